@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "AnalysisTuner.h"
+
+#include <algorithm>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+AnalysisMode AnalysisTuner::modeFromString(const std::string& str) {
+    if (str == "best") return AnalysisMode::Best;
+    if (str == "fast") return AnalysisMode::Fast;
+    if (str == "harvest") return AnalysisMode::Harvest;
+    return AnalysisMode::Auto;
+}
+
+//------------------------------------------------------------------------
+void AnalysisTuner::applyPendingReset() {
+    if (resetPending_.exchange(false)) {
+        f0Low_ = 0.0;
+        f0High_ = 0.0;
+    }
+}
+
+//------------------------------------------------------------------------
+WorldAnalysisSettings AnalysisTuner::nextSettings(bool offline) {
+    applyPendingReset();
+
+    WorldAnalysisSettings settings;
+    const AnalysisMode mode = mode_;
+    if (mode == AnalysisMode::Best) {
+        return settings;
+    }
+
+    // Narrow to the voice once its range is known; DIO's band count grows
+    // with log2(ceil / floor)
+    if (f0Low_ > 0.0) {
+        settings.f0Floor = (std::max)(settings.f0Floor, f0Low_ / kRangeMargin);
+        settings.f0Ceil = (std::min)(settings.f0Ceil, f0High_ * kRangeMargin);
+    }
+
+    if (mode == AnalysisMode::Harvest && offline) {
+        settings.estimator = F0Estimator::Harvest;
+    } else if (mode == AnalysisMode::Fast) {
+        settings.dioSpeed = kDioSpeeds[kSpeedCount - 1];
+    } else {
+        settings.dioSpeed = kDioSpeeds[speedIndex_];
+    }
+    return settings;
+}
+
+//------------------------------------------------------------------------
+WorldAnalysisSettings AnalysisTuner::bounceSettings() {
+    WorldAnalysisSettings settings;
+    settings.estimator = F0Estimator::Harvest;
+    return settings;
+}
+
+//------------------------------------------------------------------------
+void AnalysisTuner::report(const WorldAnalysis& analysis, double elapsedMs, bool offline) {
+    applyPendingReset();
+
+    // The learned range only ever widens
+    for (double f0 : analysis.f0) {
+        if (f0 <= 0.0) continue;
+        f0Low_ = f0Low_ > 0.0 ? (std::min)(f0Low_, f0) : f0;
+        f0High_ = (std::max)(f0High_, f0);
+    }
+
+    // Only live analyses count against the per-note budget
+    const AnalysisMode mode = mode_;
+    if (offline || (mode != AnalysisMode::Auto && mode != AnalysisMode::Harvest)) {
+        return;
+    }
+
+    // Plain mean of the first few, then a moving average
+    ++samples_;
+    averageMs_ += (elapsedMs - averageMs_) / (std::min)(samples_, kMinSamples);
+    if (samples_ < kMinSamples) {
+        return;
+    }
+
+    const double budget = budgetMs_;
+    if (averageMs_ > budget && speedIndex_ < kSpeedCount - 1) {
+        ++speedIndex_;
+    } else if (averageMs_ < budget * kSpeedUpRatio && speedIndex_ > 0) {
+        --speedIndex_;
+    } else {
+        return;
+    }
+    averageMs_ = 0.0;
+    samples_ = 0;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
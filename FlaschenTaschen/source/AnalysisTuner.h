@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "WorldPitchShifter.h"
+
+#include <atomic>
+#include <string>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// AnalysisMode - how World analysis trades quality for render time
+//------------------------------------------------------------------------
+enum class AnalysisMode {
+    Auto = 0,   // DIO speed follows the measured per-note budget
+    Best,       // Full F0 range, DIO speed 1 (no adaptation)
+    Fast,       // Coarsest DIO speed
+    Harvest     // Harvest for pre-bake, Auto for live notes
+};
+
+//------------------------------------------------------------------------
+// AnalysisTuner - picks WorldAnalysisSettings for the next syllable
+// Learns the F0 range of the current voice from finished analyses (so DIO
+// scans fewer bands) and raises the DIO speed while live analyses take
+// longer than the budget. nextSettings()/report() belong to the render
+// worker; the setters and resetRange() may be called from any thread.
+//------------------------------------------------------------------------
+class AnalysisTuner {
+public:
+    static constexpr double kDefaultBudgetMs = 50.0;
+
+    void setMode(AnalysisMode mode) { mode_ = mode; }
+    void setBudget(double milliseconds) { budgetMs_ = milliseconds; }
+    static AnalysisMode modeFromString(const std::string& str);
+
+    // Forget the learned F0 range (voice or eSpeak pitch changed)
+    void resetRange() { resetPending_ = true; }
+
+    // Settings for the next analysis (offline = pre-bake, not latency bound)
+    WorldAnalysisSettings nextSettings(bool offline);
+
+    // Settings for an offline bounce: Harvest over the full F0 range,
+    // independent of mode and of anything learned, so exports repeat exactly
+    static WorldAnalysisSettings bounceSettings();
+
+    // Feed back a finished analysis and how long it took
+    void report(const WorldAnalysis& analysis, double elapsedMs, bool offline);
+
+    int getDioSpeed() const { return kDioSpeeds[speedIndex_]; }
+
+private:
+    static constexpr int kDioSpeeds[] = {1, 2, 4};
+    static constexpr int kSpeedCount = 3;
+    static constexpr double kRangeMargin = 1.5;    // Headroom around the observed F0
+    static constexpr double kSpeedUpRatio = 0.35;  // Back to a finer speed below this share of the budget
+    static constexpr int kMinSamples = 3;          // Analyses averaged before changing speed
+
+    void applyPendingReset();
+
+    std::atomic<AnalysisMode> mode_{AnalysisMode::Auto};
+    std::atomic<double> budgetMs_{kDefaultBudgetMs};
+    std::atomic<bool> resetPending_{false};
+
+    // Render worker only
+    double f0Low_ = 0.0;        // Lowest voiced F0 seen (0 = nothing learned)
+    double f0High_ = 0.0;
+    int speedIndex_ = 0;
+    double averageMs_ = 0.0;    // Analysis time at the current speed (ms)
+    int samples_ = 0;           // Analyses since the last speed change
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "AsyncLogger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+
+namespace FlaschenTaschen {
+
+namespace {
+    int64_t nowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    const char* levelName(LogLevel level) {
+        switch (level) {
+            case LogLevel::Debug: return "DEBUG";
+            case LogLevel::Info: return "INFO ";
+            case LogLevel::Warning: return "WARN ";
+            case LogLevel::Error: return "ERROR";
+        }
+        return "?    ";
+    }
+}
+
+//------------------------------------------------------------------------
+AsyncLogger& AsyncLogger::instance() {
+    static AsyncLogger logger;
+    return logger;
+}
+
+//------------------------------------------------------------------------
+AsyncLogger::~AsyncLogger() {
+    std::lock_guard<std::mutex> lock(lifetimeMutex_);
+    stopWriter();
+}
+
+//------------------------------------------------------------------------
+void AsyncLogger::acquire(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(lifetimeMutex_);
+    if (users_++ > 0) {
+        return;
+    }
+
+    filePath_ = filePath;
+    {
+        std::lock_guard<std::mutex> wakeLock(wakeMutex_);
+        stopping_ = false;
+    }
+    startTicks_ = nowMicros();
+    running_ = true;
+    thread_ = std::thread(&AsyncLogger::run, this);
+}
+
+//------------------------------------------------------------------------
+void AsyncLogger::release() {
+    std::lock_guard<std::mutex> lock(lifetimeMutex_);
+    if (users_ == 0 || --users_ > 0) {
+        return;
+    }
+    stopWriter();
+}
+
+//------------------------------------------------------------------------
+void AsyncLogger::stopWriter() {
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> wakeLock(wakeMutex_);
+        stopping_ = true;
+    }
+    wakeCondition_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+//------------------------------------------------------------------------
+void AsyncLogger::log(LogLevel level, const char* format, ...) {
+    if (level < minLevel_ || !running_) {
+        return;
+    }
+
+    Record record;
+    record.timeMicros = nowMicros() - startTicks_;
+    record.level = level;
+
+    va_list args;
+    va_start(args, format);
+    const int length = std::vsnprintf(record.text, sizeof(record.text), format, args);
+    va_end(args);
+    if (length < 0) {
+        record.text[0] = '\0';
+    }
+
+    if (!queue_.push(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+//------------------------------------------------------------------------
+void AsyncLogger::run() {
+    std::string batch;
+    batch.reserve(kQueueCapacity * 64);
+
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    while (!stopping_) {
+        wakeCondition_.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMs));
+        lock.unlock();
+        writePending(batch);
+        lock.lock();
+    }
+    lock.unlock();
+
+    // Records queued before the last release
+    writePending(batch);
+}
+
+//------------------------------------------------------------------------
+void AsyncLogger::writePending(std::string& batch) {
+    batch.clear();
+
+    Record record;
+    char line[kMaxMessageLength + 32];
+    while (queue_.pop(record)) {
+        const int length = std::snprintf(line, sizeof(line), "[%10.3f] %s %s\n",
+                                         record.timeMicros / 1e6, levelName(record.level), record.text);
+        if (length > 0) {
+            batch.append(line, (std::min)(static_cast<size_t>(length), sizeof(line) - 1));
+        }
+    }
+
+    const int dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reportedDrops_) {
+        batch += "(" + std::to_string(dropped - reportedDrops_) + " log records dropped)\n";
+        reportedDrops_ = dropped;
+    }
+
+    if (batch.empty()) {
+        return;
+    }
+
+    // Opened per batch so the file can be inspected or deleted while running
+    std::ofstream file(filePath_, std::ios::app | std::ios::binary);
+    if (file.is_open()) {
+        file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "LockFreeQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define FT_PRINTF_FORMAT(formatIndex, firstArg) __attribute__((format(printf, formatIndex, firstArg)))
+#else
+    #define FT_PRINTF_FORMAT(formatIndex, firstArg)
+#endif
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// LogLevel - record severity
+//------------------------------------------------------------------------
+enum class LogLevel : uint8_t {
+    Debug = 0,      // Per-note tracing; compiled out unless FT_LOG_DEBUG_ENABLED
+    Info,
+    Warning,
+    Error
+};
+
+//------------------------------------------------------------------------
+// AsyncLogger - process-wide log file written by a background thread
+// log() formats into a fixed-size record on the caller's stack and pushes
+// it into a lock-free queue: no locks, allocation or file I/O, so it is
+// safe on the audio thread. The writer thread drains the queue in batches
+// a few times per second. Records are dropped (and counted) while the
+// queue is full or no instance holds the logger. Messages longer than
+// kMaxMessageLength are truncated.
+//------------------------------------------------------------------------
+class AsyncLogger {
+public:
+    static constexpr size_t kMaxMessageLength = 243;
+    static constexpr size_t kQueueCapacity = 1024;
+    static constexpr int kFlushIntervalMs = 100;
+
+    static AsyncLogger& instance();
+
+    // Open the log file and start the writer on the first acquire; the last
+    // release() flushes and stops it. Not realtime-safe.
+    void acquire(const std::string& filePath);
+    void release();
+
+    // Queue a printf-style message (realtime-safe)
+    void log(LogLevel level, const char* format, ...) FT_PRINTF_FORMAT(3, 4);
+
+    // Records below this level are discarded at the call
+    void setMinLevel(LogLevel level) { minLevel_ = level; }
+
+    int getDroppedCount() const { return dropped_; }
+
+    ~AsyncLogger();
+
+private:
+    struct Record {
+        int64_t timeMicros;     // Since the logger was started
+        LogLevel level;
+        char text[kMaxMessageLength + 1];
+    };
+
+    AsyncLogger() = default;
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    void run();
+    void stopWriter();
+    void writePending(std::string& batch);
+
+    MpscQueue<Record, kQueueCapacity> queue_;
+    std::atomic<LogLevel> minLevel_{LogLevel::Debug};
+    std::atomic<bool> running_{false};
+    std::atomic<int> dropped_{0};
+    std::atomic<int64_t> startTicks_{0};
+
+    std::mutex lifetimeMutex_;  // Guards users_, filePath_ and thread_ (held across join)
+    int users_ = 0;
+    std::string filePath_;
+    std::thread thread_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    bool stopping_ = false;
+
+    int reportedDrops_ = 0;     // Writer thread only
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
+
+// Debug records cost nothing in release builds (arguments are not evaluated)
+#ifndef FT_LOG_DEBUG_ENABLED
+    #ifdef NDEBUG
+        #define FT_LOG_DEBUG_ENABLED 0
+    #else
+        #define FT_LOG_DEBUG_ENABLED 1
+    #endif
+#endif
+
+#if FT_LOG_DEBUG_ENABLED
+    #define FT_LOG_DEBUG(...) ::FlaschenTaschen::AsyncLogger::instance().log(::FlaschenTaschen::LogLevel::Debug, __VA_ARGS__)
+#else
+    #define FT_LOG_DEBUG(...) ((void)0)
+#endif
+
+#define FT_LOG_INFO(...) ::FlaschenTaschen::AsyncLogger::instance().log(::FlaschenTaschen::LogLevel::Info, __VA_ARGS__)
+#define FT_LOG_WARN(...) ::FlaschenTaschen::AsyncLogger::instance().log(::FlaschenTaschen::LogLevel::Warning, __VA_ARGS__)
+#define FT_LOG_ERROR(...) ::FlaschenTaschen::AsyncLogger::instance().log(::FlaschenTaschen::LogLevel::Error, __VA_ARGS__)
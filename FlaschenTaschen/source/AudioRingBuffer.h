@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// AudioRingBuffer - wait-free single-producer/single-consumer float FIFO
+// One thread writes (TTS render), one thread reads (audio callback).
+// Reads and writes are at most two memcpy calls, independent of how much
+// audio is queued. Storage is allocated once by allocate(), never while
+// streaming.
+//------------------------------------------------------------------------
+class AudioRingBuffer {
+public:
+    AudioRingBuffer() = default;
+    explicit AudioRingBuffer(size_t minCapacity) { allocate(minCapacity); }
+
+    AudioRingBuffer(const AudioRingBuffer&) = delete;
+    AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+    // (Re)allocate storage, rounded up to a power of two. Not thread-safe:
+    // call only while neither producer nor consumer is active.
+    void allocate(size_t minCapacity) {
+        size_t capacity = 1;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        buffer_.assign(capacity, 0.0f);
+        mask_ = capacity - 1;
+        writePos_.store(0, std::memory_order_relaxed);
+        readPos_.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return buffer_.size(); }
+
+    // Samples ready to be read (consumer side)
+    size_t getAvailable() const {
+        return writePos_.load(std::memory_order_acquire) - readPos_.load(std::memory_order_acquire);
+    }
+
+    // Space left for writing (producer side)
+    size_t getFreeSpace() const {
+        return buffer_.size() - getAvailable();
+    }
+
+    // Producer: append up to count samples, returns number written
+    size_t write(const float* samples, size_t count) {
+        const size_t writePos = writePos_.load(std::memory_order_relaxed);
+        const size_t readPos = readPos_.load(std::memory_order_acquire);
+        const size_t toWrite = (std::min)(count, buffer_.size() - (writePos - readPos));
+        if (toWrite == 0) {
+            return 0;
+        }
+
+        const size_t start = writePos & mask_;
+        const size_t firstPart = (std::min)(toWrite, buffer_.size() - start);
+        std::memcpy(buffer_.data() + start, samples, firstPart * sizeof(float));
+        std::memcpy(buffer_.data(), samples + firstPart, (toWrite - firstPart) * sizeof(float));
+
+        writePos_.store(writePos + toWrite, std::memory_order_release);
+        return toWrite;
+    }
+
+    // Absolute write position (monotonic; either side may use it as a marker)
+    size_t getWritePosition() const {
+        return writePos_.load(std::memory_order_acquire);
+    }
+
+    // Absolute read position (consumer side)
+    size_t getReadPosition() const {
+        return readPos_.load(std::memory_order_relaxed);
+    }
+
+    // Consumer: read up to count samples, returns number read
+    size_t read(float* samples, size_t count) {
+        return readUntil(samples, count, writePos_.load(std::memory_order_acquire));
+    }
+
+    // Consumer: read up to count samples, but not past absolute position endPos
+    // (a snapshot of getWritePosition())
+    size_t readUntil(float* samples, size_t count, size_t endPos) {
+        const size_t readPos = readPos_.load(std::memory_order_relaxed);
+        const size_t writePos = writePos_.load(std::memory_order_acquire);
+        const size_t limit = (endPos - readPos <= writePos - readPos) ? endPos : writePos;
+        const size_t toRead = (std::min)(count, limit - readPos);
+        if (toRead == 0) {
+            return 0;
+        }
+
+        const size_t start = readPos & mask_;
+        const size_t firstPart = (std::min)(toRead, buffer_.size() - start);
+        std::memcpy(samples, buffer_.data() + start, firstPart * sizeof(float));
+        std::memcpy(samples + firstPart, buffer_.data(), (toRead - firstPart) * sizeof(float));
+
+        readPos_.store(readPos + toRead, std::memory_order_release);
+        return toRead;
+    }
+
+    // Consumer: drop everything currently queued
+    void discard() {
+        readPos_.store(writePos_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Consumer: skip forward to absolute position pos (never backwards,
+    // never past what has been written)
+    void discardUntil(size_t pos) {
+        const size_t readPos = readPos_.load(std::memory_order_relaxed);
+        const size_t writePos = writePos_.load(std::memory_order_acquire);
+        if (pos - readPos <= writePos - readPos) {
+            readPos_.store(pos, std::memory_order_release);
+        }
+    }
+
+private:
+    std::vector<float> buffer_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> writePos_{0};
+    alignas(64) std::atomic<size_t> readPos_{0};
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "AudioSpectrum.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "world/fft.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+struct AudioSpectrum::Plan {
+    explicit Plan(int size)
+        : input(size), output(new fft_complex[size / 2 + 1]) {
+        plan = fft_plan_dft_r2c_1d(size, input.data(), output.get(), FFT_ESTIMATE);
+    }
+    ~Plan() { fft_destroy_plan(plan); }
+
+    std::vector<double> input;
+    std::unique_ptr<fft_complex[]> output;
+    fft_plan plan;
+};
+
+//------------------------------------------------------------------------
+AudioSpectrum::AudioSpectrum() = default;
+AudioSpectrum::~AudioSpectrum() = default;
+
+//------------------------------------------------------------------------
+void AudioSpectrum::setup(double sampleRate, int bandCount) {
+    const int size = sampleRate > 48000.0 ? 2048 : 1024;
+    plan_ = std::make_unique<Plan>(size);
+
+    // Hann, scaled so a full-scale sine on a bin has magnitude 1
+    window_.resize(size);
+    double sum = 0.0;
+    for (int i = 0; i < size; ++i) {
+        window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / size));
+        sum += window_[i];
+    }
+    for (float& w : window_) {
+        w = static_cast<float>(w * 2.0 / sum);
+    }
+
+    // Logarithmic band edges, at least one bin per band
+    bandCount = (std::max)(1, bandCount);
+    const double binHz = sampleRate / size;
+    const double high = (std::min)(static_cast<double>(kHighHz), sampleRate / 2.0);
+    const int lastBin = size / 2;
+    bandEdges_.resize(bandCount + 1);
+    for (int band = 0; band <= bandCount; ++band) {
+        const double hz = kLowHz * std::pow(high / kLowHz, static_cast<double>(band) / bandCount);
+        int bin = static_cast<int>(std::lround(hz / binHz));
+        if (band > 0) {
+            bin = (std::max)(bin, bandEdges_[band - 1] + 1);
+        }
+        bandEdges_[band] = (std::min)(bin, lastBin + 1);
+    }
+    levels_.assign(bandCount, 0.0f);
+}
+
+//------------------------------------------------------------------------
+bool AudioSpectrum::analyze(const float* samples, float elapsedMs) {
+    if (!plan_) {
+        return false;
+    }
+    const size_t size = window_.size();
+    for (size_t i = 0; i < size; ++i) {
+        plan_->input[i] = samples[i] * window_[i];
+    }
+    fft_execute(plan_->plan);
+
+    const float fall = std::exp(-elapsedMs / kReleaseMs);
+    const fft_complex* bins = plan_->output.get();
+    bool changed = false;
+    for (size_t band = 0; band < levels_.size(); ++band) {
+        double power = 0.0;
+        for (int bin = bandEdges_[band]; bin < bandEdges_[band + 1]; ++bin) {
+            power += bins[bin][0] * bins[bin][0] + bins[bin][1] * bins[bin][1];
+        }
+        const float db = power > 0.0 ? static_cast<float>(10.0 * std::log10(power)) : kFloorDb;
+        const float level = (std::max)(0.0f, (std::min)(1.0f, 1.0f - db / kFloorDb));
+        changed |= setLevel(band, (std::max)(level, levels_[band] * fall));
+    }
+    return changed;
+}
+
+//------------------------------------------------------------------------
+bool AudioSpectrum::decay(float elapsedMs) {
+    const float fall = std::exp(-elapsedMs / kReleaseMs);
+    bool changed = false;
+    for (size_t band = 0; band < levels_.size(); ++band) {
+        changed |= setLevel(band, levels_[band] * fall);
+    }
+    return changed;
+}
+
+//------------------------------------------------------------------------
+bool AudioSpectrum::setLevel(size_t band, float level) {
+    constexpr float kStep = 1.0f / 255.0f;
+    if (level < kStep) {
+        level = 0.0f;   // Dark, not a faint glow that is never redrawn
+    }
+    const bool changed = std::fabs(level - levels_[band]) >= kStep ||
+                         (level == 0.0f) != (levels_[band] == 0.0f);
+    levels_[band] = level;
+    return changed;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,64 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// AudioSpectrum - band levels of the newest audio, for the display
+// analyze() takes a Hann-windowed FFT (World's fft_plan, so FFTW when the
+// build uses it) of the newest window of samples and sums the power into
+// bands spaced logarithmically from kLowHz to kHighHz. Levels are dB
+// relative to a full-scale sine, mapped from kFloorDb..0 to 0..1; they
+// rise at once and fall with kReleaseMs, like a level meter. Not
+// thread-safe; the display thread owns it.
+//------------------------------------------------------------------------
+class AudioSpectrum {
+public:
+    static constexpr float kLowHz = 80.0f;
+    static constexpr float kHighHz = 8000.0f;
+    static constexpr float kFloorDb = -60.0f;
+    static constexpr float kReleaseMs = 150.0f;
+
+    AudioSpectrum();
+    ~AudioSpectrum();
+
+    AudioSpectrum(const AudioSpectrum&) = delete;
+    AudioSpectrum& operator=(const AudioSpectrum&) = delete;
+
+    // Plan the FFT (about 23 ms of audio) and the bands (allocates)
+    void setup(double sampleRate, int bandCount);
+
+    // Samples per analysis window
+    size_t getWindowSize() const { return window_.size(); }
+
+    // Analyze samples[0..getWindowSize()), oldest first; elapsedMs since
+    // the previous call sets how far levels fall. True if a level changed
+    // visibly (by more than one 8-bit step).
+    bool analyze(const float* samples, float elapsedMs);
+
+    // Let levels fall without new audio (same return)
+    bool decay(float elapsedMs);
+
+    const float* getLevels() const { return levels_.data(); }
+    int getBandCount() const { return static_cast<int>(levels_.size()); }
+
+private:
+    struct Plan;    // World's fft_plan and its buffers
+
+    bool setLevel(size_t band, float level);
+
+    std::unique_ptr<Plan> plan_;
+    std::vector<float> window_;         // Hann, normalized to a full-scale sine
+    std::vector<int> bandEdges_;        // First bin of each band, plus one past the last
+    std::vector<float> levels_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -3,7 +3,9 @@
 //------------------------------------------------------------------------
 
 #include "BitmapFont.h"
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 
 namespace FlaschenTaschen {
 
@@ -243,13 +245,7 @@ void BitmapFont::renderChar(FlaschenTaschenClient& client, char c, int x, int y,
             const Color& pixelColor = pixelOn ? color : bgColor;
 
             // Draw scaled pixel
-            for (int sy = 0; sy < scale_; ++sy) {
-                for (int sx = 0; sx < scale_; ++sx) {
-                    client.setPixel(x + col * scale_ + sx,
-                                    y + row * scale_ + sy,
-                                    pixelColor);
-                }
-            }
+            client.fillRect(x + col * scale_, y + row * scale_, scale_, scale_, pixelColor);
         }
     }
 }
@@ -279,5 +275,160 @@ void BitmapFont::renderTextCenteredFull(FlaschenTaschenClient& client, const std
     renderText(client, text, x, y, color, bgColor);
 }
 
+//------------------------------------------------------------------------
+// Sprite cache
+//------------------------------------------------------------------------
+void BitmapFont::setScale(int scale) {
+    scale = (scale > 0) ? scale : 1;
+    if (scale != scale_) {
+        scale_ = scale;
+        invalidateSprites();
+    }
+}
+
+void BitmapFont::setMirrorGlyph(bool mirror) {
+    if (mirror != mirrorGlyph_) {
+        mirrorGlyph_ = mirror;
+        invalidateSprites();
+    }
+}
+
+void BitmapFont::setSpriteTexts(const std::vector<std::string>& texts) {
+    spriteTexts_ = texts;
+    invalidateSprites();
+}
+
+void BitmapFont::setSpriteColors(const Color& color, const Color& bgColor) {
+    if (color.r != spriteColor_.r || color.g != spriteColor_.g || color.b != spriteColor_.b ||
+        bgColor.r != spriteBgColor_.r || bgColor.g != spriteBgColor_.g || bgColor.b != spriteBgColor_.b) {
+        spriteColor_ = color;
+        spriteBgColor_ = bgColor;
+        invalidateSprites();
+    }
+}
+
+void BitmapFont::invalidateSprites() {
+    sprites_.clear();
+    extraSprites_ = 0;
+    spritesValid_ = false;
+}
+
+const TextSprite& BitmapFont::getSprite(const std::string& text) {
+    // Render the whole set in one go after a settings change
+    if (!spritesValid_) {
+        for (const auto& entry : spriteTexts_) {
+            rasterize(entry, sprites_[entry]);
+        }
+        spritesValid_ = true;
+    }
+
+    auto it = sprites_.find(text);
+    if (it != sprites_.end()) {
+        return it->second;
+    }
+
+    // Unknown strings are cached too, up to a limit
+    if (extraSprites_ >= kMaxExtraSprites) {
+        invalidateSprites();
+        return getSprite(text);
+    }
+    ++extraSprites_;
+    TextSprite& sprite = sprites_[text];
+    rasterize(text, sprite);
+    return sprite;
+}
+
+void BitmapFont::rasterize(const std::string& text, TextSprite& sprite) const {
+    sprite.width = getTextWidth(text);
+    sprite.height = getScaledCharHeight();
+    const size_t stride = static_cast<size_t>(sprite.width) * 3;
+    sprite.pixels.resize(stride * sprite.height);
+    if (sprite.pixels.empty()) {
+        return;
+    }
+
+    // Background first (covers the character gaps)
+    for (size_t i = 0; i < sprite.pixels.size(); i += 3) {
+        sprite.pixels[i] = spriteBgColor_.r;
+        sprite.pixels[i + 1] = spriteBgColor_.g;
+        sprite.pixels[i + 2] = spriteBgColor_.b;
+    }
+
+    // One scaled row per glyph row, then repeated scale_ times
+    const int advance = getScaledCharWidth() + getScaledSpacing();
+    for (int row = 0; row < CHAR_HEIGHT; ++row) {
+        uint8_t* line = sprite.pixels.data() + static_cast<size_t>(row) * scale_ * stride;
+
+        for (size_t i = 0; i < text.size(); ++i) {
+            const uint8_t rowData = getCharBitmap(text[i])[row];
+            uint8_t* px = line + static_cast<size_t>(i) * advance * 3;
+
+            for (int col = 0; col < CHAR_WIDTH; ++col) {
+                int bitCol = mirrorGlyph_ ? (CHAR_WIDTH - 1 - col) : col;
+                const Color& pixelColor = (rowData & (1 << bitCol)) ? spriteColor_ : spriteBgColor_;
+                for (int s = 0; s < scale_; ++s, px += 3) {
+                    px[0] = pixelColor.r;
+                    px[1] = pixelColor.g;
+                    px[2] = pixelColor.b;
+                }
+            }
+        }
+
+        for (int s = 1; s < scale_; ++s) {
+            std::memcpy(line + s * stride, line, stride);
+        }
+    }
+}
+
+void BitmapFont::drawSprite(FlaschenTaschenClient& client, const TextSprite& sprite, int x, int y) {
+    const size_t stride = static_cast<size_t>(sprite.width) * 3;
+    for (int row = 0; row < sprite.height; ++row) {
+        client.blitRow(x, y + row, sprite.pixels.data() + row * stride, sprite.width);
+    }
+}
+
+void BitmapFont::renderSpriteCenteredFull(FlaschenTaschenClient& client, const std::string& text,
+                                          const Color& color, const Color& bgColor) {
+    setSpriteColors(color, bgColor);
+    const TextSprite& sprite = getSprite(text);
+    int x = (client.getWidth() - sprite.width) / 2;
+    int y = (client.getHeight() - sprite.height) / 2;
+    drawSprite(client, sprite, x, y);
+}
+
+//------------------------------------------------------------------------
+// TextMarquee
+//------------------------------------------------------------------------
+void TextMarquee::start(const TextSprite& sprite, const Color& bgColor, int gap, int pixelsPerSecond, double startMs) {
+    strip_ = sprite;
+    bgColor_ = bgColor;
+    period_ = (std::max)(1, sprite.width + (std::max)(0, gap));
+    pixelsPerSecond_ = (std::max)(0, pixelsPerSecond);
+    startMs_ = startMs;
+    lastOffset_ = -1;
+    active_ = true;
+}
+
+bool TextMarquee::update(FlaschenTaschenClient& client, double timeMs) {
+    if (!active_) {
+        return false;
+    }
+
+    // The line starts left-aligned and moves left, one pixel at a time
+    const double elapsedMs = (std::max)(0.0, timeMs - startMs_);
+    const int offset = static_cast<int>(static_cast<int64_t>(elapsedMs * pixelsPerSecond_ / 1000.0) % period_);
+    if (offset == lastOffset_) {
+        return false;
+    }
+    lastOffset_ = offset;
+
+    client.clear(bgColor_);
+    const int y = (client.getHeight() - strip_.height) / 2;
+    for (int x = -offset; x < client.getWidth(); x += period_) {
+        BitmapFont::drawSprite(client, strip_, x, y);
+    }
+    return true;
+}
+
 //------------------------------------------------------------------------
 } // namespace FlaschenTaschen
@@ -7,9 +7,20 @@
 #include "FlaschenTaschenClient.h"
 #include <string>
 #include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 namespace FlaschenTaschen {
 
+//------------------------------------------------------------------------
+// TextSprite - a string rasterized at one scale/mirror/color setting
+//------------------------------------------------------------------------
+struct TextSprite {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;  // Packed RGB, row-major, width x height
+};
+
 //------------------------------------------------------------------------
 // BitmapFont - Simple 5x7 bitmap font renderer for LED matrices
 //------------------------------------------------------------------------
@@ -20,15 +31,18 @@ public:
     static constexpr int CHAR_HEIGHT = 7;
     static constexpr int CHAR_SPACING = 1;
 
+    // Sprites kept for strings outside the sprite text set
+    static constexpr size_t kMaxExtraSprites = 64;
+
     BitmapFont() = default;
     ~BitmapFont() = default;
 
     // Set scale factor (1 = normal, 2 = double size, etc.)
-    void setScale(int scale) { scale_ = (scale > 0) ? scale : 1; }
+    void setScale(int scale);
     int getScale() const { return scale_; }
 
     // Set horizontal mirror for each glyph (for mirrored displays)
-    void setMirrorGlyph(bool mirror) { mirrorGlyph_ = mirror; }
+    void setMirrorGlyph(bool mirror);
     bool getMirrorGlyph() const { return mirrorGlyph_; }
 
     // Get scaled dimensions
@@ -55,6 +69,26 @@ public:
     void renderTextCenteredFull(FlaschenTaschenClient& client, const std::string& text,
                                 const Color& color, const Color& bgColor = Color::Black()) const;
 
+    //--- Sprite cache ----------------------------------------------------
+    // The strings to keep pre-rendered (e.g. every syllable of a mapping).
+    // All of them are rasterized up front, and again whenever the scale,
+    // glyph mirroring or sprite colors change.
+    void setSpriteTexts(const std::vector<std::string>& texts);
+
+    // Colors sprites are rendered with (re-renders the set on change)
+    void setSpriteColors(const Color& color, const Color& bgColor);
+
+    // Cached sprite for text at the current settings (rendered on a miss)
+    const TextSprite& getSprite(const std::string& text);
+
+    // Copy a sprite into the frame at position (clipped)
+    static void drawSprite(FlaschenTaschenClient& client, const TextSprite& sprite, int x, int y);
+
+    // Like renderTextCenteredFull, as one sprite blit. The gaps between
+    // characters are filled with bgColor as well.
+    void renderSpriteCenteredFull(FlaschenTaschenClient& client, const std::string& text,
+                                  const Color& color, const Color& bgColor = Color::Black());
+
     // Get the bitmap data for a character (for custom rendering)
     static const uint8_t* getCharBitmap(char c);
 
@@ -62,9 +96,49 @@ private:
     int scale_ = 1;
     bool mirrorGlyph_ = false;
 
+    // Sprite cache (rebuilt lazily after a settings change)
+    void invalidateSprites();
+    void rasterize(const std::string& text, TextSprite& sprite) const;
+
+    std::vector<std::string> spriteTexts_;
+    std::unordered_map<std::string, TextSprite> sprites_;
+    size_t extraSprites_ = 0;
+    bool spritesValid_ = false;
+    Color spriteColor_ = Color::White();
+    Color spriteBgColor_ = Color::Black();
+
     // Character bitmap lookup
     static int charToIndex(char c);
 };
 
+//------------------------------------------------------------------------
+// TextMarquee - a line wider than the display, scrolled as a loop
+// The line is rasterized once into an off-screen strip; each frame only
+// blits the visible window of it (two spans where the loop wraps), so the
+// cost per frame doesn't depend on the length of the text.
+//------------------------------------------------------------------------
+class TextMarquee {
+public:
+    static constexpr int kGapChars = 2;     // Blank characters between loops
+
+    // Scroll a copy of sprite from startMs on, gap pixels between loops
+    void start(const TextSprite& sprite, const Color& bgColor, int gap, int pixelsPerSecond, double startMs);
+    void stop() { active_ = false; }
+    bool isActive() const { return active_; }
+
+    // Redraw the window (vertically centered) at timeMs; false if it
+    // hasn't moved since the last update, and nothing was drawn
+    bool update(FlaschenTaschenClient& client, double timeMs);
+
+private:
+    TextSprite strip_;
+    Color bgColor_ = Color::Black();
+    int period_ = 1;            // Strip width plus gap
+    int pixelsPerSecond_ = 0;
+    double startMs_ = 0.0;
+    int lastOffset_ = -1;
+    bool active_ = false;
+};
+
 //------------------------------------------------------------------------
 } // namespace FlaschenTaschen
@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "Compositor.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+void Compositor::setSize(int width, int height, bool flipHorizontal) {
+    width_ = width;
+    height_ = height;
+    flip_ = flipHorizontal;
+    for (auto& layer : layers_) {
+        layer->canvas.setDisplaySize(width_, height_);
+        layer->canvas.setFlipHorizontal(flip_);
+    }
+}
+
+//------------------------------------------------------------------------
+int Compositor::addLayer(BlendMode mode, float opacity) {
+    auto layer = std::make_unique<Layer>();
+    layer->canvas.setDisplaySize(width_, height_);
+    layer->canvas.setFlipHorizontal(flip_);
+    layer->mode = mode;
+    layer->opacity = opacity;
+    layers_.push_back(std::move(layer));
+    return static_cast<int>(layers_.size()) - 1;
+}
+
+//------------------------------------------------------------------------
+void Compositor::setKeyColor(int index, const Color& key) {
+    layers_[index]->key = key;
+    layers_[index]->keyed = true;
+}
+
+//------------------------------------------------------------------------
+void Compositor::compose(FlaschenTaschenClient& out, const Color& background) const {
+    out.clear(background);
+
+    const int width = (std::min)(width_, out.getWidth());
+    const int height = (std::min)(height_, out.getHeight());
+    const size_t count = static_cast<size_t>(width);
+
+    for (const auto& layer : layers_) {
+        if (!layer->enabled || layer->opacity <= 0.0f) {
+            continue;
+        }
+        const Color* key = layer->keyed ? &layer->key : nullptr;
+
+        for (int y = 0; y < height; ++y) {
+            uint8_t* dst = out.getRow(y);
+            const uint8_t* src = layer->canvas.getRow(y);
+
+            switch (layer->mode) {
+                case BlendMode::Replace:
+                    if (layer->opacity >= 1.0f) {
+                        std::memcpy(dst, src, count * 3);
+                    } else {
+                        PixelKernels::alphaRow(dst, src, count, layer->opacity);
+                    }
+                    break;
+                case BlendMode::Alpha:
+                    PixelKernels::alphaRow(dst, src, count, layer->opacity, key);
+                    break;
+                case BlendMode::Add:
+                    PixelKernels::addRow(dst, src, count, layer->opacity);
+                    break;
+                case BlendMode::Max:
+                    PixelKernels::maxRow(dst, src, count, layer->opacity);
+                    break;
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,72 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "FlaschenTaschenClient.h"
+
+#include <memory>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// BlendMode - how a layer combines with the layers below it
+//------------------------------------------------------------------------
+enum class BlendMode {
+    Replace = 0,    // Covers everything below (opacity still fades it)
+    Alpha,          // Lerp by opacity; the key color is transparent
+    Add,            // Saturating add, for glows over a background
+    Max             // Brightest channel wins
+};
+
+//------------------------------------------------------------------------
+// Compositor - combines several renderers into one frame
+// Each layer is an offscreen canvas (an unconnected FlaschenTaschenClient,
+// so the organ, effects and font draw into it as usual). compose() blends
+// the enabled layers bottom to top into the output client with the
+// PixelKernels blend rows, so one frame goes over the network per tick
+// instead of one send per layer. A layer's alpha is its opacity; in Alpha
+// mode, pixels of its key color (e.g. the text background) are skipped.
+//------------------------------------------------------------------------
+class Compositor {
+public:
+    // Canvas size and flip, matching the output client so rows line up
+    void setSize(int width, int height, bool flipHorizontal = false);
+
+    // Append a layer on top; returns its index
+    int addLayer(BlendMode mode, float opacity = 1.0f);
+    int getLayerCount() const { return static_cast<int>(layers_.size()); }
+
+    // Canvas to draw layer index into
+    FlaschenTaschenClient& getCanvas(int index) { return layers_[index]->canvas; }
+
+    void setEnabled(int index, bool enabled) { layers_[index]->enabled = enabled; }
+    bool isEnabled(int index) const { return layers_[index]->enabled; }
+    void setBlendMode(int index, BlendMode mode) { layers_[index]->mode = mode; }
+    void setOpacity(int index, float opacity) { layers_[index]->opacity = opacity; }
+    void setKeyColor(int index, const Color& key);
+    void clearKeyColor(int index) { layers_[index]->keyed = false; }
+
+    // Fill out with background, then blend the enabled layers over it
+    void compose(FlaschenTaschenClient& out, const Color& background) const;
+
+private:
+    struct Layer {
+        FlaschenTaschenClient canvas;
+        BlendMode mode = BlendMode::Replace;
+        float opacity = 1.0f;
+        bool enabled = true;
+        bool keyed = false;
+        Color key;
+    };
+
+    int width_ = 128;
+    int height_ = 64;
+    bool flip_ = false;
+    std::vector<std::unique_ptr<Layer>> layers_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
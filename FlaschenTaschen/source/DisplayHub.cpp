@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "DisplayHub.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace FlaschenTaschen {
+
+namespace {
+// Hubs by "ip:port/layer"; an entry expires with its last instance
+std::mutex s_registryMutex;
+std::map<std::string, std::weak_ptr<DisplayHub>> s_registry;
+} // namespace
+
+//------------------------------------------------------------------------
+std::shared_ptr<DisplayHub> DisplayHub::acquire(const ServerConfig& server, const DisplayConfig& display,
+                                                std::string& error) {
+    const std::string key = server.ip + ":" + std::to_string(server.port) + "/" + std::to_string(display.layer);
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    for (auto it = s_registry.begin(); it != s_registry.end();) {
+        it = it->second.expired() ? s_registry.erase(it) : std::next(it);
+    }
+    auto it = s_registry.find(key);
+    if (it != s_registry.end()) {
+        return it->second.lock();
+    }
+
+    std::shared_ptr<DisplayHub> hub(new DisplayHub());
+    if (!hub->connect(server, display, error)) {
+        return nullptr;
+    }
+    s_registry[key] = hub;
+    return hub;
+}
+
+//------------------------------------------------------------------------
+bool DisplayHub::connect(const ServerConfig& server, const DisplayConfig& display, std::string& error) {
+    output_.setDisplaySize(display.width, display.height);
+    output_.setOffset(display.offsetX, display.offsetY);
+    output_.setLayer(display.layer);
+    output_.setFlipHorizontal(false);   // Published rows are already in display order
+    output_.setDeltaMode(display.deltaFrames);
+    output_.setTiledMode(display.tiled);
+    output_.setMaxPacketSize(static_cast<size_t>(display.mtu));
+    output_.setNonBlocking(display.nonBlocking);
+    if (!output_.connect(server.ip, server.port)) {
+        error = output_.getLastError();
+        return false;
+    }
+    output_.setAsyncSend(true);     // Every frame is fully composed
+
+    background_ = Color(display.bgColorR, display.bgColorG, display.bgColorB);
+    compositor_.setSize(display.width, display.height);
+    limiter_.setFps(display.fps);
+
+    // Start from a blank display
+    limiter_.markDirty();
+    running_ = true;
+    thread_ = std::thread(&DisplayHub::run, this);
+    return true;
+}
+
+//------------------------------------------------------------------------
+DisplayHub::~DisplayHub() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    output_.disconnect();
+}
+
+//------------------------------------------------------------------------
+int DisplayHub::join(const Color& keyColor) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find(slotUsed_.begin(), slotUsed_.end(), false);
+    int slot = static_cast<int>(it - slotUsed_.begin());
+    if (it == slotUsed_.end()) {
+        slot = compositor_.addLayer(BlendMode::Alpha);
+        slotUsed_.push_back(true);
+    } else {
+        *it = true;
+    }
+    // Shown from its first frame on
+    compositor_.setEnabled(slot, false);
+    compositor_.setKeyColor(slot, keyColor);
+    return slot;
+}
+
+//------------------------------------------------------------------------
+void DisplayHub::leave(int slot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slot < 0 || slot >= static_cast<int>(slotUsed_.size())) {
+            return;
+        }
+        slotUsed_[slot] = false;
+        compositor_.setEnabled(slot, false);
+        limiter_.markDirty();   // Its pixels disappear with the next frame
+    }
+    wake_.notify_one();
+}
+
+//------------------------------------------------------------------------
+void DisplayHub::publish(int slot, FlaschenTaschenClient& frame) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slot < 0 || slot >= static_cast<int>(slotUsed_.size()) || !slotUsed_[slot]) {
+            return;
+        }
+        FlaschenTaschenClient& canvas = compositor_.getCanvas(slot);
+        const int height = (std::min)(canvas.getHeight(), frame.getHeight());
+        const size_t rowBytes = (std::min)(canvas.getStride(), frame.getStride());
+        for (int row = 0; row < height; ++row) {
+            std::memcpy(canvas.getRow(row), frame.getRow(row), rowBytes);
+        }
+        compositor_.setEnabled(slot, true);
+        limiter_.markDirty();
+    }
+    wake_.notify_one();
+}
+
+//------------------------------------------------------------------------
+void DisplayHub::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        wake_.wait(lock, [this] { return !running_ || limiter_.isDirty(); });
+        if (!running_) {
+            break;
+        }
+
+        // Frames published before the slot coalesce into one
+        if (!limiter_.beginFrame()) {
+            wake_.wait_until(lock, limiter_.getNextSlot(), [this] { return !running_; });
+            continue;
+        }
+        compositor_.compose(output_, background_);
+
+        // Instances keep publishing while the frame goes out
+        lock.unlock();
+        if (output_.send()) {
+            ++framesSent_;
+        }
+        lock.lock();
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
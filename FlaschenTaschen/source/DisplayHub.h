@@ -0,0 +1,78 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "Compositor.h"
+#include "FlaschenTaschenClient.h"
+#include "FrameLimiter.h"
+#include "MappingConfig.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// DisplayHub - one sender for every plugin instance showing on a server
+// With <Display shared="true">, instances don't connect themselves: each
+// joins the process-wide hub for its server (ip, port and layer) and
+// publishes its finished frames into its own compositor layer. The hub's
+// thread blends the layers (first instance at the bottom, each instance's
+// background color keyed out) and sends one frame per tick, so N tracks
+// cost one stream instead of N full frames fighting over the matrix.
+// The first instance to join sets size, offset, fps and transport options.
+//------------------------------------------------------------------------
+class DisplayHub {
+public:
+    // The hub for this server, created and connected on first use
+    // (nullptr and error set if connecting failed)
+    static std::shared_ptr<DisplayHub> acquire(const ServerConfig& server, const DisplayConfig& display,
+                                               std::string& error);
+
+    ~DisplayHub();
+
+    DisplayHub(const DisplayHub&) = delete;
+    DisplayHub& operator=(const DisplayHub&) = delete;
+
+    // Reserve a layer; pixels of keyColor show the layers below
+    int join(const Color& keyColor);
+    void leave(int slot);
+
+    // Copy a finished frame (rows in display order) into the slot's layer;
+    // sent with the hub's next frame
+    void publish(int slot, FlaschenTaschenClient& frame);
+
+    // Frames sent / dropped / late on the shared connection
+    int getFramesSent() const { return framesSent_; }
+    int getDroppedFrames() const { return output_.getDroppedFrames(); }
+    int getLateFrames() const { return output_.getLateFrames(); }
+
+private:
+    DisplayHub() = default;
+
+    bool connect(const ServerConfig& server, const DisplayConfig& display, std::string& error);
+    void run();
+
+    FlaschenTaschenClient output_;      // Sender thread only, after connect
+    Color background_;
+
+    std::mutex mutex_;                  // Guards everything below
+    std::condition_variable wake_;
+    Compositor compositor_;
+    std::vector<bool> slotUsed_;
+    FrameLimiter limiter_;
+    bool running_ = false;
+
+    std::thread thread_;
+    std::atomic<int> framesSent_{0};
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,536 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "DisplayThread.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+void DisplayCommand::setText(std::string_view str) {
+    size_t length = (std::min)(str.size(), kMaxTextLength);
+    memcpy(text, str.data(), length);
+    text[length] = '\0';
+}
+
+//------------------------------------------------------------------------
+DisplayThread::~DisplayThread() {
+    stop();
+}
+
+//------------------------------------------------------------------------
+bool DisplayThread::start(const ServerConfig& server, const DisplayConfig& display,
+                          const std::vector<Effect>& effects,
+                          const std::vector<Syllable>& syllables,
+                          const std::vector<DisplayPanel>& panels) {
+    stop();
+
+    client_.setDisplaySize(display.width, display.height);
+    client_.setOffset(display.offsetX, display.offsetY);
+    client_.setLayer(display.layer);
+    client_.setFlipHorizontal(display.flipHorizontal);
+    client_.setDeltaMode(display.deltaFrames);
+    client_.setTiledMode(display.tiled);
+    client_.setMaxPacketSize(static_cast<size_t>(display.mtu));
+    client_.setNonBlocking(display.nonBlocking);
+    // Every frame is fully redrawn, so transmit overlaps rendering. As a
+    // panel or hub canvas the client never sends, and its content must persist.
+    const bool shared = display.shared && panels.empty();
+    client_.setAsyncSend(panels.empty() && !shared);
+    font_.setMirrorGlyph(display.mirrorGlyph);
+    fps_ = display.fps;
+    scrollSpeed_ = display.scrollSpeed;
+    marquee_.stop();
+
+    std::vector<std::string> texts;
+    texts.reserve(syllables.size());
+    for (const auto& syllable : syllables) {
+        texts.push_back(syllable.text);
+    }
+    font_.setSpriteTexts(texts);
+
+    lightOrgan_ = display.lightOrgan;
+    spectrumBands_ = display.spectrumBands;
+    spectrumRate_ = 0.0;    // Set up with the first frame, at the host's rate
+    organ_.setRainbowMode(display.lightOrganRainbow);
+    organ_.setColor(display.colorR, display.colorG, display.colorB);
+
+    if (shared) {
+        hub_ = DisplayHub::acquire(server, display, lastError_);
+        if (!hub_) {
+            return false;
+        }
+        hubSlot_ = hub_->join(Color(display.bgColorR, display.bgColorG, display.bgColorB));
+    } else if (panels.empty()) {
+        if (!client_.connect(server.ip, server.port)) {
+            lastError_ = client_.getLastError();
+            return false;
+        }
+        // Record the stream as it goes out (single server only)
+        if (!display.capture.empty()) {
+            if (!capture_.open(display.capture, display.width, display.height,
+                               display.offsetX, display.offsetY, display.layer)) {
+                lastError_ = capture_.getLastError();
+                disconnectAll();
+                return false;
+            }
+            client_.setCapture(&capture_);
+        }
+    }
+
+    for (const auto& config : panels) {
+        // Clip the panel to the canvas
+        const int x = (std::min)(config.x, display.width);
+        const int y = (std::min)(config.y, display.height);
+        const int width = (std::min)(config.width, display.width - x);
+        const int height = (std::min)(config.height, display.height - y);
+        if (width <= 0 || height <= 0) {
+            continue;
+        }
+
+        auto panel = std::make_unique<Panel>();
+        panel->x = x;
+        panel->y = y;
+        panel->limited = config.fps > 0 && config.fps < fps_;
+        panel->limiter.setFps(config.fps);
+        FlaschenTaschenClient& client = panel->client;
+        client.setDisplaySize(width, height);
+        client.setOffset(config.offsetX, config.offsetY);
+        client.setLayer(config.layer);
+        client.setFlipHorizontal(false);  // Canvas rows are already in display order
+        client.setDeltaMode(display.deltaFrames);
+        client.setTiledMode(display.tiled);
+        client.setMaxPacketSize(static_cast<size_t>(display.mtu));
+        client.setNonBlocking(display.nonBlocking);
+        if (!client.connect(config.ip, config.port)) {
+            lastError_ = "Panel " + config.ip + ":" + std::to_string(config.port) + ": " + client.getLastError();
+            disconnectAll();
+            return false;
+        }
+        client.setAsyncSend(true);
+        panels_.push_back(std::move(panel));
+    }
+
+    // Drop anything left over from a previous run
+    DisplayCommand stale;
+    while (commands_.pop(stale)) {}
+
+    effectList_ = effects;
+    effects_.stopEffect();
+    effects_.loadClips(effects);    // A clip that fails to open shows its color2
+
+    // Pre-render every effect once; playing one then only decodes frames
+    if (display.effectCacheMb > 0 && !lightOrgan_ && spectrumBands_ == 0) {
+        auto cache = std::make_shared<EffectFrameCache>();
+        cache->build(effects, display.width, display.height, fps_,
+                     static_cast<size_t>(display.effectCacheMb) * 1024 * 1024);
+        effects_.setFrameCache(std::move(cache));
+    } else {
+        effects_.setFrameCache(nullptr);
+    }
+    organ_.allNotesOff();
+    scheduledCount_ = 0;
+    hasPendingText_ = false;
+    panelsBehind_ = false;
+
+    // Start from a blank display
+    client_.clear();
+    frameDirty_ = true;
+
+    framesSent_ = 0;
+    coalescedUpdates_ = 0;
+    droppedFrames_ = 0;
+    lateFrames_ = 0;
+    audio_.discard();
+    spectrumEnabled_ = spectrumBands_ > 0;
+    running_ = true;
+    thread_ = std::thread(&DisplayThread::run, this);
+    return true;
+}
+
+//------------------------------------------------------------------------
+void DisplayThread::stop() {
+    spectrumEnabled_ = false;
+    if (running_) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            running_ = false;
+        }
+        wakeCondition_.notify_one();
+    }
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    disconnectAll();
+}
+
+//------------------------------------------------------------------------
+void DisplayThread::disconnectAll() {
+    if (hub_) {
+        hub_->leave(hubSlot_);
+        hub_.reset();
+        hubSlot_ = -1;
+    }
+    client_.disconnect();
+    client_.setCapture(nullptr);
+    capture_.close();
+    for (auto& panel : panels_) {
+        panel->client.disconnect();
+    }
+    panels_.clear();
+}
+
+//------------------------------------------------------------------------
+bool DisplayThread::post(const DisplayCommand& command) {
+    if (!commands_.push(command)) {
+        ++droppedCommands_;
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+void DisplayThread::updateClock(int64_t playingSample) {
+    // Single writer: odd sequence while the anchor is being changed
+    const uint32_t sequence = clockSequence_.load(std::memory_order_relaxed);
+    clockSequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    anchorSample_.store(playingSample, std::memory_order_relaxed);
+    anchorNanos_.store(clockNanos(), std::memory_order_relaxed);
+    clockSequence_.store(sequence + 2, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------
+void DisplayThread::pushAudio(const float* samples, int count) {
+    if (spectrumEnabled_.load(std::memory_order_relaxed) && count > 0) {
+        audio_.write(samples, static_cast<size_t>(count));  // Drops what doesn't fit
+    }
+}
+
+//------------------------------------------------------------------------
+void DisplayThread::pushAudio(const double* samples, int count) {
+    if (!spectrumEnabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    float chunk[256];
+    for (int done = 0; done < count;) {
+        const int n = (std::min)(count - done, static_cast<int>(sizeof(chunk) / sizeof(chunk[0])));
+        for (int i = 0; i < n; ++i) {
+            chunk[i] = static_cast<float>(samples[done + i]);
+        }
+        audio_.write(chunk, static_cast<size_t>(n));
+        done += n;
+    }
+}
+
+//------------------------------------------------------------------------
+bool DisplayThread::getAudioTime(int64_t nowNanos, double& samples) const {
+    uint32_t before;
+    int64_t anchorSample;
+    int64_t anchorNanos;
+    do {
+        before = clockSequence_.load(std::memory_order_acquire);
+        anchorSample = anchorSample_.load(std::memory_order_relaxed);
+        anchorNanos = anchorNanos_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((before & 1) != 0 || before != clockSequence_.load(std::memory_order_relaxed));
+
+    if (before == 0) {
+        return false;  // No block processed yet
+    }
+
+    samples = anchorSample + (nowNanos - anchorNanos) * 1e-9 * sampleRate_;
+    return true;
+}
+
+//------------------------------------------------------------------------
+int64_t DisplayThread::clockNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------
+void DisplayThread::run() {
+    using Clock = std::chrono::steady_clock;
+    const auto framePeriod = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / (std::max)(1, fps_)));
+
+    auto nextFrame = Clock::now();
+    while (running_) {
+        const int64_t frameStartMicros = stats_ ? LatencyStats::nowMicros() : 0;
+        const int64_t nowNanos = clockNanos();
+        double audioSamples = 0.0;
+        const bool hasAudioTime = getAudioTime(nowNanos, audioSamples);
+
+        // Without audio running yet, effects fall back to the wall clock
+        timelineMs_ = hasAudioTime ? toMs(audioSamples) : VisualEffects::clockMs();
+
+        DisplayCommand command;
+        while (commands_.pop(command)) {
+            if (command.sampleTime < 0 || !hasAudioTime) {
+                command.sampleTime = -1;
+                apply(command);
+            } else {
+                schedule(command);
+            }
+        }
+
+        // Apply scheduled commands whose sample has played, in posting order
+        size_t kept = 0;
+        int64_t nextDue = -1;
+        for (size_t i = 0; i < scheduledCount_; ++i) {
+            if (scheduled_[i].sampleTime <= audioSamples) {
+                apply(scheduled_[i]);
+            } else {
+                if (nextDue < 0 || scheduled_[i].sampleTime < nextDue) {
+                    nextDue = scheduled_[i].sampleTime;
+                }
+                scheduled_[kept++] = scheduled_[i];
+            }
+        }
+        scheduledCount_ = kept;
+
+        renderFrame(timelineMs_, frameStartMicros);
+
+        // Fixed-rate schedule; if a frame overran, skip ahead instead of bursting
+        nextFrame += framePeriod;
+        auto now = Clock::now();
+        if (nextFrame < now) {
+            nextFrame = now;
+        }
+
+        // Wake early when a scheduled command comes due before the next frame
+        auto wakeTime = nextFrame;
+        if (nextDue >= 0) {
+            auto dueIn = std::chrono::duration<double>((nextDue - audioSamples) / sampleRate_);
+            auto due = now + std::chrono::duration_cast<Clock::duration>(dueIn);
+            wakeTime = (std::min)(wakeTime, due);
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCondition_.wait_until(lock, wakeTime, [this] { return !running_; });
+    }
+}
+
+//------------------------------------------------------------------------
+void DisplayThread::schedule(const DisplayCommand& command) {
+    if (scheduledCount_ == scheduled_.size()) {
+        apply(command);  // Too many waiting: play it now rather than lose it
+        return;
+    }
+    scheduled_[scheduledCount_++] = command;
+}
+
+//------------------------------------------------------------------------
+void DisplayThread::apply(const DisplayCommand& command) {
+    // Time the command belongs to, so effects start on their exact sample
+    const double timeMs = command.sampleTime >= 0 ? toMs(static_cast<double>(command.sampleTime)) : timelineMs_;
+
+    switch (command.type) {
+        case DisplayCommand::Type::ShowText:
+            // Showing text stops any running effect; drawn with the next frame
+            if (lightOrgan_ || spectrumBands_ > 0) break;
+            effects_.stopEffect();
+            if (hasPendingText_) {
+                ++coalescedUpdates_;
+            }
+            pendingText_ = command;
+            hasPendingText_ = true;
+            frameDirty_ = true;
+            break;
+
+        case DisplayCommand::Type::Clear:
+            effects_.stopEffect();
+            marquee_.stop();
+            hasPendingText_ = false;
+            organ_.allNotesOff();
+            client_.clear(command.bgColor);
+            frameDirty_ = true;
+            break;
+
+        case DisplayCommand::Type::StartEffect: {
+            if (lightOrgan_ || spectrumBands_ > 0) break;
+            auto it = std::find_if(effectList_.begin(), effectList_.end(),
+                                   [&](const Effect& e) { return e.id == command.effectId; });
+            if (it != effectList_.end()) {
+                effects_.startEffectAt(*it, command.velocity, timeMs);
+                hasPendingText_ = false;  // The effect draws over it anyway
+                marquee_.stop();
+            }
+            break;
+        }
+
+        case DisplayCommand::Type::StopEffect:
+            effects_.stopEffect();
+            break;
+
+        case DisplayCommand::Type::SetBrightness:
+            if (effects_.isPlaying()) {
+                effects_.setBrightness(command.brightness);
+            }
+            break;
+
+        case DisplayCommand::Type::NoteOn:
+            organ_.noteOn(command.note, command.velocity);
+            frameDirty_ = lightOrgan_ || frameDirty_;
+            break;
+
+        case DisplayCommand::Type::NoteOff:
+            organ_.noteOff(command.note);
+            frameDirty_ = lightOrgan_ || frameDirty_;
+            break;
+
+        case DisplayCommand::Type::Aftertouch:
+            organ_.aftertouch(command.note, command.velocity);
+            frameDirty_ = lightOrgan_ || frameDirty_;
+            break;
+    }
+}
+
+//------------------------------------------------------------------------
+void DisplayThread::renderFrame(double timeMs, int64_t frameStartMicros) {
+    if (hasPendingText_) {
+        font_.setScale(pendingText_.fontScale);
+        font_.setSpriteColors(pendingText_.textColor, pendingText_.bgColor);
+        const TextSprite& sprite = font_.getSprite(pendingText_.text);
+        if (scrollSpeed_ > 0 && sprite.width > client_.getWidth()) {
+            const int gap = TextMarquee::kGapChars * (font_.getScaledCharWidth() + font_.getScaledSpacing());
+            marquee_.start(sprite, pendingText_.bgColor, gap, scrollSpeed_, timeMs);
+        } else {
+            marquee_.stop();
+            client_.clear(pendingText_.bgColor);
+            font_.renderSpriteCenteredFull(client_, pendingText_.text, pendingText_.textColor, pendingText_.bgColor);
+        }
+        hasPendingText_ = false;
+    }
+
+    if (spectrumBands_ > 0) {
+        if (updateSpectrum(timeMs)) {
+            organ_.renderLevels(client_, spectrum_.getLevels(), spectrum_.getBandCount());
+            frameDirty_ = true;
+        }
+    } else if (lightOrgan_) {
+        if (frameDirty_) {
+            organ_.render(client_);
+        }
+    } else if (effects_.isPlaying() && effects_.updateAt(client_, timeMs)) {
+        // Animated effects redraw every frame; the last frame stays when they end
+        frameDirty_ = true;
+    } else if (marquee_.update(client_, timeMs)) {
+        // Scrolling text redraws whenever it has moved a pixel
+        frameDirty_ = true;
+    }
+
+    if (frameDirty_ || panelsBehind_) {
+        // Render time covers the commands applied for this frame
+        int64_t sendStartMicros = 0;
+        if (stats_) {
+            sendStartMicros = LatencyStats::nowMicros();
+            stats_->record(LatencyStage::DisplayRender, sendStartMicros - frameStartMicros);
+        }
+        if (sendFrame(frameDirty_)) {
+            ++framesSent_;
+        }
+        if (stats_) {
+            stats_->recordSince(LatencyStage::DisplaySend, sendStartMicros);
+        }
+        frameDirty_ = false;
+    }
+}
+
+//------------------------------------------------------------------------
+bool DisplayThread::updateSpectrum(double timeMs) {
+    const double sampleRate = sampleRate_;
+    if (sampleRate != spectrumRate_) {
+        spectrum_.setup(sampleRate, spectrumBands_);
+        audioWindow_.assign(spectrum_.getWindowSize(), 0.0f);
+        spectrumRate_ = sampleRate;
+        spectrumTimeMs_ = timeMs;
+    }
+    const float elapsedMs = static_cast<float>((std::max)(0.0, (std::min)(100.0, timeMs - spectrumTimeMs_)));
+    spectrumTimeMs_ = timeMs;
+
+    // Only the newest window matters: skip older audio, then slide the
+    // window along by what is left
+    const size_t window = audioWindow_.size();
+    const size_t end = audio_.getWritePosition();
+    if (end - audio_.getReadPosition() > window) {
+        audio_.discardUntil(end - window);
+    }
+    const size_t fresh = (std::min)(window, end - audio_.getReadPosition());
+    if (fresh == 0) {
+        return spectrum_.decay(elapsedMs);
+    }
+    std::copy(audioWindow_.begin() + fresh, audioWindow_.end(), audioWindow_.begin());
+    audio_.readUntil(audioWindow_.data() + window - fresh, fresh, end);
+    return spectrum_.analyze(audioWindow_.data(), elapsedMs);
+}
+
+//------------------------------------------------------------------------
+bool DisplayThread::sendFrame(bool changed) {
+    if (hub_) {
+        // The hub sends; its counters are shared with the other instances
+        hub_->publish(hubSlot_, client_);
+        droppedFrames_ = hub_->getDroppedFrames();
+        lateFrames_ = hub_->getLateFrames();
+        return true;
+    }
+
+    if (panels_.empty()) {
+        const bool sent = client_.send();
+        droppedFrames_ = client_.getDroppedFrames();
+        lateFrames_ = client_.getLateFrames();
+        return sent;
+    }
+
+    // Copy each panel's rectangle out of the canvas; send() hands the frame
+    // to the panel's sender thread, so the panels transmit in parallel. A
+    // rate-limited panel skips frames until its slot, then sends the latest.
+    bool sent = false;
+    bool failed = false;
+    const auto now = FrameLimiter::Clock::now();
+    panelsBehind_ = false;
+    for (auto& panel : panels_) {
+        FlaschenTaschenClient& client = panel->client;
+        if (panel->limited) {
+            if (changed) {
+                panel->limiter.markDirty();
+            }
+            if (!panel->limiter.beginFrame(now)) {
+                panelsBehind_ = panelsBehind_ || panel->limiter.isDirty();
+                continue;
+            }
+        } else if (!changed) {
+            continue;
+        }
+
+        const size_t rowBytes = client.getStride();
+        const size_t xBytes = static_cast<size_t>(panel->x) * 3;
+        for (int row = 0; row < client.getHeight(); ++row) {
+            std::memcpy(client.getRow(row), client_.getRow(panel->y + row) + xBytes, rowBytes);
+        }
+        if (client.send()) {
+            sent = true;
+        } else {
+            failed = true;
+        }
+    }
+
+    int dropped = 0;
+    int late = 0;
+    for (const auto& panel : panels_) {
+        dropped += panel->client.getDroppedFrames();
+        late += panel->client.getLateFrames();
+    }
+    droppedFrames_ = dropped;
+    lateFrames_ = late;
+    return sent && !failed;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,222 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "FlaschenTaschenClient.h"
+#include "AudioRingBuffer.h"
+#include "AudioSpectrum.h"
+#include "BitmapFont.h"
+#include "DisplayHub.h"
+#include "FrameCapture.h"
+#include "FrameLimiter.h"
+#include "MappingConfig.h"
+#include "VisualEffects.h"
+#include "LatencyStats.h"
+#include "LockFreeQueue.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// DisplayCommand - one request for the display thread
+// Plain data with a fixed-size text field so it can travel through the
+// lock-free queue without allocating.
+//------------------------------------------------------------------------
+struct DisplayCommand {
+    enum class Type {
+        ShowText = 0,   // Render text (syllable) centered, or scrolling if wider than the display
+        Clear,          // Fill with bgColor
+        StartEffect,    // Start effect effectId at velocity
+        StopEffect,     // Stop the running effect
+        SetBrightness,  // Effect brightness (aftertouch)
+        NoteOn,         // Light organ key down (note, velocity)
+        NoteOff,        // Light organ key up (note)
+        Aftertouch      // Light organ key pressure (note, -1 = all; velocity = pressure)
+    };
+
+    static constexpr size_t kMaxTextLength = 63;
+
+    Type type = Type::Clear;
+    char text[kMaxTextLength + 1] = {};
+    Color textColor = Color::White();
+    Color bgColor = Color::Black();
+    int fontScale = 1;
+    int effectId = -1;
+    int note = -1;
+    int velocity = 127;
+    float brightness = 1.0f;
+
+    // Audio sample position the command belongs to (-1 = as soon as possible)
+    int64_t sampleTime = -1;
+
+    // Copy text, truncated to kMaxTextLength
+    void setText(std::string_view str);
+};
+
+//------------------------------------------------------------------------
+// DisplayThread - owns the FlaschenTaschen connection and renders frames
+// at a fixed rate on its own thread. post() is safe to call from the
+// audio thread: it only pushes into a lock-free queue. Rendering, effect
+// animation and all socket calls happen on the display thread.
+// Timing follows the audio: the audio thread publishes which sample is
+// playing now, commands carry the sample they belong to and are applied
+// when playback reaches it, and effects animate on that same timeline.
+// Updates are coalesced: commands only change state, and each frame is drawn
+// once from the latest state, so text superseded within a frame is never
+// rendered. With display panels, frames are drawn once into a shared canvas
+// and each panel's rectangle goes to its own server, at most at the panel's
+// frame rate; every panel client has its own sender thread, so more panels
+// don't add up in frame latency. With <Display shared="true"> (and no
+// panels) frames go to the server's DisplayHub instead, which blends all
+// instances into one stream. <Display capture> records what client_ sends
+// (not panels or the hub) to a file. With <Display spectrum="N"> the display shows
+// the plugin's output instead: pushAudio() queues it, and each frame the
+// newest window of it is analyzed into N spectrum columns.
+//------------------------------------------------------------------------
+class DisplayThread {
+public:
+    static constexpr size_t kMaxPendingCommands = 64;
+    static constexpr int kDefaultFps = 60;
+    static constexpr size_t kAudioCapacity = 16384;    // Samples queued for the spectrum
+
+    DisplayThread() = default;
+    ~DisplayThread();
+
+    DisplayThread(const DisplayThread&) = delete;
+    DisplayThread& operator=(const DisplayThread&) = delete;
+
+    // Connect to the server (or to every panel's server, if any) and start
+    // the thread (restarts if running). Effects are copied so commands can
+    // refer to them by id; syllable texts are pre-rendered as font sprites.
+    bool start(const ServerConfig& server, const DisplayConfig& display,
+               const std::vector<Effect>& effects,
+               const std::vector<Syllable>& syllables = {},
+               const std::vector<DisplayPanel>& panels = {});
+
+    // Stop the thread and disconnect
+    void stop();
+
+    // Check if running (connected)
+    bool isRunning() const { return running_; }
+
+    // Queue a command (realtime-safe). Returns false if the queue is full.
+    bool post(const DisplayCommand& command);
+
+    // Audio timeline: sample rate, and the sample being heard right now
+    // (realtime-safe, call once per processed block)
+    void setSampleRate(double sampleRate) { sampleRate_ = sampleRate; }
+    void updateClock(int64_t playingSample);
+
+    // Output audio for the spectrum display (realtime-safe, call once per
+    // processed block; ignored unless the spectrum is on)
+    void pushAudio(const float* samples, int count);
+    void pushAudio(const double* samples, int count);
+
+    // Record frame render and send times (set before start())
+    void setLatencyStats(LatencyStats* stats) { stats_ = stats; }
+
+    // Frames sent / commands dropped because the queue was full
+    int getFramesSent() const { return framesSent_; }
+    int getDroppedCommands() const { return droppedCommands_; }
+
+    // Frames the client(s) dropped or sent late (see FlaschenTaschenClient),
+    // summed over all panels
+    int getDroppedFrames() const { return droppedFrames_; }
+    int getLateFrames() const { return lateFrames_; }
+
+    // Text updates replaced before their frame was drawn
+    int getCoalescedUpdates() const { return coalescedUpdates_; }
+
+    // Get last error message (valid after start() failed)
+    const std::string& getLastError() const { return lastError_; }
+
+private:
+    void run();
+    void schedule(const DisplayCommand& command);
+    void apply(const DisplayCommand& command);
+    void renderFrame(double timeMs, int64_t frameStartMicros);
+    bool updateSpectrum(double timeMs);
+    bool sendFrame(bool changed);
+    void disconnectAll();
+
+    // Current playback position in samples (false before the first block)
+    bool getAudioTime(int64_t nowNanos, double& samples) const;
+    double toMs(double samples) const { return samples * 1000.0 / sampleRate_; }
+    static int64_t clockNanos();
+
+    // One panel: its canvas rectangle and its own connection
+    struct Panel {
+        FlaschenTaschenClient client;
+        int x = 0;
+        int y = 0;
+        bool limited = false;   // Slower than the display thread
+        FrameLimiter limiter;
+    };
+
+    // Display thread only
+    FlaschenTaschenClient client_;  // Drawn into; sends itself when there are no panels
+    std::vector<std::unique_ptr<Panel>> panels_;
+    std::shared_ptr<DisplayHub> hub_;   // Shared sender (<Display shared>)
+    int hubSlot_ = -1;
+    FrameCapture capture_;          // <Display capture>, fed by client_
+    BitmapFont font_;
+    TextMarquee marquee_;           // Text wider than the display
+    int scrollSpeed_ = 0;
+    VisualEffects effects_;
+    PolyLightOrgan organ_;
+    bool lightOrgan_ = false;
+    int spectrumBands_ = 0;         // Spectrum columns (0 = off)
+    AudioSpectrum spectrum_;
+    double spectrumRate_ = 0.0;     // Sample rate spectrum_ was set up for
+    double spectrumTimeMs_ = 0.0;   // Time of the last analysis
+    std::vector<float> audioWindow_;    // Newest getWindowSize() samples
+    std::vector<Effect> effectList_;
+    bool frameDirty_ = false;
+    bool panelsBehind_ = false;     // A rate-limited panel still owes a frame
+    DisplayCommand pendingText_;    // Latest ShowText, drawn with the next frame
+    bool hasPendingText_ = false;
+    std::array<DisplayCommand, kMaxPendingCommands> scheduled_;  // Waiting for their sample
+    size_t scheduledCount_ = 0;
+    double timelineMs_ = 0.0;   // Time of the frame being rendered
+
+    LockFreeQueue<DisplayCommand, kMaxPendingCommands> commands_;
+    int fps_ = kDefaultFps;
+    LatencyStats* stats_ = nullptr;
+
+    // Audio clock anchor, published by the audio thread (seqlock)
+    std::atomic<double> sampleRate_{44100.0};
+    std::atomic<uint32_t> clockSequence_{0};
+    std::atomic<int64_t> anchorSample_{0};
+    std::atomic<int64_t> anchorNanos_{0};
+
+    // Output audio, written by the audio thread
+    AudioRingBuffer audio_{kAudioCapacity};
+    std::atomic<bool> spectrumEnabled_{false};
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+
+    std::atomic<int> framesSent_{0};
+    std::atomic<int> droppedCommands_{0};
+    std::atomic<int> droppedFrames_{0};
+    std::atomic<int> lateFrames_{0};
+    std::atomic<int> coalescedUpdates_{0};
+    std::string lastError_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,327 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "ESpeakService.h"
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+#include <algorithm>
+
+namespace FlaschenTaschen {
+
+// eSpeak constants (from speak_lib.h)
+namespace {
+    constexpr int AUDIO_OUTPUT_SYNCHRONOUS = 0x02;
+    constexpr int espeakCHARS_AUTO = 0;
+    constexpr int espeakENDPAUSE = 0x1000;
+    constexpr int espeakRATE = 1;
+    constexpr int espeakVOLUME = 2;
+    constexpr int espeakPITCH = 3;
+    constexpr int espeakRANGE = 4;  // Pitch range/variation
+    constexpr int POS_CHARACTER = 1;
+
+    // The service whose worker is synthesizing (eSpeak's callback is global)
+    std::atomic<ESpeakService*> s_active{nullptr};
+
+    std::mutex s_serviceMutex;
+    std::weak_ptr<ESpeakService> s_service;
+}
+
+// Function pointer types
+typedef int (*espeak_Initialize_t)(int, int, const char*, int);
+typedef void (*espeak_SetSynthCallback_t)(void*);
+typedef int (*espeak_SetParameter_t)(int, int, int);
+typedef int (*espeak_SetVoiceByName_t)(const char*);
+typedef int (*espeak_Synth_t)(const void*, size_t, unsigned int, int, unsigned int, unsigned int, unsigned int*, void*);
+typedef int (*espeak_Synchronize_t)(void);
+typedef int (*espeak_Terminate_t)(void);
+
+//------------------------------------------------------------------------
+std::shared_ptr<ESpeakService> ESpeakService::acquire(std::string& error) {
+    std::lock_guard<std::mutex> lock(s_serviceMutex);
+    if (auto service = s_service.lock()) {
+        return service;
+    }
+
+    std::shared_ptr<ESpeakService> service(new ESpeakService());
+    if (!service->load(error)) {
+        return nullptr;
+    }
+    s_service = service;
+    return service;
+}
+
+//------------------------------------------------------------------------
+ESpeakService::~ESpeakService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    requestReady_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    unload();
+}
+
+//------------------------------------------------------------------------
+bool ESpeakService::load(std::string& error) {
+    // Try multiple paths
+#ifdef _WIN32
+    const char* libraryPaths[] = {
+        "C:\\Program Files\\eSpeak NG\\libespeak-ng.dll",
+        "C:\\Program Files (x86)\\eSpeak NG\\libespeak-ng.dll",
+        "libespeak-ng.dll",
+        nullptr
+    };
+#elif defined(__APPLE__)
+    const char* libraryPaths[] = {
+        "libespeak-ng.dylib",
+        "/opt/homebrew/lib/libespeak-ng.dylib",
+        "/usr/local/lib/libespeak-ng.dylib",
+        nullptr
+    };
+#else
+    const char* libraryPaths[] = {
+        "libespeak-ng.so.1",
+        "libespeak-ng.so",
+        nullptr
+    };
+#endif
+
+    for (int i = 0; libraryPaths[i] != nullptr; ++i) {
+#ifdef _WIN32
+        library_ = LoadLibraryA(libraryPaths[i]);
+#else
+        library_ = dlopen(libraryPaths[i], RTLD_NOW | RTLD_LOCAL);
+#endif
+        if (library_) break;
+    }
+
+    if (!library_) {
+        error = std::string("Failed to load ") + libraryPaths[0];
+        return false;
+    }
+
+    // Load function pointers
+#ifdef _WIN32
+    auto lookup = [this](const char* name) { return (void*)GetProcAddress(library_, name); };
+#else
+    auto lookup = [this](const char* name) { return dlsym(library_, name); };
+#endif
+    fn_Initialize_ = lookup("espeak_Initialize");
+    fn_SetSynthCallback_ = lookup("espeak_SetSynthCallback");
+    fn_SetParameter_ = lookup("espeak_SetParameter");
+    fn_SetVoiceByName_ = lookup("espeak_SetVoiceByName");
+    fn_Synth_ = lookup("espeak_Synth");
+    fn_Synchronize_ = lookup("espeak_Synchronize");
+    fn_Terminate_ = lookup("espeak_Terminate");
+
+    if (!fn_Initialize_ || !fn_SetSynthCallback_ || !fn_Synth_ || !fn_Synchronize_) {
+        error = "Failed to load eSpeak-NG functions";
+        unload();
+        return false;
+    }
+
+    // Initialize eSpeak; it returns the output rate it will use
+    auto initFn = (espeak_Initialize_t)fn_Initialize_;
+    int result = initFn(AUDIO_OUTPUT_SYNCHRONOUS, 0, nullptr, 0);
+    if (result < 0) {
+        error = "espeak_Initialize failed";
+        unload();
+        return false;
+    }
+    initialized_ = true;
+    if (result > 0) {
+        sampleRate_ = result;
+    }
+
+    auto setCallbackFn = (espeak_SetSynthCallback_t)fn_SetSynthCallback_;
+    setCallbackFn((void*)synthCallback);
+    s_active = this;
+
+    running_ = true;
+    thread_ = std::thread(&ESpeakService::run, this);
+    return true;
+}
+
+//------------------------------------------------------------------------
+void ESpeakService::unload() {
+    if (!library_) {
+        return;
+    }
+    if (initialized_ && fn_Terminate_) {
+        ((espeak_Terminate_t)fn_Terminate_)();
+    }
+    initialized_ = false;
+    if (s_active == this) {
+        s_active = nullptr;
+    }
+#ifdef _WIN32
+    FreeLibrary(library_);
+#else
+    dlclose(library_);
+#endif
+    library_ = nullptr;
+}
+
+//------------------------------------------------------------------------
+int ESpeakService::addClient() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClientQueue client;
+    client.id = nextClientId_++;
+    clients_.push_back(std::move(client));
+    return clients_.back().id;
+}
+
+//------------------------------------------------------------------------
+void ESpeakService::removeClient(int client) {
+    cancel(client);
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients_.erase(std::remove_if(clients_.begin(), clients_.end(),
+                                  [client](const ClientQueue& queue) { return queue.id == client; }),
+                   clients_.end());
+    nextClient_ = 0;
+}
+
+//------------------------------------------------------------------------
+void ESpeakService::speak(int client, const std::string& text, const Voice& voice, const Sink& sink) {
+    Request request;
+    request.client = client;
+    request.text = &text;
+    request.voice = &voice;
+    request.sink = &sink;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = std::find_if(clients_.begin(), clients_.end(),
+                           [client](const ClientQueue& queue) { return queue.id == client; });
+    if (it == clients_.end() || !running_) {
+        return;
+    }
+    it->pending.push_back(&request);
+    requestReady_.notify_one();
+    requestDone_.wait(lock, [&request] { return request.done; });
+}
+
+//------------------------------------------------------------------------
+void ESpeakService::cancel(int client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_ && current_->client == client) {
+        current_->cancelled = true;     // Aborted at its next chunk
+    }
+    for (auto& queue : clients_) {
+        if (queue.id != client) {
+            continue;
+        }
+        for (Request* request : queue.pending) {
+            request->done = true;
+        }
+        queue.pending.clear();
+    }
+    requestDone_.notify_all();
+}
+
+//------------------------------------------------------------------------
+ESpeakService::Request* ESpeakService::nextRequest() {
+    // Round-robin over the clients with queued requests
+    for (size_t i = 0; i < clients_.size(); ++i) {
+        ClientQueue& queue = clients_[(nextClient_ + i) % clients_.size()];
+        if (!queue.pending.empty()) {
+            nextClient_ = (nextClient_ + i + 1) % clients_.size();
+            Request* request = queue.pending.front();
+            queue.pending.pop_front();
+            return request;
+        }
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------
+void ESpeakService::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        Request* request = nextRequest();
+        if (!request) {
+            requestReady_.wait(lock);
+            continue;
+        }
+
+        current_ = request;
+        lock.unlock();
+        synthesize(*request);
+        lock.lock();
+
+        current_ = nullptr;
+        request->done = true;
+        requestDone_.notify_all();
+    }
+
+    // Release anyone still waiting
+    for (auto& queue : clients_) {
+        for (Request* request : queue.pending) {
+            request->done = true;
+        }
+        queue.pending.clear();
+    }
+    requestDone_.notify_all();
+}
+
+//------------------------------------------------------------------------
+void ESpeakService::synthesize(Request& request) {
+    if (request.text->empty()) {
+        return;
+    }
+    applyVoice(*request.voice);
+
+    auto synthFn = (espeak_Synth_t)fn_Synth_;
+    synthFn(request.text->c_str(), request.text->length() + 1, 0, POS_CHARACTER, 0,
+            espeakCHARS_AUTO | espeakENDPAUSE, nullptr, nullptr);
+
+    // Wait for completion
+    auto syncFn = (espeak_Synchronize_t)fn_Synchronize_;
+    syncFn();
+}
+
+//------------------------------------------------------------------------
+void ESpeakService::applyVoice(const Voice& voice) {
+    if (voiceApplied_ && voice == applied_) {
+        return;
+    }
+
+    if (fn_SetVoiceByName_ && (!voiceApplied_ || voice.name != applied_.name)) {
+        ((espeak_SetVoiceByName_t)fn_SetVoiceByName_)(voice.name.c_str());
+    }
+    // Selecting a voice resets the parameters, so they always follow
+    if (fn_SetParameter_) {
+        auto setParamFn = (espeak_SetParameter_t)fn_SetParameter_;
+        setParamFn(espeakRATE, voice.rate, 0);
+        // Set both base pitch and pitch range for full effect.
+        // Range 0 = monotone, 50 = normal variation, 100 = max variation;
+        // a lower range gives more consistent pitch
+        setParamFn(espeakPITCH, voice.pitch, 0);
+        setParamFn(espeakRANGE, 20, 0);
+        setParamFn(espeakVOLUME, voice.volume, 0);
+    }
+    applied_ = voice;
+    voiceApplied_ = true;
+}
+
+//------------------------------------------------------------------------
+int ESpeakService::synthCallback(short* wav, int numsamples, void* events) {
+    (void)events;
+
+    // Called on the worker thread, inside synthesize()
+    ESpeakService* service = s_active;
+    Request* request = service ? service->current_ : nullptr;
+    if (!request || !wav || numsamples <= 0) {
+        return 0;   // Continue synthesis
+    }
+    if (request->cancelled || !(*request->sink)(wav, numsamples)) {
+        return 1;   // Abort synthesis
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,135 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// ESpeakService - the process's one eSpeak-NG engine
+// eSpeak keeps its voice, parameters and synth callback in global state,
+// so every ESpeakSynthesizer in the process (one per plugin instance) is
+// a client of this service instead of driving the library itself. One
+// worker thread owns the engine: clients queue requests that carry their
+// own voice settings and output sink, the worker applies the settings and
+// routes the chunks of each utterance to that request's sink only. Clients
+// are served round-robin, so a busy instance can't starve the others.
+// The library is loaded on the first acquire() and unloaded with the
+// last client.
+//------------------------------------------------------------------------
+class ESpeakService {
+public:
+    // Voice settings of one request (applied only when they change)
+    struct Voice {
+        std::string name = "en";
+        int rate = 175;
+        int pitch = 50;
+        int volume = 100;
+
+        bool operator==(const Voice& other) const {
+            return name == other.name && rate == other.rate && pitch == other.pitch && volume == other.volume;
+        }
+    };
+
+    // Receives eSpeak's 16-bit chunks on the worker thread; return false
+    // to abort the rest of the utterance
+    using Sink = std::function<bool(const short* samples, int count)>;
+
+    // The shared service, loading and initializing eSpeak on first use
+    // (nullptr and error set if that failed)
+    static std::shared_ptr<ESpeakService> acquire(std::string& error);
+
+    ~ESpeakService();
+
+    ESpeakService(const ESpeakService&) = delete;
+    ESpeakService& operator=(const ESpeakService&) = delete;
+
+    // Rate eSpeak renders at (the same for all clients)
+    int getSampleRate() const { return sampleRate_; }
+
+    // Client ids, one per synthesizer, for fair scheduling and cancel()
+    int addClient();
+    void removeClient(int client);
+
+    // Synthesize text, blocking until it is done or cancelled
+    void speak(int client, const std::string& text, const Voice& voice, const Sink& sink);
+
+    // Abort the client's utterance in progress and drop its queued ones
+    void cancel(int client);
+
+private:
+    struct Request {
+        int client = -1;
+        const std::string* text = nullptr;
+        const Voice* voice = nullptr;
+        const Sink* sink = nullptr;
+        std::atomic<bool> cancelled{false};
+        bool done = false;
+    };
+
+    struct ClientQueue {
+        int id = -1;
+        std::deque<Request*> pending;
+    };
+
+    ESpeakService() = default;
+
+    bool load(std::string& error);
+    void unload();
+    void run();
+    void synthesize(Request& request);
+    void applyVoice(const Voice& voice);
+    Request* nextRequest();
+    static int synthCallback(short* wav, int numsamples, void* events);
+
+    int sampleRate_ = 22050;
+    bool initialized_ = false;      // espeak_Initialize succeeded
+
+#ifdef _WIN32
+    HMODULE library_ = nullptr;
+#else
+    void* library_ = nullptr;       // dlopen handle
+#endif
+
+    // Function pointers for dynamic loading
+    void* fn_Initialize_ = nullptr;
+    void* fn_SetSynthCallback_ = nullptr;
+    void* fn_SetParameter_ = nullptr;
+    void* fn_SetVoiceByName_ = nullptr;
+    void* fn_Synth_ = nullptr;
+    void* fn_Synchronize_ = nullptr;
+    void* fn_Terminate_ = nullptr;
+
+    // Worker thread only
+    Voice applied_;
+    bool voiceApplied_ = false;
+
+    std::mutex mutex_;              // Guards everything below
+    Request* current_ = nullptr;    // Being synthesized (read unlocked by the worker)
+    std::condition_variable requestReady_;
+    std::condition_variable requestDone_;
+    std::vector<ClientQueue> clients_;
+    size_t nextClient_ = 0;         // Round-robin position
+    int nextClientId_ = 0;
+    bool running_ = false;
+    std::thread thread_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
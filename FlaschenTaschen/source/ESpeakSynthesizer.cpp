@@ -8,32 +8,11 @@
 
 namespace FlaschenTaschen {
 
-// Static members
-ESpeakSynthesizer* ESpeakSynthesizer::currentInstance_ = nullptr;
-std::mutex ESpeakSynthesizer::instanceMutex_;
-
-// eSpeak constants (from speak_lib.h)
 namespace {
-    constexpr int AUDIO_OUTPUT_SYNCHRONOUS = 0x02;
-    constexpr int espeakCHARS_AUTO = 0;
-    constexpr int espeakENDPAUSE = 0x1000;
-    constexpr int espeakRATE = 1;
-    constexpr int espeakVOLUME = 2;
-    constexpr int espeakPITCH = 3;
-    constexpr int espeakRANGE = 4;  // Pitch range/variation
-    constexpr int POS_CHARACTER = 1;
+    // eSpeak delivers 16-bit PCM
+    constexpr float kSampleScale = 1.0f / 32768.0f;
 }
 
-// Function pointer types
-typedef int (*espeak_Initialize_t)(int, int, const char*, int);
-typedef void (*espeak_SetSynthCallback_t)(void*);
-typedef int (*espeak_SetParameter_t)(int, int, int);
-typedef int (*espeak_SetVoiceByName_t)(const char*);
-typedef int (*espeak_Synth_t)(const void*, size_t, unsigned int, int, unsigned int, unsigned int, unsigned int*, void*);
-typedef int (*espeak_Synchronize_t)(void);
-typedef int (*espeak_Cancel_t)(void);
-typedef int (*espeak_Terminate_t)(void);
-
 //------------------------------------------------------------------------
 ESpeakSynthesizer::ESpeakSynthesizer() {
 }
@@ -41,78 +20,6 @@ ESpeakSynthesizer::ESpeakSynthesizer() {
 //------------------------------------------------------------------------
 ESpeakSynthesizer::~ESpeakSynthesizer() {
     shutdown();
-    unloadDll();
-}
-
-//------------------------------------------------------------------------
-bool ESpeakSynthesizer::loadDll() {
-#ifdef _WIN32
-    if (dllLoaded_) return true;
-
-    // Try multiple paths
-    const char* dllPaths[] = {
-        "C:\\Program Files\\eSpeak NG\\libespeak-ng.dll",
-        "C:\\Program Files (x86)\\eSpeak NG\\libespeak-ng.dll",
-        "libespeak-ng.dll",
-        nullptr
-    };
-
-    for (int i = 0; dllPaths[i] != nullptr; ++i) {
-        espeakDll_ = LoadLibraryA(dllPaths[i]);
-        if (espeakDll_) break;
-    }
-
-    if (!espeakDll_) {
-        lastError_ = "Failed to load libespeak-ng.dll";
-        return false;
-    }
-
-    // Load function pointers
-    fn_Initialize_ = (void*)GetProcAddress(espeakDll_, "espeak_Initialize");
-    fn_SetSynthCallback_ = (void*)GetProcAddress(espeakDll_, "espeak_SetSynthCallback");
-    fn_SetParameter_ = (void*)GetProcAddress(espeakDll_, "espeak_SetParameter");
-    fn_SetVoiceByName_ = (void*)GetProcAddress(espeakDll_, "espeak_SetVoiceByName");
-    fn_Synth_ = (void*)GetProcAddress(espeakDll_, "espeak_Synth");
-    fn_Synchronize_ = (void*)GetProcAddress(espeakDll_, "espeak_Synchronize");
-    fn_Cancel_ = (void*)GetProcAddress(espeakDll_, "espeak_Cancel");
-    fn_Terminate_ = (void*)GetProcAddress(espeakDll_, "espeak_Terminate");
-
-    if (!fn_Initialize_ || !fn_SetSynthCallback_ || !fn_Synth_) {
-        lastError_ = "Failed to load eSpeak-NG functions";
-        FreeLibrary(espeakDll_);
-        espeakDll_ = nullptr;
-        return false;
-    }
-
-    dllLoaded_ = true;
-    return true;
-#else
-    lastError_ = "Dynamic loading not implemented for this platform";
-    return false;
-#endif
-}
-
-//------------------------------------------------------------------------
-void ESpeakSynthesizer::unloadDll() {
-#ifdef _WIN32
-    if (espeakDll_) {
-        FreeLibrary(espeakDll_);
-        espeakDll_ = nullptr;
-    }
-    dllLoaded_ = false;
-#endif
-}
-
-//------------------------------------------------------------------------
-int ESpeakSynthesizer::synthCallbackStatic(short* wav, int numsamples, void* events) {
-    (void)events;
-
-    std::lock_guard<std::mutex> lock(instanceMutex_);
-    if (currentInstance_ && wav && numsamples > 0) {
-        currentInstance_->appendSamples(wav, numsamples);
-    }
-
-    return 0; // Continue synthesis
 }
 
 //------------------------------------------------------------------------
@@ -123,28 +30,13 @@ bool ESpeakSynthesizer::initialize(int sampleRate) {
 
     sampleRate_ = sampleRate;
 
-    // Load DLL
-    if (!loadDll()) {
+    // Loads and initializes eSpeak for the first synthesizer only
+    service_ = ESpeakService::acquire(lastError_);
+    if (!service_) {
         return false;
     }
-
-    // Initialize eSpeak
-    auto initFn = (espeak_Initialize_t)fn_Initialize_;
-    int result = initFn(AUDIO_OUTPUT_SYNCHRONOUS, 0, nullptr, 0);
-    if (result < 0) {
-        lastError_ = "espeak_Initialize failed";
-        return false;
-    }
-
-    // Set callback
-    auto setCallbackFn = (espeak_SetSynthCallback_t)fn_SetSynthCallback_;
-    setCallbackFn((void*)synthCallbackStatic);
-
-    // Set default parameters
-    setVoice(voice_);
-    setRate(rate_);
-    setPitch(pitch_);
-    setVolume(volume_);
+    sampleRate_ = service_->getSampleRate();
+    clientId_ = service_->addClient();
 
     initialized_ = true;
     return true;
@@ -152,90 +44,74 @@ bool ESpeakSynthesizer::initialize(int sampleRate) {
 
 //------------------------------------------------------------------------
 void ESpeakSynthesizer::shutdown() {
-    if (initialized_ && fn_Terminate_) {
-        stop();
-        auto terminateFn = (espeak_Terminate_t)fn_Terminate_;
-        terminateFn();
+    if (initialized_) {
+        // The engine goes away with its last client
+        service_->removeClient(clientId_);
+        service_.reset();
+        clientId_ = -1;
+        speaking_ = false;
         initialized_ = false;
     }
 }
 
+//------------------------------------------------------------------------
+// Voice settings travel with each request; the service applies them when
+// they differ from the last utterance's
 //------------------------------------------------------------------------
 void ESpeakSynthesizer::setVoice(const std::string& voice) {
     voice_ = voice;
-    if (initialized_ && fn_SetVoiceByName_) {
-        auto setVoiceFn = (espeak_SetVoiceByName_t)fn_SetVoiceByName_;
-        setVoiceFn(voice.c_str());
-    }
 }
 
 //------------------------------------------------------------------------
 void ESpeakSynthesizer::setRate(int rate) {
     rate_ = (std::max)(80, (std::min)(450, rate));
-    if (initialized_ && fn_SetParameter_) {
-        auto setParamFn = (espeak_SetParameter_t)fn_SetParameter_;
-        setParamFn(espeakRATE, rate_, 0);
-    }
 }
 
 //------------------------------------------------------------------------
 void ESpeakSynthesizer::setPitch(int pitch) {
     pitch_ = (std::max)(0, (std::min)(99, pitch));
-    if (initialized_ && fn_SetParameter_) {
-        auto setParamFn = (espeak_SetParameter_t)fn_SetParameter_;
-        // Set both base pitch and pitch range for full effect
-        setParamFn(espeakPITCH, pitch_, 0);
-        // Range 0 = monotone, 50 = normal variation, 100 = max variation
-        // Use lower range for more consistent pitch
-        setParamFn(espeakRANGE, 20, 0);
-    }
 }
 
 //------------------------------------------------------------------------
 void ESpeakSynthesizer::setVolume(int volume) {
     volume_ = (std::max)(0, (std::min)(200, volume));
-    if (initialized_ && fn_SetParameter_) {
-        auto setParamFn = (espeak_SetParameter_t)fn_SetParameter_;
-        setParamFn(espeakVOLUME, volume_, 0);
-    }
 }
 
 //------------------------------------------------------------------------
 void ESpeakSynthesizer::speak(const std::string& text) {
-    if (!initialized_ || text.empty() || !fn_Synth_ || !fn_Synchronize_) {
+    speak(text, ChunkCallback());
+}
+
+//------------------------------------------------------------------------
+void ESpeakSynthesizer::speak(const std::string& text, const ChunkCallback& onChunk) {
+    if (!initialized_ || text.empty()) {
         return;
     }
 
-    // Set current instance for callback
-    {
-        std::lock_guard<std::mutex> lock(instanceMutex_);
-        currentInstance_ = this;
-    }
+    ESpeakService::Voice voice;
+    voice.name = voice_;
+    voice.rate = rate_;
+    voice.pitch = pitch_;
+    voice.volume = volume_;
 
-    speaking_ = true;
-
-    // Synthesize
-    auto synthFn = (espeak_Synth_t)fn_Synth_;
-    synthFn(text.c_str(), text.length() + 1, 0, POS_CHARACTER, 0,
-            espeakCHARS_AUTO | espeakENDPAUSE, nullptr, nullptr);
-
-    // Wait for completion
-    auto syncFn = (espeak_Synchronize_t)fn_Synchronize_;
-    syncFn();
+    // Chunks go to this synthesizer only
+    const ESpeakService::Sink sink = [this, &onChunk](const short* samples, int count) {
+        if (onChunk) {
+            return deliverChunk(samples, count, onChunk);
+        }
+        appendSamples(samples, count);
+        return true;
+    };
 
+    speaking_ = true;
+    service_->speak(clientId_, text, voice, sink);
     speaking_ = false;
-
-    {
-        std::lock_guard<std::mutex> lock(instanceMutex_);
-        currentInstance_ = nullptr;
-    }
 }
 
 //------------------------------------------------------------------------
 void ESpeakSynthesizer::stop() {
-    if (initialized_ && fn_Cancel_) {
-        auto cancelFn = (espeak_Cancel_t)fn_Cancel_;
-        cancelFn();
+    if (initialized_) {
+        service_->cancel(clientId_);
         speaking_ = false;
     }
 }
@@ -244,10 +120,25 @@ void ESpeakSynthesizer::stop() {
 void ESpeakSynthesizer::appendSamples(const short* samples, int count) {
     std::lock_guard<std::mutex> lock(bufferMutex_);
 
+    // Grow once per chunk, then convert in a tight loop
+    size_t start = audioBuffer_.size();
+    audioBuffer_.resize(start + count);
+    float* dest = audioBuffer_.data() + start;
+    for (int i = 0; i < count; ++i) {
+        dest[i] = static_cast<float>(samples[i]) * kSampleScale;
+    }
+}
+
+//------------------------------------------------------------------------
+bool ESpeakSynthesizer::deliverChunk(const short* samples, int count, const ChunkCallback& onChunk) {
+    // Buffer only grows to the largest chunk seen, then is reused
+    if (chunkBuffer_.size() < static_cast<size_t>(count)) {
+        chunkBuffer_.resize(count);
+    }
     for (int i = 0; i < count; ++i) {
-        float sample = static_cast<float>(samples[i]) / 32768.0f;
-        audioBuffer_.push_back(sample);
+        chunkBuffer_[i] = static_cast<float>(samples[i]) * kSampleScale;
     }
+    return onChunk(chunkBuffer_.data(), static_cast<size_t>(count));
 }
 
 //------------------------------------------------------------------------
@@ -4,28 +4,37 @@
 
 #pragma once
 
+#include "ESpeakService.h"
+
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <atomic>
-
-#ifdef _WIN32
-#include <windows.h>
-#endif
+#include <functional>
 
 namespace FlaschenTaschen {
 
 //------------------------------------------------------------------------
 // ESpeakSynthesizer - Text-to-speech using eSpeak-NG library
-// Uses dynamic loading on Windows to avoid link-time dependency
+// A client of the process-wide ESpeakService, which loads the library at
+// runtime (LoadLibrary / dlopen) to avoid a link-time dependency. Voice
+// settings and the output buffer are per synthesizer, so instances can
+// speak from different threads without clobbering each other.
 //------------------------------------------------------------------------
 class ESpeakSynthesizer {
 public:
+    // Receives converted float samples as eSpeak produces them.
+    // Return false to abort the rest of the utterance.
+    using ChunkCallback = std::function<bool(const float* samples, size_t count)>;
+
     ESpeakSynthesizer();
     ~ESpeakSynthesizer();
 
-    // Initialize the synthesizer (must be called before use)
+    // Initialize the synthesizer (must be called before use). sampleRate is
+    // the preferred rate; eSpeak-NG renders at its voice data rate only, so
+    // check getSampleRate()/supportsSampleRate() afterwards.
     bool initialize(int sampleRate = 44100);
 
     // Shutdown the synthesizer
@@ -40,10 +49,21 @@ public:
     void setPitch(int pitch);   // Pitch (0-99, default 50)
     void setVolume(int volume); // Volume (0-200, default 100)
 
+    // Get voice parameters as currently applied
+    const std::string& getVoice() const { return voice_; }
+    int getRate() const { return rate_; }
+    int getPitch() const { return pitch_; }
+    int getVolume() const { return volume_; }
+
     // Speak text (generates audio samples)
     void speak(const std::string& text);
 
-    // Stop current speech
+    // Speak text, handing each chunk to onChunk as soon as eSpeak delivers
+    // it instead of buffering (called on the service thread while speak()
+    // waits). getAudioSamples() stays empty in this mode.
+    void speak(const std::string& text, const ChunkCallback& onChunk);
+
+    // Stop this synthesizer's speech (other instances keep speaking)
     void stop();
 
     // Check if currently speaking
@@ -58,15 +78,17 @@ public:
     // Read samples into buffer without clearing
     size_t readSamples(float* buffer, size_t maxSamples);
 
-    // Get sample rate
+    // Get sample rate (the rate eSpeak actually produces once initialized)
     int getSampleRate() const { return sampleRate_; }
 
+    // Check if audio can be produced at rate without resampling
+    bool supportsSampleRate(int rate) const { return initialized_ && rate == sampleRate_; }
+
     // Get last error message
     const std::string& getLastError() const { return lastError_; }
 
 private:
     bool initialized_ = false;
-    bool dllLoaded_ = false;
     int sampleRate_ = 44100;
     std::atomic<bool> speaking_{false};
     std::string lastError_;
@@ -75,34 +97,21 @@ private:
     std::vector<float> audioBuffer_;
     mutable std::mutex bufferMutex_;
 
+    // Conversion buffer for streaming speak() calls
+    std::vector<float> chunkBuffer_;
+
     // Voice settings
     std::string voice_ = "en";
     int rate_ = 175;
     int pitch_ = 50;
     int volume_ = 100;
 
-#ifdef _WIN32
-    HMODULE espeakDll_ = nullptr;
-#endif
-
-    // Function pointers for dynamic loading
-    void* fn_Initialize_ = nullptr;
-    void* fn_SetSynthCallback_ = nullptr;
-    void* fn_SetParameter_ = nullptr;
-    void* fn_SetVoiceByName_ = nullptr;
-    void* fn_Synth_ = nullptr;
-    void* fn_Synchronize_ = nullptr;
-    void* fn_Cancel_ = nullptr;
-    void* fn_Terminate_ = nullptr;
-
-    bool loadDll();
-    void unloadDll();
-    void appendSamples(const short* samples, int count);
+    // Shared engine and our place in its queue
+    std::shared_ptr<ESpeakService> service_;
+    int clientId_ = -1;
 
-    // Static callback handling
-    static ESpeakSynthesizer* currentInstance_;
-    static std::mutex instanceMutex_;
-    static int synthCallbackStatic(short* wav, int numsamples, void* events);
+    void appendSamples(const short* samples, int count);
+    bool deliverChunk(const short* samples, int count, const ChunkCallback& onChunk);
 };
 
 //------------------------------------------------------------------------
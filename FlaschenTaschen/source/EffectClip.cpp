@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "EffectClip.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace FlaschenTaschen {
+
+static_assert(sizeof(ClipHeader) == 32, "clip header layout changed");
+
+//------------------------------------------------------------------------
+bool EffectClip::open(const std::string& path) {
+    close();
+    if (!file_.open(path)) {
+        lastError_ = file_.getLastError();
+        return false;
+    }
+
+    ClipHeader header{};
+    if (file_.getSize() >= sizeof(header)) {
+        std::memcpy(&header, file_.getData(), sizeof(header));
+    }
+    if (header.magic != ClipHeader::kMagic) {
+        lastError_ = "Not a clip file: " + path;
+        close();
+        return false;
+    }
+    if (header.version != ClipHeader::kVersion) {
+        lastError_ = "Unsupported clip version " + std::to_string(header.version) + ": " + path;
+        close();
+        return false;
+    }
+
+    // Only whole frames inside the file are played
+    const uint64_t frameBytes = static_cast<uint64_t>(header.width) * header.height * 3;
+    const uint64_t available = header.frameOffset >= sizeof(header) && header.frameOffset <= file_.getSize()
+        ? file_.getSize() - header.frameOffset : 0;
+    const uint64_t frames = frameBytes > 0 ? (std::min)(static_cast<uint64_t>(header.frameCount), available / frameBytes) : 0;
+    if (frames == 0 || header.width > 4096 || header.height > 4096) {
+        lastError_ = "Clip has no playable frames: " + path;
+        close();
+        return false;
+    }
+
+    width_ = static_cast<int>(header.width);
+    height_ = static_cast<int>(header.height);
+    fps_ = static_cast<int>((std::max)(1u, (std::min)(header.fps, 240u)));
+    frameCount_ = static_cast<int>((std::min)(frames, static_cast<uint64_t>(INT32_MAX)));
+    frameOffset_ = header.frameOffset;
+    frameBytes_ = static_cast<size_t>(frameBytes);
+    return true;
+}
+
+//------------------------------------------------------------------------
+void EffectClip::close() {
+    file_.close();
+    width_ = 0;
+    height_ = 0;
+    fps_ = 1;
+    frameCount_ = 0;
+    prefetched_ = -1;
+    lastShown_ = -1;
+    releasedTo_ = 0;
+}
+
+//------------------------------------------------------------------------
+const uint8_t* EffectClip::getFrame(int index) {
+    if (!isOpen()) {
+        return nullptr;
+    }
+    index %= frameCount_;
+    if (index < 0) {
+        index += frameCount_;
+    }
+    if (index == lastShown_) {
+        return file_.getData() + frameOffset_ + index * frameBytes_;
+    }
+
+    const bool restarted = index < lastShown_;
+    const bool large = file_.getSize() > kResidentBytes;
+    if (restarted) {
+        if (large) {
+            file_.release(releasedTo_, file_.getSize() - releasedTo_);
+        }
+        releasedTo_ = 0;
+        prefetched_ = -1;
+    }
+    lastShown_ = index;
+
+    // Read the next frames in while this one is sent
+    const int ahead = (std::min)(frameCount_ - 1, index + kPrefetchFrames);
+    if (ahead > prefetched_) {
+        const int from = (std::max)(index + 1, prefetched_ + 1);
+        if (from <= ahead) {
+            file_.prefetch(frameOffset_ + from * frameBytes_, (ahead - from + 1) * frameBytes_);
+        }
+        prefetched_ = ahead;
+    }
+
+    // Drop what has been shown, a chunk at a time
+    const size_t frameStart = frameOffset_ + index * frameBytes_;
+    if (large && frameStart >= releasedTo_ + 2 * kReleaseChunk) {
+        const size_t releaseTo = (frameStart - kReleaseChunk) / kReleaseChunk * kReleaseChunk;
+        file_.release(releasedTo_, releaseTo - releasedTo_);
+        releasedTo_ = releaseTo;
+    }
+    return file_.getData() + frameStart;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "MappingBinary.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// Clip (.ftclip) layout
+// One header, then frameCount frames from frameOffset on, each height
+// rows of width packed RGB pixels, top row first, stored back to back.
+// Converters (GIF/PNG sequence to .ftclip) write the pixels as they should
+// appear; nothing is decoded at playback. All fields are little-endian.
+//------------------------------------------------------------------------
+struct ClipHeader {
+    static constexpr uint32_t kMagic = 0x4C435446;  // "FTCL"
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t fps;
+    uint32_t frameCount;
+    uint32_t frameOffset;       // First frame (>= sizeof(ClipHeader))
+    uint32_t reserved;
+};
+
+//------------------------------------------------------------------------
+// EffectClip - a memory-mapped clip played by the Clip effect
+// Frames are read straight from the mapping, so only the pages of frames
+// actually shown are ever loaded. getFrame() asks the OS to read the next
+// frames ahead, and on clips past kResidentBytes drops the pages of frames
+// already shown, so a long clip holds only a window of itself in memory.
+//------------------------------------------------------------------------
+class EffectClip {
+public:
+    static constexpr int kPrefetchFrames = 4;
+    static constexpr size_t kResidentBytes = 16 * 1024 * 1024;
+    static constexpr size_t kReleaseChunk = 1024 * 1024;    // Multiple of any page size
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return frameCount_ > 0; }
+
+    // Pixels of frame index (wrapped to the clip), width * height RGB
+    const uint8_t* getFrame(int index);
+
+    // Frame to show at elapsedMs
+    int frameAt(int elapsedMs) const {
+        return static_cast<int>(static_cast<int64_t>(elapsedMs) * fps_ / 1000);
+    }
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    int getFps() const { return fps_; }
+    int getFrameCount() const { return frameCount_; }
+    int getDurationMs() const {
+        return static_cast<int>(static_cast<int64_t>(frameCount_) * 1000 / fps_);
+    }
+    const std::string& getLastError() const { return lastError_; }
+
+private:
+    MappedFile file_;
+    int width_ = 0;
+    int height_ = 0;
+    int fps_ = 1;
+    int frameCount_ = 0;
+    size_t frameOffset_ = 0;
+    size_t frameBytes_ = 0;
+    int prefetched_ = -1;       // Last frame asked for ahead
+    int lastShown_ = -1;
+    size_t releasedTo_ = 0;     // Pages before this were dropped (kReleaseChunk aligned)
+    std::string lastError_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
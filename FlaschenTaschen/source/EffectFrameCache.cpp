@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "EffectFrameCache.h"
+#include "FlaschenTaschenClient.h"
+#include "VisualEffects.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace FlaschenTaschen {
+
+namespace {
+
+constexpr size_t kMaxRun = 0xFFFF;
+
+void appendRunHeader(std::vector<uint8_t>& out, size_t skip, size_t count) {
+    const uint16_t header[2] = { static_cast<uint16_t>(skip), static_cast<uint16_t>(count) };
+    const auto* bytes = reinterpret_cast<const uint8_t*>(header);
+    out.insert(out.end(), bytes, bytes + sizeof(header));
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+void EffectFrameCache::build(const std::vector<Effect>& effects, int width, int height, int fps, size_t maxBytes) {
+    width_ = width;
+    height_ = height;
+    fps_ = (std::max)(1, fps);
+    memorySize_ = 0;
+    sequences_.clear();
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    // Frames are kept in logical order; playback applies the display's flip
+    FlaschenTaschenClient canvas;
+    canvas.setDisplaySize(width, height);
+    canvas.setFlipHorizontal(false);
+    const size_t pixels = static_cast<size_t>(width) * height;
+    const size_t stride = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> previous(pixels * 3);
+    std::vector<uint8_t> current(pixels * 3);
+
+    for (const Effect& effect : effects) {
+        if (effect.type == EffectType::None || effect.type == EffectType::Clip || effect.durationMs <= 0) {
+            continue;   // Clips are frames already
+        }
+
+        Sequence sequence;
+        sequence.effect = effect;
+        VisualEffects player;
+        player.startEffectAt(effect, 127, 0.0);
+        std::fill(previous.begin(), previous.end(), 0);
+
+        bool fits = true;
+        for (int frame = 0; ; ++frame) {
+            // Each slot's first millisecond (see frameAt())
+            const int slotMs = static_cast<int>((static_cast<int64_t>(frame) * 1000 + fps_ - 1) / fps_);
+            if (!player.updateAt(canvas, slotMs)) {
+                break;
+            }
+            for (int y = 0; y < height; ++y) {
+                std::memcpy(current.data() + y * stride, canvas.getRow(y), stride);
+            }
+            sequence.offsets.push_back(static_cast<uint32_t>(sequence.data.size()));
+            encodeFrame(previous.data(), current.data(), pixels, sequence.data);
+            previous.swap(current);
+            ++sequence.frameCount;
+
+            if (memorySize_ + sequence.data.size() + sequence.offsets.size() * sizeof(uint32_t) > maxBytes) {
+                fits = false;
+                break;
+            }
+        }
+        if (!fits || sequence.frameCount == 0) {
+            continue;   // Renders live
+        }
+        sequence.offsets.push_back(static_cast<uint32_t>(sequence.data.size()));
+        sequence.data.shrink_to_fit();
+        memorySize_ += sequence.data.size() + sequence.offsets.size() * sizeof(uint32_t);
+        sequences_.push_back(std::move(sequence));
+    }
+}
+
+//------------------------------------------------------------------------
+void EffectFrameCache::encodeFrame(const uint8_t* previous, const uint8_t* current,
+                                   size_t pixels, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while (i < pixels) {
+        // Unchanged pixels, then changed ones, each at most kMaxRun long
+        size_t skip = 0;
+        while (i + skip < pixels && skip < kMaxRun &&
+               std::memcmp(previous + (i + skip) * 3, current + (i + skip) * 3, 3) == 0) {
+            ++skip;
+        }
+        i += skip;
+        size_t count = 0;
+        while (i + count < pixels && count < kMaxRun &&
+               std::memcmp(previous + (i + count) * 3, current + (i + count) * 3, 3) != 0) {
+            ++count;
+        }
+        if (count == 0 && i == pixels) {
+            break;      // Trailing unchanged pixels need no run
+        }
+        appendRunHeader(out, skip, count);
+        out.insert(out.end(), current + i * 3, current + (i + count) * 3);
+        i += count;
+    }
+}
+
+//------------------------------------------------------------------------
+void EffectFrameCache::decodeFrame(const Sequence& sequence, int index, uint8_t* rgb) const {
+    decodeRuns(sequence.data.data() + sequence.offsets[index],
+               sequence.offsets[index + 1] - sequence.offsets[index],
+               rgb, static_cast<size_t>(width_) * height_);
+}
+
+//------------------------------------------------------------------------
+bool EffectFrameCache::decodeRuns(const uint8_t* data, size_t size, uint8_t* rgb, size_t pixels) {
+    const uint8_t* end = data + size;
+    size_t pixel = 0;
+    while (data < end) {
+        uint16_t header[2];
+        if (static_cast<size_t>(end - data) < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(header, data, sizeof(header));
+        data += sizeof(header);
+        pixel += header[0];
+        const size_t bytes = static_cast<size_t>(header[1]) * 3;
+        if (pixel + header[1] > pixels || static_cast<size_t>(end - data) < bytes) {
+            return false;
+        }
+        std::memcpy(rgb + pixel * 3, data, bytes);
+        data += bytes;
+        pixel += header[1];
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+const EffectFrameCache::Sequence* EffectFrameCache::find(const Effect& effect) const {
+    for (const Sequence& sequence : sequences_) {
+        if (samePattern(sequence.effect, effect)) {
+            return &sequence;
+        }
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------
+bool EffectFrameCache::samePattern(const Effect& a, const Effect& b) {
+    return a.id == b.id && a.type == b.type &&
+           a.color1R == b.color1R && a.color1G == b.color1G && a.color1B == b.color1B &&
+           a.color2R == b.color2R && a.color2G == b.color2G && a.color2B == b.color2B &&
+           a.durationMs == b.durationMs && a.periodMs == b.periodMs &&
+           a.rampDirection == b.rampDirection && a.intensity == b.intensity &&
+           a.speed == b.speed && a.seed == b.seed;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
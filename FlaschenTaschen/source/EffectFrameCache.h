@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "MappingConfig.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// EffectFrameCache - every frame of every effect, rendered ahead of time
+// build() plays each effect at full brightness into an offscreen frame,
+// one frame per slot of the display frame rate, and keeps each frame as
+// the runs of pixels that changed since the one before. Static effects
+// cost one frame, slow ones a fraction of theirs. VisualEffects plays a
+// cached effect by decoding forward instead of rendering (see
+// setFrameCache()), showing the frame of the elapsed time's slot scaled
+// by its brightness. Effects past the byte budget render live. Immutable
+// once built.
+//------------------------------------------------------------------------
+class EffectFrameCache {
+public:
+    // One effect's frames: frame i spans data[offsets[i], offsets[i + 1]),
+    // a list of (uint16 skip, uint16 count, count RGB pixels) runs applied
+    // to frame i - 1 (frame 0 to black)
+    struct Sequence {
+        Effect effect;
+        int frameCount = 0;
+        std::vector<uint32_t> offsets;
+        std::vector<uint8_t> data;
+    };
+
+    // Render effects for a width x height display at fps within maxBytes
+    void build(const std::vector<Effect>& effects, int width, int height, int fps, size_t maxBytes);
+
+    // Cached frames of effect (same id and parameters), nullptr if none
+    const Sequence* find(const Effect& effect) const;
+
+    // Frame slot of an elapsed time
+    int frameAt(int elapsedMs) const {
+        return static_cast<int>(static_cast<int64_t>(elapsedMs) * fps_ / 1000);
+    }
+
+    // Turn rgb (packed, frame index - 1 of sequence) into frame index
+    void decodeFrame(const Sequence& sequence, int index, uint8_t* rgb) const;
+
+    // The run coding, also used by FrameCapture: append the runs that turn
+    // previous into current (both pixels * 3 bytes), and apply size bytes
+    // of runs to rgb (false if they are malformed or overrun pixels)
+    static void encodeFrame(const uint8_t* previous, const uint8_t* current,
+                            size_t pixels, std::vector<uint8_t>& out);
+    static bool decodeRuns(const uint8_t* data, size_t size, uint8_t* rgb, size_t pixels);
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    int getFps() const { return fps_; }
+    size_t getCachedCount() const { return sequences_.size(); }
+    size_t getMemorySize() const { return memorySize_; }
+
+private:
+    static bool samePattern(const Effect& a, const Effect& b);
+
+    int width_ = 0;
+    int height_ = 0;
+    int fps_ = 0;
+    size_t memorySize_ = 0;
+    std::vector<Sequence> sequences_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -3,8 +3,17 @@
 //------------------------------------------------------------------------
 
 #include "FlaschenTaschenClient.h"
-#include <sstream>
+#include "FrameKernels.h"
+#include "FrameCapture.h"
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <utility>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <fcntl.h>
+#endif
 
 namespace FlaschenTaschen {
 
@@ -12,7 +21,9 @@ namespace FlaschenTaschen {
 // FlaschenTaschenClient Implementation
 //------------------------------------------------------------------------
 FlaschenTaschenClient::FlaschenTaschenClient() {
+    kernels_ = &FrameKernels::select(width_, height_, flipHorizontal_);
     resizeBuffer();
+    rebuildHeader();
 }
 
 FlaschenTaschenClient::~FlaschenTaschenClient() {
@@ -20,7 +31,7 @@ FlaschenTaschenClient::~FlaschenTaschenClient() {
 }
 
 bool FlaschenTaschenClient::connect(const std::string& ip, int port) {
-    disconnect();  // Clean up any existing connection
+    disconnect();  // Clean up any existing connection (stops the sender)
 
 #ifdef _WIN32
     // Initialize Winsock
@@ -69,11 +80,23 @@ bool FlaschenTaschenClient::connect(const std::string& ip, int port) {
     }
 #endif
 
+    applySocketMode();
+
     isConnected_ = true;
+    hasSentFrame_ = false;
+    bytesSent_ = 0;
+    droppedFrames_ = 0;
+    lateFrames_ = 0;
+
+    if (asyncSend_) {
+        startSender();
+    }
     return true;
 }
 
 void FlaschenTaschenClient::disconnect() {
+    stopSender();
+
 #ifdef _WIN32
     if (socket_ != INVALID_SOCKET) {
         closesocket(socket_);
@@ -88,35 +111,175 @@ void FlaschenTaschenClient::disconnect() {
     isConnected_ = false;
 }
 
+void FlaschenTaschenClient::setNonBlocking(bool enabled) {
+    waitForSender();
+    nonBlocking_ = enabled;
+    if (isConnected_) {
+        applySocketMode();
+    }
+}
+
+void FlaschenTaschenClient::applySocketMode() {
+    // Best effort: a socket that stays blocking still works
+#ifdef _WIN32
+    u_long mode = nonBlocking_ ? 1 : 0;
+    ioctlsocket(socket_, FIONBIO, &mode);
+#else
+    const int flags = fcntl(socket_, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(socket_, F_SETFL, nonBlocking_ ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+    }
+#endif
+    if (nonBlocking_) {
+        int size = kNonBlockingSendBuffer;
+        setsockopt(socket_, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+}
+
 void FlaschenTaschenClient::setDisplaySize(int width, int height) {
     if (width > 0 && height > 0) {
+        waitForSender();
         width_ = width;
         height_ = height;
+        kernels_ = &FrameKernels::select(width_, height_, flipHorizontal_);
         resizeBuffer();
+        rebuildHeader();
     }
 }
 
+void FlaschenTaschenClient::setFlipHorizontal(bool flip) {
+    flipHorizontal_ = flip;
+    kernels_ = &FrameKernels::select(width_, height_, flipHorizontal_);
+}
+
 void FlaschenTaschenClient::setOffset(int x, int y) {
+    waitForSender();
     offsetX_ = x;
     offsetY_ = y;
+    rebuildHeader();
 }
 
 void FlaschenTaschenClient::setLayer(int z) {
+    waitForSender();
     layer_ = z;
+    rebuildHeader();
+}
+
+void FlaschenTaschenClient::setDeltaMode(bool enabled) {
+    waitForSender();
+    deltaMode_ = enabled;
+    hasSentFrame_ = false;
+}
+
+void FlaschenTaschenClient::setAsyncSend(bool enabled) {
+    asyncSend_ = enabled;
+    if (!enabled) {
+        stopSender();
+    } else if (isConnected_) {
+        startSender();
+    }
+}
+
+void FlaschenTaschenClient::invalidate() {
+    waitForSender();
+    hasSentFrame_ = false;
 }
 
 void FlaschenTaschenClient::resizeBuffer() {
     frameBuffer_.resize(width_ * height_ * 3, 0);
+    queuedBuffer_.resize(frameBuffer_.size(), 0);
+    frontBuffer_.resize(frameBuffer_.size(), 0);
+
+    // Delta buffers are sized up front so sending never allocates
+    sentBuffer_.assign(frameBuffer_.size(), 0);
+    rectBuffer_.resize(frameBuffer_.size());
+    dirtyRects_.reserve(height_);
+    pending_.reserve(height_);
+#if defined(__linux__)
+    iovecs_.reserve(height_ * 2);
+    messages_.reserve(height_);
+#endif
+    hasSentFrame_ = false;
 }
 
 void FlaschenTaschenClient::clear(const Color& color) {
-    for (int i = 0; i < width_ * height_; ++i) {
-        frameBuffer_[i * 3] = color.r;
-        frameBuffer_[i * 3 + 1] = color.g;
-        frameBuffer_[i * 3 + 2] = color.b;
+    kernels_->fill(frameBuffer_.data(), color, width_, height_);
+}
+
+void FlaschenTaschenClient::fillRect(int x, int y, int width, int height, const Color& color) {
+    int x0 = (std::max)(0, x);
+    int x1 = (std::min)(width_, x + width);
+    int y0 = (std::max)(0, y);
+    int y1 = (std::min)(height_, y + height);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    // Mirror the span once, not per pixel
+    if (flipHorizontal_) {
+        int flipped = width_ - x1;
+        x1 = width_ - x0;
+        x0 = flipped;
+    }
+
+    const size_t stride = getStride();
+    const size_t spanBytes = static_cast<size_t>(x1 - x0) * 3;
+    uint8_t* first = frameBuffer_.data() + y0 * stride + x0 * 3;
+
+    // Fill one row, copy it to the rest
+    FrameKernels::fillPixels(first, static_cast<size_t>(x1 - x0), color);
+    for (int row = y0 + 1; row < y1; ++row) {
+        memcpy(frameBuffer_.data() + row * stride + x0 * 3, first, spanBytes);
     }
 }
 
+void FlaschenTaschenClient::blitRow(int x, int y, const uint8_t* rgb, int count) {
+    if (y < 0 || y >= height_) {
+        return;
+    }
+
+    // Full rows (effects) take the geometry's own path
+    uint8_t* row = frameBuffer_.data() + y * getStride();
+    if (x == 0 && count == width_) {
+        kernels_->storeRow(row, rgb, width_);
+        return;
+    }
+
+    // Clip the source span
+    int skip = (std::max)(0, -x);
+    int x0 = x + skip;
+    int x1 = (std::min)(width_, x + count);
+    if (x0 >= x1) {
+        return;
+    }
+
+    const uint8_t* src = rgb + skip * 3;
+
+    if (!flipHorizontal_) {
+        memcpy(row + x0 * 3, src, static_cast<size_t>(x1 - x0) * 3);
+        return;
+    }
+
+    // Flipped: logical x lands at width - 1 - x, so the span runs backwards
+    uint8_t* dst = row + (width_ - 1 - x0) * 3;
+    for (int i = x0; i < x1; ++i, src += 3, dst -= 3) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+    }
+}
+
+void FlaschenTaschenClient::repeatFirstRow() {
+    kernels_->repeatFirstRow(frameBuffer_.data(), width_, height_);
+}
+
+uint8_t* FlaschenTaschenClient::getRow(int y) {
+    if (y < 0 || y >= height_) {
+        return nullptr;
+    }
+    return frameBuffer_.data() + y * getStride();
+}
+
 void FlaschenTaschenClient::setPixel(int x, int y, const Color& color) {
     if (x < 0 || x >= width_ || y < 0 || y >= height_) {
         return;
@@ -139,65 +302,388 @@ Color FlaschenTaschenClient::getPixel(int x, int y) const {
     return Color(frameBuffer_[index], frameBuffer_[index + 1], frameBuffer_[index + 2]);
 }
 
-std::string FlaschenTaschenClient::buildPPMPacket() const {
-    std::ostringstream packet;
+void FlaschenTaschenClient::rebuildHeader() {
+    // PPM P6 header, plus the FlaschenTaschen offset header (optional but useful)
+    int length;
+    if (offsetX_ != 0 || offsetY_ != 0 || layer_ != 0) {
+        length = snprintf(header_.data(), header_.size(), "P6\n%d %d\n#FT: %d %d %d\n255\n",
+                          width_, height_, offsetX_, offsetY_, layer_);
+    } else {
+        length = snprintf(header_.data(), header_.size(), "P6\n%d %d\n255\n", width_, height_);
+    }
+    headerSize_ = length > 0 ? (std::min)(static_cast<size_t>(length), header_.size() - 1) : 0;
+}
 
-    // PPM P6 header
-    packet << "P6\n";
-    packet << width_ << " " << height_ << "\n";
+bool FlaschenTaschenClient::send() {
+    if (!isConnected_ && !nullSink_) {
+        lastError_ = "Not connected";
+        return false;
+    }
 
-    // FlaschenTaschen offset header (optional but useful)
-    if (offsetX_ != 0 || offsetY_ != 0 || layer_ != 0) {
-        packet << "#FT: " << offsetX_ << " " << offsetY_ << " " << layer_ << "\n";
+    if (capture_) {
+        capture_->push(frameBuffer_.data(), frameBuffer_.size());
     }
 
-    // Max color value
-    packet << "255\n";
+    if (senderRunning_) {
+        // Hand the frame over with a pointer exchange; the caller can render
+        // the next frame while the sender transmits. A frame still queued
+        // is either waited for or, in non-blocking mode, replaced.
+        std::unique_lock<std::mutex> lock(senderMutex_);
+        if (nonBlocking_) {
+            if (frameQueued_) {
+                ++droppedFrames_;
+            }
+        } else {
+            senderCondition_.wait(lock, [this] { return !frameQueued_; });
+        }
+        if (transmitting_) {
+            ++lateFrames_;
+        }
+        frameBuffer_.swap(queuedBuffer_);
+        frameQueued_ = true;
+        bool ok = senderResult_;
+        if (!ok) {
+            lastError_ = senderError_;
+        }
+        lock.unlock();
+        senderCondition_.notify_all();
+        return ok;
+    }
+
+    if (!transmit(frameBuffer_)) {
+        lastError_ = sendError_;
+        return false;
+    }
+    return true;
+}
 
-    // Get header as string
-    std::string header = packet.str();
+bool FlaschenTaschenClient::transmit(const std::vector<uint8_t>& frame) {
+    txFrame_ = frame.data();
+    txFrameSize_ = frame.size();
+    wouldBlock_ = false;
+
+    const bool ok = deltaMode_ ? sendDelta() : sendFullFrame();
+    if (!ok && wouldBlock_) {
+        // Socket buffer full: the rest of this frame is dropped, and the
+        // failed send already made the next one a full frame
+        ++droppedFrames_;
+        return true;
+    }
+    return ok;
+}
 
-    // Build complete packet: header + pixel data (already flipped in setPixel)
-    std::string result;
-    result.reserve(header.size() + frameBuffer_.size());
-    result = header;
-    result.append(reinterpret_cast<const char*>(frameBuffer_.data()), frameBuffer_.size());
+void FlaschenTaschenClient::startSender() {
+    if (senderRunning_) {
+        return;
+    }
 
-    return result;
+    frameQueued_ = false;
+    transmitting_ = false;
+    senderResult_ = true;
+    senderStop_ = false;
+    senderRunning_ = true;
+    senderThread_ = std::thread(&FlaschenTaschenClient::runSender, this);
 }
 
-bool FlaschenTaschenClient::send() {
-    if (!isConnected_) {
-        lastError_ = "Not connected";
+void FlaschenTaschenClient::stopSender() {
+    if (!senderRunning_) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(senderMutex_);
+        senderStop_ = true;
+    }
+    senderCondition_.notify_all();
+
+    if (senderThread_.joinable()) {
+        senderThread_.join();
+    }
+    senderRunning_ = false;
+}
+
+void FlaschenTaschenClient::waitForSender() {
+    if (!senderRunning_) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(senderMutex_);
+    senderCondition_.wait(lock, [this] { return !frameQueued_ && !transmitting_; });
+}
+
+void FlaschenTaschenClient::runSender() {
+    std::unique_lock<std::mutex> lock(senderMutex_);
+    while (true) {
+        senderCondition_.wait(lock, [this] { return frameQueued_ || senderStop_; });
+        if (senderStop_) {
+            break;
+        }
+
+        // Take the queued frame; the front buffer is ours until transmitting_ is cleared
+        frontBuffer_.swap(queuedBuffer_);
+        frameQueued_ = false;
+        transmitting_ = true;
+        senderCondition_.notify_all();
+        lock.unlock();
+        bool ok = transmit(frontBuffer_);
+        lock.lock();
+
+        senderResult_ = ok;
+        if (!ok) {
+            senderError_ = sendError_;
+        }
+        transmitting_ = false;
+        senderCondition_.notify_all();
+    }
+}
+
+bool FlaschenTaschenClient::sendFullFrame() {
+    // Pixel data is already flipped in setPixel
+    if (tiledMode_) {
+        DirtyRect frame;
+        frame.width = width_;
+        frame.height = height_;
+        if (!sendRect(frame)) {
+            hasSentFrame_ = false;
+            return false;
+        }
+    } else if (!sendPacket(header_.data(), headerSize_, txFrame_, txFrameSize_)) {
+        hasSentFrame_ = false;
+        return false;
+    } else if (deltaMode_) {
+        memcpy(sentBuffer_.data(), txFrame_, txFrameSize_);
+    }
+
+    if (deltaMode_) {
+        hasSentFrame_ = true;
+        sendsSinceKeyframe_ = 0;
+    }
+    return true;
+}
+
+bool FlaschenTaschenClient::sendDelta() {
+    if (!hasSentFrame_ || ++sendsSinceKeyframe_ >= keyframeInterval_) {
+        return sendFullFrame();
+    }
+
+    findDirtyRects();
+    if (dirtyRects_.empty()) {
+        return true;  // Nothing changed
+    }
+
+    int dirtyArea = 0;
+    for (const auto& rect : dirtyRects_) {
+        dirtyArea += rect.width * rect.height;
+    }
+    if (dirtyArea > deltaThreshold_ * width_ * height_) {
+        return sendFullFrame();
+    }
+
+    for (const auto& rect : dirtyRects_) {
+        if (!sendRect(rect)) {
+            hasSentFrame_ = false;  // Server state unknown, resync next time
+            return false;
+        }
+    }
+    return true;
+}
+
+void FlaschenTaschenClient::findDirtyRects() {
+    // Consecutive changed rows form one band; its box spans the changed columns
+    dirtyRects_.clear();
+
+    const size_t stride = static_cast<size_t>(width_) * 3;
+    DirtyRect band;
+    bool inBand = false;
+
+    for (int y = 0; y < height_; ++y) {
+        const uint8_t* current = txFrame_ + y * stride;
+        const uint8_t* previous = sentBuffer_.data() + y * stride;
+
+        if (memcmp(current, previous, stride) == 0) {
+            if (inBand) {
+                dirtyRects_.push_back(band);
+                inBand = false;
+            }
+            continue;
+        }
+
+        int first = 0;
+        while (memcmp(current + first * 3, previous + first * 3, 3) == 0) {
+            ++first;
+        }
+        int last = width_ - 1;
+        while (memcmp(current + last * 3, previous + last * 3, 3) == 0) {
+            --last;
+        }
+
+        if (!inBand) {
+            band.x = first;
+            band.y = y;
+            band.width = last - first + 1;
+            band.height = 1;
+            inBand = true;
+        } else {
+            int right = (std::max)(band.x + band.width, last + 1);
+            band.x = (std::min)(band.x, first);
+            band.width = right - band.x;
+            band.height = y - band.y + 1;
+        }
+    }
+
+    if (inBand) {
+        dirtyRects_.push_back(band);
+    }
+}
+
+bool FlaschenTaschenClient::sendRect(const DirtyRect& rect) {
+    const size_t stride = static_cast<size_t>(width_) * 3;
+    const size_t rowBytes = static_cast<size_t>(rect.width) * 3;
+    const size_t start = rect.y * stride + rect.x * 3;
+
+    // Full-width bands are contiguous in the frame buffer, others are gathered
+    const uint8_t* pixels = txFrame_ + start;
+    if (rect.width != width_) {
+        for (int row = 0; row < rect.height; ++row) {
+            memcpy(rectBuffer_.data() + row * rowBytes, txFrame_ + start + row * stride, rowBytes);
+        }
+        pixels = rectBuffer_.data();
+    }
+
+    // Tiled: as many whole rows per packet as fit the payload limit (at
+    // least one row, so very wide displays still fragment)
+    int stripRows = rect.height;
+    if (tiledMode_) {
+        size_t budget = maxPacketSize_ > kMaxHeaderSize ? maxPacketSize_ - kMaxHeaderSize : 0;
+        stripRows = (std::max)(1, (std::min)(rect.height, static_cast<int>(budget / rowBytes)));
+    }
+
+    pending_.clear();
+    for (int row = 0; row < rect.height; row += stripRows) {
+        const int rows = (std::min)(stripRows, rect.height - row);
+
+        PendingPacket packet;
+        int length = snprintf(packet.header.data(), packet.header.size(), "P6\n%d %d\n#FT: %d %d %d\n255\n",
+                              rect.width, rows,
+                              offsetX_ + rect.x, offsetY_ + rect.y + row, layer_);
+        if (length <= 0 || length >= static_cast<int>(packet.header.size())) {
+            sendError_ = "Failed to format packet header";
+            return false;
+        }
+        packet.headerSize = static_cast<size_t>(length);
+        packet.pixels = pixels + row * rowBytes;
+        packet.pixelBytes = rowBytes * rows;
+        pending_.push_back(packet);
+    }
+
+    if (!flushPackets()) {
         return false;
     }
 
-    std::string packet = buildPPMPacket();
+    if (deltaMode_) {
+        for (int row = 0; row < rect.height; ++row) {
+            memcpy(sentBuffer_.data() + start + row * stride, txFrame_ + start + row * stride, rowBytes);
+        }
+    }
+    return true;
+}
+
+bool FlaschenTaschenClient::flushPackets() {
+#if defined(__linux__)
+    // One syscall for the whole batch of strips
+    if (batchSend_ && pending_.size() > 1 && !nullSink_) {
+        const size_t count = pending_.size();
+        iovecs_.resize(count * 2);
+        messages_.resize(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            iovec* buffers = &iovecs_[i * 2];
+            buffers[0].iov_base = pending_[i].header.data();
+            buffers[0].iov_len = pending_[i].headerSize;
+            buffers[1].iov_base = const_cast<uint8_t*>(pending_[i].pixels);
+            buffers[1].iov_len = pending_[i].pixelBytes;
+
+            mmsghdr& message = messages_[i];
+            memset(&message, 0, sizeof(message));
+            message.msg_hdr.msg_name = &serverAddr_;
+            message.msg_hdr.msg_namelen = sizeof(serverAddr_);
+            message.msg_hdr.msg_iov = buffers;
+            message.msg_hdr.msg_iovlen = 2;
+        }
+
+        size_t sent = 0;
+        while (sent < count) {
+            int result = sendmmsg(socket_, &messages_[sent], static_cast<unsigned>(count - sent), 0);
+            if (result <= 0) {
+                wouldBlock_ = result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                sendError_ = "Failed to send packet batch";
+                return false;
+            }
+            for (int i = 0; i < result; ++i) {
+                bytesSent_ += messages_[sent + i].msg_len;
+            }
+            sent += static_cast<size_t>(result);
+        }
+        return true;
+    }
+#endif
+
+    for (const auto& packet : pending_) {
+        if (!sendPacket(packet.header.data(), packet.headerSize, packet.pixels, packet.pixelBytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FlaschenTaschenClient::sendPacket(const char* header, size_t headerSize,
+                                       const uint8_t* pixels, size_t pixelBytes) {
+    if (nullSink_) {
+        bytesSent_ += headerSize + pixelBytes;
+        return true;
+    }
 
 #ifdef _WIN32
-    int result = sendto(socket_,
-                        packet.c_str(),
-                        static_cast<int>(packet.size()),
-                        0,
-                        reinterpret_cast<sockaddr*>(&serverAddr_),
-                        sizeof(serverAddr_));
+    WSABUF buffers[2];
+    buffers[0].buf = const_cast<char*>(header);
+    buffers[0].len = static_cast<ULONG>(headerSize);
+    buffers[1].buf = reinterpret_cast<char*>(const_cast<uint8_t*>(pixels));
+    buffers[1].len = static_cast<ULONG>(pixelBytes);
+
+    DWORD sent = 0;
+    int result = WSASendTo(socket_, buffers, 2, &sent, 0,
+                           reinterpret_cast<sockaddr*>(&serverAddr_),
+                           sizeof(serverAddr_), nullptr, nullptr);
 
     if (result == SOCKET_ERROR) {
-        lastError_ = "Failed to send packet: " + std::to_string(WSAGetLastError());
+        const int error = WSAGetLastError();
+        wouldBlock_ = error == WSAEWOULDBLOCK;
+        sendError_ = "Failed to send packet: " + std::to_string(error);
         return false;
     }
+    bytesSent_ += sent;
 #else
-    ssize_t result = sendto(socket_,
-                            packet.c_str(),
-                            packet.size(),
-                            0,
-                            reinterpret_cast<sockaddr*>(&serverAddr_),
-                            sizeof(serverAddr_));
+    iovec buffers[2];
+    buffers[0].iov_base = const_cast<char*>(header);
+    buffers[0].iov_len = headerSize;
+    buffers[1].iov_base = const_cast<uint8_t*>(pixels);
+    buffers[1].iov_len = pixelBytes;
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_name = &serverAddr_;
+    message.msg_namelen = sizeof(serverAddr_);
+    message.msg_iov = buffers;
+    message.msg_iovlen = 2;
+
+    ssize_t result = sendmsg(socket_, &message, 0);
 
     if (result < 0) {
-        lastError_ = "Failed to send packet";
+        wouldBlock_ = errno == EAGAIN || errno == EWOULDBLOCK;
+        sendError_ = "Failed to send packet";
         return false;
     }
+    bytesSent_ += static_cast<uint64_t>(result);
 #endif
 
     return true;
@@ -4,8 +4,14 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
 #ifdef _WIN32
@@ -14,6 +20,7 @@
     #pragma comment(lib, "ws2_32.lib")
 #else
     #include <sys/socket.h>
+    #include <sys/uio.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
     #include <unistd.h>
@@ -21,6 +28,9 @@
 
 namespace FlaschenTaschen {
 
+namespace FrameKernels { struct Table; }
+class FrameCapture;
+
 //------------------------------------------------------------------------
 // Color - RGB color for pixel operations
 //------------------------------------------------------------------------
@@ -66,7 +76,7 @@ public:
     void setLayer(int z);
 
     // Set horizontal flip (for mirrored displays)
-    void setFlipHorizontal(bool flip) { flipHorizontal_ = flip; }
+    void setFlipHorizontal(bool flip);
     bool getFlipHorizontal() const { return flipHorizontal_; }
 
     // Clear the frame buffer
@@ -75,6 +85,23 @@ public:
     // Set a single pixel
     void setPixel(int x, int y, const Color& color);
 
+    // Bulk drawing, clipped to the display. Coordinates are logical (like
+    // setPixel); the horizontal flip is applied once per span.
+    void fillRect(int x, int y, int width, int height, const Color& color);
+    void fillColumn(int x, const Color& color) { fillRect(x, 0, 1, height_, color); }
+
+    // Copy count RGB pixels (left to right) into row y starting at x
+    void blitRow(int x, int y, const uint8_t* rgb, int count);
+
+    // Copy row 0 into every other row (frames that only vary across x)
+    void repeatFirstRow();
+
+    // Raw access to one row of the frame buffer (nullptr if y is out of
+    // range). Rows are in display order: with flip enabled, logical x is
+    // at width - 1 - x. Each row is getStride() bytes of RGB.
+    uint8_t* getRow(int y);
+    size_t getStride() const { return static_cast<size_t>(width_) * 3; }
+
     // Get frame buffer dimensions
     int getWidth() const { return width_; }
     int getHeight() const { return height_; }
@@ -82,9 +109,64 @@ public:
     // Get pixel at position
     Color getPixel(int x, int y) const;
 
-    // Send the current frame to the server
+    // Send the current frame to the server (no allocation or copy: the
+    // cached header and the frame buffer go out as one gathered datagram)
     bool send();
 
+    // Delta mode: send only the regions that changed since the last frame,
+    // each as its own offset packet. Falls back to a full frame when the
+    // changed area exceeds the threshold, and every keyframeInterval sends
+    // so a lost packet can't leave stale pixels for long.
+    void setDeltaMode(bool enabled);
+    bool getDeltaMode() const { return deltaMode_; }
+    void setDeltaThreshold(float fraction) { deltaThreshold_ = fraction; }
+    void setKeyframeInterval(int frames) { keyframeInterval_ = frames; }
+
+    // Tiled mode: split frames and regions into horizontal strips that each
+    // fit one UDP payload, so no packet is IP-fragmented. On Linux the strips
+    // of one region go out in a single sendmmsg() when batching is on.
+    static constexpr size_t kDefaultMaxPacketSize = 1472;   // 1500 MTU - IP/UDP headers
+    void setTiledMode(bool enabled) { tiledMode_ = enabled; }
+    bool getTiledMode() const { return tiledMode_; }
+    void setMaxPacketSize(size_t bytes) { maxPacketSize_ = bytes; }
+    void setBatchSend(bool enabled) { batchSend_ = enabled; }
+
+    // Async send: frames are drawn into a back buffer and send() queues it
+    // for a sender thread, which transmits while the next frame is
+    // rendered. After send() the drawing buffer holds an older frame, so
+    // callers must redraw the whole frame each time.
+    void setAsyncSend(bool enabled);
+    bool getAsyncSend() const { return asyncSend_; }
+
+    // Non-blocking mode: the socket never blocks the caller. SO_SNDBUF is
+    // enlarged; a frame the socket buffer can't take is dropped and the
+    // next one goes out whole. With async send, send() never waits either:
+    // a frame still queued is stale and is replaced by the newest one.
+    static constexpr int kNonBlockingSendBuffer = 1 << 20;
+    void setNonBlocking(bool enabled);
+    bool getNonBlocking() const { return nonBlocking_; }
+
+    // Since connect: frames dropped (replaced in the queue or refused by a
+    // full socket buffer), and async frames queued while the previous one
+    // was still being transmitted
+    int getDroppedFrames() const { return droppedFrames_; }
+    int getLateFrames() const { return lateFrames_; }
+
+    // Force the next send to be a full frame
+    void invalidate();
+
+    // Null sink (benchmarks): send() runs the whole packet path but counts
+    // the datagrams instead of handing them to a socket; no connect needed
+    void setNullSink(bool enabled) { nullSink_ = enabled; }
+    bool getNullSink() const { return nullSink_; }
+
+    // Payload bytes sent since connect (headers included)
+    uint64_t getBytesSent() const { return bytesSent_; }
+
+    // Tee every frame send() is given, as it goes to the server, into
+    // capture (not owned; nullptr = off). Opened for this display size.
+    void setCapture(FrameCapture* capture) { capture_ = capture; }
+
     // Get last error message
     const std::string& getLastError() const { return lastError_; }
 
@@ -95,12 +177,78 @@ private:
     int offsetY_ = 0;
     int layer_ = 0;
     bool flipHorizontal_ = true;
+    const FrameKernels::Table* kernels_ = nullptr;  // For this size and flip
+
+    std::vector<uint8_t> frameBuffer_;  // RGB data (drawn into)
+    std::vector<uint8_t> queuedBuffer_; // Waiting for the sender (async send)
+    std::vector<uint8_t> frontBuffer_;  // Being transmitted (async send)
+
+    // Frame the send path reads from: frameBuffer_, or frontBuffer_ on the sender
+    const uint8_t* txFrame_ = nullptr;
+    size_t txFrameSize_ = 0;
+    std::string sendError_;     // Written by whichever thread transmits
+
+    // Preformatted PPM header, rebuilt when size/offset/layer change
+    static constexpr size_t kMaxHeaderSize = 64;
+    std::array<char, kMaxHeaderSize> header_{};
+    size_t headerSize_ = 0;
+
+    // Delta transmission
+    struct DirtyRect {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
 
-    std::vector<uint8_t> frameBuffer_;  // RGB data
+    bool deltaMode_ = false;
+    float deltaThreshold_ = 0.5f;       // Fraction of the frame area
+    int keyframeInterval_ = 120;        // Sends between forced full frames
+    int sendsSinceKeyframe_ = 0;
+    bool hasSentFrame_ = false;
+    std::vector<uint8_t> sentBuffer_;   // What the server currently shows
+    std::vector<uint8_t> rectBuffer_;   // Staging for partial-width rects
+    std::vector<DirtyRect> dirtyRects_;
+    std::atomic<uint64_t> bytesSent_{0};
+
+    // Tiled transmission
+    struct PendingPacket {
+        std::array<char, kMaxHeaderSize> header;
+        size_t headerSize = 0;
+        const uint8_t* pixels = nullptr;
+        size_t pixelBytes = 0;
+    };
+
+    bool tiledMode_ = false;
+    bool batchSend_ = true;
+    size_t maxPacketSize_ = kDefaultMaxPacketSize;
+    std::vector<PendingPacket> pending_;
+#if defined(__linux__)
+    std::vector<iovec> iovecs_;
+    std::vector<mmsghdr> messages_;
+#endif
 
     bool isConnected_ = false;
+    bool nullSink_ = false;
+    FrameCapture* capture_ = nullptr;
+    bool nonBlocking_ = false;
+    bool wouldBlock_ = false;       // Last send failed only because the socket buffer was full
+    std::atomic<int> droppedFrames_{0};
+    std::atomic<int> lateFrames_{0};
     std::string lastError_;
 
+    // Sender thread (async send)
+    bool asyncSend_ = false;
+    bool senderRunning_ = false;
+    std::thread senderThread_;
+    std::mutex senderMutex_;
+    std::condition_variable senderCondition_;
+    bool frameQueued_ = false;      // Queued buffer holds a frame
+    bool transmitting_ = false;     // Front buffer is on its way out
+    bool senderStop_ = false;
+    bool senderResult_ = true;      // Outcome of the last async frame
+    std::string senderError_;
+
 #ifdef _WIN32
     SOCKET socket_ = INVALID_SOCKET;
     sockaddr_in serverAddr_;
@@ -111,7 +259,22 @@ private:
 #endif
 
     void resizeBuffer();
-    std::string buildPPMPacket() const;
+    void applySocketMode();
+    void rebuildHeader();
+    bool transmit(const std::vector<uint8_t>& frame);
+    void startSender();
+    void stopSender();
+    void waitForSender();
+    void runSender();
+    bool sendFullFrame();
+    bool sendDelta();
+    void findDirtyRects();
+    bool sendRect(const DirtyRect& rect);
+    bool flushPackets();
+
+    // Send header + pixels as one UDP datagram (scatter/gather)
+    bool sendPacket(const char* header, size_t headerSize,
+                    const uint8_t* pixels, size_t pixelBytes);
 };
 
 //------------------------------------------------------------------------
@@ -0,0 +1,241 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "FrameCapture.h"
+#include "EffectFrameCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace FlaschenTaschen {
+
+namespace {
+
+int64_t captureClockMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+FrameCapture::~FrameCapture() {
+    close();
+}
+
+//------------------------------------------------------------------------
+bool FrameCapture::open(const std::string& path, int width, int height, int offsetX, int offsetY, int layer) {
+    close();
+    if (width <= 0 || height <= 0) {
+        lastError_ = "Capture needs a display size";
+        return false;
+    }
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        lastError_ = "Cannot create capture file: " + path;
+        return false;
+    }
+
+    CaptureHeader header{};
+    header.magic = CaptureHeader::kMagic;
+    header.version = CaptureHeader::kVersion;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.offsetX = offsetX;
+    header.offsetY = offsetY;
+    header.layer = layer;
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+        lastError_ = "Cannot write capture file: " + path;
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+
+    // Every buffer is sized here, so push() and the writer never allocate
+    frameBytes_ = static_cast<size_t>(width) * height * 3;
+    for (Slot& slot : slots_) {
+        slot.pixels.assign(frameBytes_, 0);
+    }
+    current_.pixels.assign(frameBytes_, 0);
+    previous_.assign(frameBytes_, 0);
+    runs_.clear();
+    runs_.reserve(frameBytes_ + frameBytes_ / 64 + 64);
+
+    head_ = 0;
+    count_ = 0;
+    stop_ = false;
+    failed_ = false;
+    framesWritten_ = 0;
+    droppedFrames_ = 0;
+    bytesWritten_ = sizeof(header);
+    lastError_.clear();
+    startMicros_ = captureClockMicros();
+    writer_ = std::thread(&FrameCapture::run, this);
+    return true;
+}
+
+//------------------------------------------------------------------------
+void FrameCapture::close() {
+    if (!file_) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    if (std::fclose(file_) != 0 && lastError_.empty()) {
+        lastError_ = "Capture file could not be completed";
+    }
+    file_ = nullptr;
+}
+
+//------------------------------------------------------------------------
+void FrameCapture::push(const uint8_t* frame, size_t bytes) {
+    if (!file_ || bytes != frameBytes_) {
+        return;
+    }
+    const int64_t timeMicros = captureClockMicros() - startMicros_;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (failed_ || count_ == kQueueFrames) {
+            ++droppedFrames_;
+            return;
+        }
+        Slot& slot = slots_[(head_ + count_) % kQueueFrames];
+        std::memcpy(slot.pixels.data(), frame, bytes);
+        slot.timeMicros = timeMicros;
+        ++count_;
+    }
+    condition_.notify_one();
+}
+
+//------------------------------------------------------------------------
+void FrameCapture::run() {
+    for (;;) {
+        {
+            // Take the oldest frame by swapping buffers, so push() can
+            // refill its slot while this one is coded
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return count_ > 0 || stop_; });
+            if (count_ == 0) {
+                break;      // Stopped and drained
+            }
+            Slot& slot = slots_[head_];
+            current_.pixels.swap(slot.pixels);
+            current_.timeMicros = slot.timeMicros;
+            head_ = (head_ + 1) % kQueueFrames;
+            --count_;
+        }
+
+        if (!writeFrame(current_)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            failed_ = true;
+            droppedFrames_ += static_cast<int>(count_);
+            count_ = 0;
+        }
+    }
+    std::fflush(file_);
+}
+
+//------------------------------------------------------------------------
+bool FrameCapture::writeFrame(const Slot& slot) {
+    if (failed_) {
+        return false;
+    }
+
+    runs_.clear();
+    EffectFrameCache::encodeFrame(previous_.data(), slot.pixels.data(), frameBytes_ / 3, runs_);
+
+    CaptureRecord record{};
+    record.timeMicros = slot.timeMicros;
+    record.runBytes = static_cast<uint32_t>(runs_.size());
+    if (std::fwrite(&record, sizeof(record), 1, file_) != 1 ||
+        (!runs_.empty() && std::fwrite(runs_.data(), 1, runs_.size(), file_) != runs_.size())) {
+        lastError_ = "Capture write failed (disk full?)";
+        return false;
+    }
+
+    std::memcpy(previous_.data(), slot.pixels.data(), frameBytes_);
+    ++framesWritten_;
+    bytesWritten_ += sizeof(record) + runs_.size();
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool FrameCaptureReader::open(const std::string& path) {
+    frame_.clear();
+    if (!file_.open(path)) {
+        lastError_ = file_.getLastError();
+        return false;
+    }
+    if (file_.getSize() < sizeof(CaptureHeader)) {
+        lastError_ = "Not a capture file: " + path;
+        return false;
+    }
+    std::memcpy(&header_, file_.getData(), sizeof(header_));
+    if (header_.magic != CaptureHeader::kMagic) {
+        lastError_ = "Not a capture file: " + path;
+        return false;
+    }
+    if (header_.version != CaptureHeader::kVersion) {
+        lastError_ = "Unsupported capture version " + std::to_string(header_.version);
+        return false;
+    }
+    if (header_.width == 0 || header_.height == 0 || header_.width > 65535 || header_.height > 65535) {
+        lastError_ = "Capture has an invalid frame size";
+        return false;
+    }
+
+    frame_.resize(static_cast<size_t>(header_.width) * header_.height * 3);
+    rewind();
+    return true;
+}
+
+//------------------------------------------------------------------------
+void FrameCaptureReader::rewind() {
+    std::fill(frame_.begin(), frame_.end(), 0);
+    position_ = sizeof(CaptureHeader);
+    timeMicros_ = 0;
+    frameIndex_ = -1;
+}
+
+//------------------------------------------------------------------------
+bool FrameCaptureReader::next() {
+    if (frame_.empty()) {
+        return false;
+    }
+
+    // A record cut off by a crash ends the capture
+    const size_t size = file_.getSize();
+    CaptureRecord record;
+    if (size - position_ < sizeof(record)) {
+        return false;
+    }
+    std::memcpy(&record, file_.getData() + position_, sizeof(record));
+    if (size - position_ - sizeof(record) < record.runBytes) {
+        return false;
+    }
+
+    const uint8_t* runs = file_.getData() + position_ + sizeof(record);
+    if (!EffectFrameCache::decodeRuns(runs, record.runBytes, frame_.data(), frame_.size() / 3)) {
+        lastError_ = "Corrupt capture record at frame " + std::to_string(frameIndex_ + 1);
+        return false;
+    }
+    position_ += sizeof(record) + record.runBytes;
+    timeMicros_ = record.timeMicros;
+    ++frameIndex_;
+    return true;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "MappingBinary.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// Capture (.ftcap) layout
+// One header, then one record per sent frame: its time since the capture
+// started and the runs (EffectFrameCache::encodeFrame()) that turn the
+// previous frame (black before the first) into it. Frames are packed RGB
+// rows in display order, exactly as they went to the server. All fields
+// are little-endian; a capture cut short ends at its last whole record.
+//------------------------------------------------------------------------
+struct CaptureHeader {
+    static constexpr uint32_t kMagic = 0x50435446;  // "FTCP"
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    int32_t offsetX;
+    int32_t offsetY;
+    int32_t layer;
+    uint32_t reserved;
+};
+
+struct CaptureRecord {
+    int64_t timeMicros;
+    uint32_t runBytes;          // Run data following the record
+    uint32_t reserved;
+};
+
+//------------------------------------------------------------------------
+// FrameCapture - appends frames to a capture file on a writer thread
+// push() copies the frame into one of kQueueFrames preallocated slots
+// and returns; the writer delta-codes and writes it. When the disk falls
+// behind, frames are dropped rather than ever holding up the caller (the
+// next frame written is coded against the last one written, so nothing
+// is corrupted, only missing).
+//------------------------------------------------------------------------
+class FrameCapture {
+public:
+    static constexpr size_t kQueueFrames = 8;
+
+    FrameCapture() = default;
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Create path (replacing it) for width x height frames at the given
+    // server offset and layer, and start the writer
+    bool open(const std::string& path, int width, int height, int offsetX, int offsetY, int layer);
+
+    // Write what is still queued, stop the writer and close the file
+    void close();
+
+    bool isOpen() const { return file_ != nullptr; }
+
+    // Queue a frame (width * height RGB) stamped with the current time;
+    // frames of another size are ignored
+    void push(const uint8_t* frame, size_t bytes);
+
+    int getFramesWritten() const { return framesWritten_; }
+    int getDroppedFrames() const { return droppedFrames_; }
+    uint64_t getBytesWritten() const { return bytesWritten_; }
+
+    // Why open() failed, or the write error that ended the capture
+    // (valid after close())
+    const std::string& getLastError() const { return lastError_; }
+
+private:
+    struct Slot {
+        std::vector<uint8_t> pixels;
+        int64_t timeMicros = 0;
+    };
+
+    void run();
+    bool writeFrame(const Slot& slot);
+
+    std::FILE* file_ = nullptr;
+    size_t frameBytes_ = 0;
+    int64_t startMicros_ = 0;
+
+    // Queue, guarded by mutex_
+    std::array<Slot, kQueueFrames> slots_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    bool stop_ = false;
+    bool failed_ = false;           // A write failed; later frames are dropped
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::thread writer_;
+
+    // Writer thread only
+    Slot current_;
+    std::vector<uint8_t> previous_;
+    std::vector<uint8_t> runs_;
+
+    std::atomic<int> framesWritten_{0};
+    std::atomic<int> droppedFrames_{0};
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::string lastError_;
+};
+
+//------------------------------------------------------------------------
+// FrameCaptureReader - plays a capture file back frame by frame
+// The file is memory-mapped; next() applies one record's runs to the
+// current frame.
+//------------------------------------------------------------------------
+class FrameCaptureReader {
+public:
+    bool open(const std::string& path);
+
+    const CaptureHeader& getHeader() const { return header_; }
+    int getWidth() const { return static_cast<int>(header_.width); }
+    int getHeight() const { return static_cast<int>(header_.height); }
+
+    // Advance to the next frame; false at the end (or on a corrupt
+    // record, with getLastError() set)
+    bool next();
+
+    // Back to before the first frame
+    void rewind();
+
+    // The current frame (width * height RGB, display order) and its time
+    const uint8_t* getFrame() const { return frame_.data(); }
+    int64_t getTimeMicros() const { return timeMicros_; }
+    int getFrameIndex() const { return frameIndex_; }
+
+    const std::string& getLastError() const { return lastError_; }
+
+private:
+    MappedFile file_;
+    CaptureHeader header_{};
+    size_t position_ = 0;
+    std::vector<uint8_t> frame_;
+    int64_t timeMicros_ = 0;
+    int frameIndex_ = -1;
+    std::string lastError_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,141 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "FrameKernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace FlaschenTaschen {
+namespace FrameKernels {
+
+namespace {
+
+//------------------------------------------------------------------------
+// Generic paths: sizes known only at run time
+//------------------------------------------------------------------------
+void storeRowPlain(uint8_t* dst, const uint8_t* rgb, int width) {
+    std::memcpy(dst, rgb, static_cast<size_t>(width) * 3);
+}
+
+void storeRowFlipped(uint8_t* dst, const uint8_t* rgb, int width) {
+    uint8_t* out = dst + static_cast<size_t>(width - 1) * 3;
+    for (int i = 0; i < width; ++i, rgb += 3, out -= 3) {
+        out[0] = rgb[0];
+        out[1] = rgb[1];
+        out[2] = rgb[2];
+    }
+}
+
+void fillFrameGeneric(uint8_t* frame, const Color& color, int width, int height) {
+    fillPixels(frame, static_cast<size_t>(width) * height, color);
+}
+
+void repeatFirstRowGeneric(uint8_t* frame, int width, int height) {
+    const size_t stride = static_cast<size_t>(width) * 3;
+    for (int y = 1; y < height; ++y) {
+        std::memcpy(frame + y * stride, frame, stride);
+    }
+}
+
+//------------------------------------------------------------------------
+// Fixed geometry paths: every count below is a compile-time constant
+//------------------------------------------------------------------------
+template<int Width, int Height, bool Flip>
+struct Fixed {
+    static constexpr size_t kStride = static_cast<size_t>(Width) * 3;
+
+    static void storeRow(uint8_t* dst, const uint8_t* rgb, int) {
+        if (!Flip) {
+            std::memcpy(dst, rgb, kStride);
+            return;
+        }
+        for (int i = 0; i < Width; ++i) {
+            const int out = (Width - 1 - i) * 3;
+            dst[out] = rgb[i * 3];
+            dst[out + 1] = rgb[i * 3 + 1];
+            dst[out + 2] = rgb[i * 3 + 2];
+        }
+    }
+
+    static void fill(uint8_t* frame, const Color& color, int, int) {
+        if (color.r == color.g && color.g == color.b) {
+            std::memset(frame, color.r, kStride * Height);
+            return;
+        }
+        for (int i = 0; i < Width; ++i) {
+            frame[i * 3] = color.r;
+            frame[i * 3 + 1] = color.g;
+            frame[i * 3 + 2] = color.b;
+        }
+        repeatFirstRow(frame, Width, Height);
+    }
+
+    static void repeatFirstRow(uint8_t* frame, int, int) {
+        for (int y = 1; y < Height; ++y) {
+            std::memcpy(frame + y * kStride, frame, kStride);
+        }
+    }
+
+    static constexpr Table kTable = {true, &storeRow, &fill, &repeatFirstRow};
+};
+
+template<int Width, int Height, bool Flip>
+constexpr Table Fixed<Width, Height, Flip>::kTable;
+
+struct Geometry {
+    int width;
+    int height;
+    const Table* plain;
+    const Table* flipped;
+};
+
+// Registered geometries
+const Geometry kFixedGeometries[] = {
+    {45, 35, &Fixed<45, 35, false>::kTable, &Fixed<45, 35, true>::kTable},      // DisplayConfig default
+    {64, 32, &Fixed<64, 32, false>::kTable, &Fixed<64, 32, true>::kTable},      // Common LED panel
+    {128, 64, &Fixed<128, 64, false>::kTable, &Fixed<128, 64, true>::kTable},   // FlaschenTaschenClient default
+};
+
+const Table kGenericPlain = {false, &storeRowPlain, &fillFrameGeneric, &repeatFirstRowGeneric};
+const Table kGenericFlipped = {false, &storeRowFlipped, &fillFrameGeneric, &repeatFirstRowGeneric};
+
+} // namespace
+
+//------------------------------------------------------------------------
+const Table& select(int width, int height, bool flip) {
+    for (const Geometry& geometry : kFixedGeometries) {
+        if (geometry.width == width && geometry.height == height) {
+            return flip ? *geometry.flipped : *geometry.plain;
+        }
+    }
+    return flip ? kGenericFlipped : kGenericPlain;
+}
+
+//------------------------------------------------------------------------
+void fillPixels(uint8_t* dst, size_t count, const Color& color) {
+    if (count == 0) {
+        return;
+    }
+    if (color.r == color.g && color.g == color.b) {
+        std::memset(dst, color.r, count * 3);
+        return;
+    }
+
+    // One pixel, then double the filled part
+    dst[0] = color.r;
+    dst[1] = color.g;
+    dst[2] = color.b;
+    const size_t total = count * 3;
+    size_t filled = 3;
+    while (filled < total) {
+        size_t chunk = (std::min)(filled, total - filled);
+        std::memcpy(dst + filled, dst, chunk);
+        filled += chunk;
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FrameKernels
+} // namespace FlaschenTaschen
@@ -0,0 +1,48 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "FlaschenTaschenClient.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// FrameKernels - whole-row and whole-frame paths for one display geometry
+// FlaschenTaschenClient picks a table once, when its size or flip
+// changes. The registered geometries (the DisplayConfig and client
+// defaults, plus 64x32 panels) get versions compiled for their exact
+// width, height and flip, so row lengths and copy sizes are constants the
+// compiler unrolls and vectorizes. Other sizes use the generic versions;
+// both produce the same bytes. Rows are packed RGB, stride width * 3.
+//------------------------------------------------------------------------
+namespace FrameKernels {
+
+    struct Table {
+        bool specialized = false;   // Compiled for this geometry
+
+        // Store a full logical row (width pixels, left to right) into a
+        // display row, mirrored if the display is flipped
+        void (*storeRow)(uint8_t* dst, const uint8_t* rgb, int width);
+
+        // Fill a whole frame with one color
+        void (*fill)(uint8_t* frame, const Color& color, int width, int height);
+
+        // Copy row 0 into every other row
+        void (*repeatFirstRow)(uint8_t* frame, int width, int height);
+    };
+
+    // Table for a geometry (specialized if registered, else generic)
+    const Table& select(int width, int height, bool flip);
+
+    // dst[0..count) = color (any span of a row or frame)
+    void fillPixels(uint8_t* dst, size_t count, const Color& color);
+
+} // namespace FrameKernels
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,70 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// FrameLimiter - paces a display's frames to its frame rate
+// Callers mark the frame dirty whenever something changes; beginFrame()
+// says when a frame may go out, at most fps times per second. Changes
+// between two send slots are coalesced into one frame drawn from the
+// latest state, so superseded updates are never rendered or sent.
+// Not thread-safe: use from the thread that draws and sends.
+//------------------------------------------------------------------------
+class FrameLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FrameLimiter(int fps = 60) { setFps(fps); }
+
+    void setFps(int fps) {
+        period_ = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / (std::max)(1, fps)));
+    }
+
+    // Something changed; calls before the next frame coalesce
+    void markDirty() {
+        if (dirty_) {
+            ++coalesced_;
+        }
+        dirty_ = true;
+    }
+    bool isDirty() const { return dirty_; }
+
+    // True if a dirty frame may be sent now; claims the slot, the caller
+    // then draws and sends the frame
+    bool beginFrame(Clock::time_point now = Clock::now()) {
+        if (!dirty_ || now < nextSlot_) {
+            return false;
+        }
+        dirty_ = false;
+
+        // Keep the cadence while busy; after an idle gap, restart from now
+        nextSlot_ += period_;
+        if (nextSlot_ <= now) {
+            nextSlot_ = now + period_;
+        }
+        return true;
+    }
+
+    // Earliest time the next frame may go out
+    Clock::time_point getNextSlot() const { return nextSlot_; }
+
+    // Updates merged into a later frame
+    int getCoalesced() const { return coalesced_; }
+
+private:
+    Clock::duration period_{};
+    Clock::time_point nextSlot_{};
+    bool dirty_ = false;
+    int coalesced_ = 0;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
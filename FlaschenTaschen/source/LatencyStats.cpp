@@ -0,0 +1,145 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "LatencyStats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// LatencyHistogram
+//------------------------------------------------------------------------
+int LatencyHistogram::bucketFor(uint64_t micros) {
+    // 0-3 us exactly, then the octave plus the next two bits
+    if (micros < 4) {
+        return static_cast<int>(micros);
+    }
+    int msb = 0;
+    for (uint64_t v = micros; v > 1; v >>= 1) {
+        ++msb;
+    }
+    const int sub = static_cast<int>((micros >> (msb - 2)) & 3);
+    return (std::min)(kBucketCount - 1, 4 + (msb - 2) * 4 + sub);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < 4) {
+        return static_cast<uint64_t>(bucket);
+    }
+    const int msb = (bucket - 4) / 4 + 2;
+    const int sub = (bucket - 4) % 4;
+    return ((static_cast<uint64_t>(5 + sub)) << (msb - 2)) - 1;
+}
+
+void LatencyHistogram::record(int64_t micros) {
+    const uint64_t value = micros > 0 ? static_cast<uint64_t>(micros) : 0;
+    buckets_[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+
+    const uint32_t clamped = static_cast<uint32_t>((std::min)(value, static_cast<uint64_t>(UINT32_MAX)));
+    uint32_t previous = max_.load(std::memory_order_relaxed);
+    while (clamped > previous && !max_.compare_exchange_weak(previous, clamped, std::memory_order_relaxed)) {
+    }
+}
+
+LatencySummary LatencyHistogram::summarize() const {
+    // Counts are read one by one while writers may still be adding
+    std::array<uint32_t, kBucketCount> counts;
+    uint64_t total = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    LatencySummary summary;
+    summary.count = static_cast<uint32_t>(total);
+    summary.maxMicros = max_.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return summary;
+    }
+
+    const uint64_t p50Rank = (total + 1) / 2;
+    const uint64_t p99Rank = (total * 99 + 99) / 100;
+    uint64_t seen = 0;
+    bool haveP50 = false;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += counts[i];
+        const uint32_t bound = static_cast<uint32_t>(
+            (std::min)(bucketUpperBound(i), static_cast<uint64_t>(summary.maxMicros)));
+        if (!haveP50 && seen >= p50Rank) {
+            summary.p50Micros = bound;
+            haveP50 = true;
+        }
+        if (seen >= p99Rank) {
+            summary.p99Micros = bound;
+            break;
+        }
+    }
+    return summary;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    max_.store(0, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------
+// LatencyStats
+//------------------------------------------------------------------------
+int64_t LatencyStats::nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+LatencyReport LatencyStats::getReport() const {
+    LatencyReport report;
+    for (int i = 0; i < LatencyReport::kStageCount; ++i) {
+        report.stages[i] = histograms_[i].summarize();
+    }
+    return report;
+}
+
+void LatencyStats::reset() {
+    for (auto& histogram : histograms_) {
+        histogram.reset();
+    }
+}
+
+const char* LatencyStats::stageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::EventOffset: return "event offset";
+        case LatencyStage::RenderQueue: return "render queue";
+        case LatencyStage::Speak: return "espeak";
+        case LatencyStage::F0: return "f0 (dio/harvest)";
+        case LatencyStage::Spectrum: return "cheaptrick";
+        case LatencyStage::Aperiodicity: return "d4c";
+        case LatencyStage::Synthesis: return "synthesis";
+        case LatencyStage::Resample: return "resample";
+        case LatencyStage::FirstSample: return "note -> first sample";
+        case LatencyStage::DisplayRender: return "display render";
+        case LatencyStage::DisplaySend: return "udp send";
+        case LatencyStage::Count: break;
+    }
+    return "?";
+}
+
+std::string LatencyStats::formatReport(const LatencyReport& report) {
+    std::string text = "stage                    count     p50 ms    p99 ms    max ms\n";
+    char line[128];
+    for (int i = 0; i < LatencyReport::kStageCount; ++i) {
+        const LatencySummary& s = report.stages[i];
+        std::snprintf(line, sizeof(line), "%-22s %7u %10.2f %9.2f %9.2f\n",
+                      stageName(static_cast<LatencyStage>(i)), s.count,
+                      s.p50Micros / 1000.0, s.p99Micros / 1000.0, s.maxMicros / 1000.0);
+        text += line;
+    }
+    return text;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
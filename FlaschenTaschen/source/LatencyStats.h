@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// LatencyStage - measured steps of the note -> sound/light pipeline
+//------------------------------------------------------------------------
+enum class LatencyStage : int {
+    EventOffset = 0,    // Event position inside its audio block
+    RenderQueue,        // Note-on until the render worker picks it up
+    Speak,              // eSpeak synthesis
+    F0,                 // DIO/Harvest
+    Spectrum,           // CheapTrick
+    Aperiodicity,       // D4C
+    Synthesis,          // World/PSOLA resynthesis
+    Resample,           // TTS rate -> output rate
+    FirstSample,        // Note-on until its first sample is mixed
+    DisplayRender,      // Frame render on the display thread
+    DisplaySend,        // UDP send of a frame
+    Count
+};
+
+//------------------------------------------------------------------------
+// LatencySummary - one stage's distribution (plain data, sent via IMessage)
+//------------------------------------------------------------------------
+struct LatencySummary {
+    uint32_t count = 0;
+    uint32_t p50Micros = 0;
+    uint32_t p99Micros = 0;
+    uint32_t maxMicros = 0;
+};
+
+struct LatencyReport {
+    static constexpr int kStageCount = static_cast<int>(LatencyStage::Count);
+    LatencySummary stages[kStageCount];
+};
+
+//------------------------------------------------------------------------
+// LatencyHistogram - log-scale histogram of durations in microseconds
+// Four buckets per octave (about 19% resolution). record() is
+// a couple of relaxed atomic adds, so any thread may call it, including
+// the audio thread. Percentiles report the bucket's upper bound.
+//------------------------------------------------------------------------
+class LatencyHistogram {
+public:
+    static constexpr int kBucketCount = 136;
+
+    void record(int64_t micros);
+    LatencySummary summarize() const;
+    void reset();
+
+    static int bucketFor(uint64_t micros);
+    static uint64_t bucketUpperBound(int bucket);
+
+private:
+    std::array<std::atomic<uint32_t>, kBucketCount> buckets_{};
+    std::atomic<uint32_t> max_{0};
+};
+
+//------------------------------------------------------------------------
+// LatencyStats - one histogram per pipeline stage
+//------------------------------------------------------------------------
+class LatencyStats {
+public:
+    // Monotonic high-resolution clock (realtime-safe)
+    static int64_t nowMicros();
+
+    void record(LatencyStage stage, int64_t micros) {
+        histograms_[static_cast<int>(stage)].record(micros);
+    }
+    void recordSince(LatencyStage stage, int64_t startMicros) { record(stage, nowMicros() - startMicros); }
+
+    LatencyReport getReport() const;
+    void reset();
+
+    static const char* stageName(LatencyStage stage);
+
+    // Text table of a report, one stage per line
+    static std::string formatReport(const LatencyReport& report);
+
+private:
+    std::array<LatencyHistogram, LatencyReport::kStageCount> histograms_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,133 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// LockFreeQueue - fixed-capacity single-producer/single-consumer queue
+// push() and pop() never block and never allocate, so either side may
+// be the realtime audio thread. Capacity must be a power of two.
+//------------------------------------------------------------------------
+template <typename T, size_t Capacity>
+class LockFreeQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "LockFreeQueue capacity must be a power of two");
+
+public:
+    LockFreeQueue() = default;
+
+    // Producer side: returns false if the queue is full
+    bool push(const T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        if (head - tail >= Capacity) {
+            return false;
+        }
+        slots_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: returns false if the queue is empty
+    bool pop(T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        if (tail == head) {
+            return false;
+        }
+        item = slots_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    std::array<T, Capacity> slots_{};
+    alignas(64) std::atomic<size_t> head_{0};  // Written by producer
+    alignas(64) std::atomic<size_t> tail_{0};  // Written by consumer
+};
+
+//------------------------------------------------------------------------
+// MpscQueue - fixed-capacity multi-producer/single-consumer queue
+// Each slot carries a sequence number, so producers claim slots with one
+// compare-exchange and never block or allocate (safe on the audio
+// thread). Capacity must be a power of two.
+//------------------------------------------------------------------------
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "MpscQueue capacity must be a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Any producer: returns false if the queue is full
+    bool push(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[head & (Capacity - 1)];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const ptrdiff_t diff = static_cast<ptrdiff_t>(sequence - head);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                head = head_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->item = item;
+        slot->sequence.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: returns false if the queue is empty
+    bool pop(T& item) {
+        Slot& slot = slots_[tail_ & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1) {
+            return false;
+        }
+        item = slot.item;
+        slot.sequence.store(tail_ + Capacity, std::memory_order_release);
+        ++tail_;
+        return true;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    std::array<Slot, Capacity> slots_;
+    alignas(64) std::atomic<size_t> head_{0};  // Claimed by producers
+    alignas(64) size_t tail_ = 0;              // Consumer only
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,152 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "MappingBinary.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace FlaschenTaschen {
+
+static_assert(sizeof(BinaryMappingSyllable) == 12, "ftmap syllable record layout changed");
+static_assert(sizeof(BinaryMappingEffect) == 48, "ftmap effect record layout changed");
+static_assert(sizeof(BinaryMappingPanel) == 40, "ftmap panel record layout changed");
+static_assert(sizeof(BinaryMappingHeader) % 4 == 0, "ftmap header must keep records aligned");
+
+//------------------------------------------------------------------------
+MappedFile::~MappedFile() {
+    close();
+}
+
+//------------------------------------------------------------------------
+bool MappedFile::open(const std::string& path, bool allowAppend) {
+    close();
+
+#ifdef _WIN32
+    const DWORD share = FILE_SHARE_READ | (allowAppend ? FILE_SHARE_WRITE : 0);
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, share, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        lastError_ = "Failed to open file: " + path;
+        return false;
+    }
+    file_ = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        lastError_ = "Failed to get file size: " + path;
+        close();
+        return false;
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ == 0) {
+        return true;  // Nothing to map
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        lastError_ = "Failed to map file: " + path;
+        close();
+        return false;
+    }
+    mapping_ = mapping;
+
+    data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    (void)allowAppend;      // POSIX doesn't lock open files
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        lastError_ = "Failed to open file: " + path;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd_, &info) != 0) {
+        lastError_ = "Failed to get file size: " + path;
+        close();
+        return false;
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ == 0) {
+        return true;
+    }
+
+    void* view = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    data_ = view == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(view);
+#endif
+
+    if (!data_) {
+        lastError_ = "Failed to map file: " + path;
+        close();
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(static_cast<HANDLE>(mapping_));
+    if (file_) CloseHandle(static_cast<HANDLE>(file_));
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+//------------------------------------------------------------------------
+void MappedFile::prefetch(size_t offset, size_t size) const {
+#ifdef _WIN32
+    (void)offset;
+    (void)size;
+#else
+    if (!data_ || offset >= size_) {
+        return;
+    }
+    // madvise wants a page-aligned start
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t begin = offset / page * page;
+    const size_t end = (std::min)(size_, offset + size);
+    madvise(const_cast<uint8_t*>(data_) + begin, end - begin, MADV_WILLNEED);
+#endif
+}
+
+//------------------------------------------------------------------------
+void MappedFile::release(size_t offset, size_t size) const {
+#ifdef _WIN32
+    (void)offset;
+    (void)size;
+#else
+    if (!data_ || offset >= size_) {
+        return;
+    }
+    // Whole pages inside the range only, never a neighbour's
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t begin = (offset + page - 1) / page * page;
+    const size_t end = (std::min)(size_, offset + size) / page * page;
+    if (begin < end) {
+        madvise(const_cast<uint8_t*>(data_) + begin, end - begin, MADV_DONTNEED);
+    }
+#endif
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,184 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// Compiled mapping (.ftmap) layout
+// One header, then syllable and effect records, then a string table of
+// NUL-terminated UTF-8 (identical strings are stored once). Strings are
+// referenced by table offset. All fields are little-endian and
+// naturally aligned, so a mapped file is read in place. Bump kVersion
+// whenever a record changes.
+//------------------------------------------------------------------------
+struct BinaryMappingSyllable {
+    int32_t id;
+    uint32_t text;              // String offset
+    int32_t bus;
+};
+
+struct BinaryMappingEffect {
+    static constexpr uint8_t kPrecompute = 1 << 0;
+
+    int32_t id;
+    uint32_t name;              // String offset
+    uint32_t file;              // String offset (clip)
+    int32_t type;               // EffectType
+    int32_t rampDirection;      // RampDirection
+    int32_t durationMs;
+    int32_t periodMs;
+    int32_t speed;
+    uint32_t seed;
+    float intensity;
+    uint8_t color1[3];
+    uint8_t color2[3];
+    uint8_t flags;              // kPrecompute
+    uint8_t reserved;
+};
+
+struct BinaryMappingPanel {
+    uint32_t ip;                // String offset
+    int32_t port;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+    int32_t offsetX;
+    int32_t offsetY;
+    int32_t layer;
+    int32_t fps;
+};
+
+struct BinaryMappingHeader {
+    static constexpr uint32_t kMagic = 0x424D5446;  // "FTMB"
+    static constexpr uint32_t kVersion = 19;
+    static constexpr int kNoteCount = 128;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fileSize;
+
+    uint32_t syllableCount;
+    uint32_t syllableOffset;    // BinaryMappingSyllable[syllableCount]
+    uint32_t effectCount;
+    uint32_t effectOffset;      // BinaryMappingEffect[effectCount]
+    uint32_t panelCount;
+    uint32_t panelOffset;       // BinaryMappingPanel[panelCount]
+    uint32_t stringsSize;
+    uint32_t stringsOffset;
+
+    // MIDI note -> record index (-1 = unmapped)
+    int16_t noteSyllables[kNoteCount];
+    int16_t noteEffects[kNoteCount];
+
+    // Server
+    uint32_t serverIp;
+    int32_t serverPort;
+
+    // Display
+    int32_t displayWidth;
+    int32_t displayHeight;
+    int32_t displayOffsetX;
+    int32_t displayOffsetY;
+    int32_t displayLayer;
+    int32_t displayMtu;
+    int32_t displayFps;
+    int32_t displayScrollSpeed;
+    int32_t displayEffectCacheMb;
+    int32_t displaySpectrumBands;
+    uint32_t displayCapture;    // String
+    uint8_t displayFlags;       // kDisplay* bits
+    uint8_t displayColor[3];
+    uint8_t displayBgColor[3];
+    uint8_t reserved0;
+
+    // TTS
+    uint32_t ttsVoice;
+    int32_t ttsRate;
+    int32_t ttsPitch;
+    int32_t ttsVolume;
+    int32_t ttsVoices;
+    uint32_t ttsVoiceSteal;
+    uint32_t ttsEngine;
+    uint32_t ttsAnalysis;
+    int32_t ttsAnalysisBudgetMs;
+    int32_t ttsAnalysisDims;
+    int32_t ttsPrebake;
+    int32_t ttsPrebakeOctaves;
+    int32_t ttsLookAheadMs;
+    int32_t ttsVelocityDepth;
+    int32_t ttsReleaseMs;
+    uint32_t ttsCache;
+    uint32_t ttsOutputs;
+
+    // Audio / MIDI device selection
+    uint32_t audioBackend;
+    uint32_t audioDeviceId;
+    uint32_t audioDeviceName;
+    int32_t audioBufferMs;
+    uint32_t audioMode;
+    int32_t midiDeviceId;
+    uint32_t midiDeviceName;
+    int32_t midiDeviceCount;
+    int32_t midiDeviceIds[8];   // MidiConfig::kMaxDevices
+    uint32_t networkBindAddress;
+    int32_t networkOscPort;
+    int32_t networkRtpMidiPort;
+
+    static constexpr uint8_t kDisplayFlipHorizontal = 1 << 0;
+    static constexpr uint8_t kDisplayMirrorGlyph = 1 << 1;
+    static constexpr uint8_t kDisplayDeltaFrames = 1 << 2;
+    static constexpr uint8_t kDisplayTiled = 1 << 3;
+    static constexpr uint8_t kDisplayLightOrgan = 1 << 4;
+    static constexpr uint8_t kDisplayLightOrganRainbow = 1 << 5;
+    static constexpr uint8_t kDisplayNonBlocking = 1 << 6;
+    static constexpr uint8_t kDisplayShared = 1 << 7;
+};
+
+//------------------------------------------------------------------------
+// MappedFile - read-only memory mapping of a whole file
+//------------------------------------------------------------------------
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // allowAppend: others may keep writing to the file (the mapping stays
+    // a snapshot of the size at open)
+    bool open(const std::string& path, bool allowAppend = false);
+    void close();
+
+    const uint8_t* getData() const { return data_; }
+    size_t getSize() const { return size_; }
+    const std::string& getLastError() const { return lastError_; }
+
+    // Paging hints for [offset, offset + size): start reading it in, or
+    // drop its pages (they are read again if touched). No-ops on Windows.
+    void prefetch(size_t offset, size_t size) const;
+    void release(size_t offset, size_t size) const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::string lastError_;
+
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
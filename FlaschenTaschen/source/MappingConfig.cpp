@@ -3,10 +3,13 @@
 //------------------------------------------------------------------------
 
 #include "MappingConfig.h"
+#include "MappingBinary.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <cstring>
+#include <unordered_map>
 
 namespace FlaschenTaschen {
 
@@ -60,6 +63,13 @@ std::vector<std::string> findAllTags(const std::string& xml, const std::string&
     size_t pos = 0;
 
     while ((pos = xml.find(openTag, pos)) != std::string::npos) {
+        // Whole names only: <Display must not match <Displays
+        const size_t nameEnd = pos + openTag.size();
+        if (nameEnd < xml.size() && std::string(" \t\r\n/>").find(xml[nameEnd]) == std::string::npos) {
+            pos = nameEnd;
+            continue;
+        }
+
         size_t endPos = xml.find(">", pos);
         if (endPos == std::string::npos) break;
 
@@ -89,22 +99,435 @@ std::string findTagContent(const std::string& xml, const std::string& tagName) {
     return xml.substr(contentStart, endPos - contentStart);
 }
 
+// Note tables store int16_t record indices
+constexpr size_t kMaxTableIndex = 32767;
+
+//------------------------------------------------------------------------
+// Compiled mapping helpers
+//------------------------------------------------------------------------
+
+// Interned string table; offset 0 is the empty string
+class StringTableWriter {
+public:
+    StringTableWriter() : data_(1, '\0') {}
+
+    uint32_t add(const std::string& str) {
+        if (str.empty()) return 0;
+        auto it = offsets_.find(str);
+        if (it != offsets_.end()) return it->second;
+        uint32_t offset = static_cast<uint32_t>(data_.size());
+        data_.append(str.c_str(), str.size() + 1);
+        offsets_.emplace(str, offset);
+        return offset;
+    }
+
+    const std::string& getData() const { return data_; }
+
+private:
+    std::string data_;
+    std::map<std::string, uint32_t> offsets_;
+};
+
+// Bounds-checked view of a compiled mapping's string table
+class StringTableReader {
+public:
+    StringTableReader(const char* data, uint32_t size) : data_(data), size_(size) {}
+
+    bool get(uint32_t offset, std::string& out) const {
+        if (offset >= size_) return false;
+        out.assign(data_ + offset);  // Table is NUL-terminated (checked on load)
+        return true;
+    }
+
+private:
+    const char* data_;
+    uint32_t size_;
+};
+
+bool isRangeInFile(uint32_t offset, uint64_t bytes, size_t fileSize) {
+    return offset % 4 == 0 && static_cast<uint64_t>(offset) + bytes <= fileSize;
+}
+
+uint32_t alignTo4(size_t size) {
+    return static_cast<uint32_t>((size + 3) & ~static_cast<size_t>(3));
+}
+
+bool isAbsolutePath(const std::string& path) {
+    if (!path.empty() && (path[0] == '/' || path[0] == '\\')) {
+        return true;
+    }
+    return path.size() > 1 && path[1] == ':';     // Windows drive letter
+}
+
 } // anonymous namespace
 
 //------------------------------------------------------------------------
 // MappingConfig Implementation
 //------------------------------------------------------------------------
 bool MappingConfig::loadFromFile(const std::string& filePath) {
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        lastError_ = "Failed to open file: " + filePath;
+    MappedFile file;
+    if (!file.open(filePath)) {
+        lastError_ = file.getLastError();
         isValid_ = false;
         return false;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return loadFromString(buffer.str());
+    uint32_t magic = 0;
+    if (file.getSize() >= sizeof(magic)) {
+        std::memcpy(&magic, file.getData(), sizeof(magic));
+    }
+    const bool loaded = magic == BinaryMappingHeader::kMagic
+        ? loadFromBinary(file.getData(), file.getSize())
+        : loadFromString(std::string(reinterpret_cast<const char*>(file.getData()), file.getSize()));
+    if (!loaded) {
+        return false;
+    }
+
+    // Clip and capture files next to the mapping
+    const size_t slash = filePath.find_last_of("/\\");
+    if (slash != std::string::npos) {
+        for (Effect& e : effects_) {
+            if (!e.file.empty() && !isAbsolutePath(e.file)) {
+                e.file = filePath.substr(0, slash + 1) + e.file;
+            }
+        }
+        std::string& capture = displayConfig_.capture;
+        if (!capture.empty() && !isAbsolutePath(capture)) {
+            capture = filePath.substr(0, slash + 1) + capture;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool MappingConfig::loadFromBinary(const void* data, size_t size) {
+    syllables_.clear();
+    noteMappings_.clear();
+    effects_.clear();
+    effectMappings_.clear();
+    displayPanels_.clear();
+    noteSyllables_.fill(-1);
+    noteEffects_.fill(-1);
+    isValid_ = false;
+
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    const auto* header = static_cast<const BinaryMappingHeader*>(data);
+    if (!data || size < sizeof(BinaryMappingHeader) || header->magic != BinaryMappingHeader::kMagic) {
+        lastError_ = "Not a compiled mapping file";
+        return false;
+    }
+    if (header->version != BinaryMappingHeader::kVersion) {
+        lastError_ = "Unsupported compiled mapping version " + std::to_string(header->version) +
+                     " (recompile the XML)";
+        return false;
+    }
+    if (header->fileSize != size ||
+        !isRangeInFile(header->syllableOffset, uint64_t(header->syllableCount) * sizeof(BinaryMappingSyllable), size) ||
+        !isRangeInFile(header->effectOffset, uint64_t(header->effectCount) * sizeof(BinaryMappingEffect), size) ||
+        !isRangeInFile(header->panelOffset, uint64_t(header->panelCount) * sizeof(BinaryMappingPanel), size) ||
+        !isRangeInFile(header->stringsOffset, header->stringsSize, size) ||
+        header->stringsSize == 0 || bytes[header->stringsOffset + header->stringsSize - 1] != '\0') {
+        lastError_ = "Compiled mapping file is truncated or corrupt";
+        return false;
+    }
+
+    const StringTableReader strings(reinterpret_cast<const char*>(bytes + header->stringsOffset), header->stringsSize);
+    bool stringsOk = true;
+
+    // Settings
+    stringsOk &= strings.get(header->serverIp, serverConfig_.ip);
+    serverConfig_.port = header->serverPort;
+
+    displayConfig_.width = header->displayWidth;
+    displayConfig_.height = header->displayHeight;
+    displayConfig_.offsetX = header->displayOffsetX;
+    displayConfig_.offsetY = header->displayOffsetY;
+    displayConfig_.layer = header->displayLayer;
+    displayConfig_.mtu = header->displayMtu;
+    displayConfig_.fps = header->displayFps;
+    displayConfig_.scrollSpeed = header->displayScrollSpeed;
+    displayConfig_.effectCacheMb = header->displayEffectCacheMb;
+    displayConfig_.spectrumBands = header->displaySpectrumBands;
+    stringsOk &= strings.get(header->displayCapture, displayConfig_.capture);
+    displayConfig_.flipHorizontal = (header->displayFlags & BinaryMappingHeader::kDisplayFlipHorizontal) != 0;
+    displayConfig_.mirrorGlyph = (header->displayFlags & BinaryMappingHeader::kDisplayMirrorGlyph) != 0;
+    displayConfig_.deltaFrames = (header->displayFlags & BinaryMappingHeader::kDisplayDeltaFrames) != 0;
+    displayConfig_.tiled = (header->displayFlags & BinaryMappingHeader::kDisplayTiled) != 0;
+    displayConfig_.lightOrgan = (header->displayFlags & BinaryMappingHeader::kDisplayLightOrgan) != 0;
+    displayConfig_.lightOrganRainbow = (header->displayFlags & BinaryMappingHeader::kDisplayLightOrganRainbow) != 0;
+    displayConfig_.nonBlocking = (header->displayFlags & BinaryMappingHeader::kDisplayNonBlocking) != 0;
+    displayConfig_.shared = (header->displayFlags & BinaryMappingHeader::kDisplayShared) != 0;
+    displayConfig_.colorR = header->displayColor[0];
+    displayConfig_.colorG = header->displayColor[1];
+    displayConfig_.colorB = header->displayColor[2];
+    displayConfig_.bgColorR = header->displayBgColor[0];
+    displayConfig_.bgColorG = header->displayBgColor[1];
+    displayConfig_.bgColorB = header->displayBgColor[2];
+
+    stringsOk &= strings.get(header->ttsVoice, ttsConfig_.voice);
+    ttsConfig_.rate = header->ttsRate;
+    ttsConfig_.pitch = header->ttsPitch;
+    ttsConfig_.volume = header->ttsVolume;
+    ttsConfig_.voices = header->ttsVoices;
+    stringsOk &= strings.get(header->ttsVoiceSteal, ttsConfig_.voiceSteal);
+    stringsOk &= strings.get(header->ttsEngine, ttsConfig_.engine);
+    stringsOk &= strings.get(header->ttsAnalysis, ttsConfig_.analysis);
+    ttsConfig_.analysisBudgetMs = header->ttsAnalysisBudgetMs;
+    ttsConfig_.analysisDims = header->ttsAnalysisDims;
+    ttsConfig_.prebake = header->ttsPrebake != 0;
+    ttsConfig_.prebakeOctaves = header->ttsPrebakeOctaves;
+    ttsConfig_.lookAheadMs = header->ttsLookAheadMs;
+    ttsConfig_.velocityDepth = header->ttsVelocityDepth;
+    ttsConfig_.releaseMs = header->ttsReleaseMs;
+    stringsOk &= strings.get(header->ttsCache, ttsConfig_.cache);
+    stringsOk &= strings.get(header->ttsOutputs, ttsConfig_.outputs);
+
+    stringsOk &= strings.get(header->audioDeviceId, audioConfig_.deviceId);
+    stringsOk &= strings.get(header->audioDeviceName, audioConfig_.deviceName);
+    audioConfig_.bufferMs = header->audioBufferMs;
+    stringsOk &= strings.get(header->audioBackend, audioConfig_.backend);
+    stringsOk &= strings.get(header->audioMode, audioConfig_.mode);
+    midiConfig_.deviceId = header->midiDeviceId;
+    stringsOk &= strings.get(header->midiDeviceName, midiConfig_.deviceName);
+    const int midiDeviceCount = (std::max)(0, (std::min)(MidiConfig::kMaxDevices, header->midiDeviceCount));
+    midiConfig_.deviceIds.assign(header->midiDeviceIds, header->midiDeviceIds + midiDeviceCount);
+    stringsOk &= strings.get(header->networkBindAddress, networkConfig_.bindAddress);
+    networkConfig_.oscPort = header->networkOscPort;
+    networkConfig_.rtpMidiPort = header->networkRtpMidiPort;
+
+    // Records
+    const auto* syllables = reinterpret_cast<const BinaryMappingSyllable*>(bytes + header->syllableOffset);
+    syllables_.resize(header->syllableCount);
+    for (uint32_t i = 0; i < header->syllableCount; ++i) {
+        syllables_[i].id = syllables[i].id;
+        syllables_[i].bus = syllables[i].bus;
+        stringsOk &= strings.get(syllables[i].text, syllables_[i].text);
+    }
+
+    const auto* effects = reinterpret_cast<const BinaryMappingEffect*>(bytes + header->effectOffset);
+    effects_.resize(header->effectCount);
+    for (uint32_t i = 0; i < header->effectCount; ++i) {
+        const BinaryMappingEffect& record = effects[i];
+        Effect& e = effects_[i];
+        e.id = record.id;
+        stringsOk &= strings.get(record.name, e.name);
+        stringsOk &= strings.get(record.file, e.file);
+        e.type = static_cast<EffectType>(record.type);
+        e.rampDirection = static_cast<RampDirection>(record.rampDirection);
+        e.durationMs = record.durationMs;
+        e.periodMs = record.periodMs;
+        e.speed = record.speed;
+        e.seed = record.seed;
+        e.precompute = (record.flags & BinaryMappingEffect::kPrecompute) != 0;
+        e.intensity = record.intensity;
+        e.color1R = record.color1[0];
+        e.color1G = record.color1[1];
+        e.color1B = record.color1[2];
+        e.color2R = record.color2[0];
+        e.color2G = record.color2[1];
+        e.color2B = record.color2[2];
+    }
+
+    const auto* panels = reinterpret_cast<const BinaryMappingPanel*>(bytes + header->panelOffset);
+    displayPanels_.resize(header->panelCount);
+    for (uint32_t i = 0; i < header->panelCount; ++i) {
+        const BinaryMappingPanel& record = panels[i];
+        DisplayPanel& panel = displayPanels_[i];
+        stringsOk &= strings.get(record.ip, panel.ip);
+        panel.port = record.port;
+        panel.x = record.x;
+        panel.y = record.y;
+        panel.width = record.width;
+        panel.height = record.height;
+        panel.offsetX = record.offsetX;
+        panel.offsetY = record.offsetY;
+        panel.layer = record.layer;
+        panel.fps = record.fps;
+    }
+
+    // Note tables hold record indices
+    for (int note = 0; note < BinaryMappingHeader::kNoteCount; ++note) {
+        int syllable = header->noteSyllables[note];
+        if (syllable >= 0 && static_cast<uint32_t>(syllable) < header->syllableCount) {
+            noteMappings_.push_back({note, syllables_[syllable].id});
+        }
+        int effect = header->noteEffects[note];
+        if (effect >= 0 && static_cast<uint32_t>(effect) < header->effectCount) {
+            effectMappings_.push_back({note, effects_[effect].id});
+        }
+    }
+
+    if (!stringsOk) {
+        lastError_ = "Compiled mapping file has a bad string reference";
+        return false;
+    }
+
+    sanitize();
+    buildNoteToSyllableMap();
+    buildNoteToEffectMap();
+    isValid_ = true;
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool MappingConfig::saveToBinary(const std::string& filePath) const {
+    if (!isValid_) {
+        lastError_ = "No valid configuration to save";
+        return false;
+    }
+
+    StringTableWriter strings;
+    BinaryMappingHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = BinaryMappingHeader::kMagic;
+    header.version = BinaryMappingHeader::kVersion;
+
+    header.serverIp = strings.add(serverConfig_.ip);
+    header.serverPort = serverConfig_.port;
+
+    header.displayWidth = displayConfig_.width;
+    header.displayHeight = displayConfig_.height;
+    header.displayOffsetX = displayConfig_.offsetX;
+    header.displayOffsetY = displayConfig_.offsetY;
+    header.displayLayer = displayConfig_.layer;
+    header.displayMtu = displayConfig_.mtu;
+    header.displayFps = displayConfig_.fps;
+    header.displayScrollSpeed = displayConfig_.scrollSpeed;
+    header.displayEffectCacheMb = displayConfig_.effectCacheMb;
+    header.displaySpectrumBands = displayConfig_.spectrumBands;
+    header.displayCapture = strings.add(displayConfig_.capture);
+    header.displayFlags = (displayConfig_.flipHorizontal ? BinaryMappingHeader::kDisplayFlipHorizontal : 0) |
+                          (displayConfig_.mirrorGlyph ? BinaryMappingHeader::kDisplayMirrorGlyph : 0) |
+                          (displayConfig_.deltaFrames ? BinaryMappingHeader::kDisplayDeltaFrames : 0) |
+                          (displayConfig_.tiled ? BinaryMappingHeader::kDisplayTiled : 0) |
+                          (displayConfig_.lightOrgan ? BinaryMappingHeader::kDisplayLightOrgan : 0) |
+                          (displayConfig_.lightOrganRainbow ? BinaryMappingHeader::kDisplayLightOrganRainbow : 0) |
+                          (displayConfig_.nonBlocking ? BinaryMappingHeader::kDisplayNonBlocking : 0) |
+                          (displayConfig_.shared ? BinaryMappingHeader::kDisplayShared : 0);
+    header.displayColor[0] = displayConfig_.colorR;
+    header.displayColor[1] = displayConfig_.colorG;
+    header.displayColor[2] = displayConfig_.colorB;
+    header.displayBgColor[0] = displayConfig_.bgColorR;
+    header.displayBgColor[1] = displayConfig_.bgColorG;
+    header.displayBgColor[2] = displayConfig_.bgColorB;
+
+    header.ttsVoice = strings.add(ttsConfig_.voice);
+    header.ttsRate = ttsConfig_.rate;
+    header.ttsPitch = ttsConfig_.pitch;
+    header.ttsVolume = ttsConfig_.volume;
+    header.ttsVoices = ttsConfig_.voices;
+    header.ttsVoiceSteal = strings.add(ttsConfig_.voiceSteal);
+    header.ttsEngine = strings.add(ttsConfig_.engine);
+    header.ttsAnalysis = strings.add(ttsConfig_.analysis);
+    header.ttsAnalysisBudgetMs = ttsConfig_.analysisBudgetMs;
+    header.ttsAnalysisDims = ttsConfig_.analysisDims;
+    header.ttsPrebake = ttsConfig_.prebake ? 1 : 0;
+    header.ttsPrebakeOctaves = ttsConfig_.prebakeOctaves;
+    header.ttsLookAheadMs = ttsConfig_.lookAheadMs;
+    header.ttsVelocityDepth = ttsConfig_.velocityDepth;
+    header.ttsReleaseMs = ttsConfig_.releaseMs;
+    header.ttsCache = strings.add(ttsConfig_.cache);
+    header.ttsOutputs = strings.add(ttsConfig_.outputs);
+
+    header.audioDeviceId = strings.add(audioConfig_.deviceId);
+    header.audioDeviceName = strings.add(audioConfig_.deviceName);
+    header.audioBufferMs = audioConfig_.bufferMs;
+    header.audioBackend = strings.add(audioConfig_.backend);
+    header.audioMode = strings.add(audioConfig_.mode);
+    header.midiDeviceId = midiConfig_.deviceId;
+    header.midiDeviceName = strings.add(midiConfig_.deviceName);
+    static_assert(sizeof(header.midiDeviceIds) / sizeof(header.midiDeviceIds[0]) == MidiConfig::kMaxDevices,
+                  "ftmap MIDI device table must match MidiConfig");
+    header.midiDeviceCount = static_cast<int32_t>(midiConfig_.deviceIds.size());
+    for (size_t i = 0; i < midiConfig_.deviceIds.size(); ++i) {
+        header.midiDeviceIds[i] = midiConfig_.deviceIds[i];
+    }
+    header.networkBindAddress = strings.add(networkConfig_.bindAddress);
+    header.networkOscPort = networkConfig_.oscPort;
+    header.networkRtpMidiPort = networkConfig_.rtpMidiPort;
+
+    std::vector<BinaryMappingSyllable> syllables(syllables_.size());
+    for (size_t i = 0; i < syllables_.size(); ++i) {
+        syllables[i].id = syllables_[i].id;
+        syllables[i].bus = syllables_[i].bus;
+        syllables[i].text = strings.add(syllables_[i].text);
+    }
+
+    std::vector<BinaryMappingEffect> effects(effects_.size());
+    for (size_t i = 0; i < effects_.size(); ++i) {
+        const Effect& e = effects_[i];
+        BinaryMappingEffect& record = effects[i];
+        std::memset(&record, 0, sizeof(record));
+        record.id = e.id;
+        record.name = strings.add(e.name);
+        record.file = strings.add(e.file);
+        record.type = static_cast<int32_t>(e.type);
+        record.rampDirection = static_cast<int32_t>(e.rampDirection);
+        record.durationMs = e.durationMs;
+        record.periodMs = e.periodMs;
+        record.speed = e.speed;
+        record.seed = e.seed;
+        record.flags = e.precompute ? BinaryMappingEffect::kPrecompute : 0;
+        record.intensity = e.intensity;
+        record.color1[0] = e.color1R;
+        record.color1[1] = e.color1G;
+        record.color1[2] = e.color1B;
+        record.color2[0] = e.color2R;
+        record.color2[1] = e.color2G;
+        record.color2[2] = e.color2B;
+    }
+
+    std::vector<BinaryMappingPanel> panels(displayPanels_.size());
+    for (size_t i = 0; i < displayPanels_.size(); ++i) {
+        const DisplayPanel& panel = displayPanels_[i];
+        BinaryMappingPanel& record = panels[i];
+        record.ip = strings.add(panel.ip);
+        record.port = panel.port;
+        record.x = panel.x;
+        record.y = panel.y;
+        record.width = panel.width;
+        record.height = panel.height;
+        record.offsetX = panel.offsetX;
+        record.offsetY = panel.offsetY;
+        record.layer = panel.layer;
+        record.fps = panel.fps;
+    }
+
+    static_assert(BinaryMappingHeader::kNoteCount == kNoteCount, "ftmap note tables must match MappingConfig");
+    std::memcpy(header.noteSyllables, noteSyllables_.data(), sizeof(header.noteSyllables));
+    std::memcpy(header.noteEffects, noteEffects_.data(), sizeof(header.noteEffects));
+
+    // Layout: header, syllables, effects, panels, strings (4-byte aligned)
+    const std::string& table = strings.getData();
+    header.syllableCount = static_cast<uint32_t>(syllables.size());
+    header.syllableOffset = alignTo4(sizeof(header));
+    header.effectCount = static_cast<uint32_t>(effects.size());
+    header.effectOffset = alignTo4(header.syllableOffset + syllables.size() * sizeof(BinaryMappingSyllable));
+    header.panelCount = static_cast<uint32_t>(panels.size());
+    header.panelOffset = alignTo4(header.effectOffset + effects.size() * sizeof(BinaryMappingEffect));
+    header.stringsSize = static_cast<uint32_t>(table.size());
+    header.stringsOffset = alignTo4(header.panelOffset + panels.size() * sizeof(BinaryMappingPanel));
+    header.fileSize = header.stringsOffset + header.stringsSize;
+
+    std::string image(header.fileSize, '\0');
+    std::memcpy(&image[0], &header, sizeof(header));
+    if (!syllables.empty()) {
+        std::memcpy(&image[header.syllableOffset], syllables.data(), syllables.size() * sizeof(BinaryMappingSyllable));
+    }
+    if (!effects.empty()) {
+        std::memcpy(&image[header.effectOffset], effects.data(), effects.size() * sizeof(BinaryMappingEffect));
+    }
+    if (!panels.empty()) {
+        std::memcpy(&image[header.panelOffset], panels.data(), panels.size() * sizeof(BinaryMappingPanel));
+    }
+    std::memcpy(&image[header.stringsOffset], table.data(), table.size());
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open() || !file.write(image.data(), static_cast<std::streamsize>(image.size()))) {
+        lastError_ = "Failed to write file: " + filePath;
+        return false;
+    }
+    return true;
 }
 
 bool MappingConfig::loadFromString(const std::string& xmlContent) {
@@ -112,14 +535,16 @@ bool MappingConfig::loadFromString(const std::string& xmlContent) {
     noteMappings_.clear();
     effects_.clear();
     effectMappings_.clear();
-    noteToSyllableMap_.clear();
-    noteToEffectMap_.clear();
+    displayPanels_.clear();
+    noteSyllables_.fill(-1);
+    noteEffects_.fill(-1);
     isValid_ = false;
 
     if (!parseXml(xmlContent)) {
         return false;
     }
 
+    sanitize();
     buildNoteToSyllableMap();
     buildNoteToEffectMap();
     isValid_ = true;
@@ -138,6 +563,7 @@ EffectType Effect::typeFromString(const std::string& str) {
     if (str == "strobe" || str == "Strobe") return EffectType::Strobe;
     if (str == "wave" || str == "Wave") return EffectType::Wave;
     if (str == "sparkle" || str == "Sparkle") return EffectType::Sparkle;
+    if (str == "clip" || str == "Clip") return EffectType::Clip;
     return EffectType::None;
 }
 
@@ -178,6 +604,35 @@ bool MappingConfig::parseXml(const std::string& xmlContent) {
             if (!mirrorStr.empty()) {
                 displayConfig_.mirrorGlyph = (mirrorStr != "0" && mirrorStr != "false");
             }
+            // Parse deltaFrames - default true, "0" or "false" disables it
+            std::string deltaStr = getAttribute(displayTags[0], "deltaFrames");
+            if (!deltaStr.empty()) {
+                displayConfig_.deltaFrames = (deltaStr != "0" && deltaStr != "false");
+            }
+            // Parse tiled - default false, "1" or "true" enables it
+            std::string tiledStr = getAttribute(displayTags[0], "tiled");
+            displayConfig_.tiled = (tiledStr == "1" || tiledStr == "true");
+            // Parse nonBlocking - default true, "0" or "false" disables it
+            std::string nonBlockingStr = getAttribute(displayTags[0], "nonBlocking");
+            if (!nonBlockingStr.empty()) {
+                displayConfig_.nonBlocking = (nonBlockingStr != "0" && nonBlockingStr != "false");
+            }
+            // Parse lightOrgan - default false, lightOrganRainbow - default true
+            std::string organStr = getAttribute(displayTags[0], "lightOrgan");
+            displayConfig_.lightOrgan = (organStr == "1" || organStr == "true");
+            std::string rainbowStr = getAttribute(displayTags[0], "lightOrganRainbow");
+            if (!rainbowStr.empty()) {
+                displayConfig_.lightOrganRainbow = (rainbowStr != "0" && rainbowStr != "false");
+            }
+            // Parse shared - default false, "1" or "true" enables it
+            std::string sharedStr = getAttribute(displayTags[0], "shared");
+            displayConfig_.shared = (sharedStr == "1" || sharedStr == "true");
+            displayConfig_.fps = getIntAttribute(displayTags[0], "fps", 60);
+            displayConfig_.scrollSpeed = getIntAttribute(displayTags[0], "scrollSpeed", 30);
+            displayConfig_.effectCacheMb = getIntAttribute(displayTags[0], "effectCache", 0);
+            displayConfig_.spectrumBands = getIntAttribute(displayTags[0], "spectrum", 0);
+            displayConfig_.capture = getAttribute(displayTags[0], "capture");
+            displayConfig_.mtu = getIntAttribute(displayTags[0], "mtu", 1472);
             displayConfig_.colorR = getUint8Attribute(displayTags[0], "colorR", 255);
             displayConfig_.colorG = getUint8Attribute(displayTags[0], "colorG", 255);
             displayConfig_.colorB = getUint8Attribute(displayTags[0], "colorB", 255);
@@ -186,6 +641,26 @@ bool MappingConfig::parseXml(const std::string& xmlContent) {
             displayConfig_.bgColorB = getUint8Attribute(displayTags[0], "bgColorB", 0);
         }
 
+        // Multi-panel display: one server per panel, each showing part of the canvas
+        std::string displaysSection = findTagContent(globalSection, "Displays");
+        for (const auto& tag : findAllTags(displaysSection, "Panel")) {
+            DisplayPanel panel;
+            std::string ip = getAttribute(tag, "ip");
+            if (!ip.empty()) {
+                panel.ip = ip;
+            }
+            panel.port = getIntAttribute(tag, "port", 1337);
+            panel.x = getIntAttribute(tag, "x", 0);
+            panel.y = getIntAttribute(tag, "y", 0);
+            panel.width = getIntAttribute(tag, "width", displayConfig_.width);
+            panel.height = getIntAttribute(tag, "height", displayConfig_.height);
+            panel.offsetX = getIntAttribute(tag, "offsetX", 0);
+            panel.offsetY = getIntAttribute(tag, "offsetY", 0);
+            panel.layer = getIntAttribute(tag, "layer", displayConfig_.layer);
+            panel.fps = getIntAttribute(tag, "fps", 0);
+            displayPanels_.push_back(panel);
+        }
+
         // Parse TTS config if present
         auto ttsTags = findAllTags(globalSection, "TTS");
         if (!ttsTags.empty()) {
@@ -196,22 +671,73 @@ bool MappingConfig::parseXml(const std::string& xmlContent) {
             ttsConfig_.rate = getIntAttribute(ttsTags[0], "rate", 120);
             ttsConfig_.pitch = getIntAttribute(ttsTags[0], "pitch", 50);
             ttsConfig_.volume = getIntAttribute(ttsTags[0], "volume", 100);
+            ttsConfig_.voices = getIntAttribute(ttsTags[0], "voices", 16);
+            std::string steal = getAttribute(ttsTags[0], "voiceSteal");
+            if (!steal.empty()) {
+                ttsConfig_.voiceSteal = steal;
+            }
+            std::string engine = getAttribute(ttsTags[0], "engine");
+            if (!engine.empty()) {
+                ttsConfig_.engine = engine;
+            }
+            std::string analysis = getAttribute(ttsTags[0], "analysis");
+            if (!analysis.empty()) {
+                ttsConfig_.analysis = analysis;
+            }
+            ttsConfig_.analysisBudgetMs = getIntAttribute(ttsTags[0], "analysisBudgetMs", 50);
+            ttsConfig_.analysisDims = getIntAttribute(ttsTags[0], "analysisDims", 0);
+            // Parse prebake - default false, "1" or "true" enables it
+            std::string prebakeStr = getAttribute(ttsTags[0], "prebake");
+            ttsConfig_.prebake = (prebakeStr == "1" || prebakeStr == "true");
+            ttsConfig_.prebakeOctaves = getIntAttribute(ttsTags[0], "prebakeOctaves", 0);
+            ttsConfig_.lookAheadMs = getIntAttribute(ttsTags[0], "lookAheadMs", 0);
+            ttsConfig_.velocityDepth = getIntAttribute(ttsTags[0], "velocityDepth", 100);
+            ttsConfig_.releaseMs = getIntAttribute(ttsTags[0], "releaseMs", 0);
+            ttsConfig_.cache = getAttribute(ttsTags[0], "cache");
+            std::string outputs = getAttribute(ttsTags[0], "outputs");
+            if (!outputs.empty()) {
+                ttsConfig_.outputs = outputs;
+            }
         }
 
         // Parse Audio config if present
         auto audioTags = findAllTags(globalSection, "Audio");
         if (!audioTags.empty()) {
+            audioConfig_.backend = getAttribute(audioTags[0], "backend");
             audioConfig_.deviceId = getAttribute(audioTags[0], "deviceId");
             audioConfig_.deviceName = getAttribute(audioTags[0], "deviceName");
-            audioConfig_.bufferMs = getIntAttribute(audioTags[0], "bufferMs", 20);
+            audioConfig_.bufferMs = getIntAttribute(audioTags[0], "bufferMs", 0);
+            std::string mode = getAttribute(audioTags[0], "mode");
+            if (!mode.empty()) {
+                audioConfig_.mode = mode;
+            }
         }
 
-        // Parse MIDI config if present
+        // Parse MIDI config if present; one <Midi> tag per input device
         auto midiTags = findAllTags(globalSection, "Midi");
+        midiConfig_.deviceIds.clear();
         if (!midiTags.empty()) {
             midiConfig_.deviceId = getIntAttribute(midiTags[0], "deviceId", -1);
             midiConfig_.deviceName = getAttribute(midiTags[0], "deviceName");
         }
+        for (const auto& tag : midiTags) {
+            int deviceId = getIntAttribute(tag, "deviceId", -1);
+            if (deviceId >= 0 && midiConfig_.deviceIds.size() < static_cast<size_t>(MidiConfig::kMaxDevices)) {
+                midiConfig_.deviceIds.push_back(deviceId);
+            }
+        }
+
+        // Parse network input if present
+        auto networkTags = findAllTags(globalSection, "Network");
+        networkConfig_ = NetworkConfig();
+        if (!networkTags.empty()) {
+            std::string bindAddress = getAttribute(networkTags[0], "bind");
+            if (!bindAddress.empty()) {
+                networkConfig_.bindAddress = bindAddress;
+            }
+            networkConfig_.oscPort = getIntAttribute(networkTags[0], "oscPort", 0);
+            networkConfig_.rtpMidiPort = getIntAttribute(networkTags[0], "rtpMidiPort", 0);
+        }
     }
 
     // Parse Syllables section
@@ -222,6 +748,7 @@ bool MappingConfig::parseXml(const std::string& xmlContent) {
             Syllable s;
             s.id = getIntAttribute(tag, "id", -1);
             s.text = getAttribute(tag, "text");
+            s.bus = getIntAttribute(tag, "bus", 0);
 
             if (s.id >= 0 && !s.text.empty()) {
                 syllables_.push_back(s);
@@ -265,7 +792,7 @@ bool MappingConfig::parseXml(const std::string& xmlContent) {
             e.color2B = getUint8Attribute(tag, "b2", 0);
 
             // Timing
-            e.durationMs = getIntAttribute(tag, "duration", 500);
+            e.durationMs = getIntAttribute(tag, "duration", e.type == EffectType::Clip ? 0 : 500);
             e.periodMs = getIntAttribute(tag, "period", 100);
 
             // Ramp direction
@@ -282,6 +809,10 @@ bool MappingConfig::parseXml(const std::string& xmlContent) {
                 } catch (...) {}
             }
             e.speed = getIntAttribute(tag, "speed", 50);
+            e.file = getAttribute(tag, "file");
+            e.seed = static_cast<uint32_t>(getIntAttribute(tag, "seed", 0));
+            std::string precomputeStr = getAttribute(tag, "precompute");
+            e.precompute = (precomputeStr == "1" || precomputeStr == "true");
 
             if (e.id >= 0 && e.type != EffectType::None) {
                 effects_.push_back(e);
@@ -318,28 +849,85 @@ bool MappingConfig::parseXml(const std::string& xmlContent) {
     return true;
 }
 
+// Clamp numeric settings to their supported ranges. Both loaders call this,
+// so a hand-edited or stale .ftmap gets the same limits as the XML.
+void MappingConfig::sanitize() {
+    auto clamp = [](int& value, int low, int high) { value = (std::max)(low, (std::min)(high, value)); };
+
+    clamp(displayConfig_.fps, 1, 240);
+    clamp(displayConfig_.scrollSpeed, 0, 1000);
+    clamp(displayConfig_.effectCacheMb, 0, 1024);
+    clamp(displayConfig_.spectrumBands, 0, 64);
+    clamp(displayConfig_.mtu, 128, 65507);
+
+    for (DisplayPanel& panel : displayPanels_) {
+        panel.x = (std::max)(0, panel.x);
+        panel.y = (std::max)(0, panel.y);
+        panel.width = (std::max)(1, panel.width);
+        panel.height = (std::max)(1, panel.height);
+        clamp(panel.fps, 0, 240);
+    }
+
+    clamp(ttsConfig_.voices, 1, 16);
+    ttsConfig_.analysisBudgetMs = (std::max)(1, ttsConfig_.analysisBudgetMs);
+    if (ttsConfig_.analysisDims <= 0) {
+        ttsConfig_.analysisDims = 0;
+    } else {
+        clamp(ttsConfig_.analysisDims, TTSConfig::kMinAnalysisDims, TTSConfig::kMaxAnalysisDims);
+    }
+    clamp(ttsConfig_.prebakeOctaves, 0, 3);
+    clamp(ttsConfig_.lookAheadMs, 0, TTSConfig::kMaxLookAheadMs);
+    clamp(ttsConfig_.velocityDepth, 0, 100);
+    clamp(ttsConfig_.releaseMs, 0, TTSConfig::kMaxReleaseMs);
+
+    audioConfig_.bufferMs = (std::max)(0, audioConfig_.bufferMs);
+    clamp(networkConfig_.oscPort, 0, 65535);
+    clamp(networkConfig_.rtpMidiPort, 0, 65534);
+
+    for (Syllable& syllable : syllables_) {
+        clamp(syllable.bus, 0, TTSConfig::kMaxBuses - 1);
+    }
+
+    // Enums from a compiled file are only as good as its bytes
+    for (Effect& e : effects_) {
+        if (e.type < EffectType::None || e.type > EffectType::Clip) {
+            e.type = EffectType::None;
+        }
+        if (e.rampDirection < RampDirection::Horizontal || e.rampDirection > RampDirection::Radial) {
+            e.rampDirection = RampDirection::Horizontal;
+        }
+    }
+}
+
+// Later mappings of the same note win; an id resolves to its first record
 void MappingConfig::buildNoteToSyllableMap() {
-    noteToSyllableMap_.clear();
+    noteSyllables_.fill(-1);
+    std::unordered_map<int, int16_t> indexById;
+    for (size_t i = 0; i < (std::min)(syllables_.size(), kMaxTableIndex); ++i) {
+        indexById.emplace(syllables_[i].id, static_cast<int16_t>(i));
+    }
     for (const auto& nm : noteMappings_) {
-        noteToSyllableMap_[nm.midiNote] = nm.syllableId;
+        if (!isNote(nm.midiNote)) continue;
+        auto it = indexById.find(nm.syllableId);
+        noteSyllables_[nm.midiNote] = it != indexById.end() ? it->second : -1;
     }
 }
 
 void MappingConfig::buildNoteToEffectMap() {
-    noteToEffectMap_.clear();
+    noteEffects_.fill(-1);
+    std::unordered_map<int, int16_t> indexById;
+    for (size_t i = 0; i < (std::min)(effects_.size(), kMaxTableIndex); ++i) {
+        indexById.emplace(effects_[i].id, static_cast<int16_t>(i));
+    }
     for (const auto& em : effectMappings_) {
-        noteToEffectMap_[em.midiNote] = em.effectId;
+        if (!isNote(em.midiNote)) continue;
+        auto it = indexById.find(em.effectId);
+        noteEffects_[em.midiNote] = it != indexById.end() ? it->second : -1;
     }
 }
 
 std::string MappingConfig::getSyllableForNote(int midiNote) const {
-    auto it = noteToSyllableMap_.find(midiNote);
-    if (it == noteToSyllableMap_.end()) {
-        return "";
-    }
-
-    const Syllable* s = getSyllableById(it->second);
-    return s ? s->text : "";
+    return std::string(getSyllableTextForNote(midiNote));
 }
 
 const Syllable* MappingConfig::getSyllableById(int id) const {
@@ -351,14 +939,6 @@ const Syllable* MappingConfig::getSyllableById(int id) const {
     return nullptr;
 }
 
-const Effect* MappingConfig::getEffectForNote(int midiNote) const {
-    auto it = noteToEffectMap_.find(midiNote);
-    if (it == noteToEffectMap_.end()) {
-        return nullptr;
-    }
-    return getEffectById(it->second);
-}
-
 const Effect* MappingConfig::getEffectById(int id) const {
     for (const auto& e : effects_) {
         if (e.id == id) {
@@ -368,9 +948,5 @@ const Effect* MappingConfig::getEffectById(int id) const {
     return nullptr;
 }
 
-bool MappingConfig::hasEffectForNote(int midiNote) const {
-    return noteToEffectMap_.find(midiNote) != noteToEffectMap_.end();
-}
-
 //------------------------------------------------------------------------
 } // namespace FlaschenTaschen
@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <memory>
@@ -17,6 +20,7 @@ namespace FlaschenTaschen {
 struct Syllable {
     int id;
     std::string text;
+    int bus = 0;                // Output bus with <TTS outputs="syllable"> (0 = main)
 };
 
 //------------------------------------------------------------------------
@@ -46,6 +50,18 @@ struct DisplayConfig {
     int layer = 1;  // Z-layer (0 = background)
     bool flipHorizontal = false;  // Flip entire display horizontally
     bool mirrorGlyph = true;      // Mirror each character/glyph horizontally
+    bool deltaFrames = true;      // Send only changed regions
+    bool tiled = false;           // Split frames into MTU-sized packets
+    bool nonBlocking = true;      // Drop frames instead of blocking on a full socket buffer
+    int mtu = 1472;               // Max UDP payload per packet when tiled
+    int fps = 60;                 // Display thread frame rate (plugin only)
+    bool lightOrgan = false;      // Show held keys as light organ columns (plugin only)
+    bool lightOrganRainbow = true;  // Per-key hue instead of the text color
+    bool shared = false;          // Plugin instances on one server share one sender (DisplayHub)
+    int scrollSpeed = 30;         // Pixels/s text wider than the display scrolls at (0 = clipped)
+    int effectCacheMb = 0;        // Pre-render effects into a frame cache of this size (0 = render live)
+    int spectrumBands = 0;        // Show the TTS output as this many spectrum columns (plugin only, 0 = off)
+    std::string capture;          // Record every frame sent to this .ftcap file (empty = off)
 
     // Font/color settings
     uint8_t colorR = 255;
@@ -56,6 +72,24 @@ struct DisplayConfig {
     uint8_t bgColorB = 0;
 };
 
+//------------------------------------------------------------------------
+// DisplayPanel - one server of a multi-panel display (<Displays><Panel>)
+// The panel shows the canvas rectangle x/y/width/height (canvas = the
+// <Display> size, in display order) at offsetX/offsetY/layer on its server.
+//------------------------------------------------------------------------
+struct DisplayPanel {
+    std::string ip = "127.0.0.1";
+    int port = 1337;
+    int x = 0;
+    int y = 0;
+    int width = 45;
+    int height = 35;
+    int offsetX = 0;
+    int offsetY = 0;
+    int layer = 1;
+    int fps = 0;        // Frame rate limit for this server, 0 = <Display fps>
+};
+
 //------------------------------------------------------------------------
 // TTSConfig - Text-to-speech configuration
 //------------------------------------------------------------------------
@@ -64,23 +98,80 @@ struct TTSConfig {
     int rate = 120;             // Words per minute (80-450)
     int pitch = 50;             // Pitch (0-99)
     int volume = 100;           // Volume (0-200)
+
+    // Polyphony (plugin only)
+    int voices = 16;            // Simultaneous syllables (1-16)
+    std::string voiceSteal = "oldest";  // "oldest", "quietest" or "none"
+
+    // Pitch shift engine: "world" (best quality) or "fast" (PSOLA, low latency)
+    std::string engine = "world";
+
+    // World analysis quality: "auto" (fits analysisBudgetMs), "best", "fast"
+    // or "harvest" (Harvest F0 for pre-bake)
+    std::string analysis = "auto";
+    int analysisBudgetMs = 50;  // Per-note analysis budget in auto mode
+
+    // Cached analyses keep this many mel-cepstral coefficients per frame
+    // (plus band aperiodicities) instead of full spectra (plugin only)
+    int analysisDims = 0;       // 0 = uncompressed, else kMinAnalysisDims-kMaxAnalysisDims
+    static constexpr int kMinAnalysisDims = 16;
+    static constexpr int kMaxAnalysisDims = 128;
+
+    // Pre-bake: render every mapped note at load time (plugin only)
+    bool prebake = false;
+    int prebakeOctaves = 0;     // Also bake +/- this many octave offsets (0-3)
+
+    // Look-ahead: delay playback by this much (reported to the host as
+    // latency) so renders finish before their note is heard (plugin only)
+    int lookAheadMs = 0;        // 0 = off, up to kMaxLookAheadMs
+    static constexpr int kMaxLookAheadMs = 2000;
+
+    // Voice dynamics (plugin only): how much velocity scales the syllable's
+    // level, and the fade at note-off (0 = syllables always play to the end)
+    int velocityDepth = 100;    // Percent, 0 = velocity ignored
+    int releaseMs = 0;          // Up to kMaxReleaseMs
+    static constexpr int kMaxReleaseMs = 2000;
+
+    // On-disk eSpeak output cache (plugin only): file path, "" = the user's
+    // cache directory, "off" = disabled
+    std::string cache;
+
+    // Output bus of each note (plugin only): "main", "voice" (voice n on
+    // bus n) or "syllable" (its <S bus>). Buses the host hasn't enabled
+    // fall back to the main one.
+    std::string outputs = "main";
+    static constexpr int kMaxBuses = 8;     // Main plus 7 aux buses
 };
 
 //------------------------------------------------------------------------
 // AudioConfig - Audio device configuration
 //------------------------------------------------------------------------
 struct AudioConfig {
-    std::string deviceId;       // WASAPI device ID (empty = default)
+    std::string backend;        // "wasapi", "alsa", "jack", "coreaudio" (empty = platform default)
+    std::string deviceId;       // Backend device ID (empty = default)
     std::string deviceName;     // Friendly name (for display only)
-    int bufferMs = 20;          // Buffer size in milliseconds (default 20ms)
+    int bufferMs = 0;           // Buffer/period in ms (0 = mode default: 20 ms shared, engine minimum otherwise)
+    std::string mode = "shared";  // "shared", "lowLatency" (IAudioClient3 minimum period) or "exclusive"
 };
 
 //------------------------------------------------------------------------
 // MidiConfig - MIDI input configuration
 //------------------------------------------------------------------------
 struct MidiConfig {
+    static constexpr int kMaxDevices = 8;
+
     int deviceId = -1;          // MIDI device ID (-1 = disabled)
     std::string deviceName;     // Device name (for display only)
+    std::vector<int> deviceIds; // Every input to open, one per <Midi> tag (deviceId is the first)
+};
+
+//------------------------------------------------------------------------
+// NetworkConfig - Standalone note input over UDP
+//------------------------------------------------------------------------
+struct NetworkConfig {
+    std::string bindAddress = "0.0.0.0";
+    int oscPort = 0;            // OSC messages and raw MIDI datagrams (0 = off)
+    int rtpMidiPort = 0;        // RTP-MIDI session control port, data on port + 1 (0 = off)
 };
 
 //------------------------------------------------------------------------
@@ -95,7 +186,8 @@ enum class EffectType {
     Flash,          // Quick flash then fade
     Strobe,         // Rapid on/off
     Wave,           // Horizontal wave pattern
-    Sparkle         // Random sparkling pixels
+    Sparkle,        // Random sparkling pixels
+    Clip            // Pre-converted RGB frame sequence (.ftclip file)
 };
 
 //------------------------------------------------------------------------
@@ -132,6 +224,13 @@ struct Effect {
     float intensity = 1.0f;     // 0.0 - 1.0
     int speed = 50;             // Effect speed (0-100)
 
+    // Sparkle pattern: the same seed replays the same pattern every show
+    uint32_t seed = 0;          // 0 = derived from the effect id
+    bool precompute = false;    // Build the whole schedule on first play
+
+    // Clip: frame file, relative to the mapping file (durationMs 0 = one pass)
+    std::string file;
+
     // Helper to convert effect type from string
     static EffectType typeFromString(const std::string& str);
     static RampDirection directionFromString(const std::string& str);
@@ -150,21 +249,33 @@ struct EffectMapping {
 //------------------------------------------------------------------------
 class MappingConfig {
 public:
+    static constexpr int kNoteCount = 128;
+
     MappingConfig() = default;
     ~MappingConfig() = default;
 
-    // Load configuration from XML file
+    // Load configuration from an XML or compiled (.ftmap) file; the format
+    // is detected from the content. Relative clip files are resolved
+    // against the file's directory.
     bool loadFromFile(const std::string& filePath);
 
     // Load configuration from XML string
     bool loadFromString(const std::string& xmlContent);
 
+    // Load a compiled mapping read in place from memory (e.g. a mapped file)
+    bool loadFromBinary(const void* data, size_t size);
+
+    // Write the loaded configuration as a compiled mapping
+    bool saveToBinary(const std::string& filePath) const;
+
     // Getters
     const ServerConfig& getServerConfig() const { return serverConfig_; }
     const DisplayConfig& getDisplayConfig() const { return displayConfig_; }
+    const std::vector<DisplayPanel>& getDisplayPanels() const { return displayPanels_; }  // Empty = single <Server>
     const TTSConfig& getTTSConfig() const { return ttsConfig_; }
     const AudioConfig& getAudioConfig() const { return audioConfig_; }
     const MidiConfig& getMidiConfig() const { return midiConfig_; }
+    const NetworkConfig& getNetworkConfig() const { return networkConfig_; }
     const std::vector<Syllable>& getSyllables() const { return syllables_; }
     const std::vector<NoteMapping>& getNoteMappings() const { return noteMappings_; }
     const std::vector<Effect>& getEffects() const { return effects_; }
@@ -173,17 +284,33 @@ public:
     // Get syllable text for a given MIDI note (returns empty string if not found)
     std::string getSyllableForNote(int midiNote) const;
 
+    // Constant-time note lookups for the realtime path (no allocation).
+    // Indices refer to getSyllables()/getEffects(); -1 = not mapped.
+    int getSyllableIndexForNote(int midiNote) const {
+        return isNote(midiNote) ? noteSyllables_[midiNote] : -1;
+    }
+    int getEffectIndexForNote(int midiNote) const {
+        return isNote(midiNote) ? noteEffects_[midiNote] : -1;
+    }
+    std::string_view getSyllableTextForNote(int midiNote) const {
+        const int index = getSyllableIndexForNote(midiNote);
+        return index >= 0 ? std::string_view(syllables_[index].text) : std::string_view();
+    }
+
     // Get syllable by ID
     const Syllable* getSyllableById(int id) const;
 
     // Get effect for a given MIDI note (returns nullptr if not found)
-    const Effect* getEffectForNote(int midiNote) const;
+    const Effect* getEffectForNote(int midiNote) const {
+        const int index = getEffectIndexForNote(midiNote);
+        return index >= 0 ? &effects_[index] : nullptr;
+    }
 
     // Get effect by ID
     const Effect* getEffectById(int id) const;
 
     // Check if a note triggers an effect (vs syllable)
-    bool hasEffectForNote(int midiNote) const;
+    bool hasEffectForNote(int midiNote) const { return getEffectIndexForNote(midiNote) >= 0; }
 
     // Check if configuration is valid
     bool isValid() const { return isValid_; }
@@ -194,23 +321,35 @@ public:
     // Setters for programmatic configuration
     void setServerConfig(const ServerConfig& config) { serverConfig_ = config; }
     void setDisplayConfig(const DisplayConfig& config) { displayConfig_ = config; }
+    void setDisplayPanels(const std::vector<DisplayPanel>& panels) { displayPanels_ = panels; }
 
 private:
     ServerConfig serverConfig_;
     DisplayConfig displayConfig_;
+    std::vector<DisplayPanel> displayPanels_;
     TTSConfig ttsConfig_;
     AudioConfig audioConfig_;
     MidiConfig midiConfig_;
+    NetworkConfig networkConfig_;
     std::vector<Syllable> syllables_;
     std::vector<NoteMapping> noteMappings_;
     std::vector<Effect> effects_;
     std::vector<EffectMapping> effectMappings_;
-    std::map<int, int> noteToSyllableMap_;  // MIDI note -> syllable ID
-    std::map<int, int> noteToEffectMap_;    // MIDI note -> effect ID
+    using NoteTable = std::array<int16_t, kNoteCount>;
+    NoteTable noteSyllables_ = emptyNoteTable();  // MIDI note -> index into syllables_
+    NoteTable noteEffects_ = emptyNoteTable();    // MIDI note -> index into effects_
 
     bool isValid_ = false;
-    std::string lastError_;
+    mutable std::string lastError_;
+
+    static bool isNote(int midiNote) { return midiNote >= 0 && midiNote < kNoteCount; }
+    static NoteTable emptyNoteTable() {
+        NoteTable table;
+        table.fill(-1);
+        return table;
+    }
 
+    void sanitize();
     void buildNoteToSyllableMap();
     void buildNoteToEffectMap();
     bool parseXml(const std::string& xmlContent);
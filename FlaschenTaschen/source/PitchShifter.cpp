@@ -0,0 +1,52 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "PitchShifter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+double PitchShifter::midiNoteToFrequency(int midiNote) {
+    // A4 (MIDI 69) = 440 Hz
+    return 440.0 * std::pow(2.0, (midiNote - 69) / 12.0);
+}
+
+//------------------------------------------------------------------------
+int PitchShifter::frequencyToMidiNote(double frequency) {
+    if (frequency <= 0) return 0;
+    return static_cast<int>(std::round(69.0 + 12.0 * std::log2(frequency / 440.0)));
+}
+
+//------------------------------------------------------------------------
+double PitchShifter::frequencyToRatio(double targetFreqHz) {
+    // Calculate semitone shift from middle C (261.63 Hz, MIDI 60)
+    // This gives a reasonable musical shift range
+    double middleC = 261.63;
+    double semitones = 12.0 * std::log2(targetFreqHz / middleC);
+
+    // Limit shift to +/- 36 semitones (3 octaves) to support wide range
+    // C2 (65 Hz) to C7 (2093 Hz) relative to C4 (262 Hz)
+    semitones = (std::max)(-36.0, (std::min)(36.0, semitones));
+
+    return std::pow(2.0, semitones / 12.0);
+}
+
+//------------------------------------------------------------------------
+PitchEngine PitchShifter::engineFromString(const std::string& name) {
+    if (name == "fast" || name == "psola") {
+        return PitchEngine::Fast;
+    }
+    return PitchEngine::World;
+}
+
+//------------------------------------------------------------------------
+const char* PitchShifter::engineToString(PitchEngine engine) {
+    return engine == PitchEngine::Fast ? "fast" : "world";
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
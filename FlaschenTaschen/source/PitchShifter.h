@@ -0,0 +1,51 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// PitchEngine - which pitch shifter renders notes
+//------------------------------------------------------------------------
+enum class PitchEngine {
+    World,  // World vocoder analysis/resynthesis (best quality)
+    Fast    // TD-PSOLA on the DIO F0 track (low latency)
+};
+
+//------------------------------------------------------------------------
+// PitchShifter - common interface of the pitch shift engines
+// Shifts a mono utterance by a ratio without changing its duration.
+//------------------------------------------------------------------------
+class PitchShifter {
+public:
+    virtual ~PitchShifter() = default;
+
+    // Set the sample rate of the audio passed to shift()
+    virtual void initialize(int sampleRate) = 0;
+    virtual int getSampleRate() const = 0;
+
+    // Pitch shift by ratio (1.0 = unchanged, 2.0 = octave up). Ratios
+    // within 0.001 of 1.0 return the input unchanged.
+    virtual std::vector<float> shift(const std::vector<float>& input, double ratio) = 0;
+
+    // Convert MIDI note to frequency
+    static double midiNoteToFrequency(int midiNote);
+
+    // Convert frequency to MIDI note
+    static int frequencyToMidiNote(double frequency);
+
+    // Pitch ratio that moves speech to a target frequency
+    static double frequencyToRatio(double targetFreqHz);
+
+    // "world" or "fast" (anything else selects World)
+    static PitchEngine engineFromString(const std::string& name);
+    static const char* engineToString(PitchEngine engine);
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,353 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "PixelKernels.h"
+
+#include <algorithm>
+
+// Instruction set is picked at compile time; x64 always has SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FT_PIXELS_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define FT_PIXELS_NEON 1
+#endif
+
+namespace FlaschenTaschen {
+namespace PixelKernels {
+
+namespace {
+    constexpr size_t kLanes = 4;
+
+    inline void storePixels(uint8_t* out, const int32_t* r, const int32_t* g, const int32_t* b, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i * 3] = static_cast<uint8_t>(r[i]);
+            out[i * 3 + 1] = static_cast<uint8_t>(g[i]);
+            out[i * 3 + 2] = static_cast<uint8_t>(b[i]);
+        }
+    }
+
+    // Scalar reference (also handles the tail of every row)
+    inline uint8_t lerpChannel(uint8_t a, uint8_t b, float t) {
+        return static_cast<uint8_t>(a + (b - a) * t);
+    }
+
+    void hsvPixel(uint8_t* out, float h, float s, float v) {
+        float r = 0, g = 0, b = 0;
+
+        int i = static_cast<int>(h * 6.0f);
+        float f = h * 6.0f - i;
+        float p = v * (1.0f - s);
+        float q = v * (1.0f - f * s);
+        float t = v * (1.0f - (1.0f - f) * s);
+
+        switch (i % 6) {
+            case 0: r = v; g = t; b = p; break;
+            case 1: r = q; g = v; b = p; break;
+            case 2: r = p; g = v; b = t; break;
+            case 3: r = p; g = q; b = v; break;
+            case 4: r = t; g = p; b = v; break;
+            case 5: r = v; g = p; b = q; break;
+        }
+
+        out[0] = static_cast<uint8_t>(r * 255);
+        out[1] = static_cast<uint8_t>(g * 255);
+        out[2] = static_cast<uint8_t>(b * 255);
+    }
+
+#if defined(FT_PIXELS_SSE2)
+    using Vec = __m128;
+    using IVec = __m128i;
+    inline Vec splat(float x) { return _mm_set1_ps(x); }
+    inline Vec load(const float* p) { return _mm_loadu_ps(p); }
+    inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+    inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+    inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+    inline Vec clamp01(Vec a) { return _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), splat(1.0f)); }
+    inline IVec truncate(Vec a) { return _mm_cvttps_epi32(a); }
+    inline Vec toFloat(IVec a) { return _mm_cvtepi32_ps(a); }
+    inline IVec isplat(int x) { return _mm_set1_epi32(x); }
+    inline IVec iequal(IVec a, IVec b) { return _mm_cmpeq_epi32(a, b); }
+    inline Vec select(IVec mask, Vec a, Vec b) {
+        Vec m = _mm_castsi128_ps(mask);
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+    inline void store(int32_t* p, IVec a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+#elif defined(FT_PIXELS_NEON)
+    using Vec = float32x4_t;
+    using IVec = int32x4_t;
+    inline Vec splat(float x) { return vdupq_n_f32(x); }
+    inline Vec load(const float* p) { return vld1q_f32(p); }
+    inline Vec add(Vec a, Vec b) { return vaddq_f32(a, b); }
+    inline Vec sub(Vec a, Vec b) { return vsubq_f32(a, b); }
+    inline Vec mul(Vec a, Vec b) { return vmulq_f32(a, b); }
+    inline Vec clamp01(Vec a) { return vminq_f32(vmaxq_f32(a, vdupq_n_f32(0.0f)), splat(1.0f)); }
+    inline IVec truncate(Vec a) { return vcvtq_s32_f32(a); }
+    inline Vec toFloat(IVec a) { return vcvtq_f32_s32(a); }
+    inline IVec isplat(int x) { return vdupq_n_s32(x); }
+    inline IVec iequal(IVec a, IVec b) { return vreinterpretq_s32_u32(vceqq_s32(a, b)); }
+    inline Vec select(IVec mask, Vec a, Vec b) { return vbslq_f32(vreinterpretq_u32_s32(mask), a, b); }
+    inline void store(int32_t* p, IVec a) { vst1q_s32(p, a); }
+#endif
+
+    // Byte lanes for the blend kernels: channels blend independently, so
+    // rows are processed as plain bytes regardless of pixel boundaries
+#if defined(FT_PIXELS_SSE2)
+    constexpr size_t kByteLanes = 16;
+    using Bytes = __m128i;
+    inline Bytes loadBytes(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    inline void storeBytes(uint8_t* p, Bytes a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+    inline Bytes addSaturate(Bytes a, Bytes b) { return _mm_adds_epu8(a, b); }
+    inline Bytes maxBytes(Bytes a, Bytes b) { return _mm_max_epu8(a, b); }
+
+    // (a * wa + b * wb) >> 8 per byte, with wa + wb <= 256
+    inline Bytes weighted(Bytes a, int wa, Bytes b, int wb) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i va = _mm_set1_epi16(static_cast<short>(wa));
+        const __m128i vb = _mm_set1_epi16(static_cast<short>(wb));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), va),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), vb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), va),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), vb));
+        return _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+    }
+#elif defined(FT_PIXELS_NEON)
+    constexpr size_t kByteLanes = 16;
+    using Bytes = uint8x16_t;
+    inline Bytes loadBytes(const uint8_t* p) { return vld1q_u8(p); }
+    inline void storeBytes(uint8_t* p, Bytes a) { vst1q_u8(p, a); }
+    inline Bytes addSaturate(Bytes a, Bytes b) { return vqaddq_u8(a, b); }
+    inline Bytes maxBytes(Bytes a, Bytes b) { return vmaxq_u8(a, b); }
+
+    inline Bytes weighted(Bytes a, int wa, Bytes b, int wb) {
+        const uint16_t va = static_cast<uint16_t>(wa);
+        const uint16_t vb = static_cast<uint16_t>(wb);
+        uint16x8_t lo = vaddq_u16(vmulq_n_u16(vmovl_u8(vget_low_u8(a)), va),
+                                  vmulq_n_u16(vmovl_u8(vget_low_u8(b)), vb));
+        uint16x8_t hi = vaddq_u16(vmulq_n_u16(vmovl_u8(vget_high_u8(a)), va),
+                                  vmulq_n_u16(vmovl_u8(vget_high_u8(b)), vb));
+        return vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+    }
+#endif
+
+    // Opacity as a weight out of 256
+    inline int toWeight(float opacity) {
+        return static_cast<int>((std::max)(0.0f, (std::min)(1.0f, opacity)) * 256.0f + 0.5f);
+    }
+
+    inline int scaleChannel(int value, int weight) {
+        return (value * weight) >> 8;
+    }
+
+#if defined(FT_PIXELS_SSE2) || defined(FT_PIXELS_NEON)
+    // Channel value truncated to an integer, optionally scaled and truncated again
+    inline IVec finish(Vec value, bool scale, Vec brightness) {
+        IVec channel = truncate(value);
+        return scale ? truncate(mul(toFloat(channel), brightness)) : channel;
+    }
+#endif
+}
+
+//------------------------------------------------------------------------
+void scaleRow(uint8_t* rgb, size_t count, float brightness) {
+    const size_t bytes = count * 3;
+    size_t i = 0;
+
+#if defined(FT_PIXELS_SSE2) || defined(FT_PIXELS_NEON)
+    const Vec b = splat(brightness);
+    alignas(16) int32_t values[kLanes];
+    alignas(16) float channels[kLanes];
+    for (; i + kLanes <= bytes; i += kLanes) {
+        for (size_t k = 0; k < kLanes; ++k) {
+            channels[k] = rgb[i + k];
+        }
+        store(values, truncate(mul(load(channels), b)));
+        for (size_t k = 0; k < kLanes; ++k) {
+            rgb[i + k] = static_cast<uint8_t>(values[k]);
+        }
+    }
+#endif
+
+    for (; i < bytes; ++i) {
+        rgb[i] = static_cast<uint8_t>(rgb[i] * brightness);
+    }
+}
+
+//------------------------------------------------------------------------
+void lerpRow(uint8_t* out, const float* t, size_t count,
+             const Color& c1, const Color& c2, float brightness) {
+    const bool scale = brightness != 1.0f;
+    size_t i = 0;
+
+#if defined(FT_PIXELS_SSE2) || defined(FT_PIXELS_NEON)
+    const Vec r1 = splat(c1.r), dr = splat(static_cast<float>(c2.r - c1.r));
+    const Vec g1 = splat(c1.g), dg = splat(static_cast<float>(c2.g - c1.g));
+    const Vec b1 = splat(c1.b), db = splat(static_cast<float>(c2.b - c1.b));
+    const Vec bright = splat(brightness);
+    alignas(16) int32_t r[kLanes], g[kLanes], b[kLanes];
+
+    for (; i + kLanes <= count; i += kLanes) {
+        Vec f = clamp01(load(t + i));
+        store(r, finish(add(r1, mul(dr, f)), scale, bright));
+        store(g, finish(add(g1, mul(dg, f)), scale, bright));
+        store(b, finish(add(b1, mul(db, f)), scale, bright));
+        storePixels(out + i * 3, r, g, b, kLanes);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float f = (std::max)(0.0f, (std::min)(1.0f, t[i]));
+        uint8_t* px = out + i * 3;
+        px[0] = lerpChannel(c1.r, c2.r, f);
+        px[1] = lerpChannel(c1.g, c2.g, f);
+        px[2] = lerpChannel(c1.b, c2.b, f);
+        if (scale) {
+            px[0] = static_cast<uint8_t>(px[0] * brightness);
+            px[1] = static_cast<uint8_t>(px[1] * brightness);
+            px[2] = static_cast<uint8_t>(px[2] * brightness);
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+void hsvRow(uint8_t* out, const float* hue, size_t count, float s, float v) {
+    size_t i = 0;
+
+#if defined(FT_PIXELS_SSE2) || defined(FT_PIXELS_NEON)
+    const Vec vs = splat(s);
+    const Vec vv = splat(v);
+    const Vec one = splat(1.0f);
+    const Vec six = splat(6.0f);
+    const Vec full = splat(255.0f);
+    const Vec p = mul(vv, sub(one, vs));
+    alignas(16) int32_t r[kLanes], g[kLanes], b[kLanes];
+
+    for (; i + kLanes <= count; i += kLanes) {
+        // Sector selection below assumes hue in [0, 1); anything else takes
+        // the scalar path so results stay identical
+        bool inRange = true;
+        for (size_t k = 0; k < kLanes; ++k) {
+            inRange = inRange && hue[i + k] >= 0.0f && hue[i + k] < 1.0f;
+        }
+        if (!inRange) {
+            for (size_t k = 0; k < kLanes; ++k) {
+                hsvPixel(out + (i + k) * 3, hue[i + k], s, v);
+            }
+            continue;
+        }
+
+        Vec h6 = mul(load(hue + i), six);
+        IVec sector = truncate(h6);
+        Vec f = sub(h6, toFloat(sector));
+        Vec q = mul(vv, sub(one, mul(f, vs)));
+        Vec t = mul(vv, sub(one, mul(sub(one, f), vs)));
+
+        // Sector is 0-5 here, so i % 6 == i
+        IVec s0 = iequal(sector, isplat(0)), s1 = iequal(sector, isplat(1));
+        IVec s2 = iequal(sector, isplat(2)), s3 = iequal(sector, isplat(3));
+        IVec s4 = iequal(sector, isplat(4));
+
+        Vec red = select(s0, vv, select(s1, q, select(s2, p, select(s3, p, select(s4, t, vv)))));
+        Vec green = select(s0, t, select(s1, vv, select(s2, vv, select(s3, q, p))));
+        Vec blue = select(s0, p, select(s1, p, select(s2, t, select(s3, vv, select(s4, vv, q)))));
+
+        store(r, truncate(mul(red, full)));
+        store(g, truncate(mul(green, full)));
+        store(b, truncate(mul(blue, full)));
+        storePixels(out + i * 3, r, g, b, kLanes);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        hsvPixel(out + i * 3, hue[i], s, v);
+    }
+}
+
+//------------------------------------------------------------------------
+void addRow(uint8_t* dst, const uint8_t* src, size_t count, float opacity) {
+    const int weight = toWeight(opacity);
+    if (weight == 0) {
+        return;
+    }
+    const size_t bytes = count * 3;
+    size_t i = 0;
+
+#if defined(FT_PIXELS_SSE2) || defined(FT_PIXELS_NEON)
+    for (; i + kByteLanes <= bytes; i += kByteLanes) {
+        Bytes s = loadBytes(src + i);
+        if (weight < 256) {
+            s = weighted(s, weight, s, 0);
+        }
+        storeBytes(dst + i, addSaturate(loadBytes(dst + i), s));
+    }
+#endif
+
+    for (; i < bytes; ++i) {
+        dst[i] = static_cast<uint8_t>((std::min)(255, dst[i] + scaleChannel(src[i], weight)));
+    }
+}
+
+//------------------------------------------------------------------------
+void maxRow(uint8_t* dst, const uint8_t* src, size_t count, float opacity) {
+    const int weight = toWeight(opacity);
+    if (weight == 0) {
+        return;
+    }
+    const size_t bytes = count * 3;
+    size_t i = 0;
+
+#if defined(FT_PIXELS_SSE2) || defined(FT_PIXELS_NEON)
+    for (; i + kByteLanes <= bytes; i += kByteLanes) {
+        Bytes s = loadBytes(src + i);
+        if (weight < 256) {
+            s = weighted(s, weight, s, 0);
+        }
+        storeBytes(dst + i, maxBytes(loadBytes(dst + i), s));
+    }
+#endif
+
+    for (; i < bytes; ++i) {
+        dst[i] = static_cast<uint8_t>((std::max)(static_cast<int>(dst[i]), scaleChannel(src[i], weight)));
+    }
+}
+
+//------------------------------------------------------------------------
+void alphaRow(uint8_t* dst, const uint8_t* src, size_t count, float opacity, const Color* key) {
+    const int weight = toWeight(opacity);
+    if (weight == 0) {
+        return;
+    }
+
+    if (key) {
+        for (size_t p = 0; p < count; ++p) {
+            const uint8_t* s = src + p * 3;
+            if (s[0] == key->r && s[1] == key->g && s[2] == key->b) {
+                continue;
+            }
+            uint8_t* d = dst + p * 3;
+            for (int c = 0; c < 3; ++c) {
+                d[c] = static_cast<uint8_t>((s[c] * weight + d[c] * (256 - weight)) >> 8);
+            }
+        }
+        return;
+    }
+
+    const size_t bytes = count * 3;
+    size_t i = 0;
+
+#if defined(FT_PIXELS_SSE2) || defined(FT_PIXELS_NEON)
+    for (; i + kByteLanes <= bytes; i += kByteLanes) {
+        storeBytes(dst + i, weighted(loadBytes(src + i), weight, loadBytes(dst + i), 256 - weight));
+    }
+#endif
+
+    for (; i < bytes; ++i) {
+        dst[i] = static_cast<uint8_t>((src[i] * weight + dst[i] * (256 - weight)) >> 8);
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace PixelKernels
+} // namespace FlaschenTaschen
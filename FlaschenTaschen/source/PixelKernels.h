@@ -0,0 +1,48 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "FlaschenTaschenClient.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// PixelKernels - row-at-a-time color math for the effect renderers
+// Each kernel produces exactly what the per-pixel Color helpers in
+// VisualEffects produce (same float ops, same truncation), four pixels
+// per step on SSE2/NEON. Rows are packed RGB.
+// The blend kernels combine a source row into a destination row for the
+// Compositor, sixteen bytes per step. Opacity is quantized to 1/256.
+//------------------------------------------------------------------------
+namespace PixelKernels {
+
+    // rgb[i] = rgb[i] * brightness
+    void scaleRow(uint8_t* rgb, size_t count, float brightness);
+
+    // out[i] = lerp(c1, c2, clamp(t[i])), then * brightness (skipped at 1)
+    void lerpRow(uint8_t* out, const float* t, size_t count,
+                 const Color& c1, const Color& c2, float brightness = 1.0f);
+
+    // out[i] = hsvToRgb(hue[i], s, v) (vector path for hues in [0, 1))
+    void hsvRow(uint8_t* out, const float* hue, size_t count, float s, float v);
+
+    // dst[i] = min(255, dst[i] + src[i] * opacity)
+    void addRow(uint8_t* dst, const uint8_t* src, size_t count, float opacity = 1.0f);
+
+    // dst[i] = max(dst[i], src[i] * opacity)
+    void maxRow(uint8_t* dst, const uint8_t* src, size_t count, float opacity = 1.0f);
+
+    // dst[i] = lerp(dst[i], src[i], opacity); with a key, source pixels of
+    // exactly that color are transparent (keyed rows run per pixel)
+    void alphaRow(uint8_t* dst, const uint8_t* src, size_t count, float opacity = 1.0f,
+                  const Color* key = nullptr);
+
+} // namespace PixelKernels
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
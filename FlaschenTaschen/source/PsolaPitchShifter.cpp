@@ -0,0 +1,155 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "PsolaPitchShifter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "world/dio.h"
+
+namespace FlaschenTaschen {
+
+namespace {
+    constexpr double kGrainPi = 3.14159265358979323846;  // Unique name: the Standalone app builds all sources as one unit
+    constexpr double kMinGain = 0.25;   // Loudness correction limits
+    constexpr double kMaxGain = 4.0;
+
+    // Index of the largest sample in [begin, end)
+    int findPeak(const std::vector<float>& x, int begin, int end) {
+        begin = (std::max)(begin, 0);
+        end = (std::min)(end, static_cast<int>(x.size()));
+        int peak = begin;
+        for (int i = begin + 1; i < end; ++i) {
+            if (x[i] > x[peak]) peak = i;
+        }
+        return peak;
+    }
+}
+
+//------------------------------------------------------------------------
+std::vector<float> PsolaPitchShifter::shift(const std::vector<float>& input, double ratio) {
+    if (input.empty() || ratio <= 0 || std::abs(ratio - 1.0) < 0.001) {
+        return input;
+    }
+
+    return synthesize(analyze(input), ratio);
+}
+
+//------------------------------------------------------------------------
+PsolaAnalysis PsolaPitchShifter::analyze(const std::vector<float>& input) const {
+    PsolaAnalysis analysis;
+    analysis.sampleRate = sampleRate_;
+    analysis.source = input;
+
+    const int length = static_cast<int>(input.size());
+    if (length == 0) {
+        return analysis;
+    }
+
+    // Coarse F0 track: decimated DIO, no refinement
+    std::vector<double> x(input.begin(), input.end());
+
+    DioOption option;
+    InitializeDioOption(&option);
+    option.frame_period = kFramePeriod;
+    option.speed = kDioSpeed;
+    option.f0_floor = 71.0;
+    option.f0_ceil = 800.0;
+    option.allowed_range = 0.1;
+
+    const int f0Length = GetSamplesForDIO(sampleRate_, length, kFramePeriod);
+    std::vector<double> f0(f0Length);
+    std::vector<double> temporalPositions(f0Length);
+    Dio(x.data(), length, sampleRate_, &option, temporalPositions.data(), f0.data());
+
+    const double framesPerSample = 1000.0 / (kFramePeriod * sampleRate_);
+    const int unvoicedPeriod = (std::max)(1, static_cast<int>(std::lround(kUnvoicedPeriod * sampleRate_)));
+
+    // Walk the signal one grain at a time. Voiced marks snap to the waveform
+    // peak near the expected position so grains stay pitch-synchronous.
+    bool previousVoiced = false;
+    int position = 0;
+    while (position < length) {
+        const int frame = (std::min)(f0Length - 1, static_cast<int>(std::lround(position * framesPerSample)));
+        const double currentF0 = f0[frame];
+
+        if (currentF0 > 0.0) {
+            const int period = (std::max)(2, static_cast<int>(std::lround(sampleRate_ / currentF0)));
+            const int mark = previousVoiced ? findPeak(input, position - period / 4, position + period / 4 + 1)
+                                            : findPeak(input, position, position + period);
+            analysis.marks.push_back(mark);
+            analysis.periods.push_back(period);
+            analysis.voiced.push_back(1);
+            position = mark + period;
+            previousVoiced = true;
+        } else {
+            analysis.marks.push_back(position);
+            analysis.periods.push_back(unvoicedPeriod);
+            analysis.voiced.push_back(0);
+            position += unvoicedPeriod;
+            previousVoiced = false;
+        }
+    }
+
+    return analysis;
+}
+
+//------------------------------------------------------------------------
+std::vector<float> PsolaPitchShifter::synthesize(const PsolaAnalysis& analysis, double ratio) {
+    if (!analysis.isValid() || ratio <= 0 || std::abs(ratio - 1.0) < 0.001) {
+        return analysis.source;
+    }
+
+    const std::vector<float>& source = analysis.source;
+    const int length = static_cast<int>(source.size());
+    const size_t markCount = analysis.marks.size();
+
+    std::vector<float> output(length, 0.0f);
+
+    // Output grains follow the original timeline (duration unchanged); each
+    // takes the nearest analysis grain, spaced at period / ratio when voiced
+    size_t k = 0;
+    double time = analysis.marks[0];
+    while (time < length) {
+        while (k + 1 < markCount &&
+               std::abs(analysis.marks[k + 1] - time) <= std::abs(analysis.marks[k] - time)) {
+            ++k;
+        }
+
+        const int period = analysis.periods[k];
+        const int center = analysis.marks[k];
+        const int outCenter = static_cast<int>(std::lround(time));
+
+        // Hann grain of two periods centered on the analysis mark
+        const int begin = (std::max)(-period, (std::max)(-center, -outCenter));
+        const int end = (std::min)(period, (std::min)(length - center, length - outCenter));
+        for (int j = begin; j < end; ++j) {
+            const double w = 0.5 - 0.5 * std::cos(kGrainPi * (j + period) / period);
+            output[outCenter + j] += static_cast<float>(w * source[center + j]);
+        }
+
+        time += analysis.voiced[k] ? period / ratio : period;
+    }
+
+    // Overlapping grains do not add coherently, so match the source loudness
+    double sourceEnergy = 0.0;
+    double outputEnergy = 0.0;
+    for (int i = 0; i < length; ++i) {
+        sourceEnergy += static_cast<double>(source[i]) * source[i];
+        outputEnergy += static_cast<double>(output[i]) * output[i];
+    }
+    const double gain = outputEnergy > 0.0
+        ? (std::max)(kMinGain, (std::min)(kMaxGain, std::sqrt(sourceEnergy / outputEnergy)))
+        : 1.0;
+
+    for (float& sample : output) {
+        sample = static_cast<float>(sample * gain);
+    }
+    return output;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,57 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "PitchShifter.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// PsolaAnalysis - pitch marks of one utterance
+// One grain per mark: pitch-synchronous where voiced, fixed spacing
+// where unvoiced.
+//------------------------------------------------------------------------
+struct PsolaAnalysis {
+    int sampleRate = 0;
+    std::vector<float> source;
+    std::vector<int> marks;         // Grain centers (samples, increasing)
+    std::vector<int> periods;       // Grain half-length (samples)
+    std::vector<uint8_t> voiced;    // 1 = grain follows the F0 track
+
+    bool isValid() const { return !marks.empty(); }
+};
+
+//------------------------------------------------------------------------
+// PsolaPitchShifter - low-latency TD-PSOLA pitch shifting
+// A coarse DIO pass gives the F0 track; grains are Hann-windowed and
+// re-spaced at the target period. Much cheaper than World resynthesis,
+// at the cost of some buzz on large shifts.
+//------------------------------------------------------------------------
+class PsolaPitchShifter : public PitchShifter {
+public:
+    void initialize(int sampleRate) override { sampleRate_ = sampleRate; }
+    int getSampleRate() const override { return sampleRate_; }
+
+    std::vector<float> shift(const std::vector<float>& input, double ratio) override;
+
+    // Find pitch marks (DIO F0 track snapped to waveform peaks)
+    PsolaAnalysis analyze(const std::vector<float>& input) const;
+
+    // Overlap-add the grains at the shifted spacing (duration unchanged)
+    static std::vector<float> synthesize(const PsolaAnalysis& analysis, double ratio);
+
+private:
+    static constexpr double kFramePeriod = 5.0;       // DIO frame period (ms)
+    static constexpr int kDioSpeed = 4;                // DIO decimation (1 = best, 12 = fastest)
+    static constexpr double kUnvoicedPeriod = 0.005;   // Grain spacing without F0 (s)
+
+    int sampleRate_ = 44100;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
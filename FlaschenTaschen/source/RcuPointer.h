@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// RcuPointer - immutable snapshot swapped without blocking the reader
+// One realtime reader (the audio thread) calls read() and uses the raw
+// pointer until its next quiescent() call, with no locks, reference
+// counting or frees. Writers publish() a new snapshot; the old one is
+// retired and released by a later publish()/reclaim() once the reader
+// has passed a quiescent point, so it is never freed on the audio thread.
+// Other threads take shared ownership with get().
+//------------------------------------------------------------------------
+template <typename T>
+class RcuPointer {
+public:
+    RcuPointer() = default;
+
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    // Realtime reader: current snapshot (nullptr before the first publish)
+    const T* read() const { return current_.load(); }
+
+    // Realtime reader: no pointer from read() is held any more. May also be
+    // called from any thread while the reader is known to be idle.
+    void quiescent() { epoch_.fetch_add(1); }
+
+    // Non-realtime threads: shared ownership of the current snapshot
+    std::shared_ptr<const T> get() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return owner_;
+    }
+
+    // Make next current and retire the previous snapshot (not realtime-safe)
+    void publish(std::shared_ptr<const T> next) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<const T> previous = std::move(owner_);
+        owner_ = std::move(next);
+        current_.store(owner_.get());
+
+        // The reader may still hold previous until the epoch moves on
+        if (previous) {
+            retired_.push_back({std::move(previous), epoch_.load()});
+        }
+        reclaimLocked();
+    }
+
+    // Release retired snapshots the reader can no longer see (not realtime-safe)
+    void reclaim() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reclaimLocked();
+    }
+
+    size_t getRetiredCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return retired_.size();
+    }
+
+private:
+    struct Retired {
+        std::shared_ptr<const T> snapshot;
+        uint64_t epoch;         // Reader epoch when it was replaced
+    };
+
+    void reclaimLocked() {
+        const uint64_t epoch = epoch_.load();
+        size_t kept = 0;
+        for (size_t i = 0; i < retired_.size(); ++i) {
+            if (retired_[i].epoch == epoch) {
+                retired_[kept++] = std::move(retired_[i]);
+            }
+        }
+        retired_.resize(kept);
+    }
+
+    std::atomic<const T*> current_{nullptr};
+    std::atomic<uint64_t> epoch_{0};
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const T> owner_;
+    std::vector<Retired> retired_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,72 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "RenderCache.h"
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+void RenderCache::syncGeneration() {
+    unsigned generation = generation_.load(std::memory_order_relaxed);
+    if (generation != seenGeneration_) {
+        renders_.clear();
+        analyses_.clear();
+        seenGeneration_ = generation;
+    }
+}
+
+//------------------------------------------------------------------------
+const std::vector<float>* RenderCache::find(const RenderCacheKey& key) {
+    syncGeneration();
+    return renders_.find(key);
+}
+
+//------------------------------------------------------------------------
+const std::vector<float>* RenderCache::insert(const RenderCacheKey& key, std::vector<float> samples) {
+    syncGeneration();
+    return renders_.insert(key, std::move(samples),
+                           [](const std::vector<float>& render) { return render.size(); });
+}
+
+//------------------------------------------------------------------------
+std::shared_ptr<const WorldAnalysis> RenderCache::findAnalysis(const RenderCacheKey& key) {
+    syncGeneration();
+    const CachedAnalysis* entry = analyses_.find(key);
+    if (!entry) {
+        return nullptr;
+    }
+    if (entry->full) {
+        return entry->full;
+    }
+    if (auto decoded = entry->decoded.lock()) {
+        return decoded;
+    }
+    auto decoded = std::make_shared<const WorldAnalysis>(WorldPitchShifter::decode(*entry->coded));
+    entry->decoded = decoded;
+    return decoded;
+}
+
+//------------------------------------------------------------------------
+std::shared_ptr<const WorldAnalysis> RenderCache::insertAnalysis(const RenderCacheKey& key, WorldAnalysis analysis) {
+    syncGeneration();
+    auto shared = std::make_shared<const WorldAnalysis>(std::move(analysis));
+
+    // Coded entries serve this first note from the full analysis
+    CachedAnalysis entry;
+    const int dims = analysisDims_.load(std::memory_order_relaxed);
+    if (dims > 0) {
+        entry.coded = std::make_shared<const WorldCodedAnalysis>(WorldPitchShifter::encode(*shared, dims));
+        entry.decoded = shared;
+    } else {
+        entry.full = shared;
+    }
+
+    // Over budget: still usable, just not cached
+    const CachedAnalysis* stored = analyses_.insert(key, std::move(entry),
+        [](const CachedAnalysis& a) { return a.getMemorySize(); });
+    return (stored && stored->full) ? stored->full : shared;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "WorldPitchShifter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// RenderCacheKey - everything that influences a rendered note
+//------------------------------------------------------------------------
+struct RenderCacheKey {
+    std::string text;       // Syllable text
+    std::string voice;      // eSpeak voice
+    int rate = 0;           // eSpeak rate
+    int pitch = 0;          // eSpeak base pitch
+    int volume = 0;         // eSpeak volume
+    int pitchNote = -1;     // Target MIDI note (-1 = not pitch shifted)
+    int outputRate = 0;     // Sample rate of the cached audio
+    int engine = 0;         // PitchEngine of a shifted render
+
+    bool operator<(const RenderCacheKey& other) const {
+        return std::tie(text, voice, rate, pitch, volume, pitchNote, outputRate, engine) <
+               std::tie(other.text, other.voice, other.rate, other.pitch, other.volume,
+                        other.pitchNote, other.outputRate, other.engine);
+    }
+};
+
+//------------------------------------------------------------------------
+// RenderCache - memoizes final output-rate syllable renders and the
+// World analysis of each raw syllable (so a new note only needs Synthesis)
+// With setAnalysisDims() the analyses are kept coded (WorldCodedAnalysis)
+// and decoded when a note needs one; the decode is shared while in use.
+// find()/insert() and findAnalysis()/insertAnalysis() belong to the render worker thread. invalidate() may be
+// called from any thread (including audio); the entries are dropped
+// lazily by the worker on its next access.
+//------------------------------------------------------------------------
+class RenderCache {
+public:
+    // Default budget: 16M samples (64 MB of float audio)
+    static constexpr size_t kDefaultMaxSamples = 16 * 1024 * 1024;
+
+    // Default analysis budget: 256 MB (about 300 one-second syllables at 22050 Hz)
+    static constexpr size_t kDefaultMaxAnalysisBytes = 256 * 1024 * 1024;
+
+    RenderCache() {
+        renders_.maxSize = kDefaultMaxSamples;
+        analyses_.maxSize = kDefaultMaxAnalysisBytes;
+    }
+
+    // Look up a render, returns nullptr on miss
+    const std::vector<float>* find(const RenderCacheKey& key);
+
+    // Store a render, evicting the oldest entries if over budget
+    const std::vector<float>* insert(const RenderCacheKey& key, std::vector<float> samples);
+
+    // Look up the World analysis of an unshifted syllable (key.pitchNote == -1)
+    // The analysis is shared so streams using it survive eviction.
+    std::shared_ptr<const WorldAnalysis> findAnalysis(const RenderCacheKey& key);
+
+    // Store an analysis, evicting the oldest analyses if over budget
+    std::shared_ptr<const WorldAnalysis> insertAnalysis(const RenderCacheKey& key, WorldAnalysis analysis);
+
+    // Drop all entries (realtime-safe, takes effect on next find/insert)
+    void invalidate() { generation_.fetch_add(1, std::memory_order_relaxed); }
+
+    // Current invalidation generation (any thread)
+    unsigned getGeneration() const { return generation_.load(std::memory_order_relaxed); }
+
+    // Mel-cepstral dimensions of stored analyses, 0 = full spectra (any
+    // thread; applies to analyses inserted after the next invalidate())
+    void setAnalysisDims(int dims) { analysisDims_.store(dims, std::memory_order_relaxed); }
+
+    // Set memory budgets
+    void setMaxSamples(size_t maxSamples) { renders_.maxSize = maxSamples; }
+    void setMaxAnalysisBytes(size_t maxBytes) { analyses_.maxSize = maxBytes; }
+
+    // Statistics
+    size_t getEntryCount() const { return renders_.entries.size(); }
+    size_t getTotalSamples() const { return renders_.totalSize; }
+    size_t getAnalysisCount() const { return analyses_.entries.size(); }
+    size_t getAnalysisBytes() const { return analyses_.totalSize; }
+
+private:
+    // A stored analysis: full, or coded plus its decode while one is in use
+    struct CachedAnalysis {
+        std::shared_ptr<const WorldAnalysis> full;
+        std::shared_ptr<const WorldCodedAnalysis> coded;
+        mutable std::weak_ptr<const WorldAnalysis> decoded;
+
+        size_t getMemorySize() const { return full ? full->getMemorySize() : coded->getMemorySize(); }
+    };
+
+    // FIFO-evicted map with a size budget (samples or bytes)
+    template<typename Value>
+    struct Store {
+        std::map<RenderCacheKey, Value> entries;
+        std::deque<RenderCacheKey> insertionOrder;
+        size_t totalSize = 0;
+        size_t maxSize = 0;
+
+        void clear() {
+            entries.clear();
+            insertionOrder.clear();
+            totalSize = 0;
+        }
+
+        const Value* find(const RenderCacheKey& key) const {
+            auto it = entries.find(key);
+            return (it != entries.end()) ? &it->second : nullptr;
+        }
+
+        template<typename SizeOf>
+        const Value* insert(const RenderCacheKey& key, Value value, SizeOf sizeOf);
+    };
+
+    void syncGeneration();
+
+    Store<std::vector<float>> renders_;
+    Store<CachedAnalysis> analyses_;
+    std::atomic<int> analysisDims_{0};
+
+    std::atomic<unsigned> generation_{0};
+    unsigned seenGeneration_ = 0;
+};
+
+//------------------------------------------------------------------------
+template<typename Value>
+template<typename SizeOf>
+const Value* RenderCache::Store<Value>::insert(const RenderCacheKey& key, Value value, SizeOf sizeOf) {
+    const size_t size = sizeOf(value);
+
+    // Single items larger than the whole budget are not cached
+    if (size > maxSize) {
+        return nullptr;
+    }
+
+    // Evict oldest entries until the new item fits
+    while (!insertionOrder.empty() && totalSize + size > maxSize) {
+        auto it = entries.find(insertionOrder.front());
+        if (it != entries.end()) {
+            totalSize -= sizeOf(it->second);
+            entries.erase(it);
+        }
+        insertionOrder.pop_front();
+    }
+
+    auto result = entries.emplace(key, std::move(value));
+    if (!result.second) {
+        return &result.first->second;  // Already cached
+    }
+
+    totalSize += size;
+    insertionOrder.push_back(key);
+    return &result.first->second;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "RenderWorker.h"
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+RenderWorker::~RenderWorker() {
+    stop();
+}
+
+//------------------------------------------------------------------------
+void RenderWorker::start(RenderFunction renderFunction) {
+    if (running_) {
+        return;
+    }
+
+    // Drop anything left over from a previous run
+    RenderJob stale;
+    while (jobs_.pop(stale)) {}
+    finishedJobs_ = submittedJobs_.load();
+
+    renderFunction_ = std::move(renderFunction);
+    running_ = true;
+    thread_ = std::thread(&RenderWorker::run, this);
+}
+
+//------------------------------------------------------------------------
+void RenderWorker::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    wake();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    // Release anyone waiting for jobs that will never run
+    {
+        std::lock_guard<std::mutex> lock(doneMutex_);
+    }
+    doneCondition_.notify_all();
+
+    std::lock_guard<std::mutex> lock(tasksMutex_);
+    tasks_.clear();
+    hasTasks_ = false;
+}
+
+//------------------------------------------------------------------------
+bool RenderWorker::submit(const RenderJob& job) {
+    if (!jobs_.push(job)) {
+        ++droppedJobs_;
+        return false;
+    }
+    ++submittedJobs_;
+    wake();
+    return true;
+}
+
+//------------------------------------------------------------------------
+void RenderWorker::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex_);
+        tasks_.push_back(std::move(task));
+        hasTasks_ = true;
+    }
+    wake();
+}
+
+//------------------------------------------------------------------------
+void RenderWorker::wake() {
+    if (!wakePending_.exchange(true)) {
+        wakeSemaphore_.signal();
+    }
+}
+
+//------------------------------------------------------------------------
+void RenderWorker::waitForJobs() {
+    const uint64_t target = submittedJobs_;
+    std::unique_lock<std::mutex> lock(doneMutex_);
+    doneCondition_.wait(lock, [this, target] {
+        return !running_ || finishedJobs_ >= target;
+    });
+}
+
+//------------------------------------------------------------------------
+void RenderWorker::run() {
+    while (running_) {
+        // Anything queued after this point signals again
+        wakePending_ = false;
+
+        RenderJob job;
+        if (jobs_.pop(job)) {
+            if (renderFunction_) {
+                renderFunction_(job);
+            }
+            {
+                std::lock_guard<std::mutex> lock(doneMutex_);
+                ++finishedJobs_;
+            }
+            doneCondition_.notify_all();
+            continue;
+        }
+
+        // Note jobs always win; background tasks run one at a time in between
+        if (hasTasks_) {
+            Task task;
+            {
+                std::lock_guard<std::mutex> lock(tasksMutex_);
+                if (!tasks_.empty()) {
+                    task = std::move(tasks_.front());
+                    tasks_.pop_front();
+                }
+                hasTasks_ = !tasks_.empty();
+            }
+            if (task) {
+                task();
+            }
+            continue;
+        }
+
+        if (running_) {
+            wakeSemaphore_.wait();
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
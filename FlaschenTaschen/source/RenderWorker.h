@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "LockFreeQueue.h"
+#include "Semaphore.h"
+#include "VoicePool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// RenderJob - a note that needs to be synthesized
+//------------------------------------------------------------------------
+struct RenderJob {
+    int midiNote = -1;    // Note as received (used for the syllable lookup)
+    int pitchNote = -1;   // Note after octave offset (used for pitch shifting)
+    int velocity = 0;     // 0-127
+    VoiceHandle voice;    // Playback voice claimed for this note
+    int64_t noteOnMicros = 0;  // LatencyStats::nowMicros() at the note-on
+};
+
+//------------------------------------------------------------------------
+// RenderWorker - background thread that renders note jobs
+// submit() is safe to call from the audio thread: it only pushes into a
+// lock-free queue and wakes the worker. All TTS/pitch-shift work happens
+// inside the render function on the worker thread.
+// post() queues lower-priority background tasks from non-realtime
+// threads; they run only while no note job is waiting. waitForJobs()
+// blocks until every submitted job is rendered (offline bounces).
+//------------------------------------------------------------------------
+class RenderWorker {
+public:
+    using RenderFunction = std::function<void(const RenderJob& job)>;
+    using Task = std::function<void()>;
+
+    static constexpr size_t kMaxPendingJobs = 64;
+
+    RenderWorker() = default;
+    ~RenderWorker();
+
+    RenderWorker(const RenderWorker&) = delete;
+    RenderWorker& operator=(const RenderWorker&) = delete;
+
+    // Start the worker thread (no-op if already running)
+    void start(RenderFunction renderFunction);
+
+    // Stop the worker thread, dropping any jobs and tasks still queued
+    void stop();
+
+    // Check if running
+    bool isRunning() const { return running_; }
+
+    // Queue a job (realtime-safe). Returns false if the queue is full.
+    bool submit(const RenderJob& job);
+
+    // Queue a background task (not realtime-safe: locks and allocates)
+    void post(Task task);
+
+    // Block until every job submitted so far has been rendered, or the
+    // worker stops (not realtime-safe; a task already running finishes first)
+    void waitForJobs();
+
+    // Number of jobs dropped because the queue was full
+    int getDroppedJobs() const { return droppedJobs_; }
+
+private:
+    void run();
+
+    LockFreeQueue<RenderJob, kMaxPendingJobs> jobs_;
+    RenderFunction renderFunction_;
+
+    std::mutex tasksMutex_;
+    std::deque<Task> tasks_;
+    std::atomic<bool> hasTasks_{false};
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<int> droppedJobs_{0};
+
+    // Jobs queued / rendered, for waitForJobs()
+    std::atomic<uint64_t> submittedJobs_{0};
+    std::atomic<uint64_t> finishedJobs_{0};
+    std::mutex doneMutex_;
+    std::condition_variable doneCondition_;
+
+    // Sleeps only while there is nothing to do. wakePending_ keeps a burst of
+    // submits to a single signal; it is cleared before the queues are checked.
+    void wake();
+    Semaphore wakeSemaphore_;
+    std::atomic<bool> wakePending_{false};
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,244 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "Resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <utility>
+
+// Inner loop instruction set is picked at compile time. AVX is only used
+// when the compiler targets it (/arch:AVX, -mavx); x64 always has SSE.
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FT_RESAMPLER_AVX 1
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FT_RESAMPLER_SSE 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define FT_RESAMPLER_NEON 1
+#endif
+
+namespace FlaschenTaschen {
+
+namespace {
+    constexpr int kTaps = ResamplerFilterBank::kTaps;
+    constexpr int kHalfTaps = kTaps / 2;
+    constexpr double kPi = 3.14159265358979323846;
+    constexpr double kKaiserBeta = 8.0;
+    constexpr double kCutoffScale = 0.95;   // Pass band edge relative to the lower Nyquist
+
+    const int kCommonOutputRates[] = { 44100, 48000, 88200, 96000 };
+
+    // Zeroth-order modified Bessel function (Kaiser window)
+    double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+            if (term < sum * 1e-12) break;
+        }
+        return sum;
+    }
+
+    // One output sample: kTaps-point dot product
+    inline float dotProduct(const float* samples, const float* coefficients) {
+#if defined(FT_RESAMPLER_AVX)
+        __m256 acc = _mm256_setzero_ps();
+        for (int k = 0; k < kTaps; k += 8) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(samples + k), _mm256_loadu_ps(coefficients + k)));
+        }
+        __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+        sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+        return _mm_cvtss_f32(sum4);
+#elif defined(FT_RESAMPLER_SSE)
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (int k = 0; k < kTaps; k += 8) {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(samples + k), _mm_loadu_ps(coefficients + k)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(samples + k + 4), _mm_loadu_ps(coefficients + k + 4)));
+        }
+        __m128 sum4 = _mm_add_ps(acc0, acc1);
+        sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+        sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+        return _mm_cvtss_f32(sum4);
+#elif defined(FT_RESAMPLER_NEON)
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        for (int k = 0; k < kTaps; k += 8) {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(samples + k), vld1q_f32(coefficients + k));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(samples + k + 4), vld1q_f32(coefficients + k + 4));
+        }
+        float32x4_t sum4 = vaddq_f32(acc0, acc1);
+        float32x2_t sum2 = vadd_f32(vget_low_f32(sum4), vget_high_f32(sum4));
+        return vget_lane_f32(vpadd_f32(sum2, sum2), 0);
+#else
+        float sum = 0.0f;
+        for (int k = 0; k < kTaps; ++k) {
+            sum += samples[k] * coefficients[k];
+        }
+        return sum;
+#endif
+    }
+
+    std::shared_ptr<const ResamplerFilterBank> buildFilterBank(int inputRate, int outputRate) {
+        auto bank = std::make_shared<ResamplerFilterBank>();
+        bank->inputRate = inputRate;
+        bank->outputRate = outputRate;
+
+        const uint64_t divisor = std::gcd(static_cast<uint64_t>(inputRate), static_cast<uint64_t>(outputRate));
+        bank->upFactor = static_cast<uint64_t>(outputRate) / divisor;
+        bank->downFactor = static_cast<uint64_t>(inputRate) / divisor;
+        bank->phases = static_cast<int>((std::min)(bank->upFactor, static_cast<uint64_t>(ResamplerFilterBank::kMaxPhases)));
+        bank->coefficients.resize(static_cast<size_t>(bank->phases) * kTaps);
+
+        // Low-pass at the lower of the two Nyquist frequencies (in input samples)
+        const double cutoff = (std::min)(1.0, static_cast<double>(outputRate) / inputRate) * kCutoffScale;
+        const double windowNorm = besselI0(kKaiserBeta);
+
+        for (int phase = 0; phase < bank->phases; ++phase) {
+            const double fraction = static_cast<double>(phase) / bank->phases;
+            float* taps = bank->coefficients.data() + static_cast<size_t>(phase) * kTaps;
+
+            double sum = 0.0;
+            for (int j = 0; j < kTaps; ++j) {
+                // Distance (in input samples) from the output instant to this tap
+                double distance = j - (kHalfTaps - 1) - fraction;
+                double x = cutoff * distance;
+                double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(kPi * x) / (kPi * x);
+                double r = distance / kHalfTaps;
+                double window = (std::abs(r) < 1.0) ? besselI0(kKaiserBeta * std::sqrt(1.0 - r * r)) / windowNorm : 0.0;
+                double value = cutoff * sinc * window;
+                taps[j] = static_cast<float>(value);
+                sum += value;
+            }
+
+            // Unity DC gain for every phase
+            if (sum != 0.0) {
+                for (int j = 0; j < kTaps; ++j) {
+                    taps[j] = static_cast<float>(taps[j] / sum);
+                }
+            }
+        }
+
+        return bank;
+    }
+}
+
+//------------------------------------------------------------------------
+std::shared_ptr<const ResamplerFilterBank> Resampler::getFilterBank(int inputRate, int outputRate) {
+    static std::mutex registryMutex;
+    static std::map<std::pair<int, int>, std::shared_ptr<const ResamplerFilterBank>> registry;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto& bank = registry[std::make_pair(inputRate, outputRate)];
+    if (!bank) {
+        bank = buildFilterBank(inputRate, outputRate);
+    }
+    return bank;
+}
+
+//------------------------------------------------------------------------
+void Resampler::precomputeCommonRates() {
+    for (int outputRate : kCommonOutputRates) {
+        getFilterBank(22050, outputRate);
+    }
+}
+
+//------------------------------------------------------------------------
+void Resampler::setRates(int inputRate, int outputRate) {
+    inputRate_ = inputRate > 0 ? inputRate : 1;
+    outputRate_ = outputRate > 0 ? outputRate : 1;
+    bank_ = isPassthrough() ? nullptr : getFilterBank(inputRate_, outputRate_);
+    reset();
+}
+
+//------------------------------------------------------------------------
+void Resampler::reset() {
+    // Zero pre-pad so the first output sample is centered on input[0]
+    history_.assign(kHalfTaps - 1, 0.0f);
+    index_ = 0;
+    phase_ = 0;
+    inputCount_ = 0;
+    outputCount_ = 0;
+}
+
+//------------------------------------------------------------------------
+void Resampler::process(const float* input, size_t count, std::vector<float>& output) {
+    if (count == 0) {
+        return;
+    }
+
+    if (isPassthrough()) {
+        output.insert(output.end(), input, input + count);
+        return;
+    }
+
+    history_.insert(history_.end(), input, input + count);
+    inputCount_ += count;
+    produce(output, false);
+}
+
+//------------------------------------------------------------------------
+void Resampler::flush(std::vector<float>& output) {
+    if (!isPassthrough() && inputCount_ > 0) {
+        // Zero look-ahead for the final samples, stop at the end of the real input
+        history_.insert(history_.end(), kHalfTaps, 0.0f);
+        produce(output, true);
+    }
+    reset();
+}
+
+//------------------------------------------------------------------------
+std::vector<float> Resampler::processAll(const std::vector<float>& input) {
+    reset();
+
+    std::vector<float> output;
+    output.reserve(static_cast<size_t>(static_cast<double>(input.size()) * outputRate_ / inputRate_) + 1);
+    process(input.data(), input.size(), output);
+    flush(output);
+    return output;
+}
+
+//------------------------------------------------------------------------
+void Resampler::produce(std::vector<float>& output, bool flushing) {
+    const ResamplerFilterBank& bank = *bank_;
+    const uint64_t up = bank.upFactor;
+    const uint64_t down = bank.downFactor;
+    const bool exactPhases = (static_cast<uint64_t>(bank.phases) == up);
+
+    while (index_ + kTaps <= history_.size()) {
+        // Output instant n * M / L must lie inside the real input
+        if (flushing && outputCount_ * down >= inputCount_ * up) {
+            break;
+        }
+
+        const int phase = exactPhases ? static_cast<int>(phase_)
+                                      : static_cast<int>((phase_ * bank.phases) / up);
+        output.push_back(dotProduct(history_.data() + index_, bank.getPhase(phase)));
+        ++outputCount_;
+
+        phase_ += down;
+        index_ += static_cast<size_t>(phase_ / up);
+        phase_ %= up;
+    }
+
+    // Drop consumed input, keeping the taps still needed
+    if (index_ >= history_.size()) {
+        index_ -= history_.size();
+        history_.clear();
+    } else {
+        history_.erase(history_.begin(), history_.begin() + index_);
+        index_ = 0;
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// ResamplerFilterBank - polyphase windowed-sinc coefficients for one
+// rate pair. Banks are immutable and shared between all resamplers using
+// the same conversion.
+//------------------------------------------------------------------------
+struct ResamplerFilterBank {
+    static constexpr int kTaps = 32;        // Per phase (multiple of 8 for SIMD)
+    static constexpr int kMaxPhases = 1024; // Larger ratios use quantized phases
+
+    int inputRate = 0;
+    int outputRate = 0;
+    uint64_t upFactor = 1;    // L: output rate / gcd
+    uint64_t downFactor = 1;  // M: input rate / gcd
+    int phases = 1;           // min(L, kMaxPhases)
+    std::vector<float> coefficients;  // phases x kTaps, phase-major
+
+    const float* getPhase(int phase) const { return coefficients.data() + phase * kTaps; }
+};
+
+//------------------------------------------------------------------------
+// Resampler - streaming polyphase sample rate converter
+// Keeps its filter history across process() calls, so a signal fed in
+// arbitrary blocks converts exactly like one fed as a whole. Output is
+// aligned with the input (no group delay); the last kTaps/2 input samples
+// are held back as look-ahead until flush().
+//------------------------------------------------------------------------
+class Resampler {
+public:
+    Resampler() = default;
+
+    // Configure conversion and reset state (fetches or builds the filter bank)
+    void setRates(int inputRate, int outputRate);
+
+    // Forget history (start of a new signal)
+    void reset();
+
+    // Convert one input block, appending the produced samples to output
+    void process(const float* input, size_t count, std::vector<float>& output);
+
+    // End of signal: emit the samples still held as look-ahead, then reset
+    void flush(std::vector<float>& output);
+
+    // Convert a whole signal in one go
+    std::vector<float> processAll(const std::vector<float>& input);
+
+    int getInputRate() const { return inputRate_; }
+    int getOutputRate() const { return outputRate_; }
+    bool isPassthrough() const { return inputRate_ == outputRate_; }
+
+    // Shared filter bank for a rate pair (built on first use, thread-safe)
+    static std::shared_ptr<const ResamplerFilterBank> getFilterBank(int inputRate, int outputRate);
+
+    // Build the banks for eSpeak's 22050 Hz to the usual host rates up front
+    static void precomputeCommonRates();
+
+private:
+    void produce(std::vector<float>& output, bool flushing);
+
+    int inputRate_ = 22050;
+    int outputRate_ = 22050;
+    std::shared_ptr<const ResamplerFilterBank> bank_;
+
+    std::vector<float> history_;   // Zero pre-pad + unconsumed input
+    size_t index_ = 0;             // First tap position in history_
+    uint64_t phase_ = 0;           // 0 .. L-1
+    uint64_t inputCount_ = 0;      // Real samples received since reset
+    uint64_t outputCount_ = 0;     // Samples produced since reset
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
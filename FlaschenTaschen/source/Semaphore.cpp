@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "Semaphore.h"
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <climits>
+#elif defined(__APPLE__)
+    #include <dispatch/dispatch.h>
+#else
+    #include <cerrno>
+    #include <semaphore.h>
+#endif
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+Semaphore::Semaphore() {
+#ifdef _WIN32
+    handle_ = CreateSemaphoreA(nullptr, 0, LONG_MAX, nullptr);
+#elif defined(__APPLE__)
+    handle_ = dispatch_semaphore_create(0);
+#else
+    auto* semaphore = new sem_t;
+    sem_init(semaphore, 0, 0);
+    handle_ = semaphore;
+#endif
+}
+
+//------------------------------------------------------------------------
+Semaphore::~Semaphore() {
+#ifdef _WIN32
+    CloseHandle(static_cast<HANDLE>(handle_));
+#elif defined(__APPLE__)
+    dispatch_release(static_cast<dispatch_semaphore_t>(handle_));
+#else
+    sem_destroy(static_cast<sem_t*>(handle_));
+    delete static_cast<sem_t*>(handle_);
+#endif
+}
+
+//------------------------------------------------------------------------
+void Semaphore::signal() {
+#ifdef _WIN32
+    ReleaseSemaphore(static_cast<HANDLE>(handle_), 1, nullptr);
+#elif defined(__APPLE__)
+    dispatch_semaphore_signal(static_cast<dispatch_semaphore_t>(handle_));
+#else
+    sem_post(static_cast<sem_t*>(handle_));
+#endif
+}
+
+//------------------------------------------------------------------------
+void Semaphore::wait() {
+#ifdef _WIN32
+    WaitForSingleObject(static_cast<HANDLE>(handle_), INFINITE);
+#elif defined(__APPLE__)
+    dispatch_semaphore_wait(static_cast<dispatch_semaphore_t>(handle_), DISPATCH_TIME_FOREVER);
+#else
+    // Retry if a signal handler interrupted the wait
+    while (sem_wait(static_cast<sem_t*>(handle_)) != 0 && errno == EINTR) {}
+#endif
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,33 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// Semaphore - counting semaphore on the platform primitive
+// signal() never blocks or allocates, so the realtime audio thread can
+// wake a waiting thread with it; a signal before wait() is never lost.
+//------------------------------------------------------------------------
+class Semaphore {
+public:
+    Semaphore();
+    ~Semaphore();
+
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    // Add one to the count, waking a waiter (realtime-safe)
+    void signal();
+
+    // Block until the count is positive, then take one
+    void wait();
+
+private:
+    void* handle_ = nullptr;  // HANDLE, dispatch_semaphore_t or sem_t*
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,334 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "SpeechCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <direct.h>
+    #include <process.h>
+#else
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace FlaschenTaschen {
+
+static_assert(sizeof(SpeechCacheRecord) == 40, "speech cache record layout changed");
+
+namespace {
+
+// Caches by path; an entry expires with its last user
+std::mutex s_registryMutex;
+std::map<std::string, std::weak_ptr<SpeechCache>> s_registry;
+
+//------------------------------------------------------------------------
+// mkdir -p for the file's directory
+void createParentDirectories(const std::string& path) {
+    for (size_t i = 1; i < path.size(); ++i) {
+        if (path[i] != '/' && path[i] != '\\') {
+            continue;
+        }
+        const std::string directory = path.substr(0, i);
+#ifdef _WIN32
+        _mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(), 0755);
+#endif
+    }
+}
+
+//------------------------------------------------------------------------
+// True when a record header with 'available' mapped bytes from its start
+// describes a record that lies inside it and whose samples, text and voice
+// fit in the record. Sizes are summed in 64 bits so hostile lengths can't wrap.
+bool recordFits(const SpeechCacheRecord* record, size_t available) {
+    if (record->magic != SpeechCacheRecord::kMagic || record->size % 4 != 0 ||
+        record->size < sizeof(SpeechCacheRecord) || record->size > available) {
+        return false;
+    }
+    const uint64_t payload = static_cast<uint64_t>(record->sampleCount) * sizeof(int16_t) +
+                             record->textLength + record->voiceLength;
+    return payload <= record->size - sizeof(SpeechCacheRecord);
+}
+
+//------------------------------------------------------------------------
+// Replace the file at path with an empty cache. The new file is written
+// under a per-process name and renamed over the old one, so processes
+// that still map the old file keep a valid snapshot (truncating it in
+// place would fault their reads).
+bool writeEmptyCache(const std::string& path) {
+#ifdef _WIN32
+    const std::string tempPath = path + "." + std::to_string(_getpid()) + ".tmp";
+#else
+    const std::string tempPath = path + "." + std::to_string(getpid()) + ".tmp";
+#endif
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const uint32_t header[2] = { SpeechCacheRecord::kFileMagic, SpeechCacheRecord::kVersion };
+    const bool written = std::fwrite(header, sizeof(header), 1, file) == 1;
+    if (std::fclose(file) != 0 || !written) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    // Fails while another process has the old file mapped; the cache is then off this session
+    const bool renamed = MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    const bool renamed = std::rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+    if (!renamed) {
+        std::remove(tempPath.c_str());
+    }
+    return renamed;
+}
+
+//------------------------------------------------------------------------
+size_t paddedSize(size_t size) {
+    return (size + 3) & ~static_cast<size_t>(3);
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+std::string SpeechCache::getDefaultPath() {
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    return base && *base ? std::string(base) + "\\FT-Vox\\speech.ftcache" : std::string();
+#elif defined(__APPLE__)
+    const char* home = std::getenv("HOME");
+    return home && *home ? std::string(home) + "/Library/Caches/FT-Vox/speech.ftcache" : std::string();
+#else
+    const char* base = std::getenv("XDG_CACHE_HOME");
+    if (base && *base) {
+        return std::string(base) + "/ftvox/speech.ftcache";
+    }
+    const char* home = std::getenv("HOME");
+    return home && *home ? std::string(home) + "/.cache/ftvox/speech.ftcache" : std::string();
+#endif
+}
+
+//------------------------------------------------------------------------
+std::shared_ptr<SpeechCache> SpeechCache::acquire(const std::string& path, std::string& error) {
+    if (path.empty()) {
+        error = "No cache path";
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    for (auto it = s_registry.begin(); it != s_registry.end();) {
+        it = it->second.expired() ? s_registry.erase(it) : std::next(it);
+    }
+    auto it = s_registry.find(path);
+    if (it != s_registry.end()) {
+        return it->second.lock();
+    }
+
+    std::shared_ptr<SpeechCache> cache(new SpeechCache());
+    if (!cache->open(path, error)) {
+        return nullptr;
+    }
+    s_registry[path] = cache;
+    return cache;
+}
+
+//------------------------------------------------------------------------
+SpeechCache::~SpeechCache() {
+    if (append_) {
+        std::fclose(append_);
+    }
+    mapped_.close();
+}
+
+//------------------------------------------------------------------------
+bool SpeechCache::open(const std::string& path, std::string& error) {
+    path_ = path;
+    createParentDirectories(path);
+
+    // A missing file, or one from another version, starts over
+    bool valid = false;
+    if (mapped_.open(path, true) && mapped_.getSize() >= 2 * sizeof(uint32_t)) {
+        uint32_t header[2];
+        std::memcpy(header, mapped_.getData(), sizeof(header));
+        valid = header[0] == SpeechCacheRecord::kFileMagic && header[1] == SpeechCacheRecord::kVersion;
+    }
+    if (!valid) {
+        mapped_.close();
+        if (!writeEmptyCache(path)) {
+            error = "Failed to create speech cache: " + path;
+            return false;
+        }
+        fileSize_ = 2 * sizeof(uint32_t);
+    } else {
+        fileSize_ = mapped_.getSize();
+        scan();
+    }
+
+    // Unbuffered, so each record is one write and concurrent writers
+    // (other processes) don't interleave within a record
+    append_ = std::fopen(path.c_str(), "ab");
+    if (!append_) {
+        error = "Failed to open speech cache for writing: " + path;
+        return false;
+    }
+    std::setvbuf(append_, nullptr, _IONBF, 0);
+    return true;
+}
+
+//------------------------------------------------------------------------
+void SpeechCache::scan() {
+    const uint8_t* data = mapped_.getData();
+    const size_t size = mapped_.getSize();
+
+    // Headers only; payloads are checked when first read
+    size_t offset = 2 * sizeof(uint32_t);
+    while (offset + sizeof(SpeechCacheRecord) <= size) {
+        const auto* record = reinterpret_cast<const SpeechCacheRecord*>(data + offset);
+        if (!recordFits(record, size - offset)) {
+            offset += 4;    // Resynchronize on the next record
+            continue;
+        }
+
+        const char* text = reinterpret_cast<const char*>(record + 1) + record->sampleCount * sizeof(int16_t);
+        SpeechCacheKey key;
+        key.text.assign(text, record->textLength);
+        key.voice.assign(text + record->textLength, record->voiceLength);
+        key.rate = record->rate;
+        key.pitch = record->pitch;
+        key.volume = record->volume;
+        key.sampleRate = record->sampleRate;
+        mappedIndex_[key].record = record;
+        offset += record->size;
+    }
+}
+
+//------------------------------------------------------------------------
+uint32_t SpeechCache::checksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------
+bool SpeechCache::find(const SpeechCacheKey& key, std::vector<float>& samples) {
+    constexpr float kScale = 1.0f / 32768.0f;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto added = added_.find(key);
+    if (added != added_.end()) {
+        samples.resize(added->second.size());
+        for (size_t i = 0; i < samples.size(); ++i) {
+            samples[i] = added->second[i] * kScale;
+        }
+        return true;
+    }
+
+    auto it = mappedIndex_.find(key);
+    if (it == mappedIndex_.end()) {
+        return false;
+    }
+    const SpeechCacheRecord* record = it->second.record;
+    const auto* payload = reinterpret_cast<const uint8_t*>(record + 1);
+    if (!it->second.verified) {
+        const size_t offset = reinterpret_cast<const uint8_t*>(record) - mapped_.getData();
+        if (offset >= mapped_.getSize() || !recordFits(record, mapped_.getSize() - offset)) {
+            mappedIndex_.erase(it);
+            return false;
+        }
+        if (checksum(payload, record->size - sizeof(SpeechCacheRecord)) != record->checksum) {
+            mappedIndex_.erase(it);     // Torn write: re-rendered and appended again
+            return false;
+        }
+        it->second.verified = true;
+    }
+
+    samples.resize(record->sampleCount);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        int16_t sample;
+        std::memcpy(&sample, payload + i * sizeof(int16_t), sizeof(sample));
+        samples[i] = sample * kScale;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool SpeechCache::contains(const SpeechCacheKey& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return added_.count(key) != 0 || mappedIndex_.count(key) != 0;
+}
+
+//------------------------------------------------------------------------
+void SpeechCache::insert(const SpeechCacheKey& key, const std::vector<float>& samples) {
+    if (samples.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (added_.count(key) != 0 || mappedIndex_.count(key) != 0) {
+        return;
+    }
+
+    // Back to eSpeak's 16-bit PCM (exact for its output)
+    std::vector<int16_t> pcm(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const long value = std::lround(samples[i] * 32768.0f);
+        pcm[i] = static_cast<int16_t>((std::max)(-32768L, (std::min)(32767L, value)));
+    }
+
+    const size_t samplesBytes = pcm.size() * sizeof(int16_t);
+    const size_t payloadBytes = samplesBytes + key.text.size() + key.voice.size();
+    const size_t recordBytes = sizeof(SpeechCacheRecord) + paddedSize(payloadBytes);
+    if (append_ && fileSize_ + recordBytes <= maxBytes_) {
+        std::vector<uint8_t> bytes(recordBytes, 0);
+        uint8_t* payload = bytes.data() + sizeof(SpeechCacheRecord);
+        std::memcpy(payload, pcm.data(), samplesBytes);
+        std::memcpy(payload + samplesBytes, key.text.data(), key.text.size());
+        std::memcpy(payload + samplesBytes + key.text.size(), key.voice.data(), key.voice.size());
+
+        SpeechCacheRecord record{};
+        record.magic = SpeechCacheRecord::kMagic;
+        record.size = static_cast<uint32_t>(recordBytes);
+        record.checksum = checksum(payload, recordBytes - sizeof(SpeechCacheRecord));
+        record.rate = key.rate;
+        record.pitch = key.pitch;
+        record.volume = key.volume;
+        record.sampleRate = key.sampleRate;
+        record.sampleCount = static_cast<uint32_t>(pcm.size());
+        record.textLength = static_cast<uint32_t>(key.text.size());
+        record.voiceLength = static_cast<uint32_t>(key.voice.size());
+        std::memcpy(bytes.data(), &record, sizeof(record));
+
+        if (std::fwrite(bytes.data(), bytes.size(), 1, append_) == 1) {
+            fileSize_ += recordBytes;
+        }
+    }
+    added_.emplace(key, std::move(pcm));
+}
+
+//------------------------------------------------------------------------
+size_t SpeechCache::getEntryCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mappedIndex_.size() + added_.size();
+}
+
+//------------------------------------------------------------------------
+size_t SpeechCache::getFileSize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fileSize_;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "MappingBinary.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// SpeechCacheKey - everything eSpeak's output depends on
+//------------------------------------------------------------------------
+struct SpeechCacheKey {
+    std::string text;
+    std::string voice;
+    int rate = 0;
+    int pitch = 0;
+    int volume = 0;
+    int sampleRate = 0;     // eSpeak's output rate
+
+    bool operator<(const SpeechCacheKey& other) const {
+        return std::tie(text, voice, rate, pitch, volume, sampleRate) <
+               std::tie(other.text, other.voice, other.rate, other.pitch, other.volume, other.sampleRate);
+    }
+};
+
+//------------------------------------------------------------------------
+// SpeechCacheRecord - one utterance in the cache file
+// Followed by sampleCount int16 samples (eSpeak's raw PCM), the text and
+// the voice name, padded to 4 bytes. The file starts with kFileMagic and
+// kVersion; records are only ever appended.
+//------------------------------------------------------------------------
+struct SpeechCacheRecord {
+    static constexpr uint32_t kFileMagic = 0x43535446;  // "FTSC"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kMagic = 0x52535446;      // "FTSR"
+
+    uint32_t magic;
+    uint32_t size;          // Whole record in bytes, a multiple of 4
+    uint32_t checksum;      // FNV-1a of the bytes after this header
+    int32_t rate;
+    int32_t pitch;
+    int32_t volume;
+    int32_t sampleRate;
+    uint32_t sampleCount;
+    uint32_t textLength;
+    uint32_t voiceLength;
+};
+
+//------------------------------------------------------------------------
+// SpeechCache - eSpeak output persisted between sessions
+// The cache file is memory-mapped when opened, and only its record
+// headers are scanned, so a project opens with every syllable it spoke
+// before already available. New utterances are appended and stay in
+// memory until the next open. Records are checksummed when first read;
+// torn or foreign bytes are skipped. One cache per file is shared by all
+// instances in the process (thread-safe). Delete the file to reset it,
+// e.g. after updating eSpeak's voice data.
+//------------------------------------------------------------------------
+class SpeechCache {
+public:
+    static constexpr size_t kDefaultMaxBytes = 256 * 1024 * 1024;
+
+    // <user cache dir>/FT-Vox/speech.ftcache ("" if there is none)
+    static std::string getDefaultPath();
+
+    // The cache for path, opened (and created) on first use; nullptr and
+    // error set if the file can't be used
+    static std::shared_ptr<SpeechCache> acquire(const std::string& path, std::string& error);
+
+    ~SpeechCache();
+
+    SpeechCache(const SpeechCache&) = delete;
+    SpeechCache& operator=(const SpeechCache&) = delete;
+
+    // Cached samples for key (as eSpeak floats); false on miss
+    bool find(const SpeechCacheKey& key, std::vector<float>& samples);
+    bool contains(const SpeechCacheKey& key);
+
+    // Store an utterance (ignored once the file reaches its size budget)
+    void insert(const SpeechCacheKey& key, const std::vector<float>& samples);
+
+    const std::string& getPath() const { return path_; }
+    size_t getEntryCount();
+    size_t getFileSize();
+
+private:
+    struct MappedEntry {
+        const SpeechCacheRecord* record = nullptr;
+        bool verified = false;
+    };
+
+    SpeechCache() = default;
+
+    bool open(const std::string& path, std::string& error);
+    void scan();
+    static uint32_t checksum(const uint8_t* data, size_t size);
+
+    std::string path_;
+    MappedFile mapped_;             // Snapshot at open
+    std::FILE* append_ = nullptr;
+    size_t fileSize_ = 0;
+    size_t maxBytes_ = kDefaultMaxBytes;
+
+    std::mutex mutex_;              // Guards the indexes and appends
+    std::map<SpeechCacheKey, MappedEntry> mappedIndex_;
+    std::map<SpeechCacheKey, std::vector<int16_t>> added_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+//------------------------------------------------------------------------
+void ThreadPool::start(size_t threadCount) {
+    if (isRunning()) {
+        return;
+    }
+
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) {
+            threadCount = 2;
+        }
+    }
+
+    stopping_ = false;
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+//------------------------------------------------------------------------
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        tasks_.clear();
+    }
+    condition_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+//------------------------------------------------------------------------
+void ThreadPool::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+//------------------------------------------------------------------------
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& body) {
+    if (count <= 0) {
+        return;
+    }
+
+    const size_t helpers = (std::min)(workers_.size(), static_cast<size_t>(count - 1));
+    if (helpers == 0) {
+        for (int i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    // Shared with the helpers, which may start after this call has returned
+    struct Loop {
+        std::atomic<int> next{0};
+        std::atomic<int> active{0};   // Helpers that may still claim an index
+        int count = 0;
+        const std::function<void(int)>* body = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto loop = std::make_shared<Loop>();
+    loop->count = count;
+    loop->body = &body;
+
+    // body is only touched after claiming an index below count
+    auto work = [](Loop& state) {
+        for (int i = state.next.fetch_add(1); i < state.count; i = state.next.fetch_add(1)) {
+            (*state.body)(i);
+        }
+    };
+
+    for (size_t h = 0; h < helpers; ++h) {
+        post([loop, work]() {
+            loop->active.fetch_add(1);
+            work(*loop);
+            if (loop->active.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                loop->finished.notify_all();
+            }
+        });
+    }
+
+    work(*loop);
+
+    // Range exhausted: wait for iterations still running on helpers
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->finished.wait(lock, [&loop] { return loop->active.load() == 0; });
+}
+
+//------------------------------------------------------------------------
+void ThreadPool::cancelPending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.clear();
+}
+
+//------------------------------------------------------------------------
+size_t ThreadPool::getPendingCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+//------------------------------------------------------------------------
+void ThreadPool::run() {
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
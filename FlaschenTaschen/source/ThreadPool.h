@@ -0,0 +1,68 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// ThreadPool - fixed set of worker threads draining a shared task queue
+// Used for bulk offline work (pre-baking renders). Not realtime-safe:
+// post() locks and allocates.
+//------------------------------------------------------------------------
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    ThreadPool() = default;
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Start threadCount workers (0 = one per hardware thread)
+    void start(size_t threadCount = 0);
+
+    // Stop all workers; tasks not yet started are dropped
+    void stop();
+
+    // Check if running
+    bool isRunning() const { return !workers_.empty(); }
+    size_t getThreadCount() const { return workers_.size(); }
+
+    // Queue a task
+    void post(Task task);
+
+    // Run body(i) for every i in [0, count) on the workers and the calling
+    // thread, returning when all iterations are done. The caller works
+    // through the range itself and only waits for iterations already
+    // running, so this may be called from a worker and still finishes when
+    // the pool is busy, stopped or cancelPending() drops the helpers.
+    void parallelFor(int count, const std::function<void(int)>& body);
+
+    // Drop queued tasks that have not started yet
+    void cancelPending();
+
+    // Number of tasks waiting for a worker
+    size_t getPendingCount();
+
+private:
+    void run();
+
+    std::vector<std::thread> workers_;
+    std::deque<Task> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_ = false;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
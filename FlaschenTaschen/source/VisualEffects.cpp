@@ -3,8 +3,11 @@
 //------------------------------------------------------------------------
 
 #include "VisualEffects.h"
+#include "PixelKernels.h"
 #include <cmath>
+#include <cstring>
 #include <algorithm>
+#include <vector>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -144,11 +147,34 @@ void PolyLightOrgan::render(FlaschenTaschenClient& client) {
         }
 
         // Draw vertical line for this key
-        for (int x = startX; x < endX; ++x) {
-            for (int y = 0; y < height; ++y) {
-                client.setPixel(x, y, c);
-            }
+        client.fillRect(startX, 0, endX - startX, height, c);
+    }
+}
+
+//------------------------------------------------------------------------
+void PolyLightOrgan::renderLevels(FlaschenTaschenClient& client, const float* levels, int count) const {
+    int width = client.getWidth();
+    int height = client.getHeight();
+    client.clear(Color::Black());
+    if (count <= 0) return;
+
+    for (int i = 0; i < count; ++i) {
+        if (levels[i] <= 0.0f) continue;
+
+        int startX = i * width / count;
+        int endX = (std::max)(startX + 1, (i + 1) * width / count);
+
+        Color c;
+        if (rainbowMode_) {
+            c = hsvToRgb(static_cast<float>(i) / count, 1.0f, levels[i]);
+        } else {
+            c = Color(
+                static_cast<uint8_t>(baseR_ * levels[i]),
+                static_cast<uint8_t>(baseG_ * levels[i]),
+                static_cast<uint8_t>(baseB_ * levels[i])
+            );
         }
+        client.fillRect(startX, 0, endX - startX, height, c);
     }
 }
 
@@ -168,29 +194,120 @@ void PolyLightOrgan::allNotesOff() {
     }
 }
 
+//------------------------------------------------------------------------
+// SparkleSchedule implementation
+//------------------------------------------------------------------------
+void SparkleSchedule::generateStep(uint32_t seed, int step, int pixelCount, int count, uint32_t* out) {
+    EffectRng rng(seed ^ EffectRng::mix(static_cast<uint32_t>(step)));
+    for (int i = 0; i < count; ++i) {
+        uint32_t pixel = rng.nextBelow(static_cast<uint32_t>(pixelCount));
+        uint32_t level = 128 + rng.nextBelow(128);
+        out[i] = pixel | (level << 24);
+    }
+}
+
+//------------------------------------------------------------------------
+bool SparkleSchedule::build(uint32_t seed, int width, int height, int count, int durationMs) {
+    if (matches(seed, width, height, count, durationMs)) {
+        return steps_ > 0;
+    }
+    seed_ = seed;
+    width_ = width;
+    height_ = height;
+    count_ = count;
+    durationMs_ = durationMs;
+    steps_ = 0;
+    entries_.clear();
+
+    const int steps = stepAt((std::max)(0, durationMs - 1)) + 1;
+    if (count <= 0 || static_cast<size_t>(steps) * count > kMaxEntries) {
+        return false;
+    }
+    entries_.resize(static_cast<size_t>(steps) * count);
+    for (int s = 0; s < steps; ++s) {
+        generateStep(seed, s, width * height, count, entries_.data() + static_cast<size_t>(s) * count);
+    }
+    steps_ = steps;
+    return true;
+}
+
+//------------------------------------------------------------------------
+const uint32_t* SparkleSchedule::getStep(int step) const {
+    if (step < 0 || step >= steps_) {
+        return nullptr;
+    }
+    return entries_.data() + static_cast<size_t>(step) * count_;
+}
+
 //------------------------------------------------------------------------
 // VisualEffects implementation
 //------------------------------------------------------------------------
-VisualEffects::VisualEffects()
-    : rng_(std::random_device{}())
-{
+VisualEffects::VisualEffects() = default;
+
+//------------------------------------------------------------------------
+double VisualEffects::clockMs() {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 //------------------------------------------------------------------------
 void VisualEffects::startEffect(const Effect& effect) {
-    currentEffect_ = effect;
-    isPlaying_ = true;
-    brightness_ = 1.0f;  // Default full brightness
-    startTime_ = std::chrono::steady_clock::now();
+    startEffectAt(effect, 127, clockMs());  // Default full brightness
 }
 
 //------------------------------------------------------------------------
 void VisualEffects::startEffect(const Effect& effect, int velocity) {
+    startEffectAt(effect, velocity, clockMs());
+}
+
+//------------------------------------------------------------------------
+void VisualEffects::startEffectAt(const Effect& effect, int velocity, double timeMs) {
     currentEffect_ = effect;
     isPlaying_ = true;
     // Map velocity (0-127) to brightness (0.0-1.0)
     brightness_ = static_cast<float>(velocity) / 127.0f;
-    startTime_ = std::chrono::steady_clock::now();
+    startMs_ = timeMs;
+    elapsedMs_ = 0;
+    seed_ = effect.seed ? effect.seed : EffectRng::mix(static_cast<uint32_t>(effect.id) + 1);
+    cachedSequence_ = frameCache_ ? frameCache_->find(effect) : nullptr;
+    cachedFrame_ = -1;
+
+    // A clip without a duration plays once
+    clip_ = effect.type == EffectType::Clip ? getClip(effect.file) : nullptr;
+    if (clip_ && currentEffect_.durationMs <= 0) {
+        currentEffect_.durationMs = clip_->getDurationMs();
+    }
+}
+
+//------------------------------------------------------------------------
+bool VisualEffects::loadClips(const std::vector<Effect>& effects) {
+    bool ok = true;
+    for (const Effect& effect : effects) {
+        if (effect.type == EffectType::Clip && !getClip(effect.file)) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+//------------------------------------------------------------------------
+EffectClip* VisualEffects::getClip(const std::string& file) {
+    auto it = clips_.find(file);
+    if (it == clips_.end()) {
+        auto clip = std::make_unique<EffectClip>();
+        if (!clip->open(file)) {
+            lastError_ = clip->getLastError();
+        }
+        it = clips_.emplace(file, std::move(clip)).first;   // A failed open isn't retried
+    }
+    return it->second->isOpen() ? it->second.get() : nullptr;
+}
+
+//------------------------------------------------------------------------
+void VisualEffects::setFrameCache(std::shared_ptr<const EffectFrameCache> cache) {
+    frameCache_ = std::move(cache);
+    cachedSequence_ = nullptr;
+    cachedFrame_ = -1;
 }
 
 //------------------------------------------------------------------------
@@ -214,18 +331,21 @@ void VisualEffects::stopEffect() {
 
 //------------------------------------------------------------------------
 int VisualEffects::getElapsedMs() const {
-    if (!isPlaying_) return 0;
-    auto now = std::chrono::steady_clock::now();
-    return static_cast<int>(
-        std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime_).count()
-    );
+    return isPlaying_ ? elapsedMs_ : 0;
 }
 
 //------------------------------------------------------------------------
 bool VisualEffects::update(FlaschenTaschenClient& client) {
+    return updateAt(client, clockMs());
+}
+
+//------------------------------------------------------------------------
+bool VisualEffects::updateAt(FlaschenTaschenClient& client, double timeMs) {
     if (!isPlaying_) return false;
 
-    int elapsed = getElapsedMs();
+    // A frame rendered before the scheduled start shows the first frame
+    elapsedMs_ = static_cast<int>((std::max)(0.0, timeMs - startMs_));
+    int elapsed = elapsedMs_;
 
     // Check if effect has finished
     if (elapsed >= currentEffect_.durationMs) {
@@ -233,6 +353,12 @@ bool VisualEffects::update(FlaschenTaschenClient& client) {
         return false;
     }
 
+    if (cachedSequence_ && client.getWidth() == frameCache_->getWidth() &&
+        client.getHeight() == frameCache_->getHeight()) {
+        renderCachedFrame(client);
+        return true;
+    }
+
     // Calculate normalized time (0.0 - 1.0)
     float t = static_cast<float>(elapsed) / currentEffect_.durationMs;
 
@@ -280,6 +406,10 @@ bool VisualEffects::update(FlaschenTaschenClient& client) {
             renderSparkle(client, t);
             break;
 
+        case EffectType::Clip:
+            renderClip(client);
+            break;
+
         default:
             break;
     }
@@ -294,15 +424,21 @@ void VisualEffects::renderSolidColor(FlaschenTaschenClient& client,
 }
 
 //------------------------------------------------------------------------
-void VisualEffects::renderColorRamp(FlaschenTaschenClient& client,
-                                     uint8_t r1, uint8_t g1, uint8_t b1,
-                                     uint8_t r2, uint8_t g2, uint8_t b2,
-                                     RampDirection direction) {
-    int width = client.getWidth();
-    int height = client.getHeight();
-    Color c1(r1, g1, b1);
-    Color c2(r2, g2, b2);
+// EffectTables implementation
+//------------------------------------------------------------------------
+const float* EffectTables::getRampFactors(int width, int height, RampDirection direction) {
+    if (width == rampWidth_ && height == rampHeight_ && direction == rampDirection_ &&
+        !rampFactors_.empty()) {
+        return rampFactors_.data();
+    }
+
+    rampWidth_ = width;
+    rampHeight_ = height;
+    rampDirection_ = direction;
+    rampFactors_.resize(static_cast<size_t>((std::max)(0, width)) * (std::max)(0, height));
+    resizeRows(width);
 
+    float* factor = rampFactors_.data();
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
             float t = 0.0f;
@@ -336,101 +472,154 @@ void VisualEffects::renderColorRamp(FlaschenTaschenClient& client,
                 }
             }
 
-            Color c = lerpColor(c1, c2, t);
-            client.setPixel(x, y, c);
+            *factor++ = t;
         }
     }
+
+    return rampFactors_.data();
 }
 
 //------------------------------------------------------------------------
-void VisualEffects::renderRainbow(FlaschenTaschenClient& client, float phase) {
-    int width = client.getWidth();
-    int height = client.getHeight();
+const float* EffectTables::getColumnFractions(int width) {
+    if (width == columnWidth_ && !columnFractions_.empty()) {
+        return columnFractions_.data();
+    }
 
-    for (int x = 0; x < width; ++x) {
-        float hue = std::fmod(phase + static_cast<float>(x) / width, 1.0f);
-        Color c = hsvToRgb(hue, 1.0f, 1.0f);
+    columnWidth_ = width;
+    columnFractions_.resize(static_cast<size_t>((std::max)(0, width)));
+    resizeRows(width);
 
-        for (int y = 0; y < height; ++y) {
-            client.setPixel(x, y, c);
-        }
+    for (int x = 0; x < width; ++x) {
+        columnFractions_[x] = static_cast<float>(x) / width;
     }
+
+    return columnFractions_.data();
 }
 
 //------------------------------------------------------------------------
-// Non-static versions that apply brightness (for use in update())
+void EffectTables::resizeRows(int width) {
+    const size_t count = static_cast<size_t>((std::max)(0, width));
+    if (floatRow_.size() < count) {
+        floatRow_.resize(count);
+        rgbRow_.resize(count * 3);
+    }
+}
+
 //------------------------------------------------------------------------
-void VisualEffects::renderColorRampWithBrightness(FlaschenTaschenClient& client,
+void VisualEffects::renderColorRamp(FlaschenTaschenClient& client,
                                      uint8_t r1, uint8_t g1, uint8_t b1,
                                      uint8_t r2, uint8_t g2, uint8_t b2,
                                      RampDirection direction) {
+    EffectTables tables;
+    renderRamp(client, tables, Color(r1, g1, b1), Color(r2, g2, b2), direction, 1.0f);
+}
+
+//------------------------------------------------------------------------
+void VisualEffects::renderRainbow(FlaschenTaschenClient& client, float phase) {
+    EffectTables tables;
+    renderRainbowRow(client, tables, phase, 1.0f);
+}
+
+//------------------------------------------------------------------------
+void VisualEffects::renderRamp(FlaschenTaschenClient& client, EffectTables& tables,
+                               const Color& c1, const Color& c2,
+                               RampDirection direction, float brightness) {
     int width = client.getWidth();
     int height = client.getHeight();
-    Color c1(r1, g1, b1);
-    Color c2(r2, g2, b2);
+    const float* factors = tables.getRampFactors(width, height, direction);
+    uint8_t* rowBuffer = tables.getRgbRow();
 
     for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            float t = 0.0f;
+        PixelKernels::lerpRow(rowBuffer, factors + static_cast<size_t>(y) * width, width,
+                              c1, c2, brightness);
+        client.blitRow(0, y, rowBuffer, width);
+    }
+}
 
-            switch (direction) {
-                case RampDirection::Horizontal:
-                    t = static_cast<float>(x) / (width - 1);
-                    break;
+//------------------------------------------------------------------------
+void VisualEffects::renderRainbowRow(FlaschenTaschenClient& client, EffectTables& tables,
+                                     float phase, float brightness) {
+    int width = client.getWidth();
+    const float* fractions = tables.getColumnFractions(width);
+    float* hues = tables.getFloatRow();
+    uint8_t* rowBuffer = tables.getRgbRow();
 
-                case RampDirection::Vertical:
-                    t = static_cast<float>(y) / (height - 1);
-                    break;
+    // |phase| < 1, so the wrap is one exact subtraction (same as fmod)
+    for (int x = 0; x < width; ++x) {
+        float hue = phase + fractions[x];
+        hues[x] = hue >= 1.0f ? hue - 1.0f : hue;
+    }
 
-                case RampDirection::DiagonalDown:
-                    t = static_cast<float>(x + y) / (width + height - 2);
-                    break;
+    PixelKernels::hsvRow(rowBuffer, hues, width, 1.0f, 1.0f);
+    if (brightness != 1.0f) {
+        PixelKernels::scaleRow(rowBuffer, width, brightness);
+    }
+    blitAllRows(client, rowBuffer);
+}
 
-                case RampDirection::DiagonalUp:
-                    t = static_cast<float>(x + (height - 1 - y)) / (width + height - 2);
-                    break;
+//------------------------------------------------------------------------
+void VisualEffects::blitAllRows(FlaschenTaschenClient& client, const uint8_t* rgb) {
+    int width = client.getWidth();
+    int height = client.getHeight();
+    if (height <= 0) return;
 
-                case RampDirection::Radial: {
-                    float cx = width / 2.0f;
-                    float cy = height / 2.0f;
-                    float maxDist = std::sqrt(cx * cx + cy * cy);
-                    float dx = x - cx;
-                    float dy = y - cy;
-                    float dist = std::sqrt(dx * dx + dy * dy);
-                    t = dist / maxDist;
-                    break;
-                }
-            }
+    // Flip is applied once by blitRow, the rest are plain row copies
+    client.blitRow(0, 0, rgb, width);
+    client.repeatFirstRow();
+}
 
-            Color c = applyBrightness(lerpColor(c1, c2, t));
-            client.setPixel(x, y, c);
-        }
-    }
+//------------------------------------------------------------------------
+// Non-static versions that apply brightness (for use in update())
+//------------------------------------------------------------------------
+void VisualEffects::renderColorRampWithBrightness(FlaschenTaschenClient& client,
+                                     uint8_t r1, uint8_t g1, uint8_t b1,
+                                     uint8_t r2, uint8_t g2, uint8_t b2,
+                                     RampDirection direction) {
+    renderRamp(client, tables_, Color(r1, g1, b1), Color(r2, g2, b2), direction, brightness_);
 }
 
 //------------------------------------------------------------------------
 void VisualEffects::renderAnimatedRainbowWithBrightness(FlaschenTaschenClient& client, float t) {
     float speed = currentEffect_.speed / 50.0f;
-    int elapsed = getElapsedMs();
+    int elapsed = elapsedMs_;
     float phase = std::fmod(elapsed * speed * 0.001f, 1.0f);
 
-    int width = client.getWidth();
-    int height = client.getHeight();
+    renderRainbowRow(client, tables_, phase, brightness_);
+}
 
-    for (int x = 0; x < width; ++x) {
-        float hue = std::fmod(phase + static_cast<float>(x) / width, 1.0f);
-        Color c = applyBrightness(hsvToRgb(hue, 1.0f, 1.0f));
+//------------------------------------------------------------------------
+void VisualEffects::renderCachedFrame(FlaschenTaschenClient& client) {
+    const int width = client.getWidth();
+    const int height = client.getHeight();
+    const size_t stride = static_cast<size_t>(width) * 3;
+    const int frame = (std::min)(frameCache_->frameAt(elapsedMs_), cachedSequence_->frameCount - 1);
 
-        for (int y = 0; y < height; ++y) {
-            client.setPixel(x, y, c);
+    // Frames are deltas: decode forward, from black after a jump back
+    if (frame < cachedFrame_ || cachedFrame_ < 0) {
+        cachedPixels_.assign(stride * height, 0);
+        cachedFrame_ = -1;
+    }
+    while (cachedFrame_ < frame) {
+        frameCache_->decodeFrame(*cachedSequence_, ++cachedFrame_, cachedPixels_.data());
+    }
+
+    // Rendered at full brightness; scaled like applyBrightness() otherwise
+    scaledRow_.resize(stride);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = cachedPixels_.data() + y * stride;
+        if (brightness_ < 1.0f) {
+            std::memcpy(scaledRow_.data(), row, stride);
+            PixelKernels::scaleRow(scaledRow_.data(), width, brightness_);
+            row = scaledRow_.data();
         }
+        client.blitRow(0, y, row, width);
     }
 }
 
 //------------------------------------------------------------------------
 void VisualEffects::renderPulse(FlaschenTaschenClient& client, float t) {
     // Pulse uses sine wave for smooth fade in/out
-    int elapsed = getElapsedMs();
+    int elapsed = elapsedMs_;
     float periodSec = currentEffect_.periodMs / 1000.0f;
     float phase = std::fmod(elapsed / 1000.0f, periodSec) / periodSec;
     float pulseBrightness = 0.5f + 0.5f * std::sin(phase * 2.0f * static_cast<float>(M_PI));
@@ -459,7 +648,7 @@ void VisualEffects::renderFlash(FlaschenTaschenClient& client, float t) {
 
 //------------------------------------------------------------------------
 void VisualEffects::renderStrobe(FlaschenTaschenClient& client, float t) {
-    int elapsed = getElapsedMs();
+    int elapsed = elapsedMs_;
     int periodMs = currentEffect_.periodMs;
     bool on = ((elapsed / periodMs) % 2) == 0;
 
@@ -481,8 +670,7 @@ void VisualEffects::renderStrobe(FlaschenTaschenClient& client, float t) {
 //------------------------------------------------------------------------
 void VisualEffects::renderWave(FlaschenTaschenClient& client, float t) {
     int width = client.getWidth();
-    int height = client.getHeight();
-    int elapsed = getElapsedMs();
+    int elapsed = elapsedMs_;
 
     float speed = currentEffect_.speed / 50.0f;  // Normalize speed
     float wavePhase = elapsed * speed * 0.01f;
@@ -490,16 +678,16 @@ void VisualEffects::renderWave(FlaschenTaschenClient& client, float t) {
     Color c1(currentEffect_.color1R, currentEffect_.color1G, currentEffect_.color1B);
     Color c2(currentEffect_.color2R, currentEffect_.color2G, currentEffect_.color2B);
 
+    const float* fractions = tables_.getColumnFractions(width);
+    float* waveT = tables_.getFloatRow();
+    uint8_t* rowBuffer = tables_.getRgbRow();
     for (int x = 0; x < width; ++x) {
-        float xPhase = static_cast<float>(x) / width * 2.0f * static_cast<float>(M_PI);
-        float wave = 0.5f + 0.5f * std::sin(xPhase + wavePhase);
-
-        Color c = applyBrightness(lerpColor(c1, c2, wave));
-
-        for (int y = 0; y < height; ++y) {
-            client.setPixel(x, y, c);
-        }
+        float xPhase = fractions[x] * 2.0f * static_cast<float>(M_PI);
+        waveT[x] = 0.5f + 0.5f * std::sin(xPhase + wavePhase);
     }
+
+    PixelKernels::lerpRow(rowBuffer, waveT, width, c1, c2, brightness_);
+    blitAllRows(client, rowBuffer);
 }
 
 //------------------------------------------------------------------------
@@ -514,31 +702,82 @@ void VisualEffects::renderSparkle(FlaschenTaschenClient& client, float t) {
         currentEffect_.color2B
     )));
 
-    // Add random sparkles
-    int numSparkles = static_cast<int>((width * height) * 0.1f * currentEffect_.intensity);
-    std::uniform_int_distribution<int> xDist(0, width - 1);
-    std::uniform_int_distribution<int> yDist(0, height - 1);
-    std::uniform_real_distribution<float> brightDist(0.5f, 1.0f);
+    // This step's sparkles, from the table when there is one
+    int numSparkles = SparkleSchedule::countFor(width, height, currentEffect_.intensity);
+    if (numSparkles <= 0) {
+        return;
+    }
+    int step = SparkleSchedule::stepAt(elapsedMs_);
+    const uint32_t* sparkles = nullptr;
+    if (currentEffect_.precompute &&
+        sparkleSchedule_.build(seed_, width, height, numSparkles, currentEffect_.durationMs)) {
+        sparkles = sparkleSchedule_.getStep(step);
+    }
+    if (!sparkles) {
+        sparkleStep_.resize(numSparkles);
+        SparkleSchedule::generateStep(seed_, step, width * height, numSparkles, sparkleStep_.data());
+        sparkles = sparkleStep_.data();
+    }
 
+    // Level 128-255 is 0.5-1.0 of the color, times the velocity brightness
+    const float scale = brightness_ / 255.0f;
     for (int i = 0; i < numSparkles; ++i) {
-        int x = xDist(rng_);
-        int y = yDist(rng_);
-        float bright = brightDist(rng_) * brightness_;  // Apply velocity brightness
+        int pixel = static_cast<int>(sparkles[i] & 0xFFFFFF);
+        float bright = static_cast<float>(sparkles[i] >> 24) * scale;
 
         uint8_t r = static_cast<uint8_t>(currentEffect_.color1R * bright);
         uint8_t g = static_cast<uint8_t>(currentEffect_.color1G * bright);
         uint8_t b = static_cast<uint8_t>(currentEffect_.color1B * bright);
 
-        client.setPixel(x, y, Color(r, g, b));
+        client.setPixel(pixel % width, pixel / width, Color(r, g, b));
+    }
+}
+
+//------------------------------------------------------------------------
+void VisualEffects::renderClip(FlaschenTaschenClient& client) {
+    const Color background = applyBrightness(Color(
+        currentEffect_.color2R, currentEffect_.color2G, currentEffect_.color2B));
+    const uint8_t* frame = clip_ ? clip_->getFrame(clip_->frameAt(elapsedMs_)) : nullptr;
+    if (!frame) {
+        client.clear(background);
+        return;
+    }
+
+    // Centered; a smaller clip is framed by color2, a larger one cropped
+    const int width = client.getWidth();
+    const int height = client.getHeight();
+    const int clipWidth = clip_->getWidth();
+    const int clipHeight = clip_->getHeight();
+    const int x0 = (width - clipWidth) / 2;
+    const int y0 = (height - clipHeight) / 2;
+    if (clipWidth < width || clipHeight < height) {
+        client.clear(background);
+    }
+
+    // Rows go from the mapping straight into the frame buffer
+    const size_t stride = static_cast<size_t>(clipWidth) * 3;
+    const int firstRow = (std::max)(0, -y0);
+    const int lastRow = (std::min)(clipHeight, height - y0);
+    if (brightness_ < 1.0f) {
+        scaledRow_.resize(stride);
+    }
+    for (int row = firstRow; row < lastRow; ++row) {
+        const uint8_t* rgb = frame + row * stride;
+        if (brightness_ < 1.0f) {
+            std::memcpy(scaledRow_.data(), rgb, stride);
+            PixelKernels::scaleRow(scaledRow_.data(), clipWidth, brightness_);
+            rgb = scaledRow_.data();
+        }
+        client.blitRow(x0, y0 + row, rgb, clipWidth);
     }
 }
 
 //------------------------------------------------------------------------
 void VisualEffects::renderAnimatedRainbow(FlaschenTaschenClient& client, float t) {
     float speed = currentEffect_.speed / 50.0f;
-    int elapsed = getElapsedMs();
+    int elapsed = elapsedMs_;
     float phase = std::fmod(elapsed * speed * 0.001f, 1.0f);
-    renderRainbow(client, phase);
+    renderRainbowRow(client, tables_, phase, 1.0f);
 }
 
 //------------------------------------------------------------------------
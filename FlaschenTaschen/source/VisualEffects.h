@@ -6,9 +6,15 @@
 
 #include "FlaschenTaschenClient.h"
 #include "MappingConfig.h"
+#include "EffectFrameCache.h"
+#include "EffectClip.h"
 #include <chrono>
-#include <random>
+#include <cstdint>
 #include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace FlaschenTaschen {
 
@@ -45,6 +51,10 @@ public:
     // Render to display
     void render(FlaschenTaschenClient& client);
 
+    // Render count levels (0.0 - 1.0, e.g. audio bands) as evenly spaced
+    // columns in the same colors, lowest on the left
+    void renderLevels(FlaschenTaschenClient& client, const float* levels, int count) const;
+
     // Check if any notes are active
     bool hasActiveNotes() const;
 
@@ -68,6 +78,121 @@ private:
     static Color hsvToRgb(float h, float s, float v);
 };
 
+//------------------------------------------------------------------------
+// EffectTables - per-display-size geometry shared by every frame
+// Ramp factors depend only on size and direction, column fractions only on
+// width, so animated frames become lookups. Tables rebuild lazily when the
+// requested geometry differs from the cached one (display reconfigured).
+//------------------------------------------------------------------------
+class EffectTables {
+public:
+    // Interpolation factor per pixel (row-major, width x height)
+    const float* getRampFactors(int width, int height, RampDirection direction);
+
+    // x / width per column (rainbow hue offset, wave phase)
+    const float* getColumnFractions(int width);
+
+    // Scratch rows sized for the current width
+    float* getFloatRow() { return floatRow_.data(); }
+    uint8_t* getRgbRow() { return rgbRow_.data(); }
+
+private:
+    void resizeRows(int width);
+
+    int rampWidth_ = 0;
+    int rampHeight_ = 0;
+    RampDirection rampDirection_ = RampDirection::Horizontal;
+    std::vector<float> rampFactors_;
+
+    int columnWidth_ = 0;
+    std::vector<float> columnFractions_;
+
+    std::vector<float> floatRow_;
+    std::vector<uint8_t> rgbRow_;
+};
+
+//------------------------------------------------------------------------
+// EffectRng - small deterministic generator (xorshift32)
+// A few instructions per draw and the same sequence on every platform,
+// so a seeded effect renders identically every run.
+//------------------------------------------------------------------------
+class EffectRng {
+public:
+    explicit EffectRng(uint32_t seed) : state_(mix(seed)) {}
+
+    uint32_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return state_;
+    }
+
+    // Uniform in [0, n)
+    uint32_t nextBelow(uint32_t n) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(next()) * n) >> 32);
+    }
+
+    // Spread nearby seeds apart (never 0, which xorshift can't leave)
+    static uint32_t mix(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x ? x : 0x9e3779b9u;
+    }
+
+private:
+    uint32_t state_;
+};
+
+//------------------------------------------------------------------------
+// SparkleSchedule - every sparkle of one effect play, generated up front
+// Step s of the pattern is drawn from its own seed, so a frame depends
+// only on the effect's seed and elapsed time, never on how many frames
+// came before. Playing from the table or generating a step on the fly
+// gives the same pixels; the table only skips the generator. Entries
+// pack the pixel index (low 24 bits) and brightness level (high 8).
+//------------------------------------------------------------------------
+class SparkleSchedule {
+public:
+    static constexpr int kStepsPerSecond = 60;          // <Display fps> default
+    static constexpr size_t kMaxEntries = 1 << 20;      // 4 MB; longer plays generate live
+
+    static int stepAt(int elapsedMs) {
+        return static_cast<int>(static_cast<int64_t>(elapsedMs) * kStepsPerSecond / 1000);
+    }
+
+    // Sparkles per step for a display and effect intensity
+    static int countFor(int width, int height, float intensity) {
+        return static_cast<int>((width * height) * 0.1f * intensity);
+    }
+
+    // Draw one step's sparkles into out[0..count)
+    static void generateStep(uint32_t seed, int step, int pixelCount, int count, uint32_t* out);
+
+    // Build the table for a play of durationMs (false if it would be too
+    // large). Returns true at once if it already matches.
+    bool build(uint32_t seed, int width, int height, int count, int durationMs);
+
+    // Entries of a step, nullptr past the table
+    const uint32_t* getStep(int step) const;
+
+    bool matches(uint32_t seed, int width, int height, int count, int durationMs) const {
+        return seed == seed_ && width == width_ && height == height_ &&
+               count == count_ && durationMs == durationMs_;
+    }
+
+private:
+    uint32_t seed_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    int count_ = 0;
+    int durationMs_ = 0;
+    int steps_ = 0;
+    std::vector<uint32_t> entries_;
+};
+
 //------------------------------------------------------------------------
 // VisualEffects - renders visual effects on FlaschenTaschen display
 //------------------------------------------------------------------------
@@ -82,6 +207,9 @@ public:
     // Start playing an effect with initial brightness (0-127 velocity mapped to 0.0-1.0)
     void startEffect(const Effect& effect, int velocity);
 
+    // Start at a time on the caller's own clock (ms), for use with updateAt()
+    void startEffectAt(const Effect& effect, int velocity, double timeMs);
+
     // Stop current effect
     void stopEffect();
 
@@ -96,9 +224,24 @@ public:
     // Returns true if effect is still active, false if finished
     bool update(FlaschenTaschenClient& client);
 
-    // Get elapsed time since effect started (ms)
+    // Same, rendering the frame for timeMs on the startEffectAt() clock
+    bool updateAt(FlaschenTaschenClient& client, double timeMs);
+
+    // Get elapsed time since effect started at the last update (ms)
     int getElapsedMs() const;
 
+    // Play effects found in cache from their pre-rendered frames (when the
+    // display has the cache's size), nullptr = always render
+    void setFrameCache(std::shared_ptr<const EffectFrameCache> cache);
+
+    // Open the files of the Clip effects now rather than on first play
+    // (false and getLastError() if one can't be played)
+    bool loadClips(const std::vector<Effect>& effects);
+    const std::string& getLastError() const { return lastError_; }
+
+    // Wall clock used by startEffect()/update() (ms)
+    static double clockMs();
+
     // Static effect renderers (one-shot, no animation)
     static void renderSolidColor(FlaschenTaschenClient& client,
                                   uint8_t r, uint8_t g, uint8_t b);
@@ -114,8 +257,29 @@ private:
     Effect currentEffect_;
     bool isPlaying_ = false;
     float brightness_ = 1.0f;  // 0.0 - 1.0, controlled by velocity/aftertouch
-    std::chrono::steady_clock::time_point startTime_;
-    std::mt19937 rng_;
+    double startMs_ = 0.0;
+    int elapsedMs_ = 0;
+    uint32_t seed_ = 0;        // Current effect's pattern seed
+    EffectTables tables_;
+    SparkleSchedule sparkleSchedule_;
+    std::vector<uint32_t> sparkleStep_;    // Live generation scratch
+
+    // Pre-rendered playback
+    std::shared_ptr<const EffectFrameCache> frameCache_;
+    const EffectFrameCache::Sequence* cachedSequence_ = nullptr;  // Current effect's frames
+    int cachedFrame_ = -1;                 // Frame decoded into cachedPixels_
+    std::vector<uint8_t> cachedPixels_;
+    std::vector<uint8_t> scaledRow_;       // Brightness-scaled row (cached frames, clips)
+
+    // Clip files by path, opened once
+    std::map<std::string, std::unique_ptr<EffectClip>> clips_;
+    EffectClip* clip_ = nullptr;           // Current Clip effect's file
+    std::string lastError_;
+
+    EffectClip* getClip(const std::string& file);
+
+    // Show the current effect's cached frame for elapsedMs_
+    void renderCachedFrame(FlaschenTaschenClient& client);
 
     // Apply brightness to a color
     Color applyBrightness(const Color& c) const;
@@ -126,6 +290,7 @@ private:
     void renderStrobe(FlaschenTaschenClient& client, float t);
     void renderWave(FlaschenTaschenClient& client, float t);
     void renderSparkle(FlaschenTaschenClient& client, float t);
+    void renderClip(FlaschenTaschenClient& client);
     void renderAnimatedRainbow(FlaschenTaschenClient& client, float t);
 
     // Non-static versions that apply brightness (for use in update())
@@ -135,6 +300,16 @@ private:
                                        RampDirection direction);
     void renderAnimatedRainbowWithBrightness(FlaschenTaschenClient& client, float t);
 
+    // Row kernel based renderers shared by the static and animated paths
+    static void renderRamp(FlaschenTaschenClient& client, EffectTables& tables,
+                           const Color& c1, const Color& c2,
+                           RampDirection direction, float brightness);
+    static void renderRainbowRow(FlaschenTaschenClient& client, EffectTables& tables,
+                                 float phase, float brightness);
+
+    // Copy one packed RGB row to every display row
+    static void blitAllRows(FlaschenTaschenClient& client, const uint8_t* rgb);
+
     // Helper: interpolate between two colors
     static Color lerpColor(const Color& c1, const Color& c2, float t);
 
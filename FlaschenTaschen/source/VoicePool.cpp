@@ -0,0 +1,439 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#include "VoicePool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace FlaschenTaschen {
+
+namespace {
+    // Curves sampled once at startup so the mixer never calls pow/exp
+    struct VoiceCurves {
+        static constexpr int kReleasePoints = 64;
+        std::array<float, 128> velocity;                // Square law (DLS style)
+        std::array<float, kReleasePoints + 2> release;  // Exponential fade, 1 -> 0
+
+        VoiceCurves() {
+            for (int v = 0; v < 128; ++v) {
+                const float x = v / 127.0f;
+                velocity[v] = x * x;
+            }
+            const double k = 5.0;
+            const double floor = std::exp(-k);
+            for (int i = 0; i <= kReleasePoints; ++i) {
+                release[i] = static_cast<float>((std::exp(-k * i / kReleasePoints) - floor) / (1.0 - floor));
+            }
+            release[kReleasePoints + 1] = 0.0f;  // Interpolation guard
+        }
+
+        // position 0-1 through the release
+        float releaseAt(float position) const {
+            const float index = (std::min)(position, 1.0f) * kReleasePoints;
+            const int i = static_cast<int>(index);
+            return release[i] + (release[i + 1] - release[i]) * (index - static_cast<float>(i));
+        }
+    };
+
+    const VoiceCurves kVoiceCurves;
+}
+
+//------------------------------------------------------------------------
+void VoicePool::allocate(size_t samplesPerVoice) {
+    for (auto& voice : voices_) {
+        voice.buffer.allocate(samplesPerVoice);
+        voice.generation.store(0, std::memory_order_relaxed);
+        voice.startedGeneration.store(0, std::memory_order_relaxed);
+        voice.finishedGeneration.store(0, std::memory_order_relaxed);
+        voice.startPos.store(0, std::memory_order_relaxed);
+        voice.active = false;
+        voice.pendingStart = false;
+        voice.note = -1;
+        voice.velocity = 0;
+        voice.startOrder = 0;
+        voice.envelope = 0.0f;
+        voice.gain = 1.0f;
+        voice.gainTarget = 1.0f;
+        voice.pendingGainSample = -1;
+        voice.released = false;
+        voice.releasePos = -1;
+        voice.release = 1.0f;
+        voice.level = 0.0f;
+        voice.startSample = 0;
+        voice.waitingForStart = false;
+    }
+    noteCounter_ = 0;
+}
+
+//------------------------------------------------------------------------
+void VoicePool::setVoiceLimit(int voices) {
+    voiceLimit_ = (std::max)(1, (std::min)(kMaxVoices, voices));
+}
+
+//------------------------------------------------------------------------
+void VoicePool::setVelocityDepth(float depth) {
+    velocityDepth_ = (std::max)(0.0f, (std::min)(1.0f, depth));
+}
+
+//------------------------------------------------------------------------
+void VoicePool::setReleaseSamples(int samples) {
+    releaseSamples_ = (std::max)(0, samples);
+}
+
+//------------------------------------------------------------------------
+VoiceStealMode VoicePool::stealModeFromString(const std::string& str) {
+    if (str == "quietest") return VoiceStealMode::Quietest;
+    if (str == "none") return VoiceStealMode::None;
+    return VoiceStealMode::Oldest;
+}
+
+//------------------------------------------------------------------------
+VoiceHandle VoicePool::noteOn(int note, int velocity, int64_t startSample, int bus) {
+    const int limit = voiceLimit_;
+
+    // Prefer a free voice
+    int chosen = -1;
+    for (int i = 0; i < limit; ++i) {
+        if (!voices_[i].active) {
+            chosen = i;
+            break;
+        }
+    }
+
+    // Otherwise steal one
+    if (chosen < 0) {
+        switch (stealMode_.load()) {
+            case VoiceStealMode::None:
+                return VoiceHandle();
+
+            case VoiceStealMode::Quietest:
+                chosen = 0;
+                for (int i = 1; i < limit; ++i) {
+                    if (voices_[i].level < voices_[chosen].level) {
+                        chosen = i;
+                    }
+                }
+                break;
+
+            case VoiceStealMode::Oldest:
+            default:
+                chosen = 0;
+                for (int i = 1; i < limit; ++i) {
+                    if (voices_[i].startOrder < voices_[chosen].startOrder) {
+                        chosen = i;
+                    }
+                }
+                break;
+        }
+    }
+
+    Voice& voice = voices_[chosen];
+
+    unsigned generation = voice.generation.load(std::memory_order_relaxed) + 1;
+    if (generation == 0) {
+        generation = 1;  // 0 means "never claimed"
+    }
+    voice.generation.store(generation, std::memory_order_release);
+
+    const float velocityGain = 1.0f - velocityDepth_ * (1.0f - kVoiceCurves.velocity[(std::max)(0, (std::min)(127, velocity))]);
+
+    // A stolen voice keeps fading out its old audio (at its old level) until
+    // the new stream starts
+    if (!voice.active) {
+        voice.envelope = 0.0f;
+        voice.gain = velocityGain;
+        voice.gainTarget = velocityGain;
+        voice.releasePos = -1;
+        voice.release = 1.0f;
+        voice.level = 0.0f;
+    }
+    voice.nextBus = bus == kBusByVoice ? chosen : (std::max)(0, bus);
+    if (!voice.active) {
+        voice.bus = voice.nextBus;
+    }
+    voice.velocityGain = velocityGain;
+    voice.pendingGainSample = -1;
+    voice.released = false;
+    voice.active = true;
+    voice.pendingStart = true;
+    voice.note = note;
+    voice.velocity = velocity;
+    voice.startOrder = ++noteCounter_;
+    voice.startSample = startSample;
+    voice.waitingForStart = true;
+    voice.claimMicros = stats_ ? LatencyStats::nowMicros() : 0;
+
+    VoiceHandle handle;
+    handle.index = chosen;
+    handle.generation = generation;
+    return handle;
+}
+
+//------------------------------------------------------------------------
+void VoicePool::noteOff(int note, int64_t releaseSample) {
+    const int length = releaseSamples_;
+    if (length <= 0) {
+        return;
+    }
+
+    for (auto& voice : voices_) {
+        if (voice.active && voice.note == note && !voice.released) {
+            voice.released = true;
+            voice.releaseSample = releaseSample;
+            voice.releaseLength = length;
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+void VoicePool::setPressure(int note, int pressure, int64_t pressureSample) {
+    const float amount = static_cast<float>((std::max)(0, (std::min)(127, pressure))) / 127.0f;
+    for (auto& voice : voices_) {
+        if (voice.active && voice.note == note && !voice.released) {
+            voice.pendingGain = voice.velocityGain + (1.0f - voice.velocityGain) * amount;
+            voice.pendingGainSample = pressureSample;
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+void VoicePool::cancel(const VoiceHandle& handle) {
+    if (!handle.isValid()) {
+        return;
+    }
+
+    Voice& voice = voices_[handle.index];
+    if (voice.generation.load(std::memory_order_relaxed) == handle.generation) {
+        voice.active = false;
+        voice.pendingStart = false;
+        voice.buffer.discard();
+    }
+}
+
+//------------------------------------------------------------------------
+int VoicePool::getActiveVoiceCount() const {
+    int count = 0;
+    for (const auto& voice : voices_) {
+        if (voice.active) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------
+bool VoicePool::isIdle() const {
+    for (const auto& voice : voices_) {
+        if (voice.active) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+template <typename Sample>
+uint32_t VoicePool::mix(Sample* const* outputs, int busCount, int numSamples, int64_t blockStart) {
+    uint32_t sounding = 0;
+    for (auto& voice : voices_) {
+        if (voice.active) {
+            sounding |= mixVoice(voice, outputs, busCount, numSamples, blockStart);
+        }
+    }
+    return sounding;
+}
+
+//------------------------------------------------------------------------
+template <typename Sample>
+uint32_t VoicePool::mixVoice(Voice& voice, Sample* const* outputs, int busCount, int numSamples, int64_t blockStart) {
+    const unsigned generation = voice.generation.load(std::memory_order_relaxed);
+
+    // Snapshot the write position before looking at the stream marker: the
+    // worker publishes the marker before writing the new stream, so anything
+    // up to this snapshot is known to belong to the stream the check below
+    // sees.
+    size_t writeEnd = voice.buffer.getWritePosition();
+
+    if (voice.pendingStart) {
+        const bool started = voice.startedGeneration.load(std::memory_order_acquire) == generation;
+        if (started && voice.startSample - blockStart >= numSamples) {
+            // New stream arrived ahead of its note (look-ahead): the old
+            // tail keeps fading, but must not run into the new stream
+            writeEnd = (std::min)(writeEnd, voice.startPos.load(std::memory_order_relaxed));
+            if (voice.envelope <= 0.0f) {
+                return 0;
+            }
+        } else if (started) {
+            // New stream is here: drop the old tail and fade in at the new
+            // note's level
+            voice.buffer.discardUntil(voice.startPos.load(std::memory_order_relaxed));
+            writeEnd = voice.buffer.getWritePosition();
+            voice.pendingStart = false;
+            voice.bus = voice.nextBus;
+            voice.envelope = 0.0f;
+            voice.gain = voice.velocityGain;
+            voice.gainTarget = voice.velocityGain;
+            voice.releasePos = -1;
+            voice.release = 1.0f;
+        } else if (voice.finishedGeneration.load(std::memory_order_acquire) == generation) {
+            // Job finished without producing audio (e.g. unmapped note)
+            voice.buffer.discard();
+            voice.active = false;
+            voice.pendingStart = false;
+            return 0;
+        } else if (voice.envelope <= 0.0f) {
+            // Old tail faded out, wait silently for the new stream
+            return 0;
+        }
+    }
+
+    // The new stream holds back until the sample its note was played at
+    int startOffset = 0;
+    if (!voice.pendingStart && voice.waitingForStart) {
+        const int64_t delay = voice.startSample - blockStart;
+        if (delay >= numSamples) {
+            return 0;
+        }
+        startOffset = delay > 0 ? static_cast<int>(delay) : 0;
+        voice.waitingForStart = false;
+    }
+
+    // Voice-indexed buses wrap when there are more voices than buses
+    const int bus = outputs[voice.bus % busCount] ? voice.bus % busCount : 0;
+    Sample* output = outputs[bus];
+    float peak = 0.0f;
+    int offset = startOffset;
+    while (offset < numSamples) {
+        const size_t wanted = static_cast<size_t>((std::min)(kMixChunk, numSamples - offset));
+        const size_t got = voice.buffer.readUntil(scratch_.data(), wanted, writeEnd);
+
+        // The gain is a straight line over each short segment, so the inner
+        // loop is a plain multiply-add the compiler can vectorize
+        size_t done = 0;
+        while (done < got) {
+            const int count = static_cast<int>((std::min)(got - done, static_cast<size_t>(kRampSegment)));
+            startScheduledChanges(voice, blockStart + offset + static_cast<int64_t>(done));
+
+            const float startGain = voice.envelope * voice.release * voice.gain;
+            advanceEnvelope(voice, count);
+            const float step = (voice.envelope * voice.release * voice.gain - startGain) / static_cast<float>(count);
+
+            const float* in = scratch_.data() + done;
+            Sample* out = output + offset + done;
+            for (int i = 0; i < count; ++i) {
+                const float sample = in[i] * (startGain + step * static_cast<float>(i + 1));
+                out[i] += static_cast<Sample>(sample);
+                peak = (std::max)(peak, std::fabs(sample));
+            }
+            done += static_cast<size_t>(count);
+        }
+
+        offset += static_cast<int>(got);
+        if (got < wanted) {
+            break;
+        }
+    }
+    voice.level = peak;
+
+    if (voice.claimMicros != 0 && !voice.pendingStart && offset > startOffset) {
+        stats_->recordSince(LatencyStage::FirstSample, voice.claimMicros);
+        voice.claimMicros = 0;
+    }
+
+    // Done once the release has faded out, or the worker has finished and
+    // everything was played. A released voice's remaining audio is dropped;
+    // the worker's writes fail once the voice is claimed again.
+    if (!voice.pendingStart && voice.releasePos >= voice.releaseLength) {
+        voice.buffer.discard();
+        voice.active = false;
+    } else if (!voice.pendingStart &&
+               voice.finishedGeneration.load(std::memory_order_acquire) == generation &&
+               voice.buffer.getAvailable() == 0) {
+        voice.active = false;
+    }
+    return peak > 0.0f ? 1u << bus : 0u;
+}
+
+// The sample sizes hosts process in
+template uint32_t VoicePool::mix<float>(float* const*, int, int, int64_t);
+template uint32_t VoicePool::mix<double>(double* const*, int, int, int64_t);
+
+//------------------------------------------------------------------------
+void VoicePool::startScheduledChanges(Voice& voice, int64_t time) {
+    // Until its stream starts, the voice still plays the stolen note's tail
+    if (voice.pendingStart) {
+        return;
+    }
+
+    if (voice.pendingGainSample >= 0 && time >= voice.pendingGainSample) {
+        voice.gainTarget = voice.pendingGain;
+        voice.pendingGainSample = -1;
+    }
+    // A note released before it was heard still plays its release
+    if (voice.released && voice.releasePos < 0 && time >= voice.releaseSample) {
+        voice.releasePos = 0;
+    }
+}
+
+//------------------------------------------------------------------------
+void VoicePool::advanceEnvelope(Voice& voice, int count) {
+    if (voice.pendingStart) {
+        voice.envelope = (std::max)(0.0f, voice.envelope - static_cast<float>(count) / kReleaseSamples);
+    } else {
+        voice.envelope = (std::min)(1.0f, voice.envelope + static_cast<float>(count) / kAttackSamples);
+    }
+
+    if (voice.releasePos >= 0) {
+        voice.releasePos = (std::min)(voice.releaseLength, voice.releasePos + count);
+        voice.release = kVoiceCurves.releaseAt(static_cast<float>(voice.releasePos) / voice.releaseLength);
+    }
+
+    // Pressure changes are slewed so they don't click
+    const float maxStep = static_cast<float>(count) / kGainSlewSamples;
+    voice.gain += (std::max)(-maxStep, (std::min)(maxStep, voice.gainTarget - voice.gain));
+}
+
+//------------------------------------------------------------------------
+bool VoicePool::beginStream(const VoiceHandle& handle) {
+    if (!handle.isValid()) {
+        return false;
+    }
+
+    Voice& voice = voices_[handle.index];
+    if (voice.generation.load(std::memory_order_acquire) != handle.generation) {
+        return false;
+    }
+
+    // Everything before this position belongs to earlier notes
+    voice.startPos.store(voice.buffer.getWritePosition(), std::memory_order_relaxed);
+    voice.startedGeneration.store(handle.generation, std::memory_order_release);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool VoicePool::write(const VoiceHandle& handle, const float* samples, size_t count) {
+    Voice& voice = voices_[handle.index];
+    if (voice.generation.load(std::memory_order_acquire) != handle.generation) {
+        return false;
+    }
+
+    size_t written = voice.buffer.write(samples, count);
+    if (written < count) {
+        droppedSamples_ += static_cast<int>(count - written);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+void VoicePool::endStream(const VoiceHandle& handle) {
+    if (!handle.isValid()) {
+        return;
+    }
+
+    voices_[handle.index].finishedGeneration.store(handle.generation, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,178 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "AudioRingBuffer.h"
+#include "LatencyStats.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// VoiceStealMode - what to do with a note-on when all voices are busy
+//------------------------------------------------------------------------
+enum class VoiceStealMode {
+    Oldest = 0,     // Take over the voice that started first
+    Quietest,       // Take over the voice with the lowest recent level
+    None            // Drop the new note
+};
+
+//------------------------------------------------------------------------
+// VoiceHandle - identifies one note's claim on a voice
+//------------------------------------------------------------------------
+struct VoiceHandle {
+    int index = -1;
+    unsigned generation = 0;
+
+    bool isValid() const { return index >= 0; }
+};
+
+//------------------------------------------------------------------------
+// VoicePool - fixed set of playback voices mixed by the audio thread
+// Each voice owns an SPSC ring: the render worker writes a note's audio,
+// the audio thread reads and mixes it with a gain envelope (attack, note-off
+// release, velocity and poly pressure) built from precomputed curves and
+// applied as short linear ramps, so mixing does no pow/exp. Voices are
+// claimed on the audio thread without allocating. Every claim bumps the
+// voice's generation; the worker tags the stream start with it, so audio
+// left over from a stolen note is skipped instead of played.
+//------------------------------------------------------------------------
+class VoicePool {
+public:
+    static constexpr int kMaxVoices = 16;
+    static constexpr int kAttackSamples = 64;     // Fade-in at note start
+    static constexpr int kReleaseSamples = 256;   // Fade-out of a stolen voice
+    static constexpr int kGainSlewSamples = 256;  // Full-scale pressure change
+    static constexpr int kBusByVoice = -1;        // noteOn() bus: the voice's index
+
+    VoicePool() = default;
+
+    VoicePool(const VoicePool&) = delete;
+    VoicePool& operator=(const VoicePool&) = delete;
+
+    // Allocate per-voice buffers and silence all voices. Not realtime-safe:
+    // call while neither the audio thread nor the worker is running.
+    void allocate(size_t samplesPerVoice);
+
+    // Settings (any thread, picked up on the next note-on)
+    void setVoiceLimit(int voices);
+    void setStealMode(VoiceStealMode mode) { stealMode_ = mode; }
+    static VoiceStealMode stealModeFromString(const std::string& str);
+    void setVelocityDepth(float depth);     // 0 = velocity ignored, 1 = full curve
+    void setReleaseSamples(int samples);    // Note-off fade, 0 = note-offs ignored
+
+    // Record note-on -> first mixed sample latency (set before processing)
+    void setLatencyStats(LatencyStats* stats) { stats_ = stats; }
+
+    //--- Audio thread ---------------------------------------------------
+    // Claim a voice for a note starting at startSample (mix timeline),
+    // played on output bus (or kBusByVoice). Returns an invalid handle if
+    // none is free and stealing is disabled.
+    VoiceHandle noteOn(int note, int velocity, int64_t startSample, int bus = 0);
+
+    // Fade out the note's voices from releaseSample on (mix timeline).
+    // Ignored while the release length is 0: syllables play to the end.
+    void noteOff(int note, int64_t releaseSample);
+
+    // Poly pressure lifts the note's level from its velocity gain towards
+    // full level, starting at pressureSample
+    void setPressure(int note, int pressure, int64_t pressureSample);
+
+    // Give a claim back (e.g. the render job could not be queued)
+    void cancel(const VoiceHandle& handle);
+
+    // Add all active voices into output (mono, numSamples). blockStart is
+    // the timeline position of output[0]; a voice whose audio is ready early
+    // waits for its start sample, a late one starts right away. True if
+    // anything audible was added.
+    bool mix(float* output, int numSamples, int64_t blockStart) { return mix(&output, 1, numSamples, blockStart) != 0; }
+
+    // Planar version: each voice is added into outputs[its bus % busCount]
+    // (mono, numSamples), or outputs[0] when that one is nullptr.
+    // Sample is float or double. Returns a mask of the buses that received
+    // audible output (bit n = outputs[n]).
+    template <typename Sample>
+    uint32_t mix(Sample* const* outputs, int busCount, int numSamples, int64_t blockStart);
+
+    // Number of voices currently sounding or waiting for audio
+    int getActiveVoiceCount() const;
+
+    // No voice is sounding or waiting: mix() would add nothing
+    bool isIdle() const;
+
+    //--- Render worker thread -------------------------------------------
+    // Mark the start of the claim's audio. Returns false if the voice has
+    // already been taken by a newer note.
+    bool beginStream(const VoiceHandle& handle);
+
+    // Append audio for the claim. Returns false once the voice was stolen.
+    bool write(const VoiceHandle& handle, const float* samples, size_t count);
+
+    // No more audio will follow for this claim
+    void endStream(const VoiceHandle& handle);
+
+    // Samples dropped because a voice buffer was full
+    int getDroppedSamples() const { return droppedSamples_; }
+
+private:
+    struct Voice {
+        AudioRingBuffer buffer;
+
+        // Shared between audio thread (claims) and worker (streams)
+        std::atomic<unsigned> generation{0};
+        std::atomic<unsigned> startedGeneration{0};
+        std::atomic<unsigned> finishedGeneration{0};
+        std::atomic<size_t> startPos{0};
+
+        // Audio thread only
+        bool active = false;
+        bool pendingStart = false;  // Claimed, worker has not started the stream yet
+        int note = -1;
+        int velocity = 0;
+        int bus = 0;                // Output bus of the audio playing now
+        int nextBus = 0;            // Bus of the claim, taken when its stream starts
+        uint64_t startOrder = 0;
+        float envelope = 0.0f;      // Attack / steal fade
+        float gain = 1.0f;          // Velocity and pressure, slewed towards gainTarget
+        float gainTarget = 1.0f;
+        float velocityGain = 1.0f;
+        float pendingGain = 1.0f;   // Pressure level waiting for pendingGainSample
+        int64_t pendingGainSample = -1;
+        bool released = false;      // Note-off received
+        int64_t releaseSample = 0;  // Timeline sample the release starts at
+        int releasePos = -1;        // Samples into the release, -1 = not started
+        int releaseLength = 0;
+        float release = 1.0f;       // Release curve value
+        float level = 0.0f;         // Peak of the last mixed block
+        int64_t claimMicros = 0;    // Note-on time until the first sample is mixed
+        int64_t startSample = 0;    // Timeline sample the note was played at
+        bool waitingForStart = false;   // Stream started, startSample not reached yet
+    };
+
+    template <typename Sample>
+    uint32_t mixVoice(Voice& voice, Sample* const* outputs, int busCount, int numSamples, int64_t blockStart);
+    static void startScheduledChanges(Voice& voice, int64_t time);
+    static void advanceEnvelope(Voice& voice, int count);
+
+    std::array<Voice, kMaxVoices> voices_;
+    std::atomic<int> voiceLimit_{kMaxVoices};
+    std::atomic<VoiceStealMode> stealMode_{VoiceStealMode::Oldest};
+    std::atomic<float> velocityDepth_{1.0f};
+    std::atomic<int> releaseSamples_{0};
+    std::atomic<int> droppedSamples_{0};
+    LatencyStats* stats_ = nullptr;
+    uint64_t noteCounter_ = 0;  // Audio thread only
+
+    static constexpr int kMixChunk = 256;
+    static constexpr int kRampSegment = 32;     // Samples per linear gain ramp
+    std::array<float, kMixChunk> scratch_{};
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -3,24 +3,175 @@
 //------------------------------------------------------------------------
 
 #include "WorldPitchShifter.h"
+#include "Resampler.h"
+#include "ThreadPool.h"
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 
 // World vocoder headers
 #include "world/dio.h"
+#include "world/harvest.h"
 #include "world/cheaptrick.h"
 #include "world/d4c.h"
+#include "world/codec.h"
 #include "world/synthesis.h"
+#include "world/synthesisrealtime.h"
+#include "world/workspace.h"
 
 namespace FlaschenTaschen {
 
+namespace {
+    constexpr float kSilenceThreshold = 1e-3f;      // -60 dBFS
+    constexpr double kSilencePad = 0.01;            // Kept around the audible part (s)
+    constexpr int kVoicedMargin = 2;                // Unvoiced frames resynthesized around voiced ones (crossfade)
+    constexpr int kMinBypassFrames = 4;             // Shorter unvoiced gaps are resynthesized
+    constexpr double kBypassPower = 1e-16;          // Envelope of frames that are never analyzed
+    constexpr double kBypassAperiodicity = 1.0 - 1e-12;
+
+    // WorldExecutor adapter for ThreadPool::parallelFor
+    void parallelForOnPool(void* userData, int count, WorldTask task, void* context) {
+        static_cast<ThreadPool*>(userData)->parallelFor(count, [task, context](int i) { task(context, i); });
+    }
+
+    // Voiced frames widened by the margin; nearby ranges are merged
+    std::vector<WorldFrameRange> findVoicedRanges(const std::vector<double>& f0) {
+        std::vector<WorldFrameRange> ranges;
+        const int frames = static_cast<int>(f0.size());
+        int frame = 0;
+        while (frame < frames) {
+            if (f0[frame] <= 0.0) {
+                ++frame;
+                continue;
+            }
+            int end = frame;
+            while (end < frames && f0[end] > 0.0) ++end;
+
+            WorldFrameRange range;
+            range.begin = (std::max)(0, frame - kVoicedMargin);
+            range.end = (std::min)(frames, end + kVoicedMargin);
+            if (!ranges.empty() && range.begin - ranges.back().end < kMinBypassFrames) {
+                ranges.back().end = range.end;
+            } else {
+                ranges.push_back(range);
+            }
+            frame = end;
+        }
+        return ranges;
+    }
+
+    using AnalysisClock = std::chrono::steady_clock;
+
+    int64_t elapsedMicros(AnalysisClock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(AnalysisClock::now() - start).count();
+    }
+
+    // Keep input as the analysis source and find the part worth analyzing:
+    // eSpeak's leading silence and end pause are skipped. False for an
+    // empty or all-silent input, which stays invalid and plays unchanged.
+    bool trimInput(const std::vector<float>& input, WorldAnalysis& analysis) {
+        analysis.source = input;
+        if (input.empty()) {
+            return false;
+        }
+        analysis.inputLength = static_cast<int>(input.size());
+
+        int begin = 0;
+        int end = analysis.inputLength;
+        while (begin < end && std::abs(input[begin]) < kSilenceThreshold) ++begin;
+        while (end > begin && std::abs(input[end - 1]) < kSilenceThreshold) --end;
+        if (begin == end) {
+            return false;
+        }
+        const int pad = static_cast<int>(std::lround(kSilencePad * analysis.sampleRate));
+        begin = (std::max)(0, begin - pad);
+        end = (std::min)(analysis.inputLength, end + pad);
+        analysis.analysisStart = begin;
+        analysis.analysisLength = end - begin;
+        return true;
+    }
+
+    // F0 of the analysisLength samples of x. DIO runs its frequency bands
+    // on the executor and needs fewer bands for a narrow range; Harvest is
+    // serial but robust.
+    void estimateF0(const double* x, const WorldAnalysisSettings& settings, const WorldExecutor* executor,
+                    WorldWorkspace* workspace, WorldAnalysis& analysis) {
+        const auto stepStart = AnalysisClock::now();
+        const int sampleRate = analysis.sampleRate;
+        const int inputLength = analysis.analysisLength;
+        const bool harvest = settings.estimator == F0Estimator::Harvest;
+        const int f0Length = harvest ? GetSamplesForHarvest(sampleRate, inputLength, analysis.framePeriod)
+                                     : GetSamplesForDIO(sampleRate, inputLength, analysis.framePeriod);
+
+        analysis.f0.resize(f0Length);
+        analysis.temporalPositions.resize(f0Length);
+
+        if (harvest) {
+            HarvestOption harvestOption;
+            InitializeHarvestOption(&harvestOption);
+            harvestOption.frame_period = analysis.framePeriod;
+            harvestOption.f0_floor = settings.f0Floor;
+            harvestOption.f0_ceil = settings.f0Ceil;
+
+            Harvest(x, inputLength, sampleRate, &harvestOption,
+                    analysis.temporalPositions.data(), analysis.f0.data());
+        } else {
+            DioOption dioOption;
+            InitializeDioOption(&dioOption);
+            dioOption.frame_period = analysis.framePeriod;
+            dioOption.speed = (std::max)(1, (std::min)(12, settings.dioSpeed));
+            dioOption.f0_floor = settings.f0Floor;
+            dioOption.f0_ceil = settings.f0Ceil;
+            dioOption.allowed_range = 0.1;
+            dioOption.executor = executor;
+            dioOption.workspace = workspace;
+
+            Dio(x, inputLength, sampleRate, &dioOption,
+                analysis.temporalPositions.data(), analysis.f0.data());
+        }
+        analysis.f0Micros = elapsedMicros(stepStart);
+    }
+
+    // Spectrogram and aperiodicity (frames x (fftSize/2 + 1)) for an F0
+    // contour. Frames outside the voiced ranges are never synthesized and
+    // keep placeholder values.
+    void allocateSpectra(WorldAnalysis& analysis, int fftSize) {
+        const int frames = analysis.getFrameCount();
+        const int specLength = fftSize / 2 + 1;
+        analysis.fftSize = fftSize;
+        analysis.spectrogram.assign(frames, specLength, kBypassPower);
+        analysis.aperiodicity.assign(frames, specLength, kBypassAperiodicity);
+        analysis.voicedRanges = findVoicedRanges(analysis.f0);
+    }
+
+    // End sample of a range (relative to analysisStart); the last range runs to the end
+    int rangeEndSample(const WorldAnalysis& analysis, const WorldFrameRange& range) {
+        if (range.end >= analysis.getFrameCount()) {
+            return analysis.analysisLength;
+        }
+        return (std::min)(analysis.analysisLength, analysis.frameToSample(range.end));
+    }
+
+    // Share of the resynthesized signal at offset i of a range of length samples
+    float crossfadeWeight(int i, int length, int fade) {
+        if (fade <= 0) {
+            return 1.0f;
+        }
+        const float in = (i + 0.5f) / fade;
+        const float out = (length - i - 0.5f) / fade;
+        return (std::min)(1.0f, (std::min)(in, out));
+    }
+}
+
 //------------------------------------------------------------------------
 WorldPitchShifter::WorldPitchShifter() {
+    context_.workspace = CreateWorldWorkspace();
 }
 
 //------------------------------------------------------------------------
 WorldPitchShifter::~WorldPitchShifter() {
+    DestroyWorldWorkspace(context_.workspace);
 }
 
 //------------------------------------------------------------------------
@@ -28,18 +179,6 @@ void WorldPitchShifter::initialize(int sampleRate) {
     sampleRate_ = sampleRate;
 }
 
-//------------------------------------------------------------------------
-double WorldPitchShifter::midiNoteToFrequency(int midiNote) {
-    // A4 (MIDI 69) = 440 Hz
-    return 440.0 * std::pow(2.0, (midiNote - 69) / 12.0);
-}
-
-//------------------------------------------------------------------------
-int WorldPitchShifter::frequencyToMidiNote(double frequency) {
-    if (frequency <= 0) return 0;
-    return static_cast<int>(std::round(69.0 + 12.0 * std::log2(frequency / 440.0)));
-}
-
 //------------------------------------------------------------------------
 void WorldPitchShifter::setTargetMidiNote(int midiNote) {
     // We'll shift relative to a base frequency
@@ -61,120 +200,589 @@ void WorldPitchShifter::setPitchShiftRatio(double ratio) {
 
 //------------------------------------------------------------------------
 std::vector<float> WorldPitchShifter::process(const std::vector<float>& input) {
-    return pitchShiftWorld(input, pitchShiftRatio_);
+    return shift(input, pitchShiftRatio_);
 }
 
 //------------------------------------------------------------------------
 std::vector<float> WorldPitchShifter::processToFrequency(const std::vector<float>& input, double targetFreqHz) {
-    // Calculate semitone shift from middle C (261.63 Hz, MIDI 60)
-    // This gives a reasonable musical shift range
-    double middleC = 261.63;
-    double semitones = 12.0 * std::log2(targetFreqHz / middleC);
+    return shift(input, frequencyToRatio(targetFreqHz));
+}
+
+//------------------------------------------------------------------------
+// WorldMatrix Implementation
+//------------------------------------------------------------------------
+WorldMatrix::WorldMatrix(const WorldMatrix& other) {
+    *this = other;
+}
 
-    // Limit shift to +/- 36 semitones (3 octaves) to support wide range
-    // C2 (65 Hz) to C7 (2093 Hz) relative to C4 (262 Hz)
-    semitones = (std::max)(-36.0, (std::min)(36.0, semitones));
+//------------------------------------------------------------------------
+WorldMatrix& WorldMatrix::operator=(const WorldMatrix& other) {
+    if (this != &other) {
+        assign(other.rows_, other.cols_);
+        for (int row = 0; row < rows_; ++row) {
+            std::copy(other[row], other[row] + cols_, rowPointers_[row]);
+        }
+    }
+    return *this;
+}
 
-    double ratio = std::pow(2.0, semitones / 12.0);
-    return pitchShiftWorld(input, ratio);
+//------------------------------------------------------------------------
+WorldMatrix::WorldMatrix(WorldMatrix&& other) noexcept {
+    *this = std::move(other);
 }
 
 //------------------------------------------------------------------------
-std::vector<float> WorldPitchShifter::pitchShiftWorld(const std::vector<float>& input, double ratio) {
+WorldMatrix& WorldMatrix::operator=(WorldMatrix&& other) noexcept {
+    if (this != &other) {
+        // Moving the vectors keeps the buffer, so the row pointers stay valid
+        storage_ = std::move(other.storage_);
+        rowPointers_ = std::move(other.rowPointers_);
+        rows_ = other.rows_;
+        cols_ = other.cols_;
+        stride_ = other.stride_;
+        other.storage_.clear();
+        other.rowPointers_.clear();
+        other.rows_ = other.cols_ = other.stride_ = 0;
+    }
+    return *this;
+}
+
+//------------------------------------------------------------------------
+void WorldMatrix::assign(int rows, int cols, double value) {
+    rows_ = (std::max)(rows, 0);
+    cols_ = (std::max)(cols, 0);
+    stride_ = (cols_ + kAlignDoubles - 1) / kAlignDoubles * kAlignDoubles;
+
+    // Slack so the first row can be moved up to an aligned address
+    const size_t required = static_cast<size_t>(rows_) * stride_ + kAlignDoubles;
+    if (storage_.size() < required) {
+        storage_.resize(required);
+    }
+    buildRowPointers();
+
+    for (int row = 0; row < rows_; ++row) {
+        std::fill(rowPointers_[row], rowPointers_[row] + cols_, value);
+    }
+}
+
+//------------------------------------------------------------------------
+void WorldMatrix::buildRowPointers() {
+    rowPointers_.resize(rows_);
+    if (rows_ == 0) {
+        return;
+    }
+
+    const uintptr_t address = reinterpret_cast<uintptr_t>(storage_.data());
+    const size_t offset = ((kAlignment - address % kAlignment) % kAlignment) / sizeof(double);
+    double* base = storage_.data() + offset;
+    for (int row = 0; row < rows_; ++row) {
+        rowPointers_[row] = base + static_cast<size_t>(row) * stride_;
+    }
+}
+
+//------------------------------------------------------------------------
+size_t WorldMatrix::getMemorySize() const {
+    return storage_.size() * sizeof(double) + rowPointers_.size() * sizeof(double*);
+}
+
+//------------------------------------------------------------------------
+int WorldAnalysis::frameToSample(int frame) const {
+    return static_cast<int>(std::lround(frame * framePeriod * sampleRate / 1000.0));
+}
+
+//------------------------------------------------------------------------
+size_t WorldAnalysis::getMemorySize() const {
+    size_t bytes = source.size() * sizeof(float);
+    bytes += (f0.size() + temporalPositions.size()) * sizeof(double);
+    bytes += spectrogram.getMemorySize() + aperiodicity.getMemorySize();
+    bytes += voicedRanges.size() * sizeof(WorldFrameRange);
+    return bytes;
+}
+
+//------------------------------------------------------------------------
+size_t WorldCodedAnalysis::getMemorySize() const {
+    return frames.getMemorySize() + spectrum.getMemorySize() + aperiodicity.getMemorySize();
+}
+
+//------------------------------------------------------------------------
+std::vector<float> WorldPitchShifter::shift(const std::vector<float>& input, double ratio) {
     if (input.empty() || ratio <= 0 || std::abs(ratio - 1.0) < 0.001) {
         return input;
     }
 
-    int inputLength = static_cast<int>(input.size());
+    return synthesize(analyze(input), ratio);
+}
 
-    // Convert float input to double for World vocoder
-    std::vector<double> x(inputLength);
-    for (int i = 0; i < inputLength; ++i) {
-        x[i] = static_cast<double>(input[i]);
+//------------------------------------------------------------------------
+WorldAnalysis WorldPitchShifter::analyze(const std::vector<float>& input) const {
+    return analyze(input, settings_);
+}
+
+//------------------------------------------------------------------------
+WorldAnalysis WorldPitchShifter::analyze(const std::vector<float>& input, const WorldAnalysisSettings& settings) const {
+    WorldAnalysis analysis;
+    analysis.sampleRate = sampleRate_;
+    analysis.framePeriod = framePeriod_;
+    if (!trimInput(input, analysis)) {
+        return analysis;
     }
+    const int inputLength = analysis.analysisLength;
 
-    // Step 1: F0 extraction with DIO
-    DioOption dioOption;
-    InitializeDioOption(&dioOption);
-    dioOption.frame_period = framePeriod_;
-    dioOption.speed = 1;  // Highest quality
-    dioOption.f0_floor = 71.0;   // Lower limit for F0
-    dioOption.f0_ceil = 800.0;   // Upper limit for F0
-    dioOption.allowed_range = 0.1;
+    std::lock_guard<std::mutex> lock(contextMutex_);
 
-    int f0Length = GetSamplesForDIO(sampleRate_, inputLength, framePeriod_);
+    // Convert float input to double for World vocoder
+    std::vector<double>& x = context_.x;
+    x.resize(inputLength);
+    for (int i = 0; i < inputLength; ++i) {
+        x[i] = static_cast<double>(input[analysis.analysisStart + i]);
+    }
 
-    std::vector<double> f0(f0Length);
-    std::vector<double> temporalPositions(f0Length);
+    WorldExecutor executor;
+    executor.parallel_for = parallelForOnPool;
+    executor.user_data = threadPool_;
+    const WorldExecutor* analysisExecutor = threadPool_ ? &executor : nullptr;
 
-    Dio(x.data(), inputLength, sampleRate_, &dioOption,
-        temporalPositions.data(), f0.data());
+    // Step 1: F0 extraction
+    estimateF0(x.data(), settings, analysisExecutor, context_.workspace, analysis);
 
-    // Step 2: Spectral envelope with CheapTrick
+    // Step 2: Spectral envelope with CheapTrick (blocks of frames in parallel)
     CheapTrickOption cheapTrickOption;
     InitializeCheapTrickOption(sampleRate_, &cheapTrickOption);
-    int fftSize = GetFFTSizeForCheapTrick(sampleRate_, &cheapTrickOption);
+    cheapTrickOption.executor = analysisExecutor;
+    cheapTrickOption.workspace = context_.workspace;
+    const int fftSize = GetFFTSizeForCheapTrick(sampleRate_, &cheapTrickOption);
+    allocateSpectra(analysis, fftSize);
 
-    // Allocate spectrogram (f0Length x (fftSize/2 + 1))
-    int specLength = fftSize / 2 + 1;
-    double** spectrogram = new double*[f0Length];
-    for (int i = 0; i < f0Length; ++i) {
-        spectrogram[i] = new double[specLength];
+    // Step 3: Aperiodicity with D4C (blocks of frames in parallel)
+    D4COption d4cOption;
+    InitializeD4COption(&d4cOption);
+    d4cOption.executor = analysisExecutor;
+    d4cOption.workspace = context_.workspace;
+
+    // Both estimators take any run of frames, so each voiced range is one call
+    for (const WorldFrameRange& range : analysis.voicedRanges) {
+        const int frames = range.end - range.begin;
+        auto stepStart = AnalysisClock::now();
+        CheapTrick(x.data(), inputLength, sampleRate_,
+                   analysis.temporalPositions.data() + range.begin, analysis.f0.data() + range.begin, frames,
+                   &cheapTrickOption, analysis.spectrogram.getRowPointers() + range.begin);
+        analysis.spectrumMicros += elapsedMicros(stepStart);
+
+        stepStart = AnalysisClock::now();
+        D4C(x.data(), inputLength, sampleRate_,
+            analysis.temporalPositions.data() + range.begin, analysis.f0.data() + range.begin, frames,
+            fftSize, &d4cOption, analysis.aperiodicity.getRowPointers() + range.begin);
+        analysis.aperiodicityMicros += elapsedMicros(stepStart);
     }
 
-    CheapTrick(x.data(), inputLength, sampleRate_,
-               temporalPositions.data(), f0.data(), f0Length,
-               &cheapTrickOption, spectrogram);
+    return analysis;
+}
+
+//------------------------------------------------------------------------
+std::vector<WorldAnalysis> WorldPitchShifter::analyzeBatch(const std::vector<std::vector<float>>& inputs,
+                                                           const WorldAnalysisSettings& settings) const {
+    std::vector<WorldAnalysis> analyses(inputs.size());
+    std::vector<std::vector<double>> signals(inputs.size());
+    std::vector<size_t> valid;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        WorldAnalysis& analysis = analyses[i];
+        analysis.sampleRate = sampleRate_;
+        analysis.framePeriod = framePeriod_;
+        if (trimInput(inputs[i], analysis)) {
+            const float* begin = inputs[i].data() + analysis.analysisStart;
+            signals[i].assign(begin, begin + analysis.analysisLength);
+            valid.push_back(i);
+        }
+    }
+    if (valid.empty()) {
+        return analyses;
+    }
+
+    WorldExecutor executor;
+    executor.parallel_for = parallelForOnPool;
+    executor.user_data = threadPool_;
+    const WorldExecutor* analysisExecutor = threadPool_ ? &executor : nullptr;
+
+    // Step 1: F0 extraction. Several inputs run side by side, each on one
+    // thread; a single input spreads DIO's bands over the pool instead.
+    const int count = static_cast<int>(valid.size());
+    auto estimate = [&](int k) {
+        const size_t i = valid[k];
+        estimateF0(signals[i].data(), settings, count > 1 ? nullptr : analysisExecutor, nullptr, analyses[i]);
+    };
+    if (threadPool_ && count > 1) {
+        threadPool_->parallelFor(count, estimate);
+    } else {
+        for (int k = 0; k < count; ++k) estimate(k);
+    }
+
+    CheapTrickOption cheapTrickOption;
+    InitializeCheapTrickOption(sampleRate_, &cheapTrickOption);
+    cheapTrickOption.executor = analysisExecutor;
+    const int fftSize = GetFFTSizeForCheapTrick(sampleRate_, &cheapTrickOption);
 
-    // Step 3: Aperiodicity with D4C
     D4COption d4cOption;
     InitializeD4COption(&d4cOption);
+    d4cOption.executor = analysisExecutor;
+
+    // Steps 2 and 3: one segment per voiced range of every input, laid out
+    // as the parallel arrays World's batch functions take
+    std::vector<const double*> x;
+    std::vector<int> xLength;
+    std::vector<const double*> positions;
+    std::vector<const double*> f0;
+    std::vector<int> frames;
+    std::vector<double**> spectra;
+    std::vector<double**> aperiodicities;
+    int totalFrames = 0;
+    for (size_t i : valid) {
+        WorldAnalysis& analysis = analyses[i];
+        allocateSpectra(analysis, fftSize);
+        for (const WorldFrameRange& range : analysis.voicedRanges) {
+            x.push_back(signals[i].data());
+            xLength.push_back(analysis.analysisLength);
+            positions.push_back(analysis.temporalPositions.data() + range.begin);
+            f0.push_back(analysis.f0.data() + range.begin);
+            frames.push_back(range.end - range.begin);
+            spectra.push_back(analysis.spectrogram.getRowPointers() + range.begin);
+            aperiodicities.push_back(analysis.aperiodicity.getRowPointers() + range.begin);
+            totalFrames += range.end - range.begin;
+        }
+    }
+    if (x.empty()) {
+        return analyses;
+    }
 
-    double** aperiodicity = new double*[f0Length];
-    for (int i = 0; i < f0Length; ++i) {
-        aperiodicity[i] = new double[specLength];
+    WorldAnalysisBatch batch;
+    batch.count = static_cast<int>(x.size());
+    batch.x = x.data();
+    batch.x_length = xLength.data();
+    batch.temporal_positions = positions.data();
+    batch.f0 = f0.data();
+    batch.f0_length = frames.data();
+
+    auto stepStart = AnalysisClock::now();
+    batch.output = spectra.data();
+    CheapTrickBatch(&batch, sampleRate_, &cheapTrickOption);
+    const int64_t spectrumMicros = elapsedMicros(stepStart);
+
+    stepStart = AnalysisClock::now();
+    batch.output = aperiodicities.data();
+    D4CBatch(&batch, sampleRate_, fftSize, &d4cOption);
+    const int64_t aperiodicityMicros = elapsedMicros(stepStart);
+
+    // Each analysis is charged its share of the batch by frame count
+    for (size_t i : valid) {
+        WorldAnalysis& analysis = analyses[i];
+        int analyzed = 0;
+        for (const WorldFrameRange& range : analysis.voicedRanges) {
+            analyzed += range.end - range.begin;
+        }
+        analysis.spectrumMicros = spectrumMicros * analyzed / totalFrames;
+        analysis.aperiodicityMicros = aperiodicityMicros * analyzed / totalFrames;
     }
+    return analyses;
+}
+
+//------------------------------------------------------------------------
+WorldAnalysis WorldPitchShifter::convertSampleRate(const WorldAnalysis& analysis, int targetRate) {
+    if (!analysis.isValid() || targetRate <= 0 || targetRate == analysis.sampleRate) {
+        return analysis;
+    }
+
+    WorldAnalysis converted;
+    converted.sampleRate = targetRate;
+    converted.framePeriod = analysis.framePeriod;
+    converted.f0 = analysis.f0;
+    converted.temporalPositions = analysis.temporalPositions;
+    converted.voicedRanges = analysis.voicedRanges;
+
+    // Source plays wherever the analysis isn't resynthesized
+    Resampler resampler;
+    resampler.setRates(analysis.sampleRate, targetRate);
+    converted.source = resampler.processAll(analysis.source);
+    converted.inputLength = static_cast<int>(converted.source.size());
 
-    D4C(x.data(), inputLength, sampleRate_,
-        temporalPositions.data(), f0.data(), f0Length,
-        fftSize, &d4cOption, aperiodicity);
+    const double rateScale = static_cast<double>(targetRate) / analysis.sampleRate;
+    converted.analysisStart = static_cast<int>(std::lround(analysis.analysisStart * rateScale));
+    converted.analysisLength = (std::min)(converted.inputLength - converted.analysisStart,
+                                          static_cast<int>(std::lround(analysis.analysisLength * rateScale)));
 
-    // Step 4: Modify F0 for pitch shift (duration stays the same!)
+    CheapTrickOption cheapTrickOption;
+    InitializeCheapTrickOption(targetRate, &cheapTrickOption);
+    converted.fftSize = GetFFTSizeForCheapTrick(targetRate, &cheapTrickOption);
+
+    const int srcLength = analysis.fftSize / 2 + 1;
+    const int dstLength = converted.fftSize / 2 + 1;
+    const double binScale = (static_cast<double>(targetRate) / converted.fftSize) /
+                            (static_cast<double>(analysis.sampleRate) / analysis.fftSize);
+
+    // CheapTrick's envelope is a power density that scales with the sample
+    // rate; the source signal has no energy above its Nyquist frequency
+    const double powerScale = static_cast<double>(targetRate) / analysis.sampleRate;
+    constexpr double kOutOfBandPower = 1e-8;
+
+    const int f0Length = analysis.getFrameCount();
+    converted.spectrogram.assign(f0Length, dstLength);
+    converted.aperiodicity.assign(f0Length, dstLength);
+
+    for (int frame = 0; frame < f0Length; ++frame) {
+        const double* srcSpec = analysis.spectrogram[frame];
+        const double* srcAp = analysis.aperiodicity[frame];
+        double* dstSpec = converted.spectrogram[frame];
+        double* dstAp = converted.aperiodicity[frame];
+
+        for (int k = 0; k < dstLength; ++k) {
+            double srcBin = k * binScale;
+            int index = static_cast<int>(srcBin);
+            if (index >= srcLength - 1) {
+                dstSpec[k] = srcSpec[srcLength - 1] * powerScale * kOutOfBandPower;
+                dstAp[k] = srcAp[srcLength - 1];
+                continue;
+            }
+            double frac = srcBin - index;
+            dstSpec[k] = (srcSpec[index] + (srcSpec[index + 1] - srcSpec[index]) * frac) * powerScale;
+            dstAp[k] = srcAp[index] + (srcAp[index + 1] - srcAp[index]) * frac;
+        }
+    }
+
+    return converted;
+}
+
+//------------------------------------------------------------------------
+WorldCodedAnalysis WorldPitchShifter::encode(const WorldAnalysis& analysis, int dims) {
+    WorldCodedAnalysis coded;
+    coded.frames.sampleRate = analysis.sampleRate;
+    coded.frames.inputLength = analysis.inputLength;
+    coded.frames.analysisStart = analysis.analysisStart;
+    coded.frames.analysisLength = analysis.analysisLength;
+    coded.frames.fftSize = analysis.fftSize;
+    coded.frames.framePeriod = analysis.framePeriod;
+    coded.frames.source = analysis.source;
+    coded.frames.f0 = analysis.f0;
+    coded.frames.temporalPositions = analysis.temporalPositions;
+    coded.frames.voicedRanges = analysis.voicedRanges;
+    if (!analysis.isValid()) {
+        return coded;
+    }
+
+    const int f0Length = analysis.getFrameCount();
+    coded.dims = (std::max)(1, (std::min)(dims, analysis.fftSize / 2));
+    coded.spectrum.assign(f0Length, coded.dims);
+    coded.aperiodicity.assign(f0Length, GetNumberOfAperiodicities(analysis.sampleRate));
+
+    CodeSpectralEnvelope(analysis.spectrogram.getRowPointers(), f0Length, analysis.sampleRate,
+                         analysis.fftSize, coded.dims, coded.spectrum.getRowPointers());
+    CodeAperiodicity(analysis.aperiodicity.getRowPointers(), f0Length, analysis.sampleRate,
+                     analysis.fftSize, coded.aperiodicity.getRowPointers());
+    return coded;
+}
+
+//------------------------------------------------------------------------
+WorldAnalysis WorldPitchShifter::decode(const WorldCodedAnalysis& coded) {
+    WorldAnalysis analysis = coded.frames;
+    if (!analysis.isValid() || coded.spectrum.empty()) {
+        return analysis;
+    }
+
+    const int f0Length = analysis.getFrameCount();
+    const int specLength = analysis.fftSize / 2 + 1;
+    analysis.spectrogram.assign(f0Length, specLength);
+    analysis.aperiodicity.assign(f0Length, specLength);
+
+    DecodeSpectralEnvelope(coded.spectrum.getRowPointers(), f0Length, analysis.sampleRate,
+                           analysis.fftSize, coded.dims, analysis.spectrogram.getRowPointers());
+    DecodeAperiodicity(coded.aperiodicity.getRowPointers(), f0Length, analysis.sampleRate,
+                       analysis.fftSize, analysis.aperiodicity.getRowPointers());
+    return analysis;
+}
+
+//------------------------------------------------------------------------
+std::vector<float> WorldPitchShifter::synthesize(const WorldAnalysis& analysis, double ratio) const {
+    if (!analysis.isValid() || ratio <= 0 || std::abs(ratio - 1.0) < 0.001) {
+        return analysis.source;
+    }
+
+    int f0Length = analysis.getFrameCount();
+
+    // Modify F0 for pitch shift (duration stays the same!)
     std::vector<double> modifiedF0(f0Length);
     for (int i = 0; i < f0Length; ++i) {
-        if (f0[i] > 0) {
+        if (analysis.f0[i] > 0) {
             // Scale F0 by pitch ratio - this changes pitch without affecting duration
-            modifiedF0[i] = f0[i] * ratio;
+            modifiedF0[i] = analysis.f0[i] * ratio;
         } else {
             // Unvoiced frame - keep as 0
             modifiedF0[i] = 0.0;
         }
     }
 
-    // Step 5: Synthesis with modified F0 but same frame count = same duration
-    int outputLength = inputLength;  // Same length as input!
-    std::vector<double> y(outputLength);
+    // Silence and unvoiced stretches keep the original samples; each voiced
+    // range is resynthesized (same frame count = same duration) and
+    // crossfaded in over its margin frames
+    std::vector<float> output = analysis.source;
+    std::vector<float> segment;
+    const int fade = analysis.frameToSample(kVoicedMargin);
+
+    for (const WorldFrameRange& range : analysis.voicedRanges) {
+        const int first = analysis.frameToSample(range.begin);
+        const int length = rangeEndSample(analysis, range) - first;
+        if (length <= 0) {
+            continue;
+        }
+
+        // World takes row pointers; the analysis itself is never modified.
+        // Pulses overlap-add straight into the float segment.
+        segment.resize(length);
+        SynthesisFloat(modifiedF0.data() + range.begin, range.end - range.begin,
+                       analysis.spectrogram.getRowPointers() + range.begin,
+                       analysis.aperiodicity.getRowPointers() + range.begin,
+                       analysis.fftSize, analysis.framePeriod, analysis.sampleRate,
+                       length, segment.data());
+
+        float* target = output.data() + analysis.analysisStart + first;
+        for (int i = 0; i < length; ++i) {
+            target[i] += crossfadeWeight(i, length, fade) * (segment[i] - target[i]);
+        }
+    }
+
+    return output;
+}
+
+//------------------------------------------------------------------------
+// WorldStreamSynthesizer Implementation
+//------------------------------------------------------------------------
+struct WorldStreamSynthesizer::Impl {
+    WorldSynthesizer synth;
+    bool initialized = false;
+};
+
+//------------------------------------------------------------------------
+WorldStreamSynthesizer::WorldStreamSynthesizer()
+    : impl_(std::make_unique<Impl>()) {
+}
+
+//------------------------------------------------------------------------
+WorldStreamSynthesizer::~WorldStreamSynthesizer() {
+    reset();
+}
+
+//------------------------------------------------------------------------
+void WorldStreamSynthesizer::reset() {
+    if (impl_->initialized) {
+        DestroySynthesizer(&impl_->synth);
+        impl_->initialized = false;
+    }
+    analysis_.reset();
+    remaining_ = 0;
+    sourcePos_ = 0;
+    passthrough_ = false;
+    range_ = 0;
+    rangeActive_ = false;
+}
+
+//------------------------------------------------------------------------
+bool WorldStreamSynthesizer::start(std::shared_ptr<const WorldAnalysis> analysis, double ratio, int blockSize) {
+    reset();
+
+    if (!analysis || analysis->inputLength <= 0 || blockSize <= 0) {
+        return false;
+    }
 
-    Synthesis(modifiedF0.data(), f0Length,
-              spectrogram, aperiodicity,
-              fftSize, framePeriod_, sampleRate_,
-              outputLength, y.data());
+    analysis_ = std::move(analysis);
+    blockSize_ = blockSize;
+    remaining_ = analysis_->inputLength;
 
-    // Convert back to float
-    std::vector<float> output(outputLength);
-    for (int i = 0; i < outputLength; ++i) {
-        output[i] = static_cast<float>(y[i]);
+    if (!analysis_->isValid() || ratio <= 0 || std::abs(ratio - 1.0) < 0.001) {
+        passthrough_ = true;
+        return true;
     }
 
-    // Cleanup
+    // AddParameters() keeps pointers: scaled F0 lives here, the row tables
+    // belong to the analysis, which is held until the stream ends
+    int f0Length = analysis_->getFrameCount();
+    f0_.resize(f0Length);
     for (int i = 0; i < f0Length; ++i) {
-        delete[] spectrogram[i];
-        delete[] aperiodicity[i];
+        f0_[i] = (analysis_->f0[i] > 0) ? analysis_->f0[i] * ratio : 0.0;
     }
-    delete[] spectrogram;
-    delete[] aperiodicity;
 
-    return output;
+    // One voiced range is queued at a time, so one parameter slot is enough
+    InitializeSynthesizer(analysis_->sampleRate, analysis_->framePeriod, analysis_->fftSize,
+                          blockSize_, 1, &impl_->synth);
+    impl_->initialized = true;
+    return true;
+}
+
+//------------------------------------------------------------------------
+void WorldStreamSynthesizer::startRange(size_t range) {
+    const WorldFrameRange& frames = analysis_->voicedRanges[range];
+
+    // World stops about a block before its last pulse; queue enough extra
+    // frames that the shortfall lands after the range's fade-out
+    const double samplesPerFrame = analysis_->framePeriod * analysis_->sampleRate / 1000.0;
+    const int extraFrames = static_cast<int>(blockSize_ / samplesPerFrame) + 1;
+    const int end = (std::min)(analysis_->getFrameCount(), frames.end + extraFrames);
+
+    RefreshSynthesizer(&impl_->synth);
+    AddParameters(f0_.data() + frames.begin, end - frames.begin,
+                  analysis_->spectrogram.getRowPointers() + frames.begin,
+                  analysis_->aperiodicity.getRowPointers() + frames.begin, &impl_->synth);
+    bufferPos_ = blockSize_;
+    rangeActive_ = true;
+}
+
+//------------------------------------------------------------------------
+float WorldStreamSynthesizer::pullSynthesized() {
+    if (bufferPos_ >= blockSize_) {
+        if (Synthesis2(&impl_->synth) == 0) {
+            return 0.0f;
+        }
+        bufferPos_ = 0;
+    }
+    return static_cast<float>(impl_->synth.buffer[bufferPos_++]);
+}
+
+//------------------------------------------------------------------------
+int WorldStreamSynthesizer::process(float* output) {
+    if (!analysis_ || remaining_ <= 0) {
+        return 0;
+    }
+
+    int count = (std::min)(blockSize_, remaining_);
+
+    // The original plays outside the voiced ranges (and throughout at ratio 1.0)
+    const float* source = analysis_->source.data() + sourcePos_;
+    std::copy(source, source + count, output);
+
+    const std::vector<WorldFrameRange>& ranges = analysis_->voicedRanges;
+    const int fade = analysis_->frameToSample(kVoicedMargin);
+    int i = 0;
+    while (!passthrough_ && i < count && range_ < ranges.size()) {
+        const int first = analysis_->analysisStart + analysis_->frameToSample(ranges[range_].begin);
+        const int last = analysis_->analysisStart + rangeEndSample(*analysis_, ranges[range_]);
+        const int position = sourcePos_ + i;
+
+        if (position < first) {
+            i += (std::min)(count - i, first - position);
+            continue;
+        }
+        if (position >= last) {
+            ++range_;
+            rangeActive_ = false;
+            continue;
+        }
+
+        if (!rangeActive_) {
+            startRange(range_);
+        }
+        const float synthesized = pullSynthesized();
+        output[i] += crossfadeWeight(position - first, last - first, fade) * (synthesized - output[i]);
+        ++i;
+    }
+
+    sourcePos_ += count;
+    remaining_ -= count;
+    return count;
 }
 
 //------------------------------------------------------------------------
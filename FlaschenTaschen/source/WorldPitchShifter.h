@@ -4,22 +4,152 @@
 
 #pragma once
 
+#include "PitchShifter.h"
+
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
 #include <cstdint>
 
+struct WorldWorkspace;
+
 namespace FlaschenTaschen {
 
+class ThreadPool;
+
+//------------------------------------------------------------------------
+// WorldMatrix - rows x cols doubles in one contiguous block
+// Rows start on 64-byte boundaries (the stride is padded), and a row
+// pointer table gives World's double** API a view of the same storage.
+//------------------------------------------------------------------------
+class WorldMatrix {
+public:
+    WorldMatrix() = default;
+    WorldMatrix(const WorldMatrix& other);
+    WorldMatrix& operator=(const WorldMatrix& other);
+    WorldMatrix(WorldMatrix&& other) noexcept;
+    WorldMatrix& operator=(WorldMatrix&& other) noexcept;
+
+    // Reshape to rows x cols, every element set to value. Existing
+    // capacity is reused when the new shape fits.
+    void assign(int rows, int cols, double value = 0.0);
+
+    int getRows() const { return rows_; }
+    int getCols() const { return cols_; }
+    bool empty() const { return rows_ == 0; }
+
+    double* operator[](int row) { return rowPointers_[row]; }
+    const double* operator[](int row) const { return rowPointers_[row]; }
+
+    // Row table for World. World takes double** even where it only reads.
+    double** getRowPointers() { return rowPointers_.data(); }
+    double** getRowPointers() const { return const_cast<double**>(rowPointers_.data()); }
+
+    size_t getMemorySize() const;
+
+private:
+    static constexpr int kAlignment = 64;
+    static constexpr int kAlignDoubles = kAlignment / static_cast<int>(sizeof(double));
+
+    void buildRowPointers();
+
+    std::vector<double> storage_;       // Over-allocated for alignment
+    std::vector<double*> rowPointers_;
+    int rows_ = 0;
+    int cols_ = 0;
+    int stride_ = 0;                    // cols_ rounded up to kAlignDoubles
+};
+
+//------------------------------------------------------------------------
+// WorldAnalysisSettings - F0 estimation cost/quality trade-off
+//------------------------------------------------------------------------
+enum class F0Estimator {
+    Dio,        // Fast, band count follows the F0 range
+    Harvest     // Most robust, several times slower (offline use)
+};
+
+struct WorldAnalysisSettings {
+    F0Estimator estimator = F0Estimator::Dio;
+    int dioSpeed = 1;           // DIO decimation (1 = best, 12 = fastest)
+    double f0Floor = 71.0;      // Hz
+    double f0Ceil = 800.0;      // Hz
+};
+
+//------------------------------------------------------------------------
+// WorldFrameRange - frames [begin, end) of an analysis
+//------------------------------------------------------------------------
+struct WorldFrameRange {
+    int begin = 0;
+    int end = 0;
+};
+
+//------------------------------------------------------------------------
+// WorldAnalysis - World vocoder parameters of one utterance
+// Produced once by WorldPitchShifter::analyze(), then resynthesized at
+// any pitch with WorldPitchShifter::synthesize(). Leading and trailing
+// silence is not analyzed, and only the voiced ranges (plus a margin) are
+// resynthesized; everything else plays the original samples.
+//------------------------------------------------------------------------
+struct WorldAnalysis {
+    int sampleRate = 0;
+    int inputLength = 0;        // Samples in the original signal
+    int analysisStart = 0;      // Sample of frame 0 (leading silence skipped)
+    int analysisLength = 0;     // Samples covered by the frames
+    int fftSize = 0;
+    double framePeriod = 5.0;   // ms
+
+    std::vector<float> source;  // Original signal (returned for ratio 1.0)
+    std::vector<double> f0;
+    std::vector<double> temporalPositions;
+    WorldMatrix spectrogram;    // frames x (fftSize/2 + 1)
+    WorldMatrix aperiodicity;   // frames x (fftSize/2 + 1)
+    std::vector<WorldFrameRange> voicedRanges;  // Resynthesized frames, increasing
+
+    // Time spent in each analysis step (microseconds)
+    int64_t f0Micros = 0;
+    int64_t spectrumMicros = 0;
+    int64_t aperiodicityMicros = 0;
+
+    int getFrameCount() const { return static_cast<int>(f0.size()); }
+    bool isValid() const { return inputLength > 0 && !f0.empty(); }
+
+    // First sample of a frame, relative to analysisStart
+    int frameToSample(int frame) const;
+
+    // Approximate memory footprint in bytes
+    size_t getMemorySize() const;
+};
+
+//------------------------------------------------------------------------
+// WorldCodedAnalysis - a WorldAnalysis with compressed spectra
+// World's codec keeps a mel-cepstrum of dims coefficients and a few band
+// aperiodicities per frame instead of fftSize/2 + 1 bins of each, which
+// is 10-40x smaller. Decoded back to a WorldAnalysis for synthesis.
+//------------------------------------------------------------------------
+struct WorldCodedAnalysis {
+    WorldAnalysis frames;       // Everything except spectrogram/aperiodicity
+    int dims = 0;
+    WorldMatrix spectrum;       // frames x dims
+    WorldMatrix aperiodicity;   // frames x GetNumberOfAperiodicities(sampleRate)
+
+    size_t getMemorySize() const;
+};
+
 //------------------------------------------------------------------------
 // WorldPitchShifter - Pitch shifting using World vocoder
 // Analyzes audio, modifies F0 (pitch), and resynthesizes
 //------------------------------------------------------------------------
-class WorldPitchShifter {
+class WorldPitchShifter : public PitchShifter {
 public:
     WorldPitchShifter();
-    ~WorldPitchShifter();
+    ~WorldPitchShifter() override;
 
     // Initialize with sample rate
-    void initialize(int sampleRate);
+    void initialize(int sampleRate) override;
+
+    // Analyze and resynthesize in one pass
+    std::vector<float> shift(const std::vector<float>& input, double ratio) override;
 
     // Set target pitch as MIDI note (60 = C4 = 261.63 Hz)
     void setTargetMidiNote(int midiNote);
@@ -38,23 +168,107 @@ public:
     // Process with specific target frequency
     std::vector<float> processToFrequency(const std::vector<float>& input, double targetFreqHz);
 
-    // Get current settings
-    int getSampleRate() const { return sampleRate_; }
-    double getPitchShiftRatio() const { return pitchShiftRatio_; }
+    // Spread analysis across a pool's workers (nullptr = single-threaded).
+    // The pool is not owned and must outlive analysis calls.
+    void setThreadPool(ThreadPool* pool) { threadPool_ = pool; }
+
+    // Settings used by analyze(input) and shift()
+    void setAnalysisSettings(const WorldAnalysisSettings& settings) { settings_ = settings; }
+    const WorldAnalysisSettings& getAnalysisSettings() const { return settings_; }
+
+    // Run F0/spectral envelope/aperiodicity analysis (DIO or Harvest, CheapTrick, D4C)
+    WorldAnalysis analyze(const std::vector<float>& input) const;
+    WorldAnalysis analyze(const std::vector<float>& input, const WorldAnalysisSettings& settings) const;
 
-    // Convert MIDI note to frequency
-    static double midiNoteToFrequency(int midiNote);
+    // Analyze many independent inputs (pre-bake, offline export); each
+    // result equals analyze(input, settings). F0 estimation runs for
+    // several inputs side by side, and CheapTrick/D4C work through the
+    // frames of all inputs together, sharing FFT setup and windows, so short
+    // syllables still keep every pool worker busy.
+    std::vector<WorldAnalysis> analyzeBatch(const std::vector<std::vector<float>>& inputs,
+                                            const WorldAnalysisSettings& settings) const;
 
-    // Convert frequency to MIDI note
-    static int frequencyToMidiNote(double frequency);
+    // Resynthesize an analysis with F0 scaled by ratio (duration unchanged)
+    std::vector<float> synthesize(const WorldAnalysis& analysis, double ratio) const;
+
+    // Re-map an analysis to another sample rate (same frames, spectral
+    // envelopes re-sampled in frequency), so synthesis can render directly at
+    // the output rate instead of resampling its result
+    static WorldAnalysis convertSampleRate(const WorldAnalysis& analysis, int targetRate);
+
+    // Compress an analysis with World's codec (lossy; see WorldCodedAnalysis)
+    // and expand it again
+    static WorldCodedAnalysis encode(const WorldAnalysis& analysis, int dims);
+    static WorldAnalysis decode(const WorldCodedAnalysis& coded);
+
+    // Get current settings
+    int getSampleRate() const override { return sampleRate_; }
+    double getPitchShiftRatio() const { return pitchShiftRatio_; }
 
 private:
     int sampleRate_ = 44100;
     double pitchShiftRatio_ = 1.0;
     double framePeriod_ = 5.0;  // ms
+    ThreadPool* threadPool_ = nullptr;
+    WorldAnalysisSettings settings_;
+
+    // Scratch reused by every analyze() call; buffers only grow, so steady
+    // state analysis does not reallocate them
+    struct AnalysisContext {
+        std::vector<double> x;      // Input converted to double
+        WorldWorkspace* workspace = nullptr;  // DIO/CheapTrick/D4C scratch and FFTs
+    };
+    mutable AnalysisContext context_;
+    mutable std::mutex contextMutex_;
+};
+
+//------------------------------------------------------------------------
+// WorldStreamSynthesizer - block-wise resynthesis of a WorldAnalysis
+// Wraps World's realtime synthesizer (synthesisrealtime), so the first
+// block of a pitch-shifted syllable is available long before the whole
+// utterance has been synthesized.
+//------------------------------------------------------------------------
+class WorldStreamSynthesizer {
+public:
+    static constexpr int kDefaultBlockSize = 256;
+
+    WorldStreamSynthesizer();
+    ~WorldStreamSynthesizer();
+
+    WorldStreamSynthesizer(const WorldStreamSynthesizer&) = delete;
+    WorldStreamSynthesizer& operator=(const WorldStreamSynthesizer&) = delete;
+
+    // Begin resynthesizing analysis with F0 scaled by ratio. The analysis is
+    // kept alive until the stream finishes or is restarted.
+    bool start(std::shared_ptr<const WorldAnalysis> analysis, double ratio, int blockSize = kDefaultBlockSize);
+
+    // Produce the next block into output (blockSize floats). Returns the
+    // number of valid samples, 0 once the utterance is complete.
+    int process(float* output);
+
+    // Release the synthesizer and analysis
+    void reset();
+
+    bool isActive() const { return analysis_ != nullptr; }
+    int getBlockSize() const { return blockSize_; }
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+
+    // Next resynthesized sample of the current voiced range (0 once World runs out)
+    float pullSynthesized();
+    void startRange(size_t range);
 
-    // Internal processing
-    std::vector<float> pitchShiftWorld(const std::vector<float>& input, double ratio);
+    std::shared_ptr<const WorldAnalysis> analysis_;
+    std::vector<double> f0_;
+    int blockSize_ = kDefaultBlockSize;
+    int remaining_ = 0;          // Samples left before the original length is reached
+    bool passthrough_ = false;   // Ratio 1.0: stream the source unchanged
+    int sourcePos_ = 0;
+    size_t range_ = 0;           // Voiced range being resynthesized
+    bool rangeActive_ = false;
+    int bufferPos_ = 0;          // Read position in World's output block
 };
 
 //------------------------------------------------------------------------
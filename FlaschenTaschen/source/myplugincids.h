@@ -14,5 +14,14 @@ static const Steinberg::FUID kFTVoxControllerUID (0x663075D2, 0x7E925171, 0xBEA6
 
 #define FTVoxVST3Category "Instrument"
 
+// Mapping load progress, sent by the processor as "MappingStatus" {State, Error}
+enum MappingLoadState : Steinberg::int64 {
+    kMappingIdle = 0,
+    kMappingLoading,        // Queued or parsing
+    kMappingConnecting,     // Parsed; reconnecting the display
+    kMappingReady,          // Live (pre-bake progress follows separately)
+    kMappingFailed          // Parse failed; the previous mapping stays live
+};
+
 //------------------------------------------------------------------------
 } // namespace FTVox
@@ -10,6 +10,8 @@
 #include "vstgui/lib/cfileselector.h"
 #include "vstgui/lib/cframe.h"
 
+#include <cstring>
+
 using namespace Steinberg;
 
 namespace FTVox {
@@ -81,18 +83,39 @@ tresult PLUGIN_API FTVoxController::initialize(FUnknown* context)
                             Vst::ParameterInfo::kCanAutomate | Vst::ParameterInfo::kIsList,
                             kParamPitchShiftEnabled);
 
+    // Pitch Engine (World / Fast PSOLA)
+    auto* pitchEngine = new Vst::StringListParameter(STR16("Pitch Engine"), kParamPitchEngine);
+    pitchEngine->appendString(STR16("World"));
+    pitchEngine->appendString(STR16("Fast"));
+    parameters.addParameter(pitchEngine);
+
     // Octave Offset (-3 to +3, mapped to 0-1)
     parameters.addParameter(STR16("Octave Offset"), STR16("oct"), 0,
                             0.5, // default 0 (middle)
                             Vst::ParameterInfo::kCanAutomate,
                             kParamOctaveOffset);
 
+    // Runs while the controller lives, so progress is current when an editor opens
+    statusTimer_ = VSTGUI::makeOwned<VSTGUI::CVSTGUITimer>(
+        [this](VSTGUI::CVSTGUITimer*) {
+            requestStatus();
+            if (++statusPolls_ >= kLatencyStatsPolls) {
+                statusPolls_ = 0;
+                requestLatencyStats();
+            }
+        },
+        kStatusPollMs);
+
     return result;
 }
 
 //------------------------------------------------------------------------
 tresult PLUGIN_API FTVoxController::terminate()
 {
+    if (statusTimer_) {
+        statusTimer_->stop();
+        statusTimer_ = nullptr;
+    }
     return EditControllerEx1::terminate();
 }
 
@@ -236,6 +259,8 @@ VSTGUI::CView* FTVoxController::createCustomView(
         label->setFontColor(VSTGUI::CColor(200, 200, 200, 255));
         label->setHoriAlign(VSTGUI::CHoriTxtAlign::kLeftText);
         filePathLabel_ = label;
+        updateFilePathLabel();
+        requestLatencyStats();
         return label;
     }
 
@@ -246,6 +271,9 @@ VSTGUI::CView* FTVoxController::createCustomView(
 void FTVoxController::willClose(VSTGUI::VST3Editor* editor)
 {
     (void)editor;
+
+    // The label is owned by the editor's view hierarchy
+    filePathLabel_ = nullptr;
 }
 
 //------------------------------------------------------------------------
@@ -254,15 +282,97 @@ tresult PLUGIN_API FTVoxController::notify(Vst::IMessage* message)
     if (!message)
         return kInvalidArgument;
 
-    // Handle messages from processor if needed
+    if (strcmp(message->getMessageID(), "PrebakeProgress") == 0)
+    {
+        Steinberg::int64 done = 0;
+        Steinberg::int64 total = 0;
+        if (message->getAttributes()->getInt("Done", done) == kResultOk &&
+            message->getAttributes()->getInt("Total", total) == kResultOk)
+        {
+            prebakeDone_ = done;
+            prebakeTotal_ = total;
+            updateFilePathLabel();
+        }
+        return kResultOk;
+    }
+
+    if (strcmp(message->getMessageID(), "MappingStatus") == 0)
+    {
+        Steinberg::int64 state = kMappingIdle;
+        if (message->getAttributes()->getInt("State", state) == kResultOk)
+        {
+            mappingState_ = state;
+            if (state == kMappingLoading) {
+                prebakeDone_ = 0;
+                prebakeTotal_ = 0;
+            }
+
+            const void* data = nullptr;
+            Steinberg::uint32 size = 0;
+            mappingError_.clear();
+            if (message->getAttributes()->getBinary("Error", data, size) == kResultOk && data) {
+                mappingError_.assign(static_cast<const char*>(data), size);
+            }
+            updateFilePathLabel();
+        }
+        return kResultOk;
+    }
+
+    if (strcmp(message->getMessageID(), "LatencyStats") == 0)
+    {
+        const void* data = nullptr;
+        Steinberg::uint32 size = 0;
+        if (message->getAttributes()->getBinary("Report", data, size) == kResultOk &&
+            data && size == sizeof(FlaschenTaschen::LatencyReport))
+        {
+            std::memcpy(&latencyReport_, data, sizeof(latencyReport_));
+            hasLatencyReport_ = true;
+            updateFilePathLabel();
+        }
+        return kResultOk;
+    }
+
+    // New mapping changed the look-ahead: the host re-queries getLatencySamples
+    if (strcmp(message->getMessageID(), "LatencyChanged") == 0)
+    {
+        if (componentHandler) {
+            componentHandler->restartComponent(Vst::kLatencyChanged);
+        }
+        return kResultOk;
+    }
 
     return EditControllerEx1::notify(message);
 }
 
+//------------------------------------------------------------------------
+void FTVoxController::requestLatencyStats(bool reset)
+{
+    if (auto message = allocateMessage())
+    {
+        message->setMessageID("GetLatencyStats");
+        message->getAttributes()->setInt("Reset", reset ? 1 : 0);
+        sendMessage(message);
+        message->release();
+    }
+}
+
+//------------------------------------------------------------------------
+void FTVoxController::requestStatus()
+{
+    if (auto message = allocateMessage())
+    {
+        message->setMessageID("GetStatus");
+        sendMessage(message);
+        message->release();
+    }
+}
+
 //------------------------------------------------------------------------
 void FTVoxController::sendMappingFilePath(const std::string& path)
 {
     mappingFilePath_ = path;
+    prebakeDone_ = 0;
+    prebakeTotal_ = 0;
 
     // Send message to processor
     if (auto message = allocateMessage())
@@ -275,16 +385,47 @@ void FTVoxController::sendMappingFilePath(const std::string& path)
         message->release();
     }
 
-    // Update file path label if exists
-    if (filePathLabel_) {
-        // Extract just the filename from the path
-        std::string filename = path;
-        size_t lastSlash = path.find_last_of("/\\");
-        if (lastSlash != std::string::npos) {
-            filename = path.substr(lastSlash + 1);
+    updateFilePathLabel();
+}
+
+//------------------------------------------------------------------------
+void FTVoxController::updateFilePathLabel()
+{
+    if (!filePathLabel_) {
+        return;
+    }
+
+    if (hasLatencyReport_) {
+        filePathLabel_->setTooltipText(FlaschenTaschen::LatencyStats::formatReport(latencyReport_).c_str());
+    }
+
+    if (mappingFilePath_.empty()) {
+        filePathLabel_->setText("(no file selected)");
+        return;
+    }
+
+    // Extract just the filename from the path
+    std::string text = mappingFilePath_;
+    size_t lastSlash = text.find_last_of("/\\");
+    if (lastSlash != std::string::npos) {
+        text = text.substr(lastSlash + 1);
+    }
+
+    if (mappingState_ == kMappingLoading) {
+        text += "  (loading...)";
+    } else if (mappingState_ == kMappingConnecting) {
+        text += "  (connecting...)";
+    } else if (mappingState_ == kMappingFailed) {
+        text += "  (load failed: " + mappingError_ + ")";
+    } else if (prebakeTotal_ > 0) {
+        if (prebakeDone_ < prebakeTotal_) {
+            text += "  (pre-baking " + std::to_string(prebakeDone_) + "/" + std::to_string(prebakeTotal_) + ")";
+        } else {
+            text += "  (ready)";
         }
-        filePathLabel_->setText(VSTGUI::UTF8String(filename));
     }
+
+    filePathLabel_->setText(VSTGUI::UTF8String(text));
 }
 
 //------------------------------------------------------------------------
@@ -8,7 +8,10 @@
 #include "vstgui/plugin-bindings/vst3editor.h"
 #include "vstgui/lib/controls/cbuttons.h"
 #include "vstgui/lib/controls/ctextlabel.h"
+#include "vstgui/lib/cvstguitimer.h"
 #include "pluginterfaces/vst/ivstmidicontrollers.h"
+#include "myplugincids.h"
+#include "LatencyStats.h"
 
 #include <string>
 
@@ -67,6 +70,18 @@ public:
     // Open file browser to select mapping file
     void openFileBrowser(VSTGUI::CFrame* frame);
 
+    // Refresh the file path label (file name plus load/pre-bake progress)
+    void updateFilePathLabel();
+
+    // Ask the processor for its latency stats, optionally clearing them first
+    void requestLatencyStats(bool reset = false);
+
+    // Ask the processor for load/pre-bake progress; its replies arrive on this thread
+    void requestStatus();
+
+    // Last latency report from the processor
+    const FlaschenTaschen::LatencyReport& getLatencyReport() const { return latencyReport_; }
+
     //---Interface---------
     DEFINE_INTERFACES
         // DEF_INTERFACE(Steinberg::Vst::IMidiMapping)
@@ -77,6 +92,22 @@ public:
 protected:
     std::string mappingFilePath_;
     VSTGUI::CTextLabel* filePathLabel_ = nullptr;
+
+    // Load and pre-bake progress reported by the processor
+    Steinberg::int64 mappingState_ = kMappingIdle;
+    std::string mappingError_;
+    Steinberg::int64 prebakeDone_ = 0;
+    Steinberg::int64 prebakeTotal_ = 0;
+
+    // Per-stage latency, shown as the file path label's tooltip
+    FlaschenTaschen::LatencyReport latencyReport_;
+    bool hasLatencyReport_ = false;
+
+    // Polls the processor from the UI thread; background threads there never message us
+    static constexpr Steinberg::uint32 kStatusPollMs = 250;
+    static constexpr int kLatencyStatsPolls = 4;   // Latency stats once a second
+    int statusPolls_ = 0;
+    VSTGUI::SharedPointer<VSTGUI::CVSTGUITimer> statusTimer_;
 };
 
 //------------------------------------------------------------------------
@@ -9,6 +9,7 @@
 
 #include "mypluginprocessor.h"
 #include "myplugincids.h"
+#include "AsyncLogger.h"
 
 #include "base/source/fstreamer.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
@@ -16,26 +17,81 @@
 #include "pluginterfaces/vst/ivstevents.h"
 #include "pluginterfaces/vst/ivstmessage.h"
 
-#include <fstream>
 #include <cstring>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <map>
+#include <set>
 
 namespace {
 
-void logToFile(const std::string& message) {
-    std::ofstream logFile("FlaschenTaschenPlugin_log.txt", std::ios::app);
-    if (logFile.is_open()) {
-        logFile << message << std::endl;
-        logFile.close();
-    }
-}
+constexpr const char* kLogFileName = "FlaschenTaschenPlugin_log.txt";
 
 } // anonymous namespace
 
 using namespace Steinberg;
 using namespace FlaschenTaschen;
 
+namespace {
+
+template <typename Sample>
+Sample** busChannels(Vst::AudioBusBuffers& bus);
+
+template <>
+Vst::Sample32** busChannels<Vst::Sample32>(Vst::AudioBusBuffers& bus) { return bus.channelBuffers32; }
+
+template <>
+Vst::Sample64** busChannels<Vst::Sample64>(Vst::AudioBusBuffers& bus) { return bus.channelBuffers64; }
+
+// Mix the voices into the first channel of each output bus (inactive aux
+// buses come without channels; their voices fall back to the main bus),
+// then copy it to the bus's other channels (mono to stereo). Returns the
+// mask of buses that received audio.
+template <typename Sample>
+uint32_t mixBuses(VoicePool& voices, Vst::ProcessData& data, int startSample, int numSamples, int64_t blockStart)
+{
+    const int busCount = (std::min)(static_cast<int>(data.numOutputs), TTSConfig::kMaxBuses);
+
+    // Idle: clear every channel and leave the voice buffers alone
+    if (voices.isIdle()) {
+        for (int bus = 0; bus < busCount; ++bus) {
+            Sample** channels = busChannels<Sample>(data.outputs[bus]);
+            for (int ch = 0; channels && ch < data.outputs[bus].numChannels; ++ch) {
+                std::memset(channels[ch] + startSample, 0, numSamples * sizeof(Sample));
+            }
+        }
+        return 0;
+    }
+
+    Sample* mono[TTSConfig::kMaxBuses] = {};
+    for (int bus = 0; bus < busCount; ++bus) {
+        Sample** channels = busChannels<Sample>(data.outputs[bus]);
+        if (data.outputs[bus].numChannels > 0 && channels && channels[0]) {
+            mono[bus] = channels[0] + startSample;
+            std::memset(mono[bus], 0, numSamples * sizeof(Sample));
+        }
+    }
+    if (!mono[0]) {
+        return 0;
+    }
+
+    const uint32_t sounding = voices.mix(mono, TTSConfig::kMaxBuses, numSamples, blockStart);
+
+    for (int bus = 0; bus < busCount; ++bus) {
+        if (!mono[bus]) {
+            continue;
+        }
+        Sample** channels = busChannels<Sample>(data.outputs[bus]);
+        for (int ch = 1; ch < data.outputs[bus].numChannels; ++ch) {
+            std::memcpy(channels[ch] + startSample, mono[bus], numSamples * sizeof(Sample));
+        }
+    }
+    return sounding;
+}
+
+} // anonymous namespace
+
 namespace FTVox {
 
 //------------------------------------------------------------------------
@@ -44,6 +100,9 @@ namespace FTVox {
 FTVoxProcessor::FTVoxProcessor()
 {
     setControllerClass(kFTVoxControllerUID);
+
+    voicePool_.setLatencyStats(&latencyStats_);
+    display_.setLatencyStats(&latencyStats_);
 }
 
 //------------------------------------------------------------------------
@@ -60,22 +119,34 @@ tresult PLUGIN_API FTVoxProcessor::initialize(FUnknown* context)
         return result;
     }
 
-    // Create stereo audio output for TTS
+    // Shared by all instances; records are written by a background thread
+    AsyncLogger::instance().acquire(kLogFileName);
+
+    // Create stereo audio output for TTS, plus the aux buses <TTS outputs>
+    // routes voices to (off until the host activates them)
+    static const Vst::TChar* const kAuxBusNames[TTSConfig::kMaxBuses - 1] = {
+        STR16("Bus 1"), STR16("Bus 2"), STR16("Bus 3"), STR16("Bus 4"),
+        STR16("Bus 5"), STR16("Bus 6"), STR16("Bus 7")};
     addAudioOutput(STR16("Stereo Out"), Steinberg::Vst::SpeakerArr::kStereo);
+    for (const Vst::TChar* name : kAuxBusNames) {
+        addAudioOutput(name, Steinberg::Vst::SpeakerArr::kStereo, Vst::kAux, 0);
+    }
 
     // Add MIDI event input
     addEventInput(STR16("Event In"), 1);
 
-    // Initialize FlaschenTaschen client
-    ftClient_ = std::make_unique<FlaschenTaschenClient>();
-
     // Initialize TTS synthesizer
     tts_ = std::make_unique<ESpeakSynthesizer>();
 
-    // Initialize pitch shifter
+    // Initialize pitch shifter; analysis borrows the bake pool's workers
     pitchShifter_ = std::make_unique<WorldPitchShifter>();
+    pitchShifter_->setThreadPool(&bakePool_);
+    fastShifter_ = std::make_unique<PsolaPitchShifter>();
 
-    logToFile("FlaschenTaschen plugin initialized");
+    // Mapping files are parsed off the UI and audio threads
+    configLoader_.start(1);
+
+    FT_LOG_INFO("FlaschenTaschen plugin initialized");
 
     return kResultOk;
 }
@@ -83,10 +154,17 @@ tresult PLUGIN_API FTVoxProcessor::initialize(FUnknown* context)
 //------------------------------------------------------------------------
 tresult PLUGIN_API FTVoxProcessor::terminate()
 {
+    // Finish with mappings first: a pending load would restart the display
+    configLoader_.stop();
+
+    // Stop rendering before tearing down the engines it uses
+    renderWorker_.stop();
+    bakePool_.stop();
+
     // Disconnect from server
-    if (ftClient_) {
-        ftClient_->disconnect();
-        ftClient_.reset();
+    {
+        std::lock_guard<std::mutex> lock(displayMutex_);
+        display_.stop();
     }
 
     // Shutdown TTS
@@ -95,7 +173,8 @@ tresult PLUGIN_API FTVoxProcessor::terminate()
         tts_.reset();
     }
 
-    logToFile("FlaschenTaschen plugin terminated");
+    FT_LOG_INFO("FlaschenTaschen plugin terminated");
+    AsyncLogger::instance().release();
 
     return AudioEffect::terminate();
 }
@@ -106,52 +185,57 @@ tresult PLUGIN_API FTVoxProcessor::setActive(TBool state)
     if (state)
     {
         // Activate: Connect to FlaschenTaschen server if config loaded
-        if (configLoaded_) {
-            std::lock_guard<std::mutex> lock(configMutex_);
-            const auto& server = config_.getServerConfig();
-            const auto& display = config_.getDisplayConfig();
-
-            ftClient_->setDisplaySize(display.width, display.height);
-            ftClient_->setOffset(display.offsetX, display.offsetY);
-            ftClient_->setLayer(display.layer);
-
-            if (ftClient_->connect(server.ip, server.port)) {
-                ftConnected_ = true;
-                logToFile("Connected to FlaschenTaschen server: " + server.ip + ":" + std::to_string(server.port));
-
-                // Clear display
-                ftClient_->clear();
-                ftClient_->send();
-            } else {
-                logToFile("Failed to connect to FlaschenTaschen server: " + ftClient_->getLastError());
-            }
+        active_ = true;
+        display_.setSampleRate(sampleRate_);
+        if (offline_) {
+            FT_LOG_INFO("Offline render: notes render synchronously, display off");
+        } else if (auto config = mappingConfig_.get()) {
+            startDisplay(*config);
         }
 
-        // Initialize TTS at eSpeak native rate (22050 Hz)
-        if (tts_ && !tts_->isInitialized()) {
-            ttsSampleRate_ = 22050;  // eSpeak's preferred rate
-            if (tts_->initialize(ttsSampleRate_)) {
-                ttsSampleRate_ = tts_->getSampleRate();  // Get actual rate
-                logToFile("TTS initialized at sample rate: " + std::to_string(ttsSampleRate_));
-                logToFile("Output sample rate: " + std::to_string(sampleRate_) + " (will resample)");
-            } else {
-                logToFile("TTS initialization failed: " + tts_->getLastError());
-            }
+        // Size the voice buffers for the current output rate (nothing is streaming yet)
+        voicePool_.allocate(static_cast<size_t>(sampleRate_ * kVoiceBufferSeconds));
+
+        // Workers for pre-baking and parallel analysis (leave one core for the audio thread)
+        if (!bakePool_.isRunning()) {
+            unsigned cores = std::thread::hardware_concurrency();
+            bakePool_.start(cores > 1 ? cores - 1 : 1);
         }
 
-        // Initialize pitch shifter at TTS sample rate
-        if (pitchShifter_) {
-            pitchShifter_->initialize(ttsSampleRate_);
-            logToFile("Pitch shifter initialized at " + std::to_string(ttsSampleRate_) + " Hz");
+        // Start the background renderer; from here on only the worker touches tts_/pitchShifter_.
+        // eSpeak loads there too, so activation doesn't wait for it
+        engineInitTried_ = false;
+        renderWorker_.start([this](const RenderJob& job) { renderNote(job); });
+        renderWorker_.post([this]() { initializeEngines(); });
+
+        // Analyze (or fully pre-bake) the mapped syllables up front
+        if (auto config = mappingConfig_.get()) {
+            if (config->getTTSConfig().prebake) {
+                schedulePrebake(*config);
+            } else {
+                scheduleAnalysisWarmup(config->getSyllables());
+            }
         }
     }
     else
     {
-        // Deactivate: Disconnect
-        if (ftClient_) {
-            ftClient_->disconnect();
-            ftConnected_ = false;
+        // Deactivate: Stop rendering
+        active_ = false;
+        renderWorker_.stop();
+        bakePool_.stop();
+
+        // Disconnect
+        {
+            std::lock_guard<std::mutex> lock(displayMutex_);
+            display_.stop();
+            FT_LOG_INFO("Display: %d frames sent, %d dropped, %d late, %d updates coalesced",
+                        display_.getFramesSent(), display_.getDroppedFrames(), display_.getLateFrames(),
+                        display_.getCoalescedUpdates());
         }
+
+        // process() is no longer called, so retired mappings can go
+        mappingConfig_.quiescent();
+        mappingConfig_.reclaim();
     }
 
     return AudioEffect::setActive(state);
@@ -160,147 +244,388 @@ tresult PLUGIN_API FTVoxProcessor::setActive(TBool state)
 //------------------------------------------------------------------------
 tresult PLUGIN_API FTVoxProcessor::process(Vst::ProcessData& data)
 {
-    // Process parameter changes
-    if (data.inputParameterChanges)
+    // Display timeline: what is heard now is about one block behind what is
+    // being rendered, so events are shown when their sample actually plays
+    display_.updateClock(samplePosition_ - data.numSamples);
+
+    const bool outputs = data.numSamples > 0 && data.numOutputs > 0 && data.outputs[0].numChannels > 0;
+    uint32_t sounding = 0;  // Buses that received audio this block
+
+    // The block is split at every event: audio up to the event is mixed and
+    // parameters take their value at the event's sample before it is handled,
+    // so notes start and read settings exactly where the host placed them
+    // Look-ahead: notes are rendered as soon as they arrive but play (and
+    // light up) that much later; the host compensates via getLatencySamples
+    const int64_t lookAhead = lookAheadSamples_.load(std::memory_order_relaxed);
+    snapshotParameters(data.inputParameterChanges);
+    int32 cursor = 0;
+    if (data.inputEvents)
     {
-        int32 numParamsChanged = data.inputParameterChanges->getParameterCount();
-        for (int32 index = 0; index < numParamsChanged; index++)
+        for (int32 i = 0; i < data.inputEvents->getEventCount(); i++)
         {
-            if (auto* paramQueue = data.inputParameterChanges->getParameterData(index))
+            Vst::Event event;
+            if (data.inputEvents->getEvent(i, event) != kResultOk)
+                continue;
+
+            const int32 offset = (std::max)(cursor, (std::min)(event.sampleOffset, data.numSamples));
+            if (outputs && offset > cursor) {
+                sounding |= processTTSAudio(data, cursor, offset - cursor);
+            }
+            cursor = offset;
+            applyParameterChanges(data.inputParameterChanges, offset);
+
+            const int64_t sampleTime = samplePosition_ + offset + lookAhead;
+            switch (event.type)
             {
-                Vst::ParamValue value;
-                int32 sampleOffset;
-                int32 numPoints = paramQueue->getPointCount();
-                if (paramQueue->getPoint(numPoints - 1, sampleOffset, value) == kResultTrue)
-                {
-                    switch (paramQueue->getParameterId())
-                    {
-                        case kParamFontScale:
-                            fontScale_ = static_cast<float>(value);
-                            font_.setScale(1 + static_cast<int>(value * 4)); // 1-5 scale
-                            break;
-                        case kParamColorR:
-                            colorR_ = static_cast<float>(value);
-                            break;
-                        case kParamColorG:
-                            colorG_ = static_cast<float>(value);
-                            break;
-                        case kParamColorB:
-                            colorB_ = static_cast<float>(value);
-                            break;
-                        case kParamTTSEnabled:
-                            ttsEnabled_ = value > 0.5;
-                            break;
-                        case kParamTTSRate:
-                            ttsRate_ = static_cast<float>(value);
-                            if (tts_ && tts_->isInitialized()) {
-                                tts_->setRate(80 + static_cast<int>(value * 370)); // 80-450
-                            }
-                            break;
-                        case kParamTTSPitch:
-                            ttsPitch_ = static_cast<float>(value);
-                            if (tts_ && tts_->isInitialized()) {
-                                tts_->setPitch(static_cast<int>(value * 99)); // 0-99
-                            }
-                            break;
-                        case kParamTTSVolume:
-                            ttsVolume_ = static_cast<float>(value);
-                            if (tts_ && tts_->isInitialized()) {
-                                tts_->setVolume(static_cast<int>(value * 200)); // 0-200
-                            }
-                            break;
-                        case kParamPitchShiftEnabled:
-                            pitchShiftEnabled_ = value > 0.5;
-                            break;
-                        case kParamOctaveOffset:
-                            // Map 0-1 to -3 to +3 octaves
-                            octaveOffset_ = static_cast<int>(std::round(value * 6.0 - 3.0));
-                            break;
-                    }
-                }
+                case Vst::Event::kNoteOnEvent:
+                    // How far into the block the note lands (delay behind the block start)
+                    latencyStats_.record(LatencyStage::EventOffset,
+                                         static_cast<int64_t>(offset * 1e6 / sampleRate_));
+                    handleNoteOn(event.noteOn.pitch, static_cast<int>(event.noteOn.velocity * 127), sampleTime);
+                    break;
+
+                case Vst::Event::kNoteOffEvent:
+                    handleNoteOff(event.noteOff.pitch, sampleTime);
+                    break;
+
+                case Vst::Event::kPolyPressureEvent:
+                    handlePolyPressure(event.polyPressure.pitch,
+                                       static_cast<int>(event.polyPressure.pressure * 127), sampleTime);
+                    break;
+
+                default:
+                    break;
             }
         }
     }
 
-    // Process MIDI events
-    if (data.inputEvents)
+    // Rest of the block, and every parameter's final value
+    if (outputs && cursor < data.numSamples) {
+        sounding |= processTTSAudio(data, cursor, data.numSamples - cursor);
+    }
+    applyParameterChanges(data.inputParameterChanges, data.numSamples);
+
+    // Tell the host which buses are silent, so effects after an idle
+    // instance can skip their work
+    for (int32 bus = 0; bus < data.numOutputs; ++bus) {
+        const int32 channels = (std::min)(data.outputs[bus].numChannels, 64);
+        const bool silent = bus >= TTSConfig::kMaxBuses || (sounding & (1u << bus)) == 0;
+        data.outputs[bus].silenceFlags = silent && channels > 0 ? ~uint64(0) >> (64 - channels) : 0;
+    }
+
+    // What was just rendered, for <Display spectrum> (the main bus's left
+    // channel); silence is left out, the display lets the levels fall
+    if (outputs && (sounding & 1u) != 0) {
+        if (data.symbolicSampleSize == Vst::kSample64) {
+            display_.pushAudio(data.outputs[0].channelBuffers64[0], data.numSamples);
+        } else {
+            display_.pushAudio(data.outputs[0].channelBuffers32[0], data.numSamples);
+        }
+    }
+
+    samplePosition_ += data.numSamples;
+
+    // No mapping snapshot is held past this point
+    mappingConfig_.quiescent();
+
+    return kResultOk;
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::snapshotParameters(Vst::IParameterChanges* changes)
+{
+    if (!changes) {
+        return;
+    }
+
+    const int32 numParamsChanged = changes->getParameterCount();
+    for (int32 index = 0; index < numParamsChanged; index++)
     {
-        for (int32 i = 0; i < data.inputEvents->getEventCount(); i++)
-        {
-            Vst::Event event;
-            if (data.inputEvents->getEvent(i, event) == kResultOk)
-            {
-                switch (event.type)
-                {
-                    case Vst::Event::kNoteOnEvent:
-                        handleNoteOn(event.noteOn.pitch, static_cast<int>(event.noteOn.velocity * 127));
-                        break;
+        Vst::IParamValueQueue* queue = changes->getParameterData(index);
+        if (!queue)
+            continue;
 
-                    case Vst::Event::kNoteOffEvent:
-                        handleNoteOff(event.noteOff.pitch);
-                        break;
+        const Vst::ParamID id = queue->getParameterId();
+        if (id >= kParamFontScale && id <= kParamPitchEngine) {
+            blockStartValues_[id - kParamFontScale] = getParameterValue(id);
+        }
+    }
+}
 
-                    default:
-                        break;
-                }
+//------------------------------------------------------------------------
+void FTVoxProcessor::applyParameterChanges(Vst::IParameterChanges* changes, int32 sampleOffset)
+{
+    if (!changes) {
+        return;
+    }
+
+    const int32 numParamsChanged = changes->getParameterCount();
+    for (int32 index = 0; index < numParamsChanged; index++)
+    {
+        Vst::IParamValueQueue* queue = changes->getParameterData(index);
+        if (!queue || queue->getPointCount() <= 0)
+            continue;
+
+        const Vst::ParamID id = queue->getParameterId();
+        if (id < kParamFontScale || id > kParamPitchEngine)
+            continue;
+
+        Vst::ParamValue value = 0.0;
+        if (valueAtOffset(*queue, sampleOffset, isRampedParameter(id), blockStartValues_[id - kParamFontScale], value) &&
+            static_cast<float>(value) != static_cast<float>(getParameterValue(id))) {
+            setParameter(id, value);
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+bool FTVoxProcessor::valueAtOffset(Vst::IParamValueQueue& queue, int32 sampleOffset, bool ramped,
+                                   Vst::ParamValue blockStart, Vst::ParamValue& value)
+{
+    // Segments run from the previous point (or offset 0 at the block's
+    // starting value) to each point; discrete parameters step at the point
+    Vst::ParamValue previousValue = blockStart;
+    int32 previousOffset = 0;
+    const int32 numPoints = queue.getPointCount();
+    for (int32 i = 0; i < numPoints; i++)
+    {
+        int32 pointOffset = 0;
+        Vst::ParamValue pointValue = 0.0;
+        if (queue.getPoint(i, pointOffset, pointValue) != kResultTrue)
+            return false;
+
+        if (pointOffset > sampleOffset) {
+            if (!ramped) {
+                value = previousValue;
+            } else {
+                const double t = static_cast<double>(sampleOffset - previousOffset) / (pointOffset - previousOffset);
+                value = previousValue + (pointValue - previousValue) * t;
             }
+            return true;
         }
+
+        previousValue = pointValue;
+        previousOffset = pointOffset;
     }
 
-    // Process audio output (TTS)
-    if (data.numSamples > 0 && data.numOutputs > 0)
+    value = previousValue;
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool FTVoxProcessor::isRampedParameter(Vst::ParamID id)
+{
+    switch (id)
     {
-        // Get output buffers
-        Vst::Sample32** outputs = data.outputs[0].channelBuffers32;
-        int numChannels = data.outputs[0].numChannels;
+        case kParamFontScale:
+        case kParamColorR:
+        case kParamColorG:
+        case kParamColorB:
+        case kParamTTSRate:
+        case kParamTTSPitch:
+        case kParamTTSVolume:
+            return true;
+        default:
+            return false;
+    }
+}
 
-        // Process TTS audio
-        processTTSAudio(outputs, numChannels, data.numSamples);
+//------------------------------------------------------------------------
+Vst::ParamValue FTVoxProcessor::getParameterValue(Vst::ParamID id) const
+{
+    switch (id)
+    {
+        case kParamFontScale: return fontScale_;
+        case kParamColorR: return colorR_;
+        case kParamColorG: return colorG_;
+        case kParamColorB: return colorB_;
+        case kParamTTSEnabled: return ttsEnabled_ ? 1.0 : 0.0;
+        case kParamTTSRate: return ttsRate_;
+        case kParamTTSPitch: return ttsPitch_;
+        case kParamTTSVolume: return ttsVolume_;
+        case kParamPitchShiftEnabled: return pitchShiftEnabled_ ? 1.0 : 0.0;
+        case kParamOctaveOffset: return (octaveOffset_ + 3) / 6.0;
+        case kParamPitchEngine: return pitchEngine_ == PitchEngine::Fast ? 1.0 : 0.0;
+        default: return 0.0;
     }
+}
 
-    return kResultOk;
+//------------------------------------------------------------------------
+void FTVoxProcessor::setParameter(Vst::ParamID id, Vst::ParamValue value)
+{
+    switch (id)
+    {
+        case kParamFontScale:
+            fontScale_ = static_cast<float>(value);
+            break;
+        case kParamColorR:
+            colorR_ = static_cast<float>(value);
+            break;
+        case kParamColorG:
+            colorG_ = static_cast<float>(value);
+            break;
+        case kParamColorB:
+            colorB_ = static_cast<float>(value);
+            break;
+        case kParamTTSEnabled:
+            ttsEnabled_ = value > 0.5;
+            break;
+        case kParamTTSRate:
+            ttsRate_ = static_cast<float>(value);
+            invalidateTTSRenders();
+            break;
+        case kParamTTSPitch:
+            ttsPitch_ = static_cast<float>(value);
+            invalidateTTSRenders();
+            break;
+        case kParamTTSVolume:
+            ttsVolume_ = static_cast<float>(value);
+            invalidateTTSRenders();
+            break;
+        case kParamPitchShiftEnabled:
+            pitchShiftEnabled_ = value > 0.5;
+            break;
+        case kParamOctaveOffset:
+            // Map 0-1 to -3 to +3 octaves
+            octaveOffset_ = static_cast<int>(std::round(value * 6.0 - 3.0));
+            break;
+        case kParamPitchEngine:
+            pitchEngine_ = value > 0.5 ? PitchEngine::Fast : PitchEngine::World;
+            break;
+    }
 }
 
 //------------------------------------------------------------------------
-void FTVoxProcessor::handleNoteOn(int noteNumber, int velocity)
+void FTVoxProcessor::invalidateTTSRenders()
 {
-    (void)velocity;
+    ttsSettingsDirty_ = true;
+    renderCache_.invalidate();
 
-    if (!configLoaded_) {
+    // The finished bake no longer matches; the label drops "ready" until the re-bake
+    prebakeTotal_ = 0;
+    prebakeDone_ = 0;
+    ++ttsChanges_;
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::rebuildCacheIfSettled()
+{
+    const unsigned changes = ttsChanges_;
+    const bool settled = changes == polledTtsChanges_;
+    polledTtsChanges_ = changes;
+    if (!settled || changes == rebuiltTtsChanges_) {
         return;
     }
+    rebuiltTtsChanges_ = changes;
 
-    std::string syllable;
-    {
-        std::lock_guard<std::mutex> lock(configMutex_);
-        syllable = config_.getSyllableForNote(noteNumber);
+    if (auto config = mappingConfig_.get()) {
+        if (config->getTTSConfig().prebake) {
+            schedulePrebake(*config);
+        } else {
+            scheduleAnalysisWarmup(config->getSyllables());
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::handleNoteOn(int noteNumber, int velocity, int64_t sampleTime)
+{
+    // Valid for the rest of this process() call
+    const MappingConfig* config = mappingConfig_.read();
+    if (!config) {
+        return;
+    }
+
+    // Light organ: every key lights its column (voice is unaffected)
+    if (lightOrganMode_ && display_.isRunning()) {
+        DisplayCommand command;
+        command.type = DisplayCommand::Type::NoteOn;
+        command.note = noteNumber;
+        command.velocity = velocity;
+        command.sampleTime = sampleTime;
+        display_.post(command);
     }
 
+    // Effect notes only drive the display
+    if (const Effect* effect = config->getEffectForNote(noteNumber)) {
+        if (display_.isRunning() && !lightOrganMode_) {
+            DisplayCommand command;
+            command.type = DisplayCommand::Type::StartEffect;
+            command.effectId = effect->id;
+            command.velocity = velocity;
+            command.sampleTime = sampleTime;
+            display_.post(command);
+        }
+        return;
+    }
+
+    const int syllableIndex = config->getSyllableIndexForNote(noteNumber);
+    const std::string_view syllable = config->getSyllableTextForNote(noteNumber);
     if (!syllable.empty()) {
         currentNoteNumber_ = noteNumber;
-        currentSyllable_ = syllable;
+        currentSyllableIndex_ = syllableIndex;
 
-        logToFile("Note ON: " + std::to_string(noteNumber) + " -> syllable: " + syllable);
+        FT_LOG_DEBUG("Note ON: %d -> syllable: %.*s", noteNumber, static_cast<int>(syllable.size()), syllable.data());
 
         // Update LED display
-        updateDisplay(syllable);
+        if (!lightOrganMode_) {
+            updateDisplay(*config, syllable, sampleTime);
+        }
 
-        // Speak syllable via TTS with pitch shifting
+        // Claim a voice and queue TTS + pitch shifting on the render worker
         if (ttsEnabled_) {
-            speakSyllable(syllable, noteNumber);
+            RenderJob job;
+            job.midiNote = noteNumber;
+            job.pitchNote = (std::max)(0, (std::min)(127, noteNumber + octaveOffset_ * 12));
+            job.velocity = velocity;
+            job.noteOnMicros = LatencyStats::nowMicros();
+            int bus = 0;
+            switch (outputRouting_.load(std::memory_order_relaxed)) {
+                case OutputRouting::Voice:
+                    bus = VoicePool::kBusByVoice;
+                    break;
+                case OutputRouting::Syllable:
+                    if (syllableIndex >= 0) {
+                        bus = config->getSyllables()[syllableIndex].bus;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            job.voice = voicePool_.noteOn(noteNumber, velocity, sampleTime, bus);
+            if (!job.voice.isValid()) {
+                FT_LOG_WARN("No free voice, dropped note %d", noteNumber);
+            } else if (!renderWorker_.submit(job)) {
+                voicePool_.cancel(job.voice);
+                FT_LOG_WARN("Render queue full, dropped note %d", noteNumber);
+            } else if (offline_) {
+                // Bouncing: the host waits for process(), so the note is
+                // complete before its first sample is mixed
+                renderWorker_.waitForJobs();
+            }
         }
     }
 }
 
 //------------------------------------------------------------------------
-void FTVoxProcessor::handleNoteOff(int noteNumber)
+void FTVoxProcessor::handleNoteOff(int noteNumber, int64_t sampleTime)
 {
+    voicePool_.noteOff(noteNumber, sampleTime);
+
+    if (lightOrganMode_ && display_.isRunning()) {
+        DisplayCommand command;
+        command.type = DisplayCommand::Type::NoteOff;
+        command.note = noteNumber;
+        command.sampleTime = sampleTime;
+        display_.post(command);
+    }
+
     // Only clear if this is the currently displayed note
     if (currentNoteNumber_ == noteNumber) {
         currentNoteNumber_ = -1;
-        currentSyllable_.clear();
+        currentSyllableIndex_ = -1;
 
-        logToFile("Note OFF: " + std::to_string(noteNumber));
+        FT_LOG_DEBUG("Note OFF: %d", noteNumber);
 
         // Clear display (show nothing or keep last syllable based on preference)
         // For now, we keep the last syllable displayed
@@ -308,14 +633,37 @@ void FTVoxProcessor::handleNoteOff(int noteNumber)
 }
 
 //------------------------------------------------------------------------
-void FTVoxProcessor::updateDisplay(const std::string& syllable)
+void FTVoxProcessor::handlePolyPressure(int noteNumber, int pressure, int64_t sampleTime)
 {
-    if (!ftConnected_ || !ftClient_) {
+    voicePool_.setPressure(noteNumber, pressure, sampleTime);
+
+    if (!display_.isRunning()) {
+        return;
+    }
+
+    // Pressure shapes the organ key, or the running effect's brightness
+    DisplayCommand command;
+    if (lightOrganMode_) {
+        command.type = DisplayCommand::Type::Aftertouch;
+        command.note = noteNumber;
+        command.velocity = pressure;
+    } else {
+        command.type = DisplayCommand::Type::SetBrightness;
+        command.brightness = static_cast<float>(pressure) / 127.0f;
+    }
+    command.sampleTime = sampleTime;
+    display_.post(command);
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::updateDisplay(const MappingConfig& config, std::string_view syllable, int64_t sampleTime)
+{
+    if (!display_.isRunning()) {
         return;
     }
 
     // Get display config
-    const auto& display = config_.getDisplayConfig();
+    const auto& display = config.getDisplayConfig();
 
     // Create color from parameters
     Color textColor(
@@ -325,115 +673,788 @@ void FTVoxProcessor::updateDisplay(const std::string& syllable)
     );
     Color bgColor(display.bgColorR, display.bgColorG, display.bgColorB);
 
-    // Clear and render
-    ftClient_->clear(bgColor);
-    font_.renderTextCenteredFull(*ftClient_, syllable, textColor, bgColor);
+    // Rendering and sending happen on the display thread
+    DisplayCommand command;
+    command.type = DisplayCommand::Type::ShowText;
+    command.setText(syllable);
+    command.textColor = textColor;
+    command.bgColor = bgColor;
+    command.fontScale = 1 + static_cast<int>(fontScale_ * 4);  // 1-5 scale
+    command.sampleTime = sampleTime;
+    display_.post(command);
+}
 
-    // Send to server
-    if (!ftClient_->send()) {
-        logToFile("Failed to send frame: " + ftClient_->getLastError());
+//------------------------------------------------------------------------
+void FTVoxProcessor::applyTTSSettings()
+{
+    if (!ttsSettingsDirty_.exchange(false) || !tts_ || !tts_->isInitialized()) {
+        return;
     }
+
+    tts_->setRate(80 + static_cast<int>(ttsRate_ * 370));   // 80-450
+    tts_->setPitch(static_cast<int>(ttsPitch_ * 99));       // 0-99
+    tts_->setVolume(static_cast<int>(ttsVolume_ * 200));    // 0-200
+
+    // A new base pitch moves the voice's F0 range
+    analysisTuner_.resetRange();
 }
 
 //------------------------------------------------------------------------
-void FTVoxProcessor::speakSyllable(const std::string& syllable, int midiNote)
+RenderCacheKey FTVoxProcessor::makeCacheKey(const std::string& syllable) const
 {
-    if (!tts_ || !tts_->isInitialized()) {
-        return;
+    RenderCacheKey key;
+    key.text = syllable;
+    key.voice = tts_->getVoice();
+    key.rate = tts_->getRate();
+    key.pitch = tts_->getPitch();
+    key.volume = tts_->getVolume();
+    key.pitchNote = -1;
+    key.outputRate = ttsSampleRate_;
+    return key;
+}
+
+//------------------------------------------------------------------------
+static SpeechCacheKey makeSpeechKey(const RenderCacheKey& key)
+{
+    SpeechCacheKey speechKey;
+    speechKey.text = key.text;
+    speechKey.voice = key.voice;
+    speechKey.rate = key.rate;
+    speechKey.pitch = key.pitch;
+    speechKey.volume = key.volume;
+    speechKey.sampleRate = key.outputRate;
+    return speechKey;
+}
+
+//------------------------------------------------------------------------
+SpeechCache* FTVoxProcessor::getSpeechCache()
+{
+    std::string path;
+    if (auto config = mappingConfig_.get()) {
+        path = config->getTTSConfig().cache;
+    }
+    if (path == "off") {
+        path.clear();
+    } else if (path.empty()) {
+        path = SpeechCache::getDefaultPath();
+    }
+
+    // Reopened only when the mapping names another file
+    if (path != speechCachePath_) {
+        speechCachePath_ = path;
+        speechCache_.reset();
+        if (!path.empty()) {
+            std::string error;
+            speechCache_ = SpeechCache::acquire(path, error);
+            if (speechCache_) {
+                FT_LOG_INFO("Speech cache %s: %zu entries", path.c_str(), speechCache_->getEntryCount());
+            } else {
+                FT_LOG_WARN("Speech cache disabled: %s", error.c_str());
+            }
+        }
+    }
+    return speechCache_.get();
+}
+
+//------------------------------------------------------------------------
+std::vector<float> FTVoxProcessor::speakSyllable(const std::string& syllable)
+{
+    std::vector<float> samples;
+    SpeechCache* speechCache = getSpeechCache();
+    const SpeechCacheKey speechKey = makeSpeechKey(makeCacheKey(syllable));
+    if (speechCache && speechCache->find(speechKey, samples)) {
+        FT_LOG_DEBUG("TTS cached %zu samples", samples.size());
+        return samples;
     }
 
     // Stop any current speech
     tts_->stop();
 
-    // Generate TTS audio synchronously
+    // Generate TTS audio (blocks this worker, not the audio thread)
+    const int64_t speakStart = LatencyStats::nowMicros();
     tts_->speak(syllable);
+    latencyStats_.recordSince(LatencyStage::Speak, speakStart);
+
+    samples = tts_->getAudioSamples();
+    FT_LOG_DEBUG("TTS generated %zu samples", samples.size());
+    if (speechCache) {
+        speechCache->insert(speechKey, samples);
+    }
+    return samples;
+}
 
-    // Get generated audio samples
-    auto samples = tts_->getAudioSamples();
+//------------------------------------------------------------------------
+std::vector<float> FTVoxProcessor::getSyllableSource(const std::string& syllable)
+{
+    RenderCacheKey key = makeCacheKey(syllable);
+    if (const std::vector<float>* cached = renderCache_.find(key)) {
+        return *cached;
+    }
+
+    auto samples = speakSyllable(syllable);
+    if (!samples.empty()) {
+        renderCache_.insert(key, samples);
+    }
+    return samples;
+}
+
+//------------------------------------------------------------------------
+std::vector<float> FTVoxProcessor::renderFast(const std::vector<float>& source, int pitchNote) const
+{
+    double ratio = PitchShifter::frequencyToRatio(PitchShifter::midiNoteToFrequency(pitchNote));
+    const int64_t shiftStart = LatencyStats::nowMicros();
+    auto shifted = fastShifter_->shift(source, ratio);
+    latencyStats_.recordSince(LatencyStage::Synthesis, shiftStart);
+
+    const int64_t resampleStart = LatencyStats::nowMicros();
+    Resampler resampler;
+    resampler.setRates(fastShifter_->getSampleRate(), static_cast<int>(sampleRate_));
+    auto render = resampler.processAll(shifted);
+    latencyStats_.recordSince(LatencyStage::Resample, resampleStart);
+    return render;
+}
+
+//------------------------------------------------------------------------
+std::shared_ptr<const WorldAnalysis> FTVoxProcessor::getSyllableAnalysis(const std::string& syllable, bool offline)
+{
+    RenderCacheKey key = makeCacheKey(syllable);
+    key.outputRate = static_cast<int>(sampleRate_);
+    if (auto cached = renderCache_.findAnalysis(key)) {
+        return cached;
+    }
+
+    auto samples = speakSyllable(syllable);
     if (samples.empty()) {
+        return nullptr;
+    }
+
+    // Analyze at the TTS rate, then re-map to the output rate so synthesis
+    // produces host-rate audio directly (no separate resampling pass)
+    // A bounce ignores the tuner, whose state depends on timing
+    const bool bounce = offline_;
+    const WorldAnalysisSettings settings = bounce ? AnalysisTuner::bounceSettings()
+                                                  : analysisTuner_.nextSettings(offline);
+    const int speedBefore = analysisTuner_.getDioSpeed();
+    const auto analysisStart = std::chrono::steady_clock::now();
+
+    WorldAnalysis analysis = pitchShifter_->analyze(samples, settings);
+
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - analysisStart).count();
+    if (!bounce) {
+        analysisTuner_.report(analysis, elapsedMs, offline);
+    }
+    if (analysisTuner_.getDioSpeed() != speedBefore) {
+        FT_LOG_INFO("Analysis took %d ms, DIO speed now %d", static_cast<int>(elapsedMs),
+                    analysisTuner_.getDioSpeed());
+    }
+
+    FT_LOG_DEBUG("Analyzed syllable '%s'", syllable.c_str());
+    return cacheAnalysis(key, std::move(analysis));
+}
+
+//------------------------------------------------------------------------
+std::shared_ptr<const WorldAnalysis> FTVoxProcessor::cacheAnalysis(const RenderCacheKey& key, WorldAnalysis analysis)
+{
+    latencyStats_.record(LatencyStage::F0, analysis.f0Micros);
+    latencyStats_.record(LatencyStage::Spectrum, analysis.spectrumMicros);
+    latencyStats_.record(LatencyStage::Aperiodicity, analysis.aperiodicityMicros);
+
+    const int outputRate = static_cast<int>(sampleRate_);
+    if (analysis.sampleRate != outputRate) {
+        const int64_t resampleStart = LatencyStats::nowMicros();
+        analysis = WorldPitchShifter::convertSampleRate(analysis, outputRate);
+        latencyStats_.recordSince(LatencyStage::Resample, resampleStart);
+    }
+    return renderCache_.insertAnalysis(key, std::move(analysis));
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::scheduleAnalysisWarmup(const std::vector<Syllable>& syllables)
+{
+    if (!renderWorker_.isRunning() || !pitchShiftEnabled_) {
         return;
     }
 
-    logToFile("TTS generated " + std::to_string(samples.size()) + " samples");
+    // The fast engine only needs the spoken syllable
+    const bool fast = pitchEngine_ == PitchEngine::Fast && !offline_;
 
-    // Apply pitch shifting based on MIDI note + octave offset
-    if (pitchShiftEnabled_ && pitchShifter_) {
-        int pitchNote = midiNote + (octaveOffset_ * 12);
-        if (pitchNote < 0) pitchNote = 0;
-        if (pitchNote > 127) pitchNote = 127;
-        double targetFreq = WorldPitchShifter::midiNoteToFrequency(pitchNote);
-        samples = pitchShifter_->processToFrequency(samples, targetFreq);
-        logToFile("Pitch shifted to " + std::to_string(targetFreq) + " Hz (MIDI " + std::to_string(pitchNote) + ")");
+    // One task per syllable so incoming notes never wait for the whole set
+    for (const auto& syllable : syllables) {
+        std::string text = syllable.text;
+        renderWorker_.post([this, text, fast]() {
+            if (!tts_ || !tts_->isInitialized() || !pitchShifter_) {
+                return;
+            }
+            applyTTSSettings();
+            if (fast) {
+                getSyllableSource(text);
+            } else {
+                getSyllableAnalysis(text);
+            }
+        });
     }
+}
 
-    // Resample from TTS rate to output rate
-    int outputRate = static_cast<int>(sampleRate_);
-    if (ttsSampleRate_ != outputRate) {
-        samples = resample(samples, ttsSampleRate_, outputRate);
-        logToFile("Resampled " + std::to_string(ttsSampleRate_) + " -> " + std::to_string(outputRate) + " Hz");
+//------------------------------------------------------------------------
+void FTVoxProcessor::schedulePrebake(const MappingConfig& config)
+{
+    if (!renderWorker_.isRunning()) {
+        return;
     }
 
-    // Add to playback buffer
+    // A bounce renders each note as it comes; baked notes would only differ
+    // in when (and by which synthesis path) they happened to be ready
+    if (offline_) {
+        scheduleAnalysisWarmup(config.getSyllables());
+        return;
+    }
+
+    // Group mapped notes by syllable so each syllable is spoken and analyzed once
+    std::map<std::string, std::vector<int>> notesBySyllable;
+    for (const auto& mapping : config.getNoteMappings()) {
+        if (const Syllable* syllable = config.getSyllableById(mapping.syllableId)) {
+            notesBySyllable[syllable->text].push_back(mapping.midiNote);
+        }
+    }
+
+    std::vector<std::pair<std::string, std::vector<int>>> items(notesBySyllable.begin(), notesBySyllable.end());
+    int octaves = config.getTTSConfig().prebakeOctaves;
+
+    renderWorker_.post([this, items, octaves]() {
+        // Expand the octave range around the offset in effect when the bake starts
+        std::vector<std::pair<std::string, std::vector<int>>> expanded;
+        for (const auto& item : items) {
+            std::set<int> pitchNotes;
+            for (int midiNote : item.second) {
+                if (!pitchShiftEnabled_) {
+                    pitchNotes.insert(-1);
+                    break;
+                }
+                for (int octave = -octaves; octave <= octaves; ++octave) {
+                    int pitchNote = midiNote + (octaveOffset_ + octave) * 12;
+                    pitchNotes.insert((std::max)(0, (std::min)(127, pitchNote)));
+                }
+            }
+            expanded.emplace_back(item.first, std::vector<int>(pitchNotes.begin(), pitchNotes.end()));
+        }
+        startPrebake(expanded);
+    });
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::startPrebake(const std::vector<std::pair<std::string, std::vector<int>>>& items)
+{
+    // Abandon any bake still in flight
+    unsigned bakeId = ++bakeId_;
+    bakePool_.cancelPending();
     {
-        std::lock_guard<std::mutex> lock(ttsBufferMutex_);
-        ttsAudioBuffer_.insert(ttsAudioBuffer_.end(), samples.begin(), samples.end());
+        std::lock_guard<std::mutex> lock(bakeResultsMutex_);
+        bakeResults_.clear();
+    }
+
+    if (!bakePool_.isRunning()) {
+        // Leave one core for the audio thread
+        unsigned cores = std::thread::hardware_concurrency();
+        bakePool_.start(cores > 1 ? cores - 1 : 1);
+    }
+
+    int total = 0;
+    for (const auto& item : items) {
+        total += static_cast<int>(item.second.size());
+    }
+    prebakeDone_ = 0;
+    prebakeTotal_ = total;
+
+    FT_LOG_INFO("Pre-baking %d renders on %zu threads", total, bakePool_.getThreadCount());
+
+    // World renders first analyze their syllables in batches, so short
+    // syllables keep the whole pool busy; prebakeSyllable() then finds the
+    // analyses cached
+    if (pitchEngine_ == PitchEngine::World && pitchShiftEnabled_) {
+        for (size_t first = 0; first < items.size(); first += kPrebakeBatchSyllables) {
+            std::vector<std::string> syllables;
+            for (size_t i = first; i < (std::min)(items.size(), first + kPrebakeBatchSyllables); ++i) {
+                syllables.push_back(items[i].first);
+            }
+            renderWorker_.post([this, bakeId, syllables]() {
+                prebakeAnalyses(bakeId, syllables);
+            });
+        }
+    }
+
+    // One worker task per syllable keeps live notes responsive during the bake
+    for (const auto& item : items) {
+        std::string syllable = item.first;
+        std::vector<int> pitchNotes = item.second;
+        renderWorker_.post([this, bakeId, syllable, pitchNotes]() {
+            prebakeSyllable(bakeId, syllable, pitchNotes);
+        });
     }
 }
 
 //------------------------------------------------------------------------
-void FTVoxProcessor::processTTSAudio(Vst::Sample32** outputs, int numChannels, int numSamples)
+void FTVoxProcessor::prebakeAnalyses(unsigned bakeId, const std::vector<std::string>& syllables)
 {
-    std::lock_guard<std::mutex> lock(ttsBufferMutex_);
+    if (bakeId != bakeId_ || !tts_ || !tts_->isInitialized() || !pitchShifter_) {
+        return;
+    }
+
+    applyTTSSettings();
+
+    // eSpeak is not reentrant: everything not analyzed yet is spoken here,
+    // then analyzed at once on the pool
+    std::vector<RenderCacheKey> keys;
+    std::vector<std::vector<float>> sources;
+    for (const std::string& syllable : syllables) {
+        RenderCacheKey key = makeCacheKey(syllable);
+        key.outputRate = static_cast<int>(sampleRate_);
+        if (renderCache_.findAnalysis(key)) {
+            continue;
+        }
+        auto samples = speakSyllable(syllable);
+        if (!samples.empty()) {
+            keys.push_back(key);
+            sources.push_back(std::move(samples));
+        }
+    }
+    if (sources.empty()) {
+        return;
+    }
 
-    int samplesAvailable = static_cast<int>(ttsAudioBuffer_.size());
-    int framesToRead = (std::min)(numSamples, samplesAvailable);
+    const auto analysisStart = std::chrono::steady_clock::now();
+    std::vector<WorldAnalysis> analyses = pitchShifter_->analyzeBatch(sources, analysisTuner_.nextSettings(true));
+    FT_LOG_DEBUG("Analyzed %zu syllables in %d ms", analyses.size(),
+                 static_cast<int>(std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - analysisStart).count()));
 
-    for (int frame = 0; frame < numSamples; ++frame) {
-        float sample = 0.0f;
+    for (size_t i = 0; i < analyses.size(); ++i) {
+        analysisTuner_.report(analyses[i], 0.0, true);
+        cacheAnalysis(keys[i], std::move(analyses[i]));
+    }
+}
 
-        if (frame < framesToRead && frame < static_cast<int>(ttsAudioBuffer_.size())) {
-            sample = ttsAudioBuffer_[frame];
+//------------------------------------------------------------------------
+void FTVoxProcessor::prebakeSyllable(unsigned bakeId, const std::string& syllable, const std::vector<int>& pitchNotes)
+{
+    if (bakeId != bakeId_ || !tts_ || !tts_->isInitialized()) {
+        return;
+    }
+
+    applyTTSSettings();
+
+    const int outputRate = static_cast<int>(sampleRate_);
+    const int ttsRate = ttsSampleRate_;
+    const PitchEngine engine = pitchEngine_;
+    std::shared_ptr<const WorldAnalysis> analysis;
+    std::shared_ptr<const std::vector<float>> source;
+
+    for (int pitchNote : pitchNotes) {
+        RenderCacheKey key = makeCacheKey(syllable);
+        key.pitchNote = pitchNote;
+        key.outputRate = outputRate;
+        key.engine = pitchNote < 0 ? 0 : static_cast<int>(engine);
+
+        if (renderCache_.find(key)) {
+            ++prebakeDone_;
+            continue;
+        }
+
+        if (pitchNote < 0 || !pitchShifter_) {
+            // Unshifted: nothing to parallelize
+            auto samples = speakSyllable(syllable);
+            if (!samples.empty()) {
+                Resampler resampler;
+                resampler.setRates(ttsRate, outputRate);
+                renderCache_.insert(key, resampler.processAll(samples));
+            }
+            ++prebakeDone_;
+            continue;
         }
 
-        // Write to all channels (mono to stereo)
-        for (int ch = 0; ch < numChannels; ++ch) {
-            outputs[ch][frame] = sample;
+        if (engine == PitchEngine::Fast && fastShifter_) {
+            // Speak once on this thread; the pool shifts a shared copy
+            if (!source) {
+                auto samples = getSyllableSource(syllable);
+                if (samples.empty()) {
+                    return;
+                }
+                source = std::make_shared<const std::vector<float>>(std::move(samples));
+            }
+
+            bakePool_.post([this, bakeId, key, source]() {
+                BakedRender render;
+                render.key = key;
+                render.samples = renderFast(*source, key.pitchNote);
+                render.bakeId = bakeId;
+                {
+                    std::lock_guard<std::mutex> lock(bakeResultsMutex_);
+                    bakeResults_.push_back(std::move(render));
+                }
+                renderWorker_.post([this]() { drainPrebakeResults(); });
+            });
+            continue;
         }
+
+        // eSpeak is not reentrant, so speaking/analysis stays on this thread.
+        // The shared analysis outlives any eviction while the pool uses it.
+        if (!analysis) {
+            analysis = getSyllableAnalysis(syllable, true);
+            if (!analysis) {
+                return;
+            }
+        }
+
+        bakePool_.post([this, bakeId, key, analysis]() {
+            double ratio = WorldPitchShifter::frequencyToRatio(WorldPitchShifter::midiNoteToFrequency(key.pitchNote));
+
+            // Analysis is already at the output rate
+            BakedRender render;
+            render.key = key;
+            render.samples = pitchShifter_->synthesize(*analysis, ratio);
+            render.bakeId = bakeId;
+            {
+                std::lock_guard<std::mutex> lock(bakeResultsMutex_);
+                bakeResults_.push_back(std::move(render));
+            }
+            renderWorker_.post([this]() { drainPrebakeResults(); });
+        });
     }
+}
 
-    // Remove consumed samples
-    if (framesToRead > 0 && framesToRead <= static_cast<int>(ttsAudioBuffer_.size())) {
-        ttsAudioBuffer_.erase(ttsAudioBuffer_.begin(), ttsAudioBuffer_.begin() + framesToRead);
+//------------------------------------------------------------------------
+void FTVoxProcessor::drainPrebakeResults()
+{
+    std::vector<BakedRender> results;
+    {
+        std::lock_guard<std::mutex> lock(bakeResultsMutex_);
+        results.swap(bakeResults_);
+    }
+    if (results.empty()) {
+        return;
+    }
+
+    for (auto& render : results) {
+        if (render.bakeId != bakeId_) {
+            continue;
+        }
+        renderCache_.insert(render.key, std::move(render.samples));
+        ++prebakeDone_;
+    }
+
+    if (prebakeDone_ >= prebakeTotal_) {
+        FT_LOG_INFO("Pre-bake complete: %zu renders cached", renderCache_.getEntryCount());
     }
 }
 
 //------------------------------------------------------------------------
-std::vector<float> FTVoxProcessor::resample(const std::vector<float>& input, int inputRate, int outputRate)
+void FTVoxProcessor::sendPrebakeProgress()
 {
-    if (inputRate == outputRate || input.empty()) {
-        return input;
+    if (auto message = allocateMessage())
+    {
+        message->setMessageID("PrebakeProgress");
+        message->getAttributes()->setInt("Done", prebakeDone_.load());
+        message->getAttributes()->setInt("Total", prebakeTotal_.load());
+        sendMessage(message);
+        message->release();
     }
+}
 
-    double ratio = static_cast<double>(outputRate) / inputRate;
-    size_t outputSize = static_cast<size_t>(input.size() * ratio);
-    std::vector<float> output(outputSize);
+//------------------------------------------------------------------------
+void FTVoxProcessor::setMappingStatus(MappingLoadState state, const std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mappingStatusMutex_);
+    mappingState_ = state;
+    mappingError_ = error;
+}
 
-    for (size_t i = 0; i < outputSize; ++i) {
-        double srcPos = i / ratio;
-        size_t srcIndex = static_cast<size_t>(srcPos);
-        double frac = srcPos - srcIndex;
+//------------------------------------------------------------------------
+void FTVoxProcessor::sendMappingStatus()
+{
+    MappingLoadState state;
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(mappingStatusMutex_);
+        state = mappingState_;
+        error = mappingError_;
+    }
 
-        if (srcIndex + 1 < input.size()) {
-            // Linear interpolation
-            output[i] = static_cast<float>(input[srcIndex] * (1.0 - frac) + input[srcIndex + 1] * frac);
-        } else if (srcIndex < input.size()) {
-            output[i] = input[srcIndex];
-        } else {
-            output[i] = 0.0f;
+    if (auto message = allocateMessage())
+    {
+        message->setMessageID("MappingStatus");
+        message->getAttributes()->setInt("State", state);
+        message->getAttributes()->setBinary("Error", error.data(), static_cast<Steinberg::uint32>(error.size()));
+        sendMessage(message);
+        message->release();
+    }
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::sendLatencyStats()
+{
+    const LatencyReport report = latencyStats_.getReport();
+    if (auto message = allocateMessage())
+    {
+        message->setMessageID("LatencyStats");
+        message->getAttributes()->setBinary("Report", &report, sizeof(report));
+        sendMessage(message);
+        message->release();
+    }
+}
+
+//------------------------------------------------------------------------
+bool FTVoxProcessor::updateLookAhead()
+{
+    const auto samples = static_cast<uint32>(lookAheadMs_.load() * sampleRate_ / 1000.0 + 0.5);
+    return lookAheadSamples_.exchange(samples) != samples;
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::sendLatencyChanged()
+{
+    if (auto message = allocateMessage())
+    {
+        message->setMessageID("LatencyChanged");
+        message->getAttributes()->setInt("Samples", lookAheadSamples_.load());
+        sendMessage(message);
+        message->release();
+    }
+}
+
+//------------------------------------------------------------------------
+uint32 PLUGIN_API FTVoxProcessor::getLatencySamples()
+{
+    return lookAheadSamples_.load();
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::renderNote(const RenderJob& job)
+{
+    latencyStats_.recordSince(LatencyStage::RenderQueue, job.noteOnMicros);
+
+    // Skip notes whose voice was already stolen while the job was queued
+    if (!voicePool_.beginStream(job.voice)) {
+        return;
+    }
+
+    renderVoice(job);
+
+    // Always release the claim, even if nothing was rendered
+    voicePool_.endStream(job.voice);
+}
+
+//------------------------------------------------------------------------
+bool FTVoxProcessor::initializeEngines()
+{
+    if (!tts_ || tts_->isInitialized() || engineInitTried_) {
+        return tts_ && tts_->isInitialized();
+    }
+    engineInitTried_ = true;
+    const auto initStart = std::chrono::steady_clock::now();
+
+    // Initialize TTS, asking for the host rate; eSpeak reports what it can do
+    if (!tts_->initialize(static_cast<int>(sampleRate_))) {
+        FT_LOG_ERROR("TTS initialization failed: %s", tts_->getLastError().c_str());
+        return false;
+    }
+    ttsSampleRate_ = tts_->getSampleRate();  // Probed native rate
+    ttsSettingsDirty_ = true;                // Parameters set before this still apply
+    FT_LOG_INFO("TTS initialized at sample rate: %d", ttsSampleRate_);
+    if (tts_->supportsSampleRate(static_cast<int>(sampleRate_))) {
+        FT_LOG_INFO("Output sample rate: %.0f (native, no resampling)", sampleRate_);
+    } else {
+        FT_LOG_INFO("Output sample rate: %.0f (pitch shifter renders at output rate)", sampleRate_);
+    }
+
+    // Initialize pitch shifter at TTS sample rate
+    if (pitchShifter_) {
+        pitchShifter_->initialize(ttsSampleRate_);
+        FT_LOG_INFO("Pitch shifter initialized at %d Hz", ttsSampleRate_);
+    }
+    if (fastShifter_) {
+        fastShifter_->initialize(ttsSampleRate_);
+    }
+
+    // Filter banks for 22050 Hz -> common host rates, so no note pays for them
+    Resampler::precomputeCommonRates();
+
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - initStart).count();
+    FT_LOG_INFO("Engines ready in %d ms", static_cast<int>(elapsedMs));
+    return true;
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::renderVoice(const RenderJob& job)
+{
+    // A note that beats the startup task waits for it here
+    if (!initializeEngines()) {
+        return;
+    }
+
+    std::string syllable;
+    if (auto config = mappingConfig_.get()) {
+        syllable = config->getSyllableForNote(job.midiNote);
+    }
+    if (syllable.empty()) {
+        return;
+    }
+
+    applyTTSSettings();
+
+    // Repeated notes are served from the cache; a bounce always uses World
+    const bool pitchShift = pitchShiftEnabled_ && pitchShifter_;
+    const PitchEngine engine = offline_ ? PitchEngine::World : pitchEngine_.load();
+    RenderCacheKey key = makeCacheKey(syllable);
+    key.pitchNote = pitchShift ? job.pitchNote : -1;
+    key.outputRate = static_cast<int>(sampleRate_);
+    key.engine = pitchShift ? static_cast<int>(engine) : 0;
+
+    if (const std::vector<float>* cached = renderCache_.find(key)) {
+        queuePlayback(job, *cached);
+        return;
+    }
+
+    if (pitchShift && engine == PitchEngine::Fast && fastShifter_) {
+        // Whole-utterance PSOLA is a few milliseconds, no need to stream
+        auto source = getSyllableSource(syllable);
+        if (source.empty()) {
+            return;
+        }
+
+        auto render = renderFast(source, job.pitchNote);
+        if (queuePlayback(job, render)) {
+            renderCache_.insert(key, std::move(render));
         }
+        FT_LOG_DEBUG("Fast pitch shifted to MIDI %d", job.pitchNote);
+        return;
     }
 
-    return output;
+    if (pitchShift) {
+        // Analysis is shared by all notes of this syllable; only Synthesis runs per note
+        auto analysis = getSyllableAnalysis(syllable);
+        if (!analysis) {
+            return;
+        }
+
+        double targetFreq = WorldPitchShifter::midiNoteToFrequency(job.pitchNote);
+        renderStreaming(job, key, analysis, WorldPitchShifter::frequencyToRatio(targetFreq));
+        FT_LOG_DEBUG("Pitch shifted to %.2f Hz (MIDI %d)", targetFreq, job.pitchNote);
+        return;
+    }
+
+    // Unshifted: eSpeak chunks go through the resampler straight to playback,
+    // so the first sound is bounded by eSpeak's first chunk
+    std::vector<float> render;
+    bool stolen = false;
+    streamResampler_.setRates(ttsSampleRate_, static_cast<int>(sampleRate_));
+
+    // A syllable spoken in an earlier session is resampled in one go
+    SpeechCache* speechCache = getSpeechCache();
+    const SpeechCacheKey speechKey = makeSpeechKey(makeCacheKey(syllable));
+    std::vector<float> source;
+    if (speechCache && speechCache->find(speechKey, source)) {
+        streamResampler_.process(source.data(), source.size(), render);
+        stolen = !queuePlayback(job, render.data(), render.size());
+    } else {
+        tts_->stop();
+        tts_->speak(syllable, [this, &job, &render, &stolen, &source](const float* chunk, size_t count) {
+            source.insert(source.end(), chunk, chunk + count);
+            size_t start = render.size();
+            streamResampler_.process(chunk, count, render);
+            stolen = !queuePlayback(job, render.data() + start, render.size() - start);
+            return !stolen;
+        });
+        if (speechCache && !stolen) {
+            speechCache->insert(speechKey, source);
+        }
+    }
+
+    // Emit the resampler's look-ahead tail
+    if (!stolen) {
+        size_t start = render.size();
+        streamResampler_.flush(render);
+        stolen = !queuePlayback(job, render.data() + start, render.size() - start);
+    }
+
+    // A stolen note's render is incomplete, don't cache it
+    if (render.empty() || stolen) {
+        return;
+    }
+
+    FT_LOG_DEBUG("TTS streamed %zu samples", render.size());
+    renderCache_.insert(key, std::move(render));
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::renderStreaming(const RenderJob& job, const RenderCacheKey& key,
+                                     std::shared_ptr<const WorldAnalysis> analysis, double ratio)
+{
+    // The analysis is at the output rate, so blocks go to the voice as is
+    const size_t expectedLength = static_cast<size_t>(analysis->inputLength);
+
+    if (!streamSynth_.start(std::move(analysis), ratio)) {
+        return;
+    }
+
+    streamBlock_.resize(streamSynth_.getBlockSize());
+
+    // Each block goes to the voice as soon as it is synthesized, so playback
+    // starts after one block instead of the whole utterance
+    std::vector<float> render;
+    render.reserve(expectedLength);
+
+    bool stolen = false;
+    int count = 0;
+    int64_t synthesisMicros = 0;
+    for (;;) {
+        const int64_t blockStart = LatencyStats::nowMicros();
+        count = streamSynth_.process(streamBlock_.data());
+        synthesisMicros += LatencyStats::nowMicros() - blockStart;
+        if (count <= 0) {
+            break;
+        }
+
+        render.insert(render.end(), streamBlock_.begin(), streamBlock_.begin() + count);
+        if (!queuePlayback(job, streamBlock_.data(), static_cast<size_t>(count))) {
+            stolen = true;
+            break;
+        }
+    }
+    streamSynth_.reset();
+    latencyStats_.record(LatencyStage::Synthesis, synthesisMicros);
+
+    if (!stolen) {
+        renderCache_.insert(key, std::move(render));
+    }
+}
+
+//------------------------------------------------------------------------
+bool FTVoxProcessor::queuePlayback(const RenderJob& job, const std::vector<float>& samples)
+{
+    return queuePlayback(job, samples.data(), samples.size());
+}
+
+//------------------------------------------------------------------------
+bool FTVoxProcessor::queuePlayback(const RenderJob& job, const float* samples, size_t count)
+{
+    int droppedBefore = voicePool_.getDroppedSamples();
+    if (!voicePool_.write(job.voice, samples, count)) {
+        return false;
+    }
+
+    int dropped = voicePool_.getDroppedSamples() - droppedBefore;
+    if (dropped > 0) {
+        FT_LOG_WARN("Voice buffer full, dropped %d samples", dropped);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+uint32_t FTVoxProcessor::processTTSAudio(Vst::ProcessData& data, int startSample, int numSamples)
+{
+    if (data.symbolicSampleSize == Vst::kSample64) {
+        return mixBuses<Vst::Sample64>(voicePool_, data, startSample, numSamples, samplePosition_ + startSample);
+    }
+    return mixBuses<Vst::Sample32>(voicePool_, data, startSample, numSamples, samplePosition_ + startSample);
 }
 
 //------------------------------------------------------------------------
@@ -456,26 +1477,32 @@ tresult PLUGIN_API FTVoxProcessor::notify(Vst::IMessage* message)
                 path += static_cast<char>(*path16++);
             }
 
-            logToFile("Received mapping file path: " + path);
-            loadMappingFile(path);
-
-            // Reconnect to server with new config
-            if (configLoaded_ && ftClient_) {
-                ftClient_->disconnect();
-                const auto& server = config_.getServerConfig();
-                const auto& display = config_.getDisplayConfig();
-                ftClient_->setDisplaySize(display.width, display.height);
-                ftClient_->setOffset(display.offsetX, display.offsetY);
-                ftClient_->setLayer(display.layer);
-                ftClient_->setFlipHorizontal(display.flipHorizontal);
-                font_.setMirrorGlyph(display.mirrorGlyph);
-
-                if (ftClient_->connect(server.ip, server.port)) {
-                    ftConnected_ = true;
-                    logToFile("Reconnected to FlaschenTaschen server");
-                }
-            }
+            FT_LOG_INFO("Received mapping file path: %s", path.c_str());
+            requestMappingFile(path);
+        }
+        return kResultOk;
+    }
+
+    if (strcmp(message->getMessageID(), "GetLatencyStats") == 0)
+    {
+        Steinberg::int64 reset = 0;
+        if (message->getAttributes()->getInt("Reset", reset) == kResultOk && reset) {
+            latencyStats_.reset();
         }
+        sendLatencyStats();
+        return kResultOk;
+    }
+
+    // Polled by the controller's UI timer: worker and loader threads only
+    // update state, every reply goes out from here on the UI thread
+    if (strcmp(message->getMessageID(), "GetStatus") == 0)
+    {
+        if (latencyChanged_.exchange(false)) {
+            sendLatencyChanged();
+        }
+        rebuildCacheIfSettled();
+        sendMappingStatus();
+        sendPrebakeProgress();
         return kResultOk;
     }
 
@@ -483,46 +1510,130 @@ tresult PLUGIN_API FTVoxProcessor::notify(Vst::IMessage* message)
 }
 
 //------------------------------------------------------------------------
-bool FTVoxProcessor::loadMappingFile(const std::string& filePath)
+void FTVoxProcessor::requestMappingFile(const std::string& filePath)
 {
-    std::lock_guard<std::mutex> lock(configMutex_);
+    configFilePath_ = filePath;
+    const unsigned request = ++loadRequest_;
 
-    if (config_.loadFromFile(filePath)) {
-        configFilePath_ = filePath;
-        configLoaded_ = true;
+    if (!configLoader_.isRunning()) {
+        loadMappingFile(filePath);
+        return;
+    }
 
-        logToFile("Loaded mapping file: " + filePath);
-        logToFile("  Server: " + config_.getServerConfig().ip + ":" + std::to_string(config_.getServerConfig().port));
-        logToFile("  Syllables: " + std::to_string(config_.getSyllables().size()));
-        logToFile("  Note mappings: " + std::to_string(config_.getNoteMappings().size()));
+    // The old mapping's pre-bake counts no longer apply
+    prebakeTotal_ = 0;
+    prebakeDone_ = 0;
+    setMappingStatus(kMappingLoading);
+    configLoader_.post([this, filePath, request]() {
+        // Only the latest request is worth parsing
+        if (request == loadRequest_) {
+            loadMappingFile(filePath);
+        }
+    });
+}
 
-        // Update font scale from display config
-        font_.setScale(1);
+//------------------------------------------------------------------------
+bool FTVoxProcessor::loadMappingFile(const std::string& filePath)
+{
+    // Parse into a fresh snapshot; the audio thread keeps the old one meanwhile
+    auto config = std::make_shared<MappingConfig>();
+    if (!config->loadFromFile(filePath)) {
+        FT_LOG_ERROR("Failed to load mapping file: %s", config->getLastError().c_str());
+        setMappingStatus(kMappingFailed, config->getLastError());
+        return false;
+    }
 
-        return true;
+    lightOrganMode_ = config->getDisplayConfig().lightOrgan;
+
+    const auto& tts = config->getTTSConfig();
+    voicePool_.setVoiceLimit(tts.voices);
+    voicePool_.setStealMode(VoicePool::stealModeFromString(tts.voiceSteal));
+    pitchEngine_ = PitchShifter::engineFromString(tts.engine);
+    outputRouting_ = tts.outputs == "voice"    ? OutputRouting::Voice
+                   : tts.outputs == "syllable" ? OutputRouting::Syllable
+                                               : OutputRouting::Main;
+    analysisTuner_.setMode(AnalysisTuner::modeFromString(tts.analysis));
+    analysisTuner_.setBudget(tts.analysisBudgetMs);
+    analysisTuner_.resetRange();
+    renderCache_.setAnalysisDims(tts.analysisDims);
+    lookAheadMs_ = tts.lookAheadMs;
+    if (updateLookAhead()) {
+        latencyChanged_ = true;
     }
-    else {
-        logToFile("Failed to load mapping file: " + config_.getLastError());
-        return false;
+    voicePool_.setVelocityDepth(tts.velocityDepth / 100.0f);
+    releaseMs_ = tts.releaseMs;
+    voicePool_.setReleaseSamples(static_cast<int>(releaseMs_ * sampleRate_ / 1000.0));
+
+    currentNoteNumber_ = -1;
+    currentSyllableIndex_ = -1;
+    renderCache_.invalidate();
+    mappingConfig_.publish(config);
+
+    if (tts.prebake) {
+        schedulePrebake(*config);
+    } else {
+        scheduleAnalysisWarmup(config->getSyllables());
+    }
+
+    // Reconnect to server with new config
+    if (active_ && !offline_) {
+        setMappingStatus(kMappingConnecting);
+        startDisplay(*config);
+    }
+    setMappingStatus(kMappingReady);
+
+    FT_LOG_INFO("Loaded mapping file: %s", filePath.c_str());
+    FT_LOG_INFO("  Server: %s:%d", config->getServerConfig().ip.c_str(), config->getServerConfig().port);
+    FT_LOG_INFO("  Syllables: %zu", config->getSyllables().size());
+    FT_LOG_INFO("  Note mappings: %zu", config->getNoteMappings().size());
+
+    return true;
+}
+
+//------------------------------------------------------------------------
+void FTVoxProcessor::startDisplay(const MappingConfig& config)
+{
+    const auto& server = config.getServerConfig();
+    const auto& display = config.getDisplayConfig();
+
+    // Connects and starts the display thread, which clears the display
+    std::lock_guard<std::mutex> lock(displayMutex_);
+    const auto& panels = config.getDisplayPanels();
+    if (display_.start(server, display, config.getEffects(), config.getSyllables(), panels)) {
+        if (panels.empty()) {
+            FT_LOG_INFO("Connected to FlaschenTaschen server: %s:%d (%d fps)", server.ip.c_str(), server.port, display.fps);
+        } else {
+            FT_LOG_INFO("Connected to %zu FlaschenTaschen panels (%d fps)", panels.size(), display.fps);
+        }
+    } else {
+        FT_LOG_ERROR("Failed to connect to FlaschenTaschen server: %s", display_.getLastError().c_str());
     }
 }
 
 //------------------------------------------------------------------------
 std::string FTVoxProcessor::getCurrentSyllable() const
 {
-    return currentSyllable_;
+    auto config = mappingConfig_.get();
+    if (!config) {
+        return std::string();
+    }
+    const int index = currentSyllableIndex_;
+    const auto& syllables = config->getSyllables();
+    return index >= 0 && index < static_cast<int>(syllables.size()) ? syllables[index].text : std::string();
 }
 
 //------------------------------------------------------------------------
 tresult PLUGIN_API FTVoxProcessor::setupProcessing(Vst::ProcessSetup& newSetup)
 {
+    // eSpeak's rate doesn't depend on the host rate, so it is never
+    // re-initialized here; renders and analyses are tied to the old rate
     sampleRate_ = newSetup.sampleRate;
-
-    // Update TTS sample rate if already initialized
-    if (tts_ && tts_->isInitialized()) {
-        tts_->shutdown();
-        tts_->initialize(static_cast<int>(sampleRate_));
-    }
+    offline_ = newSetup.processMode == Vst::kOffline;
+    renderCache_.invalidate();   // Also keeps bounce and live renders apart
+    display_.setSampleRate(sampleRate_);
+    // The host asks for the latency again after setup, no restart needed
+    updateLookAhead();
+    voicePool_.setReleaseSamples(static_cast<int>(releaseMs_ * sampleRate_ / 1000.0));
 
     return AudioEffect::setupProcessing(newSetup);
 }
@@ -530,7 +1641,7 @@ tresult PLUGIN_API FTVoxProcessor::setupProcessing(Vst::ProcessSetup& newSetup)
 //------------------------------------------------------------------------
 tresult PLUGIN_API FTVoxProcessor::canProcessSampleSize(int32 symbolicSampleSize)
 {
-    if (symbolicSampleSize == Vst::kSample32)
+    if (symbolicSampleSize == Vst::kSample32 || symbolicSampleSize == Vst::kSample64)
         return kResultTrue;
 
     return kResultFalse;
@@ -552,7 +1663,7 @@ tresult PLUGIN_API FTVoxProcessor::setState(IBStream* state)
             return kResultFalse;
 
         std::string filePath(pathBuffer.data());
-        loadMappingFile(filePath);
+        requestMappingFile(filePath);
     }
 
     // Read parameters
@@ -562,7 +1673,6 @@ tresult PLUGIN_API FTVoxProcessor::setState(IBStream* state)
 
     if (streamer.readFloat(fontScale) == false) return kResultOk; // Old state without these
     fontScale_ = fontScale;
-    font_.setScale(1 + static_cast<int>(fontScale * 4));
 
     if (streamer.readFloat(r) == false) return kResultOk;
     if (streamer.readFloat(g) == false) return kResultOk;
@@ -5,14 +5,26 @@
 #pragma once
 
 #include "public.sdk/source/vst/vstaudioeffect.h"
+#include "pluginterfaces/vst/ivstparameterchanges.h"
+#include "myplugincids.h"
 #include "MappingConfig.h"
-#include "FlaschenTaschenClient.h"
-#include "BitmapFont.h"
+#include "DisplayThread.h"
 #include "ESpeakSynthesizer.h"
+#include "AnalysisTuner.h"
+#include "PsolaPitchShifter.h"
 #include "WorldPitchShifter.h"
+#include "RenderWorker.h"
+#include "VoicePool.h"
+#include "RenderCache.h"
+#include "SpeechCache.h"
+#include "ThreadPool.h"
+#include "Resampler.h"
+#include "RcuPointer.h"
+#include "LatencyStats.h"
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <atomic>
 #include <mutex>
 #include <vector>
@@ -31,6 +43,7 @@ enum ParameterIDs : Steinberg::Vst::ParamID {
     kParamTTSVolume,
     kParamPitchShiftEnabled,
     kParamOctaveOffset,
+    kParamPitchEngine,
 };
 
 //------------------------------------------------------------------------
@@ -66,6 +79,9 @@ public:
     /** Asks if a given sample size is supported see SymbolicSampleSizes. */
     Steinberg::tresult PLUGIN_API canProcessSampleSize(Steinberg::int32 symbolicSampleSize) SMTG_OVERRIDE;
 
+    /** Look-ahead delay from the mapping's <TTS lookAheadMs> */
+    Steinberg::uint32 PLUGIN_API getLatencySamples() SMTG_OVERRIDE;
+
     /** Here we go...the process call */
     Steinberg::tresult PLUGIN_API process(Steinberg::Vst::ProcessData& data) SMTG_OVERRIDE;
 
@@ -73,7 +89,10 @@ public:
     Steinberg::tresult PLUGIN_API setState(Steinberg::IBStream* state) SMTG_OVERRIDE;
     Steinberg::tresult PLUGIN_API getState(Steinberg::IBStream* state) SMTG_OVERRIDE;
 
-    // Load mapping configuration from file
+    // Queue loading a mapping file on the config loader thread (returns at once)
+    void requestMappingFile(const std::string& filePath);
+
+    // Parse a mapping file and make it current (blocking; never the audio thread)
     bool loadMappingFile(const std::string& filePath);
 
     // Get current displayed syllable
@@ -81,55 +100,203 @@ public:
 
 //------------------------------------------------------------------------
 protected:
-    // Handle MIDI note on event
-    void handleNoteOn(int noteNumber, int velocity);
+    // Handle MIDI note on event (sampleTime: audio position of the event)
+    void handleNoteOn(int noteNumber, int velocity, int64_t sampleTime);
 
     // Handle MIDI note off event
-    void handleNoteOff(int noteNumber);
+    void handleNoteOff(int noteNumber, int64_t sampleTime);
+
+    // Handle polyphonic key pressure (0-127)
+    void handlePolyPressure(int noteNumber, int pressure, int64_t sampleTime);
+
+    // Send current syllable to LED display, shown when playback reaches sampleTime
+    void updateDisplay(const FlaschenTaschen::MappingConfig& config, std::string_view syllable, int64_t sampleTime);
+
+    // (Re)connect the display thread with a mapping's server and display settings
+    void startDisplay(const FlaschenTaschen::MappingConfig& config);
+
+    // Render a queued note into its voice: TTS, pitch shifting and
+    // resampling. Runs on the render worker thread, never on the audio thread.
+    void renderNote(const FlaschenTaschen::RenderJob& job);
+    void renderVoice(const FlaschenTaschen::RenderJob& job);
+
+    // Load eSpeak and set up the pitch shifters at its rate, once per
+    // activation attempt (render worker thread, so plugin scans and
+    // project loads never wait for TTS startup)
+    bool initializeEngines();
+
+    // Synthesize a pitch-shifted note block by block into the playback
+    // buffer, then cache the complete render (render worker thread)
+    void renderStreaming(const FlaschenTaschen::RenderJob& job, const FlaschenTaschen::RenderCacheKey& key,
+                         std::shared_ptr<const FlaschenTaschen::WorldAnalysis> analysis, double ratio);
+
+    // Cache key for the raw (unshifted, TTS-rate) audio of a syllable
+    FlaschenTaschen::RenderCacheKey makeCacheKey(const std::string& syllable) const;
+
+    // Run eSpeak for one syllable, or read it from the speech cache (render worker thread)
+    std::vector<float> speakSyllable(const std::string& syllable);
+
+    // The <TTS cache> file of the current mapping, nullptr if off (render worker thread)
+    FlaschenTaschen::SpeechCache* getSpeechCache();
+
+    // Raw TTS-rate audio of a syllable, spoken on first use (render worker thread)
+    std::vector<float> getSyllableSource(const std::string& syllable);
+
+    // Fast engine: PSOLA at the TTS rate, then resample to the output rate.
+    // Safe on any thread (no eSpeak, no shared state).
+    std::vector<float> renderFast(const std::vector<float>& source, int pitchNote) const;
+
+    // World analysis of a syllable, computed on first use (render worker thread).
+    // Offline (pre-bake) analyses may use Harvest and don't count against the budget;
+    // during a bounce every analysis uses AnalysisTuner::bounceSettings().
+    std::shared_ptr<const FlaschenTaschen::WorldAnalysis> getSyllableAnalysis(const std::string& syllable,
+                                                                              bool offline = false);
 
-    // Send current syllable to LED display
-    void updateDisplay(const std::string& syllable);
+    // Record an analysis' timing, re-map it to the output rate and cache it
+    std::shared_ptr<const FlaschenTaschen::WorldAnalysis> cacheAnalysis(const FlaschenTaschen::RenderCacheKey& key,
+                                                                        FlaschenTaschen::WorldAnalysis analysis);
 
-    // Speak current syllable using TTS with pitch shifting
-    void speakSyllable(const std::string& syllable, int midiNote);
+    // Queue background analysis of the given syllables on the render worker
+    void scheduleAnalysisWarmup(const std::vector<FlaschenTaschen::Syllable>& syllables);
 
-    // Process TTS audio output
-    void processTTSAudio(Steinberg::Vst::Sample32** outputs, int numChannels, int numSamples);
+    // Queue a pre-bake of every mapped note
+    void schedulePrebake(const FlaschenTaschen::MappingConfig& config);
 
-    // Resample audio from one sample rate to another
-    std::vector<float> resample(const std::vector<float>& input, int inputRate, int outputRate);
+    // TTS rate/pitch/volume changed: drop cached renders (any thread, realtime-safe)
+    void invalidateTTSRenders();
+
+    // Re-bake (or re-warm) the current mapping once TTS changes settle (UI thread)
+    void rebuildCacheIfSettled();
+
+    // Pre-bake steps, all on the render worker thread
+    void startPrebake(const std::vector<std::pair<std::string, std::vector<int>>>& items);
+    void prebakeAnalyses(unsigned bakeId, const std::vector<std::string>& syllables);
+    void prebakeSyllable(unsigned bakeId, const std::string& syllable, const std::vector<int>& pitchNotes);
+    void drainPrebakeResults();
+
+    // Send the pre-bake counters to the controller (UI thread, answering "GetStatus")
+    void sendPrebakeProgress();
+
+    // Record mapping load progress (any non-audio thread); sendMappingStatus
+    // reports it to the controller (UI thread, answering "GetStatus")
+    void setMappingStatus(MappingLoadState state, const std::string& error = std::string());
+    void sendMappingStatus();
+
+    // Send the per-stage latency summary to the controller (UI thread, answering "GetLatencyStats")
+    void sendLatencyStats();
+
+    // Push pending TTS parameter changes to eSpeak (render worker thread)
+    void applyTTSSettings();
+
+    // Append rendered audio to the job's voice (render worker thread).
+    // Returns false once the voice has been stolen by a newer note.
+    bool queuePlayback(const FlaschenTaschen::RenderJob& job, const std::vector<float>& samples);
+    bool queuePlayback(const FlaschenTaschen::RenderJob& job, const float* samples, size_t count);
+
+    // Mix the voices into samples [startSample, startSample + numSamples) of
+    // every output bus, in the block's sample size; returns the mask of
+    // buses that received audio
+    uint32_t processTTSAudio(Steinberg::Vst::ProcessData& data, int startSample, int numSamples);
+
+    // Parameter changes as of sampleOffset: ramped parameters interpolate
+    // between queue points, discrete ones step at each point
+    void snapshotParameters(Steinberg::Vst::IParameterChanges* changes);
+    void applyParameterChanges(Steinberg::Vst::IParameterChanges* changes, Steinberg::int32 sampleOffset);
+    static bool valueAtOffset(Steinberg::Vst::IParamValueQueue& queue, Steinberg::int32 sampleOffset, bool ramped,
+                              Steinberg::Vst::ParamValue blockStart, Steinberg::Vst::ParamValue& value);
+    static bool isRampedParameter(Steinberg::Vst::ParamID id);
+    Steinberg::Vst::ParamValue getParameterValue(Steinberg::Vst::ParamID id) const;
+    void setParameter(Steinberg::Vst::ParamID id, Steinberg::Vst::ParamValue value);
 
     // Handle message from controller (for file path)
     Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) SMTG_OVERRIDE;
 
 private:
-    // Configuration
-    FlaschenTaschen::MappingConfig config_;
-    std::string configFilePath_;
-    std::atomic<bool> configLoaded_{false};
-    mutable std::mutex configMutex_;
-
-    // FlaschenTaschen client
-    std::unique_ptr<FlaschenTaschen::FlaschenTaschenClient> ftClient_;
-    std::atomic<bool> ftConnected_{false};
-
-    // Font renderer
-    FlaschenTaschen::BitmapFont font_;
+    // Configuration: immutable snapshots; the audio thread reads without
+    // locking and marks a quiescent point at the end of every process()
+    FlaschenTaschen::RcuPointer<FlaschenTaschen::MappingConfig> mappingConfig_;
+    std::string configFilePath_;                // Most recently requested mapping (UI thread)
+    FlaschenTaschen::ThreadPool configLoader_;  // One thread: parses and applies mappings in order
+    std::atomic<unsigned> loadRequest_{0};      // Superseded requests are skipped
+    std::atomic<bool> active_{false};
+    std::mutex displayMutex_;                   // Serializes display_.start()/stop()
+    std::mutex mappingStatusMutex_;             // Guards the two fields below
+    MappingLoadState mappingState_ = kMappingIdle;
+    std::string mappingError_;
+
+    // LED display: connection, font and effects live on the display thread
+    FlaschenTaschen::DisplayThread display_;
 
     // TTS synthesizer
     std::unique_ptr<FlaschenTaschen::ESpeakSynthesizer> tts_;
-    int ttsSampleRate_ = 22050;  // eSpeak native rate
+    int ttsSampleRate_ = 22050;  // Probed from eSpeak by initializeEngines()
+    bool engineInitTried_ = false;  // Render worker only; reset at activation
 
     // World pitch shifter
     std::unique_ptr<FlaschenTaschen::WorldPitchShifter> pitchShifter_;
-
-    // TTS audio buffer for playback
-    std::vector<float> ttsAudioBuffer_;
-    std::mutex ttsBufferMutex_;
+    FlaschenTaschen::AnalysisTuner analysisTuner_;  // F0 range and DIO speed per analysis
+
+    // Low-latency PSOLA pitch shifter (kParamPitchEngine / <TTS engine="fast">)
+    std::unique_ptr<FlaschenTaschen::PsolaPitchShifter> fastShifter_;
+
+    // Streaming resynthesis and TTS-rate conversion of cache misses (render worker only)
+    FlaschenTaschen::WorldStreamSynthesizer streamSynth_;
+    FlaschenTaschen::Resampler streamResampler_;
+    std::vector<float> streamBlock_;
+
+    // Background render thread (owns all use of tts_ and pitchShifter_ while running)
+    FlaschenTaschen::RenderWorker renderWorker_;
+    std::atomic<bool> ttsSettingsDirty_{false};
+
+    // Finished renders and World analyses per (syllable, voice settings, note); render worker only
+    FlaschenTaschen::RenderCache renderCache_;
+
+    // eSpeak output persisted between sessions, shared by all instances; render worker only
+    std::shared_ptr<FlaschenTaschen::SpeechCache> speechCache_;
+    std::string speechCachePath_;   // Resolved path speechCache_ was opened for (or failed on)
+
+    // Pre-bake: the render worker runs eSpeak/analysis serially, the pool
+    // synthesizes notes in parallel and hands results back to the worker
+    struct BakedRender {
+        FlaschenTaschen::RenderCacheKey key;
+        std::vector<float> samples;
+        unsigned bakeId = 0;
+    };
+    FlaschenTaschen::ThreadPool bakePool_;
+    std::mutex bakeResultsMutex_;
+    std::vector<BakedRender> bakeResults_;
+    std::atomic<unsigned> bakeId_{0};
+    std::atomic<int> prebakeDone_{0};   // Written by the render worker, polled by the UI thread
+    std::atomic<int> prebakeTotal_{0};
+    // Bumped per TTS parameter change; rebuildCacheIfSettled() waits for one
+    // quiet poll interval so automation ramps trigger only one re-bake
+    std::atomic<unsigned> ttsChanges_{0};
+    unsigned polledTtsChanges_ = 0;   // UI thread only
+    unsigned rebuiltTtsChanges_ = 0;  // UI thread only
+    // Syllables analyzed together by one pre-bake task (WorldPitchShifter::
+    // analyzeBatch); live notes wait for at most one such task
+    static constexpr size_t kPrebakeBatchSyllables = 16;
+
+    // Playback voices (render worker writes, audio thread mixes)
+    static constexpr double kVoiceBufferSeconds = 8.0;
+    FlaschenTaschen::VoicePool voicePool_;
+
+    // Per-stage timing histograms (recorded on every thread, read by sendLatencyStats)
+    mutable FlaschenTaschen::LatencyStats latencyStats_;
+
+    // Look-ahead: playback delay that gives renders a head start, reported
+    // to the host as latency. Returns true if the sample count changed.
+    bool updateLookAhead();
+    void sendLatencyChanged();  // UI thread, answering "GetStatus"
+    std::atomic<bool> latencyChanged_{false};  // Set by the loader, cleared by sendLatencyChanged
+    std::atomic<int> lookAheadMs_{0};
+    std::atomic<Steinberg::uint32> lookAheadSamples_{0};
+    std::atomic<int> releaseMs_{0};  // Note-off fade from the mapping's <TTS releaseMs>
 
     // Current state
-    std::string currentSyllable_;
+    std::atomic<int> currentSyllableIndex_{-1};  // Into the current mapping's syllables
     std::atomic<int> currentNoteNumber_{-1};
+    std::atomic<bool> lightOrganMode_{false};  // From the mapping's <Display lightOrgan>
 
     // Parameters
     std::atomic<float> fontScale_{1.0f};
@@ -142,9 +309,23 @@ private:
     std::atomic<float> ttsVolume_{0.5f}; // Normalized 0-1
     std::atomic<bool> pitchShiftEnabled_{true};
     std::atomic<int> octaveOffset_{0};   // -3 to +3
+    std::atomic<FlaschenTaschen::PitchEngine> pitchEngine_{FlaschenTaschen::PitchEngine::World};
+
+    // Every parameter's value when the current block started (audio
+    // thread); ramps interpolate from here however often the block is split
+    static constexpr int kNumParameters = kParamPitchEngine - kParamFontScale + 1;
+    Steinberg::Vst::ParamValue blockStartValues_[kNumParameters] = {};
+
+    // <TTS outputs>: which bus each note plays on
+    enum class OutputRouting { Main = 0, Voice, Syllable };
+    std::atomic<OutputRouting> outputRouting_{OutputRouting::Main};
 
     // Audio processing
     double sampleRate_ = 44100.0;
+    // Host bounce (ProcessSetup::processMode == kOffline): notes render
+    // synchronously with World and Harvest, and the display stays off
+    std::atomic<bool> offline_{false};
+    int64_t samplePosition_ = 0;  // Samples processed since activation (audio thread)
 };
 
 //------------------------------------------------------------------------
@@ -15,15 +15,40 @@
 
 namespace {
 
+//-----------------------------------------------------------------------------
+// CheapTrickWorkspace holds the per-frame scratch of one block, taken from
+// its lane. Every array has fft_size elements; the F0-adaptive window never
+// exceeds the FFT length.
+//-----------------------------------------------------------------------------
+typedef struct {
+  double *smoothing_lifter;
+  double *compensation_lifter;
+  int *base_index;
+  int *safe_index;
+  double *window;
+  SmoothingBuffer *smoothing;
+} CheapTrickWorkspace;
+
+static void InitializeCheapTrickWorkspace(int fft_size, WorldLane *lane,
+    CheapTrickWorkspace *workspace) {
+  workspace->smoothing_lifter = LaneDoubles(lane, fft_size);
+  workspace->compensation_lifter = LaneDoubles(lane, fft_size);
+  workspace->base_index = LaneInts(lane, fft_size);
+  workspace->safe_index = LaneInts(lane, fft_size);
+  workspace->window = LaneDoubles(lane, fft_size);
+  workspace->smoothing = &lane->smoothing;
+}
+
 //-----------------------------------------------------------------------------
 // SmoothingWithRecovery() carries out the spectral smoothing and spectral
 // recovery on the Cepstrum domain.
 //-----------------------------------------------------------------------------
 static void SmoothingWithRecovery(double f0, int fs, int fft_size, double q1,
     const ForwardRealFFT *forward_real_fft,
-    const InverseRealFFT *inverse_real_fft, double *spectral_envelope) {
-  double *smoothing_lifter = new double[fft_size];
-  double *compensation_lifter = new double[fft_size];
+    const InverseRealFFT *inverse_real_fft,
+    const CheapTrickWorkspace *workspace, double *spectral_envelope) {
+  double *smoothing_lifter = workspace->smoothing_lifter;
+  double *compensation_lifter = workspace->compensation_lifter;
 
   smoothing_lifter[0] = 1.0;
   compensation_lifter[0] = (1.0 - 2.0 * q1) + 2.0 * q1;
@@ -51,9 +76,6 @@ static void SmoothingWithRecovery(double f0, int fs, int fft_size, double q1,
 
   for (int i = 0; i <= fft_size / 2; ++i)
     spectral_envelope[i] = exp(inverse_real_fft->waveform[i]);
-
-  delete[] smoothing_lifter;
-  delete[] compensation_lifter;
 }
 
 //-----------------------------------------------------------------------------
@@ -62,7 +84,8 @@ static void SmoothingWithRecovery(double f0, int fs, int fft_size, double q1,
 // is corrected.
 //-----------------------------------------------------------------------------
 static void GetPowerSpectrum(int fs, double f0, int fft_size,
-    const ForwardRealFFT *forward_real_fft) {
+    const ForwardRealFFT *forward_real_fft,
+    const CheapTrickWorkspace *workspace) {
   int half_window_length = matlab_round(1.5 * fs / f0);
 
   // FFT
@@ -78,7 +101,8 @@ static void GetPowerSpectrum(int fs, double f0, int fft_size,
       forward_real_fft->spectrum[i][1] * forward_real_fft->spectrum[i][1];
 
   // DC correction
-  DCCorrection(power_spectrum, f0, fs, fft_size, power_spectrum);
+  DCCorrection(power_spectrum, f0, fs, fft_size, workspace->smoothing,
+      power_spectrum);
 }
 
 //-----------------------------------------------------------------------------
@@ -111,12 +135,13 @@ static void SetParametersForGetWindowedWaveform(int half_window_length,
 //-----------------------------------------------------------------------------
 static void GetWindowedWaveform(const double *x, int x_length, int fs,
     double current_f0, double currnet_position,
-    const ForwardRealFFT *forward_real_fft, RandnState *randn_state) {
+    const ForwardRealFFT *forward_real_fft,
+    const CheapTrickWorkspace *workspace, RandnState *randn_state) {
   int half_window_length = matlab_round(1.5 * fs / current_f0);
 
-  int *base_index = new int[half_window_length * 2 + 1];
-  int *safe_index = new int[half_window_length * 2 + 1];
-  double *window  = new double[half_window_length * 2 + 1];
+  int *base_index = workspace->base_index;
+  int *safe_index = workspace->safe_index;
+  double *window  = workspace->window;
 
   SetParametersForGetWindowedWaveform(half_window_length, x_length,
       currnet_position, fs, current_f0, base_index, safe_index, window);
@@ -135,10 +160,6 @@ static void GetWindowedWaveform(const double *x, int x_length, int fs,
   double weighting_coefficient = tmp_weight1 / tmp_weight2;
   for (int i = 0; i <= half_window_length * 2; ++i)
     waveform[i] -= window[i] * weighting_coefficient;
-
-  delete[] base_index;
-  delete[] safe_index;
-  delete[] window;
 }
 
 //-----------------------------------------------------------------------------
@@ -159,22 +180,24 @@ static void AddInfinitesimalNoise(const double *input_spectrum, int fft_size,
 static void CheapTrickGeneralBody(const double *x, int x_length, int fs,
     double current_f0, int fft_size, double current_position, double q1,
     const ForwardRealFFT *forward_real_fft,
-    const InverseRealFFT *inverse_real_fft, double *spectral_envelope, RandnState *randn_state) {
+    const InverseRealFFT *inverse_real_fft,
+    const CheapTrickWorkspace *workspace, double *spectral_envelope,
+    RandnState *randn_state) {
   // F0-adaptive windowing
   GetWindowedWaveform(x, x_length, fs, current_f0, current_position,
-      forward_real_fft, randn_state);
+      forward_real_fft, workspace, randn_state);
 
   // Calculate power spectrum with DC correction
   // Note: The calculated power spectrum is stored in an array for waveform.
   // In this imprementation, power spectrum is transformed by FFT (NOT IFFT).
   // However, the same result is obtained.
   // This is tricky but important for simple implementation.
-  GetPowerSpectrum(fs, current_f0, fft_size, forward_real_fft);
+  GetPowerSpectrum(fs, current_f0, fft_size, forward_real_fft, workspace);
 
   // Smoothing of the power (linear axis)
   // forward_real_fft.waveform is the power spectrum.
   LinearSmoothing(forward_real_fft->waveform, current_f0 * 2.0 / 3.0,
-      fs, fft_size, forward_real_fft->waveform);
+      fs, fft_size, workspace->smoothing, forward_real_fft->waveform);
 
   // Add infinitesimal noise
   // This is a safeguard to avoid including zero in the spectrum.
@@ -183,7 +206,106 @@ static void CheapTrickGeneralBody(const double *x, int x_length, int fs,
 
   // Smoothing (log axis) and spectral recovery on the cepstrum domain.
   SmoothingWithRecovery(current_f0, fs, fft_size, q1, forward_real_fft,
-      inverse_real_fft, spectral_envelope);
+      inverse_real_fft, workspace, spectral_envelope);
+}
+
+typedef struct {
+  const double *x;
+  int x_length;
+  int fs;
+  const double *temporal_positions;
+  const double *f0;
+  int f0_length;
+  const CheapTrickOption *option;
+  double **spectrogram;
+  int frames_per_block;
+  WorldWorkspace *workspace;
+} CheapTrickContext;
+
+//-----------------------------------------------------------------------------
+// CheapTrickFrames() analyzes frames [begin, end) with the random stream of
+// the block they form, using FFT buffers and scratch set up by the caller.
+//-----------------------------------------------------------------------------
+static void CheapTrickFrames(const double *x, int x_length, int fs,
+    const double *temporal_positions, const double *f0, int begin, int end,
+    int stream, const CheapTrickOption *option,
+    const ForwardRealFFT *forward_real_fft,
+    const InverseRealFFT *inverse_real_fft,
+    const CheapTrickWorkspace *workspace, double **spectrogram) {
+  RandnState randn_state = {};
+  randn_seed_stream(&randn_state, stream);
+
+  int fft_size = option->fft_size;
+  double f0_floor = GetF0FloorForCheapTrick(fs, fft_size);
+  double current_f0;
+  for (int i = begin; i < end; ++i) {
+    current_f0 = f0[i] <= f0_floor ? world::kDefaultF0 : f0[i];
+    CheapTrickGeneralBody(x, x_length, fs, current_f0, fft_size,
+        temporal_positions[i], option->q1, forward_real_fft,
+        inverse_real_fft, workspace, spectrogram[i], &randn_state);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// CheapTrickBlock() analyzes one block of frames with its own lane (FFT
+// buffers and scratch) and random stream. Blocks write disjoint rows of the
+// spectrogram.
+//-----------------------------------------------------------------------------
+static void CheapTrickBlock(void *context, int block) {
+  const CheapTrickContext *c = static_cast<const CheapTrickContext *>(context);
+  int fft_size = c->option->fft_size;
+  int begin = block * c->frames_per_block;
+  int end = MyMinInt(c->f0_length, begin + c->frames_per_block);
+
+  WorldLane *lane = StartWorldLane(c->workspace, block);
+  CheapTrickWorkspace workspace;
+  InitializeCheapTrickWorkspace(fft_size, lane, &workspace);
+
+  CheapTrickFrames(c->x, c->x_length, c->fs, c->temporal_positions, c->f0,
+      begin, end, block, c->option, GetLaneForwardRealFFT(lane, fft_size, 0),
+      GetLaneInverseRealFFT(lane, fft_size, 0), &workspace, c->spectrogram);
+}
+
+typedef struct {
+  const WorldAnalysisBatch *batch;
+  int fs;
+  const CheapTrickOption *option;
+  const WorldBatchBlock *blocks;
+  int number_of_blocks;
+  int number_of_tasks;
+  WorldWorkspace *workspace;
+} CheapTrickBatchContext;
+
+//-----------------------------------------------------------------------------
+// CheapTrickBatchTask() analyzes a run of batch blocks, possibly of several
+// segments, in one lane for all of them.
+//-----------------------------------------------------------------------------
+static void CheapTrickBatchTask(void *context, int task) {
+  const CheapTrickBatchContext *c =
+    static_cast<const CheapTrickBatchContext *>(context);
+  int first = static_cast<int>(static_cast<long long>(task) *
+    c->number_of_blocks / c->number_of_tasks);
+  int last = static_cast<int>(static_cast<long long>(task + 1) *
+    c->number_of_blocks / c->number_of_tasks);
+  int fft_size = c->option->fft_size;
+
+  WorldLane *lane = StartWorldLane(c->workspace, task);
+  CheapTrickWorkspace workspace;
+  InitializeCheapTrickWorkspace(fft_size, lane, &workspace);
+  const ForwardRealFFT *forward_real_fft =
+    GetLaneForwardRealFFT(lane, fft_size, 0);
+  const InverseRealFFT *inverse_real_fft =
+    GetLaneInverseRealFFT(lane, fft_size, 0);
+
+  const WorldAnalysisBatch *batch = c->batch;
+  for (int b = first; b < last; ++b) {
+    const WorldBatchBlock *block = &c->blocks[b];
+    int segment = block->segment;
+    CheapTrickFrames(batch->x[segment], batch->x_length[segment], c->fs,
+        batch->temporal_positions[segment], batch->f0[segment], block->begin,
+        block->end, block->stream, c->option, forward_real_fft,
+        inverse_real_fft, &workspace, batch->output[segment]);
+  }
 }
 
 }  // namespace
@@ -200,32 +322,47 @@ double GetF0FloorForCheapTrick(int fs, int fft_size) {
 void CheapTrick(const double *x, int x_length, int fs,
     const double *temporal_positions, const double *f0, int f0_length,
     const CheapTrickOption *option, double **spectrogram) {
-  int fft_size = option->fft_size;
-
-  RandnState randn_state = {};
-  randn_reseed(&randn_state);
-
-  double f0_floor = GetF0FloorForCheapTrick(fs, fft_size);
-  double *spectral_envelope = new double[fft_size];
-
-  ForwardRealFFT forward_real_fft = {0};
-  InitializeForwardRealFFT(fft_size, &forward_real_fft);
-  InverseRealFFT inverse_real_fft = {0};
-  InitializeInverseRealFFT(fft_size, &inverse_real_fft);
-
-  double current_f0;
-  for (int i = 0; i < f0_length; ++i) {
-    current_f0 = f0[i] <= f0_floor ? world::kDefaultF0 : f0[i];
-    CheapTrickGeneralBody(x, x_length, fs, current_f0, fft_size,
-        temporal_positions[i], option->q1, &forward_real_fft,
-        &inverse_real_fft, spectral_envelope, &randn_state);
-    for (int j = 0; j <= fft_size / 2; ++j)
-      spectrogram[i][j] = spectral_envelope[j];
+  WorldWorkspace *workspace = AcquireWorldWorkspace(option->workspace);
+  CheapTrickContext context = { x, x_length, fs, temporal_positions, f0,
+      f0_length, option, spectrogram, f0_length, workspace };
+
+  // Serial analysis is one block; with an executor the frames are split
+  // into fixed blocks, so the result does not depend on the thread count.
+  int number_of_blocks = 1;
+  if (option->executor != NULL) {
+    context.frames_per_block = world::kFramesPerParallelBlock;
+    number_of_blocks = (f0_length + context.frames_per_block - 1) /
+      context.frames_per_block;
   }
+  ReserveWorldLanes(workspace, number_of_blocks);
+  WorldParallelFor(option->executor, number_of_blocks, CheapTrickBlock,
+      &context);
+  ReleaseWorldWorkspace(option->workspace, workspace);
+}
 
-  DestroyForwardRealFFT(&forward_real_fft);
-  DestroyInverseRealFFT(&inverse_real_fft);
-  delete[] spectral_envelope;
+void CheapTrickBatch(const WorldAnalysisBatch *batch, int fs,
+    const CheapTrickOption *option) {
+  // Blocks as CheapTrick() forms them for each segment; with an executor,
+  // runs of blocks are spread over at most kMaxBatchTasks tasks
+  int frames_per_block =
+    option->executor != NULL ? world::kFramesPerParallelBlock : 0;
+  int number_of_blocks = GetWorldBatchBlocks(batch, frames_per_block, NULL, 0);
+  if (number_of_blocks == 0) return;
+  WorldWorkspace *workspace = AcquireWorldWorkspace(option->workspace);
+  WorldBatchBlock *blocks = static_cast<WorldBatchBlock *>(
+      AllocateWorldScratch(StartWorldMainLane(workspace),
+      sizeof(WorldBatchBlock) * number_of_blocks));
+  GetWorldBatchBlocks(batch, frames_per_block, blocks, number_of_blocks);
+
+  CheapTrickBatchContext context = { batch, fs, option, blocks,
+      number_of_blocks, 1, workspace };
+  if (option->executor != NULL)
+    context.number_of_tasks = MyMinInt(number_of_blocks, world::kMaxBatchTasks);
+  ReserveWorldLanes(workspace, context.number_of_tasks);
+  WorldParallelFor(option->executor, context.number_of_tasks,
+      CheapTrickBatchTask, &context);
+
+  ReleaseWorldWorkspace(option->workspace, workspace);
 }
 
 void InitializeCheapTrickOption(int fs, CheapTrickOption *option) {
@@ -237,4 +374,8 @@ void InitializeCheapTrickOption(int fs, CheapTrickOption *option) {
   // knowledge of the signal processing in CheapTrick.
   option->f0_floor = world::kFloorF0;
   option->fft_size = GetFFTSizeForCheapTrick(fs, option);
+  // Frames are analyzed one after another unless an executor is given.
+  option->executor = NULL;
+  // Scratch is allocated for each call unless a workspace is given.
+  option->workspace = NULL;
 }
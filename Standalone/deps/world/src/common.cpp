@@ -6,6 +6,7 @@
 // common.cpp includes functions used in at least two files.
 // (1) Common functions
 // (2) FFT, IFFT and minimum phase analysis.
+// (3) Workspaces that keep scratch and FFTs between calls.
 //
 // In FFT analysis and minimum phase analysis,
 // Functions "Initialize*()" allocate the mamory.
@@ -20,6 +21,9 @@
 
 #include <math.h>
 
+#include <deque>
+#include <vector>
+
 #include "world/constantnumbers.h"
 #include "world/matlabfunctions.h"
 
@@ -45,6 +49,16 @@ static void SetParametersForLinearSmoothing(int boundary, int fft_size, int fs,
     fs - width / 2.0;
 }
 
+// Returns at least size doubles of the buffer, growing it if needed
+static double *GetSmoothingScratch(SmoothingBuffer *smoothing, int size) {
+  if (size > smoothing->size) {
+    delete[] smoothing->buffer;
+    smoothing->buffer = new double[size];
+    smoothing->size = size;
+  }
+  return smoothing->buffer;
+}
+
 }  // namespace
 
 //-----------------------------------------------------------------------------
@@ -53,11 +67,23 @@ int GetSuitableFFTSize(int sample) {
     static_cast<int>(log(static_cast<double>(sample)) / world::kLog2) + 1.0));
 }
 
+void InitializeSmoothingBuffer(SmoothingBuffer *smoothing) {
+  smoothing->buffer = NULL;
+  smoothing->size = 0;
+}
+
+void DestroySmoothingBuffer(SmoothingBuffer *smoothing) {
+  delete[] smoothing->buffer;
+  smoothing->buffer = NULL;
+  smoothing->size = 0;
+}
+
 void DCCorrection(const double *input, double f0, int fs, int fft_size,
-    double *output) {
+    SmoothingBuffer *smoothing, double *output) {
   int upper_limit = 2 + static_cast<int>(f0 * fft_size / fs);
-  double *low_frequency_replica = new double[upper_limit];
-  double *low_frequency_axis = new double[upper_limit];
+  double *low_frequency_replica =
+    GetSmoothingScratch(smoothing, upper_limit * 2);
+  double *low_frequency_axis = low_frequency_replica + upper_limit;
 
   for (int i = 0; i < upper_limit; ++i)
     low_frequency_axis[i] = static_cast<double>(i) * fs / fft_size;
@@ -69,24 +95,24 @@ void DCCorrection(const double *input, double f0, int fs, int fft_size,
 
   for (int i = 0; i < upper_limit_replica; ++i)
     output[i] = input[i] + low_frequency_replica[i];
-
-  delete[] low_frequency_replica;
-  delete[] low_frequency_axis;
 }
 
 void LinearSmoothing(const double *input, double width, int fs, int fft_size,
-    double *output) {
+    SmoothingBuffer *smoothing, double *output) {
   int boundary = static_cast<int>(width * fft_size / fs) + 1;
+  int mirroring_length = fft_size / 2 + boundary * 2 + 1;
+  int spectrum_length = fft_size / 2 + 1;
 
   // These parameters are set by the other function.
-  double *mirroring_spectrum = new double[fft_size / 2 + boundary * 2 + 1];
-  double *mirroring_segment = new double[fft_size / 2 + boundary * 2 + 1];
-  double *frequency_axis = new double[fft_size / 2 + 1];
+  double *mirroring_spectrum = GetSmoothingScratch(smoothing,
+      mirroring_length * 2 + spectrum_length * 3);
+  double *mirroring_segment = mirroring_spectrum + mirroring_length;
+  double *frequency_axis = mirroring_segment + mirroring_length;
   SetParametersForLinearSmoothing(boundary, fft_size, fs, width,
       input, mirroring_spectrum, mirroring_segment, frequency_axis);
 
-  double *low_levels = new double[fft_size / 2 + 1];
-  double *high_levels = new double[fft_size / 2 + 1];
+  double *low_levels = frequency_axis + spectrum_length;
+  double *high_levels = low_levels + spectrum_length;
   double origin_of_mirroring_axis = -(boundary - 0.5) * fs / fft_size;
   double discrete_frequency_interval = static_cast<double>(fs) / fft_size;
 
@@ -102,12 +128,6 @@ void LinearSmoothing(const double *input, double width, int fs, int fft_size,
 
   for (int i = 0; i <= fft_size / 2; ++i)
     output[i] = (high_levels[i] - low_levels[i]) / width;
-
-  delete[] mirroring_spectrum;
-  delete[] mirroring_segment;
-  delete[] frequency_axis;
-  delete[] low_levels;
-  delete[] high_levels;
 }
 
 void NuttallWindow(int y_length, double *y) {
@@ -226,3 +246,191 @@ void DestroyMinimumPhaseAnalysis(MinimumPhaseAnalysis *minimum_phase) {
   delete[] minimum_phase->log_spectrum;
   delete[] minimum_phase->minimum_phase_spectrum;
 }
+
+//-----------------------------------------------------------------------------
+// Workspaces
+namespace {
+// Scratch arrays start on this boundary
+const size_t kScratchAlignment = 64;
+
+enum { kLaneForwardFFT, kLaneInverseFFT, kLaneMinimumPhase };
+
+}  // namespace
+
+// Header of an array allocated outside the block
+struct WorldScratchChunk {
+  WorldScratchChunk *next;
+  double padding[7];  // Keeps the array after the header aligned
+};
+
+struct WorldFFTEntry {
+  int kind;
+  int fft_size;
+  int slot;
+  ForwardRealFFT forward_real_fft;
+  InverseRealFFT inverse_real_fft;
+  MinimumPhaseAnalysis minimum_phase;
+};
+
+// A deque, so entries do not move while callers hold them
+struct WorldFFTCache {
+  std::deque<WorldFFTEntry> entries;
+};
+
+struct WorldWorkspace {
+  WorldLane main;
+  std::vector<WorldLane *> lanes;
+};
+
+namespace {
+static void InitializeWorldLane(WorldLane *lane) {
+  lane->scratch.block = NULL;
+  lane->scratch.capacity = 0;
+  lane->scratch.used = 0;
+  lane->scratch.peak = 0;
+  lane->scratch.chunks = NULL;
+  InitializeSmoothingBuffer(&lane->smoothing);
+  lane->ffts = new WorldFFTCache;
+}
+
+static void FreeScratchChunks(WorldScratch *scratch) {
+  while (scratch->chunks != NULL) {
+    WorldScratchChunk *next = scratch->chunks->next;
+    delete[] reinterpret_cast<char *>(scratch->chunks);
+    scratch->chunks = next;
+  }
+}
+
+static void DestroyWorldLane(WorldLane *lane) {
+  FreeScratchChunks(&lane->scratch);
+  delete[] lane->scratch.block;
+  DestroySmoothingBuffer(&lane->smoothing);
+  for (size_t i = 0; i < lane->ffts->entries.size(); ++i) {
+    WorldFFTEntry *entry = &lane->ffts->entries[i];
+    if (entry->kind == kLaneForwardFFT)
+      DestroyForwardRealFFT(&entry->forward_real_fft);
+    else if (entry->kind == kLaneInverseFFT)
+      DestroyInverseRealFFT(&entry->inverse_real_fft);
+    else
+      DestroyMinimumPhaseAnalysis(&entry->minimum_phase);
+  }
+  delete lane->ffts;
+}
+
+// Empties the scratch; the block grows to the peak of its last use
+static void ResetWorldLane(WorldLane *lane) {
+  WorldScratch *scratch = &lane->scratch;
+  FreeScratchChunks(scratch);
+  if (scratch->peak > scratch->capacity) {
+    delete[] scratch->block;
+    scratch->block = new char[scratch->peak];
+    scratch->capacity = scratch->peak;
+  }
+  scratch->used = 0;
+  scratch->peak = 0;
+}
+
+static WorldFFTEntry *FindLaneFFT(WorldLane *lane, int kind, int fft_size,
+    int slot) {
+  std::deque<WorldFFTEntry> &entries = lane->ffts->entries;
+  for (size_t i = 0; i < entries.size(); ++i)
+    if (entries[i].kind == kind && entries[i].fft_size == fft_size &&
+        entries[i].slot == slot)
+      return &entries[i];
+  WorldFFTEntry entry = {};
+  entry.kind = kind;
+  entry.fft_size = fft_size;
+  entry.slot = slot;
+  entries.push_back(entry);
+  return &entries.back();
+}
+
+}  // namespace
+
+WorldWorkspace *CreateWorldWorkspace(void) {
+  WorldWorkspace *workspace = new WorldWorkspace;
+  InitializeWorldLane(&workspace->main);
+  return workspace;
+}
+
+void DestroyWorldWorkspace(WorldWorkspace *workspace) {
+  if (workspace == NULL) return;
+  DestroyWorldLane(&workspace->main);
+  for (size_t i = 0; i < workspace->lanes.size(); ++i) {
+    DestroyWorldLane(workspace->lanes[i]);
+    delete workspace->lanes[i];
+  }
+  delete workspace;
+}
+
+WorldWorkspace *AcquireWorldWorkspace(WorldWorkspace *workspace) {
+  return workspace != NULL ? workspace : CreateWorldWorkspace();
+}
+
+void ReleaseWorldWorkspace(WorldWorkspace *workspace,
+    WorldWorkspace *acquired) {
+  if (acquired != workspace) DestroyWorldWorkspace(acquired);
+}
+
+WorldLane *StartWorldMainLane(WorldWorkspace *workspace) {
+  ResetWorldLane(&workspace->main);
+  return &workspace->main;
+}
+
+void ReserveWorldLanes(WorldWorkspace *workspace, int count) {
+  while (static_cast<int>(workspace->lanes.size()) < count) {
+    WorldLane *lane = new WorldLane;
+    InitializeWorldLane(lane);
+    workspace->lanes.push_back(lane);
+  }
+}
+
+WorldLane *StartWorldLane(WorldWorkspace *workspace, int index) {
+  WorldLane *lane = workspace->lanes[index];
+  ResetWorldLane(lane);
+  return lane;
+}
+
+void *AllocateWorldScratch(WorldLane *lane, size_t bytes) {
+  WorldScratch *scratch = &lane->scratch;
+  bytes = (bytes + kScratchAlignment - 1) / kScratchAlignment *
+    kScratchAlignment;
+  size_t offset = scratch->used;
+  scratch->used += bytes;
+  if (scratch->used > scratch->peak) scratch->peak = scratch->used;
+  if (scratch->used <= scratch->capacity) return scratch->block + offset;
+
+  char *memory = new char[sizeof(WorldScratchChunk) + bytes];
+  WorldScratchChunk *chunk = reinterpret_cast<WorldScratchChunk *>(memory);
+  chunk->next = scratch->chunks;
+  scratch->chunks = chunk;
+  return memory + sizeof(WorldScratchChunk);
+}
+
+void ReleaseWorldScratch(WorldLane *lane, size_t mark) {
+  if (mark < lane->scratch.used) lane->scratch.used = mark;
+}
+
+ForwardRealFFT *GetLaneForwardRealFFT(WorldLane *lane, int fft_size,
+    int slot) {
+  WorldFFTEntry *entry = FindLaneFFT(lane, kLaneForwardFFT, fft_size, slot);
+  if (entry->forward_real_fft.waveform == NULL)
+    InitializeForwardRealFFT(fft_size, &entry->forward_real_fft);
+  return &entry->forward_real_fft;
+}
+
+InverseRealFFT *GetLaneInverseRealFFT(WorldLane *lane, int fft_size,
+    int slot) {
+  WorldFFTEntry *entry = FindLaneFFT(lane, kLaneInverseFFT, fft_size, slot);
+  if (entry->inverse_real_fft.waveform == NULL)
+    InitializeInverseRealFFT(fft_size, &entry->inverse_real_fft);
+  return &entry->inverse_real_fft;
+}
+
+MinimumPhaseAnalysis *GetLaneMinimumPhaseAnalysis(WorldLane *lane,
+    int fft_size, int slot) {
+  WorldFFTEntry *entry = FindLaneFFT(lane, kLaneMinimumPhase, fft_size, slot);
+  if (entry->minimum_phase.log_spectrum == NULL)
+    InitializeMinimumPhaseAnalysis(fft_size, &entry->minimum_phase);
+  return &entry->minimum_phase;
+}
@@ -15,6 +15,45 @@
 #include "world/matlabfunctions.h"
 
 namespace {
+//-----------------------------------------------------------------------------
+// D4CWorkspace holds the per-frame scratch of one block, taken from its
+// lane. The window arrays and power_spectrum have fft_size elements (the
+// largest FFT used, see D4CBlock()); the spectral arrays have
+// fft_size / 2 + 1.
+//-----------------------------------------------------------------------------
+typedef struct {
+  int *base_index;
+  int *safe_index;
+  double *window;
+  double *power_spectrum;
+  double *tmp_real;
+  double *tmp_imag;
+  double *centroid1;
+  double *centroid2;
+  double *static_centroid;
+  double *smoothed_power_spectrum;
+  double *static_group_delay;
+  double *smoothed_group_delay;
+  SmoothingBuffer *smoothing;
+} D4CWorkspace;
+
+static void InitializeD4CWorkspace(int fft_size, WorldLane *lane,
+    D4CWorkspace *workspace) {
+  workspace->base_index = LaneInts(lane, fft_size);
+  workspace->safe_index = LaneInts(lane, fft_size);
+  workspace->window = LaneDoubles(lane, fft_size);
+  workspace->power_spectrum = LaneDoubles(lane, fft_size);
+  workspace->tmp_real = LaneDoubles(lane, fft_size / 2 + 1);
+  workspace->tmp_imag = LaneDoubles(lane, fft_size / 2 + 1);
+  workspace->centroid1 = LaneDoubles(lane, fft_size / 2 + 1);
+  workspace->centroid2 = LaneDoubles(lane, fft_size / 2 + 1);
+  workspace->static_centroid = LaneDoubles(lane, fft_size / 2 + 1);
+  workspace->smoothed_power_spectrum = LaneDoubles(lane, fft_size / 2 + 1);
+  workspace->static_group_delay = LaneDoubles(lane, fft_size / 2 + 1);
+  workspace->smoothed_group_delay = LaneDoubles(lane, fft_size / 2 + 1);
+  workspace->smoothing = &lane->smoothing;
+}
+
 //-----------------------------------------------------------------------------
 // SetParametersForGetWindowedWaveform()
 //-----------------------------------------------------------------------------
@@ -51,13 +90,14 @@ static void SetParametersForGetWindowedWaveform(int half_window_length,
 //-----------------------------------------------------------------------------
 static void GetWindowedWaveform(const double *x, int x_length, int fs,
     double current_f0, double current_position, int window_type,
-    double window_length_ratio, double *waveform, RandnState *randn_state) {
+    double window_length_ratio, double *waveform,
+    const D4CWorkspace *workspace, RandnState *randn_state) {
   int half_window_length =
     matlab_round(window_length_ratio * fs / current_f0 / 2.0);
 
-  int *base_index = new int[half_window_length * 2 + 1];
-  int *safe_index = new int[half_window_length * 2 + 1];
-  double *window  = new double[half_window_length * 2 + 1];
+  int *base_index = workspace->base_index;
+  int *safe_index = workspace->safe_index;
+  double *window  = workspace->window;
 
   SetParametersForGetWindowedWaveform(half_window_length, x_length,
       current_position, fs, current_f0, window_type, window_length_ratio,
@@ -77,10 +117,6 @@ static void GetWindowedWaveform(const double *x, int x_length, int fs,
   double weighting_coefficient = tmp_weight1 / tmp_weight2;
   for (int i = 0; i <= half_window_length * 2; ++i)
     waveform[i] -= window[i] * weighting_coefficient;
-
-  delete[] base_index;
-  delete[] safe_index;
-  delete[] window;
 }
 
 //-----------------------------------------------------------------------------
@@ -90,10 +126,11 @@ static void GetWindowedWaveform(const double *x, int x_length, int fs,
 static void GetCentroid(const double *x, int x_length, int fs,
     double current_f0, int fft_size, double current_position,
     const ForwardRealFFT *forward_real_fft, double *centroid,
-    RandnState *randn_state) {
+    const D4CWorkspace *workspace, RandnState *randn_state) {
   for (int i = 0; i < fft_size; ++i) forward_real_fft->waveform[i] = 0.0;
   GetWindowedWaveform(x, x_length, fs, current_f0,
-      current_position, world::kBlackman, 4.0, forward_real_fft->waveform, randn_state);
+      current_position, world::kBlackman, 4.0, forward_real_fft->waveform,
+      workspace, randn_state);
   double power = 0.0;
   for (int i = 0; i <= matlab_round(2.0 * fs / current_f0) * 2; ++i)
     power += forward_real_fft->waveform[i] * forward_real_fft->waveform[i];
@@ -101,8 +138,8 @@ static void GetCentroid(const double *x, int x_length, int fs,
     forward_real_fft->waveform[i] /= sqrt(power);
 
   fft_execute(forward_real_fft->forward_fft);
-  double *tmp_real = new double[fft_size / 2 + 1];
-  double *tmp_imag = new double[fft_size / 2 + 1];
+  double *tmp_real = workspace->tmp_real;
+  double *tmp_imag = workspace->tmp_imag;
   for (int i = 0; i <= fft_size / 2; ++i) {
     tmp_real[i] = forward_real_fft->spectrum[i][0];
     tmp_imag[i] = forward_real_fft->spectrum[i][1];
@@ -114,9 +151,6 @@ static void GetCentroid(const double *x, int x_length, int fs,
   for (int i = 0; i <= fft_size / 2; ++i)
     centroid[i] = forward_real_fft->spectrum[i][0] * tmp_real[i] +
       tmp_imag[i] * forward_real_fft->spectrum[i][1];
-
-  delete[] tmp_real;
-  delete[] tmp_imag;
 }
 
 //-----------------------------------------------------------------------------
@@ -125,21 +159,23 @@ static void GetCentroid(const double *x, int x_length, int fs,
 //-----------------------------------------------------------------------------
 static void GetStaticCentroid(const double *x, int x_length, int fs,
     double current_f0, int fft_size, double current_position,
-    const ForwardRealFFT *forward_real_fft, double *static_centroid, RandnState *randn_state) {
-  double *centroid1 = new double[fft_size / 2 + 1];
-  double *centroid2 = new double[fft_size / 2 + 1];
+    const ForwardRealFFT *forward_real_fft, double *static_centroid,
+    const D4CWorkspace *workspace, RandnState *randn_state) {
+  double *centroid1 = workspace->centroid1;
+  double *centroid2 = workspace->centroid2;
 
   GetCentroid(x, x_length, fs, current_f0, fft_size,
-      current_position - 0.25 / current_f0, forward_real_fft, centroid1, randn_state);
+      current_position - 0.25 / current_f0, forward_real_fft, centroid1,
+      workspace, randn_state);
   GetCentroid(x, x_length, fs, current_f0, fft_size,
-      current_position + 0.25 / current_f0, forward_real_fft, centroid2, randn_state);
+      current_position + 0.25 / current_f0, forward_real_fft, centroid2,
+      workspace, randn_state);
 
   for (int i = 0; i <= fft_size / 2; ++i)
     static_centroid[i] = centroid1[i] + centroid2[i];
 
-  DCCorrection(static_centroid, current_f0, fs, fft_size, static_centroid);
-  delete[] centroid1;
-  delete[] centroid2;
+  DCCorrection(static_centroid, current_f0, fs, fft_size,
+      workspace->smoothing, static_centroid);
 }
 
 //-----------------------------------------------------------------------------
@@ -149,10 +185,11 @@ static void GetStaticCentroid(const double *x, int x_length, int fs,
 static void GetSmoothedPowerSpectrum(const double *x, int x_length, int fs,
     double current_f0, int fft_size, double current_position,
     const ForwardRealFFT *forward_real_fft, double *smoothed_power_spectrum,
-    RandnState *randn_state) {
+    const D4CWorkspace *workspace, RandnState *randn_state) {
   for (int i = 0; i < fft_size; ++i) forward_real_fft->waveform[i] = 0.0;
   GetWindowedWaveform(x, x_length, fs, current_f0, current_position,
-      world::kHanning, 4.0, forward_real_fft->waveform, randn_state);
+      world::kHanning, 4.0, forward_real_fft->waveform, workspace,
+      randn_state);
 
   fft_execute(forward_real_fft->forward_fft);
   for (int i = 0; i <= fft_size / 2; ++i)
@@ -160,9 +197,9 @@ static void GetSmoothedPowerSpectrum(const double *x, int x_length, int fs,
       forward_real_fft->spectrum[i][0] * forward_real_fft->spectrum[i][0] +
       forward_real_fft->spectrum[i][1] * forward_real_fft->spectrum[i][1];
   DCCorrection(smoothed_power_spectrum, current_f0, fs, fft_size,
-      smoothed_power_spectrum);
+      workspace->smoothing, smoothed_power_spectrum);
   LinearSmoothing(smoothed_power_spectrum, current_f0, fs, fft_size,
-      smoothed_power_spectrum);
+      workspace->smoothing, smoothed_power_spectrum);
 }
 
 //-----------------------------------------------------------------------------
@@ -171,20 +208,18 @@ static void GetSmoothedPowerSpectrum(const double *x, int x_length, int fs,
 //-----------------------------------------------------------------------------
 static void GetStaticGroupDelay(const double *static_centroid,
     const double *smoothed_power_spectrum, int fs, double f0,
-    int fft_size, double *static_group_delay) {
+    int fft_size, const D4CWorkspace *workspace, double *static_group_delay) {
   for (int i = 0; i <= fft_size / 2; ++i)
     static_group_delay[i] = static_centroid[i] / smoothed_power_spectrum[i];
   LinearSmoothing(static_group_delay, f0 / 2.0, fs, fft_size,
-      static_group_delay);
+      workspace->smoothing, static_group_delay);
 
-  double *smoothed_group_delay = new double[fft_size / 2 + 1];
+  double *smoothed_group_delay = workspace->smoothed_group_delay;
   LinearSmoothing(static_group_delay, f0, fs, fft_size,
-      smoothed_group_delay);
+      workspace->smoothing, smoothed_group_delay);
 
   for (int i = 0; i <= fft_size / 2; ++i)
     static_group_delay[i] -= smoothed_group_delay[i];
-
-  delete[] smoothed_group_delay;
 }
 
 //-----------------------------------------------------------------------------
@@ -194,14 +229,14 @@ static void GetStaticGroupDelay(const double *static_centroid,
 static void GetCoarseAperiodicity(const double *static_group_delay, int fs,
     int fft_size, int number_of_aperiodicities, const double *window,
     int window_length, const ForwardRealFFT *forward_real_fft,
-    double *coarse_aperiodicity) {
+    const D4CWorkspace *workspace, double *coarse_aperiodicity) {
   int boundary =
     matlab_round(fft_size * 8.0 / window_length);
   int half_window_length = window_length / 2;
 
   for (int i = 0; i < fft_size; ++i) forward_real_fft->waveform[i] = 0.0;
 
-  double *power_spectrum = new double[fft_size / 2 + 1];
+  double *power_spectrum = workspace->power_spectrum;
   int center;
   for (int i = 0; i < number_of_aperiodicities; ++i) {
     center =
@@ -221,18 +256,19 @@ static void GetCoarseAperiodicity(const double *static_group_delay, int fs,
       10 * log10(power_spectrum[fft_size / 2 - boundary - 1] /
                  power_spectrum[fft_size / 2]);
   }
-  delete[] power_spectrum;
 }
 
 static double D4CLoveTrainSub(const double *x, int fs, int x_length,
     double current_f0, double current_position, int f0_length, int fft_size,
     int boundary0, int boundary1, int boundary2,
-    ForwardRealFFT *forward_real_fft, RandnState *randn_state) {
-  double *power_spectrum = new double[fft_size];
+    ForwardRealFFT *forward_real_fft, const D4CWorkspace *workspace,
+    RandnState *randn_state) {
+  double *power_spectrum = workspace->power_spectrum;
 
   int window_length = matlab_round(1.5 * fs / current_f0) * 2 + 1;
   GetWindowedWaveform(x, x_length, fs, current_f0, current_position,
-    world::kBlackman, 3.0, forward_real_fft->waveform, randn_state);
+    world::kBlackman, 3.0, forward_real_fft->waveform, workspace,
+    randn_state);
 
   for (int i = window_length; i < fft_size; ++i)
     forward_real_fft->waveform[i] = 0.0;
@@ -246,9 +282,16 @@ static double D4CLoveTrainSub(const double *x, int fs, int x_length,
   for (int i = boundary0; i <= boundary2; ++i)
     power_spectrum[i] += +power_spectrum[i - 1];
 
-  double aperiodicity0 = power_spectrum[boundary1] / power_spectrum[boundary2];
-  delete[] power_spectrum;
-  return aperiodicity0;
+  return power_spectrum[boundary1] / power_spectrum[boundary2];
+}
+
+//-----------------------------------------------------------------------------
+// GetFFTSizeForLoveTrain() returns the FFT length used by D4CLoveTrain().
+//-----------------------------------------------------------------------------
+static int GetFFTSizeForLoveTrain(int fs) {
+  double lowest_f0 = 40.0;
+  return static_cast<int>(pow(2.0, 1.0 +
+    static_cast<int>(log(3.0 * fs / lowest_f0 + 1) / world::kLog2)));
 }
 
 //-----------------------------------------------------------------------------
@@ -256,32 +299,31 @@ static double D4CLoveTrainSub(const double *x, int fs, int x_length,
 // If a frame was determined as the unvoiced section, aperiodicity is set to
 // very high value as the safeguard.
 // If it was voiced section, the aperiodicity of 0 Hz is set to -60 dB.
+// Frame i is written to aperiodicity0[i - begin]; forward_real_fft has the
+// GetFFTSizeForLoveTrain() length.
 //-----------------------------------------------------------------------------
 static void D4CLoveTrain(const double *x, int fs, int x_length,
     const double *f0, int f0_length, const double *temporal_positions,
-    double *aperiodicity0, RandnState *randn_state) {
+    int begin, int end, double *aperiodicity0,
+    ForwardRealFFT *forward_real_fft, const D4CWorkspace *workspace,
+    RandnState *randn_state) {
   double lowest_f0 = 40.0;
-  int fft_size = static_cast<int>(pow(2.0, 1.0 +
-    static_cast<int>(log(3.0 * fs / lowest_f0 + 1) / world::kLog2)));
-  ForwardRealFFT forward_real_fft = { 0 };
-  InitializeForwardRealFFT(fft_size, &forward_real_fft);
+  int fft_size = forward_real_fft->fft_size;
 
   // Cumulative powers at 100, 4000, 7900 Hz are used for VUV identification.
   int boundary0 = static_cast<int>(ceil(100.0 * fft_size / fs));
   int boundary1 = static_cast<int>(ceil(4000.0 * fft_size / fs));
   int boundary2 = static_cast<int>(ceil(7900.0 * fft_size / fs));
-  for (int i = 0; i < f0_length; ++i) {
+  for (int i = begin; i < end; ++i) {
     if (f0[i] == 0.0) {
-      aperiodicity0[i] = 0.0;
+      aperiodicity0[i - begin] = 0.0;
       continue;
     }
-    aperiodicity0[i] = D4CLoveTrainSub(x, fs, x_length,
+    aperiodicity0[i - begin] = D4CLoveTrainSub(x, fs, x_length,
         MyMaxDouble(f0[i], lowest_f0), temporal_positions[i], f0_length,
-        fft_size, boundary0, boundary1, boundary2, &forward_real_fft,
-        randn_state);
+        fft_size, boundary0, boundary1, boundary2, forward_real_fft,
+        workspace, randn_state);
   }
-
-  DestroyForwardRealFFT(&forward_real_fft);
 }
 
 //-----------------------------------------------------------------------------
@@ -294,30 +336,26 @@ static void D4CGeneralBody(const double *x, int x_length, int fs,
     double current_f0, int fft_size, double current_position,
     int number_of_aperiodicities, const double *window, int window_length,
     const ForwardRealFFT *forward_real_fft, double *coarse_aperiodicity,
-    RandnState *randn_state) {
-  double *static_centroid = new double[fft_size / 2 + 1];
-  double *smoothed_power_spectrum = new double[fft_size / 2 + 1];
-  double *static_group_delay = new double[fft_size / 2 + 1];
+    const D4CWorkspace *workspace, RandnState *randn_state) {
+  double *static_centroid = workspace->static_centroid;
+  double *smoothed_power_spectrum = workspace->smoothed_power_spectrum;
+  double *static_group_delay = workspace->static_group_delay;
   GetStaticCentroid(x, x_length, fs, current_f0, fft_size, current_position,
-      forward_real_fft, static_centroid, randn_state);
+      forward_real_fft, static_centroid, workspace, randn_state);
   GetSmoothedPowerSpectrum(x, x_length, fs, current_f0, fft_size,
       current_position, forward_real_fft, smoothed_power_spectrum,
-      randn_state);
+      workspace, randn_state);
   GetStaticGroupDelay(static_centroid, smoothed_power_spectrum,
-      fs, current_f0, fft_size, static_group_delay);
+      fs, current_f0, fft_size, workspace, static_group_delay);
 
   GetCoarseAperiodicity(static_group_delay, fs, fft_size,
       number_of_aperiodicities, window, window_length, forward_real_fft,
-      coarse_aperiodicity);
+      workspace, coarse_aperiodicity);
 
   // Revision of the result based on the F0
   for (int i = 0; i < number_of_aperiodicities; ++i)
     coarse_aperiodicity[i] = MyMinDouble(0.0,
       coarse_aperiodicity[i] + (current_f0 - 100) / 50.0);
-
-  delete[] static_centroid;
-  delete[] smoothed_power_spectrum;
-  delete[] static_group_delay;
 }
 
 static void InitializeAperiodicity(int f0_length, int fft_size,
@@ -337,71 +375,249 @@ static void GetAperiodicity(const double *coarse_frequency_axis,
     aperiodicity[i] = pow(10.0, aperiodicity[i] / 20.0);
 }
 
-}  // namespace
-
-void D4C(const double *x, int x_length, int fs,
-    const double *temporal_positions, const double *f0, int f0_length,
-    int fft_size, const D4COption *option, double **aperiodicity) {
-  RandnState randn_state = {};
-  randn_reseed(&randn_state);
-
-  InitializeAperiodicity(f0_length, fft_size, aperiodicity);
-
-  int fft_size_d4c = static_cast<int>(pow(2.0, 1.0 +
+//-----------------------------------------------------------------------------
+// D4CTables holds what every frame at one sampling frequency and FFT size
+// shares: the FFT lengths, the band window and the frequency axes.
+//-----------------------------------------------------------------------------
+typedef struct {
+  int fs;
+  int fft_size;
+  int fft_size_d4c;
+  int fft_size_love_train;
+  int number_of_aperiodicities;
+  int window_length;
+  double *window;
+  double *coarse_frequency_axis;
+  double *frequency_axis;
+} D4CTables;
+
+static void InitializeD4CTables(int fs, int fft_size, WorldLane *lane,
+    D4CTables *tables) {
+  tables->fs = fs;
+  tables->fft_size = fft_size;
+  tables->fft_size_d4c = static_cast<int>(pow(2.0, 1.0 +
     static_cast<int>(log(4.0 * fs / world::kFloorF0D4C + 1) /
       world::kLog2)));
+  tables->fft_size_love_train = GetFFTSizeForLoveTrain(fs);
 
-  ForwardRealFFT forward_real_fft = {0};
-  InitializeForwardRealFFT(fft_size_d4c, &forward_real_fft);
-
-  int number_of_aperiodicities =
+  tables->number_of_aperiodicities =
     static_cast<int>(MyMinDouble(world::kUpperLimit, fs / 2.0 -
       world::kFrequencyInterval) / world::kFrequencyInterval);
   // Since the window function is common in D4CGeneralBody(),
   // it is designed here to speed up.
-  int window_length =
-    static_cast<int>(world::kFrequencyInterval * fft_size_d4c / fs) * 2 + 1;
-  double *window =  new double[window_length];
-  NuttallWindow(window_length, window);
-
-  // D4C Love Train (Aperiodicity of 0 Hz is given by the different algorithm)
-  double *aperiodicity0 = new double[f0_length];
-  D4CLoveTrain(x, fs, x_length, f0, f0_length, temporal_positions,
-      aperiodicity0, &randn_state);
+  tables->window_length = static_cast<int>(world::kFrequencyInterval *
+    tables->fft_size_d4c / fs) * 2 + 1;
+  tables->window = LaneDoubles(lane, tables->window_length);
+  NuttallWindow(tables->window_length, tables->window);
+
+  tables->coarse_frequency_axis =
+    LaneDoubles(lane, tables->number_of_aperiodicities + 2);
+  for (int i = 0; i <= tables->number_of_aperiodicities; ++i)
+    tables->coarse_frequency_axis[i] = i * world::kFrequencyInterval;
+  tables->coarse_frequency_axis[tables->number_of_aperiodicities + 1] =
+    fs / 2.0;
+
+  tables->frequency_axis = LaneDoubles(lane, fft_size / 2 + 1);
+  for (int i = 0; i <= fft_size / 2; ++i)
+    tables->frequency_axis[i] = static_cast<double>(i) * fs / fft_size;
+}
 
-  double *coarse_aperiodicity = new double[number_of_aperiodicities + 2];
-  coarse_aperiodicity[0] = -60.0;
-  coarse_aperiodicity[number_of_aperiodicities + 1] =
+//-----------------------------------------------------------------------------
+// D4CState holds the FFT buffers and scratch one task uses for a run of
+// blocks, all from its lane; aperiodicity0 has room for max_frames frames.
+//-----------------------------------------------------------------------------
+typedef struct {
+  ForwardRealFFT *forward_real_fft;
+  ForwardRealFFT *love_train_fft;
+  D4CWorkspace workspace;
+  double *aperiodicity0;
+  double *coarse_aperiodicity;
+} D4CState;
+
+static void InitializeD4CState(const D4CTables *tables, int max_frames,
+    WorldLane *lane, D4CState *state) {
+  state->forward_real_fft =
+    GetLaneForwardRealFFT(lane, tables->fft_size_d4c, 0);
+  state->love_train_fft =
+    GetLaneForwardRealFFT(lane, tables->fft_size_love_train, 1);
+
+  // Shared by D4CLoveTrain() and D4CGeneralBody(), so sized for both FFTs
+  InitializeD4CWorkspace(MyMaxInt(tables->fft_size_d4c,
+      tables->fft_size_love_train), lane, &state->workspace);
+
+  state->aperiodicity0 = LaneDoubles(lane, MyMaxInt(1, max_frames));
+  state->coarse_aperiodicity =
+    LaneDoubles(lane, tables->number_of_aperiodicities + 2);
+  state->coarse_aperiodicity[0] = -60.0;
+  state->coarse_aperiodicity[tables->number_of_aperiodicities + 1] =
     -world::kMySafeGuardMinimum;
-  double *coarse_frequency_axis = new double[number_of_aperiodicities + 2];
-  for (int i = 0; i <= number_of_aperiodicities; ++i)
-    coarse_frequency_axis[i] = i * world::kFrequencyInterval;
-  coarse_frequency_axis[number_of_aperiodicities + 1] = fs / 2.0;
+}
 
-  double *frequency_axis = new double[fft_size / 2 + 1];
-  for (int i = 0; i <= fft_size / 2; ++i)
-    frequency_axis[i] = static_cast<double>(i) * fs / fft_size;
+//-----------------------------------------------------------------------------
+// D4CFrames() estimates the aperiodicity of frames [begin, end) (at most
+// the state's max_frames) with the random stream of the block they form.
+//-----------------------------------------------------------------------------
+static void D4CFrames(const D4CTables *tables, const double *x, int x_length,
+    const double *temporal_positions, const double *f0, int f0_length,
+    int begin, int end, int stream, const D4COption *option,
+    D4CState *state, double **aperiodicity) {
+  RandnState randn_state = {};
+  randn_seed_stream(&randn_state, stream);
 
-  for (int i = 0; i < f0_length; ++i) {
-    if (f0[i] == 0 || aperiodicity0[i] <= option->threshold) continue;
-    D4CGeneralBody(x, x_length, fs, MyMaxDouble(world::kFloorF0D4C, f0[i]),
-        fft_size_d4c, temporal_positions[i], number_of_aperiodicities, window,
-        window_length, &forward_real_fft, &coarse_aperiodicity[1], &randn_state);
+  // D4C Love Train (Aperiodicity of 0 Hz is given by the different algorithm)
+  D4CLoveTrain(x, tables->fs, x_length, f0, f0_length, temporal_positions,
+      begin, end, state->aperiodicity0, state->love_train_fft,
+      &state->workspace, &randn_state);
+
+  for (int i = begin; i < end; ++i) {
+    if (f0[i] == 0 || state->aperiodicity0[i - begin] <= option->threshold)
+      continue;
+    D4CGeneralBody(x, x_length, tables->fs,
+        MyMaxDouble(world::kFloorF0D4C, f0[i]), tables->fft_size_d4c,
+        temporal_positions[i], tables->number_of_aperiodicities,
+        tables->window, tables->window_length, state->forward_real_fft,
+        &state->coarse_aperiodicity[1], &state->workspace, &randn_state);
 
     // Linear interpolation to convert the coarse aperiodicity into its
     // spectral representation.
-    GetAperiodicity(coarse_frequency_axis, coarse_aperiodicity,
-        number_of_aperiodicities, frequency_axis, fft_size, aperiodicity[i]);
+    GetAperiodicity(tables->coarse_frequency_axis, state->coarse_aperiodicity,
+        tables->number_of_aperiodicities, tables->frequency_axis,
+        tables->fft_size, aperiodicity[i]);
+  }
+}
+
+typedef struct {
+  const double *x;
+  int x_length;
+  const double *temporal_positions;
+  const double *f0;
+  int f0_length;
+  const D4COption *option;
+  double **aperiodicity;
+  int frames_per_block;
+  const D4CTables *tables;
+  WorldWorkspace *workspace;
+} D4CContext;
+
+//-----------------------------------------------------------------------------
+// D4CBlock() estimates the aperiodicity of one block of frames with its own
+// lane (FFT buffers and scratch) and random stream. Blocks write disjoint
+// rows of aperiodicity.
+//-----------------------------------------------------------------------------
+static void D4CBlock(void *context, int block) {
+  const D4CContext *c = static_cast<const D4CContext *>(context);
+  int begin = block * c->frames_per_block;
+  int end = MyMinInt(c->f0_length, begin + c->frames_per_block);
+
+  D4CState state;
+  InitializeD4CState(c->tables, end - begin,
+      StartWorldLane(c->workspace, block), &state);
+  D4CFrames(c->tables, c->x, c->x_length, c->temporal_positions, c->f0,
+      c->f0_length, begin, end, block, c->option, &state, c->aperiodicity);
+}
+
+typedef struct {
+  const WorldAnalysisBatch *batch;
+  const D4COption *option;
+  const D4CTables *tables;
+  const WorldBatchBlock *blocks;
+  int number_of_blocks;
+  int number_of_tasks;
+  WorldWorkspace *workspace;
+} D4CBatchContext;
+
+//-----------------------------------------------------------------------------
+// D4CBatchTask() estimates a run of batch blocks, possibly of several
+// segments, in one lane for all of them.
+//-----------------------------------------------------------------------------
+static void D4CBatchTask(void *context, int task) {
+  const D4CBatchContext *c = static_cast<const D4CBatchContext *>(context);
+  int first = static_cast<int>(static_cast<long long>(task) *
+    c->number_of_blocks / c->number_of_tasks);
+  int last = static_cast<int>(static_cast<long long>(task + 1) *
+    c->number_of_blocks / c->number_of_tasks);
+
+  int max_frames = 0;
+  for (int b = first; b < last; ++b)
+    max_frames = MyMaxInt(max_frames, c->blocks[b].end - c->blocks[b].begin);
+
+  D4CState state;
+  InitializeD4CState(c->tables, max_frames,
+      StartWorldLane(c->workspace, task), &state);
+
+  const WorldAnalysisBatch *batch = c->batch;
+  for (int b = first; b < last; ++b) {
+    const WorldBatchBlock *block = &c->blocks[b];
+    int segment = block->segment;
+    double **aperiodicity = batch->output[segment];
+    for (int i = block->begin; i < block->end; ++i)
+      for (int j = 0; j <= c->tables->fft_size / 2; ++j)
+        aperiodicity[i][j] = 1.0 - world::kMySafeGuardMinimum;
+    D4CFrames(c->tables, batch->x[segment], batch->x_length[segment],
+        batch->temporal_positions[segment], batch->f0[segment],
+        batch->f0_length[segment], block->begin, block->end, block->stream,
+        c->option, &state, aperiodicity);
+  }
+}
+
+}  // namespace
+
+void D4C(const double *x, int x_length, int fs,
+    const double *temporal_positions, const double *f0, int f0_length,
+    int fft_size, const D4COption *option, double **aperiodicity) {
+  InitializeAperiodicity(f0_length, fft_size, aperiodicity);
+
+  WorldWorkspace *workspace = AcquireWorldWorkspace(option->workspace);
+  D4CTables tables;
+  InitializeD4CTables(fs, fft_size, StartWorldMainLane(workspace), &tables);
+  D4CContext context = { x, x_length, temporal_positions, f0, f0_length,
+      option, aperiodicity, f0_length, &tables, workspace };
+
+  // Serial analysis is one block; with an executor the frames are split
+  // into fixed blocks, so the result does not depend on the thread count.
+  int number_of_blocks = 1;
+  if (option->executor != NULL) {
+    context.frames_per_block = world::kFramesPerParallelBlock;
+    number_of_blocks = (f0_length + context.frames_per_block - 1) /
+      context.frames_per_block;
   }
+  ReserveWorldLanes(workspace, number_of_blocks);
+  WorldParallelFor(option->executor, number_of_blocks, D4CBlock, &context);
+
+  ReleaseWorldWorkspace(option->workspace, workspace);
+}
 
-  DestroyForwardRealFFT(&forward_real_fft);
-  delete[] aperiodicity0;
-  delete[] coarse_frequency_axis;
-  delete[] coarse_aperiodicity;
-  delete[] window;
-  delete[] frequency_axis;
+void D4CBatch(const WorldAnalysisBatch *batch, int fs, int fft_size,
+    const D4COption *option) {
+  // Blocks as D4C() forms them for each segment; with an executor, runs of
+  // blocks are spread over at most kMaxBatchTasks tasks
+  int frames_per_block =
+    option->executor != NULL ? world::kFramesPerParallelBlock : 0;
+  int number_of_blocks = GetWorldBatchBlocks(batch, frames_per_block, NULL, 0);
+  if (number_of_blocks == 0) return;
+  WorldWorkspace *workspace = AcquireWorldWorkspace(option->workspace);
+  WorldLane *lane = StartWorldMainLane(workspace);
+  WorldBatchBlock *blocks = static_cast<WorldBatchBlock *>(
+      AllocateWorldScratch(lane, sizeof(WorldBatchBlock) * number_of_blocks));
+  GetWorldBatchBlocks(batch, frames_per_block, blocks, number_of_blocks);
+
+  D4CTables tables;
+  InitializeD4CTables(fs, fft_size, lane, &tables);
+  D4CBatchContext context = { batch, option, &tables, blocks,
+      number_of_blocks, 1, workspace };
+  if (option->executor != NULL)
+    context.number_of_tasks = MyMinInt(number_of_blocks, world::kMaxBatchTasks);
+  ReserveWorldLanes(workspace, context.number_of_tasks);
+  WorldParallelFor(option->executor, context.number_of_tasks, D4CBatchTask,
+      &context);
+
+  ReleaseWorldWorkspace(option->workspace, workspace);
 }
 
 void InitializeD4COption(D4COption *option) {
   option->threshold = world::kThreshold;
+  // Frames are analyzed one after another unless an executor is given.
+  option->executor = NULL;
+  // Scratch is allocated for each call unless a workspace is given.
+  option->workspace = NULL;
 }
@@ -59,8 +59,10 @@ static void DesignLowCutFilter(int N, int fft_size, double *low_cut_filter) {
 //-----------------------------------------------------------------------------
 static void GetSpectrumForEstimation(const double *x, int x_length,
     int y_length, double actual_fs, int fft_size, int decimation_ratio,
-    fft_complex *y_spectrum) {
-  double *y = new double[fft_size];
+    WorldLane *lane, fft_complex *y_spectrum) {
+  const ForwardRealFFT *forward_real_fft =
+    GetLaneForwardRealFFT(lane, fft_size, 0);
+  double *y = forward_real_fft->waveform;
 
   // Initialization
   for (int i = 0; i < fft_size; ++i) y[i] = 0.0;
@@ -78,17 +80,18 @@ static void GetSpectrumForEstimation(const double *x, int x_length,
   for (int i = 0; i < y_length; ++i) y[i] -= mean_y;
   for (int i = y_length; i < fft_size; ++i) y[i] = 0.0;
 
-  fft_plan forwardFFT =
-    fft_plan_dft_r2c_1d(fft_size, y, y_spectrum, FFT_ESTIMATE);
-  fft_execute(forwardFFT);
+  fft_execute(forward_real_fft->forward_fft);
+  for (int i = 0; i <= fft_size / 2; ++i) {
+    y_spectrum[i][0] = forward_real_fft->spectrum[i][0];
+    y_spectrum[i][1] = forward_real_fft->spectrum[i][1];
+  }
 
   // Low cut filtering (from 0.1.4). Cut off frequency is 50.0 Hz.
   int cutoff_in_sample = matlab_round(actual_fs / world::kCutOff);
   DesignLowCutFilter(cutoff_in_sample * 2 + 1, fft_size, y);
 
-  fft_complex *filter_spectrum = new fft_complex[fft_size];
-  forwardFFT.c_out = filter_spectrum;
-  fft_execute(forwardFFT);
+  fft_complex *filter_spectrum = forward_real_fft->spectrum;
+  fft_execute(forward_real_fft->forward_fft);
 
   double tmp = 0;
   for (int i = 0; i <= fft_size / 2; ++i) {
@@ -99,10 +102,6 @@ static void GetSpectrumForEstimation(const double *x, int x_length,
       y_spectrum[i][1] * filter_spectrum[i][0];
     y_spectrum[i][0] = tmp;
   }
-
-  fft_destroy_plan(forwardFFT);
-  delete[] y;
-  delete[] filter_spectrum;
 }
 
 //-----------------------------------------------------------------------------
@@ -130,8 +129,9 @@ static void GetBestF0Contour(int f0_length,
 // This function eliminates the unnatural change of f0 based on allowed_range.
 //-----------------------------------------------------------------------------
 static void FixStep1(const double *best_f0_contour, int f0_length,
-    int voice_range_minimum, double allowed_range, double *f0_step1) {
-  double *f0_base = new double[f0_length];
+    int voice_range_minimum, double allowed_range, WorldLane *lane,
+    double *f0_step1) {
+  double *f0_base = LaneDoubles(lane, f0_length);
   // Initialization
   for (int i = 0; i < voice_range_minimum; ++i) f0_base[i] = 0.0;
   for (int i = voice_range_minimum; i < f0_length - voice_range_minimum; ++i)
@@ -145,8 +145,6 @@ static void FixStep1(const double *best_f0_contour, int f0_length,
     f0_step1[i] = fabs((f0_base[i] - f0_base[i - 1]) /
     (world::kMySafeGuardMinimum + f0_base[i])) <
     allowed_range ? f0_base[i] : 0.0;
-
-  delete[] f0_base;
 }
 
 //-----------------------------------------------------------------------------
@@ -259,53 +257,52 @@ static void FixStep4(const double *f0_step3, int f0_length,
 static void FixF0Contour(double frame_period, int number_of_candidates,
     int fs, const double * const * f0_candidates,
     const double *best_f0_contour, int f0_length, double f0_floor,
-    double allowed_range, double *fixed_f0_contour) {
+    double allowed_range, WorldLane *lane, double *fixed_f0_contour) {
   int voice_range_minimum =
     static_cast<int>(0.5 + 1000.0 / frame_period / f0_floor) * 2 + 1;
 
   if (f0_length <= voice_range_minimum) return;
 
-  double *f0_tmp1 = new double[f0_length];
-  double *f0_tmp2 = new double[f0_length];
+  double *f0_tmp1 = LaneDoubles(lane, f0_length);
+  double *f0_tmp2 = LaneDoubles(lane, f0_length);
 
   FixStep1(best_f0_contour, f0_length, voice_range_minimum,
-      allowed_range, f0_tmp1);
+      allowed_range, lane, f0_tmp1);
   FixStep2(f0_tmp1, f0_length, voice_range_minimum, f0_tmp2);
 
   int positive_count, negative_count;
-  int *positive_index = new int[f0_length];
-  int *negative_index = new int[f0_length];
+  int *positive_index = LaneInts(lane, f0_length);
+  int *negative_index = LaneInts(lane, f0_length);
   GetNumberOfVoicedSections(f0_tmp2, f0_length, positive_index,
       negative_index, &positive_count, &negative_count);
   FixStep3(f0_tmp2, f0_length, f0_candidates, number_of_candidates,
       allowed_range, negative_index, negative_count, f0_tmp1);
   FixStep4(f0_tmp1, f0_length, f0_candidates, number_of_candidates,
       allowed_range, positive_index, positive_count, fixed_f0_contour);
-
-  delete[] f0_tmp1;
-  delete[] f0_tmp2;
-  delete[] positive_index;
-  delete[] negative_index;
 }
 
 //-----------------------------------------------------------------------------
 // GetFilteredSignal() calculates the signal that is the convolution of the
-// input signal and low-pass filter.
+// input signal and low-pass filter, in the lane's FFT buffers; the result
+// (fft_size samples) stays valid until the lane's inverse FFT runs again.
 // This function is only used in RawEventByDio()
 //-----------------------------------------------------------------------------
-static void GetFilteredSignal(int half_average_length, int fft_size,
-    const fft_complex *y_spectrum, int y_length, double *filtered_signal) {
-  double *low_pass_filter = new double[fft_size];
+static double *GetFilteredSignal(int half_average_length, int fft_size,
+    const fft_complex *y_spectrum, int y_length, WorldLane *lane) {
+  const ForwardRealFFT *forward_real_fft =
+    GetLaneForwardRealFFT(lane, fft_size, 0);
+  const InverseRealFFT *inverse_real_fft =
+    GetLaneInverseRealFFT(lane, fft_size, 0);
+
+  double *low_pass_filter = forward_real_fft->waveform;
   // Nuttall window is used as a low-pass filter.
   // Cutoff frequency depends on the window length.
   NuttallWindow(half_average_length * 4, low_pass_filter);
   for (int i = half_average_length * 4; i < fft_size; ++i)
     low_pass_filter[i] = 0.0;
 
-  fft_complex *low_pass_filter_spectrum = new fft_complex[fft_size];
-  fft_plan forwardFFT = fft_plan_dft_r2c_1d(fft_size, low_pass_filter,
-      low_pass_filter_spectrum, FFT_ESTIMATE);
-  fft_execute(forwardFFT);
+  fft_complex *low_pass_filter_spectrum = forward_real_fft->spectrum;
+  fft_execute(forward_real_fft->forward_fft);
 
   // Convolution
   double tmp = y_spectrum[0][0] * low_pass_filter_spectrum[0][0] -
@@ -327,19 +324,19 @@ static void GetFilteredSignal(int half_average_length, int fft_size,
       low_pass_filter_spectrum[i][1];
   }
 
-  fft_plan inverseFFT = fft_plan_dft_c2r_1d(fft_size,
-    low_pass_filter_spectrum, filtered_signal, FFT_ESTIMATE);
-  fft_execute(inverseFFT);
+  // The inverse FFT reads the lower half
+  for (int i = 0; i <= fft_size / 2; ++i) {
+    inverse_real_fft->spectrum[i][0] = low_pass_filter_spectrum[i][0];
+    inverse_real_fft->spectrum[i][1] = low_pass_filter_spectrum[i][1];
+  }
+  fft_execute(inverse_real_fft->inverse_fft);
 
   // Compensation of the delay.
+  double *filtered_signal = inverse_real_fft->waveform;
   int index_bias = half_average_length * 2;
   for (int i = 0; i < y_length; ++i)
     filtered_signal[i] = filtered_signal[i + index_bias];
-
-  fft_destroy_plan(inverseFFT);
-  fft_destroy_plan(forwardFFT);
-  delete[] low_pass_filter_spectrum;
-  delete[] low_pass_filter;
+  return filtered_signal;
 }
 
 //-----------------------------------------------------------------------------
@@ -356,40 +353,24 @@ static inline int CheckEvent(int x) {
 //-----------------------------------------------------------------------------
 static int ZeroCrossingEngine(const double *filtered_signal, int y_length,
     double fs, double *interval_locations, double *intervals) {
-  int *negative_going_points = new int[y_length];
-
-  for (int i = 0; i < y_length - 1; ++i)
-    negative_going_points[i] =
-      0.0 < filtered_signal[i] && filtered_signal[i + 1] <= 0.0 ? i + 1 : 0;
-  negative_going_points[y_length - 1] = 0;
-
-  int *edges = new int[y_length];
+  // Each crossing is refined and paired with the previous one as it is
+  // found, so no edge arrays are needed
   int count = 0;
-  for (int i = 0; i < y_length; ++i)
-    if (negative_going_points[i] > 0)
-      edges[count++] = negative_going_points[i];
-
-  if (count < 2) {
-    delete[] edges;
-    delete[] negative_going_points;
-    return 0;
-  }
-
-  double *fine_edges = new double[count];
-  for (int i = 0; i < count; ++i)
-    fine_edges[i] =
-      edges[i] - filtered_signal[edges[i] - 1] /
-      (filtered_signal[edges[i]] - filtered_signal[edges[i] - 1]);
-
-  for (int i = 0; i < count - 1; ++i) {
-    intervals[i] = fs / (fine_edges[i + 1] - fine_edges[i]);
-    interval_locations[i] = (fine_edges[i] + fine_edges[i + 1]) / 2.0 / fs;
+  double previous_edge = 0.0;
+  for (int i = 0; i < y_length - 1; ++i) {
+    if (!(0.0 < filtered_signal[i] && filtered_signal[i + 1] <= 0.0))
+      continue;
+    int edge = i + 1;
+    double fine_edge = edge - filtered_signal[edge - 1] /
+      (filtered_signal[edge] - filtered_signal[edge - 1]);
+    if (count > 0) {
+      intervals[count - 1] = fs / (fine_edge - previous_edge);
+      interval_locations[count - 1] = (previous_edge + fine_edge) / 2.0 / fs;
+    }
+    previous_edge = fine_edge;
+    ++count;
   }
-
-  delete[] fine_edges;
-  delete[] edges;
-  delete[] negative_going_points;
-  return count - 1;
+  return count < 2 ? 0 : count - 1;
 }
 
 //-----------------------------------------------------------------------------
@@ -400,17 +381,19 @@ static int ZeroCrossingEngine(const double *filtered_signal, int y_length,
 // the differential of waveform.
 //-----------------------------------------------------------------------------
 static void GetFourZeroCrossingIntervals(double *filtered_signal, int y_length,
-    double actual_fs, ZeroCrossings *zero_crossings) {
+    double actual_fs, WorldLane *lane, ZeroCrossings *zero_crossings) {
   // x_length / 4 (old version) is fixed at 2013/07/14
+  // All eight arrays share one block of the lane's scratch
   const int kMaximumNumber = y_length;
-  zero_crossings->negative_interval_locations = new double[kMaximumNumber];
-  zero_crossings->positive_interval_locations = new double[kMaximumNumber];
-  zero_crossings->peak_interval_locations = new double[kMaximumNumber];
-  zero_crossings->dip_interval_locations = new double[kMaximumNumber];
-  zero_crossings->negative_intervals = new double[kMaximumNumber];
-  zero_crossings->positive_intervals = new double[kMaximumNumber];
-  zero_crossings->peak_intervals = new double[kMaximumNumber];
-  zero_crossings->dip_intervals = new double[kMaximumNumber];
+  double *buffer = LaneDoubles(lane, kMaximumNumber * 8);
+  zero_crossings->negative_interval_locations = buffer;
+  zero_crossings->positive_interval_locations = buffer + kMaximumNumber;
+  zero_crossings->peak_interval_locations = buffer + kMaximumNumber * 2;
+  zero_crossings->dip_interval_locations = buffer + kMaximumNumber * 3;
+  zero_crossings->negative_intervals = buffer + kMaximumNumber * 4;
+  zero_crossings->positive_intervals = buffer + kMaximumNumber * 5;
+  zero_crossings->peak_intervals = buffer + kMaximumNumber * 6;
+  zero_crossings->dip_intervals = buffer + kMaximumNumber * 7;
 
   zero_crossings->number_of_negatives = ZeroCrossingEngine(filtered_signal,
       y_length, actual_fs, zero_crossings->negative_interval_locations,
@@ -470,7 +453,7 @@ static void GetF0CandidateContourSub(
 //-----------------------------------------------------------------------------
 static void GetF0CandidateContour(const ZeroCrossings *zero_crossings,
     double boundary_f0, double f0_floor, double f0_ceil,
-    const double *temporal_positions, int f0_length,
+    const double *temporal_positions, int f0_length, WorldLane *lane,
     double *f0_candidate, double *f0_score) {
   if (0 == CheckEvent(zero_crossings->number_of_negatives - 2) *
       CheckEvent(zero_crossings->number_of_positives - 2) *
@@ -484,8 +467,9 @@ static void GetF0CandidateContour(const ZeroCrossings *zero_crossings,
   }
 
   double *interpolated_f0_set[4];
-  for (int i = 0; i < 4; ++i)
-    interpolated_f0_set[i] = new double[f0_length];
+  interpolated_f0_set[0] = LaneDoubles(lane, f0_length * 4);
+  for (int i = 1; i < 4; ++i)
+    interpolated_f0_set[i] = interpolated_f0_set[0] + f0_length * i;
 
   interp1(zero_crossings->negative_interval_locations,
       zero_crossings->negative_intervals,
@@ -504,21 +488,6 @@ static void GetF0CandidateContour(const ZeroCrossings *zero_crossings,
 
   GetF0CandidateContourSub(interpolated_f0_set, f0_length, f0_floor,
       f0_ceil, boundary_f0, f0_candidate, f0_score);
-  for (int i = 0; i < 4; ++i) delete[] interpolated_f0_set[i];
-}
-
-//-----------------------------------------------------------------------------
-// DestroyZeroCrossings() frees the memory of array in the struct
-//-----------------------------------------------------------------------------
-static void DestroyZeroCrossings(ZeroCrossings *zero_crossings) {
-  delete[] zero_crossings->negative_interval_locations;
-  delete[] zero_crossings->positive_interval_locations;
-  delete[] zero_crossings->peak_interval_locations;
-  delete[] zero_crossings->dip_interval_locations;
-  delete[] zero_crossings->negative_intervals;
-  delete[] zero_crossings->positive_intervals;
-  delete[] zero_crossings->peak_intervals;
-  delete[] zero_crossings->dip_intervals;
 }
 
 //-----------------------------------------------------------------------------
@@ -527,20 +496,58 @@ static void DestroyZeroCrossings(ZeroCrossings *zero_crossings) {
 static void GetF0CandidateFromRawEvent(double boundary_f0, double fs,
     const fft_complex *y_spectrum, int y_length, int fft_size, double f0_floor,
     double f0_ceil, const double *temporal_positions, int f0_length,
-    double *f0_score, double *f0_candidate) {
-  double *filtered_signal = new double[fft_size];
-  GetFilteredSignal(matlab_round(fs / boundary_f0 / 2.0), fft_size, y_spectrum,
-      y_length, filtered_signal);
+    WorldLane *lane, double *f0_score, double *f0_candidate) {
+  double *filtered_signal = GetFilteredSignal(
+      matlab_round(fs / boundary_f0 / 2.0), fft_size, y_spectrum, y_length,
+      lane);
 
   ZeroCrossings zero_crossings = {0};
-  GetFourZeroCrossingIntervals(filtered_signal, y_length, fs,
+  GetFourZeroCrossingIntervals(filtered_signal, y_length, fs, lane,
       &zero_crossings);
 
   GetF0CandidateContour(&zero_crossings, boundary_f0, f0_floor, f0_ceil,
-      temporal_positions, f0_length, f0_candidate, f0_score);
+      temporal_positions, f0_length, lane, f0_candidate, f0_score);
+}
+
+//-----------------------------------------------------------------------------
+// GetF0CandidatesAndScores() calculates all f0 candidates and their scores.
+//-----------------------------------------------------------------------------
+typedef struct {
+  const double *boundary_f0_list;
+  double actual_fs;
+  int y_length;
+  const double *temporal_positions;
+  int f0_length;
+  const fft_complex *y_spectrum;
+  int fft_size;
+  double f0_floor;
+  double f0_ceil;
+  double **raw_f0_candidates;
+  double **raw_f0_scores;
+  WorldWorkspace *workspace;
+  int parallel;
+} BandContext;
+
+//-----------------------------------------------------------------------------
+// GetF0CandidatesForBand() calculates the candidates of one band. Bands only
+// read the shared spectrum, so they can run on different threads (each in
+// its own lane; serial bands take turns in one).
+//-----------------------------------------------------------------------------
+static void GetF0CandidatesForBand(void *context, int i) {
+  const BandContext *band = static_cast<const BandContext *>(context);
+  double *f0_candidate = band->raw_f0_candidates[i];
+  double *f0_score = band->raw_f0_scores[i];
+  WorldLane *lane = StartWorldLane(band->workspace, band->parallel ? i : 0);
 
-  DestroyZeroCrossings(&zero_crossings);
-  delete[] filtered_signal;
+  // Calculation of the acoustics events (zero-crossing)
+  GetF0CandidateFromRawEvent(band->boundary_f0_list[i], band->actual_fs,
+      band->y_spectrum, band->y_length, band->fft_size, band->f0_floor,
+      band->f0_ceil, band->temporal_positions, band->f0_length, lane,
+      f0_score, f0_candidate);
+  for (int j = 0; j < band->f0_length; ++j) {
+    // A way to avoid zero division
+    f0_score[j] /= f0_candidate[j] + world::kMySafeGuardMinimum;
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -550,25 +557,14 @@ static void GetF0CandidatesAndScores(const double *boundary_f0_list,
     int number_of_bands, double actual_fs, int y_length,
     const double *temporal_positions, int f0_length,
     const fft_complex *y_spectrum, int fft_size, double f0_floor,
-    double f0_ceil, double **raw_f0_candidates, double **raw_f0_scores) {
-  double *f0_candidate = new double[f0_length];
-  double *f0_score = new double[f0_length];
-
-  // Calculation of the acoustics events (zero-crossing)
-  for (int i = 0; i < number_of_bands; ++i) {
-    GetF0CandidateFromRawEvent(boundary_f0_list[i], actual_fs, y_spectrum,
-        y_length, fft_size, f0_floor, f0_ceil, temporal_positions, f0_length,
-        f0_score, f0_candidate);
-    for (int j = 0; j < f0_length; ++j) {
-      // A way to avoid zero division
-      raw_f0_scores[i][j] = f0_score[j] /
-        (f0_candidate[j] + world::kMySafeGuardMinimum);
-      raw_f0_candidates[i][j] = f0_candidate[j];
-    }
-  }
-
-  delete[] f0_candidate;
-  delete[] f0_score;
+    double f0_ceil, const WorldExecutor *executor, WorldWorkspace *workspace,
+    double **raw_f0_candidates, double **raw_f0_scores) {
+  int parallel = WorldRunsInParallel(executor, number_of_bands);
+  BandContext band = { boundary_f0_list, actual_fs, y_length,
+      temporal_positions, f0_length, y_spectrum, fft_size, f0_floor, f0_ceil,
+      raw_f0_candidates, raw_f0_scores, workspace, parallel };
+  ReserveWorldLanes(workspace, parallel ? number_of_bands : 1);
+  WorldParallelFor(executor, number_of_bands, GetF0CandidatesForBand, &band);
 }
 
 //-----------------------------------------------------------------------------
@@ -578,10 +574,12 @@ static void GetF0CandidatesAndScores(const double *boundary_f0_list,
 static void DioGeneralBody(const double *x, int x_length, int fs,
     double frame_period, double f0_floor, double f0_ceil,
     double channels_in_octave, int speed, double allowed_range,
+    const WorldExecutor *executor, WorldWorkspace *workspace,
     double *temporal_positions, double *f0) {
+  WorldLane *lane = StartWorldMainLane(workspace);
   int number_of_bands = 1 + static_cast<int>(log(f0_ceil / f0_floor) /
     world::kLog2 * channels_in_octave);
-  double *boundary_f0_list = new double[number_of_bands];
+  double *boundary_f0_list = LaneDoubles(lane, number_of_bands);
   for (int i = 0; i < number_of_bands; ++i)
     boundary_f0_list[i] = f0_floor * pow(2.0, (i + 1) / channels_in_octave);
 
@@ -594,16 +592,20 @@ static void DioGeneralBody(const double *x, int x_length, int fs,
       (4 * static_cast<int>(1.0 + actual_fs / boundary_f0_list[0] / 2.0)));
 
   // Calculation of the spectrum used for the f0 estimation
-  fft_complex *y_spectrum = new fft_complex[fft_size];
+  fft_complex *y_spectrum = LaneComplex(lane, fft_size);
   GetSpectrumForEstimation(x, x_length, y_length, actual_fs, fft_size,
-      decimation_ratio, y_spectrum);
+      decimation_ratio, lane, y_spectrum);
 
-  double **f0_candidates = new double *[number_of_bands];
-  double **f0_scores = new double *[number_of_bands];
+  double **f0_candidates = static_cast<double **>(
+      AllocateWorldScratch(lane, sizeof(double *) * number_of_bands));
+  double **f0_scores = static_cast<double **>(
+      AllocateWorldScratch(lane, sizeof(double *) * number_of_bands));
   int f0_length = GetSamplesForDIO(fs, x_length, frame_period);
-  for (int i = 0; i < number_of_bands; ++i) {
-    f0_candidates[i] = new double[f0_length];
-    f0_scores[i] = new double[f0_length];
+  f0_candidates[0] = LaneDoubles(lane, number_of_bands * f0_length);
+  f0_scores[0] = LaneDoubles(lane, number_of_bands * f0_length);
+  for (int i = 1; i < number_of_bands; ++i) {
+    f0_candidates[i] = f0_candidates[0] + i * f0_length;
+    f0_scores[i] = f0_scores[0] + i * f0_length;
   }
 
   for (int i = 0; i < f0_length; ++i)
@@ -611,27 +613,18 @@ static void DioGeneralBody(const double *x, int x_length, int fs,
 
   GetF0CandidatesAndScores(boundary_f0_list, number_of_bands,
       actual_fs, y_length, temporal_positions, f0_length, y_spectrum,
-      fft_size, f0_floor, f0_ceil, f0_candidates, f0_scores);
+      fft_size, f0_floor, f0_ceil, executor, workspace, f0_candidates,
+      f0_scores);
 
   // Selection of the best value based on fundamental-ness.
   // This function is related with SortCandidates() in MATLAB.
-  double *best_f0_contour = new double[f0_length];
+  double *best_f0_contour = LaneDoubles(lane, f0_length);
   GetBestF0Contour(f0_length, f0_candidates, f0_scores,
       number_of_bands, best_f0_contour);
 
   // Postprocessing to find the best f0-contour.
   FixF0Contour(frame_period, number_of_bands, fs, f0_candidates,
-      best_f0_contour, f0_length, f0_floor, allowed_range, f0);
-
-  delete[] best_f0_contour;
-  delete[] y_spectrum;
-  for (int i = 0; i < number_of_bands; ++i) {
-    delete[] f0_scores[i];
-    delete[] f0_candidates[i];
-  }
-  delete[] f0_scores;
-  delete[] f0_candidates;
-  delete[] boundary_f0_list;
+      best_f0_contour, f0_length, f0_floor, allowed_range, lane, f0);
 }
 
 }  // namespace
@@ -642,9 +635,12 @@ int GetSamplesForDIO(int fs, int x_length, double frame_period) {
 
 void Dio(const double *x, int x_length, int fs, const DioOption *option,
     double *temporal_positions, double *f0) {
+  WorldWorkspace *workspace = AcquireWorldWorkspace(option->workspace);
   DioGeneralBody(x, x_length, fs, option->frame_period, option->f0_floor,
       option->f0_ceil, option->channels_in_octave, option->speed,
-      option->allowed_range, temporal_positions, f0);
+      option->allowed_range, option->executor, workspace, temporal_positions,
+      f0);
+  ReleaseWorldWorkspace(option->workspace, workspace);
 }
 
 void InitializeDioOption(DioOption *option) {
@@ -663,4 +659,9 @@ void InitializeDioOption(DioOption *option) {
   // The most strict value is 0, and there is no upper limit.
   // On the other hand, I think that the value from 0.02 to 0.2 is reasonable.
   option->allowed_range = 0.1;
+
+  // Bands are analyzed one after another unless an executor is given.
+  option->executor = NULL;
+  // Scratch is allocated for each call unless a workspace is given.
+  option->workspace = NULL;
 }
@@ -13,16 +13,154 @@
 // FFTW:
 //   (English) http://www.fftw.org/
 // 2012/08/24 by M. Morise
+//
+// Building with WORLD_FFT_USE_FFTW routes the wrappers to FFTW instead of
+// the Ooura FFT (selected by the FT_WORLD_FFT_BACKEND CMake option).
 //-----------------------------------------------------------------------------
 #include "world/fft.h"
 
 #include <math.h>
 #include <stdlib.h>
 
+#include <mutex>
+
+#if defined(WORLD_FFT_USE_FFTW)
+#include <fftw3.h>
+#endif
+
 void cdft(int n, int isgn, double *a, int *ip, double *w);
 void rdft(int n, int isgn, double *a, int *ip, double *w);
+void makewt(int nw, int *ip, double *w);
+void makect(int nc, int *ip, double *c);
+
+#if defined(WORLD_FFT_USE_FFTW)
+namespace {
+//-----------------------------------------------------------------------------
+// FFTW's planner is not thread-safe, so plans are created and destroyed
+// under one lock. fftw_execute() on distinct plans may run concurrently.
+//-----------------------------------------------------------------------------
+static std::mutex &GetPlannerMutex() {
+  static std::mutex planner_mutex;
+  return planner_mutex;
+}
+
+}  // namespace
+
+fft_plan fft_plan_dft_1d(int n, fft_complex *in, fft_complex *out, int sign,
+    unsigned int flags) {
+  fft_plan output = {0};
+  output.n = n;
+  output.in = NULL;
+  output.c_in = in;
+  output.out = NULL;
+  output.c_out = out;
+  output.sign = sign;
+  output.flags = flags;
+
+  // The Ooura wrapper returns the conjugate of the transform with the
+  // opposite sign; fft_execute() conjugates the FFTW result to match.
+  std::lock_guard<std::mutex> lock(GetPlannerMutex());
+  output.backend = fftw_plan_dft_1d(n, reinterpret_cast<fftw_complex *>(in),
+      reinterpret_cast<fftw_complex *>(out),
+      sign == FFT_FORWARD ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE);
+  return output;
+}
+
+fft_plan fft_plan_dft_c2r_1d(int n, fft_complex *in, double *out,
+    unsigned int flags) {
+  fft_plan output = {0};
+  output.n = n;
+  output.in = NULL;
+  output.c_in = in;
+  output.out = out;
+  output.c_out = NULL;
+  output.sign = FFT_BACKWARD;
+  output.flags = flags;
+  // c2r overwrites its input, so it runs on a copy of the spectrum
+  output.input = new double[(n / 2 + 1) * 2];
+
+  std::lock_guard<std::mutex> lock(GetPlannerMutex());
+  output.backend = fftw_plan_dft_c2r_1d(n,
+      reinterpret_cast<fftw_complex *>(output.input), out, FFTW_ESTIMATE);
+  return output;
+}
 
+fft_plan fft_plan_dft_r2c_1d(int n, double *in, fft_complex *out,
+    unsigned int flags) {
+  fft_plan output = {0};
+  output.n = n;
+  output.in = in;
+  output.c_in = NULL;
+  output.out = NULL;
+  output.c_out = out;
+  output.sign = FFT_FORWARD;
+  output.flags = flags;
+
+  std::lock_guard<std::mutex> lock(GetPlannerMutex());
+  output.backend = fftw_plan_dft_r2c_1d(n, in,
+      reinterpret_cast<fftw_complex *>(out), FFTW_ESTIMATE);
+  return output;
+}
+
+void fft_execute(fft_plan p) {
+  if (p.c_in != NULL && p.out != NULL) {  // c2r
+    for (int i = 0; i <= p.n / 2; ++i) {
+      p.input[i * 2] = p.c_in[i][0];
+      p.input[i * 2 + 1] = p.c_in[i][1];
+    }
+  }
+  fftw_execute(static_cast<fftw_plan>(p.backend));
+  if (p.c_in != NULL && p.c_out != NULL) {  // c2c
+    for (int i = 0; i < p.n; ++i) p.c_out[i][1] = -p.c_out[i][1];
+  }
+}
+
+void fft_destroy_plan(fft_plan p) {
+  std::lock_guard<std::mutex> lock(GetPlannerMutex());
+  if (p.backend != NULL) fftw_destroy_plan(static_cast<fftw_plan>(p.backend));
+  delete[] p.input;
+}
+
+#else  // Ooura FFT
 namespace {
+//-----------------------------------------------------------------------------
+// Twiddle tables only depend on the size and type of the transform and are
+// read-only once built, so all plans of one size share a single copy. The
+// tables are built on first use and kept for the lifetime of the process.
+//-----------------------------------------------------------------------------
+typedef struct FFTTables {
+  int n;
+  int is_complex;
+  int *ip;
+  double *w;
+  struct FFTTables *next;
+} FFTTables;
+
+static const FFTTables *GetFFTTables(int n, int is_complex) {
+  static std::mutex tables_mutex;
+  static FFTTables *tables = NULL;
+
+  std::lock_guard<std::mutex> lock(tables_mutex);
+  for (FFTTables *t = tables; t != NULL; t = t->next)
+    if (t->n == n && t->is_complex == is_complex) return t;
+
+  FFTTables *t = new FFTTables;
+  t->n = n;
+  t->is_complex = is_complex;
+  t->ip = new int[n];
+  t->w = new double[n * 5 / 4];
+  t->ip[0] = 0;
+  if (is_complex) {
+    makewt(n >> 1, t->ip, t->w);
+  } else {
+    makewt(n >> 2, t->ip, t->w);
+    makect(n >> 2, t->ip, t->w + (n >> 2));
+  }
+  t->next = tables;
+  tables = t;
+  return t;
+}
+
 static void BackwardFFT(fft_plan p) {
   if (p.c_out == NULL) {  // c2r
     p.input[0] = p.c_in[0][0];
@@ -75,8 +213,6 @@ static void ForwardFFT(fft_plan p) {
 
 fft_plan fft_plan_dft_1d(int n, fft_complex *in, fft_complex *out, int sign,
     unsigned int flags) {
-  void makewt(int nw, int *ip, double *w);
-
   fft_plan output = {0};
   output.n = n;
   output.in = NULL;
@@ -86,19 +222,15 @@ fft_plan fft_plan_dft_1d(int n, fft_complex *in, fft_complex *out, int sign,
   output.sign = sign;
   output.flags = flags;
   output.input = new double[n * 2];
-  output.ip = new int[n];
-  output.w = new double[n * 5 / 4];
 
-  output.ip[0] = 0;
-  makewt(output.n >> 1, output.ip, output.w);
+  const FFTTables *tables = GetFFTTables(n, 1);
+  output.ip = tables->ip;
+  output.w = tables->w;
   return output;
 }
 
 fft_plan fft_plan_dft_c2r_1d(int n, fft_complex *in, double *out,
     unsigned int flags) {
-  void makewt(int nw, int *ip, double *w);
-  void makect(int nc, int *ip, double *c);
-
   fft_plan output = {0};
   output.n = n;
   output.in = NULL;
@@ -108,20 +240,15 @@ fft_plan fft_plan_dft_c2r_1d(int n, fft_complex *in, double *out,
   output.sign = FFT_BACKWARD;
   output.flags = flags;
   output.input = new double[n];
-  output.ip = new int[n];
-  output.w = new double[n * 5 / 4];
 
-  output.ip[0] = 0;
-  makewt(output.n >> 2, output.ip, output.w);
-  makect(output.n >> 2, output.ip, output.w + (output.n >> 2));
+  const FFTTables *tables = GetFFTTables(n, 0);
+  output.ip = tables->ip;
+  output.w = tables->w;
   return output;
 }
 
 fft_plan fft_plan_dft_r2c_1d(int n, double *in, fft_complex *out,
     unsigned int flags) {
-  void makewt(int nw, int *ip, double *w);
-  void makect(int nc, int *ip, double *c);
-
   fft_plan output = {0};
   output.n = n;
   output.in = in;
@@ -131,12 +258,10 @@ fft_plan fft_plan_dft_r2c_1d(int n, double *in, fft_complex *out,
   output.sign = FFT_FORWARD;
   output.flags = flags;
   output.input = new double[n];
-  output.ip = new int[n];
-  output.w = new double[n * 5 / 4];
 
-  output.ip[0] = 0;
-  makewt(output.n >> 2, output.ip, output.w);
-  makect(output.n >> 2, output.ip, output.w + (output.n >> 2));
+  const FFTTables *tables = GetFFTTables(n, 0);
+  output.ip = tables->ip;
+  output.w = tables->w;
   return output;
 }
 
@@ -156,11 +281,12 @@ void fft_destroy_plan(fft_plan p) {
   p.c_out = NULL;
   p.sign = 0;
   p.flags = 0;
+  // ip and w belong to the shared table cache
   delete[] p.input;
-  delete[] p.ip;
-  delete[] p.w;
 }
 
+#endif  // WORLD_FFT_USE_FFTW
+
 //-----------------------------------------------------------------------
 // The following functions are reffered by
 // http://www.kurims.kyoto-u.ac.jp/~ooura/index.html
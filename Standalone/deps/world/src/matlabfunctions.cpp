@@ -156,23 +156,21 @@ void histc(const double *x, int x_length, const double *edges,
 
 void interp1(const double *x, const double *y, int x_length, const double *xi,
     int xi_length, double *yi) {
-  double *h = new double[x_length - 1];
-  int *k = new int[xi_length];
-
-  for (int i = 0; i < x_length - 1; ++i) h[i] = x[i + 1] - x[i];
-  for (int i = 0; i < xi_length; ++i) {
-    k[i] = 0;
-  }
-
-  histc(x, x_length, xi, xi_length, k);
-
+  // histc() one point at a time (same bins), so no index array is needed
+  int count = 1;
+  bool below = true;
+  bool above = false;
   for (int i = 0; i < xi_length; ++i) {
-    double s = (xi[i] - x[k[i] - 1]) / h[k[i] - 1];
-    yi[i] = y[k[i] - 1] + s * (y[k[i]] - y[k[i] - 1]);
+    int k = 1;
+    if (!below || xi[i] >= x[0]) {
+      below = false;
+      while (!above && !(xi[i] < x[count]))
+        if (++count == x_length) above = true;
+      k = above ? x_length - 1 : count;
+    }
+    double s = (xi[i] - x[k - 1]) / (x[k] - x[k - 1]);
+    yi[i] = y[k - 1] + s * (y[k] - y[k - 1]);
   }
-  
-  delete[] k;
-  delete[] h;
 }
 
 void decimate(const double *x, int x_length, int r, double *y) {
@@ -213,25 +211,16 @@ void diff(const double *x, int x_length, double *y) {
 
 void interp1Q(double x, double shift, const double *y, int x_length,
     const double *xi, int xi_length, double *yi) {
-  double *xi_fraction = new double[xi_length];
-  double *delta_y = new double[x_length];
-  int *xi_base = new int[xi_length];
-
+  // Differences are taken per point instead of into a diff() array; the
+  // last sample's slope is 0 (bug was fixed at 2013/07/14 by M. Morise)
   double delta_x = shift;
   for (int i = 0; i < xi_length; ++i) {
-    xi_base[i] = static_cast<int>((xi[i] - x) / delta_x);
-    xi_fraction[i] = (xi[i] - x) / delta_x - xi_base[i];
+    int xi_base = static_cast<int>((xi[i] - x) / delta_x);
+    double xi_fraction = (xi[i] - x) / delta_x - xi_base;
+    double delta_y =
+      xi_base < x_length - 1 ? y[xi_base + 1] - y[xi_base] : 0.0;
+    yi[i] = y[xi_base] + delta_y * xi_fraction;
   }
-  diff(y, x_length, delta_y);
-  delta_y[x_length - 1] = 0.0;
-
-  for (int i = 0; i < xi_length; ++i)
-    yi[i] = y[xi_base[i]] + delta_y[xi_base[i]] * xi_fraction[i];
-
-  // Bug was fixed at 2013/07/14 by M. Morise
-  delete[] xi_fraction;
-  delete[] xi_base;
-  delete[] delta_y;
 }
 
 void randn_reseed(RandnState *state) {
@@ -241,6 +230,14 @@ void randn_reseed(RandnState *state) {
     state->g_randn_w = 88675123;
 }
 
+void randn_seed_stream(RandnState *state, int stream) {
+  randn_reseed(state);
+  if (stream == 0) return;
+  // Perturb one word (the state stays non-zero) and let the mix settle
+  state->g_randn_x ^= static_cast<uint32_t>(stream) * 0x9E3779B9u;
+  for (int i = 0; i < 8; ++i) randn(state);
+}
+
 double randn(RandnState *state) {
   uint32_t t;
   t = state->g_randn_x ^ (state->g_randn_x << 11);
@@ -334,17 +334,20 @@ static void GetDCRemover(int fft_size, double *dc_remover) {
   }
 }
 
-}  // namespace
-
-void Synthesis(const double *f0, int f0_length,
+//-----------------------------------------------------------------------------
+// SynthesisBody() is shared by Synthesis() and SynthesisFloat(). Only the
+// overlap-add into y uses the sample type; the responses stay in double.
+//-----------------------------------------------------------------------------
+template <typename T>
+static void SynthesisBody(const double *f0, int f0_length,
     const double * const *spectrogram, const double * const *aperiodicity,
-    int fft_size, double frame_period, int fs, int y_length, double *y) {
+    int fft_size, double frame_period, int fs, int y_length, T *y) {
   RandnState randn_state = {};
   randn_reseed(&randn_state);
 
   double *impulse_response = new double[fft_size];
 
-  for (int i = 0; i < y_length; ++i) y[i] = 0.0;
+  for (int i = 0; i < y_length; ++i) y[i] = 0;
 
   MinimumPhaseAnalysis minimum_phase = {0};
   InitializeMinimumPhaseAnalysis(fft_size, &minimum_phase);
@@ -381,7 +384,7 @@ void Synthesis(const double *f0, int f0_length,
     upper_limit = MyMinInt(fft_size, y_length - offset);
     for (int j = lower_limit; j < upper_limit; ++j) {
       index = j + offset;
-      y[index] += impulse_response[j];
+      y[index] += static_cast<T>(impulse_response[j]);
     }
   }
 
@@ -397,3 +400,19 @@ void Synthesis(const double *f0, int f0_length,
 
   delete[] impulse_response;
 }
+
+}  // namespace
+
+void Synthesis(const double *f0, int f0_length,
+    const double * const *spectrogram, const double * const *aperiodicity,
+    int fft_size, double frame_period, int fs, int y_length, double *y) {
+  SynthesisBody(f0, f0_length, spectrogram, aperiodicity, fft_size,
+      frame_period, fs, y_length, y);
+}
+
+void SynthesisFloat(const double *f0, int f0_length,
+    const double * const *spectrogram, const double * const *aperiodicity,
+    int fft_size, double frame_period, int fs, int y_length, float *y) {
+  SynthesisBody(f0, f0_length, spectrogram, aperiodicity, fft_size,
+      frame_period, fs, y_length, y);
+}
@@ -7,6 +7,8 @@
 #define WORLD_CHEAPTRICK_H_
 
 #include "world/macrodefinitions.h"
+#include "world/parallel.h"
+#include "world/workspace.h"
 
 WORLD_BEGIN_C_DECLS
 
@@ -17,6 +19,8 @@ typedef struct {
   double q1;
   double f0_floor;
   int fft_size;
+  const WorldExecutor *executor;  // Runs blocks of frames in parallel (NULL: serial)
+  WorldWorkspace *workspace;      // Keeps scratch between calls (NULL: per call)
 } CheapTrickOption;
 
 //-----------------------------------------------------------------------------
@@ -40,6 +44,19 @@ void CheapTrick(const double *x, int x_length, int fs,
     const CheapTrickOption *option, double **spectrogram);
 
 //-----------------------------------------------------------------------------
+// CheapTrickBatch() runs CheapTrick() over every segment of a batch (see
+// WorldAnalysisBatch), all at sampling frequency fs. Each segment's
+// spectrogram equals that of its own CheapTrick() call with the same
+// option; the batch shares FFT buffers between segments and, with an
+// executor, spreads the frames of all segments over its threads.
+//
+// Input:
+//   batch              : Segments to analyze (output: their spectrograms)
+//   fs                 : Sampling frequency
+//   option             : Struct to order the parameter for CheapTrick
+void CheapTrickBatch(const WorldAnalysisBatch *batch, int fs,
+    const CheapTrickOption *option);
+
 // InitializeCheapTrickOption allocates the memory to the struct and sets the
 // default parameters.
 //
@@ -6,8 +6,11 @@
 #ifndef WORLD_COMMON_H_
 #define WORLD_COMMON_H_
 
+#include <stddef.h>
+
 #include "world/fft.h"
 #include "world/macrodefinitions.h"
+#include "world/workspace.h"
 
 WORLD_BEGIN_C_DECLS
 
@@ -84,19 +87,32 @@ inline double MyMinDouble(double x, double y) {
 //-----------------------------------------------------------------------------
 // These functions are used in at least two different .cpp files
 
+//-----------------------------------------------------------------------------
+// SmoothingBuffer is the scratch of DCCorrection() and LinearSmoothing().
+// CheapTrick() and D4C() keep one per block, so frames reuse it; it grows
+// to the widest smoothing seen.
+//-----------------------------------------------------------------------------
+typedef struct {
+  double *buffer;
+  int size;
+} SmoothingBuffer;
+
+void InitializeSmoothingBuffer(SmoothingBuffer *smoothing);
+void DestroySmoothingBuffer(SmoothingBuffer *smoothing);
+
 //-----------------------------------------------------------------------------
 // DCCorrection interpolates the power under f0 Hz
 // and is used in CheapTrick() and D4C().
 //-----------------------------------------------------------------------------
 void DCCorrection(const double *input, double current_f0, int fs, int fft_size,
-    double *output);
+    SmoothingBuffer *smoothing, double *output);
 
 //-----------------------------------------------------------------------------
 // LinearSmoothing() carries out the spectral smoothing by rectangular window
 // whose length is width Hz and is used in CheapTrick() and D4C().
 //-----------------------------------------------------------------------------
 void LinearSmoothing(const double *input, double width, int fs, int fft_size,
-    double *output);
+    SmoothingBuffer *smoothing, double *output);
 
 //-----------------------------------------------------------------------------
 // NuttallWindow() calculates the coefficients of Nuttall window whose length
@@ -133,6 +149,70 @@ void InitializeMinimumPhaseAnalysis(int fft_size,
 void GetMinimumPhaseSpectrum(const MinimumPhaseAnalysis *minimum_phase);
 void DestroyMinimumPhaseAnalysis(MinimumPhaseAnalysis *minimum_phase);
 
+//-----------------------------------------------------------------------------
+// Lanes of a WorldWorkspace (see workspace.h)
+//-----------------------------------------------------------------------------
+// WorldScratch hands out arrays from one block that ResetWorldLane() empties
+// rather than frees. Arrays that do not fit are allocated on their own until
+// the next reset, which grows the block to what the last use needed.
+typedef struct WorldScratchChunk WorldScratchChunk;
+typedef struct {
+  char *block;
+  size_t capacity;
+  size_t used;                // Bytes handed out (may exceed capacity)
+  size_t peak;
+  WorldScratchChunk *chunks;  // Arrays that did not fit in block
+} WorldScratch;
+
+// WorldLane is what one task of a call works in: scratch arrays, smoothing
+// scratch and FFTs, all kept between calls
+typedef struct WorldFFTCache WorldFFTCache;
+typedef struct {
+  WorldScratch scratch;
+  SmoothingBuffer smoothing;
+  WorldFFTCache *ffts;
+} WorldLane;
+
+// AcquireWorldWorkspace() returns workspace, or a temporary one when it is
+// NULL; ReleaseWorldWorkspace() destroys the temporary one again.
+WorldWorkspace *AcquireWorldWorkspace(WorldWorkspace *workspace);
+void ReleaseWorldWorkspace(WorldWorkspace *workspace, WorldWorkspace *acquired);
+
+// The lane for a call's serial part, and for its task index (after
+// ReserveWorldLanes() has made room for count tasks). Both are returned
+// with their scratch emptied, so they must not be started twice at once.
+WorldLane *StartWorldMainLane(WorldWorkspace *workspace);
+void ReserveWorldLanes(WorldWorkspace *workspace, int count);
+WorldLane *StartWorldLane(WorldWorkspace *workspace, int index);
+
+// Scratch arrays, valid until the lane is started again. A mark taken
+// before a loop body can be released after it, so iterations reuse memory.
+void *AllocateWorldScratch(WorldLane *lane, size_t bytes);
+inline double *LaneDoubles(WorldLane *lane, int count) {
+  return static_cast<double *>(AllocateWorldScratch(lane,
+      sizeof(double) * count));
+}
+inline int *LaneInts(WorldLane *lane, int count) {
+  return static_cast<int *>(AllocateWorldScratch(lane, sizeof(int) * count));
+}
+inline fft_complex *LaneComplex(WorldLane *lane, int count) {
+  return static_cast<fft_complex *>(AllocateWorldScratch(lane,
+      sizeof(fft_complex) * count));
+}
+inline size_t MarkWorldScratch(const WorldLane *lane) {
+  return lane->scratch.used;
+}
+void ReleaseWorldScratch(WorldLane *lane, size_t mark);
+
+// FFTs of the lane, created on first use for each (fft_size, slot); slot
+// tells apart FFTs of one size that are used at the same time
+ForwardRealFFT *GetLaneForwardRealFFT(WorldLane *lane, int fft_size,
+    int slot);
+InverseRealFFT *GetLaneInverseRealFFT(WorldLane *lane, int fft_size,
+    int slot);
+MinimumPhaseAnalysis *GetLaneMinimumPhaseAnalysis(WorldLane *lane,
+    int fft_size, int slot);
+
 WORLD_END_C_DECLS
 
 #endif  // WORLD_COMMON_H_
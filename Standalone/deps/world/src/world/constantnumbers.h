@@ -47,6 +47,13 @@ namespace world {
   const double kFloorFrequency = 40.0;
   const double kCeilFrequency = 20000.0;
 
+  // for parallel analysis (CheapTrick, D4C): frames per task
+  const int kFramesPerParallelBlock = 8;
+
+  // for batch analysis: most tasks a batch is split into. Each task sets up
+  // its FFTs and scratch once for all of its blocks
+  const int kMaxBatchTasks = 64;
+
 }  // namespace world
 
 #endif  // WORLD_CONSTANT_NUMBERS_H_
@@ -7,6 +7,8 @@
 #define WORLD_D4C_H_
 
 #include "world/macrodefinitions.h"
+#include "world/parallel.h"
+#include "world/workspace.h"
 
 WORLD_BEGIN_C_DECLS
 
@@ -15,6 +17,8 @@ WORLD_BEGIN_C_DECLS
 //-----------------------------------------------------------------------------
 typedef struct {
   double threshold;
+  const WorldExecutor *executor;  // Runs blocks of frames in parallel (NULL: serial)
+  WorldWorkspace *workspace;      // Keeps scratch between calls (NULL: per call)
 } D4COption;
 
 //-----------------------------------------------------------------------------
@@ -36,6 +40,23 @@ void D4C(const double *x, int x_length, int fs,
     const double *temporal_positions, const double *f0, int f0_length,
     int fft_size, const D4COption *option, double **aperiodicity);
 
+//-----------------------------------------------------------------------------
+// D4CBatch() runs D4C() over every segment of a batch (see
+// WorldAnalysisBatch), all at sampling frequency fs with the same
+// fft_size. Each segment's aperiodicity equals that of its own D4C() call
+// with the same option; the batch shares windows and FFT buffers between
+// segments and, with an executor, spreads the frames of all segments over
+// its threads.
+//
+// Input:
+//   batch              : Segments to analyze (output: their aperiodicity)
+//   fs                 : Sampling frequency
+//   fft_size           : FFT size of the segments' spectrograms
+//   option             : Struct to order the parameter for D4C
+//-----------------------------------------------------------------------------
+void D4CBatch(const WorldAnalysisBatch *batch, int fs, int fft_size,
+    const D4COption *option);
+
 //-----------------------------------------------------------------------------
 // InitializeD4COption allocates the memory to the struct and sets the
 // default parameters.
@@ -7,6 +7,8 @@
 #define WORLD_DIO_H_
 
 #include "world/macrodefinitions.h"
+#include "world/parallel.h"
+#include "world/workspace.h"
 
 WORLD_BEGIN_C_DECLS
 
@@ -20,6 +22,8 @@ typedef struct {
   double frame_period;  // msec
   int speed;  // (1, 2, ..., 12)
   double allowed_range;  // Threshold used for fixing the F0 contour.
+  const WorldExecutor *executor;  // Runs the bands in parallel (NULL: serial)
+  WorldWorkspace *workspace;      // Keeps scratch between calls (NULL: per call)
 } DioOption;
 
 //-----------------------------------------------------------------------------
@@ -30,8 +30,9 @@ typedef struct {
   fft_complex *c_out;
   double *out;
   double *input;
-  int *ip;
+  int *ip;     // Shared twiddle tables (read-only, owned by fft.cpp)
   double *w;
+  void *backend;  // fftw_plan when built with WORLD_FFT_USE_FFTW
 } fft_plan;
 
 fft_plan fft_plan_dft_1d(int n, fft_complex *in, fft_complex *out, int sign,
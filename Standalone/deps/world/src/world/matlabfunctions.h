@@ -148,6 +148,13 @@ double randn(RandnState *state);
 //-----------------------------------------------------------------------------
 void randn_reseed(RandnState *state);
 
+//-----------------------------------------------------------------------------
+// randn_seed_stream() seeds the generator for one of several independent,
+// reproducible sequences (e.g. one per block of frames analyzed in
+// parallel). Stream 0 is the same sequence as randn_reseed().
+//-----------------------------------------------------------------------------
+void randn_seed_stream(RandnState *state, int stream);
+
 //-----------------------------------------------------------------------------
 // fast_fftfilt() carries out the convolution on the frequency domain.
 //
@@ -0,0 +1,99 @@
+//-----------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//
+// Optional task executor for the analysis functions. WORLD does not create
+// threads itself; the application hands in a parallel loop (e.g. backed by
+// its own thread pool) through the option structs.
+//-----------------------------------------------------------------------------
+#ifndef WORLD_PARALLEL_H_
+#define WORLD_PARALLEL_H_
+
+#include <stddef.h>
+
+#include "world/macrodefinitions.h"
+
+WORLD_BEGIN_C_DECLS
+
+// One iteration of a parallel loop
+typedef void (*WorldTask)(void *context, int index);
+
+//-----------------------------------------------------------------------------
+// WorldExecutor runs task(context, i) exactly once for every i in
+// [0, count), in any order and on any thread, and returns after all calls
+// have finished. Iterations never share writable data.
+//-----------------------------------------------------------------------------
+typedef struct {
+  void (*parallel_for)(void *user_data, int count, WorldTask task,
+      void *context);
+  void *user_data;
+} WorldExecutor;
+
+//-----------------------------------------------------------------------------
+// WorldParallelFor() runs the loop on executor, or serially on the calling
+// thread when executor is NULL (WorldRunsInParallel() tells which).
+//-----------------------------------------------------------------------------
+static inline int WorldRunsInParallel(const WorldExecutor *executor,
+    int count) {
+  return executor != NULL && executor->parallel_for != NULL && count > 1;
+}
+
+static inline void WorldParallelFor(const WorldExecutor *executor, int count,
+    WorldTask task, void *context) {
+  if (WorldRunsInParallel(executor, count)) {
+    executor->parallel_for(executor->user_data, count, task, context);
+    return;
+  }
+  for (int i = 0; i < count; ++i) task(context, i);
+}
+
+// WorldAnalysisBatch lists independent segments for the batch analysis
+// functions (CheapTrickBatch(), D4CBatch()) as parallel arrays: segment i
+// covers f0_length[i] frames at temporal_positions[i] / f0[i] of signal
+// x[i] (x_length[i] samples) and writes rows output[i][0..f0_length[i]).
+// Segments may share a signal, e.g. the voiced ranges of one utterance.
+typedef struct {
+  int count;
+  const double *const *x;
+  const int *x_length;
+  const double *const *temporal_positions;
+  const double *const *f0;
+  const int *f0_length;
+  double **const *output;
+} WorldAnalysisBatch;
+
+// WorldBatchBlock is one block of frames [begin, end) of a batch segment;
+// stream numbers the blocks of each segment from 0.
+typedef struct {
+  int segment;
+  int begin;
+  int end;
+  int stream;
+} WorldBatchBlock;
+
+// GetWorldBatchBlocks() splits every segment into blocks of
+// frames_per_block frames, or one block per segment when frames_per_block
+// is 0, numbered as the per-signal functions number theirs (so a batch
+// gives the same result as one call per segment). Fills up to max_blocks
+// of blocks (may be NULL) and returns the number of blocks.
+static inline int GetWorldBatchBlocks(const WorldAnalysisBatch *batch,
+    int frames_per_block, WorldBatchBlock *blocks, int max_blocks) {
+  int count = 0;
+  for (int segment = 0; segment < batch->count; ++segment) {
+    int length = batch->f0_length[segment];
+    int step = frames_per_block > 0 ? frames_per_block : length;
+    for (int begin = 0, stream = 0; begin < length; begin += step, ++stream) {
+      if (blocks != NULL && count < max_blocks) {
+        blocks[count].segment = segment;
+        blocks[count].begin = begin;
+        blocks[count].end = begin + step < length ? begin + step : length;
+        blocks[count].stream = stream;
+      }
+      ++count;
+    }
+  }
+  return count;
+}
+
+WORLD_END_C_DECLS
+
+#endif  // WORLD_PARALLEL_H_
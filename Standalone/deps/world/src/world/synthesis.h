@@ -31,6 +31,14 @@ void Synthesis(const double *f0, int f0_length,
     const double * const *spectrogram, const double * const *aperiodicity, 
     int fft_size, double frame_period, int fs, int y_length, double *y);
 
+//-----------------------------------------------------------------------------
+// SynthesisFloat() is Synthesis() writing single precision output directly,
+// for callers that play the result as float (no double staging buffer).
+//-----------------------------------------------------------------------------
+void SynthesisFloat(const double *f0, int f0_length,
+    const double * const *spectrogram, const double * const *aperiodicity,
+    int fft_size, double frame_period, int fs, int y_length, float *y);
+
 WORLD_END_C_DECLS
 
 #endif  // WORLD_SYNTHESIS_H_
@@ -0,0 +1,29 @@
+//-----------------------------------------------------------------------------
+// Copyright(c) 2024 Stratojets.
+//
+// Optional persistent scratch for the analysis functions.
+// Without one, every call allocates its arrays and FFT plans and frees them
+// before returning; with one, they are kept for the next call and only grow
+// when a call needs more, so repeated calls on similar signals stop
+// allocating.
+//-----------------------------------------------------------------------------
+#ifndef WORLD_WORKSPACE_H_
+#define WORLD_WORKSPACE_H_
+
+#include "world/macrodefinitions.h"
+
+WORLD_BEGIN_C_DECLS
+
+//-----------------------------------------------------------------------------
+// WorldWorkspace is handed to Dio(), CheapTrick() and D4C() (and their
+// batch forms) through the option structs. It serves one call at a time;
+// the tasks of that call's executor each get their own part of it. Results never depend on whether one is used.
+//-----------------------------------------------------------------------------
+typedef struct WorldWorkspace WorldWorkspace;
+
+WorldWorkspace *CreateWorldWorkspace(void);
+void DestroyWorldWorkspace(WorldWorkspace *workspace);
+
+WORLD_END_C_DECLS
+
+#endif  // WORLD_WORKSPACE_H_
@@ -0,0 +1,425 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - ALSA Audio Output and Sequencer MIDI Input
+//------------------------------------------------------------------------
+
+#include "AlsaBackend.h"
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// AlsaOutput
+//------------------------------------------------------------------------
+AlsaOutput::AlsaOutput() {
+}
+
+//------------------------------------------------------------------------
+AlsaOutput::~AlsaOutput() {
+    stop();
+    if (pcm_) {
+        snd_pcm_close(pcm_);
+        pcm_ = nullptr;
+    }
+}
+
+//------------------------------------------------------------------------
+std::vector<AudioDeviceInfo> AlsaOutput::getDevices() const {
+    std::vector<AudioDeviceInfo> devices;
+
+    void** hints = nullptr;
+    if (snd_device_name_hint(-1, "pcm", &hints) < 0) {
+        return devices;
+    }
+    for (void** hint = hints; *hint != nullptr; ++hint) {
+        char* name = snd_device_name_get_hint(*hint, "NAME");
+        char* desc = snd_device_name_get_hint(*hint, "DESC");
+        char* ioid = snd_device_name_get_hint(*hint, "IOID");
+
+        // IOID is absent for devices that do both directions
+        if (name && (!ioid || std::strcmp(ioid, "Output") == 0)) {
+            AudioDeviceInfo info;
+            info.id = name;
+            info.name = desc ? desc : name;
+            std::replace(info.name.begin(), info.name.end(), '\n', ' ');
+            info.isDefault = (info.id == "default");
+            devices.push_back(info);
+        }
+        std::free(name);
+        std::free(desc);
+        std::free(ioid);
+    }
+    snd_device_name_free_hint(hints);
+    return devices;
+}
+
+//------------------------------------------------------------------------
+bool AlsaOutput::initialize(const std::string& deviceId, int bufferMs, const std::string& mode) {
+    (void)mode;
+    stop();
+    if (pcm_) {
+        snd_pcm_close(pcm_);
+        pcm_ = nullptr;
+    }
+
+    const std::string device = deviceId.empty() ? "default" : deviceId;
+    int err = snd_pcm_open(&pcm_, device.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
+    if (err < 0) {
+        pcm_ = nullptr;
+        lastError_ = "Failed to open " + device + ": " + snd_strerror(err);
+        return false;
+    }
+    if (!configure(bufferMs)) {
+        snd_pcm_close(pcm_);
+        pcm_ = nullptr;
+        return false;
+    }
+
+    scratch_.assign(static_cast<size_t>(periodFrames_) * numChannels_, 0.0f);
+    scratch16_.assign(floatFormat_ ? 0 : scratch_.size(), 0);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool AlsaOutput::configure(int bufferMs) {
+    snd_pcm_hw_params_t* hw = nullptr;
+    snd_pcm_hw_params_alloca(&hw);
+    snd_pcm_hw_params_any(pcm_, hw);
+
+    int err = snd_pcm_hw_params_set_access(pcm_, hw, SND_PCM_ACCESS_RW_INTERLEAVED);
+    if (err < 0) {
+        lastError_ = std::string("Interleaved access not supported: ") + snd_strerror(err);
+        return false;
+    }
+    floatFormat_ = snd_pcm_hw_params_set_format(pcm_, hw, SND_PCM_FORMAT_FLOAT) == 0;
+    if (!floatFormat_ && (err = snd_pcm_hw_params_set_format(pcm_, hw, SND_PCM_FORMAT_S16)) < 0) {
+        lastError_ = std::string("No float or 16-bit format: ") + snd_strerror(err);
+        return false;
+    }
+
+    unsigned int channels = 2;
+    snd_pcm_hw_params_set_channels_near(pcm_, hw, &channels);
+    unsigned int rate = 48000;
+    snd_pcm_hw_params_set_rate_near(pcm_, hw, &rate, nullptr);
+
+    const int periodMs = bufferMs > 0 ? bufferMs : kDefaultPeriodMs;
+    snd_pcm_uframes_t period = (std::max)(16u, rate * periodMs / 1000);
+    snd_pcm_hw_params_set_period_size_near(pcm_, hw, &period, nullptr);
+    snd_pcm_uframes_t buffer = period * kPeriods;
+    snd_pcm_hw_params_set_buffer_size_near(pcm_, hw, &buffer);
+
+    if ((err = snd_pcm_hw_params(pcm_, hw)) < 0) {
+        lastError_ = std::string("Failed to set hardware parameters: ") + snd_strerror(err);
+        return false;
+    }
+    snd_pcm_hw_params_get_channels(hw, &channels);
+    snd_pcm_hw_params_get_rate(hw, &rate, nullptr);
+    snd_pcm_hw_params_get_period_size(hw, &period, nullptr);
+    snd_pcm_hw_params_get_buffer_size(hw, &buffer);
+
+    // Start once the buffer is full; wake with a period of room
+    snd_pcm_sw_params_t* sw = nullptr;
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_sw_params_current(pcm_, sw);
+    snd_pcm_sw_params_set_start_threshold(pcm_, sw, buffer - buffer % period);
+    snd_pcm_sw_params_set_avail_min(pcm_, sw, period);
+    if ((err = snd_pcm_sw_params(pcm_, sw)) < 0) {
+        lastError_ = std::string("Failed to set software parameters: ") + snd_strerror(err);
+        return false;
+    }
+
+    numChannels_ = static_cast<int>(channels);
+    sampleRate_ = static_cast<int>(rate);
+    periodFrames_ = static_cast<int>(period);
+    bufferFrames_ = static_cast<int>(buffer);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool AlsaOutput::start(AudioCallback callback) {
+    if (!pcm_) {
+        lastError_ = "Not initialized";
+        return false;
+    }
+    if (running_) {
+        return true;
+    }
+    stop();     // Thread that ended on an error
+
+    callback_ = callback;
+    running_ = true;
+    audioThread_ = std::thread(&AlsaOutput::audioThread, this);
+    return true;
+}
+
+//------------------------------------------------------------------------
+void AlsaOutput::stop() {
+    running_ = false;
+    if (!audioThread_.joinable()) {
+        return;
+    }
+    audioThread_.join();
+    snd_pcm_drop(pcm_);
+    snd_pcm_prepare(pcm_);
+}
+
+//------------------------------------------------------------------------
+void AlsaOutput::audioThread() {
+    // Real-time priority needs rtprio (audio group); run normally otherwise
+    sched_param param{};
+    param.sched_priority = (std::max)(1, sched_get_priority_max(SCHED_FIFO) - 10);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+    while (running_) {
+        float* buffer = scratch_.data();
+        callback_(buffer, periodFrames_, numChannels_);
+
+        const void* data = buffer;
+        if (!floatFormat_) {
+            for (size_t i = 0; i < scratch_.size(); ++i) {
+                float sample = (std::max)(-1.0f, (std::min)(1.0f, buffer[i]));
+                scratch16_[i] = static_cast<int16_t>(sample * 32767.0f);
+            }
+            data = scratch16_.data();
+        }
+
+        snd_pcm_sframes_t written = snd_pcm_writei(pcm_, data, periodFrames_);
+        if (written < 0) {
+            // Underrun or suspend: restart the stream and carry on
+            if (snd_pcm_recover(pcm_, static_cast<int>(written), 1) < 0) {
+                lastError_ = std::string("Playback failed: ") + snd_strerror(static_cast<int>(written));
+                running_ = false;
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+// AlsaMidiInput
+//------------------------------------------------------------------------
+AlsaMidiInput::AlsaMidiInput() {
+}
+
+//------------------------------------------------------------------------
+AlsaMidiInput::~AlsaMidiInput() {
+    close();
+}
+
+//------------------------------------------------------------------------
+std::vector<AlsaMidiInput::Source> AlsaMidiInput::listSources(snd_seq_t* seq) {
+    std::vector<Source> sources;
+
+    snd_seq_client_info_t* clientInfo = nullptr;
+    snd_seq_port_info_t* portInfo = nullptr;
+    snd_seq_client_info_alloca(&clientInfo);
+    snd_seq_port_info_alloca(&portInfo);
+
+    const int self = snd_seq_client_id(seq);
+    snd_seq_client_info_set_client(clientInfo, -1);
+    while (snd_seq_query_next_client(seq, clientInfo) >= 0) {
+        const int client = snd_seq_client_info_get_client(clientInfo);
+        if (client == SND_SEQ_CLIENT_SYSTEM || client == self) {
+            continue;
+        }
+        snd_seq_port_info_set_client(portInfo, client);
+        snd_seq_port_info_set_port(portInfo, -1);
+        while (snd_seq_query_next_port(seq, portInfo) >= 0) {
+            const unsigned int caps = snd_seq_port_info_get_capability(portInfo);
+            const unsigned int wanted = SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ;
+            if ((caps & wanted) != wanted || (caps & SND_SEQ_PORT_CAP_NO_EXPORT)) {
+                continue;
+            }
+            Source source;
+            source.client = client;
+            source.port = snd_seq_port_info_get_port(portInfo);
+            source.name = std::string(snd_seq_client_info_get_name(clientInfo)) + ": " +
+                          snd_seq_port_info_get_name(portInfo);
+            sources.push_back(source);
+        }
+    }
+    return sources;
+}
+
+//------------------------------------------------------------------------
+std::vector<MidiDeviceInfo> AlsaMidiInput::getDevices() const {
+    std::vector<MidiDeviceInfo> devices;
+
+    snd_seq_t* seq = nullptr;
+    if (snd_seq_open(&seq, "default", SND_SEQ_OPEN_INPUT, 0) < 0) {
+        return devices;
+    }
+    auto sources = listSources(seq);
+    snd_seq_close(seq);
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        MidiDeviceInfo info;
+        info.id = static_cast<int>(i);
+        info.name = sources[i].name;
+        devices.push_back(info);
+    }
+    return devices;
+}
+
+//------------------------------------------------------------------------
+bool AlsaMidiInput::open(const std::vector<int>& deviceIds) {
+    close();
+
+    int err = snd_seq_open(&seq_, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK);
+    if (err < 0) {
+        seq_ = nullptr;
+        lastError_ = std::string("Failed to open the ALSA sequencer: ") + snd_strerror(err);
+        return false;
+    }
+    snd_seq_set_client_name(seq_, "FT-Vox");
+    port_ = snd_seq_create_simple_port(seq_, "FT-Vox In",
+                                       SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+                                       SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+    if (port_ < 0) {
+        lastError_ = std::string("Failed to create sequencer port: ") + snd_strerror(port_);
+        close();
+        return false;
+    }
+
+    const auto available = listSources(seq_);
+    std::string errors;
+    for (int deviceId : deviceIds) {
+        if (sources_.size() > 0xFF) {
+            break;
+        }
+        if (deviceId < 0 || deviceId >= static_cast<int>(available.size())) {
+            errors += (errors.empty() ? "" : "; ") + std::string("Invalid device ID ") + std::to_string(deviceId);
+            continue;
+        }
+        const Source& source = available[deviceId];
+        err = snd_seq_connect_from(seq_, port_, source.client, source.port);
+        if (err < 0) {
+            errors += (errors.empty() ? "" : "; ") + std::string("Failed to connect ") + source.name +
+                      ": " + snd_strerror(err);
+            continue;
+        }
+        deviceName_ += (deviceName_.empty() ? "" : ", ") + source.name;
+        sources_.push_back(source);
+    }
+
+    lastError_ = errors;
+    if (sources_.empty()) {
+        if (lastError_.empty()) {
+            lastError_ = "No MIDI device given";
+        }
+        std::string error = lastError_;
+        close();
+        lastError_ = error;
+        return false;
+    }
+
+    if (pipe(stopPipe_) != 0) {
+        lastError_ = std::string("Failed to create pipe: ") + std::strerror(errno);
+        close();
+        return false;
+    }
+    readerThread_ = std::thread(&AlsaMidiInput::readerThread, this);
+    return true;
+}
+
+//------------------------------------------------------------------------
+void AlsaMidiInput::close() {
+    if (readerThread_.joinable()) {
+        const char stop = 1;
+        (void)write(stopPipe_[1], &stop, 1);
+        readerThread_.join();
+    }
+    for (int& fd : stopPipe_) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    if (seq_) {
+        snd_seq_close(seq_);
+        seq_ = nullptr;
+    }
+    port_ = -1;
+    sources_.clear();
+    deviceName_.clear();
+
+    // Nothing can push any more
+    discardPending();
+}
+
+//------------------------------------------------------------------------
+void AlsaMidiInput::readerThread() {
+    const int count = snd_seq_poll_descriptors_count(seq_, POLLIN);
+    std::vector<pollfd> fds(static_cast<size_t>(count) + 1);
+    snd_seq_poll_descriptors(seq_, fds.data(), count, POLLIN);
+    fds[count].fd = stopPipe_[0];
+    fds[count].events = POLLIN;
+
+    for (;;) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[count].revents & POLLIN) {
+            break;
+        }
+
+        snd_seq_event_t* event = nullptr;
+        int result;
+        while ((result = snd_seq_event_input(seq_, &event)) >= 0 || result == -ENOSPC) {
+            if (!event) {
+                continue;       // Overrun: the kernel dropped events
+            }
+
+            MidiMessage message;
+            message.timeMicros = nowMicros();
+            for (size_t i = 0; i < sources_.size(); ++i) {
+                if (sources_[i].client == event->source.client && sources_[i].port == event->source.port) {
+                    message.port = static_cast<uint8_t>(i);
+                    break;
+                }
+            }
+
+            switch (event->type) {
+                case SND_SEQ_EVENT_NOTEON:
+                case SND_SEQ_EVENT_NOTEOFF:
+                case SND_SEQ_EVENT_KEYPRESS:
+                    message.status = (event->type == SND_SEQ_EVENT_NOTEON ? 0x90 :
+                                      event->type == SND_SEQ_EVENT_NOTEOFF ? 0x80 : 0xA0) |
+                                     (event->data.note.channel & 0x0F);
+                    message.data1 = event->data.note.note & 0x7F;
+                    message.data2 = event->data.note.velocity & 0x7F;
+                    post(message);
+                    break;
+
+                case SND_SEQ_EVENT_CONTROLLER:
+                    message.status = 0xB0 | (event->data.control.channel & 0x0F);
+                    message.data1 = static_cast<uint8_t>(event->data.control.param & 0x7F);
+                    message.data2 = static_cast<uint8_t>(event->data.control.value & 0x7F);
+                    post(message);
+                    break;
+
+                case SND_SEQ_EVENT_CHANPRESS:
+                    message.status = 0xD0 | (event->data.control.channel & 0x0F);
+                    message.data1 = static_cast<uint8_t>(event->data.control.value & 0x7F);
+                    post(message);
+                    break;
+
+                default:
+                    break;
+            }
+            event = nullptr;
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - ALSA Audio Output and Sequencer MIDI Input
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <alsa/asoundlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+
+#include "AudioOutput.h"
+#include "MidiSource.h"
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// AlsaOutput - ALSA PCM playback
+// A real-time thread (SCHED_FIFO where permitted) renders one period per
+// iteration and writes it with snd_pcm_writei, which blocks until the
+// device has room, so the loop runs at the period rate. Small periods
+// (bufferMs, default 5 ms) with three in the buffer; underruns restart
+// the stream instead of stopping it. Float samples where the device takes
+// them, 16-bit otherwise.
+//------------------------------------------------------------------------
+class AlsaOutput : public AudioOutput {
+public:
+    AlsaOutput();
+    ~AlsaOutput() override;
+
+    const char* getBackendName() const override { return "alsa"; }
+
+    // PCM names as accepted by snd_pcm_open ("default", "hw:0,0", ...)
+    std::vector<AudioDeviceInfo> getDevices() const override;
+
+    bool initialize(const std::string& deviceId, int bufferMs, const std::string& mode) override;
+    bool start(AudioCallback callback) override;
+    void stop() override;
+    bool isRunning() const override { return running_; }
+
+    int getSampleRate() const override { return sampleRate_; }
+    int getNumChannels() const override { return numChannels_; }
+    int getBufferFrames() const override { return bufferFrames_; }
+    int getPeriodFrames() const override { return periodFrames_; }
+    std::string getModeName() const override { return floatFormat_ ? "float" : "s16"; }
+
+    const std::string& getLastError() const override { return lastError_; }
+
+private:
+    static constexpr int kPeriods = 3;
+    static constexpr int kDefaultPeriodMs = 5;
+
+    bool configure(int bufferMs);
+    void audioThread();
+
+    snd_pcm_t* pcm_ = nullptr;
+    int sampleRate_ = 48000;
+    int numChannels_ = 2;
+    int bufferFrames_ = 0;
+    int periodFrames_ = 0;
+    bool floatFormat_ = true;
+
+    std::atomic<bool> running_{false};
+    std::thread audioThread_;
+    AudioCallback callback_;
+    std::vector<float> scratch_;
+    std::vector<int16_t> scratch16_;
+    std::string lastError_;
+};
+
+//------------------------------------------------------------------------
+// AlsaMidiInput - ALSA sequencer input
+// One application port subscribed to each opened source; a reader thread
+// sleeps in poll() on the sequencer and posts events as they arrive,
+// stamped with their arrival time.
+//------------------------------------------------------------------------
+class AlsaMidiInput : public MidiSource {
+public:
+    AlsaMidiInput();
+    ~AlsaMidiInput() override;
+
+    const char* getBackendName() const override { return "alsa"; }
+
+    // Readable sequencer ports (device ID = index in this list)
+    std::vector<MidiDeviceInfo> getDevices() const override;
+
+    bool open(const std::vector<int>& deviceIds) override;
+    void close() override;
+    bool isOpen() const override { return !sources_.empty(); }
+
+private:
+    struct Source {
+        int client = 0;
+        int port = 0;
+        std::string name;
+    };
+
+    static std::vector<Source> listSources(snd_seq_t* seq);
+    void readerThread();
+
+    snd_seq_t* seq_ = nullptr;
+    int port_ = -1;
+    std::vector<Source> sources_;     // Opened, in open() order
+    int stopPipe_[2] = { -1, -1 };
+    std::thread readerThread_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
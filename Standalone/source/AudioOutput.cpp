@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - Audio Output Interface
+//------------------------------------------------------------------------
+
+#include "AudioOutput.h"
+
+#ifdef FT_AUDIO_WASAPI
+#include "WasapiAudio.h"
+#endif
+#ifdef FT_AUDIO_COREAUDIO
+#include "CoreAudioBackend.h"
+#endif
+#ifdef FT_AUDIO_ALSA
+#include "AlsaBackend.h"
+#endif
+#ifdef FT_AUDIO_JACK
+#include "JackBackend.h"
+#endif
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+std::vector<std::string> AudioOutput::getBackendNames() {
+    std::vector<std::string> names;
+#ifdef FT_AUDIO_WASAPI
+    names.push_back("wasapi");
+#endif
+#ifdef FT_AUDIO_COREAUDIO
+    names.push_back("coreaudio");
+#endif
+#ifdef FT_AUDIO_ALSA
+    names.push_back("alsa");
+#endif
+#ifdef FT_AUDIO_JACK
+    names.push_back("jack");
+#endif
+    return names;
+}
+
+//------------------------------------------------------------------------
+std::unique_ptr<AudioOutput> AudioOutput::create(const std::string& backend) {
+    std::string name = backend;
+    if (name.empty()) {
+        auto names = getBackendNames();
+        if (names.empty()) {
+            return nullptr;
+        }
+        name = names.front();
+    }
+
+#ifdef FT_AUDIO_WASAPI
+    if (name == "wasapi") {
+        return std::make_unique<WasapiAudio>();
+    }
+#endif
+#ifdef FT_AUDIO_COREAUDIO
+    if (name == "coreaudio") {
+        return std::make_unique<CoreAudioOutput>();
+    }
+#endif
+#ifdef FT_AUDIO_ALSA
+    if (name == "alsa") {
+        return std::make_unique<AlsaOutput>();
+    }
+#endif
+#ifdef FT_AUDIO_JACK
+    if (name == "jack") {
+        return std::make_unique<JackOutput>();
+    }
+#endif
+    return nullptr;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
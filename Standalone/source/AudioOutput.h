@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - Audio Output Interface
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// AudioDeviceInfo - Information about an audio device
+//------------------------------------------------------------------------
+struct AudioDeviceInfo {
+    std::string id;          // Device ID (for selection)
+    std::string name;        // Friendly name
+    bool isDefault = false;  // Is this the default device?
+};
+
+//------------------------------------------------------------------------
+// AudioOutput - callback-driven audio output, one per platform API
+// Backends: WASAPI (Windows), ALSA and JACK (Linux), CoreAudio (macOS);
+// which ones exist depends on what the build found. The callback runs on
+// the backend's real-time thread and fills interleaved float frames, so
+// the DSP pipeline is the same on every platform.
+//------------------------------------------------------------------------
+class AudioOutput {
+public:
+    // Audio callback: fills numFrames interleaved frames of numChannels
+    using AudioCallback = std::function<void(float* buffer, int numFrames, int numChannels)>;
+
+    virtual ~AudioOutput() = default;
+
+    // Backend by name ("wasapi", "alsa", "jack", "coreaudio"; empty = the
+    // platform default). nullptr if it isn't built in.
+    static std::unique_ptr<AudioOutput> create(const std::string& backend);
+
+    // Backends built in, platform default first
+    static std::vector<std::string> getBackendNames();
+
+    virtual const char* getBackendName() const = 0;
+
+    // Output devices of this backend
+    virtual std::vector<AudioDeviceInfo> getDevices() const = 0;
+
+    // Open deviceId (empty = default). bufferMs = requested buffer or
+    // period, 0 = backend default; mode is backend specific ("shared",
+    // "lowLatency", "exclusive" on WASAPI, ignored elsewhere)
+    virtual bool initialize(const std::string& deviceId, int bufferMs, const std::string& mode) = 0;
+
+    // Start audio playback with callback
+    virtual bool start(AudioCallback callback) = 0;
+
+    // Stop audio playback
+    virtual void stop() = 0;
+
+    virtual bool isRunning() const = 0;
+
+    // Format actually in use
+    virtual int getSampleRate() const = 0;
+    virtual int getNumChannels() const = 0;
+    virtual int getBufferFrames() const = 0;
+    virtual int getPeriodFrames() const = 0;   // Frames per callback
+    virtual std::string getModeName() const = 0;
+
+    virtual const std::string& getLastError() const = 0;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,382 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - CoreAudio Output and CoreMIDI Input
+//------------------------------------------------------------------------
+
+#include "CoreAudioBackend.h"
+
+#include <mach/mach_time.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+namespace FlaschenTaschen {
+
+namespace {
+
+// kAudioObjectPropertyElementMain (macOS 12) / ...Master before it
+constexpr AudioObjectPropertyElement kElementMain = 0;
+
+//------------------------------------------------------------------------
+std::string toString(CFStringRef string) {
+    if (!string) {
+        return {};
+    }
+    char buffer[256] = {};
+    CFStringGetCString(string, buffer, sizeof(buffer), kCFStringEncodingUTF8);
+    return buffer;
+}
+
+//------------------------------------------------------------------------
+AudioDeviceID getDefaultOutputDevice() {
+    AudioObjectPropertyAddress address = { kAudioHardwarePropertyDefaultOutputDevice,
+                                           kAudioObjectPropertyScopeGlobal, kElementMain };
+    AudioDeviceID device = kAudioObjectUnknown;
+    UInt32 size = sizeof(device);
+    AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, &device);
+    return device;
+}
+
+//------------------------------------------------------------------------
+int getOutputChannelCount(AudioDeviceID device) {
+    AudioObjectPropertyAddress address = { kAudioDevicePropertyStreamConfiguration,
+                                           kAudioDevicePropertyScopeOutput, kElementMain };
+    UInt32 size = 0;
+    if (AudioObjectGetPropertyDataSize(device, &address, 0, nullptr, &size) != noErr || size == 0) {
+        return 0;
+    }
+    std::vector<uint8_t> storage(size);
+    auto* buffers = reinterpret_cast<AudioBufferList*>(storage.data());
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, buffers) != noErr) {
+        return 0;
+    }
+    int channels = 0;
+    for (UInt32 i = 0; i < buffers->mNumberBuffers; ++i) {
+        channels += static_cast<int>(buffers->mBuffers[i].mNumberChannels);
+    }
+    return channels;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+// CoreAudioOutput
+//------------------------------------------------------------------------
+CoreAudioOutput::CoreAudioOutput() {
+}
+
+//------------------------------------------------------------------------
+CoreAudioOutput::~CoreAudioOutput() {
+    stop();
+    dispose();
+}
+
+//------------------------------------------------------------------------
+std::vector<AudioDeviceInfo> CoreAudioOutput::getDevices() const {
+    std::vector<AudioDeviceInfo> devices;
+
+    AudioObjectPropertyAddress address = { kAudioHardwarePropertyDevices,
+                                           kAudioObjectPropertyScopeGlobal, kElementMain };
+    UInt32 size = 0;
+    if (AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &address, 0, nullptr, &size) != noErr) {
+        return devices;
+    }
+    std::vector<AudioDeviceID> ids(size / sizeof(AudioDeviceID));
+    if (AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, ids.data()) != noErr) {
+        return devices;
+    }
+
+    const AudioDeviceID defaultDevice = getDefaultOutputDevice();
+    for (AudioDeviceID id : ids) {
+        if (getOutputChannelCount(id) == 0) {
+            continue;
+        }
+        AudioObjectPropertyAddress nameAddress = { kAudioObjectPropertyName,
+                                                   kAudioObjectPropertyScopeGlobal, kElementMain };
+        CFStringRef name = nullptr;
+        UInt32 nameSize = sizeof(name);
+        AudioObjectGetPropertyData(id, &nameAddress, 0, nullptr, &nameSize, &name);
+
+        AudioDeviceInfo info;
+        info.id = std::to_string(id);
+        info.name = name ? toString(name) : info.id;
+        info.isDefault = (id == defaultDevice);
+        devices.push_back(info);
+        if (name) {
+            CFRelease(name);
+        }
+    }
+    return devices;
+}
+
+//------------------------------------------------------------------------
+bool CoreAudioOutput::initialize(const std::string& deviceId, int bufferMs, const std::string& mode) {
+    (void)mode;
+    stop();
+    dispose();
+
+    device_ = deviceId.empty() ? getDefaultOutputDevice()
+                               : static_cast<AudioDeviceID>(std::strtoul(deviceId.c_str(), nullptr, 10));
+    if (device_ == kAudioObjectUnknown) {
+        lastError_ = "No output device";
+        return false;
+    }
+
+    AudioComponentDescription description = {};
+    description.componentType = kAudioUnitType_Output;
+    description.componentSubType = kAudioUnitSubType_HALOutput;
+    description.componentManufacturer = kAudioUnitManufacturer_Apple;
+    AudioComponent component = AudioComponentFindNext(nullptr, &description);
+    if (!component || AudioComponentInstanceNew(component, &unit_) != noErr) {
+        unit_ = nullptr;
+        lastError_ = "Failed to create the HAL output unit";
+        return false;
+    }
+
+    OSStatus status = AudioUnitSetProperty(unit_, kAudioOutputUnitProperty_CurrentDevice,
+                                           kAudioUnitScope_Global, 0, &device_, sizeof(device_));
+    if (status != noErr) {
+        lastError_ = "Failed to select device " + std::to_string(device_) + " (error " + std::to_string(status) + ")";
+        dispose();
+        return false;
+    }
+
+    // Run at the device's rate; the pipeline resamples to it
+    AudioObjectPropertyAddress rateAddress = { kAudioDevicePropertyNominalSampleRate,
+                                               kAudioObjectPropertyScopeGlobal, kElementMain };
+    Float64 rate = 48000.0;
+    UInt32 size = sizeof(rate);
+    AudioObjectGetPropertyData(device_, &rateAddress, 0, nullptr, &size, &rate);
+    sampleRate_ = static_cast<int>(rate);
+
+    // Small I/O buffer; the device clamps it to its supported range
+    AudioObjectPropertyAddress bufferAddress = { kAudioDevicePropertyBufferFrameSize,
+                                                 kAudioObjectPropertyScopeGlobal, kElementMain };
+    UInt32 frames = bufferMs > 0 ? static_cast<UInt32>(sampleRate_ * bufferMs / 1000) : kDefaultBufferFrames;
+    AudioObjectSetPropertyData(device_, &bufferAddress, 0, nullptr, sizeof(frames), &frames);
+    size = sizeof(frames);
+    AudioObjectGetPropertyData(device_, &bufferAddress, 0, nullptr, &size, &frames);
+    periodFrames_ = static_cast<int>(frames);
+
+    AudioStreamBasicDescription format = {};
+    format.mSampleRate = rate;
+    format.mFormatID = kAudioFormatLinearPCM;
+    format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked;
+    format.mChannelsPerFrame = kNumChannels;
+    format.mBitsPerChannel = 32;
+    format.mFramesPerPacket = 1;
+    format.mBytesPerFrame = sizeof(float) * kNumChannels;
+    format.mBytesPerPacket = format.mBytesPerFrame;
+    status = AudioUnitSetProperty(unit_, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0,
+                                  &format, sizeof(format));
+    if (status != noErr) {
+        lastError_ = "Float stereo format not accepted (error " + std::to_string(status) + ")";
+        dispose();
+        return false;
+    }
+
+    AURenderCallbackStruct render = { renderStatic, this };
+    AudioUnitSetProperty(unit_, kAudioUnitProperty_SetRenderCallback, kAudioUnitScope_Input, 0,
+                         &render, sizeof(render));
+
+    status = AudioUnitInitialize(unit_);
+    if (status != noErr) {
+        lastError_ = "Failed to initialize the output unit (error " + std::to_string(status) + ")";
+        dispose();
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+void CoreAudioOutput::dispose() {
+    if (unit_) {
+        AudioUnitUninitialize(unit_);
+        AudioComponentInstanceDispose(unit_);
+        unit_ = nullptr;
+    }
+}
+
+//------------------------------------------------------------------------
+bool CoreAudioOutput::start(AudioCallback callback) {
+    if (!unit_) {
+        lastError_ = "Not initialized";
+        return false;
+    }
+    if (running_) {
+        return true;
+    }
+
+    callback_ = callback;
+    running_ = true;
+    OSStatus status = AudioOutputUnitStart(unit_);
+    if (status != noErr) {
+        running_ = false;
+        lastError_ = "Failed to start output (error " + std::to_string(status) + ")";
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+void CoreAudioOutput::stop() {
+    if (!running_) {
+        return;
+    }
+    AudioOutputUnitStop(unit_);
+    running_ = false;
+}
+
+//------------------------------------------------------------------------
+OSStatus CoreAudioOutput::renderStatic(void* refCon, AudioUnitRenderActionFlags* flags,
+                                       const AudioTimeStamp* timeStamp, UInt32 bus,
+                                       UInt32 numFrames, AudioBufferList* data) {
+    (void)flags;
+    (void)timeStamp;
+    (void)bus;
+
+    auto* self = static_cast<CoreAudioOutput*>(refCon);
+    float* buffer = static_cast<float*>(data->mBuffers[0].mData);
+    if (!self->running_) {
+        std::fill(buffer, buffer + numFrames * kNumChannels, 0.0f);
+        return noErr;
+    }
+    self->callback_(buffer, static_cast<int>(numFrames), kNumChannels);
+    return noErr;
+}
+
+//------------------------------------------------------------------------
+// CoreMidiInput
+//------------------------------------------------------------------------
+CoreMidiInput::CoreMidiInput() {
+}
+
+//------------------------------------------------------------------------
+CoreMidiInput::~CoreMidiInput() {
+    close();
+}
+
+//------------------------------------------------------------------------
+std::vector<MidiDeviceInfo> CoreMidiInput::getDevices() const {
+    std::vector<MidiDeviceInfo> devices;
+
+    const ItemCount count = MIDIGetNumberOfSources();
+    for (ItemCount i = 0; i < count; ++i) {
+        MIDIEndpointRef source = MIDIGetSource(i);
+        CFStringRef name = nullptr;
+        MIDIObjectGetStringProperty(source, kMIDIPropertyDisplayName, &name);
+
+        MidiDeviceInfo info;
+        info.id = static_cast<int>(i);
+        info.name = name ? toString(name) : "MIDI " + std::to_string(i);
+        devices.push_back(info);
+        if (name) {
+            CFRelease(name);
+        }
+    }
+    return devices;
+}
+
+//------------------------------------------------------------------------
+bool CoreMidiInput::open(const std::vector<int>& deviceIds) {
+    close();
+
+    OSStatus status = MIDIClientCreate(CFSTR("FT-Vox"), nullptr, nullptr, &client_);
+    if (status != noErr) {
+        client_ = 0;
+        lastError_ = "Failed to create MIDI client (error " + std::to_string(status) + ")";
+        return false;
+    }
+    status = MIDIInputPortCreate(client_, CFSTR("FT-Vox In"), readProc, this, &port_);
+    if (status != noErr) {
+        lastError_ = "Failed to create MIDI input port (error " + std::to_string(status) + ")";
+        close();
+        return false;
+    }
+
+    const auto available = getDevices();
+    std::string errors;
+    for (int deviceId : deviceIds) {
+        if (sources_.size() > 0xFF) {
+            break;
+        }
+        if (deviceId < 0 || deviceId >= static_cast<int>(available.size())) {
+            errors += (errors.empty() ? "" : "; ") + std::string("Invalid device ID ") + std::to_string(deviceId);
+            continue;
+        }
+        MIDIEndpointRef source = MIDIGetSource(static_cast<ItemCount>(deviceId));
+        void* index = reinterpret_cast<void*>(static_cast<intptr_t>(sources_.size()));
+        status = MIDIPortConnectSource(port_, source, index);
+        if (status != noErr) {
+            errors += (errors.empty() ? "" : "; ") + std::string("Failed to connect ") +
+                      available[deviceId].name + " (error " + std::to_string(status) + ")";
+            continue;
+        }
+        deviceName_ += (deviceName_.empty() ? "" : ", ") + available[deviceId].name;
+        sources_.push_back(source);
+    }
+
+    lastError_ = errors;
+    if (sources_.empty()) {
+        if (lastError_.empty()) {
+            lastError_ = "No MIDI device given";
+        }
+        std::string error = lastError_;
+        close();
+        lastError_ = error;
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+void CoreMidiInput::close() {
+    for (MIDIEndpointRef source : sources_) {
+        MIDIPortDisconnectSource(port_, source);
+    }
+    sources_.clear();
+    if (port_) {
+        MIDIPortDispose(port_);
+        port_ = 0;
+    }
+    if (client_) {
+        MIDIClientDispose(client_);
+        client_ = 0;
+    }
+    deviceName_.clear();
+
+    // Nothing can push any more
+    discardPending();
+}
+
+//------------------------------------------------------------------------
+int64_t CoreMidiInput::hostTimeToMicros(MIDITimeStamp hostTime) {
+    static const mach_timebase_info_data_t timebase = [] {
+        mach_timebase_info_data_t info;
+        mach_timebase_info(&info);
+        return info;
+    }();
+
+    // 0 = now; never later than now
+    const int64_t now = nowMicros();
+    const uint64_t hostNow = mach_absolute_time();
+    if (hostTime == 0 || hostTime >= hostNow) {
+        return now;
+    }
+    const uint64_t ageNanos = (hostNow - hostTime) * timebase.numer / timebase.denom;
+    return now - static_cast<int64_t>(ageNanos / 1000);
+}
+
+//------------------------------------------------------------------------
+void CoreMidiInput::readProc(const MIDIPacketList* packets, void* readRefCon, void* sourceRefCon) {
+    auto* self = static_cast<CoreMidiInput*>(readRefCon);
+    const auto port = static_cast<uint8_t>(reinterpret_cast<intptr_t>(sourceRefCon));
+
+    const MIDIPacket* packet = &packets->packet[0];
+    for (UInt32 i = 0; i < packets->numPackets; ++i) {
+        self->postBytes(packet->data, packet->length, port, hostTimeToMicros(packet->timeStamp));
+        packet = MIDIPacketNext(packet);
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - CoreAudio Output and CoreMIDI Input
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <AudioToolbox/AudioToolbox.h>
+#include <CoreAudio/CoreAudio.h>
+#include <CoreMIDI/CoreMIDI.h>
+#include <atomic>
+#include <vector>
+#include <string>
+
+#include "AudioOutput.h"
+#include "MidiSource.h"
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// CoreAudioOutput - HAL output unit with a render callback
+// The callback runs on the device's I/O thread and fills the unit's
+// interleaved float buffer directly. bufferMs sets the device's I/O buffer
+// (default 256 frames). Device IDs are AudioDeviceID numbers.
+//------------------------------------------------------------------------
+class CoreAudioOutput : public AudioOutput {
+public:
+    CoreAudioOutput();
+    ~CoreAudioOutput() override;
+
+    const char* getBackendName() const override { return "coreaudio"; }
+
+    // Devices with output channels
+    std::vector<AudioDeviceInfo> getDevices() const override;
+
+    bool initialize(const std::string& deviceId, int bufferMs, const std::string& mode) override;
+    bool start(AudioCallback callback) override;
+    void stop() override;
+    bool isRunning() const override { return running_; }
+
+    int getSampleRate() const override { return sampleRate_; }
+    int getNumChannels() const override { return kNumChannels; }
+    int getBufferFrames() const override { return periodFrames_; }
+    int getPeriodFrames() const override { return periodFrames_; }
+    std::string getModeName() const override { return "hal"; }
+
+    const std::string& getLastError() const override { return lastError_; }
+
+private:
+    static constexpr int kNumChannels = 2;
+    static constexpr UInt32 kDefaultBufferFrames = 256;
+
+    static OSStatus renderStatic(void* refCon, AudioUnitRenderActionFlags* flags,
+                                 const AudioTimeStamp* timeStamp, UInt32 bus,
+                                 UInt32 numFrames, AudioBufferList* data);
+    void dispose();
+
+    AudioUnit unit_ = nullptr;
+    AudioDeviceID device_ = kAudioObjectUnknown;
+    int sampleRate_ = 48000;
+    int periodFrames_ = 0;
+
+    std::atomic<bool> running_{false};
+    AudioCallback callback_;
+    std::string lastError_;
+};
+
+//------------------------------------------------------------------------
+// CoreMidiInput - CoreMIDI input port connected to each opened source
+// Packets carry host-time stamps, converted to the steady clock.
+//------------------------------------------------------------------------
+class CoreMidiInput : public MidiSource {
+public:
+    CoreMidiInput();
+    ~CoreMidiInput() override;
+
+    const char* getBackendName() const override { return "coremidi"; }
+
+    // MIDI sources (device ID = source index)
+    std::vector<MidiDeviceInfo> getDevices() const override;
+
+    bool open(const std::vector<int>& deviceIds) override;
+    void close() override;
+    bool isOpen() const override { return !sources_.empty(); }
+
+private:
+    static void readProc(const MIDIPacketList* packets, void* readRefCon, void* sourceRefCon);
+    static int64_t hostTimeToMicros(MIDITimeStamp hostTime);
+
+    MIDIClientRef client_ = 0;
+    MIDIPortRef port_ = 0;
+    std::vector<MIDIEndpointRef> sources_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
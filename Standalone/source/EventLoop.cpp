@@ -0,0 +1,284 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - Main Loop Wait
+//------------------------------------------------------------------------
+
+#include "EventLoop.h"
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace FlaschenTaschen {
+
+namespace {
+// The loop that Ctrl+C / SIGTERM wake (one per process)
+std::atomic<EventLoop*> s_signalLoop{nullptr};
+} // namespace
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+//------------------------------------------------------------------------
+EventLoop::EventLoop() {
+}
+
+//------------------------------------------------------------------------
+EventLoop::~EventLoop() {
+    close();
+}
+
+#ifdef _WIN32
+
+//------------------------------------------------------------------------
+bool EventLoop::open(bool readConsole) {
+    console_ = readConsole ? GetStdHandle(STD_INPUT_HANDLE) : nullptr;
+    if (console_ == INVALID_HANDLE_VALUE) {
+        console_ = nullptr;     // Detached (service, redirected)
+    }
+    wakeEvent_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+
+    // High resolution where available (Windows 10 1803+), so frames
+    // aren't rounded to the ~15 ms system tick
+    timer_ = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer_) {
+        timer_ = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+    if (!wakeEvent_ || !timer_) {
+        close();
+        return false;
+    }
+
+    s_signalLoop = this;
+    SetConsoleCtrlHandler(consoleHandler, TRUE);
+    return true;
+}
+
+//------------------------------------------------------------------------
+void EventLoop::close() {
+    if (s_signalLoop == this) {
+        SetConsoleCtrlHandler(consoleHandler, FALSE);
+        s_signalLoop = nullptr;
+    }
+    if (timer_) {
+        CloseHandle(timer_);
+        timer_ = nullptr;
+    }
+    if (wakeEvent_) {
+        CloseHandle(wakeEvent_);
+        wakeEvent_ = nullptr;
+    }
+    console_ = nullptr;
+}
+
+//------------------------------------------------------------------------
+BOOL WINAPI EventLoop::consoleHandler(DWORD type) {
+    if (type != CTRL_C_EVENT && type != CTRL_BREAK_EVENT && type != CTRL_CLOSE_EVENT) {
+        return FALSE;
+    }
+    EventLoop* loop = s_signalLoop;
+    if (!loop) {
+        return FALSE;
+    }
+    loop->quit_ = true;
+    loop->wake();
+    return TRUE;
+}
+
+//------------------------------------------------------------------------
+void EventLoop::wake() {
+    if (wakeEvent_) {
+        SetEvent(wakeEvent_);
+    }
+}
+
+//------------------------------------------------------------------------
+bool EventLoop::readKey(int& key) {
+    // The records are read directly, so mouse, focus and key-up events are
+    // consumed and don't keep the handle signaled
+    if (!console_) {
+        return false;
+    }
+    DWORD pending = 0;
+    while (GetNumberOfConsoleInputEvents(console_, &pending) && pending > 0) {
+        INPUT_RECORD record;
+        DWORD read = 0;
+        if (!ReadConsoleInputA(console_, &record, 1, &read) || read == 0) {
+            return false;
+        }
+        const KEY_EVENT_RECORD& keyEvent = record.Event.KeyEvent;
+        if (record.EventType == KEY_EVENT && keyEvent.bKeyDown && keyEvent.uChar.AsciiChar != 0) {
+            key = static_cast<unsigned char>(keyEvent.uChar.AsciiChar);
+            return true;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------
+void EventLoop::wait(Clock::time_point deadline) {
+    if (deadline != Clock::time_point::max()) {
+        const auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now());
+        LARGE_INTEGER due;
+        due.QuadPart = -(std::max)(static_cast<LONGLONG>(wait.count() / 100), 1LL);  // Relative, 100 ns units
+        SetWaitableTimer(timer_, &due, 0, nullptr, nullptr, FALSE);
+    }
+    // Without a console only the event and the timer are waited on
+    const HANDLE handles[] = { wakeEvent_, timer_, console_ };
+    WaitForMultipleObjects(console_ ? 3 : 2, handles, FALSE, INFINITE);
+}
+
+#else
+
+//------------------------------------------------------------------------
+bool EventLoop::open(bool readConsole) {
+    if (pipe(wakePipe_) != 0) {
+        return false;
+    }
+    for (int fd : wakePipe_) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    // Keys arrive one by one, unechoed; Ctrl+C still raises SIGINT
+    terminal_ = readConsole && isatty(STDIN_FILENO) != 0;
+    if (terminal_ && tcgetattr(STDIN_FILENO, &savedTermios_) == 0) {
+        termios raw = savedTermios_;
+        raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        rawMode_ = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    }
+
+    s_signalLoop = this;
+    struct sigaction action {};
+    action.sa_handler = signalHandler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    return true;
+}
+
+//------------------------------------------------------------------------
+void EventLoop::close() {
+    if (s_signalLoop == this) {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        s_signalLoop = nullptr;
+    }
+    if (rawMode_) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &savedTermios_);
+        rawMode_ = false;
+    }
+    for (int& fd : wakePipe_) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+void EventLoop::signalHandler(int signal) {
+    (void)signal;
+    EventLoop* loop = s_signalLoop;
+    if (loop) {
+        loop->quit_ = true;
+        loop->wake();
+    }
+}
+
+//------------------------------------------------------------------------
+void EventLoop::wake() {
+    // A full pipe already has a wakeup pending
+    if (wakePipe_[1] >= 0) {
+        const char byte = 1;
+        const int savedErrno = errno;
+        (void)write(wakePipe_[1], &byte, 1);
+        errno = savedErrno;
+    }
+}
+
+//------------------------------------------------------------------------
+bool EventLoop::stdinReady(int timeoutMs) {
+    pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+    return poll(&fd, 1, timeoutMs) > 0 && (fd.revents & POLLIN);
+}
+
+//------------------------------------------------------------------------
+bool EventLoop::readKey(int& key) {
+    if (!terminal_) {
+        return false;
+    }
+    while (stdinReady(0)) {
+        unsigned char byte = 0;
+        if (read(STDIN_FILENO, &byte, 1) != 1) {
+            terminal_ = false;      // Hung up: stop polling stdin
+            return false;
+        }
+        if (byte != 27) {
+            key = byte;
+            return true;
+        }
+
+        // A lone ESC is the key; ESC followed right away by more bytes is
+        // an escape sequence (arrows: ESC [ A) or Alt+key
+        if (!stdinReady(10)) {
+            key = byte;
+            return true;
+        }
+        unsigned char next = 0;
+        if (read(STDIN_FILENO, &next, 1) == 1 && (next == '[' || next == 'O')) {
+            // Parameters, then one final byte in 0x40-0x7E
+            for (int i = 0; i < 16 && stdinReady(0); ++i) {
+                if (read(STDIN_FILENO, &next, 1) != 1 || (next >= 0x40 && next <= 0x7E)) {
+                    break;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------
+void EventLoop::wait(Clock::time_point deadline) {
+    pollfd fds[2] = {
+        { wakePipe_[0], POLLIN, 0 },
+        { STDIN_FILENO, POLLIN, 0 },
+    };
+    const nfds_t count = terminal_ ? 2 : 1;
+
+    if (deadline == Clock::time_point::max()) {
+        poll(fds, count, -1);
+    } else {
+        const auto wait = (std::max)(Clock::duration::zero(), deadline - Clock::now());
+#ifdef __linux__
+        // Nanosecond timeout (hrtimer), so frames keep their slots
+        const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+        timespec timeout;
+        timeout.tv_sec = static_cast<time_t>(nanos / 1000000000);
+        timeout.tv_nsec = static_cast<long>(nanos % 1000000000);
+        ppoll(fds, count, &timeout, nullptr);
+#else
+        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(wait).count();
+        poll(fds, count, static_cast<int>((micros + 999) / 1000));
+#endif
+    }
+
+    // Drain wakeups; the caller checks every source anyway
+    char buffer[64];
+    while (read(wakePipe_[0], buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+#endif
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
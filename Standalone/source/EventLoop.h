@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - Main Loop Wait
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <termios.h>
+#endif
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// EventLoop - puts the main thread to sleep until a key press, a wake()
+// from another thread (MIDI drivers) or a deadline (the next frame slot)
+// Windows waits on the console handle, an event and a high-resolution
+// waitable timer; POSIX uses ppoll() on stdin (raw, unechoed while open)
+// and a self-pipe. Ctrl+C / SIGTERM make wait() return with
+// quitRequested() set, so shutdown runs the normal cleanup.
+//------------------------------------------------------------------------
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    EventLoop();
+    ~EventLoop();
+
+    // readConsole = false (headless): only wake(), deadlines and signals
+    bool open(bool readConsole = true);
+    void close();
+
+    // Any thread; async-signal-safe on POSIX
+    void wake();
+
+    // Next key press waiting on the console (false once none is pending).
+    // Only keys with a character are returned; escape sequences (arrows,
+    // function keys) are skipped
+    bool readKey(int& key);
+
+    // Sleep until input, wake() or the deadline (Clock::time_point::max() = none)
+    void wait(Clock::time_point deadline);
+
+    bool quitRequested() const { return quit_; }
+
+private:
+    std::atomic<bool> quit_{false};
+
+#ifdef _WIN32
+    static BOOL WINAPI consoleHandler(DWORD type);
+
+    HANDLE console_ = nullptr;
+    HANDLE wakeEvent_ = nullptr;
+    HANDLE timer_ = nullptr;
+#else
+    static void signalHandler(int signal);
+    bool stdinReady(int timeoutMs);
+
+    int wakePipe_[2] = { -1, -1 };
+    bool terminal_ = false;         // stdin is a terminal (not /dev/null or a pipe)
+    bool rawMode_ = false;
+    termios savedTermios_{};
+#endif
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,323 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - JACK Audio Output and MIDI Input
+//------------------------------------------------------------------------
+
+#include "JackBackend.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace FlaschenTaschen {
+
+namespace {
+
+//------------------------------------------------------------------------
+// Temporary client for listing ports; nullptr if no server is running
+jack_client_t* openQueryClient() {
+    jack_status_t status;
+    return jack_client_open("FT-Vox query", JackNoStartServer, &status);
+}
+
+//------------------------------------------------------------------------
+std::vector<std::string> getPortNames(jack_client_t* client, const char* pattern,
+                                      const char* type, unsigned long flags) {
+    std::vector<std::string> names;
+    const char** ports = jack_get_ports(client, pattern, type, flags);
+    if (ports) {
+        for (const char** port = ports; *port != nullptr; ++port) {
+            names.push_back(*port);
+        }
+        jack_free(ports);
+    }
+    return names;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+// JackOutput
+//------------------------------------------------------------------------
+JackOutput::JackOutput() {
+}
+
+//------------------------------------------------------------------------
+JackOutput::~JackOutput() {
+    stop();
+    if (client_) {
+        jack_client_close(client_);
+        client_ = nullptr;
+    }
+}
+
+//------------------------------------------------------------------------
+std::vector<AudioDeviceInfo> JackOutput::getDevices() const {
+    std::vector<AudioDeviceInfo> devices;
+
+    jack_client_t* client = openQueryClient();
+    if (!client) {
+        return devices;
+    }
+    for (const auto& port : getPortNames(client, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput)) {
+        const std::string owner = port.substr(0, port.find(':'));
+        auto it = std::find_if(devices.begin(), devices.end(),
+                               [&](const AudioDeviceInfo& info) { return info.id == owner; });
+        if (it == devices.end()) {
+            AudioDeviceInfo info;
+            info.id = owner;
+            info.name = owner;
+            info.isDefault = (owner == "system");
+            devices.push_back(info);
+        }
+    }
+    jack_client_close(client);
+    return devices;
+}
+
+//------------------------------------------------------------------------
+bool JackOutput::initialize(const std::string& deviceId, int bufferMs, const std::string& mode) {
+    (void)bufferMs;
+    (void)mode;
+    stop();
+    if (client_) {
+        jack_client_close(client_);
+        client_ = nullptr;
+    }
+
+    jack_status_t status;
+    client_ = jack_client_open("FT-Vox", JackNoStartServer, &status);
+    if (!client_) {
+        lastError_ = "JACK server not running (status " + std::to_string(static_cast<int>(status)) + ")";
+        return false;
+    }
+
+    for (int channel = 0; channel < kNumChannels; ++channel) {
+        const std::string name = "out_" + std::to_string(channel + 1);
+        ports_[channel] = jack_port_register(client_, name.c_str(), JACK_DEFAULT_AUDIO_TYPE,
+                                             JackPortIsOutput, 0);
+        if (!ports_[channel]) {
+            lastError_ = "Failed to register JACK port " + name;
+            jack_client_close(client_);
+            client_ = nullptr;
+            return false;
+        }
+    }
+
+    sampleRate_ = static_cast<int>(jack_get_sample_rate(client_));
+    periodFrames_ = static_cast<int>(jack_get_buffer_size(client_));
+    target_ = deviceId.empty() ? "system" : deviceId;
+
+    // Room for a larger period if the server is reconfigured while running
+    interleaved_.assign(static_cast<size_t>((std::max)(periodFrames_, kMaxPeriodFrames)) * kNumChannels, 0.0f);
+    jack_set_process_callback(client_, processStatic, this);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool JackOutput::start(AudioCallback callback) {
+    if (!client_) {
+        lastError_ = "Not initialized";
+        return false;
+    }
+    if (running_) {
+        return true;
+    }
+
+    callback_ = callback;
+    running_ = true;
+    if (jack_activate(client_) != 0) {
+        running_ = false;
+        lastError_ = "Failed to activate JACK client";
+        return false;
+    }
+
+    // Ports can only be connected once the client is active
+    const auto targets = getPortNames(client_, ("^" + target_ + ":").c_str(),
+                                      JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput);
+    for (int channel = 0; channel < kNumChannels && !targets.empty(); ++channel) {
+        const std::string& target = targets[(std::min)(static_cast<size_t>(channel), targets.size() - 1)];
+        jack_connect(client_, jack_port_name(ports_[channel]), target.c_str());
+    }
+    if (targets.empty()) {
+        lastError_ = "No playback ports on " + target_ + " (connect FT-Vox manually)";
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+void JackOutput::stop() {
+    if (!running_) {
+        return;
+    }
+    jack_deactivate(client_);
+    running_ = false;
+}
+
+//------------------------------------------------------------------------
+int JackOutput::processStatic(jack_nframes_t numFrames, void* arg) {
+    return static_cast<JackOutput*>(arg)->process(numFrames);
+}
+
+//------------------------------------------------------------------------
+int JackOutput::process(jack_nframes_t numFrames) {
+    float* out[kNumChannels];
+    for (int channel = 0; channel < kNumChannels; ++channel) {
+        out[channel] = static_cast<float*>(jack_port_get_buffer(ports_[channel], numFrames));
+    }
+
+    const size_t frames = numFrames;
+    if (!running_ || frames * kNumChannels > interleaved_.size()) {
+        for (int channel = 0; channel < kNumChannels; ++channel) {
+            std::memset(out[channel], 0, frames * sizeof(float));
+        }
+        return 0;
+    }
+
+    // Same interleaved callback as every backend, split into the ports
+    float* buffer = interleaved_.data();
+    callback_(buffer, static_cast<int>(frames), kNumChannels);
+    for (size_t frame = 0; frame < frames; ++frame) {
+        for (int channel = 0; channel < kNumChannels; ++channel) {
+            out[channel][frame] = buffer[frame * kNumChannels + channel];
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------
+// JackMidiInput
+//------------------------------------------------------------------------
+JackMidiInput::JackMidiInput() {
+}
+
+//------------------------------------------------------------------------
+JackMidiInput::~JackMidiInput() {
+    close();
+}
+
+//------------------------------------------------------------------------
+std::vector<std::string> JackMidiInput::listSources(jack_client_t* client) {
+    return getPortNames(client, nullptr, JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput);
+}
+
+//------------------------------------------------------------------------
+std::vector<MidiDeviceInfo> JackMidiInput::getDevices() const {
+    std::vector<MidiDeviceInfo> devices;
+
+    jack_client_t* client = openQueryClient();
+    if (!client) {
+        return devices;
+    }
+    const auto sources = listSources(client);
+    jack_client_close(client);
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        MidiDeviceInfo info;
+        info.id = static_cast<int>(i);
+        info.name = sources[i];
+        devices.push_back(info);
+    }
+    return devices;
+}
+
+//------------------------------------------------------------------------
+bool JackMidiInput::open(const std::vector<int>& deviceIds) {
+    close();
+
+    jack_status_t status;
+    client_ = jack_client_open("FT-Vox MIDI", JackNoStartServer, &status);
+    if (!client_) {
+        lastError_ = "JACK server not running (status " + std::to_string(static_cast<int>(status)) + ")";
+        return false;
+    }
+
+    // Chosen before our own ports exist, so IDs match getDevices()
+    const auto available = listSources(client_);
+    std::vector<std::string> connections;
+    std::string errors;
+    for (int deviceId : deviceIds) {
+        if (ports_.size() > 0xFF) {
+            break;
+        }
+        if (deviceId < 0 || deviceId >= static_cast<int>(available.size())) {
+            errors += (errors.empty() ? "" : "; ") + std::string("Invalid device ID ") + std::to_string(deviceId);
+            continue;
+        }
+        const std::string name = "midi_in_" + std::to_string(ports_.size() + 1);
+        jack_port_t* port = jack_port_register(client_, name.c_str(), JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+        if (!port) {
+            errors += (errors.empty() ? "" : "; ") + std::string("Failed to register JACK port ") + name;
+            continue;
+        }
+        ports_.push_back(port);
+        connections.push_back(available[deviceId]);
+        deviceName_ += (deviceName_.empty() ? "" : ", ") + available[deviceId];
+    }
+
+    lastError_ = errors;
+    if (ports_.empty()) {
+        if (lastError_.empty()) {
+            lastError_ = "No MIDI device given";
+        }
+        std::string error = lastError_;
+        close();
+        lastError_ = error;
+        return false;
+    }
+
+    clockOffsetMicros_ = nowMicros() - static_cast<int64_t>(jack_get_time());
+    jack_set_process_callback(client_, processStatic, this);
+    if (jack_activate(client_) != 0) {
+        close();
+        lastError_ = "Failed to activate JACK client";
+        return false;
+    }
+    for (size_t i = 0; i < ports_.size(); ++i) {
+        jack_connect(client_, connections[i].c_str(), jack_port_name(ports_[i]));
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+void JackMidiInput::close() {
+    if (client_) {
+        jack_deactivate(client_);
+        jack_client_close(client_);
+        client_ = nullptr;
+    }
+    ports_.clear();
+    deviceName_.clear();
+
+    // Nothing can push any more
+    discardPending();
+}
+
+//------------------------------------------------------------------------
+int JackMidiInput::processStatic(jack_nframes_t numFrames, void* arg) {
+    return static_cast<JackMidiInput*>(arg)->process(numFrames);
+}
+
+//------------------------------------------------------------------------
+int JackMidiInput::process(jack_nframes_t numFrames) {
+    // Events read in this cycle arrived during the previous one: their
+    // frame offsets count from one period before this cycle started
+    const jack_nframes_t cycleStart = jack_last_frame_time(client_) - numFrames;
+    const int64_t now = nowMicros();
+
+    for (size_t i = 0; i < ports_.size(); ++i) {
+        void* buffer = jack_port_get_buffer(ports_[i], numFrames);
+        const uint32_t count = jack_midi_get_event_count(buffer);
+        for (uint32_t j = 0; j < count; ++j) {
+            jack_midi_event_t event;
+            if (jack_midi_event_get(&event, buffer, j) != 0) {
+                continue;
+            }
+            const int64_t time = static_cast<int64_t>(jack_frames_to_time(client_, cycleStart + event.time)) +
+                                 clockOffsetMicros_;
+            postBytes(event.buffer, event.size, static_cast<uint8_t>(i), (std::min)(time, now));
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - JACK Audio Output and MIDI Input
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <jack/jack.h>
+#include <jack/midiport.h>
+#include <atomic>
+#include <vector>
+#include <string>
+
+#include "AudioOutput.h"
+#include "MidiSource.h"
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// JackOutput - JACK client with two output ports
+// The callback runs inside JACK's process cycle, at the server's period
+// and sample rate (bufferMs and mode don't apply). The device ID names
+// the client whose playback ports we connect to ("system" by default).
+// The server is never started on demand.
+//------------------------------------------------------------------------
+class JackOutput : public AudioOutput {
+public:
+    JackOutput();
+    ~JackOutput() override;
+
+    const char* getBackendName() const override { return "jack"; }
+
+    // Clients with audio input ports
+    std::vector<AudioDeviceInfo> getDevices() const override;
+
+    bool initialize(const std::string& deviceId, int bufferMs, const std::string& mode) override;
+    bool start(AudioCallback callback) override;
+    void stop() override;
+    bool isRunning() const override { return running_; }
+
+    int getSampleRate() const override { return sampleRate_; }
+    int getNumChannels() const override { return kNumChannels; }
+    int getBufferFrames() const override { return periodFrames_; }
+    int getPeriodFrames() const override { return periodFrames_; }
+    std::string getModeName() const override { return "server period"; }
+
+    const std::string& getLastError() const override { return lastError_; }
+
+private:
+    static constexpr int kNumChannels = 2;
+    static constexpr int kMaxPeriodFrames = 8192;
+
+    static int processStatic(jack_nframes_t numFrames, void* arg);
+    int process(jack_nframes_t numFrames);
+
+    jack_client_t* client_ = nullptr;
+    jack_port_t* ports_[kNumChannels] = {};
+    std::string target_ = "system";
+    int sampleRate_ = 48000;
+    int periodFrames_ = 0;
+
+    std::atomic<bool> running_{false};
+    AudioCallback callback_;
+    std::vector<float> interleaved_;
+    std::string lastError_;
+};
+
+//------------------------------------------------------------------------
+// JackMidiInput - JACK MIDI input, one port per opened source
+// Events are read in the process cycle and stamped from their frame
+// offset, mapped to the steady clock, so timing is sample accurate to
+// within the JACK period.
+//------------------------------------------------------------------------
+class JackMidiInput : public MidiSource {
+public:
+    JackMidiInput();
+    ~JackMidiInput() override;
+
+    const char* getBackendName() const override { return "jack"; }
+
+    // MIDI output ports of other clients (device ID = index in this list)
+    std::vector<MidiDeviceInfo> getDevices() const override;
+
+    bool open(const std::vector<int>& deviceIds) override;
+    void close() override;
+    bool isOpen() const override { return !ports_.empty(); }
+
+private:
+    static std::vector<std::string> listSources(jack_client_t* client);
+    static int processStatic(jack_nframes_t numFrames, void* arg);
+    int process(jack_nframes_t numFrames);
+
+    jack_client_t* client_ = nullptr;
+    std::vector<jack_port_t*> ports_;
+    int64_t clockOffsetMicros_ = 0;    // Steady clock minus jack_get_time()
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -4,6 +4,8 @@
 
 #include "MidiInput.h"
 
+#include <algorithm>
+
 #pragma comment(lib, "winmm.lib")
 
 namespace FlaschenTaschen {
@@ -43,114 +45,107 @@ std::vector<MidiDeviceInfo> MidiInput::enumerateDevices() {
 }
 
 //------------------------------------------------------------------------
-bool MidiInput::open(int deviceId) {
+bool MidiInput::open(const std::vector<int>& deviceIds) {
+    close();
+
+    std::string errors;
+    for (int deviceId : deviceIds) {
+        if (ports_.size() > 0xFF) {
+            break;
+        }
+        if (!openPort(deviceId)) {
+            errors += (errors.empty() ? "" : "; ") + lastError_;
+        }
+    }
+
+    lastError_ = errors;
+    if (ports_.empty()) {
+        if (lastError_.empty()) {
+            lastError_ = "No MIDI device given";
+        }
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool MidiInput::openPort(int deviceId) {
     if (deviceId < 0) {
         lastError_ = "Invalid device ID";
         return false;
     }
 
-    close();
-
     // Get device name
+    std::string name = "MIDI " + std::to_string(deviceId);
     MIDIINCAPSW caps;
     if (midiInGetDevCapsW(deviceId, &caps, sizeof(caps)) == MMSYSERR_NOERROR) {
         int len = WideCharToMultiByte(CP_UTF8, 0, caps.szPname, -1, nullptr, 0, nullptr, nullptr);
         if (len > 0) {
-            deviceName_.resize(len - 1);
-            WideCharToMultiByte(CP_UTF8, 0, caps.szPname, -1, &deviceName_[0], len, nullptr, nullptr);
+            name.resize(len - 1);
+            WideCharToMultiByte(CP_UTF8, 0, caps.szPname, -1, &name[0], len, nullptr, nullptr);
         }
     }
 
-    MMRESULT result = midiInOpen(&midiIn_, deviceId, (DWORD_PTR)midiCallback,
-                                  (DWORD_PTR)this, CALLBACK_FUNCTION);
+    auto port = std::make_unique<Port>();
+    port->owner = this;
+    port->index = static_cast<uint8_t>(ports_.size());
+
+    MMRESULT result = midiInOpen(&port->handle, deviceId, (DWORD_PTR)midiCallback,
+                                  (DWORD_PTR)port.get(), CALLBACK_FUNCTION);
     if (result != MMSYSERR_NOERROR) {
-        lastError_ = "Failed to open MIDI device (error " + std::to_string(result) + ")";
-        midiIn_ = nullptr;
+        lastError_ = "Failed to open MIDI device " + std::to_string(deviceId) + " (error " + std::to_string(result) + ")";
         return false;
     }
 
-    // Start receiving MIDI messages
-    result = midiInStart(midiIn_);
+    // Start receiving MIDI messages; driver timestamps count from here
+    port->startMicros = nowMicros();
+    result = midiInStart(port->handle);
     if (result != MMSYSERR_NOERROR) {
-        midiInClose(midiIn_);
-        midiIn_ = nullptr;
-        lastError_ = "Failed to start MIDI input (error " + std::to_string(result) + ")";
+        midiInClose(port->handle);
+        lastError_ = "Failed to start MIDI input " + std::to_string(deviceId) + " (error " + std::to_string(result) + ")";
         return false;
     }
 
+    deviceName_ += (deviceName_.empty() ? "" : ", ") + name;
+    ports_.push_back(std::move(port));
     return true;
 }
 
 //------------------------------------------------------------------------
 void MidiInput::close() {
-    if (midiIn_) {
-        midiInStop(midiIn_);
-        midiInClose(midiIn_);
-        midiIn_ = nullptr;
+    for (auto& port : ports_) {
+        midiInStop(port->handle);
+        midiInClose(port->handle);
     }
+    ports_.clear();
     deviceName_.clear();
+
+    // Nothing can push any more
+    discardPending();
 }
 
 //------------------------------------------------------------------------
 void CALLBACK MidiInput::midiCallback(HMIDIIN hMidiIn, UINT wMsg, DWORD_PTR dwInstance,
                                        DWORD_PTR dwParam1, DWORD_PTR dwParam2) {
     (void)hMidiIn;
-    (void)dwParam2;
 
-    if (wMsg == MIM_DATA) {
-        MidiInput* self = reinterpret_cast<MidiInput*>(dwInstance);
-        if (self) {
-            self->handleMidiMessage(dwParam1);
-        }
+    if (wMsg != MIM_DATA) {
+        return;
+    }
+    Port* port = reinterpret_cast<Port*>(dwInstance);
+    if (!port || !port->owner) {
+        return;
     }
-}
-
-//------------------------------------------------------------------------
-void MidiInput::handleMidiMessage(DWORD_PTR dwParam1) {
-    // Parse MIDI message
-    BYTE status = dwParam1 & 0xFF;
-    BYTE data1 = (dwParam1 >> 8) & 0xFF;
-    BYTE data2 = (dwParam1 >> 16) & 0xFF;
-
-    BYTE messageType = status & 0xF0;
-    BYTE channel = status & 0x0F;
-
-    switch (messageType) {
-        case 0x90:  // Note On
-            if (noteCallback_) {
-                if (data2 > 0) {
-                    noteCallback_(channel, data1, data2);
-                } else {
-                    // Velocity 0 = Note Off
-                    noteCallback_(channel, data1, 0);
-                }
-            }
-            break;
-
-        case 0x80:  // Note Off
-            if (noteCallback_) {
-                noteCallback_(channel, data1, 0);
-            }
-            break;
 
-        case 0xA0:  // Polyphonic Aftertouch (per-note)
-            if (aftertouchCallback_) {
-                aftertouchCallback_(channel, data1, data2);  // note, pressure
-            }
-            break;
+    // dwParam2 is milliseconds since midiInStart; never later than now
+    MidiMessage message;
+    message.status = dwParam1 & 0xFF;
+    message.data1 = (dwParam1 >> 8) & 0xFF;
+    message.data2 = (dwParam1 >> 16) & 0xFF;
+    message.port = port->index;
+    message.timeMicros = (std::min)(port->startMicros + static_cast<int64_t>(dwParam2) * 1000, nowMicros());
 
-        case 0xD0:  // Channel Aftertouch (all notes)
-            if (aftertouchCallback_) {
-                aftertouchCallback_(channel, -1, data1);  // -1 = all notes, pressure
-            }
-            break;
-
-        case 0xB0:  // Control Change
-            if (ccCallback_) {
-                ccCallback_(channel, data1, data2);  // controller, value
-            }
-            break;
-    }
+    port->owner->post(message);
 }
 
 //------------------------------------------------------------------------
@@ -6,73 +6,52 @@
 
 #include <windows.h>
 #include <mmsystem.h>
-#include <functional>
-#include <atomic>
-#include <mutex>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 
-namespace FlaschenTaschen {
+#include "MidiSource.h"
 
-//------------------------------------------------------------------------
-// MidiDeviceInfo - Information about a MIDI device
-//------------------------------------------------------------------------
-struct MidiDeviceInfo {
-    int id;              // Device ID (for selection)
-    std::string name;    // Device name
-};
+namespace FlaschenTaschen {
 
 //------------------------------------------------------------------------
-// MidiInput - Windows MIDI input handler
+// MidiInput - Windows MIDI input handler (winmm)
+// The winmm callback only stamps each message and posts it to the
+// MidiSource queue. Timestamps come from the driver (milliseconds since
+// the device started), not from when the message is drained.
 //------------------------------------------------------------------------
-class MidiInput {
+class MidiInput : public MidiSource {
 public:
-    // MIDI callback: receives channel, note, velocity (velocity 0 = note off)
-    using NoteCallback = std::function<void(int channel, int note, int velocity)>;
-
-    // Aftertouch callback: receives channel, note (for poly) or -1 (for channel), pressure
-    using AftertouchCallback = std::function<void(int channel, int note, int pressure)>;
-
-    // Control change callback: receives channel, controller number, value
-    using ControlChangeCallback = std::function<void(int channel, int controller, int value)>;
-
     MidiInput();
     ~MidiInput();
 
+    const char* getBackendName() const override { return "winmm"; }
+
     // Enumerate available MIDI input devices
     static std::vector<MidiDeviceInfo> enumerateDevices();
+    std::vector<MidiDeviceInfo> getDevices() const override { return enumerateDevices(); }
 
-    // Open MIDI input device by ID (-1 = no device)
-    bool open(int deviceId);
-
-    // Close MIDI input
-    void close();
-
-    // Check if open
-    bool isOpen() const { return midiIn_ != nullptr; }
+    bool open(const std::vector<int>& deviceIds) override;
+    void close() override;
+    bool isOpen() const override { return !ports_.empty(); }
+    size_t getPortCount() const { return ports_.size(); }
 
-    // Set callbacks
-    void setNoteCallback(NoteCallback callback) { noteCallback_ = callback; }
-    void setAftertouchCallback(AftertouchCallback callback) { aftertouchCallback_ = callback; }
-    void setControlChangeCallback(ControlChangeCallback callback) { ccCallback_ = callback; }
-
-    // Get last error
-    const std::string& getLastError() const { return lastError_; }
+private:
+    // One open device; the callback instance pointer
+    struct Port {
+        MidiInput* owner = nullptr;
+        HMIDIIN handle = nullptr;
+        uint8_t index = 0;
+        int64_t startMicros = 0;    // Steady clock time of midiInStart
+    };
 
-    // Get current device name
-    const std::string& getDeviceName() const { return deviceName_; }
+    bool openPort(int deviceId);
 
-private:
     static void CALLBACK midiCallback(HMIDIIN hMidiIn, UINT wMsg, DWORD_PTR dwInstance,
                                        DWORD_PTR dwParam1, DWORD_PTR dwParam2);
-    void handleMidiMessage(DWORD_PTR dwParam1);
 
-    HMIDIIN midiIn_ = nullptr;
-    NoteCallback noteCallback_;
-    AftertouchCallback aftertouchCallback_;
-    ControlChangeCallback ccCallback_;
-    std::string lastError_;
-    std::string deviceName_;
+    std::vector<std::unique_ptr<Port>> ports_;
 };
 
 //------------------------------------------------------------------------
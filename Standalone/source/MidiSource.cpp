@@ -0,0 +1,175 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - MIDI Input Interface
+//------------------------------------------------------------------------
+
+#include "MidiSource.h"
+
+#include <chrono>
+
+#ifdef FT_MIDI_WINMM
+#include "MidiInput.h"
+#endif
+#ifdef FT_AUDIO_COREAUDIO
+#include "CoreAudioBackend.h"
+#endif
+#ifdef FT_AUDIO_ALSA
+#include "AlsaBackend.h"
+#endif
+#ifdef FT_AUDIO_JACK
+#include "JackBackend.h"
+#endif
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+std::unique_ptr<MidiSource> MidiSource::create(const std::string& backend) {
+    (void)backend;     // Unused when no MIDI backend is built in
+#ifdef FT_MIDI_WINMM
+    if (backend.empty() || backend == "wasapi" || backend == "winmm") {
+        return std::make_unique<MidiInput>();
+    }
+#endif
+#ifdef FT_AUDIO_COREAUDIO
+    if (backend.empty() || backend == "coreaudio" || backend == "coremidi") {
+        return std::make_unique<CoreMidiInput>();
+    }
+#endif
+#ifdef FT_AUDIO_ALSA
+    if (backend.empty() || backend == "alsa") {
+        return std::make_unique<AlsaMidiInput>();
+    }
+#endif
+#ifdef FT_AUDIO_JACK
+    if (backend.empty() || backend == "jack") {
+        return std::make_unique<JackMidiInput>();
+    }
+#endif
+    return nullptr;
+}
+
+//------------------------------------------------------------------------
+int64_t MidiSource::nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------
+void MidiSource::post(const MidiMessage& message) {
+    if (!queue_.push(message)) {
+        ++droppedMessages_;
+        return;
+    }
+    if (wakeCallback_) {
+        wakeCallback_();
+    }
+}
+
+//------------------------------------------------------------------------
+void MidiSource::postBytes(const uint8_t* data, size_t size, uint8_t port, int64_t timeMicros) {
+    uint8_t status = 0;
+    size_t i = 0;
+    while (i < size) {
+        if (data[i] >= 0xF0) {
+            // System message: common ones (and SysEx) cancel running status,
+            // so their data bytes are skipped as strays; real-time is one byte
+            if (data[i] < 0xF8) {
+                status = 0;
+            }
+            if (data[i] == 0xF0) {
+                while (i < size && data[i] != 0xF7) {
+                    ++i;
+                }
+            }
+            ++i;
+            continue;
+        }
+        if (data[i] & 0x80) {
+            status = data[i++];
+        }
+        if (status == 0) {
+            ++i;               // Stray data byte
+            continue;
+        }
+
+        const uint8_t type = status & 0xF0;
+        const size_t length = (type == 0xC0 || type == 0xD0) ? 1 : 2;
+        if (i + length > size) {
+            break;
+        }
+        MidiMessage message;
+        message.status = status;
+        message.data1 = data[i] & 0x7F;
+        message.data2 = length > 1 ? (data[i + 1] & 0x7F) : 0;
+        message.port = port;
+        message.timeMicros = timeMicros;
+        post(message);
+        i += length;
+    }
+}
+
+//------------------------------------------------------------------------
+void MidiSource::discardPending() {
+    MidiMessage message;
+    while (queue_.pop(message)) {
+    }
+}
+
+//------------------------------------------------------------------------
+size_t MidiSource::dispatch() {
+    size_t count = 0;
+    MidiMessage message;
+    while (queue_.pop(message)) {
+        handleMidiMessage(message);
+        ++count;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------
+void MidiSource::handleMidiMessage(const MidiMessage& message) {
+    // Parse MIDI message
+    const uint8_t data1 = message.data1;
+    const uint8_t data2 = message.data2;
+
+    const uint8_t messageType = message.status & 0xF0;
+    const uint8_t channel = message.status & 0x0F;
+
+    switch (messageType) {
+        case 0x90:  // Note On
+            if (noteCallback_) {
+                if (data2 > 0) {
+                    noteCallback_(channel, data1, data2, message.timeMicros);
+                } else {
+                    // Velocity 0 = Note Off
+                    noteCallback_(channel, data1, 0, message.timeMicros);
+                }
+            }
+            break;
+
+        case 0x80:  // Note Off
+            if (noteCallback_) {
+                noteCallback_(channel, data1, 0, message.timeMicros);
+            }
+            break;
+        case 0xA0:  // Polyphonic Aftertouch (per-note)
+            if (aftertouchCallback_) {
+                aftertouchCallback_(channel, data1, data2);  // note, pressure
+            }
+            break;
+
+        case 0xD0:  // Channel Aftertouch (all notes)
+            if (aftertouchCallback_) {
+                aftertouchCallback_(channel, -1, data1);  // -1 = all notes, pressure
+            }
+            break;
+
+        case 0xB0:  // Control Change
+            if (ccCallback_) {
+                ccCallback_(channel, data1, data2);  // controller, value
+            }
+            break;
+    }
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - MIDI Input Interface
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LockFreeQueue.h"
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// MidiDeviceInfo - Information about a MIDI device
+//------------------------------------------------------------------------
+struct MidiDeviceInfo {
+    int id;              // Device ID (for selection)
+    std::string name;    // Device name
+};
+
+//------------------------------------------------------------------------
+// MidiMessage - one short message as received, with its arrival time
+//------------------------------------------------------------------------
+struct MidiMessage {
+    uint8_t status = 0;
+    uint8_t data1 = 0;
+    uint8_t data2 = 0;
+    uint8_t port = 0;           // Index of the device in open() order
+    int64_t timeMicros = 0;     // Driver timestamp on the steady clock (as LatencyStats::nowMicros)
+};
+
+//------------------------------------------------------------------------
+// MidiSource - MIDI input, one per platform API (winmm, ALSA sequencer,
+// JACK, CoreMIDI)
+// Backends only stamp each message on their driver thread and post() it
+// into a lock-free queue (one per source, shared by all its devices). The
+// consumer thread drains it with pop() or dispatch(), so the callbacks
+// below run there, never on the driver thread. Timestamps come from the
+// driver where it has them, so queueing delay doesn't shift note timing.
+//------------------------------------------------------------------------
+class MidiSource {
+public:
+    static constexpr size_t kQueueSize = 1024;
+
+    // MIDI callback: receives channel, note, velocity (velocity 0 = note off)
+    // and the message's timestamp
+    using NoteCallback = std::function<void(int channel, int note, int velocity, int64_t timeMicros)>;
+
+    // Aftertouch callback: receives channel, note (for poly) or -1 (for channel), pressure
+    using AftertouchCallback = std::function<void(int channel, int note, int pressure)>;
+
+    // Control change callback: receives channel, controller number, value
+    using ControlChangeCallback = std::function<void(int channel, int controller, int value)>;
+
+    // Called on the driver thread after messages are queued, so a waiting
+    // consumer wakes right away; must be quick and thread-safe
+    using WakeCallback = std::function<void()>;
+
+    virtual ~MidiSource() = default;
+
+    // Source by name: an audio backend name picks its MIDI API ("wasapi" =
+    // winmm, "alsa" = sequencer, "jack", "coreaudio" = CoreMIDI); empty =
+    // the platform default. nullptr if it isn't built in.
+    static std::unique_ptr<MidiSource> create(const std::string& backend);
+
+    virtual const char* getBackendName() const = 0;
+
+    // Input devices of this backend
+    virtual std::vector<MidiDeviceInfo> getDevices() const = 0;
+
+    // Open several devices at once, merged into one queue. Devices that
+    // fail are skipped (see getLastError()); false if none opened.
+    virtual bool open(const std::vector<int>& deviceIds) = 0;
+
+    // Close MIDI input
+    virtual void close() = 0;
+
+    virtual bool isOpen() const = 0;
+
+    // Set callbacks (called from dispatch(), on the draining thread)
+    void setNoteCallback(NoteCallback callback) { noteCallback_ = callback; }
+    void setAftertouchCallback(AftertouchCallback callback) { aftertouchCallback_ = callback; }
+    void setControlChangeCallback(ControlChangeCallback callback) { ccCallback_ = callback; }
+
+    // Set before open()
+    void setWakeCallback(WakeCallback callback) { wakeCallback_ = callback; }
+
+    // Consumer side (one thread): next raw message, false if none
+    bool pop(MidiMessage& message) { return queue_.pop(message); }
+
+    // Drain the queue, calling the callbacks for each message; returns the count
+    size_t dispatch();
+
+    // Messages lost because the queue was full
+    int getDroppedMessages() const { return droppedMessages_; }
+
+    // Get last error
+    const std::string& getLastError() const { return lastError_; }
+
+    // Get current device name(s), comma separated
+    const std::string& getDeviceName() const { return deviceName_; }
+
+    static int64_t nowMicros();
+
+protected:
+    // Driver side, any thread: queue one message and wake the consumer
+    void post(const MidiMessage& message);
+
+    // Post the channel messages in a raw byte stream (running status
+    // allowed; system messages are skipped)
+    void postBytes(const uint8_t* data, size_t size, uint8_t port, int64_t timeMicros);
+
+    // After the driver has stopped: drop what the consumer didn't take
+    void discardPending();
+
+    std::string lastError_;
+    std::string deviceName_;
+
+private:
+    void handleMidiMessage(const MidiMessage& message);
+
+    MpscQueue<MidiMessage, kQueueSize> queue_;
+    WakeCallback wakeCallback_;
+    std::atomic<int> droppedMessages_{0};
+    NoteCallback noteCallback_;
+    AftertouchCallback aftertouchCallback_;
+    ControlChangeCallback ccCallback_;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
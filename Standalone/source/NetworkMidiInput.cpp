@@ -0,0 +1,576 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - Network Note Input (OSC, RTP-MIDI)
+//------------------------------------------------------------------------
+
+#include "NetworkMidiInput.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#ifdef _WIN32
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace FlaschenTaschen {
+
+namespace {
+
+constexpr size_t kMaxDatagram = 65536;
+constexpr int kMaxBundleDepth = 8;
+constexpr int kMaxOscArgs = 8;
+constexpr int kReceiveBufferBytes = 1 << 20;
+
+//------------------------------------------------------------------------
+uint32_t readU32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+//------------------------------------------------------------------------
+void writeU32(uint8_t* data, uint32_t value) {
+    data[0] = static_cast<uint8_t>(value >> 24);
+    data[1] = static_cast<uint8_t>(value >> 16);
+    data[2] = static_cast<uint8_t>(value >> 8);
+    data[3] = static_cast<uint8_t>(value);
+}
+
+//------------------------------------------------------------------------
+// Length of the OSC string at data (padded to 4 bytes), 0 if unterminated
+size_t oscStringSize(const uint8_t* data, size_t size) {
+    const void* end = std::memchr(data, 0, size);
+    if (!end) {
+        return 0;
+    }
+    const size_t length = static_cast<const uint8_t*>(end) - data + 1;
+    return (std::min)(size, (length + 3) & ~static_cast<size_t>(3));
+}
+
+//------------------------------------------------------------------------
+uint8_t clamp7(int value) {
+    return static_cast<uint8_t>((std::max)(0, (std::min)(127, value)));
+}
+
+//------------------------------------------------------------------------
+int lastSocketError() {
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+} // namespace
+
+//------------------------------------------------------------------------
+NetworkMidiInput::NetworkMidiInput(const std::string& bindAddress, int oscPort, int rtpMidiPort)
+    : bindAddress_(bindAddress.empty() ? "0.0.0.0" : bindAddress)
+    , oscPort_(oscPort)
+    , rtpMidiPort_(rtpMidiPort) {
+    std::random_device random;
+    ssrc_ = random();
+}
+
+//------------------------------------------------------------------------
+NetworkMidiInput::~NetworkMidiInput() {
+    close();
+}
+
+//------------------------------------------------------------------------
+std::vector<MidiDeviceInfo> NetworkMidiInput::getDevices() const {
+    std::vector<MidiDeviceInfo> devices;
+    if (oscPort_ > 0) {
+        devices.push_back({ kOscDevice, "OSC udp/" + std::to_string(oscPort_) });
+    }
+    if (rtpMidiPort_ > 0) {
+        devices.push_back({ kRtpMidiDevice, "RTP-MIDI udp/" + std::to_string(rtpMidiPort_) + "-" +
+                                            std::to_string(rtpMidiPort_ + 1) });
+    }
+    return devices;
+}
+
+//------------------------------------------------------------------------
+bool NetworkMidiInput::open(const std::vector<int>& deviceIds) {
+    close();
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        lastError_ = "WSAStartup failed";
+        return false;
+    }
+    wsaStarted_ = true;
+#endif
+
+    std::string errors;
+    for (int deviceId : deviceIds) {
+        bool ok = true;
+        if (deviceId == kOscDevice && oscPort_ > 0) {
+            ok = openSocket(oscPort_, Kind::Osc, kOscDevice);
+        } else if (deviceId == kRtpMidiDevice && rtpMidiPort_ > 0) {
+            ok = openSocket(rtpMidiPort_, Kind::RtpControl, kRtpMidiDevice) &&
+                 openSocket(rtpMidiPort_ + 1, Kind::RtpData, kRtpMidiDevice);
+        } else {
+            lastError_ = "No network input " + std::to_string(deviceId) + " configured";
+            ok = false;
+        }
+        if (!ok) {
+            errors += (errors.empty() ? "" : "; ") + lastError_;
+        }
+    }
+    for (const auto& device : getDevices()) {
+        const bool opened = std::any_of(sockets_.begin(), sockets_.end(),
+                                        [&](const Socket& socket) { return socket.port == device.id; });
+        if (opened) {
+            deviceName_ += (deviceName_.empty() ? "" : ", ") + device.name;
+        }
+    }
+
+    lastError_ = errors;
+    if (sockets_.empty()) {
+        if (lastError_.empty()) {
+            lastError_ = "No network input given";
+        }
+        std::string error = lastError_;
+        close();
+        lastError_ = error;
+        return false;
+    }
+
+    running_ = true;
+    receiveThread_ = std::thread(&NetworkMidiInput::receiveThread, this);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool NetworkMidiInput::openSocket(int udpPort, Kind kind, uint8_t port) {
+    SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+    if (handle == INVALID_SOCKET) {
+#else
+    if (handle < 0) {
+#endif
+        lastError_ = "Failed to create socket (error " + std::to_string(lastSocketError()) + ")";
+        return false;
+    }
+
+    // Room for bursts while the receiver is descheduled
+    const int bufferBytes = kReceiveBufferBytes;
+    setsockopt(handle, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufferBytes), sizeof(bufferBytes));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(udpPort));
+    if (inet_pton(AF_INET, bindAddress_.c_str(), &address.sin_addr) != 1) {
+        lastError_ = "Invalid bind address: " + bindAddress_;
+        closeSocket(handle);
+        return false;
+    }
+    if (bind(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        lastError_ = "Failed to bind udp/" + std::to_string(udpPort) + " (error " +
+                     std::to_string(lastSocketError()) + ")";
+        closeSocket(handle);
+        return false;
+    }
+
+    // Drained until empty on every wakeup
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(handle, FIONBIO, &nonBlocking);
+#else
+    fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    sockets_.push_back({ handle, kind, port });
+    return true;
+}
+
+//------------------------------------------------------------------------
+void NetworkMidiInput::closeSocket(SocketHandle handle) {
+#ifdef _WIN32
+    closesocket(handle);
+#else
+    ::close(handle);
+#endif
+}
+
+//------------------------------------------------------------------------
+void NetworkMidiInput::close() {
+    if (receiveThread_.joinable()) {
+        running_ = false;
+        poke();
+        receiveThread_.join();
+    }
+    for (const Socket& socket : sockets_) {
+        closeSocket(socket.handle);
+    }
+    sockets_.clear();
+    deviceName_.clear();
+
+#ifdef _WIN32
+    if (wsaStarted_) {
+        WSACleanup();
+        wsaStarted_ = false;
+    }
+#endif
+
+    // Nothing can push any more
+    discardPending();
+}
+
+//------------------------------------------------------------------------
+void NetworkMidiInput::poke() {
+    // An empty datagram to our first socket ends the receiver's select()
+    if (sockets_.empty()) {
+        return;
+    }
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    getsockname(sockets_[0].handle, reinterpret_cast<sockaddr*>(&address), &length);
+    if (address.sin_addr.s_addr == htonl(INADDR_ANY)) {
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    }
+    sendto(sockets_[0].handle, "", 0, 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+}
+
+//------------------------------------------------------------------------
+void NetworkMidiInput::receiveThread() {
+    std::vector<uint8_t> buffer(kMaxDatagram);
+
+    while (running_) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        SocketHandle highest = 0;
+        for (const Socket& socket : sockets_) {
+            FD_SET(socket.handle, &readable);
+            highest = (std::max)(highest, socket.handle);
+        }
+        if (select(static_cast<int>(highest) + 1, &readable, nullptr, nullptr, nullptr) < 0) {
+#ifndef _WIN32
+            if (errno == EINTR) {
+                continue;
+            }
+#endif
+            break;
+        }
+        if (!running_) {
+            break;
+        }
+
+        for (const Socket& socket : sockets_) {
+            if (!FD_ISSET(socket.handle, &readable)) {
+                continue;
+            }
+            for (;;) {
+                sockaddr_in from{};
+                socklen_t fromLength = sizeof(from);
+                const auto received = recvfrom(socket.handle, reinterpret_cast<char*>(buffer.data()),
+                                               static_cast<int>(buffer.size()), 0,
+                                               reinterpret_cast<sockaddr*>(&from), &fromLength);
+                if (received < 0) {
+                    break;      // Drained (would block)
+                }
+                handlePacket(socket, buffer.data(), static_cast<size_t>(received), from, nowMicros());
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+void NetworkMidiInput::handlePacket(const Socket& socket, const uint8_t* data, size_t size,
+                                    const sockaddr_in& from, int64_t timeMicros) {
+    if (size == 0) {
+        return;     // poke()
+    }
+
+    bool ok = false;
+    const bool appleMidi = size >= 4 && data[0] == 0xFF && data[1] == 0xFF;
+    switch (socket.kind) {
+        case Kind::Osc:
+            if (data[0] == '/' || data[0] == '#') {
+                ok = handleOsc(data, size, socket.port, timeMicros, 0);
+            } else if (data[0] & 0x80) {
+                postBytes(data, size, socket.port, timeMicros);
+                ok = true;
+            }
+            break;
+
+        case Kind::RtpControl:
+            ok = appleMidi && handleAppleMidi(socket, data, size, from);
+            break;
+
+        case Kind::RtpData:
+            ok = appleMidi ? handleAppleMidi(socket, data, size, from)
+                           : handleRtpMidi(data, size, socket.port, timeMicros);
+            break;
+    }
+    if (!ok) {
+        ++malformedPackets_;
+    }
+}
+
+//------------------------------------------------------------------------
+bool NetworkMidiInput::handleOsc(const uint8_t* data, size_t size, uint8_t port, int64_t timeMicros, int depth) {
+    if (size < 8 || std::memcmp(data, "#bundle", 8) != 0) {
+        return data[0] == '/' && handleOscMessage(data, size, port, timeMicros);
+    }
+
+    // Bundle: tag, time tag, then size-prefixed elements
+    if (depth >= kMaxBundleDepth || size < 16) {
+        return false;
+    }
+    size_t offset = 16;
+    while (offset + 4 <= size) {
+        const size_t elementSize = readU32(data + offset);
+        offset += 4;
+        if (elementSize == 0 || elementSize > size - offset ||
+            !handleOsc(data + offset, elementSize, port, timeMicros, depth + 1)) {
+            return false;
+        }
+        offset += elementSize;
+    }
+    return offset == size;
+}
+
+//------------------------------------------------------------------------
+bool NetworkMidiInput::handleOscMessage(const uint8_t* data, size_t size, uint8_t port, int64_t timeMicros) {
+    const size_t addressSize = oscStringSize(data, size);
+    if (addressSize == 0) {
+        return false;
+    }
+    const std::string address(reinterpret_cast<const char*>(data));
+    const std::string name = address.substr(address.rfind('/') + 1);
+
+    // Type tags; a message without them has no arguments
+    size_t offset = addressSize;
+    const char* types = ",";
+    if (offset < size) {
+        const size_t typesSize = oscStringSize(data + offset, size - offset);
+        if (typesSize == 0 || data[offset] != ',') {
+            return false;
+        }
+        types = reinterpret_cast<const char*>(data + offset);
+        offset += typesSize;
+    }
+
+    int args[kMaxOscArgs] = {};
+    int argCount = 0;
+    for (const char* type = types + 1; *type != '\0'; ++type) {
+        const size_t remaining = size - offset;
+        int value = 0;
+        bool numeric = true;
+        switch (*type) {
+            case 'i':
+                if (remaining < 4) return false;
+                value = static_cast<int32_t>(readU32(data + offset));
+                offset += 4;
+                break;
+            case 'f': {
+                if (remaining < 4) return false;
+                const uint32_t bits = readU32(data + offset);
+                float f;
+                std::memcpy(&f, &bits, sizeof(f));
+                value = std::isfinite(f) ? static_cast<int>(std::lround(f)) : 0;
+                offset += 4;
+                break;
+            }
+            case 'm': {
+                // Port ID, status, data1, data2
+                if (remaining < 4) return false;
+                postBytes(data + offset + 1, 3, port, timeMicros);
+                offset += 4;
+                numeric = false;
+                break;
+            }
+            case 'h': case 't': case 'd':
+                if (remaining < 8) return false;
+                offset += 8;
+                numeric = false;
+                break;
+            case 's': case 'S': {
+                const size_t stringSize = oscStringSize(data + offset, remaining);
+                if (stringSize == 0) return false;
+                offset += stringSize;
+                numeric = false;
+                break;
+            }
+            case 'b': {
+                if (remaining < 4) return false;
+                const size_t blobSize = (readU32(data + offset) + 3) & ~static_cast<size_t>(3);
+                if (blobSize > remaining - 4) return false;
+                offset += 4 + blobSize;
+                numeric = false;
+                break;
+            }
+            case 'T': value = 1; break;
+            case 'F': value = 0; break;
+            default:
+                numeric = false;     // N, I, arrays: no data
+                break;
+        }
+        if (numeric && argCount < kMaxOscArgs) {
+            args[argCount++] = value;
+        }
+    }
+
+    const auto arg = [&](int index, int fallback) { return index < argCount ? args[index] : fallback; };
+    MidiMessage message;
+    message.port = port;
+    message.timeMicros = timeMicros;
+    if (name == "note" && argCount >= 1) {
+        message.status = 0x90 | (clamp7(arg(2, 0)) & 0x0F);
+        message.data1 = clamp7(arg(0, 0));
+        message.data2 = clamp7(arg(1, 127));
+    } else if (name == "noteoff" && argCount >= 1) {
+        message.status = 0x80 | (clamp7(arg(1, 0)) & 0x0F);
+        message.data1 = clamp7(arg(0, 0));
+    } else if (name == "cc" && argCount >= 2) {
+        message.status = 0xB0 | (clamp7(arg(2, 0)) & 0x0F);
+        message.data1 = clamp7(arg(0, 0));
+        message.data2 = clamp7(arg(1, 0));
+    } else if (name == "aftertouch" && argCount >= 2) {
+        message.status = 0xA0 | (clamp7(arg(2, 0)) & 0x0F);
+        message.data1 = clamp7(arg(0, 0));
+        message.data2 = clamp7(arg(1, 0));
+    } else if (name == "pressure" && argCount >= 1) {
+        message.status = 0xD0 | (clamp7(arg(1, 0)) & 0x0F);
+        message.data1 = clamp7(arg(0, 0));
+    } else {
+        return true;    // Not ours (or /midi, already posted)
+    }
+    post(message);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool NetworkMidiInput::handleAppleMidi(const Socket& socket, const uint8_t* data, size_t size,
+                                       const sockaddr_in& from) {
+    const auto reply = [&](const uint8_t* packet, size_t length) {
+        sendto(socket.handle, reinterpret_cast<const char*>(packet), static_cast<int>(length), 0,
+               reinterpret_cast<const sockaddr*>(&from), sizeof(from));
+    };
+
+    if (data[2] == 'I' && data[3] == 'N') {
+        // Invitation: accept with the same version and token
+        if (size < 16) {
+            return false;
+        }
+        static const char kName[] = "FT-Vox";
+        uint8_t packet[16 + sizeof(kName)];
+        std::memcpy(packet, data, 12);
+        packet[2] = 'O';
+        packet[3] = 'K';
+        writeU32(packet + 12, ssrc_);
+        std::memcpy(packet + 16, kName, sizeof(kName));
+        reply(packet, sizeof(packet));
+        return true;
+    }
+    if (data[2] == 'C' && data[3] == 'K') {
+        // Clock sync: answer the initiator's first timestamp with ours
+        if (size < 36) {
+            return false;
+        }
+        if (data[8] == 0) {
+            uint8_t packet[36];
+            std::memcpy(packet, data, sizeof(packet));
+            writeU32(packet + 4, ssrc_);
+            packet[8] = 1;
+            const uint64_t now = static_cast<uint64_t>(nowMicros() / 100);  // 100 us units
+            writeU32(packet + 20, static_cast<uint32_t>(now >> 32));
+            writeU32(packet + 24, static_cast<uint32_t>(now));
+            reply(packet, sizeof(packet));
+        }
+        return true;
+    }
+    return true;    // BY, RS and others need no answer
+}
+
+//------------------------------------------------------------------------
+bool NetworkMidiInput::handleRtpMidi(const uint8_t* data, size_t size, uint8_t port, int64_t timeMicros) {
+    // RTP header (version 2), CSRCs, then the MIDI command section
+    if (size < 13 || (data[0] & 0xC0) != 0x80) {
+        return false;
+    }
+    size_t offset = 12 + 4 * static_cast<size_t>(data[0] & 0x0F);
+    if (offset >= size) {
+        return false;
+    }
+    const uint8_t flags = data[offset++];
+    size_t length = flags & 0x0F;
+    if (flags & 0x80) {
+        if (offset >= size) {
+            return false;
+        }
+        length = (length << 8) | data[offset++];
+    }
+    if (length > size - offset) {
+        return false;
+    }
+
+    // Commands, each but the first (unless Z) after a delta time; running
+    // status applies. The recovery journal after the list is not used.
+    const uint8_t* list = data + offset;
+    uint8_t status = 0;
+    bool first = !(flags & 0x20);
+    size_t i = 0;
+    while (i < length) {
+        if (!first) {
+            for (int byte = 0; byte < 4 && i < length; ++byte) {
+                if (!(list[i++] & 0x80)) {
+                    break;
+                }
+            }
+        }
+        first = false;
+        if (i >= length) {
+            break;
+        }
+
+        if (list[i] & 0x80) {
+            status = list[i++];
+        }
+        if (status >= 0xF0) {
+            // SysEx (possibly segmented) runs to its terminator; other
+            // system messages are skipped with their data bytes
+            if (status == 0xF0 || status == 0xF7) {
+                while (i < length && list[i] != 0xF7 && list[i] != 0xF0 && list[i] != 0xF4) {
+                    ++i;
+                }
+                ++i;
+            } else {
+                i += (status == 0xF2) ? 2 : (status == 0xF1 || status == 0xF3) ? 1 : 0;
+            }
+            status = 0;
+            continue;
+        }
+        if (status == 0) {
+            return false;
+        }
+
+        const uint8_t type = status & 0xF0;
+        const size_t dataBytes = (type == 0xC0 || type == 0xD0) ? 1 : 2;
+        if (i + dataBytes > length) {
+            return false;
+        }
+        MidiMessage message;
+        message.status = status;
+        message.data1 = list[i] & 0x7F;
+        message.data2 = dataBytes > 1 ? (list[i + 1] & 0x7F) : 0;
+        message.port = port;
+        message.timeMicros = timeMicros;
+        post(message);
+        i += dataBytes;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------
+// FlaschenTaschen Standalone - Network Note Input (OSC, RTP-MIDI)
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#endif
+
+#include "MidiSource.h"
+
+namespace FlaschenTaschen {
+
+//------------------------------------------------------------------------
+// NetworkMidiInput - notes from the network, as a MidiSource
+// Device 0 is the OSC port: OSC messages (also in bundles) and datagrams
+// of raw MIDI bytes. Device 1 is an RTP-MIDI (AppleMIDI) session: control
+// on rtpMidiPort, data on rtpMidiPort + 1; invitations are accepted and
+// clock sync is answered, so macOS network sessions connect directly.
+//
+// OSC addresses (only the last path element counts, so "/ftvox/note"
+// works as well); int or float arguments, [..] optional:
+//   /note note [velocity=127] [channel=0]   velocity 0 = note off
+//   /noteoff note [channel]
+//   /cc controller value [channel]
+//   /aftertouch note pressure [channel]
+//   /pressure pressure [channel]
+//   /midi m                                 OSC MIDI message
+//
+// One receiver thread decodes datagrams straight into the lock-free queue;
+// messages are stamped on arrival (bundle time tags are not scheduled).
+//------------------------------------------------------------------------
+class NetworkMidiInput : public MidiSource {
+public:
+    static constexpr int kOscDevice = 0;
+    static constexpr int kRtpMidiDevice = 1;
+
+    // Ports as in <Network>; 0 leaves that input off
+    NetworkMidiInput(const std::string& bindAddress, int oscPort, int rtpMidiPort);
+    ~NetworkMidiInput() override;
+
+    const char* getBackendName() const override { return "network"; }
+
+    // The configured inputs
+    std::vector<MidiDeviceInfo> getDevices() const override;
+
+    bool open(const std::vector<int>& deviceIds) override;
+    void close() override;
+    bool isOpen() const override { return !sockets_.empty(); }
+
+    // Datagrams that couldn't be decoded
+    int getMalformedPackets() const { return malformedPackets_; }
+
+private:
+#ifdef _WIN32
+    using SocketHandle = SOCKET;
+#else
+    using SocketHandle = int;
+#endif
+
+    enum class Kind { Osc, RtpControl, RtpData };
+
+    struct Socket {
+        SocketHandle handle;
+        Kind kind;
+        uint8_t port;
+    };
+
+    bool openSocket(int udpPort, Kind kind, uint8_t port);
+    static void closeSocket(SocketHandle handle);
+    void receiveThread();
+    void poke();
+
+    void handlePacket(const Socket& socket, const uint8_t* data, size_t size,
+                      const sockaddr_in& from, int64_t timeMicros);
+    bool handleOsc(const uint8_t* data, size_t size, uint8_t port, int64_t timeMicros, int depth);
+    bool handleOscMessage(const uint8_t* data, size_t size, uint8_t port, int64_t timeMicros);
+    bool handleAppleMidi(const Socket& socket, const uint8_t* data, size_t size, const sockaddr_in& from);
+    bool handleRtpMidi(const uint8_t* data, size_t size, uint8_t port, int64_t timeMicros);
+
+    std::string bindAddress_;
+    int oscPort_ = 0;
+    int rtpMidiPort_ = 0;
+
+    std::vector<Socket> sockets_;
+    std::thread receiveThread_;
+    std::atomic<bool> running_{false};
+    std::atomic<int> malformedPackets_{0};
+    uint32_t ssrc_ = 0;             // Our RTP-MIDI session SSRC
+    bool wsaStarted_ = false;
+};
+
+//------------------------------------------------------------------------
+} // namespace FlaschenTaschen
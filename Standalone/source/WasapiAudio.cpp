@@ -3,7 +3,10 @@
 //------------------------------------------------------------------------
 
 #include "WasapiAudio.h"
+#include <avrt.h>
 #include <comdef.h>
+#include <ksmedia.h>
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <locale>
@@ -11,6 +14,7 @@
 
 // Link required libraries
 #pragma comment(lib, "ole32.lib")
+#pragma comment(lib, "avrt.lib")
 
 namespace FlaschenTaschen {
 
@@ -34,6 +38,26 @@ static std::wstring utf8ToWide(const std::string& utf8) {
     return result;
 }
 
+//------------------------------------------------------------------------
+WasapiAudio::ShareMode WasapiAudio::modeFromString(const std::string& mode) {
+    if (mode == "exclusive") {
+        return ShareMode::Exclusive;
+    }
+    if (mode == "lowLatency" || mode == "lowlatency") {
+        return ShareMode::LowLatency;
+    }
+    return ShareMode::Shared;
+}
+
+//------------------------------------------------------------------------
+const char* WasapiAudio::modeToString(ShareMode mode) {
+    switch (mode) {
+        case ShareMode::LowLatency: return "lowLatency";
+        case ShareMode::Exclusive: return "exclusive";
+        default: return "shared";
+    }
+}
+
 //------------------------------------------------------------------------
 WasapiAudio::WasapiAudio() {
 }
@@ -148,11 +172,11 @@ std::vector<AudioDeviceInfo> WasapiAudio::enumerateDevices() {
 
 //------------------------------------------------------------------------
 bool WasapiAudio::initialize() {
-    return initialize("", 0);  // Use default device and buffer
+    return initialize("", 0, ShareMode::Shared);  // Use default device and buffer
 }
 
 //------------------------------------------------------------------------
-bool WasapiAudio::initialize(const std::string& deviceId, int bufferMs) {
+bool WasapiAudio::initialize(const std::string& deviceId, int bufferMs, ShareMode mode) {
     HRESULT hr;
 
     // Initialize COM
@@ -192,28 +216,91 @@ bool WasapiAudio::initialize(const std::string& deviceId, int bufferMs) {
     }
 
     // Activate audio client
-    hr = device_->Activate(
-        __uuidof(IAudioClient),
-        CLSCTX_ALL,
-        nullptr,
-        (void**)&audioClient_
-    );
-    if (FAILED(hr)) {
-        lastError_ = "Failed to activate audio client";
+    if (!activateClient()) {
         return false;
     }
 
-    // Get mix format (shared mode format)
+    // Get mix format (shared mode format; exclusive mode starts from it)
     hr = audioClient_->GetMixFormat(&waveFormat_);
     if (FAILED(hr)) {
         lastError_ = "Failed to get mix format";
         return false;
     }
 
+    bool initialized = false;
+    switch (mode) {
+        case ShareMode::Exclusive: initialized = initializeExclusive(bufferMs); break;
+        case ShareMode::LowLatency: initialized = initializeLowLatency(bufferMs); break;
+        default: initialized = initializeShared(bufferMs); break;
+    }
+    if (!initialized) {
+        return false;
+    }
+
     // Store format info
     sampleRate_ = waveFormat_->nSamplesPerSec;
     numChannels_ = waveFormat_->nChannels;
 
+    // Get actual buffer size
+    UINT32 bufferFrameCount;
+    hr = audioClient_->GetBufferSize(&bufferFrameCount);
+    if (FAILED(hr)) {
+        lastError_ = "Failed to get buffer size";
+        return false;
+    }
+    bufferFrames_ = bufferFrameCount;
+    if (shareMode_ == ShareMode::Exclusive) {
+        periodFrames_ = bufferFrames_;  // One whole buffer per event
+    }
+
+    // Create event for audio callback
+    audioEvent_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!audioEvent_) {
+        lastError_ = "Failed to create audio event";
+        return false;
+    }
+
+    hr = audioClient_->SetEventHandle(audioEvent_);
+    if (FAILED(hr)) {
+        lastError_ = "Failed to set event handle";
+        return false;
+    }
+
+    // Get render client
+    hr = audioClient_->GetService(
+        __uuidof(IAudioRenderClient),
+        (void**)&renderClient_
+    );
+    if (FAILED(hr)) {
+        lastError_ = "Failed to get render client";
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool WasapiAudio::activateClient() {
+    if (audioClient_) {
+        audioClient_->Release();
+        audioClient_ = nullptr;
+    }
+
+    HRESULT hr = device_->Activate(
+        __uuidof(IAudioClient),
+        CLSCTX_ALL,
+        nullptr,
+        (void**)&audioClient_
+    );
+    if (FAILED(hr)) {
+        lastError_ = "Failed to activate audio client";
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool WasapiAudio::initializeShared(int bufferMs) {
     // Calculate buffer duration (in 100ns units)
     // Default to 20ms if not specified or invalid
     if (bufferMs <= 0) bufferMs = 20;
@@ -221,7 +308,7 @@ bool WasapiAudio::initialize(const std::string& deviceId, int bufferMs) {
     REFERENCE_TIME requestedDuration = bufferMs * 10000; // ms to 100ns units
 
     // Initialize audio client in shared mode (more compatible than exclusive)
-    hr = audioClient_->Initialize(
+    HRESULT hr = audioClient_->Initialize(
         AUDCLNT_SHAREMODE_SHARED,
         AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
         requestedDuration,
@@ -234,38 +321,144 @@ bool WasapiAudio::initialize(const std::string& deviceId, int bufferMs) {
         return false;
     }
 
-    // Get actual buffer size
-    UINT32 bufferFrameCount;
-    hr = audioClient_->GetBufferSize(&bufferFrameCount);
+    // The engine wakes us once per device period
+    REFERENCE_TIME defaultPeriod = 0;
+    if (SUCCEEDED(audioClient_->GetDevicePeriod(&defaultPeriod, nullptr))) {
+        periodFrames_ = static_cast<int>(defaultPeriod * waveFormat_->nSamplesPerSec / 10000000);
+    }
+    shareMode_ = ShareMode::Shared;
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool WasapiAudio::initializeLowLatency(int bufferMs) {
+    IAudioClient3* client3 = nullptr;
+    HRESULT hr = audioClient_->QueryInterface(__uuidof(IAudioClient3), (void**)&client3);
+    if (FAILED(hr) || !client3) {
+        return initializeShared(bufferMs);  // Before Windows 10
+    }
+
+    UINT32 defaultPeriod = 0, fundamentalPeriod = 0, minPeriod = 0, maxPeriod = 0;
+    hr = client3->GetSharedModeEnginePeriod(waveFormat_, &defaultPeriod, &fundamentalPeriod,
+                                            &minPeriod, &maxPeriod);
+    UINT32 period = minPeriod;
+    if (SUCCEEDED(hr) && bufferMs > 0 && fundamentalPeriod > 0) {
+        // Requested period, rounded up to the engine's granularity
+        UINT32 requested = static_cast<UINT32>(static_cast<uint64_t>(bufferMs) * waveFormat_->nSamplesPerSec / 1000);
+        period = (requested + fundamentalPeriod - 1) / fundamentalPeriod * fundamentalPeriod;
+        period = (std::max)(minPeriod, (std::min)(maxPeriod, period));
+    }
+    if (SUCCEEDED(hr)) {
+        hr = client3->InitializeSharedAudioStream(AUDCLNT_STREAMFLAGS_EVENTCALLBACK, period, waveFormat_, nullptr);
+    }
+    client3->Release();
+
     if (FAILED(hr)) {
-        lastError_ = "Failed to get buffer size";
+        // Driver without small-period support: regular shared mode on a fresh client
+        if (!activateClient()) {
+            return false;
+        }
+        return initializeShared(bufferMs);
+    }
+
+    periodFrames_ = static_cast<int>(period);
+    shareMode_ = ShareMode::LowLatency;
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool WasapiAudio::selectExclusiveFormat() {
+    // Keep the mixer's rate and channel layout, pick a sample type the
+    // device takes directly: float if it can, else 16-bit PCM
+    const DWORD sampleRate = waveFormat_->nSamplesPerSec;
+    const WORD channels = waveFormat_->nChannels;
+    DWORD channelMask = 0;
+    if (waveFormat_->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+        channelMask = reinterpret_cast<WAVEFORMATEXTENSIBLE*>(waveFormat_)->dwChannelMask;
+    }
+
+    auto* format = static_cast<WAVEFORMATEXTENSIBLE*>(CoTaskMemAlloc(sizeof(WAVEFORMATEXTENSIBLE)));
+    if (!format) {
+        lastError_ = "Out of memory";
         return false;
     }
-    bufferFrames_ = bufferFrameCount;
 
-    // Create event for audio callback
-    audioEvent_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-    if (!audioEvent_) {
-        lastError_ = "Failed to create audio event";
+    struct SampleType {
+        GUID subFormat;
+        WORD bits;
+    };
+    const SampleType sampleTypes[] = {
+        { KSDATAFORMAT_SUBTYPE_IEEE_FLOAT, 32 },
+        { KSDATAFORMAT_SUBTYPE_PCM, 16 }
+    };
+
+    for (const auto& type : sampleTypes) {
+        std::memset(format, 0, sizeof(WAVEFORMATEXTENSIBLE));
+        format->Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+        format->Format.nChannels = channels;
+        format->Format.nSamplesPerSec = sampleRate;
+        format->Format.wBitsPerSample = type.bits;
+        format->Format.nBlockAlign = static_cast<WORD>(channels * type.bits / 8);
+        format->Format.nAvgBytesPerSec = sampleRate * format->Format.nBlockAlign;
+        format->Format.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+        format->Samples.wValidBitsPerSample = type.bits;
+        format->dwChannelMask = channelMask;
+        format->SubFormat = type.subFormat;
+
+        if (audioClient_->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, &format->Format, nullptr) == S_OK) {
+            CoTaskMemFree(waveFormat_);
+            waveFormat_ = &format->Format;
+            return true;
+        }
+    }
+
+    CoTaskMemFree(format);
+    lastError_ = "Device takes neither 32-bit float nor 16-bit PCM in exclusive mode";
+    return false;
+}
+
+//------------------------------------------------------------------------
+bool WasapiAudio::initializeExclusive(int bufferMs) {
+    if (!selectExclusiveFormat()) {
         return false;
     }
 
-    hr = audioClient_->SetEventHandle(audioEvent_);
+    REFERENCE_TIME defaultPeriod = 0, minPeriod = 0;
+    HRESULT hr = audioClient_->GetDevicePeriod(&defaultPeriod, &minPeriod);
     if (FAILED(hr)) {
-        lastError_ = "Failed to set event handle";
+        lastError_ = "Failed to get device period";
         return false;
     }
+    REFERENCE_TIME period = minPeriod;
+    if (bufferMs > 0) {
+        period = (std::max)(minPeriod, static_cast<REFERENCE_TIME>((std::min)(bufferMs, 500)) * 10000);
+    }
 
-    // Get render client
-    hr = audioClient_->GetService(
-        __uuidof(IAudioRenderClient),
-        (void**)&renderClient_
-    );
+    // Event-driven exclusive mode: the buffer is exactly one period
+    hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+                                  period, period, waveFormat_, nullptr);
+    if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
+        // Retry with the aligned size the device reports, on a fresh client
+        UINT32 alignedFrames = 0;
+        audioClient_->GetBufferSize(&alignedFrames);
+        period = static_cast<REFERENCE_TIME>(10000000.0 * alignedFrames / waveFormat_->nSamplesPerSec + 0.5);
+        if (!activateClient()) {
+            return false;
+        }
+        hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+                                      period, period, waveFormat_, nullptr);
+    }
     if (FAILED(hr)) {
-        lastError_ = "Failed to get render client";
+        lastError_ = "Failed to initialize exclusive mode (hr=" + std::to_string(hr) + ")";
+        if (hr == AUDCLNT_E_DEVICE_IN_USE) {
+            lastError_ += ": device in use";
+        } else if (hr == AUDCLNT_E_EXCLUSIVE_MODE_NOT_ALLOWED) {
+            lastError_ += ": exclusive mode disabled for this device";
+        }
         return false;
     }
 
+    shareMode_ = ShareMode::Exclusive;
     return true;
 }
 
@@ -283,6 +476,15 @@ bool WasapiAudio::start(AudioCallback callback) {
     callback_ = callback;
     running_ = true;
 
+    // Exclusive mode plays whatever is in the buffer from the first period:
+    // start on silence
+    if (shareMode_ == ShareMode::Exclusive) {
+        BYTE* buffer = nullptr;
+        if (SUCCEEDED(renderClient_->GetBuffer(bufferFrames_, &buffer))) {
+            renderClient_->ReleaseBuffer(bufferFrames_, AUDCLNT_BUFFERFLAGS_SILENT);
+        }
+    }
+
     // Start audio thread
     audioThread_ = std::thread(&WasapiAudio::audioThread, this);
 
@@ -325,8 +527,21 @@ void WasapiAudio::stop() {
 
 //------------------------------------------------------------------------
 void WasapiAudio::audioThread() {
-    // Set thread priority for audio
-    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    // Register with MMCSS so the thread is scheduled as pro audio, ahead
+    // of ordinary time-critical threads; plain priority if that fails
+    DWORD taskIndex = 0;
+    HANDLE mmcss = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+    if (mmcss) {
+        AvSetMmThreadPriority(mmcss, AVRT_PRIORITY_HIGH);
+    } else {
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    }
+
+    // Check if format is float
+    const bool isFloat = (waveFormat_->wFormatTag == WAVE_FORMAT_IEEE_FLOAT) ||
+                         (waveFormat_->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+                          reinterpret_cast<WAVEFORMATEXTENSIBLE*>(waveFormat_)->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
+    std::vector<float> tempBuffer(isFloat ? 0 : static_cast<size_t>(bufferFrames_) * numChannels_);
 
     while (running_) {
         // Wait for buffer event
@@ -338,17 +553,20 @@ void WasapiAudio::audioThread() {
             continue;
         }
 
-        // Get padding (how much data is already in buffer)
-        UINT32 padding = 0;
-        HRESULT hr = audioClient_->GetCurrentPadding(&padding);
-        if (FAILED(hr)) {
-            continue;
-        }
-
-        // Calculate available frames
-        UINT32 availableFrames = bufferFrames_ - padding;
-        if (availableFrames == 0) {
-            continue;
+        // Exclusive mode hands over a whole buffer per event; shared mode
+        // fills what the engine has consumed
+        UINT32 availableFrames = bufferFrames_;
+        HRESULT hr = S_OK;
+        if (shareMode_ != ShareMode::Exclusive) {
+            UINT32 padding = 0;
+            hr = audioClient_->GetCurrentPadding(&padding);
+            if (FAILED(hr)) {
+                continue;
+            }
+            availableFrames = bufferFrames_ - padding;
+            if (availableFrames == 0) {
+                continue;
+            }
         }
 
         // Get buffer from WASAPI
@@ -358,18 +576,12 @@ void WasapiAudio::audioThread() {
             continue;
         }
 
-        // Check if format is float
-        bool isFloat = (waveFormat_->wFormatTag == WAVE_FORMAT_IEEE_FLOAT) ||
-                       (waveFormat_->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
-                        reinterpret_cast<WAVEFORMATEXTENSIBLE*>(waveFormat_)->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
-
         if (isFloat && callback_) {
             // Direct float output
             callback_(reinterpret_cast<float*>(buffer), availableFrames, numChannels_);
         }
         else if (callback_) {
-            // Need to convert - create temp float buffer
-            std::vector<float> tempBuffer(availableFrames * numChannels_);
+            // Need to convert - render into the float scratch buffer
             callback_(tempBuffer.data(), availableFrames, numChannels_);
 
             // Convert float to 16-bit PCM
@@ -388,6 +600,10 @@ void WasapiAudio::audioThread() {
         // Release buffer
         renderClient_->ReleaseBuffer(availableFrames, 0);
     }
+
+    if (mmcss) {
+        AvRevertMmThreadCharacteristics(mmcss);
+    }
 }
 
 //------------------------------------------------------------------------
@@ -8,63 +8,83 @@
 #include <mmdeviceapi.h>
 #include <audioclient.h>
 #include <functiondiscoverykeys_devpkey.h>
-#include <functional>
 #include <atomic>
 #include <thread>
 #include <mutex>
 #include <vector>
 #include <string>
 
-namespace FlaschenTaschen {
+#include "AudioOutput.h"
 
-//------------------------------------------------------------------------
-// AudioDeviceInfo - Information about an audio device
-//------------------------------------------------------------------------
-struct AudioDeviceInfo {
-    std::string id;          // Device ID (for selection)
-    std::string name;        // Friendly name
-    bool isDefault = false;  // Is this the default device?
-};
+namespace FlaschenTaschen {
 
 //------------------------------------------------------------------------
-// WasapiAudio - Simple WASAPI shared mode audio output
+// WasapiAudio - WASAPI event-driven audio output
+// Shared mode goes through the Windows mixer with the requested buffer.
+// LowLatency is shared mode on the engine's minimum period (IAudioClient3,
+// Windows 10+; often 128 frames = 2.67 ms at 48 kHz). Exclusive bypasses
+// the mixer and runs the device at its minimum period in a format it
+// supports (float or 16-bit). The audio thread is registered with MMCSS.
 //------------------------------------------------------------------------
-class WasapiAudio {
+class WasapiAudio : public AudioOutput {
 public:
-    // Audio callback: fills buffer with samples, returns number of frames written
-    using AudioCallback = std::function<void(float* buffer, int numFrames, int numChannels)>;
+    enum class ShareMode {
+        Shared = 0,
+        LowLatency,
+        Exclusive
+    };
+
+    // "shared", "lowLatency" or "exclusive" (anything else = Shared)
+    static ShareMode modeFromString(const std::string& mode);
+    static const char* modeToString(ShareMode mode);
 
     WasapiAudio();
-    ~WasapiAudio();
+    ~WasapiAudio() override;
+
+    const char* getBackendName() const override { return "wasapi"; }
 
     // Enumerate available output devices
     static std::vector<AudioDeviceInfo> enumerateDevices();
+    std::vector<AudioDeviceInfo> getDevices() const override { return enumerateDevices(); }
 
     // Initialize WASAPI with default device
     bool initialize();
 
     // Initialize WASAPI with specific device by ID (empty = default)
-    // bufferMs = requested buffer size in milliseconds (0 = use default 20ms)
-    bool initialize(const std::string& deviceId, int bufferMs = 0);
+    // bufferMs = requested buffer (Shared) or period (other modes) in
+    // milliseconds; 0 = 20 ms shared, the minimum period otherwise.
+    // LowLatency falls back to Shared where IAudioClient3 is missing.
+    bool initialize(const std::string& deviceId, int bufferMs = 0, ShareMode mode = ShareMode::Shared);
+    bool initialize(const std::string& deviceId, int bufferMs, const std::string& mode) override {
+        return initialize(deviceId, bufferMs, modeFromString(mode));
+    }
 
     // Start audio playback with callback
-    bool start(AudioCallback callback);
+    bool start(AudioCallback callback) override;
 
     // Stop audio playback
-    void stop();
+    void stop() override;
 
     // Check if running
-    bool isRunning() const { return running_; }
+    bool isRunning() const override { return running_; }
 
     // Get format info
-    int getSampleRate() const { return sampleRate_; }
-    int getNumChannels() const { return numChannels_; }
-    int getBufferFrames() const { return bufferFrames_; }
+    int getSampleRate() const override { return sampleRate_; }
+    int getNumChannels() const override { return numChannels_; }
+    int getBufferFrames() const override { return bufferFrames_; }
+    int getPeriodFrames() const override { return periodFrames_; }  // Frames per wakeup
+    ShareMode getShareMode() const { return shareMode_; }  // Mode actually in use
+    std::string getModeName() const override { return modeToString(shareMode_); }
 
     // Get last error
-    const std::string& getLastError() const { return lastError_; }
+    const std::string& getLastError() const override { return lastError_; }
 
 private:
+    bool activateClient();
+    bool selectExclusiveFormat();
+    bool initializeShared(int bufferMs);
+    bool initializeLowLatency(int bufferMs);
+    bool initializeExclusive(int bufferMs);
     void audioThread();
 
     IMMDeviceEnumerator* deviceEnumerator_ = nullptr;
@@ -76,6 +96,8 @@ private:
     int sampleRate_ = 44100;
     int numChannels_ = 2;
     int bufferFrames_ = 0;
+    int periodFrames_ = 0;
+    ShareMode shareMode_ = ShareMode::Shared;
 
     std::atomic<bool> running_{false};
     std::thread audioThread_;
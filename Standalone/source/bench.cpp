@@ -0,0 +1,464 @@
+//------------------------------------------------------------------------
+// FT-Vox offline pipeline benchmark
+//
+// Renders every syllable of a mapping across a MIDI note sweep through
+// eSpeak -> pitch shift (World or PSOLA) -> resampler, without audio or
+// network devices, and reports per stage:
+//   - throughput as a multiple of realtime (audio seconds / wall seconds)
+//   - heap allocations per call
+//   - p50/p99/max call latency
+//
+// Command line:
+//   ftvox_bench [options] [mapping.xml]
+//   --low <note> --high <note> --step <n>   Note sweep (default 36..84 step 4)
+//   --engine world|fast                     Pitch engine (default: mapping's)
+//   --rate <hz>                             Output sample rate (default 48000)
+//   --repeat <n>                            Passes over the sweep (default 1)
+//   --threads <n>                           World analysis threads (default 0 = serial)
+//   --batch                                 Analyze each pass's syllables in one batch
+//   --json <file|->                         Write results as JSON
+//
+// Without eSpeak (or with --synthetic) each syllable is replaced by a
+// deterministic voiced test signal, so the World/resampler stages can still
+// be compared across machines and commits.
+//------------------------------------------------------------------------
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// Include FlaschenTaschen library sources
+#include "../../FlaschenTaschen/source/MappingBinary.h"
+#include "../../FlaschenTaschen/source/MappingBinary.cpp"
+#include "../../FlaschenTaschen/source/MappingConfig.h"
+#include "../../FlaschenTaschen/source/MappingConfig.cpp"
+#include "../../FlaschenTaschen/source/ESpeakService.h"
+#include "../../FlaschenTaschen/source/ESpeakService.cpp"
+#include "../../FlaschenTaschen/source/ESpeakSynthesizer.h"
+#include "../../FlaschenTaschen/source/ESpeakSynthesizer.cpp"
+#include "../../FlaschenTaschen/source/PitchShifter.h"
+#include "../../FlaschenTaschen/source/PitchShifter.cpp"
+#include "../../FlaschenTaschen/source/PsolaPitchShifter.h"
+#include "../../FlaschenTaschen/source/PsolaPitchShifter.cpp"
+#include "../../FlaschenTaschen/source/WorldPitchShifter.h"
+#include "../../FlaschenTaschen/source/WorldPitchShifter.cpp"
+#include "../../FlaschenTaschen/source/Resampler.h"
+#include "../../FlaschenTaschen/source/Resampler.cpp"
+#include "../../FlaschenTaschen/source/ThreadPool.h"
+#include "../../FlaschenTaschen/source/ThreadPool.cpp"
+#include "../../FlaschenTaschen/source/LatencyStats.h"
+#include "../../FlaschenTaschen/source/LatencyStats.cpp"
+
+using namespace FlaschenTaschen;
+
+//------------------------------------------------------------------------
+// Heap allocation counting (all threads; aligned/nothrow forms not counted)
+//------------------------------------------------------------------------
+namespace {
+    std::atomic<uint64_t> g_allocations{0};
+    std::atomic<uint64_t> g_allocatedBytes{0};
+
+    // Both new forms allocate here so every block comes from malloc and
+    // every delete form frees it; neither form forwards to the other.
+    void* countedAlloc(size_t size) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        if (void* p = std::malloc(size ? size : 1)) {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+//------------------------------------------------------------------------
+// StageResult - accumulated measurements of one pipeline stage
+//------------------------------------------------------------------------
+struct StageResult {
+    const char* name = "";
+    LatencyHistogram latency;
+    uint64_t calls = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+    double wallSeconds = 0.0;
+    double audioSeconds = 0.0;   // Audio produced by the stage
+
+    double realtimeFactor() const { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+};
+
+//------------------------------------------------------------------------
+// StageTimer - measures one call of a stage (scope based)
+//------------------------------------------------------------------------
+class StageTimer {
+public:
+    explicit StageTimer(StageResult& stage)
+        : stage_(stage),
+          allocations_(g_allocations.load(std::memory_order_relaxed)),
+          bytes_(g_allocatedBytes.load(std::memory_order_relaxed)),
+          start_(std::chrono::steady_clock::now()) {}
+
+    // Stop the clock and book audioSeconds of output
+    void finish(double audioSeconds) {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        const int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        stage_.latency.record(micros);
+        stage_.wallSeconds += std::chrono::duration<double>(elapsed).count();
+        stage_.audioSeconds += audioSeconds;
+        stage_.allocations += g_allocations.load(std::memory_order_relaxed) - allocations_;
+        stage_.allocatedBytes += g_allocatedBytes.load(std::memory_order_relaxed) - bytes_;
+        ++stage_.calls;
+    }
+
+private:
+    StageResult& stage_;
+    uint64_t allocations_;
+    uint64_t bytes_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+//------------------------------------------------------------------------
+struct BenchOptions {
+    std::string mappingPath = "example_mapping.xml";
+    std::string engine;          // Empty: use the mapping's <TTS engine>
+    std::string jsonPath;
+    int lowNote = 36;
+    int highNote = 84;
+    int noteStep = 4;
+    int outputRate = 48000;
+    int repeat = 1;
+    int threads = 0;             // Analysis pool size (0: World runs serially)
+    bool batch = false;          // WorldPitchShifter::analyzeBatch per pass
+    bool synthetic = false;
+};
+
+//------------------------------------------------------------------------
+// Voiced stand-in for eSpeak output: harmonics of a gliding F0 with a
+// syllable-shaped envelope. Length grows with the text like speech does.
+//------------------------------------------------------------------------
+std::vector<float> syntheticSyllable(const std::string& text, int sampleRate) {
+    const double seconds = 0.15 + 0.06 * static_cast<double>(text.size());
+    const size_t length = static_cast<size_t>(seconds * sampleRate);
+    std::vector<float> samples(length);
+
+    const double pi = std::acos(-1.0);
+    double phase = 0.0;
+    for (size_t i = 0; i < length; ++i) {
+        const double t = static_cast<double>(i) / length;
+        const double f0 = 110.0 + 30.0 * t + 3.0 * std::sin(2.0 * pi * 5.0 * i / sampleRate);
+        phase += 2.0 * pi * f0 / sampleRate;
+
+        double value = 0.0;
+        for (int h = 1; h <= 12; ++h) {
+            value += std::sin(h * phase) / h;
+        }
+        const double envelope = std::sin(pi * t);
+        samples[i] = static_cast<float>(0.25 * envelope * value);
+    }
+    return samples;
+}
+
+//------------------------------------------------------------------------
+void printHelp() {
+    std::cout << "Usage: ftvox_bench [options] [mapping.xml]\n";
+    std::cout << "\nOptions:\n";
+    std::cout << "  --low <note>      First note of the sweep (default 36)\n";
+    std::cout << "  --high <note>     Last note of the sweep (default 84)\n";
+    std::cout << "  --step <n>        Semitones between notes (default 4)\n";
+    std::cout << "  --engine <name>   world or fast (default: the mapping's engine)\n";
+    std::cout << "  --rate <hz>       Output sample rate (default 48000)\n";
+    std::cout << "  --repeat <n>      Passes over the whole sweep (default 1)\n";
+    std::cout << "  --threads <n>     Threads for World analysis (default 0 = serial)\n";
+    std::cout << "  --batch           Analyze all syllables of a pass in one batch\n";
+    std::cout << "  --synthetic       Use a generated test signal instead of eSpeak\n";
+    std::cout << "  --json <file|->   Write results as JSON ('-' for stdout)\n";
+}
+
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            printHelp();
+            return false;
+        } else if (arg == "--low" && hasValue) {
+            options.lowNote = std::atoi(argv[++i]);
+        } else if (arg == "--high" && hasValue) {
+            options.highNote = std::atoi(argv[++i]);
+        } else if (arg == "--step" && hasValue) {
+            options.noteStep = (std::max)(1, std::atoi(argv[++i]));
+        } else if (arg == "--engine" && hasValue) {
+            options.engine = argv[++i];
+        } else if (arg == "--rate" && hasValue) {
+            options.outputRate = (std::max)(8000, std::atoi(argv[++i]));
+        } else if (arg == "--repeat" && hasValue) {
+            options.repeat = (std::max)(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = (std::max)(0, std::atoi(argv[++i]));
+        } else if (arg == "--batch") {
+            options.batch = true;
+        } else if (arg == "--json" && hasValue) {
+            options.jsonPath = argv[++i];
+        } else if (arg == "--synthetic") {
+            options.synthetic = true;
+        } else if (arg[0] != '-') {
+            options.mappingPath = arg;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printHelp();
+            return false;
+        }
+    }
+
+    options.lowNote = (std::max)(0, (std::min)(127, options.lowNote));
+    options.highNote = (std::max)(options.lowNote, (std::min)(127, options.highNote));
+    return true;
+}
+
+//------------------------------------------------------------------------
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::string toJson(const BenchOptions& options, const std::string& engine, const std::string& source,
+                   int ttsRate, size_t syllables, size_t notes, const std::vector<StageResult*>& stages) {
+    char line[512];
+    std::string json = "{\n";
+    json += "  \"mapping\": \"" + jsonEscape(options.mappingPath) + "\",\n";
+    json += "  \"engine\": \"" + jsonEscape(engine) + "\",\n";
+    json += "  \"source\": \"" + source + "\",\n";
+    std::snprintf(line, sizeof(line),
+                  "  \"ttsRate\": %d,\n  \"outputRate\": %d,\n  \"syllables\": %zu,\n  \"notes\": %zu,\n  \"repeat\": %d,\n"
+                  "  \"threads\": %d,\n  \"batch\": %s,\n",
+                  ttsRate, options.outputRate, syllables, notes, options.repeat, options.threads,
+                  options.batch ? "true" : "false");
+    json += line;
+    json += "  \"stages\": [\n";
+
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const StageResult& stage = *stages[i];
+        const LatencySummary summary = stage.latency.summarize();
+        const double calls = static_cast<double>(stage.calls > 0 ? stage.calls : 1);
+        std::snprintf(line, sizeof(line),
+                      "    {\"name\": \"%s\", \"calls\": %llu, \"wallSeconds\": %.6f, \"audioSeconds\": %.6f, "
+                      "\"realtimeFactor\": %.3f, \"allocsPerCall\": %.2f, \"bytesPerCall\": %.0f, "
+                      "\"p50Ms\": %.3f, \"p99Ms\": %.3f, \"maxMs\": %.3f}%s\n",
+                      stage.name, static_cast<unsigned long long>(stage.calls), stage.wallSeconds,
+                      stage.audioSeconds, stage.realtimeFactor(), stage.allocations / calls,
+                      stage.allocatedBytes / calls, summary.p50Micros / 1000.0, summary.p99Micros / 1000.0,
+                      summary.maxMicros / 1000.0, i + 1 < stages.size() ? "," : "");
+        json += line;
+    }
+
+    json += "  ]\n}\n";
+    return json;
+}
+
+void printTable(const std::vector<StageResult*>& stages) {
+    std::printf("\n%-12s %8s %10s %10s %10s %9s %9s %9s\n",
+                "stage", "calls", "x realtime", "allocs", "KB/call", "p50 ms", "p99 ms", "max ms");
+    for (const StageResult* stage : stages) {
+        const LatencySummary summary = stage->latency.summarize();
+        const double calls = static_cast<double>(stage->calls > 0 ? stage->calls : 1);
+        std::printf("%-12s %8llu %10.1f %10.1f %10.1f %9.2f %9.2f %9.2f\n",
+                    stage->name, static_cast<unsigned long long>(stage->calls), stage->realtimeFactor(),
+                    stage->allocations / calls, stage->allocatedBytes / calls / 1024.0,
+                    summary.p50Micros / 1000.0, summary.p99Micros / 1000.0, summary.maxMicros / 1000.0);
+    }
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------
+// Main
+//------------------------------------------------------------------------
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    // JSON on stdout must not be mixed with progress output
+    std::ostream& log = options.jsonPath == "-" ? std::cerr : std::cout;
+
+    MappingConfig config;
+    if (!config.loadFromFile(options.mappingPath)) {
+        std::cerr << "Failed to load " << options.mappingPath << ": " << config.getLastError() << "\n";
+        return 1;
+    }
+    const auto& syllables = config.getSyllables();
+    if (syllables.empty()) {
+        std::cerr << "No syllables in " << options.mappingPath << "\n";
+        return 1;
+    }
+
+    const std::string engine = options.engine.empty() ? config.getTTSConfig().engine : options.engine;
+    const bool fast = PitchShifter::engineFromString(engine) == PitchEngine::Fast;
+
+    // eSpeak, or the synthetic stand-in
+    ESpeakSynthesizer tts;
+    int ttsRate = 22050;
+    bool useTts = false;
+    if (!options.synthetic) {
+        if (tts.initialize(ttsRate)) {
+            const auto& ttsConfig = config.getTTSConfig();
+            ttsRate = tts.getSampleRate();
+            tts.setVoice(ttsConfig.voice);
+            tts.setRate(ttsConfig.rate);
+            tts.setPitch(ttsConfig.pitch);
+            tts.setVolume(ttsConfig.volume);
+            useTts = true;
+        } else {
+            log << "eSpeak unavailable (" << tts.getLastError() << "), using a synthetic source\n";
+        }
+    }
+
+    ThreadPool analysisPool;
+    WorldPitchShifter world;
+    PsolaPitchShifter psola;
+    world.initialize(ttsRate);
+    psola.initialize(ttsRate);
+    if (options.threads > 0) {
+        analysisPool.start(static_cast<size_t>(options.threads));
+        world.setThreadPool(&analysisPool);
+    }
+
+    std::vector<int> notes;
+    for (int note = options.lowNote; note <= options.highNote; note += options.noteStep) {
+        notes.push_back(note);
+    }
+
+    log << "Benchmarking " << syllables.size() << " syllables x " << notes.size() << " notes ("
+        << (fast ? "PSOLA" : "World") << ", " << ttsRate << " -> " << options.outputRate << " Hz, "
+        << options.repeat << " pass" << (options.repeat > 1 ? "es" : "")
+        << (options.threads > 0 ? ", " + std::to_string(options.threads) + " analysis threads" : std::string())
+        << (options.batch && !fast ? ", batched analysis" : "") << ")\n";
+
+    StageResult speak, analysis, synthesis, resample, total;
+    speak.name = "speak";
+    analysis.name = "analysis";
+    synthesis.name = "synthesis";
+    resample.name = "resample";
+    total.name = "total";
+
+    Resampler resampler;
+    for (int pass = 0; pass < options.repeat; ++pass) {
+        // eSpeak output does not depend on the note: once per syllable
+        std::vector<std::vector<float>> sources(syllables.size());
+        double sourceSeconds = 0.0;
+        for (size_t i = 0; i < syllables.size(); ++i) {
+            StageTimer speakTimer(speak);
+            if (useTts) {
+                tts.stop();
+                tts.speak(syllables[i].text);
+                sources[i] = tts.getAudioSamples();
+            } else {
+                sources[i] = syntheticSyllable(syllables[i].text, ttsRate);
+            }
+            const double seconds = static_cast<double>(sources[i].size()) / ttsRate;
+            speakTimer.finish(seconds);
+            sourceSeconds += seconds;
+        }
+
+        // World analysis is shared by every note of the syllable (as in the
+        // plugin); a batch counts as one call
+        std::vector<WorldAnalysis> analyses(syllables.size());
+        if (!fast && options.batch) {
+            StageTimer analysisTimer(analysis);
+            analyses = world.analyzeBatch(sources, world.getAnalysisSettings());
+            analysisTimer.finish(sourceSeconds);
+        } else if (!fast) {
+            for (size_t i = 0; i < syllables.size(); ++i) {
+                if (sources[i].empty()) {
+                    continue;
+                }
+                StageTimer analysisTimer(analysis);
+                analyses[i] = world.analyze(sources[i]);
+                analysisTimer.finish(static_cast<double>(sources[i].size()) / ttsRate);
+            }
+        }
+
+        for (size_t i = 0; i < syllables.size(); ++i) {
+            const std::vector<float>& source = sources[i];
+            if (source.empty()) {
+                continue;
+            }
+
+            for (int note : notes) {
+                StageTimer totalTimer(total);
+                const double ratio = PitchShifter::frequencyToRatio(PitchShifter::midiNoteToFrequency(note));
+
+                StageTimer synthesisTimer(synthesis);
+                std::vector<float> shifted = fast ? psola.shift(source, ratio) : world.synthesize(analyses[i], ratio);
+                synthesisTimer.finish(static_cast<double>(shifted.size()) / ttsRate);
+
+                StageTimer resampleTimer(resample);
+                resampler.setRates(ttsRate, options.outputRate);
+                std::vector<float> output = resampler.processAll(shifted);
+                const double outputSeconds = static_cast<double>(output.size()) / options.outputRate;
+                resampleTimer.finish(outputSeconds);
+
+                totalTimer.finish(outputSeconds);
+            }
+        }
+    }
+
+    std::vector<StageResult*> stages = {&speak, &synthesis, &resample, &total};
+    if (!fast) {
+        stages.insert(stages.begin() + 1, &analysis);
+    }
+
+    if (options.jsonPath != "-") {
+        printTable(stages);
+    }
+
+    if (!options.jsonPath.empty()) {
+        const std::string json = toJson(options, fast ? "fast" : "world", useTts ? "espeak" : "synthetic",
+                                        ttsRate, syllables.size(), notes.size(), stages);
+        if (options.jsonPath == "-") {
+            std::cout << json;
+        } else {
+            FILE* file = std::fopen(options.jsonPath.c_str(), "wb");
+            if (!file) {
+                std::cerr << "Cannot write " << options.jsonPath << "\n";
+                return 1;
+            }
+            std::fwrite(json.data(), 1, json.size(), file);
+            std::fclose(file);
+            log << "Wrote " << options.jsonPath << "\n";
+        }
+    }
+
+    return 0;
+}
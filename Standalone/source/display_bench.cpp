@@ -0,0 +1,383 @@
+//------------------------------------------------------------------------
+// FT-Vox display benchmark
+//
+// Renders every effect type (each ramp direction separately), the light
+// organ with a growing number of held keys and sprite text at scales 1-5
+// on displays from 45x35 to 512x256, and reports frames/sec of render +
+// packet send, with p50/p99 frame times.
+//
+// By default frames go to the client's null sink: the whole packet path
+// (header, delta diffing, tiling) runs but nothing reaches a socket. With
+// --udp the frames are sent to a (local) ft-server instead, measuring the
+// end-to-end frame throughput including the network stack.
+//
+// Command line:
+//   ftvox_display_bench [options]
+//   --frames <n>           Frames per case (default 240)
+//   --size <WxH>           Only this display size
+//   --udp <host[:port]>    Send to a server instead of the null sink
+//   --delta / --tiled      Enable the client's delta or tiled mode
+//   --json <file|->        Write results as JSON
+//------------------------------------------------------------------------
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Include FlaschenTaschen library sources
+#include "../../FlaschenTaschen/source/MappingBinary.h"
+#include "../../FlaschenTaschen/source/MappingBinary.cpp"
+#include "../../FlaschenTaschen/source/MappingConfig.h"
+#include "../../FlaschenTaschen/source/MappingConfig.cpp"
+#include "../../FlaschenTaschen/source/FlaschenTaschenClient.h"
+#include "../../FlaschenTaschen/source/FlaschenTaschenClient.cpp"
+#include "../../FlaschenTaschen/source/FrameKernels.h"
+#include "../../FlaschenTaschen/source/FrameKernels.cpp"
+#include "../../FlaschenTaschen/source/BitmapFont.h"
+#include "../../FlaschenTaschen/source/BitmapFont.cpp"
+#include "../../FlaschenTaschen/source/PixelKernels.h"
+#include "../../FlaschenTaschen/source/PixelKernels.cpp"
+#include "../../FlaschenTaschen/source/VisualEffects.h"
+#include "../../FlaschenTaschen/source/VisualEffects.cpp"
+#include "../../FlaschenTaschen/source/EffectFrameCache.h"
+#include "../../FlaschenTaschen/source/EffectFrameCache.cpp"
+#include "../../FlaschenTaschen/source/EffectClip.h"
+#include "../../FlaschenTaschen/source/EffectClip.cpp"
+#include "../../FlaschenTaschen/source/FrameCapture.h"
+#include "../../FlaschenTaschen/source/FrameCapture.cpp"
+#include "../../FlaschenTaschen/source/LatencyStats.h"
+#include "../../FlaschenTaschen/source/LatencyStats.cpp"
+
+using namespace FlaschenTaschen;
+
+namespace {
+
+constexpr double kFrameMs = 1000.0 / 60.0;     // Simulated display timeline
+constexpr int kEffectDurationMs = 600000;      // Effects never finish during a case
+
+//------------------------------------------------------------------------
+struct DisplaySize {
+    int width;
+    int height;
+};
+
+const DisplaySize kDisplaySizes[] = {{45, 35}, {64, 32}, {128, 64}, {256, 128}, {512, 256}};
+
+//------------------------------------------------------------------------
+struct BenchOptions {
+    int frames = 240;
+    std::vector<DisplaySize> sizes;
+    std::string host;           // Empty: null sink
+    int port = 1337;
+    bool delta = false;
+    bool tiled = false;
+    std::string jsonPath;
+};
+
+//------------------------------------------------------------------------
+// CaseResult - one scene on one display size
+//------------------------------------------------------------------------
+struct CaseResult {
+    std::string name;
+    DisplaySize size{};
+    int frames = 0;
+    int failedSends = 0;
+    double renderSeconds = 0.0;
+    double sendSeconds = 0.0;
+    uint64_t bytesSent = 0;
+    LatencySummary frameTime;   // Render + send per frame
+
+    double framesPerSecond() const {
+        const double total = renderSeconds + sendSeconds;
+        return total > 0.0 ? frames / total : 0.0;
+    }
+};
+
+// Draws frame n of a scene into the client
+using RenderScene = std::function<void(FlaschenTaschenClient& client, int frame)>;
+
+struct Scene {
+    std::string name;
+    std::function<RenderScene()> create;   // Fresh state per display size
+};
+
+//------------------------------------------------------------------------
+Effect makeEffect(EffectType type, RampDirection direction = RampDirection::Horizontal) {
+    Effect effect;
+    effect.id = 0;
+    effect.type = type;
+    effect.color1R = 255; effect.color1G = 80;  effect.color1B = 0;
+    effect.color2R = 0;   effect.color2G = 40;  effect.color2B = 255;
+    effect.durationMs = kEffectDurationMs;
+    effect.periodMs = 250;
+    effect.rampDirection = direction;
+    return effect;
+}
+
+Scene effectScene(const std::string& name, const Effect& effect) {
+    return {name, [effect]() -> RenderScene {
+        auto effects = std::make_shared<VisualEffects>();
+        effects->startEffectAt(effect, 127, 0.0);
+        return [effects](FlaschenTaschenClient& client, int frame) {
+            effects->updateAt(client, frame * kFrameMs);
+        };
+    }};
+}
+
+Scene organScene(int keys) {
+    return {"organ " + std::to_string(keys) + " keys", [keys]() -> RenderScene {
+        auto organ = std::make_shared<PolyLightOrgan>();
+        organ->setRainbowMode(true);
+        for (int k = 0; k < keys; ++k) {
+            organ->noteOn(21 + k, 100);
+        }
+        return [organ, keys](FlaschenTaschenClient& client, int frame) {
+            // Moving pressure so every frame's columns differ
+            for (int k = 0; k < keys; ++k) {
+                organ->aftertouch(21 + k, (frame * 3 + k * 11) % 128);
+            }
+            organ->render(client);
+        };
+    }};
+}
+
+Scene textScene(int scale) {
+    return {"text scale " + std::to_string(scale), [scale]() -> RenderScene {
+        static const std::vector<std::string> kWords = {"the", "strato", "jets", "are", "next", "hot"};
+        auto font = std::make_shared<BitmapFont>();
+        font->setScale(scale);
+        font->setSpriteColors(Color(255, 200, 0), Color::Black());
+        font->setSpriteTexts(kWords);
+        return [font](FlaschenTaschenClient& client, int frame) {
+            client.clear(Color::Black());
+            font->renderSpriteCenteredFull(client, kWords[frame % kWords.size()], Color(255, 200, 0), Color::Black());
+        };
+    }};
+}
+
+std::vector<Scene> makeScenes() {
+    std::vector<Scene> scenes;
+    scenes.push_back(effectScene("solid", makeEffect(EffectType::SolidColor)));
+
+    const std::pair<const char*, RampDirection> ramps[] = {
+        {"ramp horizontal", RampDirection::Horizontal},
+        {"ramp vertical", RampDirection::Vertical},
+        {"ramp diag down", RampDirection::DiagonalDown},
+        {"ramp diag up", RampDirection::DiagonalUp},
+        {"ramp radial", RampDirection::Radial},
+    };
+    for (const auto& ramp : ramps) {
+        scenes.push_back(effectScene(ramp.first, makeEffect(EffectType::ColorRamp, ramp.second)));
+    }
+
+    scenes.push_back(effectScene("pulse", makeEffect(EffectType::Pulse)));
+    scenes.push_back(effectScene("rainbow", makeEffect(EffectType::Rainbow)));
+    scenes.push_back(effectScene("flash", makeEffect(EffectType::Flash)));
+    scenes.push_back(effectScene("strobe", makeEffect(EffectType::Strobe)));
+    scenes.push_back(effectScene("wave", makeEffect(EffectType::Wave)));
+    scenes.push_back(effectScene("sparkle", makeEffect(EffectType::Sparkle)));
+
+    for (int keys : {1, 8, 32, 88}) {
+        scenes.push_back(organScene(keys));
+    }
+    for (int scale = 1; scale <= 5; ++scale) {
+        scenes.push_back(textScene(scale));
+    }
+    return scenes;
+}
+
+//------------------------------------------------------------------------
+CaseResult runCase(const Scene& scene, const DisplaySize& size, const BenchOptions& options,
+                   FlaschenTaschenClient& client) {
+    using Clock = std::chrono::steady_clock;
+
+    client.setDisplaySize(size.width, size.height);
+    client.invalidate();
+    RenderScene render = scene.create();
+
+    CaseResult result;
+    result.name = scene.name;
+    result.size = size;
+    result.frames = options.frames;
+
+    LatencyHistogram frameTimes;
+    const uint64_t bytesBefore = client.getBytesSent();
+    for (int frame = 0; frame < options.frames; ++frame) {
+        const auto start = Clock::now();
+        render(client, frame);
+        const auto rendered = Clock::now();
+        if (!client.send()) {
+            ++result.failedSends;
+        }
+        const auto sent = Clock::now();
+
+        result.renderSeconds += std::chrono::duration<double>(rendered - start).count();
+        result.sendSeconds += std::chrono::duration<double>(sent - rendered).count();
+        frameTimes.record(std::chrono::duration_cast<std::chrono::microseconds>(sent - start).count());
+    }
+
+    result.bytesSent = client.getBytesSent() - bytesBefore;
+    result.frameTime = frameTimes.summarize();
+    return result;
+}
+
+//------------------------------------------------------------------------
+void printHelp() {
+    std::cout << "Usage: ftvox_display_bench [options]\n";
+    std::cout << "\nOptions:\n";
+    std::cout << "  --frames <n>          Frames per case (default 240)\n";
+    std::cout << "  --size <WxH>          Only this display size (default: 45x35 .. 512x256)\n";
+    std::cout << "  --udp <host[:port]>   Send frames to an ft-server (default: null sink)\n";
+    std::cout << "  --delta               Send changed regions only\n";
+    std::cout << "  --tiled               Split frames into MTU-sized packets\n";
+    std::cout << "  --json <file|->       Write results as JSON ('-' for stdout)\n";
+}
+
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            printHelp();
+            return false;
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = (std::max)(1, std::atoi(argv[++i]));
+        } else if (arg == "--size" && hasValue) {
+            DisplaySize size{};
+            if (std::sscanf(argv[++i], "%dx%d", &size.width, &size.height) != 2 ||
+                size.width <= 0 || size.height <= 0) {
+                std::cerr << "Invalid size: " << argv[i] << "\n";
+                return false;
+            }
+            options.sizes.push_back(size);
+        } else if (arg == "--udp" && hasValue) {
+            options.host = argv[++i];
+            const size_t colon = options.host.find(':');
+            if (colon != std::string::npos) {
+                options.port = std::atoi(options.host.c_str() + colon + 1);
+                options.host.resize(colon);
+            }
+        } else if (arg == "--delta") {
+            options.delta = true;
+        } else if (arg == "--tiled") {
+            options.tiled = true;
+        } else if (arg == "--json" && hasValue) {
+            options.jsonPath = argv[++i];
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printHelp();
+            return false;
+        }
+    }
+
+    if (options.sizes.empty()) {
+        options.sizes.assign(std::begin(kDisplaySizes), std::end(kDisplaySizes));
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+std::string toJson(const BenchOptions& options, const std::vector<CaseResult>& results) {
+    char line[512];
+    std::string json = "{\n";
+    json += "  \"sink\": \"" + (options.host.empty() ? std::string("null") : options.host + ":" + std::to_string(options.port)) + "\",\n";
+    std::snprintf(line, sizeof(line), "  \"frames\": %d,\n  \"delta\": %s,\n  \"tiled\": %s,\n",
+                  options.frames, options.delta ? "true" : "false", options.tiled ? "true" : "false");
+    json += line;
+    json += "  \"cases\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const CaseResult& r = results[i];
+        std::snprintf(line, sizeof(line),
+                      "    {\"name\": \"%s\", \"width\": %d, \"height\": %d, \"fps\": %.1f, "
+                      "\"renderMs\": %.4f, \"sendMs\": %.4f, \"bytesPerFrame\": %.0f, "
+                      "\"p50Ms\": %.3f, \"p99Ms\": %.3f, \"maxMs\": %.3f, \"failedSends\": %d}%s\n",
+                      r.name.c_str(), r.size.width, r.size.height, r.framesPerSecond(),
+                      r.renderSeconds * 1000.0 / r.frames, r.sendSeconds * 1000.0 / r.frames,
+                      static_cast<double>(r.bytesSent) / r.frames, r.frameTime.p50Micros / 1000.0,
+                      r.frameTime.p99Micros / 1000.0, r.frameTime.maxMicros / 1000.0, r.failedSends,
+                      i + 1 < results.size() ? "," : "");
+        json += line;
+    }
+
+    json += "  ]\n}\n";
+    return json;
+}
+
+void printResult(const CaseResult& r) {
+    char sizeText[16];
+    std::snprintf(sizeText, sizeof(sizeText), "%dx%d", r.size.width, r.size.height);
+    std::printf("%-18s %-8s %10.0f %10.3f %10.3f %10.1f %9.3f %s\n",
+                r.name.c_str(), sizeText, r.framesPerSecond(),
+                r.renderSeconds * 1000.0 / r.frames, r.sendSeconds * 1000.0 / r.frames,
+                static_cast<double>(r.bytesSent) / r.frames / 1024.0, r.frameTime.p99Micros / 1000.0,
+                r.failedSends > 0 ? "(send errors)" : "");
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------
+// Main
+//------------------------------------------------------------------------
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    FlaschenTaschenClient client;
+    if (options.host.empty()) {
+        client.setNullSink(true);
+    } else if (!client.connect(options.host, options.port)) {
+        std::cerr << "Failed to connect to " << options.host << ":" << options.port << ": "
+                  << client.getLastError() << "\n";
+        return 1;
+    }
+    client.setDeltaMode(options.delta);
+    client.setTiledMode(options.tiled);
+
+    const bool tableOutput = options.jsonPath != "-";
+    if (tableOutput) {
+        std::printf("%-18s %-8s %10s %10s %10s %10s %9s\n",
+                    "case", "size", "frames/s", "render ms", "send ms", "KB/frame", "p99 ms");
+    }
+
+    std::vector<CaseResult> results;
+    for (const Scene& scene : makeScenes()) {
+        for (const DisplaySize& size : options.sizes) {
+            results.push_back(runCase(scene, size, options, client));
+            if (tableOutput) {
+                printResult(results.back());
+            }
+        }
+    }
+
+    if (!options.jsonPath.empty()) {
+        const std::string json = toJson(options, results);
+        if (options.jsonPath == "-") {
+            std::cout << json;
+        } else {
+            FILE* file = std::fopen(options.jsonPath.c_str(), "wb");
+            if (!file) {
+                std::cerr << "Cannot write " << options.jsonPath << "\n";
+                return 1;
+            }
+            std::fwrite(json.data(), 1, json.size(), file);
+            std::fclose(file);
+            std::cout << "Wrote " << options.jsonPath << "\n";
+        }
+    }
+
+    client.disconnect();
+    return 0;
+}
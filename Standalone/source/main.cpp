@@ -1,7 +1,8 @@
 //------------------------------------------------------------------------
 // FlaschenTaschen Standalone Test Application
 //
-// Tests: XML parsing, FlaschenTaschen UDP client, eSpeak TTS, WASAPI audio
+// Tests: XML parsing, FlaschenTaschen UDP client, eSpeak TTS, audio output
+// (WASAPI, ALSA, JACK or CoreAudio, see <Audio backend>)
 //
 // Keyboard controls:
 //   Keys A-Z map to MIDI notes 60-85 (C4-C#6)
@@ -10,37 +11,74 @@
 //
 // Command line:
 //   -l          List available audio and MIDI devices
-//   <file.xml>  Load configuration from XML file
+//   -c <in.xml> <out.ftmap>  Compile an XML mapping to the binary format
+//   -r <capture.ftcap> [ip[:port]]  Replay a <Display capture> recording
+//   -d          Headless: no console, notes over OSC / RTP-MIDI (<Network>)
+//   -v          Log every note (the default unless headless)
+//   <file.xml>  Load configuration from XML (or compiled .ftmap) file
 //------------------------------------------------------------------------
 
+#ifdef _WIN32
 #ifndef NOMINMAX
 #define NOMINMAX
 #endif
 #include <windows.h>
-#include <conio.h>
+#endif
 #include <iostream>
 #include <string>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <queue>
 #include <cmath>
 
-#include "WasapiAudio.h"
-#include "MidiInput.h"
+#include "AudioOutput.h"
+#include "MidiSource.h"
+#include "EventLoop.h"
+#include "NetworkMidiInput.h"
 
 // Include shared sources from VST plugin
+#include "../../FlaschenTaschen/source/MappingBinary.h"
+#include "../../FlaschenTaschen/source/MappingBinary.cpp"
 #include "../../FlaschenTaschen/source/MappingConfig.h"
 #include "../../FlaschenTaschen/source/MappingConfig.cpp"
 #include "../../FlaschenTaschen/source/FlaschenTaschenClient.h"
 #include "../../FlaschenTaschen/source/FlaschenTaschenClient.cpp"
+#include "../../FlaschenTaschen/source/FrameKernels.h"
+#include "../../FlaschenTaschen/source/FrameKernels.cpp"
+#include "../../FlaschenTaschen/source/FrameLimiter.h"
+#include "../../FlaschenTaschen/source/LockFreeQueue.h"
 #include "../../FlaschenTaschen/source/BitmapFont.h"
 #include "../../FlaschenTaschen/source/BitmapFont.cpp"
+#include "../../FlaschenTaschen/source/ESpeakService.h"
+#include "../../FlaschenTaschen/source/ESpeakService.cpp"
 #include "../../FlaschenTaschen/source/ESpeakSynthesizer.h"
 #include "../../FlaschenTaschen/source/ESpeakSynthesizer.cpp"
+#include "../../FlaschenTaschen/source/PitchShifter.h"
+#include "../../FlaschenTaschen/source/PitchShifter.cpp"
+#include "../../FlaschenTaschen/source/PsolaPitchShifter.h"
+#include "../../FlaschenTaschen/source/PsolaPitchShifter.cpp"
 #include "../../FlaschenTaschen/source/WorldPitchShifter.h"
 #include "../../FlaschenTaschen/source/WorldPitchShifter.cpp"
+#include "../../FlaschenTaschen/source/PixelKernels.h"
+#include "../../FlaschenTaschen/source/PixelKernels.cpp"
+#include "../../FlaschenTaschen/source/Compositor.h"
+#include "../../FlaschenTaschen/source/Compositor.cpp"
 #include "../../FlaschenTaschen/source/VisualEffects.h"
 #include "../../FlaschenTaschen/source/VisualEffects.cpp"
+#include "../../FlaschenTaschen/source/EffectFrameCache.h"
+#include "../../FlaschenTaschen/source/EffectFrameCache.cpp"
+#include "../../FlaschenTaschen/source/EffectClip.h"
+#include "../../FlaschenTaschen/source/EffectClip.cpp"
+#include "../../FlaschenTaschen/source/FrameCapture.h"
+#include "../../FlaschenTaschen/source/FrameCapture.cpp"
+#include "../../FlaschenTaschen/source/AudioRingBuffer.h"
+#include "../../FlaschenTaschen/source/Resampler.h"
+#include "../../FlaschenTaschen/source/Resampler.cpp"
+#include "../../FlaschenTaschen/source/ThreadPool.h"
+#include "../../FlaschenTaschen/source/ThreadPool.cpp"
+#include "../../FlaschenTaschen/source/LatencyStats.h"
+#include "../../FlaschenTaschen/source/LatencyStats.cpp"
 
 using namespace FlaschenTaschen;
 
@@ -48,57 +86,117 @@ using namespace FlaschenTaschen;
 // Global state
 //------------------------------------------------------------------------
 std::atomic<bool> g_running{true};
-std::mutex g_ttsBufferMutex;
-std::vector<float> g_ttsAudioBuffer;
+AudioRingBuffer g_ttsAudioBuffer;  // Read lock-free by the audio callback
+std::mutex g_ttsWriteMutex;        // Serializes producers (keyboard + MIDI threads)
 
 MappingConfig g_config;
 FlaschenTaschenClient g_ftClient;
+FrameCapture g_capture;     // <Display capture>
 BitmapFont g_font;
+TextMarquee g_marquee;      // Syllables wider than the display (main thread)
 ESpeakSynthesizer g_tts;
 WorldPitchShifter g_pitchShifter;
-MidiInput g_midiInput;
+PsolaPitchShifter g_fastShifter;   // <TTS engine="fast">
+std::unique_ptr<MidiSource> g_midiInput;  // Backend chosen with <Audio backend>
 VisualEffects g_visualEffects;
 PolyLightOrgan g_lightOrgan;      // Polyphonic light organ mode
 bool g_pitchShiftEnabled = true;  // Enable/disable pitch shifting
 int g_octaveOffset = 0;           // Octave shift (-3 to +3)
 bool g_effectsEnabled = true;     // Enable/disable visual effects
-bool g_lightOrganMode = false;    // Light organ mode (bypasses syllables/effects)
+bool g_lightOrganMode = false;    // Light organ mode (notes play the organ, not syllables/effects)
+LatencyStats g_latency;           // Per-stage timings, printed with 'I'
+std::atomic<int64_t> g_noteMicros{0};  // Last note's trigger time until its first sample plays
 
 // Sample rate conversion
 int g_ttsSampleRate = 22050;  // eSpeak default
-int g_outputSampleRate = 48000;  // Will be set from WASAPI
-
-// Simple linear resampler
-std::vector<float> resample(const std::vector<float>& input, int inputRate, int outputRate) {
-    if (inputRate == outputRate || input.empty()) {
-        return input;
+int g_outputSampleRate = 48000;  // Will be set from the audio backend
+
+// Audio timeline, published by the audio callback (seqlock): frames output
+// before the current block and when that block started
+std::atomic<uint32_t> g_clockSequence{0};
+std::atomic<int64_t> g_clockFrames{0};
+std::atomic<int64_t> g_clockMicros{0};
+int g_lookAheadFrames = 0;  // <TTS lookAheadMs>: notes start this long after they came in
+
+// Where a note starts: when the FIFO read position reaches fifoPos, the
+// audio callback holds silence until output frame `frame`
+struct NoteOnset {
+    size_t fifoPos = 0;
+    int64_t frame = 0;
+};
+LockFreeQueue<NoteOnset, 64> g_noteOnsets;  // Writers hold g_ttsWriteMutex
+
+// Output frame playing at steady clock time micros (false before audio runs)
+bool audioFrameAt(int64_t micros, int64_t& frame) {
+    uint32_t before;
+    int64_t anchorFrames;
+    int64_t anchorMicros;
+    do {
+        before = g_clockSequence.load(std::memory_order_acquire);
+        anchorFrames = g_clockFrames.load(std::memory_order_relaxed);
+        anchorMicros = g_clockMicros.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((before & 1) != 0 || before != g_clockSequence.load(std::memory_order_relaxed));
+
+    if (before == 0) {
+        return false;
     }
+    frame = anchorFrames + (micros - anchorMicros) * g_outputSampleRate / 1000000;
+    return true;
+}
 
-    double ratio = static_cast<double>(outputRate) / inputRate;
-    size_t outputSize = static_cast<size_t>(input.size() * ratio);
-    std::vector<float> output(outputSize);
-
-    for (size_t i = 0; i < outputSize; ++i) {
-        double srcPos = i / ratio;
-        size_t srcIndex = static_cast<size_t>(srcPos);
-        double frac = srcPos - srcIndex;
-
-        if (srcIndex + 1 < input.size()) {
-            // Linear interpolation
-            output[i] = static_cast<float>(input[srcIndex] * (1.0 - frac) + input[srcIndex + 1] * frac);
-        } else if (srcIndex < input.size()) {
-            output[i] = input[srcIndex];
-        } else {
-            output[i] = 0.0f;
-        }
+// Queue mono samples for playback (callable from any non-audio thread).
+// With an onset frame, the samples start exactly there, unless the FIFO
+// only reaches them later.
+void queueTTSAudio(const std::vector<float>& samples, int64_t onsetFrame = -1) {
+    std::lock_guard<std::mutex> lock(g_ttsWriteMutex);
+    if (onsetFrame >= 0) {
+        NoteOnset onset;
+        onset.fifoPos = g_ttsAudioBuffer.getWritePosition();
+        onset.frame = onsetFrame;
+        g_noteOnsets.push(onset);  // Full: the note just plays as soon as it can
+    }
+    size_t written = g_ttsAudioBuffer.write(samples.data(), samples.size());
+    if (written < samples.size()) {
+        std::cout << "    -> Playback buffer full, dropped " << (samples.size() - written) << " samples" << std::endl;
     }
-
-    return output;
 }
 
 // Current display state
 std::string g_currentSyllable;
 std::mutex g_displayMutex;
+std::atomic<bool> g_syllablePending{false};  // New syllable to show with the next frame
+FrameLimiter g_frameLimiter;                 // Main loop only, paced to <Display fps>
+
+// Display layers, bottom to top, composed into g_ftClient (main loop only)
+Compositor g_compositor;
+constexpr int kEffectsLayer = 0;   // Replace: last effect frame
+constexpr int kOrganLayer = 1;     // Add: light organ glows over the effect
+constexpr int kTextLayer = 2;      // Alpha: syllable, background keyed out
+bool g_layersChanged = false;      // A layer was switched on or off
+
+// Event loop: the main thread sleeps until console input, MIDI or the
+// next frame slot wakes it. MIDI sources only queue messages on the driver
+// thread; they are dispatched here. Synthesis runs on its own worker so
+// neither input nor frames wait for it.
+EventLoop g_eventLoop;                       // Woken by the MIDI source after each message
+ThreadPool g_synthWorker;                    // One thread: TTS, pitch shift, resample
+
+// Syllables queued on the synth worker; above the limit new ones are shown
+// but not spoken, so a flood of notes can't build up seconds of backlog
+constexpr int kMaxPendingSynth = 2;
+std::atomic<int> g_pendingSynth{0};
+std::atomic<int> g_skippedSynth{0};
+
+// Headless (--headless): no console, notes from <Network> and <Midi> only
+std::unique_ptr<NetworkMidiInput> g_networkInput;
+bool g_verbose = true;            // Per-note log lines (off headless unless -v)
+
+// Per-note log output, discarded unless verbose
+std::ostream& noteLog() {
+    static std::ostream discard(nullptr);
+    return g_verbose ? std::cout : discard;
+}
 
 //------------------------------------------------------------------------
 // Convert keyboard key to MIDI note (base note for syllable lookup)
@@ -129,32 +227,97 @@ int keyToMidiNote(int key) {
 // Handle effect trigger
 //------------------------------------------------------------------------
 void triggerEffect(int midiNote, const Effect* effect, int velocity = 127) {
-    std::cout << "  Note " << midiNote << " -> Effect: \"" << effect->name << "\" (";
+    std::ostream& log = noteLog();
+    log << "  Note " << midiNote << " -> Effect: \"" << effect->name << "\" (";
 
     switch (effect->type) {
-        case EffectType::SolidColor: std::cout << "solid"; break;
-        case EffectType::ColorRamp: std::cout << "ramp"; break;
-        case EffectType::Pulse: std::cout << "pulse"; break;
-        case EffectType::Rainbow: std::cout << "rainbow"; break;
-        case EffectType::Flash: std::cout << "flash"; break;
-        case EffectType::Strobe: std::cout << "strobe"; break;
-        case EffectType::Wave: std::cout << "wave"; break;
-        case EffectType::Sparkle: std::cout << "sparkle"; break;
-        default: std::cout << "unknown"; break;
-    }
-    std::cout << ") velocity=" << velocity << std::endl;
+        case EffectType::SolidColor: log << "solid"; break;
+        case EffectType::ColorRamp: log << "ramp"; break;
+        case EffectType::Pulse: log << "pulse"; break;
+        case EffectType::Rainbow: log << "rainbow"; break;
+        case EffectType::Flash: log << "flash"; break;
+        case EffectType::Strobe: log << "strobe"; break;
+        case EffectType::Wave: log << "wave"; break;
+        case EffectType::Sparkle: log << "sparkle"; break;
+        case EffectType::Clip: log << "clip"; break;
+        default: log << "unknown"; break;
+    }
+    log << ") velocity=" << velocity << std::endl;
 
     if (g_ftClient.isConnected() && g_effectsEnabled) {
         g_visualEffects.startEffect(*effect, velocity);
-        std::cout << "    -> Effect started (duration: " << effect->durationMs << "ms, brightness: "
+        log << "    -> Effect started (duration: " << effect->durationMs << "ms, brightness: "
                   << (velocity * 100 / 127) << "%)" << std::endl;
     }
 }
 
 //------------------------------------------------------------------------
-// Handle note trigger
+// Speak a syllable (synth worker): TTS, pitch shift to pitchNote (< 0 =
+// unshifted), resample, then queue for playback
+//------------------------------------------------------------------------
+void speakSyllable(const std::string& syllable, int pitchNote, int64_t noteMicros) {
+    if (!g_tts.isInitialized()) {
+        return;
+    }
+
+    // Render the syllable with eSpeak
+    const int64_t speakStart = LatencyStats::nowMicros();
+    g_tts.speak(syllable);
+    g_latency.recordSince(LatencyStage::Speak, speakStart);
+
+    // Copy generated audio to playback buffer
+    auto samples = g_tts.getAudioSamples();
+    if (!samples.empty()) {
+        // Apply pitch shifting based on MIDI note + octave offset
+        if (pitchNote >= 0) {
+            double targetFreq = PitchShifter::midiNoteToFrequency(pitchNote);
+            const double ratio = PitchShifter::frequencyToRatio(targetFreq);
+            if (PitchShifter::engineFromString(g_config.getTTSConfig().engine) == PitchEngine::Fast) {
+                const int64_t shiftStart = LatencyStats::nowMicros();
+                samples = g_fastShifter.shift(samples, ratio);
+                g_latency.recordSince(LatencyStage::Synthesis, shiftStart);
+            } else if (std::abs(ratio - 1.0) >= 0.001) {
+                // Analyze and synthesize separately so each World step is timed
+                WorldAnalysis analysis = g_pitchShifter.analyze(samples);
+                g_latency.record(LatencyStage::F0, analysis.f0Micros);
+                g_latency.record(LatencyStage::Spectrum, analysis.spectrumMicros);
+                g_latency.record(LatencyStage::Aperiodicity, analysis.aperiodicityMicros);
+
+                const int64_t synthesisStart = LatencyStats::nowMicros();
+                samples = g_pitchShifter.synthesize(analysis, ratio);
+                g_latency.recordSince(LatencyStage::Synthesis, synthesisStart);
+            }
+            noteLog() << "    -> Pitch shifted to " << targetFreq << " Hz (MIDI " << pitchNote << ")" << std::endl;
+        }
+
+        // Resample from TTS rate to output rate
+        if (g_ttsSampleRate != g_outputSampleRate) {
+            const int64_t resampleStart = LatencyStats::nowMicros();
+            Resampler resampler;
+            resampler.setRates(g_ttsSampleRate, g_outputSampleRate);
+            samples = resampler.processAll(samples);
+            g_latency.recordSince(LatencyStage::Resample, resampleStart);
+            noteLog() << "    -> Resampled " << g_ttsSampleRate << " -> " << g_outputSampleRate << " Hz" << std::endl;
+        }
+
+        // Sample-accurate onset: the note's own time plus the look-ahead
+        int64_t onsetFrame = -1;
+        if (g_lookAheadFrames > 0 && audioFrameAt(noteMicros, onsetFrame)) {
+            onsetFrame += g_lookAheadFrames;
+        } else {
+            onsetFrame = -1;
+        }
+
+        g_noteMicros = noteMicros;
+        queueTTSAudio(samples, onsetFrame);
+        noteLog() << "    -> TTS generated " << samples.size() << " samples" << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------
+// Handle note trigger (main loop); noteMicros is when the note came in
 //------------------------------------------------------------------------
-void triggerNote(int midiNote, int velocity = 127) {
+void triggerNote(int midiNote, int velocity = 127, int64_t noteMicros = LatencyStats::nowMicros()) {
     // First check if this note triggers an effect
     const Effect* effect = g_config.getEffectForNote(midiNote);
     if (effect) {
@@ -166,138 +329,257 @@ void triggerNote(int midiNote, int velocity = 127) {
     std::string syllable = g_config.getSyllableForNote(midiNote);
 
     if (syllable.empty()) {
-        std::cout << "  Note " << midiNote << " -> (not mapped)" << std::endl;
+        noteLog() << "  Note " << midiNote << " -> (not mapped)" << std::endl;
         return;
     }
 
-    std::cout << "  Note " << midiNote << " -> \"" << syllable << "\"" << std::endl;
+    noteLog() << "  Note " << midiNote << " -> \"" << syllable << "\"" << std::endl;
 
-    // Update current syllable
+    // Update current syllable; the main loop draws it with its next frame,
+    // so syllables superseded before then are never rendered or sent
     {
         std::lock_guard<std::mutex> lock(g_displayMutex);
         g_currentSyllable = syllable;
     }
-
-    // Send to FlaschenTaschen display
     if (g_ftClient.isConnected()) {
-        // Stop any running effect when showing text
-        g_visualEffects.stopEffect();
-
-        const auto& display = g_config.getDisplayConfig();
-        Color textColor(display.colorR, display.colorG, display.colorB);
-        Color bgColor(display.bgColorR, display.bgColorG, display.bgColorB);
-
-        g_ftClient.clear(bgColor);
-        g_font.renderTextCenteredFull(g_ftClient, syllable, textColor, bgColor);
-
-        if (g_ftClient.send()) {
-            std::cout << "    -> Sent to LED display" << std::endl;
-        }
-        else {
-            std::cout << "    -> Failed to send: " << g_ftClient.getLastError() << std::endl;
-        }
+        // Drawn over the running effect
+        g_syllablePending = true;
     }
 
-    // Speak via TTS with pitch shifting
-    if (g_tts.isInitialized()) {
-        // Get TTS audio synchronously
-        g_tts.speak(syllable);
-
-        // Copy generated audio to playback buffer
-        auto samples = g_tts.getAudioSamples();
-        if (!samples.empty()) {
-            // Apply pitch shifting based on MIDI note + octave offset
-            if (g_pitchShiftEnabled) {
-                int pitchNote = midiNote + (g_octaveOffset * 12);
-                if (pitchNote < 0) pitchNote = 0;
-                if (pitchNote > 127) pitchNote = 127;
-                double targetFreq = WorldPitchShifter::midiNoteToFrequency(pitchNote);
-                samples = g_pitchShifter.processToFrequency(samples, targetFreq);
-                std::cout << "    -> Pitch shifted to " << targetFreq << " Hz (MIDI " << pitchNote << ")" << std::endl;
-            }
-
-            // Resample from TTS rate to output rate
-            if (g_ttsSampleRate != g_outputSampleRate) {
-                samples = resample(samples, g_ttsSampleRate, g_outputSampleRate);
-                std::cout << "    -> Resampled " << g_ttsSampleRate << " -> " << g_outputSampleRate << " Hz" << std::endl;
-            }
-
-            std::lock_guard<std::mutex> lock(g_ttsBufferMutex);
-            g_ttsAudioBuffer.insert(g_ttsAudioBuffer.end(), samples.begin(), samples.end());
-            std::cout << "    -> TTS generated " << samples.size() << " samples" << std::endl;
-        }
+    // Speak on the synth worker, so input and display never wait for TTS
+    if (g_pendingSynth >= kMaxPendingSynth) {
+        ++g_skippedSynth;
+        noteLog() << "    -> Synthesis busy, not spoken" << std::endl;
+        return;
+    }
+    int pitchNote = -1;
+    if (g_pitchShiftEnabled) {
+        pitchNote = (std::max)(0, (std::min)(127, midiNote + g_octaveOffset * 12));
     }
+    ++g_pendingSynth;
+    g_synthWorker.post([syllable, pitchNote, noteMicros] {
+        speakSyllable(syllable, pitchNote, noteMicros);
+        --g_pendingSynth;
+    });
 }
 
 //------------------------------------------------------------------------
-// Audio callback for WASAPI
+// Audio callback (backend real-time thread)
 //------------------------------------------------------------------------
 void audioCallback(float* buffer, int numFrames, int numChannels) {
-    std::lock_guard<std::mutex> lock(g_ttsBufferMutex);
-
-    int samplesToWrite = numFrames * numChannels;
-    int samplesAvailable = static_cast<int>(g_ttsAudioBuffer.size());
-
-    // TTS is mono, we need to copy to all channels
-    int ttsFramesToRead = (std::min)(numFrames, samplesAvailable);
-
-    for (int frame = 0; frame < numFrames; ++frame) {
-        float sample = 0.0f;
-
-        if (frame < ttsFramesToRead && frame < static_cast<int>(g_ttsAudioBuffer.size())) {
-            sample = g_ttsAudioBuffer[frame];
+    // Audio callback only: frames output so far, the onset being waited for
+    static int64_t outputFrames = 0;
+    static NoteOnset onset;
+    static bool hasOnset = false;
+
+    // Publish the timeline for this block
+    const uint32_t sequence = g_clockSequence.load(std::memory_order_relaxed);
+    g_clockSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    g_clockFrames.store(outputFrames, std::memory_order_relaxed);
+    g_clockMicros.store(LatencyStats::nowMicros(), std::memory_order_relaxed);
+    g_clockSequence.store(sequence + 2, std::memory_order_release);
+
+    // TTS is mono: read in chunks and copy each sample to all channels
+    float mono[256];
+    int frame = 0;
+
+    while (frame < numFrames) {
+        int chunk = (std::min)(numFrames - frame, static_cast<int>(sizeof(mono) / sizeof(mono[0])));
+        if (!hasOnset) {
+            hasOnset = g_noteOnsets.pop(onset);
         }
 
-        // Write to all channels
-        for (int ch = 0; ch < numChannels; ++ch) {
-            buffer[frame * numChannels + ch] = sample;
+        int framesRead = 0;
+        if (hasOnset && g_ttsAudioBuffer.getReadPosition() == onset.fifoPos) {
+            const int64_t now = outputFrames + frame;
+            if (now >= onset.frame) {
+                hasOnset = false;  // At (or past) the onset: play on
+                continue;
+            }
+            // Hold the note back until its onset frame
+            chunk = static_cast<int>((std::min)(static_cast<int64_t>(chunk), onset.frame - now));
+        } else if (hasOnset) {
+            framesRead = static_cast<int>(g_ttsAudioBuffer.readUntil(mono, chunk, onset.fifoPos));
+        } else {
+            framesRead = static_cast<int>(g_ttsAudioBuffer.read(mono, chunk));
+        }
+        if (framesRead > 0 && g_noteMicros.load(std::memory_order_relaxed) != 0) {
+            const int64_t noteMicros = g_noteMicros.exchange(0);
+            if (noteMicros != 0) {
+                g_latency.recordSince(LatencyStage::FirstSample, noteMicros);
+            }
+        }
+        for (int i = framesRead; i < chunk; ++i) {
+            mono[i] = 0.0f;
         }
-    }
 
-    // Remove consumed samples
-    if (ttsFramesToRead > 0 && ttsFramesToRead <= static_cast<int>(g_ttsAudioBuffer.size())) {
-        g_ttsAudioBuffer.erase(g_ttsAudioBuffer.begin(), g_ttsAudioBuffer.begin() + ttsFramesToRead);
+        for (int i = 0; i < chunk; ++i) {
+            for (int ch = 0; ch < numChannels; ++ch) {
+                buffer[(frame + i) * numChannels + ch] = mono[i];
+            }
+        }
+        frame += chunk;
     }
+    outputFrames += numFrames;
 }
 
 //------------------------------------------------------------------------
 // List available devices
 //------------------------------------------------------------------------
 void listDevices() {
-    std::cout << "\n";
-    std::cout << "=== WASAPI Audio Output Devices ===\n";
-    auto audioDevices = WasapiAudio::enumerateDevices();
-    if (audioDevices.empty()) {
-        std::cout << "  (no devices found)\n";
-    } else {
-        for (size_t i = 0; i < audioDevices.size(); ++i) {
-            std::cout << "  [" << i << "] " << audioDevices[i].name;
-            if (audioDevices[i].isDefault) {
-                std::cout << " (default)";
+    const auto backends = AudioOutput::getBackendNames();
+    if (backends.empty()) {
+        std::cout << "\n(no audio backend built in)\n";
+    }
+    for (const auto& backend : backends) {
+        auto audio = AudioOutput::create(backend);
+        std::cout << "\n";
+        std::cout << "=== " << audio->getBackendName() << " Audio Output Devices ===\n";
+        auto audioDevices = audio->getDevices();
+        if (audioDevices.empty()) {
+            std::cout << "  (no devices found)\n";
+        } else {
+            for (size_t i = 0; i < audioDevices.size(); ++i) {
+                std::cout << "  [" << i << "] " << audioDevices[i].name;
+                if (audioDevices[i].isDefault) {
+                    std::cout << " (default)";
+                }
+                std::cout << "\n";
+                std::cout << "      ID: " << audioDevices[i].id << "\n";
             }
-            std::cout << "\n";
-            std::cout << "      ID: " << audioDevices[i].id << "\n";
         }
-    }
 
-    std::cout << "\n";
-    std::cout << "=== MIDI Input Devices ===\n";
-    auto midiDevices = MidiInput::enumerateDevices();
-    if (midiDevices.empty()) {
-        std::cout << "  (no devices found)\n";
-    } else {
-        for (const auto& dev : midiDevices) {
-            std::cout << "  [" << dev.id << "] " << dev.name << "\n";
+        auto midi = MidiSource::create(backend);
+        if (!midi) {
+            continue;
+        }
+        std::cout << "\n";
+        std::cout << "=== " << midi->getBackendName() << " MIDI Input Devices ===\n";
+        auto midiDevices = midi->getDevices();
+        if (midiDevices.empty()) {
+            std::cout << "  (no devices found)\n";
+        } else {
+            for (const auto& dev : midiDevices) {
+                std::cout << "  [" << dev.id << "] " << dev.name << "\n";
+            }
         }
     }
 
     std::cout << "\n";
     std::cout << "To use a specific device, add to your XML config:\n";
-    std::cout << "  <Audio deviceId=\"...\" />\n";
+    std::cout << "  <Audio backend=\"...\" deviceId=\"...\" />\n";
     std::cout << "  <Midi deviceId=\"0\" />\n";
+    std::cout << "  <Network oscPort=\"9000\" rtpMidiPort=\"5004\" />  (network input, any backend)\n";
     std::cout << "\n";
 }
 
+//------------------------------------------------------------------------
+// Route a source's notes and aftertouch (dispatched from the main loop,
+// with the source's timestamp)
+//------------------------------------------------------------------------
+void setupNoteCallbacks(MidiSource& source) {
+    source.setWakeCallback([] { g_eventLoop.wake(); });
+    source.setNoteCallback([](int channel, int note, int velocity, int64_t timeMicros) {
+        (void)channel;
+        if (g_lightOrganMode) {
+            // Light organ mode - direct note to pixel mapping
+            if (velocity > 0) {
+                g_lightOrgan.noteOn(note, velocity);
+            } else {
+                g_lightOrgan.noteOff(note);
+            }
+        } else if (velocity > 0) {
+            // Normal mode - trigger syllables/effects
+            triggerNote(note, velocity, timeMicros);
+        }
+    });
+    source.setAftertouchCallback([](int channel, int note, int pressure) {
+        (void)channel;
+        if (g_lightOrganMode) {
+            // Light organ mode - polyphonic aftertouch per key
+            g_lightOrgan.aftertouch(note, pressure);
+        } else if (g_visualEffects.isPlaying()) {
+            // Normal mode - apply to current effect
+            g_visualEffects.setBrightness(static_cast<float>(pressure) / 127.0f);
+        }
+    });
+}
+
+//------------------------------------------------------------------------
+// Replay a capture file to a server (--replay)
+//------------------------------------------------------------------------
+int replayCapture(const std::string& path, const std::string& target, bool maxSpeed, bool loop) {
+    FrameCaptureReader reader;
+    if (!reader.open(path)) {
+        std::cout << "FAILED: " << reader.getLastError() << "\n";
+        return 1;
+    }
+
+    std::string ip = "127.0.0.1";
+    int port = 1337;
+    if (!target.empty()) {
+        const size_t colon = target.rfind(':');
+        ip = target.substr(0, colon);
+        if (colon != std::string::npos) {
+            port = std::atoi(target.c_str() + colon + 1);
+        }
+    }
+
+    // Frames go out whole, where they were captured
+    const CaptureHeader& header = reader.getHeader();
+    FlaschenTaschenClient client;
+    client.setDisplaySize(reader.getWidth(), reader.getHeight());
+    client.setOffset(header.offsetX, header.offsetY);
+    client.setLayer(header.layer);
+    client.setFlipHorizontal(false);    // Captured rows are already in display order
+    if (!client.connect(ip, port)) {
+        std::cout << "FAILED: " << client.getLastError() << "\n";
+        return 1;
+    }
+    std::cout << "Replaying " << path << " (" << reader.getWidth() << "x" << reader.getHeight() << ") to "
+              << ip << ":" << port << (maxSpeed ? " at max speed" : "") << (loop ? ", looping" : "") << "\n";
+
+    const size_t stride = client.getStride();
+    int frames = 0;
+    int failed = 0;
+    const auto start = std::chrono::steady_clock::now();
+    auto passStart = start;
+    for (;;) {
+        if (!reader.next()) {
+            if (!reader.getLastError().empty()) {
+                std::cout << "Stopped: " << reader.getLastError() << "\n";
+                break;
+            }
+            if (!loop || reader.getFrameIndex() < 0) {
+                break;
+            }
+            reader.rewind();
+            passStart = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (!maxSpeed) {
+            std::this_thread::sleep_until(passStart + std::chrono::microseconds(reader.getTimeMicros()));
+        }
+        for (int y = 0; y < reader.getHeight(); ++y) {
+            std::memcpy(client.getRow(y), reader.getFrame() + y * stride, stride);
+        }
+        if (!client.send()) {
+            ++failed;
+        }
+        ++frames;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << frames << " frames in " << seconds << " s (" << (seconds > 0.0 ? frames / seconds : 0.0)
+              << " fps, " << client.getBytesSent() / (1024.0 * 1024.0) << " MB sent";
+    if (failed > 0) {
+        std::cout << ", " << failed << " sends failed: " << client.getLastError();
+    }
+    std::cout << ")\n";
+    return 0;
+}
+
 //------------------------------------------------------------------------
 // Print usage
 //------------------------------------------------------------------------
@@ -319,6 +601,7 @@ void printUsage() {
     std::cout << "  L    -> Toggle LIGHT ORGAN mode (poly aftertouch visualizer)\n";
     std::cout << "  R    -> Toggle rainbow/solid color in light organ mode\n";
     std::cout << "  T    -> Test tone (440 Hz)\n";
+    std::cout << "  I    -> Print latency stats (Shift+I resets them)\n";
     std::cout << "  ESC  -> Quit\n";
     std::cout << "\n";
 }
@@ -332,16 +615,69 @@ int main(int argc, char* argv[]) {
 
     // Parse command line arguments
     std::string xmlPath;
+    bool headless = false;
+    bool verbose = false;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
-        if (arg == "-l" || arg == "--list") {
+        if (arg == "-d" || arg == "--headless") {
+            headless = true;
+        }
+        else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+        }
+        else if (arg == "-l" || arg == "--list") {
             listDevices();
             return 0;
         }
+        else if (arg == "-c" || arg == "--compile") {
+            if (i + 2 >= argc) {
+                std::cout << "Usage: FlaschenTaschenTest --compile <in.xml> <out.ftmap>\n";
+                return 1;
+            }
+            MappingConfig source;
+            if (!source.loadFromFile(argv[i + 1]) || !source.saveToBinary(argv[i + 2])) {
+                std::cout << "FAILED: " << source.getLastError() << "\n";
+                return 1;
+            }
+            std::cout << "Compiled " << argv[i + 1] << " -> " << argv[i + 2] << " ("
+                      << source.getSyllables().size() << " syllables, "
+                      << source.getEffects().size() << " effects)\n";
+            return 0;
+        }
+        else if (arg == "-r" || arg == "--replay") {
+            if (i + 1 >= argc) {
+                std::cout << "Usage: FlaschenTaschenTest --replay <capture.ftcap> [ip[:port]] [--max-speed] [--loop]\n";
+                return 1;
+            }
+            std::string target;
+            bool maxSpeed = false;
+            bool loop = false;
+            for (int j = i + 2; j < argc; ++j) {
+                const std::string option = argv[j];
+                if (option == "--max-speed") {
+                    maxSpeed = true;
+                } else if (option == "--loop") {
+                    loop = true;
+                } else {
+                    target = option;
+                }
+            }
+            return replayCapture(argv[i + 1], target, maxSpeed, loop);
+        }
         else if (arg == "-h" || arg == "--help") {
             std::cout << "Usage: FlaschenTaschenTest [options] [config.xml]\n";
             std::cout << "\nOptions:\n";
             std::cout << "  -l, --list   List available audio and MIDI devices\n";
+            std::cout << "  -c, --compile <in.xml> <out.ftmap>\n";
+            std::cout << "               Compile an XML mapping to the binary format\n";
+            std::cout << "  -r, --replay <capture.ftcap> [ip[:port]] [--max-speed] [--loop]\n";
+            std::cout << "               Send a <Display capture> recording to a server (default\n";
+            std::cout << "               127.0.0.1:1337) at its original timing or as fast as possible\n";
+            std::cout << "  -d, --headless\n";
+            std::cout << "               Run without the console; notes come from <Network>\n";
+            std::cout << "               (OSC, RTP-MIDI) and <Midi>. Ctrl+C / SIGTERM stops\n";
+            std::cout << "  -v, --verbose\n";
+            std::cout << "               Log every note (default unless headless)\n";
             std::cout << "  -h, --help   Show this help message\n";
             std::cout << "\nIf no XML file is specified, uses built-in defaults.\n";
             return 0;
@@ -351,6 +687,8 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    g_verbose = verbose || !headless;
+
     // Use default path if not specified
     if (xmlPath.empty()) {
         xmlPath = "../../FlaschenTaschen/examples/example_mapping.xml";
@@ -411,11 +749,54 @@ int main(int argc, char* argv[]) {
     g_ftClient.setOffset(display.offsetX, display.offsetY);
     g_ftClient.setLayer(display.layer);
     g_ftClient.setFlipHorizontal(display.flipHorizontal);
+    g_ftClient.setDeltaMode(display.deltaFrames);
+    g_ftClient.setTiledMode(display.tiled);
+    g_ftClient.setMaxPacketSize(static_cast<size_t>(display.mtu));
+    g_ftClient.setNonBlocking(display.nonBlocking);  // Sends happen on the MIDI callback
     g_font.setScale(2);  // Double size for visibility
     g_font.setMirrorGlyph(display.mirrorGlyph);
 
+    std::vector<std::string> syllableTexts;
+    for (const auto& syllable : g_config.getSyllables()) {
+        syllableTexts.push_back(syllable.text);
+    }
+    g_font.setSpriteTexts(syllableTexts);
+
+    g_frameLimiter.setFps(display.fps);
+
+    if (!g_visualEffects.loadClips(g_config.getEffects())) {
+        std::cout << "    Clip: " << g_visualEffects.getLastError() << "\n";
+    }
+
+    if (display.effectCacheMb > 0) {
+        auto cache = std::make_shared<EffectFrameCache>();
+        cache->build(g_config.getEffects(), display.width, display.height, display.fps,
+                     static_cast<size_t>(display.effectCacheMb) * 1024 * 1024);
+        std::cout << "    Effect cache: " << cache->getCachedCount() << " of " << g_config.getEffects().size()
+                  << " effects, " << (cache->getMemorySize() + 1023) / 1024 << " KB\n";
+        g_visualEffects.setFrameCache(std::move(cache));
+    }
+
+    g_compositor.setSize(display.width, display.height, display.flipHorizontal);
+    g_compositor.addLayer(BlendMode::Replace);
+    g_compositor.addLayer(BlendMode::Add);
+    g_compositor.addLayer(BlendMode::Alpha);
+    g_compositor.setKeyColor(kTextLayer, Color(display.bgColorR, display.bgColorG, display.bgColorB));
+    for (int layer = 0; layer < g_compositor.getLayerCount(); ++layer) {
+        g_compositor.setEnabled(layer, false);
+    }
+
     if (g_ftClient.connect(server.ip, server.port)) {
         std::cout << "    OK - Connected to " << server.ip << ":" << server.port << "\n";
+        if (!display.capture.empty()) {
+            if (g_capture.open(display.capture, display.width, display.height,
+                               display.offsetX, display.offsetY, display.layer)) {
+                g_ftClient.setCapture(&g_capture);
+                std::cout << "    Capturing to " << display.capture << "\n";
+            } else {
+                std::cout << "    Capture: " << g_capture.getLastError() << "\n";
+            }
+        }
 
         // Send test frame
         g_ftClient.clear(Color::Black());
@@ -427,74 +808,83 @@ int main(int argc, char* argv[]) {
         std::cout << "    (LED display will not be updated)\n";
     }
 
-    // Initialize WASAPI audio
-    std::cout << "\n[3] Initializing WASAPI audio...\n";
-    WasapiAudio audio;
+    // Initialize audio output
+    std::cout << "\n[3] Initializing audio output...\n";
     const auto& audioConfig = g_config.getAudioConfig();
+    std::unique_ptr<AudioOutput> audio = AudioOutput::create(audioConfig.backend);
     bool audioOk = false;
+    if (!audio) {
+        std::cout << "    SKIPPED - audio backend \"" << audioConfig.backend << "\" not built in\n";
+    }
+    else {
+        std::cout << "    Backend: " << audio->getBackendName() << "\n";
+    }
     if (!audioConfig.deviceId.empty()) {
         std::cout << "    Using device: " << audioConfig.deviceId << "\n";
     }
     if (audioConfig.bufferMs > 0) {
         std::cout << "    Requested buffer: " << audioConfig.bufferMs << " ms\n";
     }
-    audioOk = audio.initialize(audioConfig.deviceId, audioConfig.bufferMs);
+    audioOk = audio && audio->initialize(audioConfig.deviceId, audioConfig.bufferMs, audioConfig.mode);
     if (audioOk) {
-        g_outputSampleRate = audio.getSampleRate();
+        g_outputSampleRate = audio->getSampleRate();
         std::cout << "    OK - " << g_outputSampleRate << " Hz, "
-                  << audio.getNumChannels() << " channels, "
-                  << audio.getBufferFrames() << " buffer frames\n";
+                  << audio->getNumChannels() << " channels, "
+                  << audio->getBufferFrames() << " buffer frames, "
+                  << audio->getModeName() << " mode, "
+                  << (audio->getPeriodFrames() * 1000.0 / g_outputSampleRate) << " ms period\n";
     }
     else {
-        std::cout << "    FAILED: " << audio.getLastError() << "\n";
+        if (audio) {
+            std::cout << "    FAILED: " << audio->getLastError() << "\n";
+        }
         std::cout << "    (Audio will not play)\n";
     }
 
     // Initialize MIDI input if configured
     std::cout << "\n[4] Initializing MIDI input...\n";
-    const auto& midiConfig = g_config.getMidiConfig();
-    if (midiConfig.deviceId >= 0) {
-        if (g_midiInput.open(midiConfig.deviceId)) {
-            std::cout << "    OK - " << g_midiInput.getDeviceName() << "\n";
-
-            // Set up MIDI note callback
-            g_midiInput.setNoteCallback([](int channel, int note, int velocity) {
-                (void)channel;
-                if (g_lightOrganMode) {
-                    // Light organ mode - direct note to pixel mapping
-                    if (velocity > 0) {
-                        g_lightOrgan.noteOn(note, velocity);
-                    } else {
-                        g_lightOrgan.noteOff(note);
-                    }
-                } else {
-                    // Normal mode - trigger syllables/effects
-                    if (velocity > 0) {
-                        triggerNote(note, velocity);
-                    }
-                }
-            });
+    if (!g_eventLoop.open(!headless)) {
+        std::cout << "    (event loop setup failed, input may be unresponsive)\n";
+    }
+    g_midiInput = MidiSource::create(audioConfig.backend);
 
-            // Set up aftertouch callback for real-time brightness control
-            g_midiInput.setAftertouchCallback([](int channel, int note, int pressure) {
-                (void)channel;
-                if (g_lightOrganMode) {
-                    // Light organ mode - polyphonic aftertouch per key
-                    g_lightOrgan.aftertouch(note, pressure);
-                } else {
-                    // Normal mode - apply to current effect
-                    if (g_visualEffects.isPlaying()) {
-                        g_visualEffects.setBrightness(static_cast<float>(pressure) / 127.0f);
-                    }
-                }
-            });
+    const auto& midiConfig = g_config.getMidiConfig();
+    if (!g_midiInput) {
+        std::cout << "    SKIPPED - No MIDI input for this audio backend\n";
+    } else if (!midiConfig.deviceIds.empty()) {
+        setupNoteCallbacks(*g_midiInput);
+        if (g_midiInput->open(midiConfig.deviceIds)) {
+            std::cout << "    OK - " << g_midiInput->getBackendName() << ": " << g_midiInput->getDeviceName() << "\n";
+            if (!g_midiInput->getLastError().empty()) {
+                std::cout << "    (skipped: " << g_midiInput->getLastError() << ")\n";
+            }
         } else {
-            std::cout << "    FAILED: " << g_midiInput.getLastError() << "\n";
+            std::cout << "    FAILED: " << g_midiInput->getLastError() << "\n";
         }
     } else {
         std::cout << "    SKIPPED - No MIDI device configured (use -l to list devices)\n";
     }
 
+    // Network input: OSC and RTP-MIDI, independent of the audio backend
+    const auto& network = g_config.getNetworkConfig();
+    if (network.oscPort > 0 || network.rtpMidiPort > 0) {
+        g_networkInput = std::make_unique<NetworkMidiInput>(network.bindAddress, network.oscPort, network.rtpMidiPort);
+        setupNoteCallbacks(*g_networkInput);
+        std::vector<int> inputs;
+        for (const auto& device : g_networkInput->getDevices()) {
+            inputs.push_back(device.id);
+        }
+        if (g_networkInput->open(inputs)) {
+            std::cout << "    OK - network on " << network.bindAddress << ": " << g_networkInput->getDeviceName() << "\n";
+            if (!g_networkInput->getLastError().empty()) {
+                std::cout << "    (skipped: " << g_networkInput->getLastError() << ")\n";
+            }
+        } else {
+            std::cout << "    FAILED: " << g_networkInput->getLastError() << "\n";
+            g_networkInput.reset();
+        }
+    }
+
     // Initialize eSpeak TTS (at 22050 Hz - eSpeak's native rate)
     std::cout << "\n[5] Initializing eSpeak-NG TTS...\n";
     g_ttsSampleRate = 22050;  // eSpeak's default/preferred rate
@@ -518,20 +908,34 @@ int main(int argc, char* argv[]) {
     // Initialize World vocoder for pitch shifting (at TTS sample rate)
     std::cout << "\n[6] Initializing World vocoder...\n";
     g_pitchShifter.initialize(g_ttsSampleRate);
-    std::cout << "    OK - Pitch shifter ready at " << g_ttsSampleRate << " Hz\n";
+    g_fastShifter.initialize(g_ttsSampleRate);
+    std::cout << "    OK - Pitch shifter ready at " << g_ttsSampleRate << " Hz (engine: "
+              << g_config.getTTSConfig().engine << ")\n";
     std::cout << "    Press 'P' to toggle pitch shifting (currently ON)\n";
 
+    // Allocate the playback FIFO before the audio thread starts reading it
+    g_ttsAudioBuffer.allocate(static_cast<size_t>(g_outputSampleRate) * 20);
+    g_lookAheadFrames = g_config.getTTSConfig().lookAheadMs * g_outputSampleRate / 1000;
+    g_synthWorker.start(1);
+
     // Start audio
     std::cout << "\n[7] Starting audio playback...\n";
-    if (audio.isRunning() || audio.start(audioCallback)) {
+    if (audioOk && (audio->isRunning() || audio->start(audioCallback))) {
         std::cout << "    OK - Audio running\n";
     }
     else {
-        std::cout << "    FAILED: " << audio.getLastError() << "\n";
+        std::cout << "    FAILED: " << (audio ? audio->getLastError() : "no audio output") << "\n";
     }
 
-    // Print usage
-    printUsage();
+    if (headless) {
+        if ((!g_midiInput || !g_midiInput->isOpen()) && !g_networkInput) {
+            std::cout << "\nWARNING: no input open - configure <Network> or <Midi>\n";
+        }
+        std::cout << "\nRunning headless (Ctrl+C / SIGTERM to stop)\n\n";
+    }
+    else {
+        printUsage();
+    }
 
     // Show mapped notes
     std::cout << "Mapped Notes (Syllables):\n";
@@ -565,25 +969,25 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    std::cout << "\nPress keys to trigger notes (ESC to quit):\n\n";
+    if (!headless) {
+        std::cout << "\nPress keys to trigger notes (ESC to quit):\n\n";
+    }
 
-    // Main loop - keyboard input
+    // Main loop - wakes on keyboard input, MIDI events and the display timer
     while (g_running) {
-        if (_kbhit()) {
-            int key = _getch();
+        if (g_eventLoop.quitRequested()) {  // Ctrl+C
+            g_running = false;
+            break;
+        }
 
+        int key = 0;
+        while (g_eventLoop.readKey(key)) {
             // Check for escape
             if (key == 27) {  // ESC
                 g_running = false;
                 break;
             }
 
-            // Check for special keys (arrows, function keys start with 0 or 224)
-            if (key == 0 || key == 224) {
-                _getch();  // Consume the second byte
-                continue;
-            }
-
             // Toggle pitch shifting with 'P'
             if (key == 'p' || key == 'P') {
                 g_pitchShiftEnabled = !g_pitchShiftEnabled;
@@ -633,10 +1037,7 @@ int main(int argc, char* argv[]) {
                 for (int i = 0; i < g_outputSampleRate; ++i) {
                     testTone[i] = 0.3f * std::sin(2.0f * 3.14159f * 440.0f * i / g_outputSampleRate);
                 }
-                {
-                    std::lock_guard<std::mutex> lock(g_ttsBufferMutex);
-                    g_ttsAudioBuffer.insert(g_ttsAudioBuffer.end(), testTone.begin(), testTone.end());
-                }
+                queueTTSAudio(testTone);
                 continue;
             }
 
@@ -646,18 +1047,27 @@ int main(int argc, char* argv[]) {
                 std::cout << "  LIGHT ORGAN mode: " << (g_lightOrganMode ? "ON" : "OFF");
                 if (g_lightOrganMode) {
                     std::cout << " (rainbow: " << (g_lightOrgan.isRainbowMode() ? "ON" : "OFF") << ")";
-                    // Clear display when entering light organ mode
+                    // Drop the effect when entering light organ mode; the syllable stays on top
                     g_visualEffects.stopEffect();
                     g_lightOrgan.allNotesOff();
-                    if (g_ftClient.isConnected()) {
-                        g_ftClient.clear(Color::Black());
-                        g_ftClient.send();
-                    }
+                    g_compositor.setEnabled(kEffectsLayer, false);
                 }
+                g_compositor.setEnabled(kOrganLayer, g_lightOrganMode);
+                g_layersChanged = true;
                 std::cout << std::endl;
                 continue;
             }
 
+            // Latency stats with 'I', reset with Shift+I
+            if (key == 'i' || key == 'I') {
+                std::cout << "\n" << LatencyStats::formatReport(g_latency.getReport()) << std::endl;
+                if (key == 'I') {
+                    g_latency.reset();
+                    std::cout << "  Latency stats reset" << std::endl;
+                }
+                continue;
+            }
+
             // Toggle rainbow mode in light organ with 'R'
             if (key == 'r' || key == 'R') {
                 g_lightOrgan.setRainbowMode(!g_lightOrgan.isRainbowMode());
@@ -672,30 +1082,127 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        // Update display based on mode
+        if (g_midiInput) {
+            g_midiInput->dispatch();
+        }
+        if (g_networkInput) {
+            g_networkInput->dispatch();
+        }
+
+        // Update the layers and send one composed frame, at most <Display fps>
+        // frames per second
         if (g_ftClient.isConnected()) {
-            if (g_lightOrganMode) {
-                // Light organ mode - render polyphonic key visualization
-                g_lightOrgan.render(g_ftClient);
-                g_ftClient.send();
-            } else if (g_visualEffects.isPlaying()) {
-                // Normal effects mode
-                if (g_visualEffects.update(g_ftClient)) {
-                    g_ftClient.send();
+            if (g_syllablePending || g_layersChanged || g_lightOrganMode || g_visualEffects.isPlaying() ||
+                g_marquee.isActive()) {
+                g_frameLimiter.markDirty();
+            }
+
+            if (g_frameLimiter.beginFrame()) {
+                const int64_t renderStart = LatencyStats::nowMicros();
+                const bool showSyllable = g_syllablePending.exchange(false);
+                const auto& display = g_config.getDisplayConfig();
+                Color bgColor(display.bgColorR, display.bgColorG, display.bgColorB);
+                bool changed = false;
+                if (g_lightOrganMode) {
+                    // Polyphonic key visualization
+                    g_lightOrgan.render(g_compositor.getCanvas(kOrganLayer));
+                    changed = true;
+                }
+                if (g_visualEffects.update(g_compositor.getCanvas(kEffectsLayer))) {
+                    // The last frame stays when the effect ends
+                    g_compositor.setEnabled(kEffectsLayer, true);
+                    changed = true;
+                }
+                if (showSyllable) {
+                    // Latest syllable only
+                    std::string syllable;
+                    {
+                        std::lock_guard<std::mutex> lock(g_displayMutex);
+                        syllable = g_currentSyllable;
+                    }
+                    Color textColor(display.colorR, display.colorG, display.colorB);
+                    FlaschenTaschenClient& canvas = g_compositor.getCanvas(kTextLayer);
+                    g_font.setSpriteColors(textColor, bgColor);
+                    const TextSprite& sprite = g_font.getSprite(syllable);
+                    if (display.scrollSpeed > 0 && sprite.width > canvas.getWidth()) {
+                        const int gap = TextMarquee::kGapChars * (g_font.getScaledCharWidth() + g_font.getScaledSpacing());
+                        g_marquee.start(sprite, bgColor, gap, display.scrollSpeed, renderStart / 1000.0);
+                    } else {
+                        g_marquee.stop();
+                        canvas.clear(bgColor);
+                        g_font.renderSpriteCenteredFull(canvas, syllable, textColor, bgColor);
+                    }
+                    g_compositor.setEnabled(kTextLayer, true);
+                    changed = true;
+                }
+                if (g_marquee.update(g_compositor.getCanvas(kTextLayer), renderStart / 1000.0)) {
+                    changed = true;
+                }
+                changed = changed || g_layersChanged;
+                g_layersChanged = false;
+
+                if (changed) {
+                    g_compositor.compose(g_ftClient, bgColor);
+                    const int64_t sendStart = LatencyStats::nowMicros();
+                    g_latency.record(LatencyStage::DisplayRender, sendStart - renderStart);
+                    if (!g_ftClient.send()) {
+                        std::cout << "    -> Failed to send: " << g_ftClient.getLastError() << std::endl;
+                    }
+                    g_latency.recordSince(LatencyStage::DisplaySend, sendStart);
                 }
             }
         }
 
-        Sleep(10);  // Small delay to prevent CPU spinning
+        // Sleep until the next input or, while something is left to draw,
+        // the next frame slot
+        if (!g_running) {
+            break;
+        }
+        auto deadline = EventLoop::Clock::time_point::max();
+        if (g_ftClient.isConnected() &&
+            (g_frameLimiter.isDirty() || g_layersChanged || g_lightOrganMode || g_visualEffects.isPlaying() ||
+             g_marquee.isActive())) {
+            deadline = g_frameLimiter.getNextSlot();
+        }
+        g_eventLoop.wait(deadline);
     }
 
     // Cleanup
     std::cout << "\nShutting down...\n";
 
-    audio.stop();
-    g_midiInput.close();
+    if (audio) {
+        audio->stop();
+    }
+    if (g_midiInput) {
+        g_midiInput->close();
+    }
+    if (g_networkInput) {
+        g_networkInput->close();
+        if (g_networkInput->getDroppedMessages() > 0 || g_networkInput->getMalformedPackets() > 0) {
+            std::cout << "Network input: " << g_networkInput->getDroppedMessages() << " messages dropped, "
+                      << g_networkInput->getMalformedPackets() << " malformed packets\n";
+        }
+    }
+    g_synthWorker.stop();
+    if (g_skippedSynth > 0) {
+        std::cout << "Synthesis skipped for " << g_skippedSynth << " notes (worker busy)\n";
+    }
     g_tts.shutdown();
     g_ftClient.disconnect();
+    if (g_capture.isOpen()) {
+        g_ftClient.setCapture(nullptr);
+        g_capture.close();
+        std::cout << "Capture: " << g_capture.getFramesWritten() << " frames, "
+                  << (g_capture.getBytesWritten() + 1023) / 1024 << " KB";
+        if (g_capture.getDroppedFrames() > 0) {
+            std::cout << ", " << g_capture.getDroppedFrames() << " dropped";
+        }
+        if (!g_capture.getLastError().empty()) {
+            std::cout << " (" << g_capture.getLastError() << ")";
+        }
+        std::cout << "\n";
+    }
+    g_eventLoop.close();
 
     std::cout << "Done.\n";
     return 0;